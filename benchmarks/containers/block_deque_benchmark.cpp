@@ -0,0 +1,45 @@
+#include "containers/block_deque.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+using namespace ws;
+
+
+namespace {
+
+/**
+ * @brief Push and pop elements by contended producers and consumers, as a thread pool's task queue does.
+ *
+ * @details
+ * Threads with even indexes push and the others pop.
+ * Each thread runs the same number of iterations, so all pushed elements are popped.
+ */
+void PushPop(benchmark::State& state) {
+    static std::unique_ptr<BlockDeque<std::size_t>> deq;
+    if (state.thread_index() == 0) {
+        deq = std::make_unique<BlockDeque<std::size_t>>(state.range(0));
+    }
+
+    // Google Benchmark synchronizes threads after the setup.
+    const auto producer {state.thread_index() % 2 == 0};
+    for (auto _ : state) {
+        if (producer) {
+            deq->PushBack(state.iterations());
+        } else {
+            benchmark::DoNotOptimize(deq->Pop());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(PushPop)
+    ->Name("BlockDequeBenchmark/PushPop")
+    ->Arg(16)
+    ->Arg(1024)
+    ->ThreadRange(2, 8)
+    ->UseRealTime();
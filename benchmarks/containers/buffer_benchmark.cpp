@@ -0,0 +1,118 @@
+#include "containers/buffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+
+using namespace ws;
+
+
+namespace {
+
+/**
+ * @brief Append and retrieve small pieces of data, as a connection does when parsing and building messages.
+ *
+ * @tparam T A buffer type.
+ */
+template <typename T>
+void AppendRetrieve(benchmark::State& state) {
+    const std::array<std::byte, 16> data {};
+    T buf {0x1000};
+    for (auto _ : state) {
+        for (auto i {0}; i != 64; ++i) {
+            buf.Append(data);
+        }
+
+        while (!buf.Empty()) {
+            benchmark::DoNotOptimize(buf.ReadableSize());
+            buf.Retrieve(data.size());
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * 64 * data.size());
+}
+
+//! Create a buffer with an HTTP header of many fields.
+Buffer MakeHeader() noexcept {
+    Buffer buf;
+    buf.Append("GET /index.html HTTP/1.1", NewLine::CRLF);
+    for (auto i {0}; i != 32; ++i) {
+        buf.Append("X-Custom-Header: some-fairly-long-header-value-here",
+                   NewLine::CRLF);
+    }
+
+    buf.Append("", NewLine::CRLF);
+    return buf;
+}
+
+//! Split a header into lines by copying readable bytes into a string and searching it, as parsers used to do.
+void FindLinesInCopiedString(benchmark::State& state) {
+    const auto buf {MakeHeader()};
+    for (auto _ : state) {
+        const auto str {buf.ReadableString()};
+        std::size_t lines {0};
+        for (auto pos {str.find("\r\n")}; pos != std::string::npos;
+             pos = str.find("\r\n", pos + 2)) {
+            benchmark::DoNotOptimize(str.substr(0, pos));
+            ++lines;
+        }
+
+        benchmark::DoNotOptimize(lines);
+    }
+
+    state.SetBytesProcessed(state.iterations() * buf.ReadableSize());
+}
+
+//! Split a header into lines with @p Buffer::FindCRLF over readable bytes.
+void FindLinesInBuffer(benchmark::State& state) {
+    const auto buf {MakeHeader()};
+    for (auto _ : state) {
+        std::size_t lines {0};
+        for (auto pos {buf.FindCRLF()}; pos.has_value();
+             pos = buf.FindCRLF(pos.value() + 2)) {
+            ++lines;
+        }
+
+        benchmark::DoNotOptimize(lines);
+    }
+
+    state.SetBytesProcessed(state.iterations() * buf.ReadableSize());
+}
+
+//! Find any of a few characters with @p std::string_view::find_first_of.
+void FindAnyInStringView(benchmark::State& state) {
+    const auto buf {MakeHeader()};
+    const auto bytes {buf.ReadableBytes()};
+    const std::string_view str {reinterpret_cast<const char*>(bytes.data()),
+                                bytes.size()};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(str.find_first_of("&=;"));
+    }
+
+    state.SetBytesProcessed(state.iterations() * buf.ReadableSize());
+}
+
+//! Find any of a few characters with @p Buffer::FindAny.
+void FindAnyInBuffer(benchmark::State& state) {
+    const auto buf {MakeHeader()};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buf.FindAny("&=;"));
+    }
+
+    state.SetBytesProcessed(state.iterations() * buf.ReadableSize());
+}
+
+}  // namespace
+
+BENCHMARK(FindLinesInCopiedString)
+    ->Name("BufferBenchmark/FindLines/CopiedString");
+BENCHMARK(FindLinesInBuffer)->Name("BufferBenchmark/FindLines/Buffer");
+BENCHMARK(FindAnyInStringView)->Name("BufferBenchmark/FindAny/StringView");
+BENCHMARK(FindAnyInBuffer)->Name("BufferBenchmark/FindAny/Buffer");
+
+BENCHMARK(AppendRetrieve<Buffer>)
+    ->Name("BufferBenchmark/AppendRetrieve/SingleThreaded");
+BENCHMARK(AppendRetrieve<ConcurrentBuffer>)
+    ->Name("BufferBenchmark/AppendRetrieve/MultiThreaded");
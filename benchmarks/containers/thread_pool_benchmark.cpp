@@ -0,0 +1,111 @@
+#include "containers/thread_pool.h"
+#include "containers/work_stealing_thread_pool.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace ws;
+
+
+namespace {
+
+//! The number of tasks executed in each iteration.
+constexpr std::size_t task_count {0x1000};
+
+/**
+ * @brief Push small tasks one by one and wait for all of them, as a reactor does when dispatching clients.
+ *
+ * @tparam T A thread pool type.
+ */
+template <typename T>
+void Push(benchmark::State& state) {
+    T pool {static_cast<std::size_t>(state.range(0)), nullptr};
+    pool.Start();
+
+    std::atomic_size_t done {0};
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (std::size_t i {0}; i != task_count; ++i) {
+            pool.Push([&done]() noexcept {
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1
+                    == task_count) {
+                    done.notify_one();
+                }
+            });
+        }
+
+        for (auto curr {done.load(std::memory_order_acquire)};
+             curr != task_count; curr = done.load(std::memory_order_acquire)) {
+            done.wait(curr, std::memory_order_acquire);
+        }
+    }
+
+    pool.Close();
+    state.SetItemsProcessed(state.iterations() * task_count);
+}
+
+/**
+ * @brief Push small tasks in batches and wait for all of them, as a reactor does after each wait.
+ *
+ * @tparam T A thread pool type.
+ */
+template <typename T>
+void PushBatch(benchmark::State& state) {
+    static constexpr std::size_t batch_size {64};
+
+    T pool {static_cast<std::size_t>(state.range(0)), nullptr};
+    pool.Start();
+
+    std::atomic_size_t done {0};
+    std::vector<Executor::Task> tasks;
+    tasks.reserve(batch_size);
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (std::size_t i {0}; i != task_count / batch_size; ++i) {
+            tasks.clear();
+            for (std::size_t j {0}; j != batch_size; ++j) {
+                tasks.emplace_back([&done]() noexcept {
+                    if (done.fetch_add(1, std::memory_order_acq_rel) + 1
+                        == task_count) {
+                        done.notify_one();
+                    }
+                });
+            }
+
+            pool.PushBatch(tasks);
+        }
+
+        for (auto curr {done.load(std::memory_order_acquire)};
+             curr != task_count; curr = done.load(std::memory_order_acquire)) {
+            done.wait(curr, std::memory_order_acquire);
+        }
+    }
+
+    pool.Close();
+    state.SetItemsProcessed(state.iterations() * task_count);
+}
+
+}  // namespace
+
+BENCHMARK(Push<ThreadPool>)
+    ->Name("ThreadPoolBenchmark/Push/Shared")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK(Push<WorkStealingThreadPool>)
+    ->Name("ThreadPoolBenchmark/Push/WorkStealing")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK(PushBatch<ThreadPool>)
+    ->Name("ThreadPoolBenchmark/PushBatch/Shared")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+BENCHMARK(PushBatch<WorkStealingThreadPool>)
+    ->Name("ThreadPoolBenchmark/PushBatch/WorkStealing")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
@@ -0,0 +1,159 @@
+#include "containers/heap_timer.h"
+#include "containers/timing_wheel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace ws;
+
+
+namespace {
+
+//! The callback of benchmark timers, which never expire during measurement.
+void OnTimeOut(std::size_t) noexcept {}
+
+//! Create random expirations within a connection's typical alive time.
+std::vector<std::chrono::milliseconds> RandomExpirations(
+    const std::size_t count) noexcept {
+    std::mt19937 engine {count};
+    std::uniform_int_distribution<std::int64_t> dist {1000, 60000};
+    std::vector<std::chrono::milliseconds> expirations;
+    expirations.reserve(count);
+    for (std::size_t i {0}; i != count; ++i) {
+        expirations.emplace_back(dist(engine));
+    }
+
+    return expirations;
+}
+
+/**
+ * @brief Push timers with random expirations, as a reactor does when clients connect.
+ *
+ * @tparam T A timer system type.
+ */
+template <typename T>
+void Push(benchmark::State& state) {
+    const auto count {static_cast<std::size_t>(state.range(0))};
+    const auto expirations {RandomExpirations(count)};
+    for (auto _ : state) {
+        T timer {nullptr};
+        for (std::size_t i {0}; i != count; ++i) {
+            timer.Push(i, expirations[i], OnTimeOut);
+        }
+
+        benchmark::DoNotOptimize(timer.Size());
+        state.PauseTiming();
+        timer.Clear();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+/**
+ * @brief Postpone timers among a large population, as a reactor does when clients send or receive data.
+ *
+ * @tparam T A timer system type.
+ */
+template <typename T>
+void Adjust(benchmark::State& state) {
+    const auto count {static_cast<std::size_t>(state.range(0))};
+    const auto expirations {RandomExpirations(count)};
+    T timer {nullptr};
+    for (std::size_t i {0}; i != count; ++i) {
+        timer.Push(i, expirations[i], OnTimeOut);
+    }
+
+    std::mt19937 engine {0};
+    std::uniform_int_distribution<std::size_t> dist {0, count - 1};
+    for (auto _ : state) {
+        timer.Adjust(dist(engine), std::chrono::seconds {60});
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Remove and push timers among a large population, as a reactor does when clients disconnect and reconnect.
+ *
+ * @tparam T A timer system type.
+ */
+template <typename T>
+void RemovePush(benchmark::State& state) {
+    const auto count {static_cast<std::size_t>(state.range(0))};
+    const auto expirations {RandomExpirations(count)};
+    T timer {nullptr};
+    for (std::size_t i {0}; i != count; ++i) {
+        timer.Push(i, expirations[i], OnTimeOut);
+    }
+
+    std::mt19937 engine {0};
+    std::uniform_int_distribution<std::size_t> dist {0, count - 1};
+    for (auto _ : state) {
+        const auto key {dist(engine)};
+        timer.Remove(key);
+        timer.Push(key, expirations[key], OnTimeOut);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Tick a large population of timers that have not expired, as a reactor does after each wait.
+ *
+ * @tparam T A timer system type.
+ */
+template <typename T>
+void Tick(benchmark::State& state) {
+    const auto count {static_cast<std::size_t>(state.range(0))};
+    const auto expirations {RandomExpirations(count)};
+    T timer {nullptr};
+    for (std::size_t i {0}; i != count; ++i) {
+        timer.Push(i, expirations[i], OnTimeOut);
+    }
+
+    for (auto _ : state) {
+        timer.Tick();
+        benchmark::DoNotOptimize(timer.ToNextTick());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+//! Timer populations from ten thousand to one million.
+void TimerCounts(benchmark::internal::Benchmark* const benchmark) noexcept {
+    benchmark->RangeMultiplier(10)->Range(10000, 1000000);
+}
+
+}  // namespace
+
+BENCHMARK(Push<HeapTimer<std::size_t>>)
+    ->Name("TimerBenchmark/Push/HeapTimer")
+    ->Apply(TimerCounts)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(Push<TimingWheel<std::size_t>>)
+    ->Name("TimerBenchmark/Push/TimingWheel")
+    ->Apply(TimerCounts)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(Adjust<HeapTimer<std::size_t>>)
+    ->Name("TimerBenchmark/Adjust/HeapTimer")
+    ->Apply(TimerCounts);
+BENCHMARK(Adjust<TimingWheel<std::size_t>>)
+    ->Name("TimerBenchmark/Adjust/TimingWheel")
+    ->Apply(TimerCounts);
+BENCHMARK(RemovePush<HeapTimer<std::size_t>>)
+    ->Name("TimerBenchmark/RemovePush/HeapTimer")
+    ->Apply(TimerCounts);
+BENCHMARK(RemovePush<TimingWheel<std::size_t>>)
+    ->Name("TimerBenchmark/RemovePush/TimingWheel")
+    ->Apply(TimerCounts);
+BENCHMARK(Tick<HeapTimer<std::size_t>>)
+    ->Name("TimerBenchmark/Tick/HeapTimer")
+    ->Apply(TimerCounts);
+BENCHMARK(Tick<TimingWheel<std::size_t>>)
+    ->Name("TimerBenchmark/Tick/TimingWheel")
+    ->Apply(TimerCounts);
@@ -0,0 +1,137 @@
+#include "containers/buffer.h"
+#include "http.h"
+#include "request.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using namespace ws;
+using namespace ws::http;
+
+
+namespace {
+
+//! A minimal request.
+constexpr std::string_view simple_request {
+    "GET / HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "\r\n"};
+
+//! A request with headers sent by a typical browser.
+constexpr std::string_view browser_request {
+    "GET /assets/images/background.png?version=20220701 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \".Not/A)Brand\";v=\"99\", \"Google Chrome\";v=\"103\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/103.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,image/apng,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: https://www.example.com/index.html\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8,zh;q=0.7\r\n"
+    "Cookie: session=5f2b8c9e1a7d4e3f; theme=dark; "
+    "_ga=GA1.1.123456789.1656633600\r\n"
+    "If-None-Match: \"62bea3c0-1a2b\"\r\n"
+    "If-Modified-Since: Fri, 01 Jul 2022 08:00:00 GMT\r\n"
+    "\r\n"};
+
+//! A form submitted by the echo page, with URL-encoded characters.
+constexpr std::string_view post_request {
+    "POST /echo HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "Connection: keep-alive\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 65\r\n"
+    "\r\n"
+    "user=Zhenshuo+Chen&msg=Hello%2C+world%21+%E4%BD%A0%E5%A5%BD%21%21"};
+
+//! Create a large form with a long message, most of which is plain text.
+std::string LargePostRequest() {
+    std::string msg;
+    while (msg.size() < 0x10000) {
+        msg += "The+quick+brown+fox+jumps+over+the+lazy+dog%21+";
+    }
+
+    const auto body {"user=Zhenshuo+Chen&msg=" + msg};
+    return "POST /echo HTTP/1.1\r\n"
+           "Host: 127.0.0.1\r\n"
+           "Content-Type: application/x-www-form-urlencoded\r\n"
+           "Content-Length: "
+           + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+//! Parse a complete request from a buffer.
+void Parse(benchmark::State& state, const std::string_view raw) {
+    Buffer buf {raw};
+    Request request;
+    for (auto _ : state) {
+        request.Clear();
+        benchmark::DoNotOptimize(request.Parse(buf));
+    }
+
+    state.SetBytesProcessed(state.iterations() * raw.size());
+}
+
+//! Parse requests pipelined in a buffer one after another, as a keep-alive connection does.
+void ParsePipelined(benchmark::State& state) {
+    static constexpr std::size_t count {16};
+
+    Buffer buf;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (std::size_t i {0}; i != count; ++i) {
+            buf.Append(browser_request);
+        }
+
+        state.ResumeTiming();
+        Request request;
+        while (!buf.Empty()) {
+            request.Clear();
+            request.Parse(buf);
+            buf.Retrieve(request.Size());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+//! Decode a URL-encoded string.
+void DecodeURLEncoded(benchmark::State& state, const std::string& str) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DecodeURLEncodedString(str));
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(Parse, Simple, simple_request)
+    ->Name("HTTPBenchmark/Parse/Simple");
+BENCHMARK_CAPTURE(Parse, Browser, browser_request)
+    ->Name("HTTPBenchmark/Parse/HeaderHeavy");
+BENCHMARK_CAPTURE(Parse, Post, post_request)
+    ->Name("HTTPBenchmark/Parse/URLEncodedPost");
+BENCHMARK_CAPTURE(Parse, LargePost, LargePostRequest())
+    ->Name("HTTPBenchmark/Parse/LargeURLEncodedPost");
+BENCHMARK(ParsePipelined)->Name("HTTPBenchmark/Parse/Pipelined");
+BENCHMARK_CAPTURE(DecodeURLEncoded, Plain,
+                  std::string {"Zhenshuo+Chen+said+hello+to+the+server"})
+    ->Name("HTTPBenchmark/DecodeURLEncoded/Plain");
+BENCHMARK_CAPTURE(
+    DecodeURLEncoded, Encoded,
+    std::string {"Hello%2C+world%21+%E4%BD%A0%E5%A5%BD%21+%28%3A%29+%26+%3D"})
+    ->Name("HTTPBenchmark/DecodeURLEncoded/Encoded");
+BENCHMARK_CAPTURE(DecodeURLEncoded, Large,
+                  std::string(0x10000, 'a') + "%21")
+    ->Name("HTTPBenchmark/DecodeURLEncoded/Large");
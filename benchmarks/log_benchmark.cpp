@@ -0,0 +1,72 @@
+#include "log.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using namespace ws::log;
+
+
+namespace {
+
+//! The appender that discards formatted events.
+class NullAppender : public Appender {
+public:
+    using Appender::Appender;
+
+    std::string ToYamlString() const noexcept override {
+        return "";
+    }
+
+protected:
+    void Write(const std::string_view logs) noexcept override {
+        benchmark::DoNotOptimize(logs.data());
+    }
+};
+
+//! Format events with the default pattern into a reused string.
+void FormatDefaultPattern(benchmark::State& state) {
+    const Logger logger {"benchmark"};
+    const auto formatter {Formatter::Default()};
+    const auto event {Event::Create(Level::Info)
+                      << "A new client 127.0.0.1 has connected on socket 6"};
+
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        formatter->Format(out, logger, *event);
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+//! Create and log events synchronously with the default pattern.
+void SyncLog(benchmark::State& state) {
+    Logger logger {"benchmark", Level::Info};
+    logger.AddAppender(std::make_shared<NullAppender>());
+    for (auto _ : state) {
+        WS_LOG_INFO(&logger, "A new client {} has connected on socket {}",
+                    "127.0.0.1", 6);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+//! Skip events below the logger's level.
+void DisabledLog(benchmark::State& state) {
+    Logger logger {"benchmark", Level::Warn};
+    logger.AddAppender(std::make_shared<NullAppender>());
+    for (auto _ : state) {
+        WS_LOG_INFO(&logger, "A new client {} has connected on socket {}",
+                    "127.0.0.1", 6);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(FormatDefaultPattern)->Name("LogBenchmark/Format/DefaultPattern");
+BENCHMARK(SyncLog)->Name("LogBenchmark/Log/Sync");
+BENCHMARK(DisabledLog)->Name("LogBenchmark/Log/Disabled");
@@ -16,6 +16,7 @@
 #include "util.h"
 
 #include <algorithm>
+#include <atomic>
 #include <initializer_list>
 #include <iostream>
 #include <list>
@@ -116,9 +117,8 @@ public:
 
         std::list<T> vals;
         std::ranges::for_each(node, [&vals](const YAML::Node& child) {
-            std::ostringstream ss;
-            ss << child;
-            vals.emplace_back(VarConverter<std::string, T> {}(ss.str()));
+            vals.emplace_back(
+                VarConverter<std::string, T> {}(YamlNodeToString(child)));
         });
 
         return vals;
@@ -226,12 +226,9 @@ public:
         std::map<std::string, T> vals;
         std::ranges::for_each(
             node, [&vals](const std::pair<YAML::Node, YAML::Node>& child) {
-                std::ostringstream key;
-                key << child.first;
-                std::ostringstream val;
-                val << child.second;
-                vals.emplace(key.str(),
-                             VarConverter<std::string, T> {}(val.str()));
+                vals.emplace(YamlNodeToString(child.first),
+                             VarConverter<std::string, T> {}(
+                                 YamlNodeToString(child.second)));
             });
 
         return vals;
@@ -312,6 +309,17 @@ protected:
 /**
  * @brief The configuration variable.
  *
+ * @details
+ * The value is kept as an immutable snapshot behind an atomic @p std::shared_ptr.
+ * Reading it never waits for the lock of setting values and listeners,
+ * and setting it publishes a new snapshot and increases a version.
+ *
+ * @note
+ * The atomic @p std::shared_ptr is not lock-free in libstdc++.
+ * Each read briefly holds an internal spin lock and writes the pointer's cache line,
+ * so reading should stay out of hot paths.
+ * The server reads variables only when it starts.
+ *
  * @tparam T The variable type.
  * @tparam FromStr A converter that can convert a string into a type-matching value.
  * @tparam ToStr A converter that can convert a type-matching value into a string.
@@ -324,6 +332,9 @@ class Var : public VarBase {
 public:
     using Ptr = std::shared_ptr<Var>;
 
+    //! An immutable value.
+    using Snapshot = std::shared_ptr<const T>;
+
     /**
      * @brief The listener for value change events.
      *
@@ -334,7 +345,8 @@ public:
 
     explicit Var(const std::string_view name, const T& default_val,
                  const std::string_view description = "") noexcept :
-        VarBase {name, description}, val_ {default_val} {}
+        VarBase {name, description},
+        val_ {std::make_shared<const T>(default_val)} {}
 
     Var(const Var&) = delete;
 
@@ -345,7 +357,7 @@ public:
     Var& operator=(Var&&) = delete;
 
     std::string ToString() const noexcept override {
-        return ToStr {}(GetValue());
+        return ToStr {}(*GetSnapshot());
     }
 
     void FromString(const std::string_view str) override {
@@ -353,28 +365,46 @@ public:
     }
 
     T GetValue() const noexcept {
-        const std::shared_lock locker {mtx_};
-        return val_;
+        return *GetSnapshot();
+    }
+
+    //! Get the current value without copying it.
+    Snapshot GetSnapshot() const noexcept {
+        return val_.load(std::memory_order_acquire);
     }
 
+    /**
+     * @brief Get the version of the value.
+     *
+     * @details It increases each time the value changes.
+     */
+    std::uint64_t Version() const noexcept {
+        return version_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Set the value.
+     *
+     * @details Listeners are notified before the new value is published.
+     */
     void SetValue(const T& val) noexcept {
-        {
-            const std::shared_lock locker {mtx_};
-            if (val != val_) {
-                std::ranges::for_each(
-                    listeners_, [&val, this](const auto& listener) noexcept {
-                        try {
-                            listener.second(val_, val);
-                        } catch (const std::exception& err) {
-                            std::osyncstream {std::cerr} << err.what()
-                                                         << std::endl;
-                        }
-                    });
-            }
+        const std::lock_guard locker {mtx_};
+        const auto old_val {GetSnapshot()};
+        if (val == *old_val) {
+            return;
         }
 
-        const std::unique_lock locker {mtx_};
-        val_ = val;
+        std::ranges::for_each(
+            listeners_, [&val, &old_val](const auto& listener) noexcept {
+                try {
+                    listener.second(*old_val, val);
+                } catch (const std::exception& err) {
+                    std::osyncstream {std::cerr} << err.what() << std::endl;
+                }
+            });
+
+        val_.store(std::make_shared<const T>(val), std::memory_order_release);
+        version_.fetch_add(1, std::memory_order_release);
     }
 
     //! Get a unique string representing the variable type.
@@ -388,7 +418,7 @@ public:
      * @param key A unique key corresponding to the listener.
      */
     void RemoveListener(const std::uint64_t key) noexcept {
-        const std::unique_lock locker {mtx_};
+        const std::lock_guard locker {mtx_};
         listeners_.erase(key);
     }
 
@@ -399,7 +429,7 @@ public:
      * @return A unique key corresponding to the listener.
      */
     std::uint64_t AddListener(OnChange listener) noexcept {
-        const std::unique_lock locker {mtx_};
+        const std::lock_guard locker {mtx_};
         static std::uint64_t key {0};
         listeners_[key] = std::move(listener);
         return key++;
@@ -407,14 +437,16 @@ public:
 
     //! Remove all listeners.
     void ClearListeners() noexcept {
-        const std::unique_lock locker {mtx_};
+        const std::lock_guard locker {mtx_};
         listeners_.clear();
     }
 
 private:
-    mutable std::shared_mutex mtx_;
+    //! The lock for setting the value and listeners.
+    mutable std::mutex mtx_;
 
-    T val_;
+    std::atomic<Snapshot> val_;
+    std::atomic_uint64_t version_ {0};
     std::unordered_map<std::uint64_t, OnChange> listeners_;
 };
 
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <atomic>
+#include <initializer_list>
 #include <optional>
 #include <span>
 #include <string>
@@ -27,6 +28,8 @@ namespace io {
 
 class IReadWriter;
 
+class FileDescriptor;
+
 }
 
 //! New-line characters
@@ -38,6 +41,34 @@ enum class NewLine {
     CRLF
 };
 
+/**
+ * @brief Find the first occurrence of any of the characters in a string.
+ *
+ * @details
+ * Blocks are compared with each character using AVX2 if it is enabled by the compiler,
+ * SSE2 on other x86-64 processors and NEON on ARM processors,
+ * and the first match is found from the bit mask of results.
+ * The remaining bytes shorter than a block are compared one by one.
+ * A single character is searched with @p memchr.
+ *
+ * @param chars A few characters. Long sets are slower, as each block is compared with every character.
+ * @return The position of the first matched character, or the size of the string if none is found.
+ */
+std::size_t FindAnyOf(std::string_view str, std::string_view chars) noexcept;
+
+//! Get the name of the instruction set used by @p FindAnyOf.
+std::string_view FindAnyOfInstructionSet() noexcept;
+
+//! The threading policy for a buffer only used by one thread at a time, whose offsets are plain integers.
+struct SingleThreaded {
+    using Offset = std::size_t;
+};
+
+//! The threading policy for a buffer shared between threads, whose offsets are atomic.
+struct MultiThreaded {
+    using Offset = std::atomic<std::size_t>;
+};
+
 /**
  * @brief An auto-expandable buffer, supporting storing bytes and strings.
  *
@@ -53,28 +84,33 @@ enum class NewLine {
  * @endcode
  *
  * Prependable space can be reused.
+ *
+ * @tparam ThreadingPolicy
+ * A policy deciding whether offsets are atomic.
+ * Connections use @p SingleThreaded offsets, since a connection is processed by one thread at a time.
  */
-class Buffer {
+template <typename ThreadingPolicy>
+class BasicBuffer {
 public:
     //! Create a buffer with an initial size.
-    explicit Buffer(std::size_t size = 1000) noexcept;
+    explicit BasicBuffer(std::size_t size = 1000) noexcept;
 
     //! Create a buffer with bytes.
-    explicit Buffer(std::span<const std::byte> bytes) noexcept;
+    explicit BasicBuffer(std::span<const std::byte> bytes) noexcept;
 
     //! Create a buffer with bytes.
-    explicit Buffer(std::initializer_list<std::byte> bytes) noexcept;
+    explicit BasicBuffer(std::initializer_list<std::byte> bytes) noexcept;
 
     //! Create a buffer with a string.
-    explicit Buffer(std::string_view str) noexcept;
+    explicit BasicBuffer(std::string_view str) noexcept;
 
-    Buffer(const Buffer&) noexcept;
+    BasicBuffer(const BasicBuffer&) noexcept;
 
-    Buffer(Buffer&&) noexcept;
+    BasicBuffer(BasicBuffer&&) noexcept;
 
-    Buffer& operator=(const Buffer&) noexcept;
+    BasicBuffer& operator=(const BasicBuffer&) noexcept;
 
-    Buffer& operator=(Buffer&&) noexcept;
+    BasicBuffer& operator=(BasicBuffer&&) noexcept;
 
     //! Get the current writable size without expanding.
     std::size_t WritableSize() const noexcept;
@@ -88,6 +124,9 @@ public:
     //! Get readable bytes without moving the reading offset.
     std::span<const std::byte> ReadableBytes() const noexcept;
 
+    //! Get readable bytes for editing in place without moving the reading offset.
+    std::span<std::byte> MutableReadableBytes() noexcept;
+
     /**
      * @brief Get a readable string without moving the reading offset.
      *
@@ -95,6 +134,36 @@ public:
      */
     std::string ReadableString() const noexcept;
 
+    /**
+     * @brief Find the first occurrence of a character in readable bytes without copying them.
+     *
+     * @param c A character.
+     * @param offset The offset in readable bytes where the search starts.
+     * @return The offset of the character in readable bytes, or @p std::nullopt if it is not found.
+     */
+    std::optional<std::size_t> Find(char c, std::size_t offset = 0) const noexcept;
+
+    /**
+     * @brief Find the first @p \r\n in readable bytes without copying them.
+     *
+     * @param offset The offset in readable bytes where the search starts.
+     * @return The offset of @p \r in readable bytes, or @p std::nullopt if it is not found.
+     */
+    std::optional<std::size_t> FindCRLF(std::size_t offset = 0) const noexcept;
+
+    /**
+     * @brief Find the first occurrence of any of the characters in readable bytes without copying them.
+     *
+     * @details
+     * Readable bytes are searched with @p FindAnyOf.
+     *
+     * @param chars A few characters.
+     * @param offset The offset in readable bytes where the search starts.
+     * @return The offset of the first matched character in readable bytes, or @p std::nullopt if none is found.
+     */
+    std::optional<std::size_t> FindAny(std::string_view chars,
+                                       std::size_t offset = 0) const noexcept;
+
     /**
      * @brief Get writable space for editing.
      *
@@ -118,7 +187,7 @@ public:
     void Append(const void* data, std::size_t size) noexcept;
 
     //! Append another buffer to the buffer and move forward the writing offset.
-    void Append(const Buffer& buf) noexcept;
+    void Append(const BasicBuffer& buf) noexcept;
 
     //! Ensure the buffer has enough writable space.
     void EnsureWriteableSize(std::size_t size) noexcept;
@@ -129,6 +198,14 @@ public:
     //! Manually move forward the reading offset by a specific size.
     void Retrieve(std::size_t size) noexcept;
 
+    /**
+     * @brief Remove a range of readable bytes, moving the following bytes forward.
+     *
+     * @param offset The offset of the range in readable bytes.
+     * @param size The size of the range.
+     */
+    void Erase(std::size_t offset, std::size_t size) noexcept;
+
     //! Manually move forward the reading offset until it reaches the destination.
     std::size_t RetrieveUntil(const void* addr) noexcept;
 
@@ -145,6 +222,18 @@ public:
     //! Clear the buffer.
     void Clear() noexcept;
 
+    /**
+     * @brief Clear the buffer for reuse.
+     *
+     * @details
+     * The allocated space is kept, unless the buffer has grown beyond a maximum size.
+     * In that case, it is shrunk to the maximum size.
+     */
+    void Reset(std::size_t max_size) noexcept;
+
+    //! Get the allocated size.
+    std::size_t Capacity() const noexcept;
+
     //! Whether the buffer is empty.
     bool Empty() const noexcept;
 
@@ -162,10 +251,19 @@ protected:
     std::vector<std::byte>::iterator WriteIter() const noexcept;
 
     std::vector<std::byte> buf_;
-    std::atomic<std::size_t> read_pos_ {0};
-    std::atomic<std::size_t> write_pos_ {0};
+    typename ThreadingPolicy::Offset read_pos_ {0};
+    typename ThreadingPolicy::Offset write_pos_ {0};
 };
 
+//! The buffer only used by one thread at a time.
+using Buffer = BasicBuffer<SingleThreaded>;
+
+//! The buffer whose offsets can be accessed by multiple threads.
+using ConcurrentBuffer = BasicBuffer<MultiThreaded>;
+
+extern template class BasicBuffer<SingleThreaded>;
+extern template class BasicBuffer<MultiThreaded>;
+
 //! An enhanced buffer supporting I/O reading and writing.
 class IOBuffer : public Buffer {
 public:
@@ -176,6 +274,16 @@ public:
 
     //! Write data to an I/O object.
     std::size_t WriteTo(io::IReadWriter& io);
+
+    /**
+     * @brief Write data followed by other buffers to a file descriptor with a single gather write.
+     *
+     * @details
+     * A partial write retrieves the written data only,
+     * so calling it again resumes from where it stopped.
+     */
+    std::size_t WriteTo(io::FileDescriptor& io,
+                        std::initializer_list<Buffer*> follows);
 };
 
 //! Write a string to a buffer.
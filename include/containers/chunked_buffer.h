@@ -0,0 +1,220 @@
+/**
+ * @file chunked_buffer.h
+ * @brief The buffer made of fixed-size chunks from a shared allocator.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-14
+ *
+ * @example tests/containers/chunked_buffer_test.cpp
+ */
+
+#pragma once
+
+#include "containers/mpmc_queue.h"
+
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+namespace ws {
+
+/**
+ * @brief The allocator of fixed-size memory chunks.
+ *
+ * @details
+ * Released chunks are kept in a lock-free free list and reused by later allocations from any thread.
+ * If the free list is full, released chunks are returned to the system.
+ */
+class ChunkAllocator {
+public:
+    static constexpr std::size_t default_chunk_size {0x4000};
+
+    /**
+     * @brief Get the global allocator shared by chunked buffers.
+     *
+     * @warning Chunked buffers using it must not be static objects.
+     */
+    static ChunkAllocator& Global() noexcept;
+
+    /**
+     * @brief Create a chunk allocator.
+     *
+     * @param chunk_size The size of each chunk.
+     * @param max_free_count The maximum number of released chunks kept for reuse.
+     */
+    explicit ChunkAllocator(std::size_t chunk_size = default_chunk_size,
+                            std::size_t max_free_count = 0x400) noexcept;
+
+    ~ChunkAllocator() noexcept;
+
+    ChunkAllocator(const ChunkAllocator&) = delete;
+
+    ChunkAllocator(ChunkAllocator&&) = delete;
+
+    ChunkAllocator& operator=(const ChunkAllocator&) = delete;
+
+    ChunkAllocator& operator=(ChunkAllocator&&) = delete;
+
+    //! Get a chunk, reusing a released one if possible.
+    std::byte* Allocate() noexcept;
+
+    //! Release a chunk.
+    void Release(std::byte* chunk) noexcept;
+
+    //! Get the size of each chunk.
+    std::size_t ChunkSize() const noexcept;
+
+    //! Get the approximate number of released chunks kept for reuse.
+    std::size_t FreeCount() const noexcept;
+
+private:
+    std::size_t chunk_size_;
+    MPMCQueue<std::byte*> free_chunks_;
+};
+
+/**
+ * @brief The buffer made of fixed-size chunks from a shared allocator.
+ *
+ * @details
+ * @code
+ *         Reading Offset ──┐                   Writing Offset ──┐
+ *                          │                                    │
+ * ┌────────────────────────▼──┐ ┌───────────────────────────┐ ┌─▼─────────────────────────┐
+ * │ Retrieved │    Readable   │ │          Readable         │ │ Readable │    Writable    │
+ * └───────────────────────────┘ └───────────────────────────┘ └───────────────────────────┘
+ *            Chunk 0                       Chunk 1                       Chunk 2
+ * @endcode
+ *
+ * Unlike @p Buffer, growing the buffer appends new chunks instead of reallocating and copying existing data.
+ * Readable and writable space can be exposed as multiple segments for scatter-gather I/O.
+ * Fully retrieved chunks are returned to the allocator immediately.
+ *
+ * It receives upstream responses of the reverse proxy.
+ * Client connections keep contiguous buffers, as requests are parsed in place.
+ */
+class ChunkedBuffer {
+public:
+    //! Create an empty buffer.
+    explicit ChunkedBuffer(
+        ChunkAllocator& allocator = ChunkAllocator::Global()) noexcept;
+
+    ~ChunkedBuffer() noexcept;
+
+    ChunkedBuffer(ChunkedBuffer&& o) noexcept;
+
+    ChunkedBuffer& operator=(ChunkedBuffer&& o) noexcept;
+
+    ChunkedBuffer(const ChunkedBuffer&) = delete;
+
+    ChunkedBuffer& operator=(const ChunkedBuffer&) = delete;
+
+    //! Get the readable size.
+    std::size_t ReadableSize() const noexcept;
+
+    //! Get the writable size of allocated chunks.
+    std::size_t WritableSize() const noexcept;
+
+    //! Get the number of allocated chunks.
+    std::size_t ChunkCount() const noexcept;
+
+    //! Whether the buffer is empty.
+    bool Empty() const noexcept;
+
+    /**
+     * @brief Get readable bytes as segments without moving the reading offset.
+     *
+     * @param[out] segments Segments to receive readable bytes, one per chunk.
+     * @return The number of filled segments.
+     */
+    std::size_t ReadableSegments(
+        std::span<std::span<const std::byte>> segments) const noexcept;
+
+    /**
+     * @brief Ensure writable space and get it as segments.
+     *
+     * @warning
+     * If developers directly write data into the segments,
+     * they must manually adjust the writing offset with @p HasWritten.
+     *
+     * @param size The minimum writable size.
+     * @param[out] segments Segments to receive writable space, one per chunk.
+     * @return The number of filled segments.
+     */
+    std::size_t WritableSegments(
+        std::size_t size, std::span<std::span<std::byte>> segments) noexcept;
+
+    //! Ensure the buffer has enough writable space by appending chunks.
+    void EnsureWriteableSize(std::size_t size) noexcept;
+
+    //! Append bytes to the buffer and move forward the writing offset.
+    void Append(std::span<const std::byte> bytes) noexcept;
+
+    //! Append a string to the buffer and move forward the writing offset.
+    void Append(std::string_view str) noexcept;
+
+    //! Manually move forward the writing offset by a specific size.
+    void HasWritten(std::size_t size) noexcept;
+
+    //! Manually move forward the reading offset by a specific size and release retrieved chunks.
+    void Retrieve(std::size_t size) noexcept;
+
+    /**
+     * @brief Get a readable string without moving the reading offset.
+     *
+     * @warning Developers should ensure that the stored bytes are printable.
+     */
+    std::string ReadableString() const;
+
+    /**
+     * @brief Get a readable string of at most a specific size without moving the reading offset.
+     *
+     * @warning Developers should ensure that the stored bytes are printable.
+     */
+    std::string ReadableString(std::size_t size) const;
+
+    /**
+     * @brief Get a readable string of at most a specific size from an offset without moving the reading offset.
+     *
+     * @param offset An offset relative to readable bytes.
+     * @param size The maximum size.
+     *
+     * @warning Developers should ensure that the stored bytes are printable.
+     */
+    std::string ReadableString(std::size_t offset, std::size_t size) const;
+
+    /**
+     * @brief Manually move forward the reading offset to the end and extract a string from the rest.
+     *
+     * @warning Developers should ensure that the stored bytes are printable.
+     */
+    std::string RetrieveAllToString();
+
+    //! Clear the buffer and release all chunks.
+    void Clear() noexcept;
+
+    //! Release chunks that have no readable data.
+    void Shrink() noexcept;
+
+private:
+    std::size_t ChunkSize() const noexcept;
+
+    //! Get the offset from the beginning of the first chunk to the writing offset.
+    std::size_t WriteOffset() const noexcept;
+
+    ChunkAllocator* allocator_;
+    std::deque<std::byte*> chunks_;
+
+    //! The reading offset in the first chunk.
+    std::size_t read_pos_ {0};
+
+    std::size_t size_ {0};
+};
+
+}  // namespace ws
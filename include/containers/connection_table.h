@@ -0,0 +1,234 @@
+/**
+ * @file connection_table.h
+ * @brief The connection table indexed by sockets.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-12
+ *
+ * @example tests/containers/connection_table_test.cpp
+ */
+
+#pragma once
+
+#include "util.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace ws {
+
+/**
+ * @brief The connection table indexed by sockets.
+ *
+ * @details
+ * Sockets are small and dense integers, so connections are stored in slots indexed directly by their sockets.
+ * A lookup is a single index operation without hashing.
+ * Connections are owned by pointers and never move, so references to them stay valid until they are erased.
+ * A connection can be extracted from the table, for example to return it to an object pool.
+ *
+ * Each slot has a generation number, which is increased when its connection is erased.
+ * A handle records a socket with its generation,
+ * so a stale handle will not find a new connection that reuses the same socket.
+ *
+ * @tparam T The type of connections.
+ */
+template <typename T>
+class ConnectionTable {
+public:
+    //! A reference to a connection that can detect whether the socket has been reused.
+    struct Handle {
+        FileDescriptor socket {invalid_file_descriptor};
+        std::uint32_t generation {0};
+
+        bool operator==(const Handle&) const noexcept = default;
+    };
+
+    ConnectionTable() noexcept = default;
+
+    ConnectionTable(const ConnectionTable&) = delete;
+
+    ConnectionTable(ConnectionTable&&) = delete;
+
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    ConnectionTable& operator=(ConnectionTable&&) = delete;
+
+    /**
+     * @brief Put a connection into the slot of a socket.
+     *
+     * @warning The table must not contain any connection with the same socket.
+     */
+    T& Insert(FileDescriptor socket, std::unique_ptr<T> item) noexcept;
+
+    /**
+     * @brief Construct a connection in the slot of a socket.
+     *
+     * @warning The table must not contain any connection with the same socket.
+     */
+    template <typename... Args>
+    T& Emplace(FileDescriptor socket, Args&&... args);
+
+    /**
+     * @brief Take the connection of a socket out of the table.
+     *
+     * @return The connection, or @p nullptr if there is no connection.
+     */
+    std::unique_ptr<T> Extract(FileDescriptor socket) noexcept;
+
+    /**
+     * @brief Erase the connection of a socket.
+     *
+     * @return Whether the connection was erased.
+     */
+    bool Erase(FileDescriptor socket) noexcept;
+
+    /**
+     * @brief Find the connection of a socket.
+     *
+     * @return The connection, or @p nullptr if there is no connection.
+     */
+    T* Find(FileDescriptor socket) noexcept;
+
+    /**
+     * @brief Find the connection of a handle.
+     *
+     * @return The connection, or @p nullptr if it has been erased.
+     */
+    T* Find(const Handle& handle) noexcept;
+
+    /**
+     * @brief Get the handle of a socket's connection.
+     *
+     * @warning The table must contain a connection with the socket.
+     */
+    Handle GetHandle(FileDescriptor socket) const noexcept;
+
+    //! Whether the table contains the connection of a socket.
+    bool Contain(FileDescriptor socket) const noexcept;
+
+    //! Whether the table is empty.
+    bool Empty() const noexcept;
+
+    //! Get the number of connections.
+    std::size_t Size() const noexcept;
+
+    //! Erase all connections.
+    void Clear() noexcept;
+
+private:
+    struct Slot {
+        std::unique_ptr<T> item;
+        std::uint32_t generation {0};
+    };
+
+    //! Slots indexed by sockets.
+    std::vector<Slot> slots_;
+
+    std::size_t size_ {0};
+};
+
+template <typename T>
+T& ConnectionTable<T>::Insert(const FileDescriptor socket,
+                              std::unique_ptr<T> item) noexcept {
+    assert(IsValidFileDescriptor(socket));
+    assert(!Contain(socket));
+    assert(item);
+
+    const auto index {static_cast<std::size_t>(socket)};
+    if (slots_.size() <= index) {
+        slots_.resize(index + 1);
+    }
+
+    auto& slot {slots_[index]};
+    slot.item = std::move(item);
+    ++size_;
+    return *slot.item;
+}
+
+template <typename T>
+template <typename... Args>
+T& ConnectionTable<T>::Emplace(const FileDescriptor socket, Args&&... args) {
+    return Insert(socket, std::make_unique<T>(std::forward<Args>(args)...));
+}
+
+template <typename T>
+std::unique_ptr<T> ConnectionTable<T>::Extract(
+    const FileDescriptor socket) noexcept {
+    if (!Contain(socket)) {
+        return nullptr;
+    }
+
+    auto& slot {slots_[static_cast<std::size_t>(socket)]};
+    ++slot.generation;
+    --size_;
+    return std::move(slot.item);
+}
+
+template <typename T>
+bool ConnectionTable<T>::Erase(const FileDescriptor socket) noexcept {
+    return Extract(socket) != nullptr;
+}
+
+template <typename T>
+T* ConnectionTable<T>::Find(const FileDescriptor socket) noexcept {
+    return Contain(socket)
+               ? slots_[static_cast<std::size_t>(socket)].item.get()
+               : nullptr;
+}
+
+template <typename T>
+T* ConnectionTable<T>::Find(const Handle& handle) noexcept {
+    if (!Contain(handle.socket)) {
+        return nullptr;
+    }
+
+    auto& slot {slots_[static_cast<std::size_t>(handle.socket)]};
+    return slot.generation == handle.generation ? slot.item.get() : nullptr;
+}
+
+template <typename T>
+typename ConnectionTable<T>::Handle ConnectionTable<T>::GetHandle(
+    const FileDescriptor socket) const noexcept {
+    assert(Contain(socket));
+    return {.socket = socket,
+            .generation = slots_[static_cast<std::size_t>(socket)].generation};
+}
+
+template <typename T>
+bool ConnectionTable<T>::Contain(const FileDescriptor socket) const noexcept {
+    return IsValidFileDescriptor(socket)
+           && static_cast<std::size_t>(socket) < slots_.size()
+           && slots_[static_cast<std::size_t>(socket)].item != nullptr;
+}
+
+template <typename T>
+bool ConnectionTable<T>::Empty() const noexcept {
+    return size_ == 0;
+}
+
+template <typename T>
+std::size_t ConnectionTable<T>::Size() const noexcept {
+    return size_;
+}
+
+template <typename T>
+void ConnectionTable<T>::Clear() noexcept {
+    for (auto& slot : slots_) {
+        if (slot.item) {
+            slot.item.reset();
+            ++slot.generation;
+        }
+    }
+
+    size_ = 0;
+}
+
+}  // namespace ws
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include "containers/poller.h"
 #include "util.h"
 
 #include <sys/epoll.h>
@@ -25,25 +26,28 @@ namespace ws {
 
 /**
  * @brief
- * The I/O event notification facility.
+ * The I/O event notification facility based on @p epoll.
  *
  * @details
  * It monitors multiple file descriptors to see if I/O is possible on any of them.
+ *
+ * The event array grows when a wait fills it and shrinks when it has been mostly empty for a while,
+ * so it follows the number of ready file descriptors up to its capacity.
+ * Time-outs have nanosecond precision if the kernel supports @p epoll_pwait2,
+ * otherwise they are rounded up to milliseconds.
  */
-class Epoller {
+class Epoller : public Poller {
 public:
-    using Clock = std::chrono::steady_clock;
-
     /**
      * @brief Create an epoller.
      *
-     * @param capacity The maximum number of file descriptors to be monitored.
+     * @param capacity The maximum number of events returned by each wait.
      *
      * @exception std::system_error Creation failed.
      */
     explicit Epoller(std::size_t capacity = 1024);
 
-    ~Epoller() noexcept;
+    ~Epoller() noexcept override;
 
     Epoller(const Epoller&) = delete;
 
@@ -54,46 +58,47 @@ public:
     Epoller& operator=(Epoller&&) = delete;
 
     //! Close the epoller.
-    void Close() noexcept;
+    void Close() noexcept override;
 
     //! Add a file descriptor to the epoller.
-    void AddFileDescriptor(ws::FileDescriptor fd, std::uint32_t events);
+    void AddFileDescriptor(ws::FileDescriptor fd,
+                           std::uint32_t events) override;
 
     //! Remove a file descriptor from the epoller.
-    void DeleteFileDescriptor(ws::FileDescriptor fd);
+    void DeleteFileDescriptor(ws::FileDescriptor fd) override;
 
     //! Change the setting associated with a file descriptor in the epoller.
-    void ModifyFileDescriptor(ws::FileDescriptor fd, std::uint32_t events);
-
-    /**
-     * @brief Wait for events.
-     *
-     * @param time_out The maximum time to wait.
-     * @return
-     * The number of file descriptors ready for the requested I/O,
-     * or zero if getting a time-out.
-     *
-     * @exception std::system_error Failed to wait.
-     */
-    std::size_t Wait(Clock::duration time_out);
+    void ModifyFileDescriptor(ws::FileDescriptor fd,
+                              std::uint32_t events) override;
 
     /**
      * @brief Get a file descriptor's trigger events.
      *
      * @note This method should be called after @p Wait returns.
      */
-    std::uint32_t Events(std::size_t idx) const noexcept;
+    std::uint32_t Events(std::size_t idx) const noexcept override;
 
     /**
      * @brief Get a file descriptor.
      *
      * @note This method should be called after @p Wait returns.
      */
-    ws::FileDescriptor FileDescriptor(std::size_t idx) const noexcept;
+    ws::FileDescriptor FileDescriptor(
+        std::size_t idx) const noexcept override;
+
+protected:
+    std::size_t WaitForEvents(
+        std::optional<Clock::duration> time_out) override;
 
 private:
     enum class Control { Add, Delete, Modify };
 
+    //! The initial size of the event array.
+    static constexpr std::size_t min_event_count {64};
+
+    //! The number of consecutive mostly empty waits before the event array shrinks.
+    static constexpr std::size_t shrink_wait_count {0x100};
+
     /**
      * @brief Perform control operations on a file descriptor.
      *
@@ -110,8 +115,19 @@ private:
 
     bool ValidIndex(std::size_t idx) const noexcept;
 
+    //! Grow or shrink the event array according to the number of ready file descriptors.
+    void Adapt(std::size_t ready_count) noexcept;
+
     ws::FileDescriptor epoll_fd_ {invalid_file_descriptor};
     std::vector<epoll_event> events_;
+
+    std::size_t capacity_;
+
+    //! The number of consecutive waits that filled no more than a quarter of the event array.
+    std::size_t sparse_wait_count_ {0};
+
+    //! Whether the kernel supports @p epoll_pwait2.
+    bool precise_wait_ {true};
 };
 
 }  // namespace ws
\ No newline at end of file
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "log.h"
+#include "metrics.h"
 #include "util.h"
 
 #include <algorithm>
@@ -36,6 +37,7 @@ namespace ws {
  * @details
  * Timers are maintained in a min-heap ordered by expiration time.
  * When a timer expires, its callback will be invoked.
+ * The number of timers and expirations are recorded in metrics.
  *
  * @tparam Key The type of node keys.
  */
@@ -54,6 +56,8 @@ public:
      */
     explicit HeapTimer(log::Logger::Ptr logger = log::RootLogger()) noexcept;
 
+    ~HeapTimer() noexcept;
+
     HeapTimer(HeapTimer&&) = delete;
 
     HeapTimer& operator=(HeapTimer&&) = delete;
@@ -225,6 +229,9 @@ private:
     //! A map from user-defined keys to array indices.
     std::unordered_map<Key, std::size_t> key_to_idx_;
     std::deque<Node> nodes_;
+
+    metrics::Gauge& timers_;
+    metrics::Counter& expirations_;
 };
 
 template <typename Key>
@@ -242,14 +249,25 @@ void HeapTimer<Key>::Node::Swap(Node& o) noexcept {
 
 template <typename Key>
 HeapTimer<Key>::HeapTimer(log::Logger::Ptr logger) noexcept :
-    logger_ {std::move(logger)} {
+    logger_ {std::move(logger)},
+    timers_ {metrics::DefaultRegistry().AddGauge(
+        "ws_timers", "The number of pending timers", {{"type", "heap"}})},
+    expirations_ {metrics::DefaultRegistry().AddCounter(
+        "ws_timer_expirations_total", "The number of expired timers",
+        {{"type", "heap"}})} {
     if (!logger_) {
         logger_ = log::RootLogger();
     }
 }
 
+template <typename Key>
+HeapTimer<Key>::~HeapTimer() noexcept {
+    Clear();
+}
+
 template <typename Key>
 void HeapTimer<Key>::Clear() noexcept {
+    timers_.Decrease(static_cast<std::int64_t>(nodes_.size()));
     nodes_.clear();
     key_to_idx_.clear();
 }
@@ -316,6 +334,7 @@ void HeapTimer<Key>::Push(const Key& key, const Clock::time_point expiration,
         key_to_idx_.emplace(key, idx);
         nodes_.push_back({key, expiration, std::move(callback)});
         ShiftUp(idx);
+        timers_.Increase();
     } else {
         Adjust(key, expiration, std::move(callback));
     }
@@ -408,6 +427,7 @@ void HeapTimer<Key>::Tick() noexcept {
             const auto callback {std::move(node.callback)};
             const auto key {node.key};
             Pop();
+            expirations_.Increase();
 
             try {
                 assert(callback);
@@ -489,6 +509,7 @@ Key HeapTimer<Key>::RemoveByIndex(const std::size_t idx) noexcept {
     // Delete the input node.
     nodes_.pop_back();
     key_to_idx_.erase(key);
+    timers_.Decrease();
 
     // Move the top node to the correct place.
     ShiftDown(0);
@@ -0,0 +1,197 @@
+/**
+ * @file io_uring_poller.h
+ * @brief The @p io_uring poll backend of I/O event notification.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-16
+ *
+ * @example tests/containers/poller_test.cpp
+ */
+
+#pragma once
+
+#include "containers/poller.h"
+#include "util.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+
+namespace ws {
+
+/**
+ * @brief The @p io_uring poll backend of I/O event notification.
+ *
+ * @details
+ * File descriptors are monitored by poll requests in the submission queue.
+ * It only replaces @p epoll_ctl and @p epoll_wait,
+ * so accepting, receiving and sending still cost a system call each.
+ * Adding, modifying and removing file descriptors only queue requests without system calls.
+ * Queued requests are submitted together when waiting, so the whole batch costs a single @p io_uring_enter.
+ * If a file descriptor is modified in another thread while the poller may be waiting,
+ * its request is submitted immediately instead.
+ *
+ * A file descriptor without @p EPOLLONESHOT is monitored by a multi-shot poll request,
+ * which stays armed after its events are triggered.
+ * @p EPOLLET is ignored, as re-arming a one-shot request checks the current readiness like @p epoll does.
+ *
+ * Each request records the generation of its file descriptor,
+ * so completions of requests issued before the file descriptor was removed or modified are ignored.
+ *
+ * @note It needs Linux 5.11 or later.
+ */
+class IoUringPoller : public Poller {
+public:
+    /**
+     * @brief Create an @p io_uring poller.
+     *
+     * @param capacity The maximum number of events returned by each wait.
+     *
+     * @exception std::system_error The kernel does not support @p io_uring or the required features.
+     */
+    explicit IoUringPoller(std::size_t capacity = 1024);
+
+    ~IoUringPoller() noexcept override;
+
+    IoUringPoller(const IoUringPoller&) = delete;
+
+    IoUringPoller(IoUringPoller&&) = delete;
+
+    IoUringPoller& operator=(const IoUringPoller&) = delete;
+
+    IoUringPoller& operator=(IoUringPoller&&) = delete;
+
+    void Close() noexcept override;
+
+    /**
+     * @brief Add a file descriptor to the poller.
+     *
+     * @exception std::system_error The file descriptor has been added.
+     */
+    void AddFileDescriptor(ws::FileDescriptor fd,
+                           std::uint32_t events) override;
+
+    /**
+     * @brief Remove a file descriptor from the poller.
+     *
+     * @exception std::system_error The file descriptor has not been added.
+     */
+    void DeleteFileDescriptor(ws::FileDescriptor fd) override;
+
+    /**
+     * @brief Change the events associated with a file descriptor in the poller.
+     *
+     * @details It can be called in any thread.
+     *
+     * @exception std::system_error The file descriptor has not been added.
+     */
+    void ModifyFileDescriptor(ws::FileDescriptor fd,
+                              std::uint32_t events) override;
+
+    std::uint32_t Events(std::size_t idx) const noexcept override;
+
+    ws::FileDescriptor FileDescriptor(
+        std::size_t idx) const noexcept override;
+
+protected:
+    std::size_t WaitForEvents(
+        std::optional<Clock::duration> time_out) override;
+
+private:
+    //! The state of a monitored file descriptor.
+    struct Target {
+        //! It is increased when the file descriptor is removed or its request is replaced.
+        std::uint32_t generation {0};
+
+        std::uint32_t events {0};
+
+        bool registered {false};
+
+        //! Whether a poll request is pending in the kernel.
+        bool armed {false};
+    };
+
+    struct Event {
+        ws::FileDescriptor fd {invalid_file_descriptor};
+        std::uint32_t events {0};
+    };
+
+    /**
+     * @brief Get the target of a file descriptor.
+     *
+     * @exception std::system_error The file descriptor has not been added.
+     */
+    Target& RegisteredTarget(ws::FileDescriptor fd);
+
+    /**
+     * @brief Get an empty entry in the submission queue.
+     *
+     * @details If the queue is full, queued requests are submitted first.
+     *
+     * @exception std::system_error Failed to submit requests.
+     */
+    io_uring_sqe& NextEntry();
+
+    //! Make a queued entry visible to the kernel.
+    void CommitEntry() noexcept;
+
+    //! Queue a poll request for a file descriptor.
+    void Arm(ws::FileDescriptor fd, Target& target);
+
+    //! Queue a request to cancel the poll request of a file descriptor.
+    void Disarm(ws::FileDescriptor fd, Target& target);
+
+    /**
+     * @brief Submit queued requests without waiting.
+     *
+     * @exception std::system_error Failed to submit requests.
+     */
+    void Submit();
+
+    //! Move completions into the event array.
+    std::size_t Reap();
+
+    bool ValidIndex(std::size_t idx) const noexcept;
+
+    ws::FileDescriptor ring_fd_ {invalid_file_descriptor};
+
+    void* ring_ {nullptr};
+    std::size_t ring_size_ {0};
+
+    io_uring_sqe* entries_ {nullptr};
+    std::size_t entry_count_ {0};
+
+    unsigned* sq_head_ {nullptr};
+    unsigned* sq_tail_ {nullptr};
+    unsigned sq_mask_ {0};
+    unsigned* sq_array_ {nullptr};
+
+    unsigned* cq_head_ {nullptr};
+    unsigned* cq_tail_ {nullptr};
+    unsigned cq_mask_ {0};
+    io_uring_cqe* cq_entries_ {nullptr};
+
+    //! The thread waiting for events.
+    std::atomic<std::thread::id> waiter_;
+
+    //! The lock for the submission queue and targets.
+    std::mutex mtx_;
+
+    //! Targets indexed by file descriptors.
+    std::vector<Target> targets_;
+
+    std::vector<Event> events_;
+};
+
+}  // namespace ws
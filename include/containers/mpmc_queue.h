@@ -0,0 +1,206 @@
+/**
+ * @file mpmc_queue.h
+ * @brief The lock-free bounded multi-producer multi-consumer queue.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-06
+ *
+ * @example tests/containers/mpmc_queue_test.cpp
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+
+namespace ws {
+
+//! The consumer policy for a queue popped by multiple threads, which claim slots with compare-and-swaps.
+struct MultiConsumer {};
+
+//! The consumer policy for a queue popped by one thread at a time, which needs no read-modify-write operations to pop.
+struct SingleConsumer {};
+
+/**
+ * @brief The lock-free bounded multi-producer multi-consumer queue.
+ *
+ * @details
+ * Each slot has a sequence number telling producers and consumers whether it is ready for them,
+ * so an operation only needs a single compare-and-swap on the shared position.
+ * Pushing into a full queue or popping from an empty queue fails immediately instead of waiting.
+ * A popped slot releases its element immediately instead of keeping it until the slot is reused.
+ *
+ * @tparam ConsumerPolicy
+ * A policy deciding whether popping is synchronized between consumers.
+ * With @p SingleConsumer, @p TryPop must only be called by one thread at a time.
+ */
+template <typename T, typename ConsumerPolicy = MultiConsumer>
+class MPMCQueue {
+public:
+    /**
+     * @brief Create a multi-producer multi-consumer queue.
+     *
+     * @param capacity
+     * The maximum capacity, which will be rounded up to a power of two.
+     * It is at least two, since a slot's sequence number cannot tell a full slot from a free one in a single-slot queue.
+     */
+    explicit MPMCQueue(std::size_t capacity = 0x400) noexcept;
+
+    MPMCQueue(const MPMCQueue&) = delete;
+
+    MPMCQueue(MPMCQueue&&) = delete;
+
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+    /**
+     * @brief Try to push an element to the end.
+     *
+     * @details The element is only moved if it has been pushed.
+     *
+     * @return @p false if the queue is full, otherwise @p true.
+     */
+    bool TryPush(T&& item) noexcept;
+
+    /**
+     * @brief Try to pop the first element.
+     *
+     * @return The first element, or @p std::nullopt if the queue is empty.
+     */
+    std::optional<T> TryPop() noexcept;
+
+    //! Get the approximate number of elements.
+    std::size_t Size() const noexcept;
+
+    //! Whether the queue is approximately empty.
+    bool Empty() const noexcept;
+
+    //! Get the maximum capacity.
+    std::size_t Capacity() const noexcept;
+
+private:
+    static constexpr std::size_t cache_line_size {64};
+
+    struct Slot {
+        std::atomic<std::size_t> sequence {0};
+        T item {};
+    };
+
+    std::size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+
+    //! The position where the next element is pushed.
+    alignas(cache_line_size) std::atomic<std::size_t> tail_ {0};
+
+    //! The position where the next element is popped, only written by the consumer with @p SingleConsumer.
+    alignas(cache_line_size) std::atomic<std::size_t> head_ {0};
+};
+
+template <typename T, typename ConsumerPolicy>
+MPMCQueue<T, ConsumerPolicy>::MPMCQueue(const std::size_t capacity) noexcept :
+    capacity_ {std::bit_ceil(std::max<std::size_t>(capacity, 2))},
+    slots_ {std::make_unique<Slot[]>(capacity_)} {
+    assert(capacity > 0);
+    for (std::size_t i {0}; i != capacity_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, typename ConsumerPolicy>
+bool MPMCQueue<T, ConsumerPolicy>::TryPush(T&& item) noexcept {
+    auto pos {tail_.load(std::memory_order_relaxed)};
+    while (true) {
+        auto& slot {slots_[pos & (capacity_ - 1)]};
+        const auto seq {slot.sequence.load(std::memory_order_acquire)};
+        const auto diff {static_cast<std::intptr_t>(seq)
+                         - static_cast<std::intptr_t>(pos)};
+        if (diff == 0) {
+            // The slot is free, try to claim it.
+            if (tail_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+                slot.item = std::move(item);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The slot has not been consumed since the last cycle.
+            return false;
+        } else {
+            // Another producer has claimed the slot.
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T, typename ConsumerPolicy>
+std::optional<T> MPMCQueue<T, ConsumerPolicy>::TryPop() noexcept {
+    auto pos {head_.load(std::memory_order_relaxed)};
+    if constexpr (std::same_as<ConsumerPolicy, SingleConsumer>) {
+        auto& slot {slots_[pos & (capacity_ - 1)]};
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            // The slot has not been filled yet.
+            return std::nullopt;
+        }
+
+        std::optional<T> item {std::move(slot.item)};
+        slot.item = T {};
+        head_.store(pos + 1, std::memory_order_relaxed);
+        slot.sequence.store(pos + capacity_, std::memory_order_release);
+        return item;
+    }
+
+    while (true) {
+        auto& slot {slots_[pos & (capacity_ - 1)]};
+        const auto seq {slot.sequence.load(std::memory_order_acquire)};
+        const auto diff {static_cast<std::intptr_t>(seq)
+                         - static_cast<std::intptr_t>(pos + 1)};
+        if (diff == 0) {
+            // The slot has been filled, try to claim it.
+            if (head_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+                std::optional<T> item {std::move(slot.item)};
+                slot.item = T {};
+                slot.sequence.store(pos + capacity_, std::memory_order_release);
+                return item;
+            }
+        } else if (diff < 0) {
+            // The slot has not been filled yet.
+            return std::nullopt;
+        } else {
+            // Another consumer has claimed the slot.
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T, typename ConsumerPolicy>
+std::size_t MPMCQueue<T, ConsumerPolicy>::Size() const noexcept {
+    const auto tail {tail_.load(std::memory_order_relaxed)};
+    const auto head {head_.load(std::memory_order_relaxed)};
+    return tail > head ? tail - head : 0;
+}
+
+template <typename T, typename ConsumerPolicy>
+bool MPMCQueue<T, ConsumerPolicy>::Empty() const noexcept {
+    return Size() == 0;
+}
+
+template <typename T, typename ConsumerPolicy>
+std::size_t MPMCQueue<T, ConsumerPolicy>::Capacity() const noexcept {
+    return capacity_;
+}
+
+}  // namespace ws
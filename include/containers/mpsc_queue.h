@@ -0,0 +1,34 @@
+/**
+ * @file mpsc_queue.h
+ * @brief The lock-free bounded multi-producer single-consumer queue.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-18
+ *
+ * @example tests/containers/mpsc_queue_test.cpp
+ */
+
+#pragma once
+
+#include "containers/mpmc_queue.h"
+
+
+namespace ws {
+
+/**
+ * @brief The lock-free bounded multi-producer single-consumer queue.
+ *
+ * @details
+ * It shares the slots and the pushing protocol of @p MPMCQueue.
+ * Since there is only one consumer, popping needs no read-modify-write operations at all.
+ *
+ * @warning @p TryPop must only be called by one thread at a time.
+ */
+template <typename T>
+using MPSCQueue = MPMCQueue<T, SingleConsumer>;
+
+}  // namespace ws
@@ -0,0 +1,156 @@
+/**
+ * @file object_pool.h
+ * @brief The pool of reusable objects.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-13
+ *
+ * @example tests/containers/object_pool_test.cpp
+ */
+
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace ws {
+
+/**
+ * @brief The pool of reusable objects.
+ *
+ * @details
+ * Released objects are kept in the pool instead of being destroyed.
+ * Acquiring an object reinitializes a kept one by its @p Reset method,
+ * so resources it owns, such as buffers, can be reused without allocating memory again.
+ *
+ * @warning The pool is not thread-safe.
+ *
+ * @tparam T The type of objects.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    /**
+     * @brief Create an object pool.
+     *
+     * @param capacity The maximum number of kept objects.
+     * Objects released when the pool is full are destroyed.
+     */
+    explicit ObjectPool(std::size_t capacity = 0x400) noexcept;
+
+    ObjectPool(const ObjectPool&) = delete;
+
+    ObjectPool(ObjectPool&&) = delete;
+
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ObjectPool& operator=(ObjectPool&&) = delete;
+
+    /**
+     * @brief Get an object.
+     *
+     * @details
+     * A kept object is reinitialized with @p Reset if there is one.
+     * Otherwise, a new object is created.
+     */
+    template <typename... Args>
+        requires std::constructible_from<T, Args...>
+                 && requires(T& obj, Args&&... args) {
+                        obj.Reset(std::forward<Args>(args)...);
+                    }
+    std::unique_ptr<T> Acquire(Args&&... args);
+
+    //! Return an object to the pool, or destroy it if the pool is full.
+    void Release(std::unique_ptr<T> obj) noexcept;
+
+    //! Get the number of kept objects.
+    std::size_t Size() const noexcept;
+
+    //! Get the maximum number of kept objects.
+    std::size_t Capacity() const noexcept;
+
+    //! Get the number of acquisitions that reused a kept object.
+    std::size_t HitCount() const noexcept;
+
+    //! Get the number of acquisitions that created a new object.
+    std::size_t MissCount() const noexcept;
+
+    //! Destroy all kept objects.
+    void Clear() noexcept;
+
+private:
+    std::size_t capacity_;
+    std::vector<std::unique_ptr<T>> objs_;
+
+    std::size_t hit_count_ {0};
+    std::size_t miss_count_ {0};
+};
+
+template <typename T>
+ObjectPool<T>::ObjectPool(const std::size_t capacity) noexcept :
+    capacity_ {capacity} {
+    objs_.reserve(capacity_);
+}
+
+template <typename T>
+template <typename... Args>
+    requires std::constructible_from<T, Args...>
+             && requires(T& obj, Args&&... args) {
+                    obj.Reset(std::forward<Args>(args)...);
+                }
+std::unique_ptr<T> ObjectPool<T>::Acquire(Args&&... args) {
+    if (objs_.empty()) {
+        ++miss_count_;
+        return std::make_unique<T>(std::forward<Args>(args)...);
+    }
+
+    ++hit_count_;
+    auto obj {std::move(objs_.back())};
+    objs_.pop_back();
+    obj->Reset(std::forward<Args>(args)...);
+    return obj;
+}
+
+template <typename T>
+void ObjectPool<T>::Release(std::unique_ptr<T> obj) noexcept {
+    assert(obj);
+    if (objs_.size() < capacity_) {
+        objs_.push_back(std::move(obj));
+    }
+}
+
+template <typename T>
+std::size_t ObjectPool<T>::Size() const noexcept {
+    return objs_.size();
+}
+
+template <typename T>
+std::size_t ObjectPool<T>::Capacity() const noexcept {
+    return capacity_;
+}
+
+template <typename T>
+std::size_t ObjectPool<T>::HitCount() const noexcept {
+    return hit_count_;
+}
+
+template <typename T>
+std::size_t ObjectPool<T>::MissCount() const noexcept {
+    return miss_count_;
+}
+
+template <typename T>
+void ObjectPool<T>::Clear() noexcept {
+    objs_.clear();
+}
+
+}  // namespace ws
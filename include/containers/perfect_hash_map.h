@@ -0,0 +1,185 @@
+/**
+ * @file perfect_hash_map.h
+ * @brief The compile-time perfect-hash map with case-insensitive string keys.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-29
+ *
+ * @example tests/containers/perfect_hash_map_test.cpp
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+
+namespace ws {
+
+//! Convert an ASCII character to lower case.
+constexpr char ToLowerASCII(const char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+//! Whether two strings are equal, ignoring the case of ASCII letters.
+constexpr bool EqualsIgnoreCase(const std::string_view lhs,
+                                const std::string_view rhs) noexcept {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+
+    for (std::size_t i {0}; i != lhs.size(); ++i) {
+        if (ToLowerASCII(lhs[i]) != ToLowerASCII(rhs[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Hash a string with FNV-1a, ignoring the case of ASCII letters.
+ *
+ * @param seed A seed changing the hash of all strings.
+ */
+constexpr std::uint64_t HashIgnoreCase(const std::string_view str,
+                                       const std::uint64_t seed) noexcept {
+    constexpr std::uint64_t offset_basis {0xCBF29CE484222325};
+    constexpr std::uint64_t prime {0x100000001B3};
+    auto hash {offset_basis ^ (seed * prime)};
+    for (const auto c : str) {
+        hash ^= static_cast<std::uint8_t>(ToLowerASCII(c));
+        hash *= prime;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * @brief The immutable map from case-insensitive string keys to values, built at compile time.
+ *
+ * @details
+ * When the map is built, a seed is searched so that all keys are hashed to different slots.
+ * A lookup hashes the key once and compares it with the only candidate in its slot,
+ * so it neither probes nor allocates.
+ * Keys are compared ignoring the case of ASCII letters.
+ *
+ * @tparam Value The type of values.
+ * @tparam N The number of keys.
+ *
+ * @code {.cpp}
+ * constexpr auto methods {MakePerfectHashMap<Method>({
+ *     {"GET", Method::Get},
+ *     {"POST", Method::Post},
+ * })};
+ * static_assert(methods.Find("get") == Method::Get);
+ * @endcode
+ */
+template <typename Value, std::size_t N>
+class PerfectHashMap {
+public:
+    using Entry = std::pair<std::string_view, Value>;
+
+    //! The number of slots, which keeps the load factor at most 0.5 so a seed is found quickly.
+    static constexpr std::size_t capacity {std::bit_ceil(N * 2)};
+
+    static_assert(N > 0 && N < 0xFF,
+                  "The number of keys must be in the range of slots' indices");
+
+    /**
+     * @brief Build a map.
+     *
+     * @details It fails to compile if keys are duplicated.
+     */
+    consteval explicit PerfectHashMap(const Entry (&entries)[N]) {
+        for (std::size_t i {0}; i != N; ++i) {
+            entries_[i] = entries[i];
+            for (std::size_t j {0}; j != i; ++j) {
+                if (EqualsIgnoreCase(entries[i].first, entries[j].first)) {
+                    throw std::invalid_argument {"Duplicate keys"};
+                }
+            }
+        }
+
+        constexpr std::uint64_t max_seed {0x10000};
+        for (seed_ = 0; seed_ != max_seed; ++seed_) {
+            if (TryBuild()) {
+                return;
+            }
+        }
+
+        throw std::invalid_argument {"No perfect hash seed is found"};
+    }
+
+    //! Find the value of a key.
+    constexpr std::optional<Value> Find(
+        const std::string_view key) const noexcept {
+        const auto slot {slots_[Slot(key)]};
+        if (slot != 0 && EqualsIgnoreCase(entries_[slot - 1].first, key)) {
+            return entries_[slot - 1].second;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    //! Whether a key exists.
+    constexpr bool Contains(const std::string_view key) const noexcept {
+        return Find(key).has_value();
+    }
+
+    //! Get the number of keys.
+    static constexpr std::size_t Size() noexcept {
+        return N;
+    }
+
+    //! Get all entries in the order of building.
+    constexpr const std::array<Entry, N>& Entries() const noexcept {
+        return entries_;
+    }
+
+private:
+    constexpr std::size_t Slot(const std::string_view key) const noexcept {
+        return HashIgnoreCase(key, seed_) & (capacity - 1);
+    }
+
+    //! Try to place all keys into different slots with the current seed.
+    consteval bool TryBuild() noexcept {
+        slots_.fill(0);
+        for (std::size_t i {0}; i != N; ++i) {
+            auto& slot {slots_[Slot(entries_[i].first)]};
+            if (slot != 0) {
+                return false;
+            }
+
+            slot = static_cast<std::uint8_t>(i + 1);
+        }
+
+        return true;
+    }
+
+    std::array<Entry, N> entries_ {};
+
+    //! Indices of entries plus one, or zero for empty slots.
+    std::array<std::uint8_t, capacity> slots_ {};
+
+    std::uint64_t seed_ {0};
+};
+
+//! Build a perfect-hash map at compile time, deducing the number of keys.
+template <typename Value, std::size_t N>
+consteval PerfectHashMap<Value, N> MakePerfectHashMap(
+    const std::pair<std::string_view, Value> (&entries)[N]) {
+    return PerfectHashMap<Value, N> {entries};
+}
+
+}  // namespace ws
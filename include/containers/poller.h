@@ -0,0 +1,147 @@
+/**
+ * @file poller.h
+ * @brief The interface of I/O event notification facilities.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-16
+ *
+ * @example tests/containers/poller_test.cpp
+ */
+
+#pragma once
+
+#include "util.h"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+
+namespace ws {
+
+/**
+ * @brief The interface of I/O event notification facilities.
+ *
+ * @details
+ * Events are described with @p epoll flags, such as @p EPOLLIN, @p EPOLLOUT and @p EPOLLONESHOT,
+ * whatever the backend is.
+ *
+ * A poller can busy-poll for a while before blocking,
+ * trading CPU time for lower latency when events arrive shortly after a wait starts.
+ */
+class Poller {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    using Ptr = std::unique_ptr<Poller>;
+
+    //! Backends of pollers.
+    enum class Backend {
+        //! @p epoll, which needs a system call for each change of a file descriptor's events.
+        Epoll,
+        //! The @p io_uring poll backend, which submits changes of events in batches when waiting.
+        IoUring
+    };
+
+    //! Options of pollers.
+    struct Options;
+
+    /**
+     * @brief Create a poller.
+     *
+     * @exception std::system_error Creation failed, for example the kernel does not support the backend.
+     */
+    static Ptr Create(const Options& options);
+
+    /**
+     * @brief Get a backend by its name.
+     *
+     * @param name @p epoll or @p io_uring.
+     *
+     * @exception std::invalid_argument The name is invalid.
+     */
+    static Backend ToBackend(std::string_view name);
+
+    virtual ~Poller() noexcept = default;
+
+    //! Close the poller.
+    virtual void Close() noexcept = 0;
+
+    //! Add a file descriptor to the poller.
+    virtual void AddFileDescriptor(ws::FileDescriptor fd,
+                                   std::uint32_t events) = 0;
+
+    //! Remove a file descriptor from the poller.
+    virtual void DeleteFileDescriptor(ws::FileDescriptor fd) = 0;
+
+    //! Change the events associated with a file descriptor in the poller.
+    virtual void ModifyFileDescriptor(ws::FileDescriptor fd,
+                                      std::uint32_t events) = 0;
+
+    /**
+     * @brief Wait for events.
+     *
+     * @details If busy polling is enabled, the poller checks for events without blocking before waiting.
+     *
+     * @param time_out
+     * The maximum time to wait.
+     * If it is @p std::nullopt, the call will block until an event is triggered.
+     * @return
+     * The number of file descriptors ready for the requested I/O,
+     * or zero if getting a time-out.
+     *
+     * @exception std::system_error Failed to wait.
+     */
+    std::size_t Wait(std::optional<Clock::duration> time_out = std::nullopt);
+
+    /**
+     * @brief Set how long a wait polls without blocking.
+     *
+     * @param time The busy-polling time. Zero disables busy polling.
+     */
+    void SetBusyPoll(Clock::duration time) noexcept;
+
+    /**
+     * @brief Get a file descriptor's trigger events.
+     *
+     * @note This method should be called after @p Wait returns.
+     */
+    virtual std::uint32_t Events(std::size_t idx) const noexcept = 0;
+
+    /**
+     * @brief Get a file descriptor.
+     *
+     * @note This method should be called after @p Wait returns.
+     */
+    virtual ws::FileDescriptor FileDescriptor(
+        std::size_t idx) const noexcept = 0;
+
+protected:
+    /**
+     * @brief Wait for events with the backend.
+     *
+     * @details It has the same semantics as @p Wait without busy polling.
+     */
+    virtual std::size_t WaitForEvents(
+        std::optional<Clock::duration> time_out) = 0;
+
+private:
+    Clock::duration busy_poll_ {Clock::duration::zero()};
+};
+
+struct Poller::Options {
+    Backend backend {Backend::Epoll};
+
+    //! The maximum number of events returned by each wait.
+    std::size_t max_events {1024};
+
+    //! How long a wait polls without blocking. Zero disables busy polling.
+    Clock::duration busy_poll {Clock::duration::zero()};
+};
+
+}  // namespace ws
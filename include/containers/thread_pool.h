@@ -14,22 +14,109 @@
 
 #pragma once
 
+#include "containers/unique_function.h"
 #include "log.h"
+#include "metrics.h"
 
+#include <chrono>
 #include <condition_variable>
-#include <functional>
 #include <list>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 
 namespace ws {
 
-//! The thread pool.
-class ThreadPool {
+//! The interface of objects executing tasks in background threads.
+class Executor {
+public:
+    /**
+     * @brief The task type.
+     *
+     * @details
+     * A task is stored inline without allocating memory.
+     * It is large enough for a reactor's lambda capturing @p this, a client's reference, its handle and a member-function pointer.
+     */
+    using Task = UniqueFunction<void(), 48>;
+
+    virtual ~Executor() noexcept = default;
+
+    //! Run the executor.
+    virtual void Start() noexcept = 0;
+
+    //! Push a task into the executor.
+    virtual void Push(Task task) noexcept = 0;
+
+    /**
+     * @brief Push multiple tasks into the executor at once.
+     *
+     * @details
+     * It is cheaper than pushing tasks one by one,
+     * as the executor is synchronized and working threads are woken up once for the whole batch.
+     * Tasks are moved out of the span.
+     */
+    virtual void PushBatch(std::span<Task> tasks) noexcept = 0;
+
+    /**
+     * @brief Close the executor.
+     *
+     * @details
+     * The remaining tasks will not be executed.
+     */
+    virtual void Close() noexcept = 0;
+
+    /**
+     * @brief Get the number of tasks waiting to be executed.
+     *
+     * @details It may be outdated as soon as it returns, so it is only suitable for admission decisions.
+     */
+    virtual std::size_t QueuedCount() const noexcept = 0;
+
+    /**
+     * @brief Set CPUs where working threads run.
+     *
+     * @details
+     * It must be called before the executor starts.
+     * The i-th working thread is pinned to the CPU @p cpus[i % cpus.size()],
+     * so it is not moved between cores and its memory stays on the same NUMA node.
+     * An empty list leaves working threads to the scheduler.
+     */
+    void SetAffinity(std::vector<std::size_t> cpus) noexcept;
+
+    //! Get CPUs where working threads run.
+    const std::vector<std::size_t>& Affinity() const noexcept;
+
+protected:
+    /**
+     * @brief Pin a working thread to its CPU if the affinity has been set.
+     *
+     * @param thread A working thread.
+     * @param idx The index of the working thread.
+     *
+     * @exception std::system_error Failed to set the affinity.
+     */
+    void PinWorker(std::thread& thread, std::size_t idx) const;
+
+private:
+    std::vector<std::size_t> cpus_;
+};
+
+/**
+ * @brief The thread pool.
+ *
+ * @details
+ * All working threads share a single task queue protected by a lock.
+ * Nodes of executed tasks are recycled through a free list,
+ * so pushing a task does not allocate memory once the queue has grown to its working size.
+ *
+ * The queue length and the time from pushing a task to starting it are recorded in metrics.
+ */
+class ThreadPool : public Executor {
 public:
-    using Task = std::function<void()>;
 
     /**
      * @brief Create a thread pool.
@@ -39,11 +126,14 @@ public:
      * If it is @p std::nullopt or zero, the thread pool will use the number of concurrent threads supported by hardware.
      * @param logger
      * A logger. If it is @p nullptr, the thread pool will use the global root logger.
+     * @param pool
+     * The value of the @p pool label in metrics, telling pools with different purposes apart.
      */
     explicit ThreadPool(std::optional<std::size_t> thread_count = std::nullopt,
-                        log::Logger::Ptr logger = log::RootLogger()) noexcept;
+                        log::Logger::Ptr logger = log::RootLogger(),
+                        std::string_view pool = "shared") noexcept;
 
-    ~ThreadPool() noexcept;
+    ~ThreadPool() noexcept override;
 
     ThreadPool(const ThreadPool&) = delete;
 
@@ -54,10 +144,13 @@ public:
     ThreadPool& operator=(ThreadPool&&) = delete;
 
     //! Run the thread pool.
-    void Start() noexcept;
+    void Start() noexcept override;
 
     //! Push a task into the thread pool.
-    void Push(Task task) noexcept;
+    void Push(Task task) noexcept override;
+
+    //! Push multiple tasks into the thread pool with a single lock.
+    void PushBatch(std::span<Task> tasks) noexcept override;
 
     /**
      * @brief Close the thread pool.
@@ -65,9 +158,17 @@ public:
      * @details
      * The remaining tasks will not be executed.
      */
-    void Close() noexcept;
+    void Close() noexcept override;
+
+    std::size_t QueuedCount() const noexcept override;
 
 private:
+    //! A queued task with the time when it was pushed.
+    struct QueuedTask {
+        Task task;
+        std::chrono::steady_clock::time_point pushed;
+    };
+
     /**
      * @brief Continually pop and execute tasks.
      *
@@ -77,6 +178,9 @@ private:
      */
     void ExecProc() noexcept;
 
+    //! Put a task at the end of the queue, reusing a free node if possible.
+    void Enqueue(Task task) noexcept;
+
     log::Logger::Ptr logger_;
 
     mutable std::mutex mtx_;
@@ -84,8 +188,14 @@ private:
     std::size_t thread_count_;
     std::condition_variable cond_;
 
-    std::list<Task> tasks_;
+    std::list<QueuedTask> tasks_;
+
+    //! Nodes of executed tasks, which are reused by new tasks.
+    std::list<QueuedTask> free_tasks_;
     std::list<std::thread> threads_;
+
+    metrics::Gauge& queued_tasks_;
+    metrics::Histogram& task_latency_;
 };
 
 }  // namespace ws
\ No newline at end of file
@@ -0,0 +1,534 @@
+/**
+ * @file timing_wheel.h
+ * @brief The timer system based on a hierarchical timing wheel.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-10
+ *
+ * @example tests/containers/timing_wheel_test.cpp
+ */
+
+#pragma once
+
+#include "log.h"
+#include "metrics.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace ws {
+
+/**
+ * @brief
+ * The timer system based on a hierarchical timing wheel.
+ *
+ * @details
+ * Time is divided into ticks of a fixed resolution.
+ * The wheel has several levels of slots, and each level covers a range that is @p slot_count times longer than the previous one.
+ * A node is put into a slot by its expiration tick,
+ * and nodes in higher levels are cascaded into lower levels as time goes by.
+ * So pushing, adjusting, removing and expiring a node all take constant time.
+ *
+ * Postponing a node's expiration time only stores the new time.
+ * When its original slot expires, the node is moved to the slot of the new time instead of being timed out.
+ *
+ * Unlike @p HeapTimer, nodes expiring in the same tick are not ordered by expiration time,
+ * and a node may time out up to one tick after its expiration time.
+ *
+ * The number of timers and expirations are recorded in metrics.
+ *
+ * @tparam Key The type of node keys.
+ */
+template <typename Key>
+class TimingWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    using TimeOutCallback = std::function<void(const Key&)>;
+
+    /**
+     * @brief Create a timer system.
+     *
+     * @param logger
+     * A logger. If it is @p nullptr, the timer system will use the global root logger.
+     * @param resolution The duration of a tick.
+     */
+    explicit TimingWheel(
+        log::Logger::Ptr logger = log::RootLogger(),
+        Clock::duration resolution = std::chrono::milliseconds {100}) noexcept;
+
+    ~TimingWheel() noexcept;
+
+    TimingWheel(TimingWheel&&) = delete;
+
+    TimingWheel& operator=(TimingWheel&&) = delete;
+
+    TimingWheel(const TimingWheel&) = delete;
+
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    /**
+     * @brief Adjust a node's expiration time.
+     *
+     * @param key A key.
+     * @param expiration A new duration from now to its expiration time.
+     *
+     * @exception std::out_of_range The timer system does not contain any node with the specific key.
+     */
+    void Adjust(const Key& key, Clock::duration expiration);
+
+    /**
+     * @brief Adjust a node's expiration time.
+     *
+     * @param key A key.
+     * @param expiration A new expiration time.
+     *
+     * @exception std::out_of_range The timer system does not contain any node with the specific key.
+     */
+    void Adjust(const Key& key, Clock::time_point expiration);
+
+    /**
+     * @brief Push a node into the timer system.
+     *
+     * @param key A key.
+     * @param expiration A duration from now to its expiration time.
+     * @param callback A time-out callback that will be invoked when the node expires.
+     */
+    void Push(const Key& key, Clock::duration expiration,
+              TimeOutCallback callback) noexcept;
+
+    /**
+     * @brief Push a node into the timer system.
+     *
+     * @param key A key.
+     * @param expiration An expiration time.
+     * @param callback A time-out callback that will be invoked when the node expires.
+     */
+    void Push(const Key& key, Clock::time_point expiration,
+              TimeOutCallback callback) noexcept;
+
+    /**
+     * @brief Remove expired nodes and invoke their callbacks.
+     *
+     * @warning
+     * Any exceptions raised in callbacks will not be rethrown.
+     * Exception messages will be recorded in the logger.
+     */
+    void Tick() noexcept;
+
+    /**
+     * @brief Remove a node by its key.
+     *
+     * @return Whether the node was removed.
+     */
+    bool Remove(const Key& key) noexcept;
+
+    /**
+     * @brief Remove a node by its key and invoke the callback.
+     *
+     * @exception std::out_of_range The timer system does not contain any node with the specific key.
+     *
+     * @warning
+     * Any exceptions raised in callbacks will not be rethrown.
+     * Exception messages will be recorded in the logger.
+     */
+    void Invoke(const Key& key);
+
+    //! Clear the timer system.
+    void Clear() noexcept;
+
+    //! Whether the timer system contains the node with a specific key.
+    bool Contain(const Key& key) const noexcept;
+
+    //! Whether the timer system is empty.
+    bool Empty() const noexcept;
+
+    //! Get the number of nodes.
+    std::size_t Size() const noexcept;
+
+    /**
+     * @brief
+     * Remove expired nodes and invoke their callbacks.
+     * Then return the interval from now to the next tick that has nodes.
+     * The interval is greater than or equal to zero.
+     *
+     * @details
+     * The next tick may only move nodes between levels or slots, so it can be earlier than the next expiration time.
+     *
+     * @warning
+     * Any exceptions raised in callbacks will not be rethrown.
+     * Exception messages will be recorded in the logger.
+     */
+    Clock::duration ToNextTick() noexcept;
+
+private:
+    //! The number of bits of a slot index.
+    static constexpr std::size_t slot_bits {6};
+
+    //! The number of slots in each level.
+    static constexpr std::size_t slot_count {1 << slot_bits};
+
+    static constexpr std::size_t slot_mask {slot_count - 1};
+
+    //! The number of levels.
+    static constexpr std::size_t level_count {4};
+
+    //! A pseudo level for nodes that are being expired.
+    static constexpr std::size_t expiring_level {level_count};
+
+    using Slot = std::list<Key>;
+
+    struct Node {
+        //! An expiration time.
+        Clock::time_point expiration;
+
+        //! A time-out callback which will be invoked when the node expires.
+        TimeOutCallback callback;
+
+        //! The tick of the slot where the node is.
+        std::uint64_t tick {0};
+
+        std::size_t level {0};
+        std::size_t slot {0};
+
+        //! The position of the node in its slot.
+        typename Slot::iterator pos {};
+    };
+
+    //! Get the number of ticks covered by a slot in a level.
+    static constexpr std::uint64_t TicksPerSlot(const std::size_t level) noexcept {
+        return std::uint64_t {1} << (slot_bits * level);
+    }
+
+    //! Get the first tick not earlier than a time.
+    std::uint64_t CeilTick(Clock::time_point time) const noexcept;
+
+    //! Get the last tick not later than a time.
+    std::uint64_t FloorTick(Clock::time_point time) const noexcept;
+
+    //! Get the slot where a node is.
+    Slot& SlotOf(const Node& node) noexcept;
+
+    //! Put a node that already has a position into the slot by its expiration time.
+    void Place(Node& node) noexcept;
+
+    //! Get the target tick, level and slot for an expiration time.
+    void Locate(Clock::time_point expiration, std::uint64_t& tick,
+                std::size_t& level, std::size_t& slot) const noexcept;
+
+    //! Get the next tick that has nodes to be expired or cascaded.
+    std::optional<std::uint64_t> NextActiveTick() const noexcept;
+
+    //! Cascade nodes from higher levels and expire nodes in a tick.
+    void ProcessTick(std::uint64_t tick, Clock::time_point now) noexcept;
+
+    //! Invoke a callback and record exceptions.
+    void Call(const TimeOutCallback& callback, const Key& key) noexcept;
+
+    log::Logger::Ptr logger_;
+
+    Clock::duration resolution_;
+
+    //! The time of the tick zero.
+    Clock::time_point start_;
+
+    //! The next tick that has not been processed.
+    std::uint64_t curr_tick_ {0};
+
+    std::unordered_map<Key, Node> nodes_;
+    std::array<std::array<Slot, slot_count>, level_count> wheels_;
+
+    //! Nodes taken out of the current slot, which are being expired.
+    Slot expiring_;
+
+    metrics::Gauge& timers_;
+    metrics::Counter& expirations_;
+};
+
+template <typename Key>
+TimingWheel<Key>::TimingWheel(log::Logger::Ptr logger,
+                              const Clock::duration resolution) noexcept :
+    logger_ {std::move(logger)},
+    resolution_ {resolution},
+    start_ {Clock::now()},
+    timers_ {metrics::DefaultRegistry().AddGauge(
+        "ws_timers", "The number of pending timers",
+        {{"type", "timing-wheel"}})},
+    expirations_ {metrics::DefaultRegistry().AddCounter(
+        "ws_timer_expirations_total", "The number of expired timers",
+        {{"type", "timing-wheel"}})} {
+    assert(resolution_ > Clock::duration::zero());
+    if (!logger_) {
+        logger_ = log::RootLogger();
+    }
+}
+
+template <typename Key>
+std::uint64_t TimingWheel<Key>::CeilTick(
+    const Clock::time_point time) const noexcept {
+    if (time <= start_) {
+        return 0;
+    }
+
+    return static_cast<std::uint64_t>((time - start_ + resolution_
+                                       - Clock::duration {1})
+                                      / resolution_);
+}
+
+template <typename Key>
+std::uint64_t TimingWheel<Key>::FloorTick(
+    const Clock::time_point time) const noexcept {
+    return time > start_ ? static_cast<std::uint64_t>((time - start_)
+                                                      / resolution_)
+                         : 0;
+}
+
+template <typename Key>
+typename TimingWheel<Key>::Slot& TimingWheel<Key>::SlotOf(
+    const Node& node) noexcept {
+    return node.level == expiring_level ? expiring_
+                                        : wheels_[node.level][node.slot];
+}
+
+template <typename Key>
+void TimingWheel<Key>::Locate(const Clock::time_point expiration,
+                              std::uint64_t& tick, std::size_t& level,
+                              std::size_t& slot) const noexcept {
+    tick = std::max(CeilTick(expiration), curr_tick_);
+
+    // A node beyond the range of the wheel is put into the farthest slot and moved again when it is reached.
+    const auto max_delta {TicksPerSlot(level_count) - 1};
+    tick = std::min(tick, curr_tick_ + max_delta);
+
+    const auto delta {tick - curr_tick_};
+    level = 0;
+    while (level + 1 < level_count && delta >= TicksPerSlot(level + 1)) {
+        ++level;
+    }
+
+    slot = (tick >> (slot_bits * level)) & slot_mask;
+}
+
+template <typename Key>
+void TimingWheel<Key>::Place(Node& node) noexcept {
+    auto& from {SlotOf(node)};
+    Locate(node.expiration, node.tick, node.level, node.slot);
+    auto& to {SlotOf(node)};
+    to.splice(to.cend(), from, node.pos);
+}
+
+template <typename Key>
+TimingWheel<Key>::~TimingWheel() noexcept {
+    Clear();
+}
+
+template <typename Key>
+void TimingWheel<Key>::Clear() noexcept {
+    timers_.Decrease(static_cast<std::int64_t>(nodes_.size()));
+    nodes_.clear();
+    for (auto& level : wheels_) {
+        for (auto& slot : level) {
+            slot.clear();
+        }
+    }
+
+    expiring_.clear();
+}
+
+template <typename Key>
+bool TimingWheel<Key>::Remove(const Key& key) noexcept {
+    if (const auto it {nodes_.find(key)}; it != nodes_.cend()) {
+        SlotOf(it->second).erase(it->second.pos);
+        nodes_.erase(it);
+        timers_.Decrease();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template <typename Key>
+bool TimingWheel<Key>::Contain(const Key& key) const noexcept {
+    return nodes_.contains(key);
+}
+
+template <typename Key>
+bool TimingWheel<Key>::Empty() const noexcept {
+    return nodes_.empty();
+}
+
+template <typename Key>
+std::size_t TimingWheel<Key>::Size() const noexcept {
+    return nodes_.size();
+}
+
+template <typename Key>
+void TimingWheel<Key>::Adjust(const Key& key,
+                              const Clock::duration expiration) {
+    Adjust(key, Clock::now() + expiration);
+}
+
+template <typename Key>
+void TimingWheel<Key>::Adjust(const Key& key,
+                              const Clock::time_point expiration) {
+    auto& node {nodes_.at(key)};
+    node.expiration = expiration;
+
+    // A postponed node stays in its slot and will be moved when the slot expires.
+    if (node.level != expiring_level && CeilTick(expiration) < node.tick) {
+        Place(node);
+    }
+}
+
+template <typename Key>
+void TimingWheel<Key>::Push(const Key& key, const Clock::duration expiration,
+                            TimeOutCallback callback) noexcept {
+    Push(key, Clock::now() + expiration, std::move(callback));
+}
+
+template <typename Key>
+void TimingWheel<Key>::Push(const Key& key, const Clock::time_point expiration,
+                            TimeOutCallback callback) noexcept {
+    if (const auto it {nodes_.find(key)}; it != nodes_.cend()) {
+        it->second.callback = std::move(callback);
+        Adjust(key, expiration);
+        return;
+    }
+
+    Node node {.expiration = expiration, .callback = std::move(callback)};
+    Locate(expiration, node.tick, node.level, node.slot);
+    auto& slot {SlotOf(node)};
+    node.pos = slot.insert(slot.cend(), key);
+    nodes_.emplace(key, std::move(node));
+    timers_.Increase();
+}
+
+template <typename Key>
+void TimingWheel<Key>::Call(const TimeOutCallback& callback,
+                            const Key& key) noexcept {
+    try {
+        assert(callback);
+        callback(key);
+    } catch (const std::exception& err) {
+        logger_->Log(log::Event::Create(log::Level::Error)
+                     << fmt::format("Exception raised in timer's callback: {}",
+                                    err.what()));
+    }
+}
+
+template <typename Key>
+void TimingWheel<Key>::Invoke(const Key& key) {
+    const auto callback {std::move(nodes_.at(key).callback)};
+    Remove(key);
+    Call(callback, key);
+}
+
+template <typename Key>
+std::optional<std::uint64_t> TimingWheel<Key>::NextActiveTick() const noexcept {
+    std::optional<std::uint64_t> next;
+    for (std::size_t level {0}; level != level_count; ++level) {
+        const auto span {TicksPerSlot(level)};
+
+        // The first slot boundary in this level that has not been processed.
+        const auto first {(curr_tick_ + span - 1) / span};
+        for (std::size_t i {0}; i != slot_count; ++i) {
+            if (!wheels_[level][(first + i) & slot_mask].empty()) {
+                const auto tick {(first + i) * span};
+                next = std::min(next.value_or(tick), tick);
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+template <typename Key>
+void TimingWheel<Key>::ProcessTick(const std::uint64_t tick,
+                                   const Clock::time_point now) noexcept {
+    assert(tick >= curr_tick_);
+    curr_tick_ = tick;
+
+    // Cascade nodes from higher levels into lower levels.
+    for (auto level {level_count - 1}; level != 0; --level) {
+        if (tick % TicksPerSlot(level) == 0) {
+            auto& slot {wheels_[level][(tick >> (slot_bits * level))
+                                       & slot_mask]};
+            while (!slot.empty()) {
+                auto& node {nodes_.at(slot.front())};
+                Place(node);
+                assert(&SlotOf(node) != &slot);
+            }
+        }
+    }
+
+    // Take out nodes in the current slot, so moving them cannot put them back into it.
+    auto& slot {wheels_[0][tick & slot_mask]};
+    for (const auto& key : slot) {
+        nodes_.at(key).level = expiring_level;
+    }
+
+    expiring_.splice(expiring_.cend(), slot);
+    curr_tick_ = tick + 1;
+
+    while (!expiring_.empty()) {
+        const auto key {expiring_.front()};
+        if (auto& node {nodes_.at(key)}; node.expiration <= now) {
+            const auto callback {std::move(node.callback)};
+            expiring_.pop_front();
+            nodes_.erase(key);
+            timers_.Decrease();
+            expirations_.Increase();
+            Call(callback, key);
+        } else {
+            // The node has been postponed.
+            Place(node);
+        }
+    }
+}
+
+template <typename Key>
+void TimingWheel<Key>::Tick() noexcept {
+    const auto now {Clock::now()};
+    const auto last {FloorTick(now)};
+    while (curr_tick_ <= last) {
+        const auto next {NextActiveTick()};
+        if (!next.has_value() || next.value() > last) {
+            // Skip ticks without nodes.
+            curr_tick_ = last + 1;
+            break;
+        }
+
+        ProcessTick(next.value(), now);
+    }
+}
+
+template <typename Key>
+typename TimingWheel<Key>::Clock::duration
+TimingWheel<Key>::ToNextTick() noexcept {
+    Tick();
+    if (const auto next {NextActiveTick()}; next.has_value()) {
+        const auto interval {start_ + next.value() * resolution_
+                             - Clock::now()};
+        if (interval > Clock::duration::zero()) {
+            return interval;
+        }
+    }
+
+    return Clock::duration::zero();
+}
+
+}  // namespace ws
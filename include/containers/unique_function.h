@@ -0,0 +1,148 @@
+/**
+ * @file unique_function.h
+ * @brief The move-only callable wrapper with inline storage.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-08
+ *
+ * @example tests/containers/unique_function_test.cpp
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace ws {
+
+template <typename Signature, std::size_t Capacity = 64>
+class UniqueFunction;
+
+/**
+ * @brief The move-only callable wrapper with inline storage.
+ *
+ * @details
+ * Unlike @p std::function, a callable is always stored inside the object and never allocates memory.
+ * A callable larger than @p Capacity is rejected at compile time.
+ *
+ * @tparam Capacity The maximum size of a callable.
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class UniqueFunction<R(Args...), Capacity> {
+public:
+    UniqueFunction() noexcept = default;
+
+    UniqueFunction(std::nullptr_t) noexcept {}
+
+    //! Wrap a callable.
+    template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, UniqueFunction>)
+        && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+    UniqueFunction(F&& func) noexcept(
+        std::is_nothrow_constructible_v<std::decay_t<F>, F>) {
+        using Functor = std::decay_t<F>;
+        static_assert(sizeof(Functor) <= Capacity,
+                      "The callable is too large for the inline storage");
+        static_assert(alignof(Functor) <= alignof(std::max_align_t),
+                      "The callable is over-aligned for the inline storage");
+        static_assert(std::is_nothrow_move_constructible_v<Functor>,
+                      "The callable must be nothrow move constructible");
+
+        ::new (static_cast<void*>(storage_)) Functor(std::forward<F>(func));
+        ops_ = &operations<Functor>;
+    }
+
+    UniqueFunction(UniqueFunction&& o) noexcept {
+        MoveFrom(o);
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& o) noexcept {
+        if (this != &o) {
+            Reset();
+            MoveFrom(o);
+        }
+
+        return *this;
+    }
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept {
+        Reset();
+        return *this;
+    }
+
+    UniqueFunction(const UniqueFunction&) = delete;
+
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    ~UniqueFunction() noexcept {
+        Reset();
+    }
+
+    //! Whether there is a callable.
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    /**
+     * @brief Invoke the callable.
+     *
+     * @warning This method can only be called when there is a callable.
+     */
+    R operator()(Args... args) {
+        assert(ops_);
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    //! Destroy the callable.
+    void Reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    //! Type-erased operations of a callable.
+    struct Operations {
+        R (*invoke)(void* func, Args&&... args);
+        void (*move)(void* dest, void* src) noexcept;
+        void (*destroy)(void* func) noexcept;
+    };
+
+    template <typename Functor>
+    static constexpr Operations operations {
+        .invoke = [](void* const func, Args&&... args) -> R {
+            return std::invoke(*static_cast<Functor*>(func),
+                               std::forward<Args>(args)...);
+        },
+        .move =
+            [](void* const dest, void* const src) noexcept {
+                ::new (dest) Functor(std::move(*static_cast<Functor*>(src)));
+                static_cast<Functor*>(src)->~Functor();
+            },
+        .destroy =
+            [](void* const func) noexcept {
+                static_cast<Functor*>(func)->~Functor();
+            }};
+
+    void MoveFrom(UniqueFunction& o) noexcept {
+        if (o.ops_) {
+            o.ops_->move(storage_, o.storage_);
+            ops_ = std::exchange(o.ops_, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) std::byte storage_[Capacity];
+    const Operations* ops_ {nullptr};
+};
+
+}  // namespace ws
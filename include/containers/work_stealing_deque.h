@@ -0,0 +1,204 @@
+/**
+ * @file work_stealing_deque.h
+ * @brief The lock-free work-stealing double-ended queue.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-06
+ *
+ * @example tests/containers/work_stealing_deque_test.cpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+
+namespace ws {
+
+/**
+ * @brief The bounded Chase-Lev work-stealing double-ended queue.
+ *
+ * @details
+ * The owner thread pushes and pops elements at the bottom in LIFO order,
+ * while other threads steal elements from the top in FIFO order.
+ * None of the operations takes a lock.
+ *
+ * Elements are read and written atomically, so they must be trivially copyable, such as pointers.
+ *
+ * @warning @p Push and @p Pop can only be called by the owner thread.
+ */
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+class WorkStealingDeque {
+public:
+    /**
+     * @brief Create a work-stealing double-ended queue.
+     *
+     * @param capacity The maximum capacity, which will be rounded up to a power of two.
+     */
+    explicit WorkStealingDeque(std::size_t capacity = 0x400) noexcept;
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+    /**
+     * @brief Push an element to the bottom.
+     *
+     * @return @p false if the queue is full, otherwise @p true.
+     */
+    bool Push(T item) noexcept;
+
+    /**
+     * @brief Pop an element from the bottom.
+     *
+     * @return The last element, or @p std::nullopt if the queue is empty or it has been stolen.
+     */
+    std::optional<T> Pop() noexcept;
+
+    /**
+     * @brief Steal an element from the top.
+     *
+     * @details It can be called by any thread.
+     *
+     * @return The first element, or @p std::nullopt if the queue is empty or another thread won the race.
+     */
+    std::optional<T> Steal() noexcept;
+
+    //! Get the approximate number of elements.
+    std::size_t Size() const noexcept;
+
+    //! Whether the queue is approximately empty.
+    bool Empty() const noexcept;
+
+    //! Get the maximum capacity.
+    std::size_t Capacity() const noexcept;
+
+private:
+    //! The cache line size, used to avoid false sharing between the two ends.
+    static constexpr std::size_t cache_line_size {64};
+
+    std::atomic<T>& Slot(std::int64_t index) const noexcept;
+
+    std::size_t capacity_;
+    std::unique_ptr<std::atomic<T>[]> slots_;
+
+    //! The index where the next element is stolen.
+    alignas(cache_line_size) std::atomic<std::int64_t> top_ {0};
+
+    //! The index where the next element is pushed.
+    alignas(cache_line_size) std::atomic<std::int64_t> bottom_ {0};
+};
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+WorkStealingDeque<T>::WorkStealingDeque(const std::size_t capacity) noexcept :
+    capacity_ {std::bit_ceil(capacity)},
+    slots_ {std::make_unique<std::atomic<T>[]>(capacity_)} {
+    assert(capacity > 0);
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+std::atomic<T>& WorkStealingDeque<T>::Slot(
+    const std::int64_t index) const noexcept {
+    return slots_[static_cast<std::size_t>(index) & (capacity_ - 1)];
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+bool WorkStealingDeque<T>::Push(const T item) noexcept {
+    const auto bottom {bottom_.load(std::memory_order_relaxed)};
+    const auto top {top_.load(std::memory_order_acquire)};
+    if (static_cast<std::size_t>(bottom - top) >= capacity_) {
+        return false;
+    }
+
+    Slot(bottom).store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+std::optional<T> WorkStealingDeque<T>::Pop() noexcept {
+    const auto bottom {bottom_.load(std::memory_order_relaxed) - 1};
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top {top_.load(std::memory_order_relaxed)};
+    if (top > bottom) {
+        // The queue is empty.
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    std::optional<T> item {Slot(bottom).load(std::memory_order_relaxed)};
+    if (top == bottom) {
+        // This is the last element, race against thieves for it.
+        if (!top_.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            item.reset();
+        }
+
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return item;
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+std::optional<T> WorkStealingDeque<T>::Steal() noexcept {
+    auto top {top_.load(std::memory_order_acquire)};
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto bottom {bottom_.load(std::memory_order_acquire)};
+    if (top >= bottom) {
+        return std::nullopt;
+    }
+
+    const auto item {Slot(top).load(std::memory_order_relaxed)};
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+        return std::nullopt;
+    }
+
+    return item;
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+std::size_t WorkStealingDeque<T>::Size() const noexcept {
+    const auto bottom {bottom_.load(std::memory_order_relaxed)};
+    const auto top {top_.load(std::memory_order_relaxed)};
+    return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+bool WorkStealingDeque<T>::Empty() const noexcept {
+    return Size() == 0;
+}
+
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+std::size_t WorkStealingDeque<T>::Capacity() const noexcept {
+    return capacity_;
+}
+
+}  // namespace ws
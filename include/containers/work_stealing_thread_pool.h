@@ -0,0 +1,188 @@
+/**
+ * @file work_stealing_thread_pool.h
+ * @brief The work-stealing thread pool.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-06
+ *
+ * @example tests/containers/thread_pool_test.cpp
+ */
+
+#pragma once
+
+#include "containers/mpmc_queue.h"
+#include "containers/thread_pool.h"
+#include "containers/work_stealing_deque.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+namespace ws {
+
+/**
+ * @brief The work-stealing thread pool.
+ *
+ * @details
+ * Each working thread has its own lock-free deque.
+ * Tasks pushed by a working thread go into its own deque,
+ * and tasks pushed by other threads, such as a reactor, go into a shared lock-free injection queue.
+ * An idle working thread takes tasks from its own deque first, then the injection queue,
+ * and finally steals tasks from other working threads.
+ *
+ * A working thread without tasks spins for a short time before parking,
+ * so bursts of tasks do not pay for waking threads up.
+ *
+ * Executed task objects are recycled through a lock-free free list,
+ * so pushing a task does not allocate memory in the steady state.
+ */
+class WorkStealingThreadPool : public Executor {
+public:
+    /**
+     * @brief Create a work-stealing thread pool.
+     *
+     * @param thread_count
+     * The number of working threads.
+     * If it is @p std::nullopt or zero, the thread pool will use the number of concurrent threads supported by hardware.
+     * @param logger
+     * A logger. If it is @p nullptr, the thread pool will use the global root logger.
+     * @param queue_capacity The capacity of each working thread's deque and the injection queue.
+     */
+    explicit WorkStealingThreadPool(
+        std::optional<std::size_t> thread_count = std::nullopt,
+        log::Logger::Ptr logger = log::RootLogger(),
+        std::size_t queue_capacity = 0x1000) noexcept;
+
+    ~WorkStealingThreadPool() noexcept override;
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+
+    WorkStealingThreadPool(WorkStealingThreadPool&&) = delete;
+
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    WorkStealingThreadPool& operator=(WorkStealingThreadPool&&) = delete;
+
+    //! Run the thread pool.
+    void Start() noexcept override;
+
+    /**
+     * @brief Push a task into the thread pool.
+     *
+     * @details
+     * If the injection queue is full, the caller yields until there is space.
+     */
+    void Push(Task task) noexcept override;
+
+    /**
+     * @brief Push multiple tasks into the thread pool.
+     *
+     * @details Parked working threads are woken up once for the whole batch.
+     */
+    void PushBatch(std::span<Task> tasks) noexcept override;
+
+    /**
+     * @brief Close the thread pool.
+     *
+     * @details
+     * The remaining tasks will not be executed.
+     */
+    void Close() noexcept override;
+
+    std::size_t QueuedCount() const noexcept override;
+
+private:
+    //! A queued task with the time when it was pushed.
+    struct QueuedTask {
+        Task task;
+        std::chrono::steady_clock::time_point pushed;
+    };
+
+    struct Worker {
+        explicit Worker(std::size_t capacity) noexcept;
+
+        WorkStealingDeque<QueuedTask*> tasks;
+        std::thread thread;
+    };
+
+    //! The number of attempts to find a task before a working thread parks.
+    static constexpr std::size_t spin_count {64};
+
+    //! Continually find and execute tasks in a working thread.
+    void ExecProc(std::size_t index) noexcept;
+
+    /**
+     * @brief Find a task for a working thread.
+     *
+     * @return A task, or @p nullptr if there are no tasks.
+     */
+    QueuedTask* FindTask(std::size_t index) noexcept;
+
+    //! Steal a task from other working threads.
+    QueuedTask* Steal(std::size_t index) noexcept;
+
+    /**
+     * @brief Block a working thread until a task is pushed or the thread pool is closed.
+     *
+     * @return A task that has been found before blocking, or @p nullptr.
+     */
+    QueuedTask* Park(std::size_t index) noexcept;
+
+    /**
+     * @brief Put a task into the current working thread's deque or the injection queue.
+     *
+     * @return Whether the task has been queued. It fails only if the thread pool is closed.
+     */
+    bool Enqueue(Task task) noexcept;
+
+    //! Wake up parked working threads if there are any.
+    void Notify(std::size_t count = 1) noexcept;
+
+    //! Get a task object from the free list, or allocate a new one.
+    QueuedTask* Allocate(Task task) noexcept;
+
+    //! Return a task object to the free list, or release it if the list is full.
+    void Recycle(QueuedTask* task) noexcept;
+
+    //! Execute and recycle a task.
+    void Run(QueuedTask* task) noexcept;
+
+    //! Release all remaining and free tasks.
+    void Clear() noexcept;
+
+    log::Logger::Ptr logger_;
+
+    std::atomic_bool closed_ {true};
+    std::size_t thread_count_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    MPMCQueue<QueuedTask*> injection_;
+
+    //! Task objects that have been executed and can be reused.
+    MPMCQueue<QueuedTask*> free_tasks_;
+
+    //! The number of parked working threads.
+    std::atomic<std::size_t> parked_count_ {0};
+
+    //! Bumped to wake parked working threads up.
+    std::atomic<std::uint32_t> epoch_ {0};
+
+    //! The number of tasks in all deques and the injection queue.
+    std::atomic<std::size_t> queued_count_ {0};
+
+    metrics::Gauge& queued_tasks_;
+    metrics::Histogram& task_latency_;
+};
+
+}  // namespace ws
@@ -0,0 +1,458 @@
+/**
+ * @file coroutine.h
+ * @brief Coroutine tasks, their pooled frames and awaitable socket readiness.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-31
+ *
+ * @example tests/coroutine_test.cpp
+ */
+
+#pragma once
+
+#include <sys/epoll.h>
+
+#include <array>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <optional>
+#include <utility>
+
+
+namespace ws::coro {
+
+/**
+ * @brief The allocator of coroutine frames.
+ *
+ * @details
+ * Each thread keeps freed frames in lists by their rounded sizes,
+ * and a new frame of the same size class reuses one without calling the global allocator.
+ * A connection's coroutine and the tasks it awaits have a few fixed sizes,
+ * so after warming up, serving a client allocates no frame from the heap.
+ *
+ * A frame can be freed in any thread, which keeps it for its own allocations.
+ * Frames larger than @p max_pooled_size and frames beyond the capacity of a list are returned to the global allocator.
+ */
+class FramePool {
+public:
+    //! The granularity of size classes.
+    static constexpr std::size_t granularity {0x40};
+
+    //! The maximum size of a pooled frame.
+    static constexpr std::size_t max_pooled_size {0x800};
+
+    //! The maximum number of frames kept in each list of a thread.
+    static constexpr std::size_t max_free_count {0x100};
+
+    //! Allocate a frame.
+    static void* Allocate(const std::size_t size) {
+        if (size > max_pooled_size) {
+            return ::operator new(size);
+        }
+
+        auto& cache {LocalCache()};
+        const auto idx {SizeClass(size)};
+        if (auto frame {cache.frames[idx]}; frame) {
+            cache.frames[idx] = frame->next;
+            --cache.counts[idx];
+            ++cache.hit_count;
+            return frame;
+        }
+
+        ++cache.miss_count;
+        return ::operator new((idx + 1) * granularity);
+    }
+
+    /**
+     * @brief Free a frame.
+     *
+     * @param size The size used to allocate the frame.
+     */
+    static void Deallocate(void* const frame, const std::size_t size) noexcept {
+        if (size > max_pooled_size) {
+            ::operator delete(frame);
+            return;
+        }
+
+        auto& cache {LocalCache()};
+        const auto idx {SizeClass(size)};
+        if (cache.counts[idx] == max_free_count) {
+            ::operator delete(frame);
+            return;
+        }
+
+        cache.frames[idx] = ::new (frame) FreeFrame {cache.frames[idx]};
+        ++cache.counts[idx];
+    }
+
+    //! Get the number of allocations in the current thread that reused a freed frame.
+    static std::size_t HitCount() noexcept {
+        return LocalCache().hit_count;
+    }
+
+    //! Get the number of pooled allocations in the current thread that called the global allocator.
+    static std::size_t MissCount() noexcept {
+        return LocalCache().miss_count;
+    }
+
+private:
+    static constexpr std::size_t class_count {max_pooled_size / granularity};
+
+    //! A freed frame linked into a list.
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+
+    static_assert(sizeof(FreeFrame) <= granularity);
+
+    struct Cache {
+        Cache() noexcept = default;
+
+        ~Cache() noexcept {
+            for (auto frame : frames) {
+                while (frame) {
+                    ::operator delete(std::exchange(frame, frame->next));
+                }
+            }
+        }
+
+        Cache(const Cache&) = delete;
+
+        Cache& operator=(const Cache&) = delete;
+
+        std::array<FreeFrame*, class_count> frames {};
+        std::array<std::size_t, class_count> counts {};
+        std::size_t hit_count {0};
+        std::size_t miss_count {0};
+    };
+
+    static constexpr std::size_t SizeClass(const std::size_t size) noexcept {
+        assert(size <= max_pooled_size);
+        return size == 0 ? 0 : (size - 1) / granularity;
+    }
+
+    static Cache& LocalCache() noexcept {
+        thread_local Cache cache;
+        return cache;
+    }
+};
+
+namespace detail {
+
+//! The part of a task's promise independent of its result.
+class PromiseBase {
+public:
+    static void* operator new(const std::size_t size) {
+        return FramePool::Allocate(size);
+    }
+
+    static void operator delete(void* const frame,
+                                const std::size_t size) noexcept {
+        FramePool::Deallocate(frame, size);
+    }
+
+    //! A task does not start until it is awaited or started.
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    //! A finished task transfers control to its awaiting coroutine.
+    auto final_suspend() const noexcept {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<>) const noexcept {
+                // Resuming the awaiting coroutine by returning its handle does not grow the stack.
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+
+            std::coroutine_handle<> continuation;
+        };
+
+        return FinalAwaiter {continuation_};
+    }
+
+    void unhandled_exception() noexcept {
+        exception_ = std::current_exception();
+    }
+
+    void SetContinuation(const std::coroutine_handle<> continuation) noexcept {
+        continuation_ = continuation;
+    }
+
+protected:
+    void RethrowIfFailed() const {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+public:
+    template <typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T Result() {
+        RethrowIfFailed();
+        assert(value_.has_value());
+        return std::move(value_).value();
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+public:
+    void return_void() const noexcept {}
+
+    void Result() const {
+        RethrowIfFailed();
+    }
+};
+
+}  // namespace detail
+
+/**
+ * @brief A lazily started coroutine returning a result.
+ *
+ * @details
+ * A task owns its coroutine frame, which is allocated from @p FramePool.
+ * It starts when it is awaited by another coroutine or started by @p Start.
+ * When it finishes, the awaiting coroutine is resumed in the same thread by symmetric transfer.
+ * An exception escaping the coroutine is rethrown to the awaiting coroutine.
+ *
+ * @code {.cpp}
+ * Task<int> Read();
+ *
+ * Task<> Serve() {
+ *     const auto size {co_await Read()};
+ * }
+ * @endcode
+ */
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    class promise_type : public detail::Promise<T> {
+    public:
+        Task get_return_object() noexcept {
+            return Task {Handle::from_promise(*this)};
+        }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() noexcept = default;
+
+    Task(Task&& o) noexcept : handle_ {std::exchange(o.handle_, nullptr)} {}
+
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) {
+            Destroy();
+            handle_ = std::exchange(o.handle_, nullptr);
+        }
+
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+
+    Task& operator=(const Task&) = delete;
+
+    //! Destroy the coroutine, even if it is suspended.
+    ~Task() noexcept {
+        Destroy();
+    }
+
+    //! Whether the task has a coroutine.
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(handle_);
+    }
+
+    //! Whether the coroutine has finished.
+    bool Done() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    /**
+     * @brief Start a task that is not awaited by another coroutine.
+     *
+     * @details It runs in the current thread until its first suspension.
+     */
+    void Start() {
+        assert(handle_ && !handle_.done());
+        handle_.resume();
+    }
+
+    /**
+     * @brief Get the result of a finished task.
+     *
+     * @exception Any An exception escaping the coroutine.
+     */
+    T Result() {
+        assert(handle_ && handle_.done());
+        return handle_.promise().Result();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            bool await_ready() const noexcept {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(
+                const std::coroutine_handle<> awaiting) const noexcept {
+                handle.promise().SetContinuation(awaiting);
+                return handle;
+            }
+
+            T await_resume() const {
+                assert(handle);
+                return handle.promise().Result();
+            }
+
+            Handle handle;
+        };
+
+        return Awaiter {handle_};
+    }
+
+private:
+    explicit Task(const Handle handle) noexcept : handle_ {handle} {}
+
+    void Destroy() noexcept {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    Handle handle_;
+};
+
+/**
+ * @brief The readiness of an edge-triggered socket, which a coroutine can wait for.
+ *
+ * @details
+ * Readiness is set by events from a poller and cleared by the coroutine after an operation would block.
+ * Waiting for a ready socket does not suspend.
+ * Otherwise, the coroutine is suspended until an event makes the socket ready,
+ * and the poller's owner resumes the handle returned by @p Notify.
+ *
+ * @code {.cpp}
+ * Task<> Serve(SocketReadiness& socket) {
+ *     co_await socket.Readable();
+ *     if (Receive() == would_block) {
+ *         socket.ClearReadable();
+ *     }
+ * }
+ * @endcode
+ *
+ * @warning At most one coroutine can wait for a socket at a time.
+ */
+class SocketReadiness {
+public:
+    //! Wait until the socket is readable.
+    auto Readable() noexcept {
+        return Awaiter {*this, EPOLLIN};
+    }
+
+    //! Wait until the socket is writable.
+    auto Writable() noexcept {
+        return Awaiter {*this, EPOLLOUT};
+    }
+
+    //! Mark the socket as not readable, as a read would block.
+    void ClearReadable() noexcept {
+        ready_ &= ~static_cast<std::uint32_t>(EPOLLIN);
+    }
+
+    //! Mark the socket as not writable, as a write would block.
+    void ClearWritable() noexcept {
+        ready_ &= ~static_cast<std::uint32_t>(EPOLLOUT);
+    }
+
+    /**
+     * @brief Update the readiness with events from a poller.
+     *
+     * @return
+     * The handle of the waiting coroutine if the socket becomes ready for it, otherwise @p nullptr.
+     * The caller should resume it.
+     */
+    std::coroutine_handle<> Notify(const std::uint32_t events) noexcept {
+        ready_ |= events & (EPOLLIN | EPOLLOUT);
+        if (waiter_ && (ready_ & waiting_)) {
+            waiting_ = 0;
+            return std::exchange(waiter_, nullptr);
+        } else {
+            return nullptr;
+        }
+    }
+
+    //! Whether a coroutine is waiting for the socket.
+    bool Waiting() const noexcept {
+        return static_cast<bool>(waiter_);
+    }
+
+    //! Clear the readiness and the waiting coroutine for a new socket.
+    void Reset() noexcept {
+        ready_ = 0;
+        waiting_ = 0;
+        waiter_ = nullptr;
+    }
+
+private:
+    class Awaiter {
+    public:
+        Awaiter(SocketReadiness& socket, const std::uint32_t event) noexcept :
+            socket_ {socket}, event_ {event} {}
+
+        bool await_ready() const noexcept {
+            return socket_.ready_ & event_;
+        }
+
+        void await_suspend(const std::coroutine_handle<> waiter) noexcept {
+            assert(!socket_.waiter_);
+            socket_.waiter_ = waiter;
+            socket_.waiting_ = event_;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        SocketReadiness& socket_;
+        std::uint32_t event_;
+    };
+
+    //! Ready events, which are @p EPOLLIN and @p EPOLLOUT.
+    std::uint32_t ready_ {0};
+
+    //! The event the waiting coroutine is waiting for.
+    std::uint32_t waiting_ {0};
+
+    std::coroutine_handle<> waiter_;
+};
+
+}  // namespace ws::coro
@@ -13,31 +13,60 @@
 #pragma once
 
 #include "containers/buffer.h"
+#include "containers/chunked_buffer.h"
+#include "io.h"
 #include "ip.h"
+#include "trace.h"
 #include "util.h"
 
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <queue>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 
 namespace ws::http {
 
+struct Asset;
+class AssetCache;
+class AssetPack;
+class Http2Session;
+class ProxyExchange;
+class Request;
+class TLSContext;
+class TLSSession;
+
 //! HTTP version: 1.1
 inline constexpr std::string_view version {"1.1"};
 
 //! HTTP parameters consisting of key-value pairs.
-using Parameters = std::unordered_map<std::string, std::string>;
+using Parameters =
+    std::unordered_map<std::string, std::string, StringHash, std::equal_to<>>;
 
 //! HTTP status codes.
 enum class StatusCode : std::uint32_t {
     OK = 200,
+    PartialContent = 206,
+    NotModified = 304,
     BadRequest = 400,
     Forbidden = 403,
-    NotFound = 404
+    NotFound = 404,
+    PayloadTooLarge = 413,
+    RangeNotSatisfiable = 416,
+    RequestHeaderFieldsTooLarge = 431,
+    BadGateway = 502,
+    ServiceUnavailable = 503
 };
 
 //! Convert an HTTP status code into a message.
@@ -48,6 +77,30 @@ std::uint32_t StatusCodeToInteger(StatusCode code) noexcept;
 
 std::ostream& operator<<(std::ostream& os, StatusCode code) noexcept;
 
+//! An error that occurred when parsing a request, which is answered with its status code.
+struct RequestError {
+    StatusCode status {StatusCode::BadRequest};
+    std::string msg;
+};
+
+/**
+ * @brief Limits on the size of a request.
+ *
+ * @details
+ * A request is rejected as soon as it exceeds a limit, before the rest of it is received.
+ * Zero disables a limit.
+ */
+struct RequestLimits {
+    //! The maximum size of the request line and headers, above which the request is rejected with @p 431 Request Header Fields Too Large.
+    std::size_t max_header_size {0x10000};
+
+    //! The maximum number of headers, above which the request is rejected with @p 431 Request Header Fields Too Large.
+    std::size_t max_header_count {100};
+
+    //! The maximum size of the body, above which the request is rejected with @p 413 Payload Too Large.
+    std::size_t max_body_size {0x100000};
+};
+
 //! HTTP methods.
 enum class Method { Get, Post, Put, Patch, Delete };
 
@@ -61,10 +114,236 @@ std::string to_string(Method method) noexcept;
  *
  * @exception std::invalid_argument The string does not represent an HTTP method.
  */
-Method StringToMethod(std::string str);
+Method StringToMethod(std::string_view str);
 
 std::ostream& operator<<(std::ostream& os, Method method) noexcept;
 
+//! HTTP content encodings.
+enum class ContentEncoding : std::uint8_t {
+    //! No compression.
+    Identity = 0,
+    Gzip = 1 << 0,
+    //! Brotli, which usually compresses text better than gzip.
+    Brotli = 1 << 1
+};
+
+/**
+ * @brief Convert an HTTP content encoding into a token used by @p Content-Encoding.
+ *
+ * @return @p identity, @p gzip or @p br.
+ */
+std::string_view ContentEncodingToString(ContentEncoding encoding) noexcept;
+
+/**
+ * @brief Get the file extension of a precompressed file.
+ *
+ * @return @p .gz, @p .br, or an empty string for @p ContentEncoding::Identity.
+ */
+std::string_view ContentEncodingToExtension(ContentEncoding encoding) noexcept;
+
+std::ostream& operator<<(std::ostream& os, ContentEncoding encoding) noexcept;
+
+//! A set of HTTP content encodings accepted by a client.
+class ContentEncodings {
+public:
+    //! Encodings in the order of the server's preference.
+    static constexpr std::array<ContentEncoding, 2> preferences {
+        ContentEncoding::Brotli, ContentEncoding::Gzip};
+
+    constexpr ContentEncodings() noexcept = default;
+
+    //! Add an encoding to the set.
+    constexpr ContentEncodings& Add(const ContentEncoding encoding) noexcept {
+        bits_ |= static_cast<std::uint8_t>(encoding);
+        return *this;
+    }
+
+    /**
+     * @brief Whether the set contains an encoding.
+     *
+     * @note @p ContentEncoding::Identity is always acceptable.
+     */
+    constexpr bool Contains(const ContentEncoding encoding) const noexcept {
+        return encoding == ContentEncoding::Identity
+               || (bits_ & static_cast<std::uint8_t>(encoding)) != 0;
+    }
+
+    //! Whether the set only contains @p ContentEncoding::Identity.
+    constexpr bool Empty() const noexcept {
+        return bits_ == 0;
+    }
+
+    constexpr bool operator==(const ContentEncodings&) const noexcept = default;
+
+private:
+    std::uint8_t bits_ {0};
+};
+
+/**
+ * @brief Parse the value of an HTTP @p Accept-Encoding header.
+ *
+ * @details
+ * Encodings are case-insensitive and @p * stands for all supported encodings.
+ * An encoding whose quality value is zero is not acceptable.
+ * Other quality values do not change the server's preference.
+ * Unsupported encodings are ignored.
+ */
+ContentEncodings ParseAcceptEncoding(std::string_view value) noexcept;
+
+/**
+ * @brief Whether content of a type is worth being compressed.
+ *
+ * @details Text is compressible, while most images, audio and video have been compressed.
+ */
+bool IsCompressibleContentType(std::string_view type) noexcept;
+
+/**
+ * @brief Make a strong entity tag for a representation of a file.
+ *
+ * @details
+ * It is derived from the file's inode number, size and modification time.
+ * Encoded representations of the same file have different tags, since their bytes are different.
+ *
+ * @return A quoted entity tag, such as @p "2a3b-1f4-16f3e2d4c1b0a708-gzip".
+ */
+std::string MakeEntityTag(
+    std::uint64_t inode, std::size_t size,
+    std::chrono::system_clock::time_point modification_time,
+    ContentEncoding encoding = ContentEncoding::Identity) noexcept;
+
+//! Format a time as an HTTP date, such as @p Sun, 06 Nov 1994 08:49:37 GMT.
+std::string FormatHTTPDate(std::chrono::system_clock::time_point time) noexcept;
+
+/**
+ * @brief Parse an HTTP date.
+ *
+ * @details The preferred format and the obsolete RFC 850 and ANSI C formats are supported.
+ *
+ * @return The time, or @p std::nullopt if the date is invalid.
+ */
+std::optional<std::chrono::system_clock::time_point> ParseHTTPDate(
+    std::string_view date) noexcept;
+
+//! The validators of a representation for conditional requests.
+struct Validators {
+    //! A strong entity tag.
+    std::string etag;
+
+    std::chrono::system_clock::time_point last_modified;
+};
+
+//! The preconditions of an HTTP conditional @p GET request.
+struct Preconditions {
+    //! Whether there are no preconditions.
+    bool Empty() const noexcept;
+
+    /**
+     * @brief Whether a representation has not been modified, so @p 304 Not Modified can be sent.
+     *
+     * @details
+     * Entity tags are compared weakly.
+     * @p If-Modified-Since is ignored if @p If-None-Match exists.
+     */
+    bool NotModified(const Validators& validators) const noexcept;
+
+    /**
+     * @brief Whether the byte ranges of a request can be sent for a representation.
+     *
+     * @details
+     * If @p If-Range does not exist, or its entity tag or date matches the representation, ranges are sent.
+     * Otherwise the whole representation should be sent, since the client has an outdated part.
+     * Entity tags are compared strongly.
+     */
+    bool RangeApplies(const Validators& validators) const noexcept;
+
+    //! The value of @p If-None-Match, which is a list of entity tags or @p *.
+    std::optional<std::string_view> if_none_match;
+
+    //! The value of @p If-Modified-Since.
+    std::optional<std::chrono::system_clock::time_point> if_modified_since;
+
+    //! The value of @p If-Range, which is an entity tag or a date.
+    std::optional<std::string_view> if_range;
+};
+
+//! A range of bytes, including both ends.
+struct ByteRange {
+    //! Get the number of bytes.
+    constexpr std::size_t Length() const noexcept {
+        return last - first + 1;
+    }
+
+    constexpr bool operator==(const ByteRange&) const noexcept = default;
+
+    std::size_t first {0};
+    std::size_t last {0};
+};
+
+//! A byte range specified by a @p Range header, which has not been resolved against the content size.
+struct RangeSpec {
+    /**
+     * @brief Resolve the range against the content size.
+     *
+     * @return The byte range, or @p std::nullopt if the range cannot be satisfied.
+     */
+    std::optional<ByteRange> Resolve(std::size_t size) const noexcept;
+
+    constexpr bool operator==(const RangeSpec&) const noexcept = default;
+
+    //! The first byte position, or @p std::nullopt for a suffix range such as @p -500.
+    std::optional<std::size_t> first {std::nullopt};
+
+    /**
+     * @brief
+     * The last byte position, @p std::nullopt for an open range such as @p 100-,
+     * or the suffix length for a suffix range.
+     */
+    std::optional<std::size_t> last {std::nullopt};
+};
+
+//! The maximum number of ranges accepted in a @p Range header.
+inline constexpr std::size_t max_range_count {16};
+
+/**
+ * @brief Parse the value of an HTTP @p Range header.
+ *
+ * @details Only byte ranges are supported, such as @p bytes=0-99,200-,-50.
+ *
+ * @return
+ * The ranges, or @p std::nullopt if the value is invalid, uses another unit or contains too many ranges.
+ * In such cases, the header should be ignored.
+ */
+std::optional<std::vector<RangeSpec>> ParseRange(
+    std::string_view value) noexcept;
+
+/**
+ * @brief Resolve byte ranges against the content size.
+ *
+ * @return
+ * The satisfiable ranges, sorted with overlapping and adjacent ranges coalesced.
+ * It is empty if no range can be satisfied.
+ */
+std::vector<ByteRange> ResolveRanges(const std::vector<RangeSpec>& ranges,
+                                     std::size_t size) noexcept;
+
+/**
+ * @brief A part of a response body sent after the response header.
+ *
+ * @details
+ * It is used for byte range responses.
+ * Each part sends its prefix, such as the header of a part in a @p multipart/byteranges body,
+ * followed by a range of the content.
+ */
+struct BodyPart {
+    std::string prefix;
+
+    //! The offset of the content.
+    std::size_t offset {0};
+
+    //! The number of content bytes.
+    std::size_t length {0};
+};
+
 //! HTTP uses @p CRLF as the line separator.
 inline constexpr std::string_view new_line {"\r\n"};
 
@@ -75,6 +354,80 @@ inline constexpr std::string_view new_line {"\r\n"};
  */
 std::string_view ContentTypeByFileName(std::string_view name) noexcept;
 
+/**
+ * @brief Pack all files in an asset folder into a single indexed asset pack.
+ *
+ * @details
+ * Each file is indexed by its request path, such as @p /css/index.css for @p css/index.css.
+ * Its precompressed siblings, such as @p index.css.br and @p index.css.gz, are packed as its encoded variants.
+ *
+ * @param dir An asset folder.
+ * @param pack The path of the pack to be written.
+ * @param compression Whether to compress text files with gzip if they do not have a precompressed @p .gz sibling.
+ *
+ * @exception std::system_error Failed to read a file or write the pack.
+ */
+void PackAssets(const std::filesystem::path& dir,
+                const std::filesystem::path& pack, bool compression = false);
+
+//! The address of an upstream server.
+using UpstreamAddr = std::variant<IPv4Addr, IPv6Addr>;
+
+/**
+ * @brief Parse the address of an upstream server.
+ *
+ * @param addr
+ * An IP address with a port, such as @p 127.0.0.1:8080 or @p [::1]:8080.
+ * An IPv6 address must be in brackets. Host names are not resolved.
+ *
+ * @exception std::invalid_argument The address is invalid.
+ */
+UpstreamAddr ParseUpstream(std::string_view addr);
+
+/**
+ * @brief The routing table of the reverse proxy, mapping path prefixes to upstream servers.
+ *
+ * @details
+ * The longest prefix that a request's path starts with decides where the request is handled.
+ * If the prefix has no upstream server or no prefix matches, the request is handled locally.
+ */
+class RoutingTable {
+public:
+    /**
+     * @brief Add a route.
+     *
+     * @param prefix A path prefix, such as @p /api/.
+     * @param upstream An upstream server, or @p std::nullopt to handle matching requests locally.
+     *
+     * @exception std::invalid_argument The prefix does not start with @p / or has been added.
+     */
+    void Add(std::string prefix, std::optional<UpstreamAddr> upstream);
+
+    /**
+     * @brief Find where a request is handled.
+     *
+     * @return The index of the upstream server, or @p std::nullopt if the request is handled locally.
+     */
+    std::optional<std::size_t> Match(std::string_view path) const noexcept;
+
+    //! Get an upstream server by its index.
+    const IPAddr& Upstream(std::size_t idx) const noexcept;
+
+    //! Get the number of different upstream servers.
+    std::size_t UpstreamCount() const noexcept;
+
+private:
+    struct Route {
+        std::string prefix;
+        std::optional<std::size_t> upstream;
+    };
+
+    //! Routes sorted by the lengths of their prefixes in descending order.
+    std::vector<Route> routes_;
+
+    std::vector<UpstreamAddr> upstreams_;
+};
+
 /**
  * @brief
  * Decode an URL-encoded character.
@@ -131,6 +484,172 @@ public:
     //! Get the root directory.
     static std::filesystem::path GetRootDirectory() noexcept;
 
+    /**
+     * @brief Enable the in-memory cache for static assets shared by all connections.
+     *
+     * @param capacity The maximum total size of cached content. Zero disables the cache.
+     * @param revalidation_interval
+     * The minimum interval between two checks of an asset's modification time.
+     * @param compression
+     * Whether to compress cached text assets with gzip when they do not have a precompressed @p .gz sibling.
+     */
+    static void SetAssetCache(
+        std::size_t capacity,
+        std::chrono::steady_clock::duration revalidation_interval,
+        bool compression = false) noexcept;
+
+    /**
+     * @brief Serve static assets from an asset pack shared by all connections.
+     *
+     * @details
+     * The pack is mapped into memory once.
+     * Files outside the pack are still served from the root directory.
+     *
+     * @param pack The path of an asset pack built by @p PackAssets, or an empty path to disable it.
+     *
+     * @exception std::system_error Failed to map the pack.
+     * @exception std::invalid_argument The pack is malformed.
+     */
+    static void SetAssetPack(const std::filesystem::path& pack);
+
+    /**
+     * @brief Set the high-water mark of each connection's buffered data.
+     *
+     * @details
+     * A connection stops reading requests ahead and building responses for them
+     * once its received data or its response data in memory reaches the mark.
+     * The rest stays in the socket until previous responses have been sent,
+     * so a client that pipelines requests faster than it reads responses is throttled by TCP flow control.
+     *
+     * @param size The mark in bytes. Zero means using @p default_high_water_mark.
+     */
+    static void SetHighWaterMark(std::size_t size) noexcept;
+
+    //! Get the high-water mark of each connection's buffered data.
+    static std::size_t GetHighWaterMark() noexcept;
+
+    /**
+     * @brief Set the maximum number of requests served on each persistent connection.
+     *
+     * @details The response to the last request asks the client to close the connection.
+     *
+     * @param count A number of requests. Zero means no limit.
+     */
+    static void SetMaxRequestsPerConnection(std::size_t count) noexcept;
+
+    //! Get the maximum number of requests served on each persistent connection.
+    static std::size_t GetMaxRequestsPerConnection() noexcept;
+
+    /**
+     * @brief Set the idle timeout advertised to clients of persistent connections.
+     *
+     * @details
+     * It should be the time for which the server keeps an idle connection,
+     * so clients do not reuse a connection that is being closed.
+     *
+     * @param timeout A timeout. If it is zero, it is not advertised.
+     */
+    static void SetKeepAliveTimeout(std::chrono::seconds timeout) noexcept;
+
+    /**
+     * @brief Set the maximum size of an incomplete request buffered by each connection.
+     *
+     * @details A client whose incomplete request exceeds the size is rejected with @p 503 Service Unavailable.
+     *
+     * @param size A size in bytes. Zero means no limit.
+     */
+    static void SetMaxBufferSize(std::size_t size) noexcept;
+
+    //! Get the maximum size of an incomplete request buffered by each connection.
+    static std::size_t GetMaxBufferSize() noexcept;
+
+    //! Set limits on the size of each HTTP/1.1 request.
+    static void SetRequestLimits(RequestLimits limits) noexcept;
+
+    //! Get limits on the size of each HTTP/1.1 request.
+    static RequestLimits GetRequestLimits() noexcept;
+
+    /**
+     * @brief Enable TLS on all connections.
+     *
+     * @details
+     * Handshakes run in user space.
+     * After a handshake, the record layer moves to the kernel (kTLS) if it is supported,
+     * so responses are still sent by @p sendfile and gather writes.
+     * Otherwise, data is encrypted and decrypted in user space.
+     *
+     * @param cert_chain A certificate chain in PEM format.
+     * @param private_key The private key of the certificate in PEM format.
+     *
+     * @exception std::runtime_error TLS is not supported, or failed to load the certificate or the key.
+     */
+    static void SetTLSCertificate(const std::filesystem::path& cert_chain,
+                                  const std::filesystem::path& private_key);
+
+    /**
+     * @brief Set the routing table of the reverse proxy shared by all connections.
+     *
+     * @details
+     * @p Process stops at a request routed to an upstream server,
+     * so its caller can forward it by @p StartProxy after previous responses have been sent.
+     * HTTP/2 requests routed to upstream servers are answered with @p 502 Bad Gateway.
+     */
+    static void SetRoutes(RoutingTable routes) noexcept;
+
+    //! Get the routing table of the reverse proxy.
+    static const RoutingTable& GetRoutes() noexcept;
+
+    /**
+     * @brief Set whether responses that may block on the disk are built outside of @p Process.
+     *
+     * @details
+     * If it is enabled, @p Process stops at a request whose response is not in memory,
+     * so its caller can build it by @p BuildDiskResponse in a thread that is allowed to block.
+     * Responses from the asset pack, the asset cache, metrics and traces are still built by @p Process.
+     * HTTP/2 responses are always built by @p Process.
+     */
+    static void SetDiskOffload(bool enable) noexcept;
+
+    //! Whether responses that may block on the disk are built outside of @p Process.
+    static bool GetDiskOffload() noexcept;
+
+    //! Disable TLS on new connections.
+    static void DisableTLS() noexcept;
+
+    //! Whether TLS is enabled.
+    static bool TLSEnabled() noexcept;
+
+    /**
+     * @brief Set the reserved path where metrics are exposed in the Prometheus text format.
+     *
+     * @param path A path. If it is empty, metrics are not exposed.
+     */
+    static void SetMetricsPath(std::string path) noexcept;
+
+    //! Get the reserved path where metrics are exposed.
+    static std::string GetMetricsPath() noexcept;
+
+    //! The default path where metrics are exposed.
+    static constexpr std::string_view default_metrics_path {"/metrics"};
+
+    /**
+     * @brief Set the reserved path where traced request stages are dumped in the Chrome trace event format.
+     *
+     * @details Stages are only traced if tracing is compiled with @p WS_TRACE.
+     *
+     * @param path A path. If it is empty, traces are not dumped.
+     */
+    static void SetTracePath(std::string path) noexcept;
+
+    //! Get the reserved path where traced request stages are dumped.
+    static std::string GetTracePath() noexcept;
+
+    //! The default path where traced request stages are dumped.
+    static constexpr std::string_view default_trace_path {"/trace"};
+
+    //! The default high-water mark of each connection's buffered data.
+    static constexpr std::size_t default_high_water_mark {0x100000};
+
     ConnectionImpl(const ConnectionImpl&) = delete;
 
     ConnectionImpl(ConnectionImpl&&) = delete;
@@ -148,27 +667,148 @@ public:
     //! Get the socket.
     FileDescriptor Socket() const noexcept;
 
-    //! Receive an HTTP request.
+    /**
+     * @brief Receive HTTP requests.
+     *
+     * @details
+     * Data is read until the socket has no more data or the reading buffer reaches the high-water mark.
+     * At least one read is made, so a request larger than the mark can still be received.
+     * If TLS is enabled, the handshake is continued first and requests are read after it has finished.
+     *
+     * @return The number of bytes received by this call.
+     */
     std::size_t Receive();
 
-    //! Send an HTTP response.
+    /**
+     * @brief Whether the last receiving read all data available in the socket.
+     *
+     * @details
+     * If it is @p true, the socket will not be readable until new data arrives,
+     * so an edge-triggered caller can wait for the next receive event.
+     * Otherwise, receiving stopped at the high-water mark and the rest of the data is still in the socket.
+     */
+    bool Drained() const noexcept;
+
+    //! Whether the reading buffer has received data that have not been processed.
+    bool HasReceivedData() const noexcept;
+
+    /**
+     * @brief Send an HTTP response.
+     *
+     * @details
+     * The response header and a small file's content are sent together by a single @p writev.
+     * A large file is sent by @p sendfile without being mapped into memory.
+     * Responses for pipelined requests are sent in order.
+     * If the socket cannot accept more data, the method returns and keeps the progress,
+     * so the next call will resume where it stopped.
+     *
+     * @return The number of bytes sent by this call.
+     */
     std::size_t Send();
 
+    //! Get the number of bytes that have not been sent yet.
+    std::size_t ToSendSize() const noexcept;
+
+    //! Get the number of response bytes buffered in memory, including pending responses.
+    std::size_t BufferedSize() const noexcept;
+
     //! Whether the connection keeps alive.
     bool KeepAlive() const noexcept;
 
     /**
-     * @brief Process the HTTP request.
+     * @brief Process received HTTP requests.
      *
      * @details
      * For the first request that does not contain a user's input,
      * It will reply with a form for user input.
      * Otherwise, it will reply both a user's previous input and a form for new input.
      *
-     * @return @p false if the reading buffer for request is empty, otherwise @p true.
+     * An incomplete request is kept in the reading buffer and its parsing will be resumed after more data is received.
+     * If several requests are pipelined, a response is built for each of them,
+     * until the buffered responses reach the high-water mark.
+     * The remaining requests are processed by the next call after responses have been sent.
+     *
+     * A client starting with the HTTP/2 connection preface is served by an HTTP/2 session,
+     * whose multiplexed requests are answered in the same way.
+     *
+     * @return @p true if there are responses to be sent, otherwise @p false.
      */
     bool Process() noexcept;
 
+    /**
+     * @brief Reject the client because the server is overloaded.
+     *
+     * @details
+     * Received data is dropped and the connection will not be kept alive.
+     * A pre-rendered @p 503 Service Unavailable response is buffered without building a response,
+     * unless previous responses are being sent or the client cannot read an HTTP/1.1 response in plain text,
+     * such as an HTTP/2 client or a TLS client before its handshake finishes.
+     *
+     * @return @p true if there are responses to be sent before the connection is closed, otherwise @p false.
+     */
+    bool Reject() noexcept;
+
+    /**
+     * @brief Get the upstream server of the request that @p Process has stopped at.
+     *
+     * @return The index of the upstream server in the routing table, or @p std::nullopt if no request is to be forwarded.
+     */
+    std::optional<std::size_t> ProxiedUpstream() const noexcept;
+
+    /**
+     * @brief Start forwarding the request that @p Process has stopped at.
+     *
+     * @param forwarded_for The client's address, which is appended to the @p X-Forwarded-For header.
+     * @return The serialized request for the upstream server, which is valid until @p FinishProxy.
+     */
+    std::span<const std::byte> StartProxy(std::string_view forwarded_for);
+
+    /**
+     * @brief Forward received data of the upstream response to the client.
+     *
+     * @details
+     * Data is appended to the writing buffer as it arrives, so the caller should send it before receiving more.
+     *
+     * @param[in, out] data Data received from the upstream server. Forwarded bytes are retrieved from it.
+     * @param closed Whether the upstream server has closed the connection.
+     * @return Whether the response has been forwarded entirely.
+     *
+     * @exception std::invalid_argument The response is malformed or incomplete.
+     */
+    bool ForwardProxyResponse(ChunkedBuffer& data, bool closed);
+
+    /**
+     * @brief Finish forwarding a request.
+     *
+     * @param succeeded
+     * Whether the response has been forwarded entirely.
+     * If not and nothing has been forwarded, a @p 502 Bad Gateway response is built.
+     * Otherwise, the connection will not be kept alive, as the client cannot find the end of the response.
+     *
+     * @return Whether the upstream connection can be reused.
+     */
+    bool FinishProxy(bool succeeded) noexcept;
+
+    //! Whether @p Process has stopped at a request whose response may block on the disk.
+    bool DiskPending() const noexcept;
+
+    /**
+     * @brief Build the response of the request that @p Process has stopped at.
+     *
+     * @details
+     * It opens and reads files, so it should run in a thread dedicated to blocking I/O.
+     * The connection must not be used by other threads until it returns.
+     * Processing continues with the following requests by calling @p Process again.
+     */
+    void BuildDiskResponse() noexcept;
+
+#if WS_TRACE
+    //! Get the trace of the request being processed.
+    trace::RequestTrace& Trace() noexcept {
+        return trace_;
+    }
+#endif
+
 protected:
     static constexpr std::string_view true_tag {"true"};
 
@@ -178,16 +818,287 @@ protected:
 
     virtual ~ConnectionImpl() noexcept;
 
+    /**
+     * @brief Reinitialize the connection with a new socket for reuse.
+     *
+     * @details
+     * The previous socket is closed if it is still open.
+     * Buffers keep their allocated space up to @p max_reused_buffer_size.
+     */
+    void Reset(FileDescriptor socket) noexcept;
+
     static std::filesystem::path root_dir_;
 
+    static std::unique_ptr<AssetCache> asset_cache_;
+
+    static std::unique_ptr<AssetPack> asset_pack_;
+
+    static std::size_t high_water_mark_;
+
+    static std::size_t max_buffer_size_;
+
+    static RequestLimits request_limits_;
+
+    static std::size_t max_requests_;
+
+    static std::unique_ptr<TLSContext> tls_context_;
+
+    static RoutingTable routes_;
+
+    static bool disk_offload_;
+
+    static std::string metrics_path_;
+
+    static std::string trace_path_;
+
     FileDescriptor socket_ {invalid_file_descriptor};
     bool keep_alive_ {false};
 
+    //! The number of requests received on the connection.
+    std::size_t request_count_ {0};
+
+    //! Whether the last receiving read all data available in the socket.
+    bool drained_ {false};
+
+    /**
+     * @brief The maximum size of an uncached file whose content is read into memory.
+     *
+     * @details
+     * The content of such a file is sent with the response header in one gather write,
+     * avoiding an additional system call and TCP segment.
+     */
+    static constexpr std::size_t max_gathered_file_size {0x4000};
+
+    /**
+     * @brief The maximum size of an uncached file mapped into memory to be encrypted in user space.
+     *
+     * @details
+     * Without kTLS, such a file is encrypted from its shared mapping instead of being read in chunks by every connection.
+     * A larger file is still read in chunks, so it never has to be populated as a whole.
+     */
+    static constexpr std::size_t max_mapped_file_size {0x1000000};
+
+    //! The maximum number of bytes of an uncached file prefetched into the page cache before it is sent.
+    static constexpr std::size_t max_prefetch_size {0x200000};
+
+    /**
+     * @brief The maximum number of pipelined requests processed before their responses are sent.
+     *
+     * @details
+     * The remaining requests stay in the reading buffer until the responses have been sent.
+     */
+    static constexpr std::size_t max_pending_response_count {16};
+
+    //! The maximum size of a buffer that keeps its allocated space when the connection is reused.
+    static constexpr std::size_t max_reused_buffer_size {0x10000};
+
+    //! A response waiting for previous responses to be sent.
+    struct PendingResponse {
+        Buffer header {0x100};
+        std::shared_ptr<const Asset> asset;
+        ReadOnlyFile file;
+        std::vector<BodyPart> parts;
+    };
+
     IOBuffer read_buf_;
     IOBuffer write_buf_;
 
+    //! The content of a requested file in memory, which may be shared with the asset cache.
+    std::shared_ptr<const Asset> asset_;
+
+    //! The offset of the content in memory where the next sending starts.
+    std::size_t asset_offset_ {0};
+
     //! The requested file.
-    MappedReadOnlyFile file_;
+    ReadOnlyFile file_;
+
+    //! The offset of the requested file where the next sending starts.
+    std::size_t file_offset_ {0};
+
+    //! The body parts of a @p 206 Partial Content response, or an empty list if the whole content is sent.
+    std::vector<BodyPart> parts_;
+
+    //! The index of the next body part to be sent.
+    std::size_t next_part_ {0};
+
+    //! The offset of the content in memory or the requested file where the current sending ends.
+    std::size_t content_end_ {0};
+
+    /**
+     * @brief A pipe for sending the file by @p splice.
+     *
+     * @details
+     * It is only created if the file does not support @p sendfile.
+     */
+    std::unique_ptr<io::SplicePipe> splice_pipe_;
+
+    //! The request being parsed, which may be incomplete.
+    std::unique_ptr<Request> request_;
+
+    //! Responses for pipelined requests that will be sent after the current one.
+    std::queue<PendingResponse> pending_responses_;
+
+    //! The number of bytes buffered in memory by pending responses.
+    std::size_t pending_size_ {0};
+
+    //! The HTTP/2 session, which is only created if the client starts with the HTTP/2 connection preface.
+    std::unique_ptr<Http2Session> http2_;
+
+    //! Whether the protocol of the connection has been detected from its first bytes.
+    bool protocol_detected_ {false};
+
+    //! The upstream server of the request that processing has stopped at.
+    std::optional<std::size_t> proxy_upstream_;
+
+    //! The exchange with the upstream server, which is created when the first request is forwarded.
+    std::unique_ptr<ProxyExchange> proxy_;
+
+    //! The serialized request being forwarded.
+    Buffer proxy_request_ {0};
+
+    //! Whether processing has stopped at a request whose response may block on the disk.
+    bool disk_pending_ {false};
+
+    //! The TLS session, which is created when the first data is received if TLS is enabled.
+    std::unique_ptr<TLSSession> tls_;
+
+#if WS_TRACE
+    //! Stages of the request being processed, which finishes when its response has been sent.
+    trace::RequestTrace trace_;
+#endif
+
+private:
+    //! Send the remaining content of the requested file.
+    std::size_t SendFile();
+
+    //! Send the response header and the remaining content in memory with a single gather write.
+    std::size_t SendMemory(io::FileDescriptor& io);
+
+    /**
+     * @brief Whether more data will be sent right after the data in memory.
+     *
+     * @details
+     * It is true if a file, another part or another pipelined response follows,
+     * so the data in memory is sent with @p MSG_MORE and coalesced with it into full TCP segments.
+     */
+    bool MoreAfterMemory() const noexcept;
+
+    //! Send responses until all of them have been sent or the socket cannot accept more data.
+    std::size_t SendResponses();
+
+    /**
+     * @brief Build a response for a parsed request and count it by its status code in metrics.
+     *
+     * @param request The request, which may be invalid.
+     * @param error The error that occurred when parsing the request.
+     * @param header A buffer to receive the response header and small content.
+     * @param asset The content in memory to be sent after the header.
+     * @param file The file to be sent after the header.
+     * @param parts The body parts to be sent if only ranges of the content are requested.
+     */
+    void BuildResponse(const Request& request,
+                       const std::optional<RequestError>& error,
+                       Buffer& header, std::shared_ptr<const Asset>& asset,
+                       ReadOnlyFile& file,
+                       std::vector<BodyPart>& parts) noexcept;
+
+    /**
+     * @brief Build a response for a parsed request without counting it in metrics.
+     *
+     * @return The status code of the response.
+     */
+    StatusCode BuildResponseContent(const Request& request,
+                                    const std::optional<RequestError>& error,
+                                    Buffer& header,
+                                    std::shared_ptr<const Asset>& asset,
+                                    ReadOnlyFile& file,
+                                    std::vector<BodyPart>& parts) noexcept;
+
+    /**
+     * @brief Build a response from the asset pack or the asset cache.
+     *
+     * @details
+     * Files in the asset pack are sent from the mapped pack.
+     * Otherwise, if the requested file has not been cached, it will be loaded into the cache.
+     * The most preferred variant accepted by the client is sent.
+     *
+     * @param path The requested path.
+     * @param encodings The content encodings accepted by the client.
+     * @param preconditions
+     * The preconditions of the request.
+     * If the file has not been modified, only a @p 304 Not Modified header is sent.
+     * @param ranges The byte ranges requested by the client.
+     * @param header A buffer to receive the response header.
+     * @param asset The content in memory to be sent after the header.
+     * @param parts The body parts to be sent if only ranges of the content are requested.
+     * @return The status code of the response if the requested file is in the pack or the cache, otherwise @p std::nullopt.
+     */
+    std::optional<StatusCode> BuildFromCache(
+        const std::filesystem::path& path, ContentEncodings encodings,
+        const Preconditions& preconditions,
+        const std::optional<std::vector<RangeSpec>>& ranges, Buffer& header,
+        std::shared_ptr<const Asset>& asset, std::vector<BodyPart>& parts);
+
+    //! Build a response from an asset in memory, sending its most preferred variant accepted by the client.
+    StatusCode BuildFromAsset(
+        const std::filesystem::path& path, std::shared_ptr<const Asset> cached,
+        ContentEncodings encodings, const Preconditions& preconditions,
+        const std::optional<std::vector<RangeSpec>>& ranges, Buffer& header,
+        std::shared_ptr<const Asset>& asset, std::vector<BodyPart>& parts);
+
+    /**
+     * @brief Build the response of a parsed request and retrieve the request.
+     *
+     * @return Whether the following requests can be processed, which is @p false if the connection will be closed.
+     */
+    bool BuildNextResponse(const std::optional<RequestError>& error) noexcept;
+
+    //! Whether the response of a valid request is built from memory without touching the disk.
+    bool InMemory(const Request& request) const noexcept;
+
+    /**
+     * @brief Keep an uncached opened file to be sent.
+     *
+     * @details
+     * A small file, or a file to be encrypted in user space, is sent from its content shared by connections.
+     * Other files are sent by @p sendfile.
+     *
+     * @param user_space Whether the connection sends data through user-space TLS.
+     */
+    static void KeepFile(ReadOnlyFile opened, bool user_space,
+                         std::shared_ptr<const Asset>& asset,
+                         ReadOnlyFile& file) noexcept;
+
+    /**
+     * @brief Start sending the next pending response after the current one has been sent.
+     *
+     * @return @p true if there is a pending response, otherwise @p false.
+     */
+    bool NextResponse() noexcept;
+
+    //! Get the number of bytes a pending response buffers in memory.
+    static std::size_t BufferedSize(const PendingResponse& response) noexcept;
+
+    //! Start sending the content of the current response, from the first body part if there are any.
+    void StartContent() noexcept;
+
+    /**
+     * @brief Start sending the next body part after the current one has been sent.
+     *
+     * @details The prefix of the part is appended to the write buffer.
+     *
+     * @return @p true if there is a remaining part, otherwise @p false.
+     */
+    bool NextPart() noexcept;
+
+    /**
+     * @brief Detect whether the client speaks HTTP/2 with prior knowledge.
+     *
+     * @details If the connection preface has been received, it is retrieved and an HTTP/2 session is created.
+     *
+     * @return @p false if more data is needed to decide, otherwise @p true.
+     */
+    bool DetectProtocol() noexcept;
 };
 
 //! The HTTP connection.
@@ -199,6 +1110,16 @@ public:
     explicit Connection(const FileDescriptor socket, IPAddr addr) noexcept :
         ConnectionImpl {socket}, addr_ {std::move(addr)} {}
 
+    /**
+     * @brief Reinitialize the connection for a new client.
+     *
+     * @details Allocated buffers are reused.
+     */
+    void Reset(const FileDescriptor socket, IPAddr addr) noexcept {
+        ConnectionImpl::Reset(socket);
+        addr_ = std::move(addr);
+    }
+
     std::string IPAddress() const noexcept {
         return addr_.IPAddress();
     }
@@ -17,11 +17,19 @@
 #include "util.h"
 
 #include <iostream>
+#include <span>
 
 
 namespace ws {
 
-class Buffer;
+template <typename ThreadingPolicy>
+class BasicBuffer;
+
+struct SingleThreaded;
+
+using Buffer = BasicBuffer<SingleThreaded>;
+
+class ChunkedBuffer;
 
 namespace io {
 
@@ -124,15 +132,140 @@ public:
 
     FileDescriptor& operator=(FileDescriptor&&) = delete;
 
+    //! The maximum number of buffers written by a single gather write.
+    static constexpr std::size_t max_gather_count {64};
+
     std::size_t WriteTo(Buffer& buf) override;
 
     std::size_t ReadFrom(Buffer& buf) override;
 
+    /**
+     * @brief Read data from multiple buffers and write them with a single @p writev.
+     *
+     * @details
+     * Empty buffers are skipped.
+     * The written size is retrieved from each buffer in order,
+     * so a partial write can be resumed by calling this method again without copying data.
+     *
+     * @param bufs
+     * Buffers to be written in order.
+     * Only the first @p max_gather_count non-empty buffers are written.
+     * @return The number of bytes written.
+     *
+     * @exception std::system_error Failed to write.
+     */
+    std::size_t ReadFrom(std::span<Buffer* const> bufs);
+
+    /**
+     * @brief Write byte segments with a single @p writev.
+     *
+     * @param segments
+     * Byte segments to be written in order.
+     * Only the first @p max_gather_count segments are written.
+     * @param more
+     * Whether more data will be written right after the segments.
+     * If it is set, the segments are sent by @p sendmsg with @p MSG_MORE,
+     * so a TCP socket coalesces them with the following data into full segments.
+     * The descriptor must be a socket.
+     * @return The number of bytes written.
+     *
+     * @exception std::system_error Failed to write.
+     */
+    std::size_t Write(std::span<const std::span<const std::byte>> segments,
+                      bool more = false);
+
+    /**
+     * @brief Read data into a chunked buffer with a single @p readv.
+     *
+     * @details Data is read directly into the buffer's chunks without an intermediate copy.
+     *
+     * @param buf A chunked buffer.
+     * @param size The minimum writable size prepared before reading.
+     * @return The number of bytes read.
+     *
+     * @exception std::system_error Failed to read.
+     */
+    std::size_t WriteTo(ChunkedBuffer& buf, std::size_t size = 0x10000);
+
 private:
     ws::FileDescriptor read_;
     ws::FileDescriptor write_;
 };
 
+/**
+ * @brief Send file content to a file descriptor by @p sendfile without copying data through user space.
+ *
+ * @param out An output file descriptor, usually a socket.
+ * @param in An input file descriptor, which must support @p mmap-like operations.
+ * @param[in, out] offset
+ * The offset in the input file where sending starts.
+ * It will be advanced by the number of bytes sent.
+ * @param count The maximum number of bytes to send.
+ * @return The number of bytes sent.
+ *
+ * @exception std::system_error Failed to send.
+ */
+std::size_t SendFile(ws::FileDescriptor out, ws::FileDescriptor in,
+                     std::size_t& offset, std::size_t count);
+
+/**
+ * @brief
+ * A pipe sending file content to a file descriptor by @p splice without copying data through user space.
+ *
+ * @details
+ * Data is moved from the input file into the pipe, then from the pipe into the output.
+ * If the output cannot accept all data, the remaining data stays in the pipe
+ * and will be sent first by the next call.
+ *
+ * It is an alternative when @p sendfile is not supported by the input file.
+ */
+class SplicePipe {
+public:
+    /**
+     * @brief Create a pipe.
+     *
+     * @exception std::system_error Failed to create the pipe.
+     */
+    SplicePipe();
+
+    ~SplicePipe() noexcept;
+
+    SplicePipe(const SplicePipe&) = delete;
+
+    SplicePipe(SplicePipe&&) = delete;
+
+    SplicePipe& operator=(const SplicePipe&) = delete;
+
+    SplicePipe& operator=(SplicePipe&&) = delete;
+
+    /**
+     * @brief Send file content to a file descriptor.
+     *
+     * @param out An output file descriptor.
+     * @param in An input file descriptor.
+     * @param[in, out] offset
+     * The offset in the input file where reading starts.
+     * It will be advanced by the number of bytes moved into the pipe.
+     * @param count The maximum number of bytes to read from the input file.
+     * @return The number of bytes written to the output.
+     *
+     * @exception std::system_error Failed to send.
+     */
+    std::size_t Send(ws::FileDescriptor out, ws::FileDescriptor in,
+                     std::size_t& offset, std::size_t count);
+
+    //! Get the number of bytes that have been read from the input but not yet written to the output.
+    std::size_t PendingSize() const noexcept;
+
+private:
+    //! Write pending data in the pipe to the output.
+    std::size_t Flush(ws::FileDescriptor out);
+
+    ws::FileDescriptor read_ {invalid_file_descriptor};
+    ws::FileDescriptor write_ {invalid_file_descriptor};
+    std::size_t pending_size_ {0};
+};
+
 }  // namespace io
 
 }  // namespace ws
\ No newline at end of file
@@ -26,9 +26,11 @@
 #pragma once
 
 #include "config.h"
-#include "containers/block_deque.h"
+#include "containers/mpsc_queue.h"
 #include "util.h"
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <experimental/source_location>
 #include <fstream>
@@ -37,11 +39,18 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <unordered_map>
+#include <vector>
+
+#ifndef WS_LOG_MIN_LEVEL
+//! The integral value of the lowest level that can be logged.
+#define WS_LOG_MIN_LEVEL 0
+#endif
 
 
 namespace ws::log {
@@ -78,15 +87,50 @@ std::ostream& operator<<(std::ostream& os, AppenderType type) noexcept;
  *
  * @exception std::invalid_argument The string does not represent an appender type.
  */
-AppenderType StringToAppenderType(std::string str);
+AppenderType StringToAppenderType(std::string_view str);
+
+//! What an asynchronous logger does with an event when its queue is full.
+enum class OverflowPolicy {
+    //! Wait until the writer thread frees a slot.
+    Block = 0,
+    //! Drop the event.
+    Drop = 1,
+    //! Drop the event unless it is an error or one of every several overflowing events, which wait instead.
+    Sample = 2
+};
+
+//! Convert an overflow policy into a string.
+std::string_view OverflowPolicyToString(OverflowPolicy policy) noexcept;
+
+std::string to_string(OverflowPolicy policy) noexcept;
 
-//! The log event.
+std::ostream& operator<<(std::ostream& os, OverflowPolicy policy) noexcept;
+
+/**
+ * @brief Convert a string into an overflow policy.
+ *
+ * @exception std::invalid_argument The string does not represent an overflow policy.
+ */
+OverflowPolicy StringToOverflowPolicy(std::string str);
+
+/**
+ * @brief The log event.
+ *
+ * @details
+ * Events are allocated from a pool of the creating thread together with their control blocks,
+ * and the memory returns to the pool when the last reference is released, even in another thread.
+ * A short message is stored in an inline buffer without allocating memory.
+ * A longer one moves to the heap.
+ */
 class Event {
 public:
     using Ptr = std::shared_ptr<Event>;
 
     using Clock = std::chrono::system_clock;
 
+    //! The maximum size of a message stored without allocating memory.
+    static constexpr std::size_t inline_message_capacity {0xC0};
+
     /**
      * @brief Create an event.
      *
@@ -111,6 +155,8 @@ public:
 
     Event& operator=(Event&&) = delete;
 
+    ~Event() noexcept;
+
     log::Level Level() const noexcept;
 
     std::string_view FileName() const noexcept;
@@ -122,10 +168,17 @@ public:
     Clock::time_point Time() const noexcept;
 
     //! Get the message written by the user.
-    std::string Message() const noexcept;
+    std::string_view Message() const noexcept;
+
+    //! Append a string to the message.
+    void AppendMessage(std::string_view msg) noexcept;
 
-    //! Get an output stream. The user can write messages into it.
-    std::ostringstream& MessageStream() noexcept;
+    /**
+     * @brief Get an output stream. The user can write messages into it.
+     *
+     * @details The stream is created when it is used for the first time.
+     */
+    std::ostream& MessageStream() noexcept;
 
 protected:
     explicit Event(log::Level level,
@@ -139,12 +192,29 @@ private:
     std::uint32_t thread_id_;
     Clock::time_point time_;
 
-    std::ostringstream msg_;
+    //! The output stream writing into the message.
+    class Stream;
+
+    //! It is not initialized, since only the first @p msg_size_ characters are used.
+    std::array<char, inline_message_capacity> inline_msg_;
+    std::size_t msg_size_ {0};
+
+    //! The message moved out of the inline buffer when it becomes too long.
+    std::string heap_msg_;
+
+    std::unique_ptr<Stream> stream_;
 };
 
 Event::Ptr operator<<(Event::Ptr event, std::string_view msg) noexcept;
 
-//! The event formatter.
+/**
+ * @brief The event formatter.
+ *
+ * @details
+ * A pattern is compiled once into a flat array of fields,
+ * which are written into an output string without any stream or virtual call.
+ * Each thread caches the rendered time of date time fields for the current second.
+ */
 class Formatter {
 public:
     using Ptr = std::shared_ptr<Formatter>;
@@ -152,35 +222,29 @@ public:
     static Formatter::Ptr Default() noexcept;
 
     /**
-     * @brief
-     * The field formatter for different information.
-     * A formatter usually needs multiple field formatters, such as for thread ID and time.
+     * @brief A compiled field.
      *
      * @see src/log/field.h
      */
-    class Field {
-    public:
-        using Ptr = std::shared_ptr<Field>;
-
-        /**
-         * @brief Create a field formatter.
-         *
-         * @param format An optional format required for some fields.
-         */
-        explicit Field(std::string_view format = "") noexcept;
-
-        virtual ~Field() noexcept = default;
-
-        //! Format a field into a string.
-        virtual void Format(std::ostream& out, const Logger& logger,
-                            const Event& event) noexcept = 0;
-
-        /**
-         * @brief
-         * Get the tag representing a field.
-         * The tag does not contain the preceding symbol @p %.
-         */
-        virtual std::string_view Tag() const noexcept = 0;
+    struct Field {
+        enum class Type {
+            RawString,
+            Message,
+            Level,
+            ThreadId,
+            DateTime,
+            FileName,
+            LineNum,
+            LoggerName
+        };
+
+        Type type;
+
+        //! The content of a raw string, or the format of a date time.
+        std::string arg;
+
+        //! The unique ID of a date time field, which identifies its rendered time in caches.
+        std::size_t id {0};
     };
 
     /**
@@ -195,14 +259,42 @@ public:
     //! Format an event into a string.
     std::string Format(const Logger& logger, const Event& event) const noexcept;
 
+    //! Format an event and append it to a string, whose memory can be reused by later events.
+    void Format(std::string& out, const Logger& logger,
+                const Event& event) const noexcept;
+
     std::string_view Pattern() const noexcept;
 
 private:
     std::string pattern_;
-    std::list<Field::Ptr> fields_;
+    std::vector<Field> fields_;
+};
+
+//! When an appender writes its buffered events.
+struct FlushPolicy {
+    //! The buffered size that triggers a write. Zero writes each event immediately.
+    std::size_t buffer_size {0x1000};
+
+    //! The longest time events are buffered while more events keep coming.
+    std::chrono::milliseconds interval {1000};
+
+    //! Events at this level or higher are written immediately.
+    log::Level level {Level::Error};
 };
 
-//! The appender that writes events to a specific place.
+bool operator==(const FlushPolicy&, const FlushPolicy&) noexcept;
+
+/**
+ * @brief The appender that writes events to a specific place.
+ *
+ * @details
+ * Formatted events are collected in a reusable buffer and written in batches.
+ * The buffer is written when it is large enough, when it has been kept for a while,
+ * when an event is at least at the flush level, or when the logger flushes the appender.
+ * A synchronous logger flushes its appenders after each event.
+ * An asynchronous logger flushes them whenever its queue becomes empty,
+ * so a burst of events only costs a single write.
+ */
 class Appender {
 public:
     using Ptr = std::shared_ptr<Appender>;
@@ -226,8 +318,11 @@ public:
 
     virtual ~Appender() noexcept = default;
 
-    //! Write an event into a specific place.
-    virtual void Log(const Logger& logger, const Event& event) noexcept = 0;
+    //! Format an event into the buffer, writing the buffer if needed.
+    virtual void Log(const Logger& logger, const Event& event) noexcept;
+
+    //! Write all buffered events.
+    void Flush() noexcept;
 
     //! Convert the appender configuration into a @p YAML string for storage.
     virtual std::string ToYamlString() const noexcept = 0;
@@ -243,9 +338,27 @@ public:
      */
     void SetFormatter(std::string_view pattern);
 
+    FlushPolicy GetFlushPolicy() const noexcept;
+
+    void SetFlushPolicy(const FlushPolicy& policy) noexcept;
+
 protected:
+    //! Write formatted events into a specific place.
+    virtual void Write(std::string_view logs) noexcept = 0;
+
+    //! Add the flush policy to a @p YAML node.
+    void FlushPolicyToYaml(YAML::Node& node) const noexcept;
+
     mutable std::mutex mtx_;
     Formatter::Ptr formatter_;
+
+private:
+    //! Write the buffer without locking.
+    void FlushBuffer() noexcept;
+
+    std::string buffer_;
+    Event::Clock::time_point last_flush_time_ {Event::Clock::now()};
+    FlushPolicy flush_policy_;
 };
 
 //! The appender that writes events to the standard output stream.
@@ -255,9 +368,10 @@ public:
 
     using Appender::Appender;
 
-    void Log(const Logger& logger, const Event& event) noexcept override;
-
     std::string ToYamlString() const noexcept override;
+
+protected:
+    void Write(std::string_view logs) noexcept override;
 };
 
 //! The appender that writes events to a file.
@@ -276,10 +390,11 @@ public:
     explicit FileAppender(std::string_view file_name,
                           Formatter::Ptr formatter = Formatter::Default());
 
-    void Log(const Logger& logger, const Event& event) noexcept override;
-
     std::string ToYamlString() const noexcept override;
 
+protected:
+    void Write(std::string_view logs) noexcept override;
+
 private:
     std::string file_name_;
     std::ofstream file_;
@@ -304,11 +419,11 @@ public:
      * @param capacity
      * The capacity of event queue.
      * If it is invalid or zero, the logger will be synchronous, otherwise asynchronous.
-     * If the queue is full, the logging process will be blocked and waiting.
+     * @param overflow What to do with an event when the queue is full.
      */
-    explicit Logger(
-        std::string_view name, log::Level level = Level::Info,
-        std::optional<std::size_t> capacity = std::nullopt) noexcept;
+    explicit Logger(std::string_view name, log::Level level = Level::Info,
+                    std::optional<std::size_t> capacity = std::nullopt,
+                    OverflowPolicy overflow = OverflowPolicy::Block) noexcept;
 
     ~Logger() noexcept;
 
@@ -320,8 +435,22 @@ public:
 
     Logger& operator=(Logger&&) = delete;
 
+    /**
+     * @brief Log an event.
+     *
+     * @details
+     * An asynchronous logger pushes the event into a lock-free queue,
+     * so logging from many threads only costs a few atomic operations.
+     */
     void Log(Event::Ptr event) noexcept;
 
+    /**
+     * @brief Whether an event at a level would be logged.
+     *
+     * @details It only reads an atomic level, so it can be checked before creating and formatting an event.
+     */
+    bool Enabled(log::Level level) const noexcept;
+
     void AddAppender(Appender::Ptr appender) noexcept;
 
     void RemoveAppender(Appender::Ptr appender) noexcept;
@@ -355,6 +484,22 @@ public:
 
     std::size_t Capacity() const noexcept;
 
+    OverflowPolicy Overflow() const noexcept;
+
+    //! Get the number of events dropped because the queue was full.
+    std::size_t DroppedCount() const noexcept;
+
+    /**
+     * @brief Restrict the writer thread of an asynchronous logger to a set of CPUs.
+     *
+     * @details
+     * Keeping the writer away from reactors and working threads stops formatting and file writes from preempting them.
+     * It has no effect on a synchronous logger.
+     *
+     * @exception std::system_error Failed to set the affinity.
+     */
+    void SetWriterAffinity(std::span<const std::size_t> cpus);
+
     //! Convert the logger configuration into a @p YAML string for storage.
     std::string ToYamlString() const noexcept;
 
@@ -364,16 +509,55 @@ private:
 
     void SyncLog(const Event& event) noexcept;
 
+    //! Write the events buffered in appenders.
+    void FlushAppenders() noexcept;
+
+    //! Push an event into the queue, handling overflow according to the policy.
+    void Enqueue(Event::Ptr event) noexcept;
+
+    //! Wait until the queue has a free slot, then push an event.
+    void EnqueueWaiting(Event::Ptr event) noexcept;
+
+    //! Wake up the writer thread if it is sleeping.
+    void NotifyWriter() noexcept;
+
+    /**
+     * @brief The sampling interval of the sample overflow policy.
+     *
+     * @details One of every such many overflowing events waits for a free slot.
+     */
+    static constexpr std::size_t overflow_sample_interval {0x10};
+
     mutable std::mutex mtx_;
     bool async_;
     std::unique_ptr<std::thread> writer_thread_;
 
     std::string name_;
     std::size_t capacity_;
-    log::Level level_;
+    OverflowPolicy overflow_;
+    std::atomic<log::Level> level_;
     std::list<Appender::Ptr> appenders_;
-    std::unique_ptr<BlockDeque<Event::Ptr>> event_deque_;
     Formatter::Ptr formatter_ {Formatter::Default()};
+
+    std::unique_ptr<MPSCQueue<Event::Ptr>> event_queue_;
+
+    //! Whether the logger is being destroyed.
+    std::atomic_bool closed_ {false};
+
+    //! Whether the writer thread is sleeping because the queue is empty.
+    std::atomic_bool writer_sleeping_ {false};
+
+    //! It is increased to wake up the writer thread.
+    std::atomic_uint32_t writer_signal_ {0};
+
+    //! The number of producers waiting for a free slot.
+    std::atomic_size_t waiting_producers_ {0};
+
+    //! It is increased to wake up producers when slots are freed.
+    std::atomic_uint32_t space_signal_ {0};
+
+    std::atomic_size_t overflow_count_ {0};
+    std::atomic_size_t dropped_count_ {0};
 };
 
 void Log(Logger::Ptr logger, Event::Ptr event) noexcept;
@@ -406,7 +590,7 @@ public:
 
     ~EventWriter() noexcept;
 
-    std::ostringstream& MessageStream() noexcept;
+    std::ostream& MessageStream() noexcept;
 
 private:
     Logger& logger_;
@@ -440,7 +624,8 @@ public:
     //! Get a logger by its name, creating it if it does not exist.
     Logger::Ptr FindLogger(
         std::string_view name, log::Level level = Level::Info,
-        std::optional<std::size_t> capacity = std::nullopt) noexcept;
+        std::optional<std::size_t> capacity = std::nullopt,
+        OverflowPolicy overflow = OverflowPolicy::Block) noexcept;
 
     void RemoveLogger(std::string_view name) noexcept;
 
@@ -459,4 +644,54 @@ Logger::Ptr RootLogger() noexcept;
 
 Logger::Ptr FindLogger(std::string_view name) noexcept;
 
-}  // namespace ws::log
\ No newline at end of file
+/**
+ * @brief The lowest level of events that can be logged, fixed at compile time.
+ *
+ * @details
+ * It is set by the @p WS_LOG_MIN_LEVEL macro, which is an integral value of @p Level.
+ * Logging macros below it are compiled into nothing.
+ */
+inline constexpr Level min_level {static_cast<Level>(WS_LOG_MIN_LEVEL)};
+
+}  // namespace ws::log
+
+/**
+ * @brief Log a message formatted by @p fmt::format.
+ *
+ * @details
+ * The level is checked before creating the event,
+ * so the format arguments are not evaluated if the event will not be logged.
+ * If the level is lower than @p ws::log::min_level, the call is discarded at compile time.
+ *
+ * @code {.cpp}
+ * WS_LOG(logger, ws::log::Level::Info, "Client {} has connected", client.IPAddress());
+ * @endcode
+ *
+ * @param logger A pointer to a logger.
+ * @param level A constant level.
+ */
+#define WS_LOG(logger, level, ...)                                        \
+    do {                                                                  \
+        if constexpr ((level) >= ::ws::log::min_level) {                  \
+            if (const auto& ws_log_logger {logger};                       \
+                ws_log_logger && ws_log_logger->Enabled(level)) {         \
+                ws_log_logger->Log(::ws::log::Event::Create(level)        \
+                                   << ::fmt::format(__VA_ARGS__));        \
+            }                                                             \
+        }                                                                 \
+    } while (false)
+
+#define WS_LOG_DEBUG(logger, ...) \
+    WS_LOG(logger, ::ws::log::Level::Debug, __VA_ARGS__)
+
+#define WS_LOG_INFO(logger, ...) \
+    WS_LOG(logger, ::ws::log::Level::Info, __VA_ARGS__)
+
+#define WS_LOG_WARN(logger, ...) \
+    WS_LOG(logger, ::ws::log::Level::Warn, __VA_ARGS__)
+
+#define WS_LOG_ERROR(logger, ...) \
+    WS_LOG(logger, ::ws::log::Level::Error, __VA_ARGS__)
+
+#define WS_LOG_FATAL(logger, ...) \
+    WS_LOG(logger, ::ws::log::Level::Fatal, __VA_ARGS__)
@@ -0,0 +1,265 @@
+/**
+ * @file metrics.h
+ * @brief The metrics system.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-27
+ *
+ * @example tests/metrics_test.cpp
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ws::metrics {
+
+/**
+ * @brief The number of shards of a metric.
+ *
+ * @details
+ * Each thread updates the shard selected by its index,
+ * so threads rarely write to the same cache line.
+ */
+inline constexpr std::size_t shard_count {16};
+
+//! Get the index of the shard updated by the current thread.
+std::size_t ShardIndex() noexcept;
+
+/**
+ * @brief A monotonically increasing counter.
+ *
+ * @details
+ * Increasing it costs a relaxed atomic addition to the current thread's shard.
+ * Shards are summed when the value is read.
+ */
+class Counter {
+public:
+    //! Increase the counter.
+    void Increase(std::uint64_t n = 1) noexcept;
+
+    //! Get the sum of all shards.
+    std::uint64_t Value() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic_uint64_t value {0};
+    };
+
+    std::array<Shard, shard_count> shards_;
+};
+
+/**
+ * @brief A gauge that can go up and down.
+ *
+ * @details
+ * It is sharded in the same way as counters,
+ * so a thread can decrease it below zero while the sum of all shards stays correct.
+ */
+class Gauge {
+public:
+    //! Increase the gauge.
+    void Increase(std::int64_t n = 1) noexcept;
+
+    //! Decrease the gauge.
+    void Decrease(std::int64_t n = 1) noexcept;
+
+    //! Get the sum of all shards.
+    std::int64_t Value() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic_int64_t value {0};
+    };
+
+    std::array<Shard, shard_count> shards_;
+};
+
+/**
+ * @brief A histogram counting integer observations in buckets with fixed upper bounds.
+ *
+ * @details
+ * Observing a value costs a search in upper bounds and relaxed atomic additions to the current thread's shard.
+ * Observations are integers, such as nanoseconds,
+ * and are multiplied by a scale when exposed, such as @p 1e-9 for seconds.
+ */
+class Histogram {
+public:
+    //! Latency buckets from 100 microseconds to 10 seconds, in nanoseconds.
+    static const std::vector<std::uint64_t> latency_bounds;
+
+    /**
+     * @brief Create a histogram.
+     *
+     * @param bounds Upper bounds of buckets in ascending order. A bucket without an upper bound is added after them.
+     * @param scale The scale of observations when they are exposed.
+     *
+     * @exception std::invalid_argument Upper bounds are not in ascending order.
+     */
+    explicit Histogram(std::vector<std::uint64_t> bounds, double scale = 1);
+
+    //! Observe a value.
+    void Observe(std::uint64_t value) noexcept;
+
+    //! Get upper bounds of buckets.
+    const std::vector<std::uint64_t>& Bounds() const noexcept;
+
+    //! Get the scale of observations.
+    double Scale() const noexcept;
+
+    /**
+     * @brief Get the number of observations in each bucket.
+     *
+     * @return Counts which are not cumulative. The last one is the bucket without an upper bound.
+     */
+    std::vector<std::uint64_t> Counts() const noexcept;
+
+    //! Get the sum of observations.
+    std::uint64_t Sum() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        //! Counts of buckets, including the one without an upper bound.
+        std::unique_ptr<std::atomic_uint64_t[]> counts;
+        std::atomic_uint64_t sum {0};
+    };
+
+    std::vector<std::uint64_t> bounds_;
+    double scale_;
+    std::array<Shard, shard_count> shards_;
+};
+
+//! Labels of a metric, which are sorted by names.
+using Labels = std::map<std::string, std::string>;
+
+/**
+ * @brief The registry of metrics.
+ *
+ * @details
+ * A metric is identified by its name and labels.
+ * Registering an existing metric returns it again,
+ * so modules can keep a reference to a metric in a function-local static variable.
+ * Registered metrics live as long as the registry.
+ */
+class Registry {
+public:
+    /**
+     * @brief Register a counter.
+     *
+     * @param name A metric name. By convention, it ends with @p _total.
+     * @param help A description of the metric.
+     * @param labels Labels distinguishing the metric from others with the same name.
+     *
+     * @exception std::invalid_argument A metric of another type has the same name.
+     */
+    Counter& AddCounter(std::string_view name, std::string_view help,
+                        const Labels& labels = {});
+
+    /**
+     * @brief Register a gauge.
+     *
+     * @exception std::invalid_argument A metric of another type has the same name.
+     */
+    Gauge& AddGauge(std::string_view name, std::string_view help,
+                    const Labels& labels = {});
+
+    /**
+     * @brief Register a histogram.
+     *
+     * @details If the histogram exists, its buckets are not changed.
+     *
+     * @exception std::invalid_argument A metric of another type has the same name.
+     */
+    Histogram& AddHistogram(std::string_view name, std::string_view help,
+                            std::vector<std::uint64_t> bounds, double scale = 1,
+                            const Labels& labels = {});
+
+    /**
+     * @brief Aggregate all metrics in the Prometheus text format.
+     *
+     * @details Metrics are grouped by names in the order of their first registration.
+     */
+    std::string Expose() const noexcept;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Metric {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::list<Metric> metrics;
+    };
+
+    //! Find or create the metric with a name and labels.
+    Metric& Find(std::string_view name, std::string_view help, Type type,
+                 const Labels& labels);
+
+    mutable std::mutex mtx_;
+    std::list<Family> families_;
+};
+
+//! Get the registry shared by all modules.
+Registry& DefaultRegistry() noexcept;
+
+/**
+ * @brief Get a counter of the default registry distinguished by one label, caching it in the calling thread.
+ *
+ * @details
+ * Counters are cached by each thread, so counting frequent events does not lock the registry.
+ * The label value is only converted into a string when a thread meets it for the first time.
+ *
+ * @param name A metric name, which must outlive the thread, such as a string literal.
+ * @param help A description of the metric.
+ * @param label A label name.
+ * @param value
+ * A label value, which is a string or an integer.
+ * A string view must outlive the thread as well.
+ *
+ * @exception std::invalid_argument A metric of another type has the same name.
+ */
+template <typename T>
+Counter& CachedCounter(const std::string_view name, const std::string_view help,
+                       const std::string_view label, const T& value) {
+    thread_local std::map<std::pair<std::string_view, T>, Counter*> counters;
+    auto& counter {counters[{name, value}]};
+    if (!counter) {
+        std::string str;
+        if constexpr (std::is_convertible_v<T, std::string_view>) {
+            str = std::string_view {value};
+        } else {
+            str = std::to_string(value);
+        }
+
+        counter = &DefaultRegistry().AddCounter(name, help,
+                                                {{std::string {label}, str}});
+    }
+
+    return *counter;
+}
+
+}  // namespace ws::metrics
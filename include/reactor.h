@@ -0,0 +1,1690 @@
+/**
+ * @file reactor.h
+ * @brief The event loop serving clients of a listening socket.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-06-30
+ */
+
+#pragma once
+
+#include "containers/chunked_buffer.h"
+#include "containers/connection_table.h"
+#include "containers/poller.h"
+#include "containers/object_pool.h"
+#include "containers/timing_wheel.h"
+#include "containers/thread_pool.h"
+#include "coroutine.h"
+#include "http.h"
+#include "ip.h"
+#include "log.h"
+#include "metrics.h"
+#include "util.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+namespace ws {
+
+//! Options of reactors' listeners.
+struct ListenerOptions {
+    /**
+     * @brief The maximum number of connections accepted in an iteration of the event loop.
+     *
+     * @details
+     * The rest are accepted in the next iterations,
+     * so a burst of new connections cannot starve existing clients.
+     */
+    std::size_t accept_budget {0x40};
+
+    /**
+     * @brief The time for which the kernel waits for a new connection's first data before completing its accepting.
+     *
+     * @details
+     * It enables @p TCP_DEFER_ACCEPT,
+     * so the reactor is not notified of a connection until it has a request to read.
+     * Zero disables it.
+     */
+    std::chrono::seconds defer_accept {0};
+
+    /**
+     * @brief The maximum number of pending @p TCP_FASTOPEN requests.
+     *
+     * @details
+     * @p TCP_FASTOPEN allows clients to send data in the @p SYN packet.
+     * Zero disables it.
+     */
+    std::size_t fast_open_queue {0};
+
+    /**
+     * @brief The CPU whose connections the listener prefers.
+     *
+     * @details
+     * It sets @p SO_INCOMING_CPU.
+     * Among listeners sharing a port by @p SO_REUSEPORT,
+     * the kernel prefers the one whose CPU is processing a new connection's packets.
+     * If the reactor is pinned to the same CPU and receive queues of the network card are steered to it by RSS or RPS,
+     * a connection's packets, reactor and buffers stay on one core.
+     */
+    std::optional<std::size_t> incoming_cpu;
+
+    /**
+     * @brief Whether to disable Nagle's algorithm on accepted connections.
+     *
+     * @details
+     * It sets @p TCP_NODELAY, which accepted connections inherit from the listener.
+     * Connections already mark all but the last write of their responses with @p MSG_MORE,
+     * so the kernel still sends full segments, while the end of a response leaves without waiting for an acknowledgment.
+     */
+    bool no_delay {true};
+
+    /**
+     * @brief The size of each accepted connection's socket send buffer.
+     *
+     * @details
+     * It sets @p SO_SNDBUF, which accepted connections inherit from the listener.
+     * A fixed size disables the kernel's auto-tuning of the buffer.
+     * Zero keeps the default.
+     */
+    std::size_t send_buffer_size {0};
+
+    //! The size of each accepted connection's socket receive buffer, in the same way as @p send_buffer_size.
+    std::size_t receive_buffer_size {0};
+};
+
+/**
+ * @brief Limits on the load admitted by a reactor.
+ *
+ * @details
+ * When a limit is reached, the reactor sheds new work cheaply instead of queueing it,
+ * so admitted clients keep a bounded latency under overload.
+ * Zero disables a limit.
+ */
+struct AdmissionOptions {
+    /**
+     * @brief The maximum number of clients connected to the reactor.
+     *
+     * @details
+     * When it is reached, the listener is removed from the poller until a client disconnects.
+     * New connections wait in the listen backlog instead of being accepted and served slowly.
+     */
+    std::size_t max_connections {0};
+
+    /**
+     * @brief The maximum number of tasks queued in the thread pool.
+     *
+     * @details
+     * When it is reached, clients sending new requests are rejected with @p 503 Service Unavailable in the reactor's thread.
+     * Clients receiving responses are still dispatched, so admitted requests can finish.
+     */
+    std::size_t max_queued_tasks {0};
+
+    /**
+     * @brief The maximum time for which a client with new requests waits in the thread pool.
+     *
+     * @details Its requests are rejected with @p 503 Service Unavailable if it waited longer.
+     */
+    std::chrono::steady_clock::duration max_queue_time {0};
+};
+
+/**
+ * @brief The event loop serving clients of a listening socket.
+ *
+ * @details
+ * A reactor owns a listener, a poller, a timer system and a connection table.
+ * Clients are added and removed only in the reactor's thread.
+ * Closed clients are kept in a pool and reused for new connections, along with their buffers.
+ *
+ * Received and sent data can be processed in two ways:
+ * - If a thread pool is provided, clients are dispatched to its working threads.
+ *   Tasks of ready clients returned by a wait are pushed into the thread pool as a single batch.
+ *   If there are too few of them to be worth waking up working threads, they are processed in the reactor's thread.
+ *   A client being processed by a working thread is not released until the task finishes.
+ * - Otherwise, clients are processed directly in the reactor's thread.
+ *   Connections never cross threads, so multiple reactors can run in parallel,
+ *   each with its own @p SO_REUSEPORT listener.
+ *
+ * Responses are sent as soon as they are built, since a socket is usually writable.
+ * The reactor only waits for a send event if the socket cannot accept more data.
+ *
+ * Without a thread pool, each client can also be served by a coroutine,
+ * which receives, processes and sends in a single flow and suspends only when its socket would block.
+ * The socket is registered once as edge-triggered instead of being re-armed for every phase,
+ * so a keep-alive request costs no @p epoll_ctl.
+ *
+ * Coroutines also forward requests routed to upstream servers by the reverse proxy.
+ * Upstream connections are registered on the same poller and kept alive in a pool of each reactor,
+ * so a forwarded request usually reuses a connection without a new handshake.
+ *
+ * If an I/O executor is provided, a coroutine moves the building of a response that may block on the disk to it,
+ * and is resumed in the reactor's thread when the response is ready.
+ * Other clients keep being served while files are opened and read.
+ */
+template <ValidIPAddr IPAddr>
+class Reactor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    using Ptr = std::unique_ptr<Reactor>;
+
+    /**
+     * @brief Create a reactor.
+     *
+     * @param port A listening port.
+     * @param alive_time
+     * A maximum alive time for client timers.
+     * A client's timer will be refreshed if it sends or receives data.
+     * When a client's timer reaches zero, it will disconnect.
+     * @param thread_pool
+     * A thread pool processing clients.
+     * If it is @p nullptr, clients will be processed in the reactor's thread.
+     * It must stop before the reactor is destroyed.
+     * @param reuse_port
+     * Whether the listener is bound with @p SO_REUSEPORT,
+     * so that the kernel can distribute new connections among multiple reactors listening on the same port.
+     * @param poller_options
+     * Options of the poller.
+     * If @p io_uring is not supported by the kernel, the reactor will fall back to @p epoll.
+     * @param listener_options Options of the listener.
+     * @param admission_options Limits on the admitted load.
+     * @param coroutines
+     * Whether clients are served by coroutines.
+     * It is ignored if a thread pool is provided, as a coroutine is resumed only in the reactor's thread.
+     * @param io_executor
+     * An executor building responses that may block on the disk for coroutines.
+     * If it is @p nullptr, they are built in the reactor's thread.
+     * It must stop before the reactor is destroyed.
+     * @param logger
+     * A logger. If it is @p nullptr, the reactor will use the global root logger.
+     *
+     * @exception std::system_error Failed to create the poller or the wake-up event.
+     */
+    explicit Reactor(
+        const std::uint16_t port, const Clock::duration alive_time,
+        Executor* const thread_pool, const bool reuse_port,
+        const Poller::Options& poller_options = {},
+        const ListenerOptions& listener_options = {},
+        const AdmissionOptions& admission_options = {},
+        const bool coroutines = false, Executor* const io_executor = nullptr,
+        log::Logger::Ptr logger = log::RootLogger()) :
+        port_ {port},
+        alive_time_ {alive_time},
+        thread_pool_ {thread_pool},
+        reuse_port_ {reuse_port},
+        listener_options_ {listener_options},
+        admission_options_ {admission_options},
+        coroutines_ {coroutines && !thread_pool},
+        io_executor_ {coroutines_ ? io_executor : nullptr},
+        logger_ {std::move(logger)} {
+        if (!logger_) {
+            logger_ = log::RootLogger();
+        }
+
+        assert(listener_options_.accept_budget > 0);
+        try {
+            poller_ = Poller::Create(poller_options);
+        } catch (const std::system_error& err) {
+            if (poller_options.backend == Poller::Backend::Epoll) {
+                throw;
+            }
+
+            WS_LOG_WARN(logger_,
+                        "Failed to create an io_uring poller, "
+                        "falling back to epoll: {}",
+                        err.what());
+            auto options {poller_options};
+            options.backend = Poller::Backend::Epoll;
+            poller_ = Poller::Create(options);
+        }
+
+        waker_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (!IsValidFileDescriptor(waker_)) {
+            ThrowLastSystemError();
+        }
+
+        poller_->AddFileDescriptor(waker_, EPOLLIN);
+    }
+
+    ~Reactor() noexcept {
+        Release();
+        close(waker_);
+    }
+
+    Reactor(const Reactor&) = delete;
+
+    Reactor(Reactor&&) = delete;
+
+    Reactor& operator=(const Reactor&) = delete;
+
+    Reactor& operator=(Reactor&&) = delete;
+
+    /**
+     * @brief Run the event loop in the current thread until the reactor is closed.
+     *
+     * @exception std::system_error Failed to initialize the network.
+     */
+    void Start() {
+        const RAII raii {this, [](Reactor* const reactor) noexcept {
+                             reactor->CloseListener();
+                         }};
+        InitNetwork();
+        loop_thread_ = std::this_thread::get_id();
+        while (!closed_) {
+            try {
+                // Do not block if there are connections left to accept or coroutines left to resume.
+                const auto busy {accept_pending_ || !yielded_.empty()};
+                const auto wait_time {busy ? Clock::duration::zero()
+                                           : timer_.ToNextTick()};
+
+                // Wait without a time-out if there is no client.
+                // The reactor will be woken up when it is closed.
+                const auto event_count {
+                    poller_->Wait(busy || !timer_.Empty()
+                                      ? std::optional {wait_time}
+                                      : std::nullopt)};
+                if (thread_pool_ && admission_options_.max_queued_tasks > 0) {
+                    // Read the queue length once per wait, as it may need a lock.
+                    queued_count_ = thread_pool_->QueuedCount();
+                }
+
+                for (std::size_t i {0}; i != event_count; ++i) {
+                    const auto socket {poller_->FileDescriptor(i)};
+                    const auto events {poller_->Events(i)};
+                    if (socket == listener_) {
+                        // Accept new connections after existing clients have been processed.
+                        accept_pending_ = true;
+                    } else if (socket == waker_) {
+                        OnWakeEvent();
+                    } else if (coroutines_) {
+                        if (upstreams_.Contain(socket)) {
+                            OnUpstreamEvent(socket, events);
+                        } else {
+                            OnReadinessEvent(socket, events);
+                        }
+                    } else {
+                        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                            OnCloseEvent(socket);
+                        } else if (events & EPOLLIN) {
+                            OnReceiveEvent(socket);
+                        } else if (events & EPOLLOUT) {
+                            OnSendEvent(socket);
+                        } else {
+                            throw std::runtime_error {
+                                fmt::format("Unexpected event: {}", events)};
+                        }
+                    }
+                }
+
+                DispatchPendingTasks();
+                ResumeYieldedClients();
+                if (accept_pending_) {
+                    OnListenEvent();
+                }
+            } catch (const std::exception& err) {
+                WS_LOG_ERROR(logger_, "Exception raised in reactor: {}",
+                             err.what());
+
+                // Tasks collected before the exception must still run, or their clients will never be released.
+                DispatchPendingTasks();
+            }
+        }
+    }
+
+    /**
+     * @brief Close the reactor.
+     *
+     * @details
+     * It can be called in any thread, even before the reactor starts.
+     * The event loop will exit after finishing the current iteration.
+     */
+    void Close() noexcept {
+        closed_ = true;
+        Wake();
+    }
+
+private:
+    //! A client in the connection table.
+    struct Client {
+        explicit Client(const FileDescriptor socket, IPAddr addr) noexcept :
+            conn {socket, std::move(addr)} {}
+
+        //! Reinitialize a closed client for a new connection.
+        void Reset(const FileDescriptor socket, IPAddr addr) noexcept {
+            assert(task_count.load(std::memory_order_relaxed) == 0);
+            assert(!coroutine);
+            conn.Reset(socket, std::move(addr));
+            readiness.Reset();
+        }
+
+        http::Connection<IPAddr> conn;
+
+        //! The coroutine serving the client, if clients are served by coroutines.
+        coro::Task<> coroutine;
+
+        //! The readiness of the client's socket, which its coroutine waits for.
+        coro::SocketReadiness readiness;
+
+        //! The number of dispatched tasks that have not finished.
+        std::atomic<std::uint32_t> task_count {0};
+
+        /**
+         * @brief The time when the client was last dispatched to the thread pool.
+         *
+         * @details It is kept in the client rather than the task, so the task still fits in its inline storage.
+         */
+        Clock::time_point dispatched;
+    };
+
+    using Clients = ConnectionTable<Client>;
+
+    //! A connection to an upstream server of the reverse proxy.
+    struct Upstream {
+        explicit Upstream(const FileDescriptor socket,
+                          const std::size_t idx) noexcept :
+            socket {socket}, idx {idx} {}
+
+        ~Upstream() noexcept {
+            close(socket);
+        }
+
+        Upstream(const Upstream&) = delete;
+
+        Upstream& operator=(const Upstream&) = delete;
+
+        FileDescriptor socket;
+
+        //! The index of the upstream server in the routing table.
+        std::size_t idx;
+
+        /**
+         * @brief Data received from the upstream server and not yet forwarded.
+         *
+         * @details It is read directly into chunks, which are released once forwarded.
+         */
+        ChunkedBuffer buf;
+
+        //! The readiness of the socket, which the coroutine of its client waits for.
+        coro::SocketReadiness readiness;
+
+        //! The client forwarding a request over the connection, or @p std::nullopt if it is idle in the pool.
+        std::optional<typename Clients::Handle> client;
+    };
+
+    //! The maximum number of closed clients kept for reuse.
+    static constexpr std::size_t max_pooled_client_count {0x400};
+
+    //! The maximum number of idle connections kept for each upstream server.
+    static constexpr std::size_t max_idle_upstream_count {0x20};
+
+    //! The maximum number of send resumes in a batch processed in the reactor's thread instead of the thread pool.
+    static constexpr std::size_t max_inline_task_count {1};
+
+    static constexpr auto listen_event_mode {EPOLLRDHUP | EPOLLET};
+
+    static constexpr auto connect_event_mode {EPOLLONESHOT | EPOLLRDHUP
+                                              | EPOLLET};
+
+    //! The event mode of clients served by coroutines, which are registered once and never re-armed.
+    static constexpr auto coroutine_event_mode {EPOLLRDHUP | EPOLLET};
+
+    void InitNetwork() {
+        assert(port_ >= 1024);
+
+        const IPAddr addr {IPAddr::any.data(), port_};
+        const linger opt {.l_onoff = true, .l_linger = 1};
+        listener_ = socket(IPAddr::version,
+                           SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (!IsValidFileDescriptor(listener_)) {
+            ThrowLastSystemError();
+        }
+
+        bool failed {true};
+        const RAII raii {std::ref(listener_),
+                         [&failed](FileDescriptor& socket) {
+                             if (failed) {
+                                 close(socket);
+                                 socket = invalid_file_descriptor;
+                             }
+                         }};
+
+        if (setsockopt(listener_, SOL_SOCKET, SO_LINGER, &opt, sizeof(opt))
+            < 0) {
+            ThrowLastSystemError();
+        }
+
+        const int enable {1};
+        if (setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &enable,
+                       sizeof(enable))
+            < 0) {
+            ThrowLastSystemError();
+        }
+
+        if (reuse_port_
+            && setsockopt(listener_, SOL_SOCKET, SO_REUSEPORT, &enable,
+                          sizeof(enable))
+                   < 0) {
+            ThrowLastSystemError();
+        }
+
+        if (const int time {static_cast<int>(
+                listener_options_.defer_accept.count())};
+            time > 0
+            && setsockopt(listener_, IPPROTO_TCP, TCP_DEFER_ACCEPT, &time,
+                          sizeof(time))
+                   < 0) {
+            ThrowLastSystemError();
+        }
+
+        if (const int queue {
+                static_cast<int>(listener_options_.fast_open_queue)};
+            queue > 0
+            && setsockopt(listener_, IPPROTO_TCP, TCP_FASTOPEN, &queue,
+                          sizeof(queue))
+                   < 0) {
+            ThrowLastSystemError();
+        }
+
+        if (listener_options_.no_delay
+            && setsockopt(listener_, IPPROTO_TCP, TCP_NODELAY, &enable,
+                          sizeof(enable))
+                   < 0) {
+            ThrowLastSystemError();
+        }
+
+        // Buffer sizes must be set before listening to take effect on the TCP window of accepted connections.
+        for (const auto& [name, size] :
+             {std::pair {SO_SNDBUF, listener_options_.send_buffer_size},
+              std::pair {SO_RCVBUF, listener_options_.receive_buffer_size}}) {
+            if (const int value {static_cast<int>(size)};
+                value > 0
+                && setsockopt(listener_, SOL_SOCKET, name, &value,
+                              sizeof(value))
+                       < 0) {
+                ThrowLastSystemError();
+            }
+        }
+
+        if (const auto cpu {listener_options_.incoming_cpu}; cpu.has_value()) {
+            const auto value {static_cast<int>(cpu.value())};
+            if (setsockopt(listener_, SOL_SOCKET, SO_INCOMING_CPU, &value,
+                           sizeof(value))
+                < 0) {
+                ThrowLastSystemError();
+            }
+        }
+
+        if (bind(listener_, addr.Raw(), addr.Size()) < 0) {
+            ThrowLastSystemError();
+        }
+
+        if (listen(listener_, SOMAXCONN) < 0) {
+            ThrowLastSystemError();
+        }
+
+        poller_->AddFileDescriptor(listener_, listen_event_mode | EPOLLIN);
+        failed = false;
+    }
+
+    //! Close the listener.
+    void CloseListener() noexcept {
+        if (IsValidFileDescriptor(listener_)) {
+            close(listener_);
+            listener_ = invalid_file_descriptor;
+        }
+    }
+
+    /**
+     * @brief Release the network resources and clients.
+     *
+     * @warning The thread pool must have stopped, so no task is using clients.
+     */
+    void Release() noexcept {
+        CloseListener();
+        timer_.Clear();
+        yielded_.clear();
+
+        // Destroying coroutines closes the upstream connections they are using.
+        users_.Clear();
+        upstreams_.Clear();
+        idle_upstreams_.clear();
+
+        if (const auto count {pool_.HitCount() + pool_.MissCount()};
+            count > 0) {
+            WS_LOG_DEBUG(logger_, "{} of {} clients reused pooled connections",
+                         pool_.HitCount(), count);
+        }
+
+        pool_.Clear();
+
+        const std::lock_guard locker {mtx_};
+        to_be_closed_.clear();
+        to_be_resumed_.clear();
+    }
+
+    //! Wake up the event loop if it is waiting for events.
+    void Wake() noexcept {
+        const std::uint64_t count {1};
+        write(waker_, &count, sizeof(count));
+    }
+
+    //! A wake-up event is triggered.
+    void OnWakeEvent() {
+        std::uint64_t count {0};
+        read(waker_, &count, sizeof(count));
+
+        decltype(to_be_closed_) clients;
+        decltype(to_be_resumed_) resumed;
+        {
+            const std::lock_guard locker {mtx_};
+            clients.swap(to_be_closed_);
+            resumed.swap(to_be_resumed_);
+        }
+
+        for (const auto& client : clients) {
+            // The client may have been closed and replaced by a new one using the same socket.
+            if (users_.Find(client)) {
+                MarkClientAsToBeClosed(client.socket);
+            }
+        }
+
+        for (const auto& [handle, waiter] : resumed) {
+            // A client closed while its task was running has destroyed the coroutine.
+            if (const auto client {users_.Find(handle)};
+                client && !client->coroutine.Done()) {
+                Resume(*client, waiter);
+            }
+        }
+    }
+
+    /**
+     * @brief Request the reactor to resume a coroutine whose offloaded task has finished.
+     *
+     * @details It can be called in any thread.
+     */
+    void RequestResume(const typename Clients::Handle client,
+                       const std::coroutine_handle<> waiter) noexcept {
+        {
+            const std::lock_guard locker {mtx_};
+            to_be_resumed_.emplace_back(client, waiter);
+        }
+
+        Wake();
+    }
+
+    /**
+     * @brief An awaitable running a blocking function of a client in the I/O executor.
+     *
+     * @details
+     * The coroutine is suspended while the function runs,
+     * and resumed in the reactor's thread after the reactor is woken up.
+     * The client's task count keeps the reactor from releasing it until the function returns.
+     */
+    template <typename Func>
+    class Offload {
+    public:
+        explicit Offload(Reactor& reactor, Client& client,
+                         const typename Clients::Handle handle,
+                         Func func) noexcept :
+            reactor_ {reactor},
+            client_ {client},
+            handle_ {handle},
+            func_ {std::move(func)} {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(const std::coroutine_handle<> waiter) noexcept {
+            waiter_ = waiter;
+            client_.task_count.fetch_add(1, std::memory_order_relaxed);
+            reactor_.io_executor_->Push([this]() noexcept { Run(); });
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        void Run() noexcept {
+            func_();
+
+            // The awaitable is destroyed with the coroutine once the client can be released, so it must not be used after this.
+            auto& reactor {reactor_};
+            const auto handle {handle_};
+            const auto waiter {waiter_};
+            client_.task_count.fetch_sub(1, std::memory_order_release);
+            reactor.RequestResume(handle, waiter);
+        }
+
+        Reactor& reactor_;
+        Client& client_;
+        typename Clients::Handle handle_;
+        Func func_;
+        std::coroutine_handle<> waiter_;
+    };
+
+    /**
+     * @brief Accept new connections.
+     *
+     * @details
+     * At most @p ListenerOptions::accept_budget connections are accepted.
+     * If there may be more, the next iteration of the event loop will continue accepting without waiting for a listen event,
+     * as the listener is edge-triggered.
+     * If the reactor reaches its connection limit, accepting is paused until a client disconnects.
+     */
+    void OnListenEvent() {
+        accept_pending_ = false;
+        try {
+            for (std::size_t i {0}; i != listener_options_.accept_budget;
+                 ++i) {
+                if (ConnectionsFull()) {
+                    PauseAccepting();
+                    return;
+                }
+
+                typename IPAddr::RawType addr {};
+                socklen_t size {sizeof(addr)};
+                if (const auto new_socket {
+                        accept4(listener_, reinterpret_cast<sockaddr*>(&addr),
+                                &size, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+                    IsValidFileDescriptor(new_socket)) {
+                    AddClient(new_socket, std::move(addr));
+                } else {
+                    ThrowLastSystemError();
+                }
+            }
+
+            accept_pending_ = true;
+        } catch (const std::system_error& err) {
+            if (err.code() != std::errc::resource_unavailable_try_again) {
+                WS_LOG_ERROR(logger_, "Failed to accept a new client: {}",
+                             err.what());
+                throw;
+            }
+        }
+    }
+
+    //! Whether the reactor has reached its connection limit.
+    bool ConnectionsFull() const noexcept {
+        return admission_options_.max_connections > 0
+               && users_.Size() >= admission_options_.max_connections;
+    }
+
+    /**
+     * @brief Stop waiting for new connections by removing the listener from the poller.
+     *
+     * @details The kernel keeps queueing new connections in the listen backlog.
+     */
+    void PauseAccepting() {
+        if (accept_paused_) {
+            return;
+        }
+
+        poller_->DeleteFileDescriptor(listener_);
+        accept_paused_ = true;
+
+        static auto& pauses {metrics::DefaultRegistry().AddCounter(
+            "ws_accept_pauses_total",
+            "The number of times accepting is paused by the connection limit")};
+        pauses.Increase();
+        WS_LOG_WARN(logger_,
+                    "Accepting is paused as {} clients have connected",
+                    users_.Size());
+    }
+
+    /**
+     * @brief Resume accepting new connections if accepting has been paused and the reactor is below its connection limit.
+     *
+     * @details
+     * Connections queued while accepting was paused are accepted in the next iteration of the event loop,
+     * as the edge-triggered listener may not report them again.
+     */
+    void ResumeAccepting() noexcept {
+        if (!accept_paused_ || ConnectionsFull()) {
+            return;
+        }
+
+        try {
+            poller_->AddFileDescriptor(listener_, listen_event_mode | EPOLLIN);
+            accept_paused_ = false;
+            accept_pending_ = true;
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to resume accepting: {}",
+                         err.what());
+        }
+    }
+
+    //! Whether the thread pool's queue is too long to admit a client with new requests.
+    bool QueueFull() const noexcept {
+        return thread_pool_ && admission_options_.max_queued_tasks > 0
+               && queued_count_ + pending_tasks_.size()
+                      >= admission_options_.max_queued_tasks;
+    }
+
+    //! Whether a client with new requests waited too long in the thread pool.
+    bool QueuedTooLong(const Client& client) const noexcept {
+        return admission_options_.max_queue_time > Clock::duration::zero()
+               && Clock::now() - client.dispatched
+                      > admission_options_.max_queue_time;
+    }
+
+    /**
+     * @brief Reject a client because the reactor is overloaded.
+     *
+     * @param reason A reason counted in metrics, which must be a string literal.
+     * @return Whether the client should stay connected, which is always @p false.
+     */
+    bool Shed(http::Connection<IPAddr>& client,
+              const std::string_view reason) noexcept {
+        metrics::CachedCounter("ws_shed_total",
+                               "The number of clients shed by reason", "reason",
+                               reason)
+            .Increase();
+        try {
+            WS_LOG_DEBUG(logger_, "Client {} is shed by {} limit",
+                         client.IPAddress(), reason);
+            if (client.Reject()) {
+                client.Send();
+            }
+        } catch (const std::exception& err) {
+            WS_LOG_DEBUG(logger_, "Failed to reject client {}: {}",
+                         client.IPAddress(), err.what());
+        }
+
+        return false;
+    }
+
+    //! A close event is triggered.
+    void OnCloseEvent(const FileDescriptor socket) noexcept {
+        MarkClientAsToBeClosed(socket);
+    }
+
+    //! A receive event is triggered.
+    void OnReceiveEvent(const FileDescriptor socket) {
+        if (!ExtendClientAliveTime(socket)) {
+            return;
+        }
+
+        if (QueueFull()) {
+            auto& client {Conn(socket)};
+            if (client.task_count.load(std::memory_order_acquire) == 0) {
+                // Shed the client in the reactor's thread without receiving its requests.
+                Shed(client.conn, "queue");
+                MarkClientAsToBeClosed(socket);
+                return;
+            }
+        }
+
+        Dispatch(socket, &Reactor::ReceiveFrom);
+    }
+
+    //! A send event is triggered.
+    void OnSendEvent(const FileDescriptor socket) {
+        if (ExtendClientAliveTime(socket)) {
+            Dispatch(socket, &Reactor::SendTo);
+        }
+    }
+
+    //! Dispatch a client to a processing method.
+    void Dispatch(const FileDescriptor socket,
+                  bool (Reactor::*const proc)(http::Connection<IPAddr>&)) {
+        // `SendTo` is overloaded for coroutines.
+        Dispatch(MakeTask(socket, proc),
+                 proc == static_cast<decltype(proc)>(&Reactor::SendTo));
+    }
+
+    /**
+     * @brief Create a task processing a client.
+     *
+     * @details
+     * The task refers to the client without owning it.
+     * The client's task count keeps the reactor from releasing it until the task finishes.
+     *
+     * @param proc A processing method returning whether the client should stay connected.
+     */
+    Executor::Task MakeTask(
+        const FileDescriptor socket,
+        bool (Reactor::*const proc)(http::Connection<IPAddr>&)) {
+        auto& client {Conn(socket)};
+        client.task_count.fetch_add(1, std::memory_order_relaxed);
+        if (thread_pool_
+            && admission_options_.max_queue_time > Clock::duration::zero()) {
+            client.dispatched = Clock::now();
+        }
+
+        WS_TRACE_ENQUEUE(client.conn.Trace());
+        return [this, &client, handle {users_.GetHandle(socket)},
+                proc]() noexcept {
+            WS_TRACE_DEQUEUE(client.conn.Trace());
+            // Only tasks processing new requests are shed by their queuing time.
+            const auto requests {proc == &Reactor::ReceiveFrom
+                                 || proc == &Reactor::ProcessRequests};
+            const auto alive {requests && thread_pool_ && QueuedTooLong(client)
+                                  ? Shed(client.conn, "queue_time")
+                                  : (this->*proc)(client.conn)};
+
+            // The client must not be used after this, as the reactor may release it.
+            client.task_count.fetch_sub(1, std::memory_order_release);
+            if (!alive) {
+                RequestClientClose(handle);
+            }
+        };
+    }
+
+    /**
+     * @brief Process a client in the current thread if there is no thread pool.
+     *
+     * @details
+     * Otherwise, the task is collected and will be dispatched with other tasks of the same wait.
+     *
+     * @param send Whether the task resumes sending responses, which is cheap enough to run in the reactor's thread.
+     */
+    void Dispatch(Executor::Task task, const bool send) {
+        if (thread_pool_) {
+            pending_tasks_.push_back(std::move(task));
+            pending_send_count_ += send;
+        } else {
+            task();
+        }
+    }
+
+    /**
+     * @brief Dispatch collected tasks.
+     *
+     * @details
+     * If there are only a few tasks and all of them resume sending responses,
+     * they are processed in the reactor's thread, saving the cost of waking up working threads.
+     * Otherwise, they are pushed into the thread pool as a single batch,
+     * so parsing requests and building responses never stall other clients of the reactor.
+     */
+    void DispatchPendingTasks() noexcept {
+        if (pending_tasks_.empty()) {
+            return;
+        }
+
+        assert(thread_pool_);
+        if (pending_tasks_.size() <= max_inline_task_count
+            && pending_send_count_ == pending_tasks_.size()) {
+            // Sends may collect new tasks processing buffered requests.
+            std::swap(pending_tasks_, inline_tasks_);
+            pending_send_count_ = 0;
+            for (auto& task : inline_tasks_) {
+                task();
+            }
+
+            inline_tasks_.clear();
+            if (pending_tasks_.empty()) {
+                return;
+            }
+        }
+
+        thread_pool_->PushBatch(pending_tasks_);
+        pending_tasks_.clear();
+        pending_send_count_ = 0;
+    }
+
+    /**
+     * @brief Extend a socket's alive time.
+     *
+     * @return @p true if the corresponding client is still valid, otherwise @p false.
+     *
+     * @warning This method can only be called in the reactor's thread.
+     */
+    bool ExtendClientAliveTime(const FileDescriptor socket) {
+        assert(IsValidFileDescriptor(socket));
+        if (timer_.Contain(socket)) {
+            timer_.Adjust(socket, alive_time_);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Mark a client as needing to be closed.
+     *
+     * @details
+     * This method makes a client's alive time zero,
+     * so it will be removed in the next event loop.
+     *
+     * @warning This method can only be called in the reactor's thread.
+     */
+    void MarkClientAsToBeClosed(const FileDescriptor socket) noexcept {
+        assert(IsValidFileDescriptor(socket));
+        assert(timer_.Contain(socket));
+        timer_.Adjust(socket, Clock::duration::zero());
+    }
+
+    /**
+     * @brief Request the reactor to close a client.
+     *
+     * @note
+     * Clients should only be added and removed in the reactor's thread.
+     * If the client is being processed in a working thread,
+     * it will be queued and the reactor will be woken up to close it.
+     */
+    void RequestClientClose(const typename Clients::Handle client) noexcept {
+        if (std::this_thread::get_id() != loop_thread_) {
+            {
+                const std::lock_guard locker {mtx_};
+                to_be_closed_.push_back(client);
+            }
+
+            Wake();
+        } else {
+            MarkClientAsToBeClosed(client.socket);
+        }
+    }
+
+    //! Add a client.
+    void AddClient(const FileDescriptor socket, typename IPAddr::RawType addr) {
+        assert(IsValidFileDescriptor(socket));
+
+        // The socket has been set as non-blocking by `accept4`.
+        poller_->AddFileDescriptor(
+            socket,
+            (coroutines_ ? coroutine_event_mode : connect_event_mode) | EPOLLIN);
+
+        users_.Insert(socket, pool_.Acquire(socket, IPAddr {std::move(addr)}));
+        timer_.Push(socket, alive_time_,
+                    [this](const auto socket) { OnTimeOut(socket); });
+
+        auto& client {Conn(socket)};
+        WS_LOG_INFO(logger_, "A new client {} has connected on socket {}",
+                    client.conn.IPAddress(), socket);
+
+        if (coroutines_) {
+            // The coroutine runs until it waits for the first receive event.
+            client.coroutine = Serve(client, users_.GetHandle(socket));
+            client.coroutine.Start();
+        }
+    }
+
+    //! A client's timer expires.
+    void OnTimeOut(const FileDescriptor socket) noexcept {
+        // Pair with the release in a finished task, so its changes to the client are visible before releasing.
+        if (Conn(socket).task_count.load(std::memory_order_acquire) > 0) {
+            // The client is being processed in a working thread, check it again later.
+            timer_.Push(socket, alive_time_,
+                        [this](const auto socket) { OnTimeOut(socket); });
+            return;
+        }
+
+        WS_LOG_INFO(logger_, "Client {} has timed-out",
+                    Conn(socket).conn.IPAddress());
+        CloseClient(socket);
+    }
+
+    //! Close a client.
+    void CloseClient(const FileDescriptor socket) noexcept {
+        assert(IsValidFileDescriptor(socket));
+
+        try {
+            poller_->DeleteFileDescriptor(socket);
+        } catch (const std::exception& err) {
+            WS_LOG_DEBUG(logger_, "Failed to delete socket {} from poller: {}",
+                         socket, err.what());
+        }
+
+        timer_.Remove(socket);
+        WS_LOG_INFO(logger_, "Client {} has disconnected",
+                    Conn(socket).conn.IPAddress());
+
+        // Close the socket now, as a pooled client keeps its old socket until it is reused.
+        // A suspended coroutine is destroyed along with the tasks it is awaiting.
+        auto client {users_.Extract(socket)};
+        client->coroutine = {};
+        client->conn.Close();
+        pool_.Release(std::move(client));
+        ResumeAccepting();
+    }
+
+    /**
+     * @brief Receive data from a client.
+     *
+     * @return Whether the client should stay connected.
+     */
+    bool ReceiveFrom(http::Connection<IPAddr>& client) noexcept {
+        try {
+            WS_LOG_INFO(logger_, "Start to receive data from client {}",
+                        client.IPAddress());
+            client.Receive();
+            return Process(client);
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to receive data from client {}: {}",
+                         client.IPAddress(), err.what());
+            return false;
+        }
+    }
+
+    /**
+     * @brief Send data to a client.
+     *
+     * @return Whether the client should stay connected.
+     */
+    bool SendTo(http::Connection<IPAddr>& client) noexcept {
+        try {
+            WS_LOG_INFO(logger_, "Start to send data to client {}",
+                        client.IPAddress());
+            client.Send();
+            if (client.ToSendSize() > 0) {
+                // The socket cannot accept more data for now, wait for the next send event.
+                poller_->ModifyFileDescriptor(client.Socket(),
+                                              connect_event_mode | EPOLLOUT);
+                return true;
+            } else if (!client.KeepAlive()) {
+                return false;
+            }
+
+            if (thread_pool_ && std::this_thread::get_id() == loop_thread_) {
+                if (!client.HasReceivedData()) {
+                    // There is no request to process, so only a receive event is registered.
+                    poller_->ModifyFileDescriptor(client.Socket(),
+                                                  connect_event_mode | EPOLLIN);
+                    return true;
+                } else if (QueueFull()) {
+                    return Shed(client, "queue");
+                }
+
+                // A send resumed in the reactor's thread hands the rest requests over to the thread pool,
+                // along with other tasks of the same wait.
+                Dispatch(MakeTask(client.Socket(), &Reactor::ProcessRequests),
+                         false);
+                return true;
+            }
+
+            // Continue to process the rest requests and receive data if the client keeps alive.
+            return Process(client);
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to send data to client {}: {}",
+                         client.IPAddress(), err.what());
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Process a client's buffered requests after its previous responses have been sent.
+     *
+     * @return Whether the client should stay connected.
+     */
+    bool ProcessRequests(http::Connection<IPAddr>& client) noexcept {
+        try {
+            return Process(client);
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to process requests of client {}: {}",
+                         client.IPAddress(), err.what());
+            return false;
+        }
+    }
+
+    /**
+     * @brief Process a client's requests and send the responses.
+     *
+     * @return Whether the client should stay connected.
+     */
+    bool Process(http::Connection<IPAddr>& client) {
+        while (client.Process()) {
+            // Send responses right away instead of re-arming the socket for a send event,
+            // as the socket is usually writable.
+            client.Send();
+            if (client.ToSendSize() > 0) {
+                // The socket cannot accept more data for now, wait for the next send event.
+                poller_->ModifyFileDescriptor(client.Socket(),
+                                              connect_event_mode | EPOLLOUT);
+                return true;
+            }
+
+            if (!client.KeepAlive()) {
+                return false;
+            }
+        }
+
+        // The client's reading buffer has no complete request, register a receive event.
+        poller_->ModifyFileDescriptor(client.Socket(),
+                                      connect_event_mode | EPOLLIN);
+        return true;
+    }
+
+    //! An event of a client served by a coroutine is triggered.
+    void OnReadinessEvent(const FileDescriptor socket,
+                          const std::uint32_t events) {
+        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            OnCloseEvent(socket);
+            return;
+        }
+
+        // A finished coroutine's client is waiting to be closed, and its events must not extend its alive time.
+        if (const auto client {users_.Find(socket)};
+            client && !client->coroutine.Done()) {
+            ExtendClientAliveTime(socket);
+            Resume(*client, client->readiness.Notify(events));
+        }
+    }
+
+    /**
+     * @brief Resume a client's coroutine.
+     *
+     * @param waiter
+     * The handle of the coroutine or a task it is awaiting, which is waiting for its socket.
+     * If it is @p nullptr, nothing is resumed.
+     */
+    void Resume(Client& client, const std::coroutine_handle<> waiter) {
+        if (waiter) {
+            waiter.resume();
+            if (client.coroutine.Done()) {
+                MarkClientAsToBeClosed(client.conn.Socket());
+            }
+        }
+    }
+
+    /**
+     * @brief Resume coroutines that yielded with data left in their sockets.
+     *
+     * @details Coroutines yielding again are resumed in the next iteration of the event loop.
+     */
+    void ResumeYieldedClients() {
+        if (yielded_.empty()) {
+            return;
+        }
+
+        resuming_.swap(yielded_);
+        for (const auto& handle : resuming_) {
+            // The client may have been closed and replaced by a new one using the same socket.
+            if (const auto client {users_.Find(handle)};
+                client && !client->coroutine.Done()) {
+                Resume(*client, client->readiness.Notify(EPOLLIN));
+            }
+        }
+
+        resuming_.clear();
+    }
+
+    /**
+     * @brief Serve a client until it disconnects.
+     *
+     * @details
+     * The coroutine waits for its socket to be readable, receives and processes requests and sends their responses.
+     * Requests routed to upstream servers are forwarded in order with the others.
+     * Responses that may block on the disk are built by the I/O executor.
+     * If reading stopped at the high-water mark, the coroutine yields to other clients before receiving the rest.
+     * It finishes when the client should be closed.
+     */
+    coro::Task<> Serve(Client& client, const typename Clients::Handle handle) {
+        auto& conn {client.conn};
+        try {
+            while (true) {
+                co_await client.readiness.Readable();
+                WS_LOG_INFO(logger_, "Start to receive data from client {}",
+                            conn.IPAddress());
+                conn.Receive();
+                const auto drained {conn.Drained()};
+                client.readiness.ClearReadable();
+
+                while (true) {
+                    while (conn.Process()) {
+                        co_await SendTo(client);
+                        if (!conn.KeepAlive()) {
+                            co_return;
+                        }
+                    }
+
+                    // Processing stops at a request routed to an upstream server or needing the disk.
+                    if (conn.ProxiedUpstream()) {
+                        co_await Proxy(client, handle);
+                        if (!conn.KeepAlive()) {
+                            co_return;
+                        }
+                    } else if (conn.DiskPending()) {
+                        // Opening and reading files may block, so they are left to the I/O executor.
+                        co_await Offload {*this, client, handle, [&conn]() noexcept {
+                                              conn.BuildDiskResponse();
+                                          }};
+                    } else {
+                        break;
+                    }
+                }
+
+                if (!drained) {
+                    // No receive event will be triggered for the data left in the socket.
+                    yielded_.push_back(handle);
+                }
+            }
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to serve client {}: {}",
+                         conn.IPAddress(), err.what());
+        }
+    }
+
+    /**
+     * @brief Send all responses to a client served by a coroutine.
+     *
+     * @details
+     * If the socket cannot accept more data, the client's registration is modified to include send events until sending finishes.
+     * Send events are not registered all the time, as a multi-shot @p io_uring poll would report every time the socket's buffer is freed.
+     */
+    coro::Task<> SendTo(Client& client) {
+        auto& conn {client.conn};
+        conn.Send();
+        if (conn.ToSendSize() == 0) {
+            co_return;
+        }
+
+        const auto socket {conn.Socket()};
+        poller_->ModifyFileDescriptor(socket, coroutine_event_mode | EPOLLIN
+                                                  | EPOLLOUT);
+        do {
+            client.readiness.ClearWritable();
+            co_await client.readiness.Writable();
+            WS_LOG_INFO(logger_, "Start to send data to client {}",
+                        conn.IPAddress());
+            conn.Send();
+        } while (conn.ToSendSize() > 0);
+
+        poller_->ModifyFileDescriptor(socket, coroutine_event_mode | EPOLLIN);
+    }
+
+    /**
+     * @brief Forward the request that a client's processing has stopped at to its upstream server.
+     *
+     * @details
+     * An idle connection to the server is reused if there is one, otherwise a new one is connected.
+     * The response is forwarded to the client as it arrives.
+     * The client's responses are sent before more data is received, so a slow client slows down its upstream connection instead of growing its buffer.
+     * If the response is complete and the connection is clean, the connection goes back to the pool.
+     *
+     * A reused connection may have been closed by the server before it receives the request.
+     * If it fails before any response and the request is idempotent, it is retried once over a new connection.
+     * A request failing before its response is answered with @p 502 Bad Gateway.
+     */
+    coro::Task<> Proxy(Client& client, const typename Clients::Handle handle) {
+        auto& conn {client.conn};
+        const auto idx {conn.ProxiedUpstream().value()};
+        const auto request {conn.StartProxy(conn.IPAddress())};
+
+        // A connection is closed with the coroutine if the client is closed during forwarding.
+        Upstream* up {nullptr};
+        const RAII raii {std::ref(up), [this](Upstream*& up) noexcept {
+                             if (up) {
+                                 CloseUpstream(*std::exchange(up, nullptr));
+                             }
+                         }};
+
+        auto succeeded {false};
+        for (auto retry {Idempotent(request)};; retry = false) {
+            up = TakeIdleUpstream(idx, handle);
+            const auto reused {up != nullptr};
+            auto responded {false};
+            try {
+                if (!reused) {
+                    up = &AddUpstream(idx, handle);
+                    co_await Connect(*up);
+                }
+
+                co_await Exchange(client, *up, request, responded);
+                succeeded = true;
+            } catch (const std::exception& err) {
+                WS_LOG_ERROR(logger_,
+                             "Failed to forward a request of client {} to "
+                             "upstream server {}: {}",
+                             conn.IPAddress(),
+                             http::ConnectionImpl::GetRoutes()
+                                 .Upstream(idx)
+                                 .IPAddress(),
+                             err.what());
+                if (reused && retry && !responded) {
+                    CloseUpstream(*std::exchange(up, nullptr));
+                    continue;
+                }
+            }
+
+            break;
+        }
+
+        if (conn.FinishProxy(succeeded) && up && Clean(*up)) {
+            ReleaseUpstream(*std::exchange(up, nullptr));
+        } else if (up) {
+            CloseUpstream(*std::exchange(up, nullptr));
+        }
+
+        // Send the rest of the response or the error response.
+        co_await SendTo(client);
+    }
+
+    /**
+     * @brief Send a request to an upstream server and forward its response to the client.
+     *
+     * @param[out] responded Whether any data has been received from the server.
+     *
+     * @exception std::system_error Failed to send or receive data.
+     * @exception std::invalid_argument The response is malformed or incomplete.
+     */
+    coro::Task<> Exchange(Client& client, Upstream& up,
+                          std::span<const std::byte> request,
+                          bool& responded) {
+        auto& conn {client.conn};
+        io::FileDescriptor io {up.socket, up.socket};
+
+        auto writing {false};
+        while (!request.empty()) {
+            try {
+                const std::array segments {request};
+                request = request.subspan(io.Write(segments));
+            } catch (const std::system_error& err) {
+                if (err.code() != std::errc::resource_unavailable_try_again) {
+                    throw;
+                }
+
+                up.readiness.ClearWritable();
+                if (!writing) {
+                    poller_->ModifyFileDescriptor(
+                        up.socket, coroutine_event_mode | EPOLLIN | EPOLLOUT);
+                    writing = true;
+                }
+            }
+
+            if (!request.empty()) {
+                co_await up.readiness.Writable();
+            }
+        }
+
+        if (writing) {
+            poller_->ModifyFileDescriptor(up.socket,
+                                          coroutine_event_mode | EPOLLIN);
+        }
+
+        for (auto done {false}; !done;) {
+            co_await up.readiness.Readable();
+            auto closed {false};
+            try {
+                closed = io.WriteTo(up.buf) == 0;
+            } catch (const std::system_error& err) {
+                if (err.code() != std::errc::resource_unavailable_try_again) {
+                    throw;
+                }
+
+                up.readiness.ClearReadable();
+                continue;
+            }
+
+            responded = responded || !closed;
+            done = conn.ForwardProxyResponse(up.buf, closed);
+            co_await SendTo(client);
+        }
+    }
+
+    /**
+     * @brief Connect a new upstream connection.
+     *
+     * @details The socket is registered for send events until the connection is established.
+     *
+     * @exception std::system_error Failed to connect.
+     */
+    coro::Task<> Connect(Upstream& up) {
+        const int enable {1};
+        if (setsockopt(up.socket, IPPROTO_TCP, TCP_NODELAY, &enable,
+                       sizeof(enable))
+            < 0) {
+            ThrowLastSystemError();
+        }
+
+        const auto& addr {http::ConnectionImpl::GetRoutes().Upstream(up.idx)};
+        if (connect(up.socket, addr.Raw(), addr.Size()) < 0
+            && errno != EINPROGRESS) {
+            ThrowLastSystemError();
+        }
+
+        // An unconnected socket is reported as hung up, so it is registered after connecting.
+        poller_->AddFileDescriptor(up.socket, coroutine_event_mode | EPOLLIN
+                                                  | EPOLLOUT);
+        co_await up.readiness.Writable();
+
+        int error {0};
+        socklen_t size {sizeof(error)};
+        if (getsockopt(up.socket, SOL_SOCKET, SO_ERROR, &error, &size) < 0) {
+            ThrowLastSystemError();
+        } else if (error != 0) {
+            throw std::system_error {error, std::system_category()};
+        }
+
+        poller_->ModifyFileDescriptor(up.socket,
+                                      coroutine_event_mode | EPOLLIN);
+    }
+
+    //! Create an upstream connection for a client.
+    Upstream& AddUpstream(const std::size_t idx,
+                          const typename Clients::Handle client) {
+        const auto family {
+            http::ConnectionImpl::GetRoutes().Upstream(idx).Version()};
+        const auto socket {
+            ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+        if (!IsValidFileDescriptor(socket)) {
+            ThrowLastSystemError();
+        }
+
+        auto& up {
+            upstreams_.Insert(socket, std::make_unique<Upstream>(socket, idx))};
+        up.client = client;
+        return up;
+    }
+
+    /**
+     * @brief Take an idle connection to an upstream server from the pool.
+     *
+     * @return The connection, or @p nullptr if there is no idle one.
+     */
+    Upstream* TakeIdleUpstream(const std::size_t idx,
+                               const typename Clients::Handle client) {
+        if (idle_upstreams_.size() <= idx || idle_upstreams_[idx].empty()) {
+            return nullptr;
+        }
+
+        auto& idle {idle_upstreams_[idx]};
+        const auto up {upstreams_.Find(idle.back())};
+        idle.pop_back();
+        assert(up && !up->client);
+        up->client = client;
+        return up;
+    }
+
+    /**
+     * @brief Return a connection to the pool of its upstream server.
+     *
+     * @details It is closed if the pool is full.
+     */
+    void ReleaseUpstream(Upstream& up) noexcept {
+        if (idle_upstreams_.size() <= up.idx) {
+            idle_upstreams_.resize(
+                http::ConnectionImpl::GetRoutes().UpstreamCount());
+        }
+
+        auto& idle {idle_upstreams_[up.idx]};
+        if (idle.size() == max_idle_upstream_count) {
+            CloseUpstream(up);
+            return;
+        }
+
+        // An idle connection holds no chunks.
+        up.buf.Shrink();
+        up.client.reset();
+        idle.push_back(up.socket);
+    }
+
+    //! Close an upstream connection.
+    void CloseUpstream(Upstream& up) noexcept {
+        try {
+            poller_->DeleteFileDescriptor(up.socket);
+        } catch (const std::exception& err) {
+            WS_LOG_DEBUG(logger_, "Failed to delete socket {} from poller: {}",
+                         up.socket, err.what());
+        }
+
+        if (!up.client && up.idx < idle_upstreams_.size()) {
+            std::erase(idle_upstreams_[up.idx], up.socket);
+        }
+
+        upstreams_.Erase(up.socket);
+    }
+
+    /**
+     * @brief Check whether a connection whose response has been forwarded can be reused.
+     *
+     * @details
+     * It must have no data left, and the server must not have closed it.
+     * Its socket is marked as not readable, so the next request waits for a receive event.
+     */
+    static bool Clean(Upstream& up) noexcept {
+        if (up.buf.ReadableSize() > 0) {
+            return false;
+        }
+
+        std::byte byte {};
+        if (recv(up.socket, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT) >= 0
+            || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return false;
+        }
+
+        up.readiness.ClearReadable();
+        return true;
+    }
+
+    //! Whether a serialized request can be retried without changing the upstream server's state.
+    static bool Idempotent(const std::span<const std::byte> request) noexcept {
+        static constexpr std::array<std::string_view, 6> methods {
+            "GET ", "HEAD ", "PUT ", "DELETE ", "OPTIONS ", "TRACE "};
+        const std::string_view str {
+            reinterpret_cast<const char*>(request.data()), request.size()};
+        return std::ranges::any_of(methods, [str](const auto method) noexcept {
+            return str.starts_with(method);
+        });
+    }
+
+    //! An event of an upstream connection is triggered.
+    void OnUpstreamEvent(const FileDescriptor socket,
+                         const std::uint32_t events) {
+        auto& up {*upstreams_.Find(socket)};
+        if (!up.client) {
+            // An idle connection is expected to have no data, so it has been closed by the server.
+            if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                CloseUpstream(up);
+            }
+
+            return;
+        }
+
+        // Errors are reported to the waiting coroutine by its next operation.
+        const auto ready {events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)
+                              ? static_cast<std::uint32_t>(EPOLLIN | EPOLLOUT)
+                              : events};
+        if (const auto client {users_.Find(up.client.value())};
+            client && !client->coroutine.Done()) {
+            // Waiting for a slow upstream server does not time out its client.
+            ExtendClientAliveTime(client->conn.Socket());
+            Resume(*client, up.readiness.Notify(ready));
+        }
+    }
+
+    /**
+     * @brief Get the client by a socket.
+     *
+     * @warning This method can only be called in the reactor's thread.
+     */
+    Client& Conn(const FileDescriptor socket) noexcept {
+        const auto client {users_.Find(socket)};
+        assert(client);
+        return *client;
+    }
+
+    std::uint16_t port_;
+    Clock::duration alive_time_;
+    Executor* thread_pool_;
+    bool reuse_port_;
+    ListenerOptions listener_options_;
+    AdmissionOptions admission_options_;
+
+    //! Whether clients are served by coroutines.
+    bool coroutines_;
+
+    //! The executor building responses that may block on the disk, if clients are served by coroutines.
+    Executor* io_executor_;
+
+    std::atomic_bool closed_ {false};
+
+    //! Whether the listener may have connections left to accept.
+    bool accept_pending_ {false};
+
+    //! Whether the listener has been removed from the poller by the connection limit.
+    bool accept_paused_ {false};
+
+    //! The number of tasks queued in the thread pool when the current wait returned.
+    std::size_t queued_count_ {0};
+
+    //! The thread running the event loop.
+    std::thread::id loop_thread_;
+
+    FileDescriptor listener_ {invalid_file_descriptor};
+
+    //! An event file descriptor used to wake up the event loop.
+    FileDescriptor waker_ {invalid_file_descriptor};
+
+    Poller::Ptr poller_;
+    TimingWheel<FileDescriptor> timer_;
+    //! Closed clients kept for reuse.
+    ObjectPool<Client> pool_ {max_pooled_client_count};
+
+    Clients users_;
+
+    //! Connections to upstream servers of the reverse proxy.
+    ConnectionTable<Upstream> upstreams_;
+
+    //! Sockets of idle upstream connections, indexed by upstream servers.
+    std::vector<std::vector<FileDescriptor>> idle_upstreams_;
+
+    //! Tasks collected in the current iteration of the event loop, which will be dispatched together.
+    std::vector<Executor::Task> pending_tasks_;
+
+    //! The number of collected tasks resuming sends.
+    std::size_t pending_send_count_ {0};
+
+    //! Collected tasks being processed in the reactor's thread.
+    std::vector<Executor::Task> inline_tasks_;
+
+    //! Clients whose coroutines yielded and will be resumed after events of the current iteration.
+    std::vector<typename Clients::Handle> yielded_;
+
+    //! Clients whose yielded coroutines are being resumed.
+    std::vector<typename Clients::Handle> resuming_;
+
+    //! The lock for clients requested to be closed by working threads.
+    std::mutex mtx_;
+    std::vector<typename Clients::Handle> to_be_closed_;
+
+    //! Coroutines whose offloaded tasks have finished, along with the handles to resume.
+    std::vector<std::pair<typename Clients::Handle, std::coroutine_handle<>>>
+        to_be_resumed_;
+
+    log::Logger::Ptr logger_;
+};
+
+}  // namespace ws
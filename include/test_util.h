@@ -15,6 +15,7 @@
 #include "util.h"
 
 #include <string>
+#include <string_view>
 #include <utility>
 
 
@@ -43,6 +44,52 @@ std::string TestName() noexcept;
  */
 std::pair<FileDescriptor, std::string> CreateTempTestFile();
 
+/**
+ * @brief A unique temporary file for the current test.
+ *
+ * @details The file is closed and removed when the object is destroyed.
+ */
+class TempTestFile {
+public:
+    /**
+     * @brief Create a temporary file.
+     *
+     * @exception std::system_error Failed to create a temporary file.
+     */
+    TempTestFile();
+
+    ~TempTestFile() noexcept;
+
+    TempTestFile(const TempTestFile&) = delete;
+
+    TempTestFile& operator=(const TempTestFile&) = delete;
+
+    //! Get the file descriptor.
+    FileDescriptor Descriptor() const noexcept;
+
+    //! Get the path.
+    const std::string& Path() const noexcept;
+
+    //! Write a string to the file from the beginning, replacing its content.
+    void Rewrite(std::string_view data) const;
+
+private:
+    FileDescriptor fd_;
+    std::string path_;
+};
+
+//! Write a string to a file descriptor from the beginning, replacing its content.
+void Rewrite(FileDescriptor fd, std::string_view data);
+
+/**
+ * @brief Create an unique temporary directory for the current test.
+ *
+ * @return The directory path.
+ *
+ * @exception std::system_error Failed to create a temporary directory.
+ */
+std::string CreateTempTestDirectory();
+
 //! Get a logger for tests.
 log::Logger::Ptr TestLogger() noexcept;
 
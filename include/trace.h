@@ -0,0 +1,230 @@
+/**
+ * @file trace.h
+ * @brief The per-request stage tracing.
+ *
+ * @details
+ * Tracing is only compiled if @p WS_TRACE is non-zero.
+ * Otherwise, tracing macros are compiled into nothing.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-28
+ *
+ * @example tests/trace_test.cpp
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef WS_TRACE
+//! Whether tracing is compiled.
+#define WS_TRACE 0
+#endif
+
+
+namespace ws::trace {
+
+//! Whether tracing is compiled.
+inline constexpr bool enabled {WS_TRACE != 0};
+
+//! Stages of processing a request.
+enum class Stage {
+    //! From dispatching a client to a thread pool to starting its task.
+    Queue = 0,
+    Receive = 1,
+    Parse = 2,
+    Build = 3,
+    Send = 4
+};
+
+//! Convert a stage into a string.
+std::string_view StageToString(Stage stage) noexcept;
+
+/**
+ * @brief Get the current timestamp in ticks.
+ *
+ * @details
+ * On x86 processors, it reads the time stamp counter, which is much cheaper than @p clock_gettime.
+ * Otherwise, it uses the steady clock in nanoseconds.
+ */
+inline std::uint64_t Now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+/**
+ * @brief Convert ticks into nanoseconds.
+ *
+ * @details The tick rate is calibrated against the steady clock when it is first used.
+ */
+double ToNanoseconds(std::uint64_t ticks) noexcept;
+
+//! A stage of a request.
+struct Span {
+    //! The identifier of the request.
+    std::uint64_t request {0};
+    Stage stage {Stage::Queue};
+
+    //! The timestamp when the stage begins, in ticks.
+    std::uint64_t begin {0};
+
+    //! The timestamp when the stage ends, in ticks.
+    std::uint64_t end {0};
+};
+
+/**
+ * @brief The stages of a request being processed.
+ *
+ * @details
+ * Stages are recorded into the trace as they finish.
+ * When the request finishes, its stages are copied into the ring buffer of the current thread.
+ * Pipelined requests whose responses are sent together are traced as one request.
+ *
+ * @warning A trace may be used by different threads, but not at the same time.
+ */
+class RequestTrace {
+public:
+    //! The maximum number of stages recorded for a request. Later stages are counted in the last one.
+    static constexpr std::size_t max_span_count {32};
+
+    //! Mark the time when the client is dispatched to a thread pool.
+    void Enqueue() noexcept;
+
+    //! Record the time from dispatching to now as the queueing stage.
+    void Dequeue() noexcept;
+
+    //! Record a stage.
+    void Record(Stage stage, std::uint64_t begin, std::uint64_t end) noexcept;
+
+    /**
+     * @brief Finish the request.
+     *
+     * @details
+     * Stages are copied into the ring buffer of the current thread.
+     * If the request took longer than the slow threshold, its stages are logged.
+     */
+    void Finish() noexcept;
+
+    //! Set a description of the request, such as its path, to be logged for a slow request.
+    void SetLabel(std::string_view label) noexcept;
+
+    //! Clear recorded stages without finishing the request.
+    void Clear() noexcept;
+
+    //! Get the number of recorded stages.
+    std::size_t Size() const noexcept;
+
+private:
+    std::array<Span, max_span_count> spans_;
+    std::size_t size_ {0};
+    std::uint64_t queued_ {0};
+    std::string label_;
+};
+
+//! The scope recording a stage from its creation to its destruction.
+class Scope {
+public:
+    Scope(RequestTrace& trace, Stage stage) noexcept;
+
+    ~Scope() noexcept;
+
+    Scope(const Scope&) = delete;
+
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    RequestTrace& trace_;
+    Stage stage_;
+    std::uint64_t begin_;
+};
+
+//! The maximum number of stages kept by each thread. Older stages are overwritten.
+inline constexpr std::size_t ring_capacity {0x4000};
+
+/**
+ * @brief Set the threshold above which finished requests are logged with their stages.
+ *
+ * @param threshold A duration. Zero disables logging slow requests.
+ */
+void SetSlowThreshold(std::chrono::nanoseconds threshold) noexcept;
+
+//! Get the threshold above which finished requests are logged.
+std::chrono::nanoseconds GetSlowThreshold() noexcept;
+
+/**
+ * @brief Dump stages kept by all threads in the Chrome trace event format.
+ *
+ * @details
+ * The JSON can be loaded by @p chrome://tracing or @p Perfetto.
+ * Each stage is a complete event whose thread is the one that finished the request.
+ */
+std::string DumpChromeTrace() noexcept;
+
+//! Discard stages kept by all threads.
+void ClearRings() noexcept;
+
+}  // namespace ws::trace
+
+#define WS_TRACE_CONCAT_IMPL(x, y) x##y
+#define WS_TRACE_CONCAT(x, y) WS_TRACE_CONCAT_IMPL(x, y)
+
+#if WS_TRACE
+
+/**
+ * @brief Record a stage from here to the end of the current scope.
+ *
+ * @code {.cpp}
+ * WS_TRACE_SCOPE(trace_, ws::trace::Stage::Parse);
+ * @endcode
+ *
+ * @param request A request trace.
+ * @param stage A stage.
+ */
+#define WS_TRACE_SCOPE(request, stage) \
+    const ::ws::trace::Scope WS_TRACE_CONCAT(ws_trace_scope_, __LINE__) { \
+        request, stage                                                     \
+    }
+
+//! Mark the time when a client is dispatched to a thread pool.
+#define WS_TRACE_ENQUEUE(request) (request).Enqueue()
+
+//! Record the time from dispatching a client to now as the queueing stage.
+#define WS_TRACE_DEQUEUE(request) (request).Dequeue()
+
+//! Set a description of the request.
+#define WS_TRACE_LABEL(request, label) (request).SetLabel(label)
+
+//! Finish a request.
+#define WS_TRACE_FINISH(request) (request).Finish()
+
+//! Clear a request's stages without finishing it.
+#define WS_TRACE_CLEAR(request) (request).Clear()
+
+#else
+
+#define WS_TRACE_SCOPE(request, stage) static_cast<void>(0)
+#define WS_TRACE_ENQUEUE(request) static_cast<void>(0)
+#define WS_TRACE_DEQUEUE(request) static_cast<void>(0)
+#define WS_TRACE_LABEL(request, label) static_cast<void>(0)
+#define WS_TRACE_FINISH(request) static_cast<void>(0)
+#define WS_TRACE_CLEAR(request) static_cast<void>(0)
+
+#endif
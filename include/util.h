@@ -20,13 +20,18 @@
 
 #include <sys/stat.h>
 
+#include <chrono>
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <memory>
+#include <optional>
 #include <regex>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -39,6 +44,32 @@ using FileDescriptor = int;
 //! A constant value representing invalid file descriptors.
 inline constexpr FileDescriptor invalid_file_descriptor {-1};
 
+//! Remove leading and trailing spaces and tabs.
+constexpr std::string_view TrimWhitespace(std::string_view str) noexcept {
+    constexpr std::string_view whitespace {" \t"};
+    const auto begin {str.find_first_not_of(whitespace)};
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+
+    const auto end {str.find_last_not_of(whitespace)};
+    return str.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief A transparent string hash.
+ *
+ * @details
+ * With @p std::equal_to<>, it lets unordered containers with string keys be searched by string views without copying them.
+ */
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(const std::string_view str) const noexcept {
+        return std::hash<std::string_view> {}(str);
+    }
+};
+
 //! Convert a string into lower-case.
 std::string StringToLower(std::string str) noexcept;
 
@@ -68,6 +99,15 @@ YAML::Node LoadYamlString(
     std::string_view str,
     std::initializer_list<std::string_view> required_fields = {});
 
+/**
+ * @brief Convert a @p YAML node into a string.
+ *
+ * @details
+ * A scalar node is converted into its unquoted value,
+ * other nodes are emitted as @p YAML strings.
+ */
+std::string YamlNodeToString(const YAML::Node& node) noexcept;
+
 //! Throw an @p std::invalid_argument exception if a field does not exist in a @p YAML node or it is not scalar.
 void ThrowIfYamlFieldIsNotScalar(const YAML::Node& node,
                                  std::string_view field);
@@ -94,6 +134,33 @@ void SetFileDescriptorAsNonblocking(FileDescriptor fd);
 //! Get the ID of the current thread.
 std::uint32_t CurrentThreadId() noexcept;
 
+/**
+ * @brief Parse a CPU list in the format of @p taskset and @p /sys, such as @p 0-3,8.
+ *
+ * @return CPU numbers in the order of the list. An empty list returns no CPU.
+ *
+ * @exception std::invalid_argument The list is malformed.
+ */
+std::vector<std::size_t> ParseCPUList(std::string_view list);
+
+/**
+ * @brief Restrict a thread to run on a set of CPUs.
+ *
+ * @exception std::system_error Failed to set the affinity, e.g. a CPU does not exist.
+ */
+void SetThreadAffinity(std::thread::native_handle_type thread,
+                       std::span<const std::size_t> cpus);
+
+//! Restrict the current thread to run on a set of CPUs.
+void SetCurrentThreadAffinity(std::span<const std::size_t> cpus);
+
+/**
+ * @brief Get the NUMA node of a CPU.
+ *
+ * @return The node number, or @p std::nullopt if the system does not report NUMA topology.
+ */
+std::optional<std::size_t> NUMANodeOfCPU(std::size_t cpu) noexcept;
+
 /**
  * @brief Get a backtrace for the calling program.
  *
@@ -191,12 +258,97 @@ private:
     Cleaner cleaner_;
 };
 
+//! Get the last modification time from a file status.
+std::chrono::system_clock::time_point ModificationTime(
+    const struct stat& stat) noexcept;
+
+/**
+ * @brief
+ * RAII for a read-only file descriptor.
+ *
+ * @details
+ * It encapsulates @p open, @p fstat and @p close of Linux system.
+ * The file content is not mapped into memory,
+ * so it can be sent by zero-copy system calls like @p sendfile.
+ */
+class ReadOnlyFile {
+public:
+    ReadOnlyFile() noexcept;
+
+    ReadOnlyFile(const ReadOnlyFile&) = delete;
+
+    ReadOnlyFile(ReadOnlyFile&&) noexcept;
+
+    ReadOnlyFile& operator=(const ReadOnlyFile&) = delete;
+
+    ReadOnlyFile& operator=(ReadOnlyFile&&) noexcept;
+
+    ~ReadOnlyFile() noexcept;
+
+    /**
+     * @brief Open a file.
+     *
+     * @exception std::invalid_argument The path refers to a directory.
+     * @exception std::runtime_error No permission to access the file.
+     * @exception std::system_error Failed to open the file.
+     */
+    FileDescriptor Open(std::string path);
+
+    //! Close the file.
+    void Close() noexcept;
+
+    /**
+     * @brief Read the whole file content.
+     *
+     * @exception std::system_error Failed to read the file.
+     * @exception std::runtime_error The file has been truncated.
+     */
+    std::vector<std::byte> ReadAll() const;
+
+    /**
+     * @brief Ask the kernel to read a range of the file into the page cache in the background.
+     *
+     * @details
+     * It issues @p POSIX_FADV_WILLNEED and returns without waiting,
+     * so a later @p sendfile of a cold file is less likely to block on the disk.
+     *
+     * @param offset The start of the range.
+     * @param size The size of the range, which is clamped to the end of the file.
+     */
+    void Prefetch(std::size_t offset, std::size_t size) const noexcept;
+
+    //! Whether the file has been opened.
+    bool Valid() const noexcept;
+
+    //! Get the file size.
+    std::size_t Size() const noexcept;
+
+    //! Get the file descriptor.
+    FileDescriptor Descriptor() const noexcept;
+
+    //! Get the last modification time.
+    std::chrono::system_clock::time_point ModificationTime() const noexcept;
+
+    //! Get the inode number.
+    std::uint64_t Inode() const noexcept;
+
+    //! Get the file path.
+    std::string_view Path() const noexcept;
+
+private:
+    std::string path_;
+    struct stat stat_ {};
+    FileDescriptor fd_ {invalid_file_descriptor};
+};
+
 /**
  * @brief
  * RAII for a read-only file that has been mapped into memory.
  *
  * @details
  * It encapsulates @p stat, @p mmap and @p munmap of Linux system.
+ * The mapping is advised with @p MADV_WILLNEED,
+ * so its pages are read in the background instead of faulting in on their first access.
  */
 class MappedReadOnlyFile {
 public:
@@ -221,6 +373,18 @@ public:
      */
     std::byte* Map(std::string path);
 
+    /**
+     * @brief Map an opened file into memory.
+     *
+     * @details
+     * The mapping is populated at once with @p MAP_POPULATE and advised with @p MADV_SEQUENTIAL,
+     * as it is intended to be shared and sent from the beginning to the end.
+     *
+     * @exception std::invalid_argument The file is empty.
+     * @exception std::system_error Failed to map the file.
+     */
+    std::byte* Map(const ReadOnlyFile& file);
+
     //! Unmap the file.
     void Unmap() noexcept;
 
@@ -12,27 +12,74 @@
 
 #pragma once
 
-#include "containers/epoller.h"
-#include "containers/heap_timer.h"
 #include "containers/thread_pool.h"
+#include "containers/work_stealing_thread_pool.h"
 #include "http.h"
 #include "ip.h"
 #include "log.h"
-#include "util.h"
+#include "reactor.h"
 
-#include <sys/socket.h>
-
-#include <atomic>
 #include <cassert>
+#include <csignal>
 #include <filesystem>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 namespace ws {
 
+/**
+ * @brief The placement of a web server's threads on CPUs.
+ *
+ * @details
+ * Pinned threads are not moved between cores by the scheduler.
+ * Memory is allocated on the NUMA node of the thread that first touches it,
+ * and pooled clients and their buffers are allocated by their reactor,
+ * so a pinned reactor keeps its clients on its own node.
+ */
+struct AffinityOptions {
+    /**
+     * @brief CPUs where reactors run.
+     *
+     * @details
+     * The i-th reactor is pinned to the CPU @p reactors[i % reactors.size()].
+     * The first reactor runs in the thread starting the server, which is pinned as well.
+     * An empty list leaves reactors to the scheduler.
+     */
+    std::vector<std::size_t> reactors;
+
+    //! CPUs where working threads of the thread pool run in the classic mode, in the same way as reactors.
+    std::vector<std::size_t> workers;
+
+    /**
+     * @brief Whether each reactor's listener prefers connections whose packets are processed on the reactor's CPU.
+     *
+     * @details It only works in the multi-reactor mode with pinned reactors.
+     *
+     * @see ListenerOptions::incoming_cpu
+     */
+    bool incoming_cpu {false};
+};
+
+/**
+ * @brief The echo HTTP server.
+ *
+ * @details
+ * The server runs in one of two modes:
+ * - The classic mode has a single reactor dispatching clients to a thread pool,
+ *   which is either a pool with a shared task queue or a work-stealing pool.
+ * - The multi-reactor mode runs multiple reactors processing clients in their own threads.
+ *   Each reactor has a listener bound with @p SO_REUSEPORT to the same port,
+ *   so new connections are distributed by the kernel and no state is shared between reactors.
+ *
+ * With coroutines in the multi-reactor mode, responses that may block on the disk can be built by a shared I/O thread pool,
+ * so a slow disk never stalls reactors.
+ */
 template <ValidIPAddr IPAddr>
 class WebServer {
 public:
@@ -50,6 +97,122 @@ public:
         return http::Connection<IPAddr>::GetRootDirectory();
     }
 
+    /**
+     * @brief Enable the in-memory cache for static assets.
+     *
+     * @param capacity The maximum total size of cached content. Zero disables the cache.
+     * @param revalidation_interval
+     * The minimum interval between two checks of an asset's modification time.
+     * @param compression
+     * Whether to compress cached text assets with gzip when they do not have a precompressed @p .gz sibling.
+     */
+    static void SetAssetCache(const std::size_t capacity,
+                              const Clock::duration revalidation_interval,
+                              const bool compression = false) noexcept {
+        http::Connection<IPAddr>::SetAssetCache(capacity, revalidation_interval,
+                                                compression);
+    }
+
+    /**
+     * @brief Serve static assets from an asset pack built by @p echo-asset-pack.
+     *
+     * @details Files outside the pack are still served from the root directory.
+     *
+     * @param pack The path of an asset pack, or an empty path to disable it.
+     *
+     * @exception std::system_error Failed to map the pack.
+     * @exception std::invalid_argument The pack is malformed.
+     */
+    static void SetAssetPack(const std::filesystem::path& pack) {
+        http::Connection<IPAddr>::SetAssetPack(pack);
+    }
+
+    /**
+     * @brief Set the high-water mark of each client's buffered data.
+     *
+     * @param size The mark in bytes. Zero means using the default mark.
+     */
+    static void SetHighWaterMark(const std::size_t size) noexcept {
+        http::Connection<IPAddr>::SetHighWaterMark(size);
+    }
+
+    /**
+     * @brief Set the maximum number of requests served on each persistent connection.
+     *
+     * @param count A number of requests. Zero means no limit.
+     */
+    static void SetMaxRequestsPerConnection(const std::size_t count) noexcept {
+        http::Connection<IPAddr>::SetMaxRequestsPerConnection(count);
+    }
+
+    /**
+     * @brief Set the maximum size of an incomplete request buffered by each client.
+     *
+     * @param size A size in bytes. Zero means no limit.
+     */
+    static void SetMaxBufferSize(const std::size_t size) noexcept {
+        http::Connection<IPAddr>::SetMaxBufferSize(size);
+    }
+
+    /**
+     * @brief Set limits on the size of each HTTP/1.1 request.
+     *
+     * @details
+     * A request exceeding a limit is rejected with @p 413 or @p 431 and its connection is closed.
+     */
+    static void SetRequestLimits(const http::RequestLimits limits) noexcept {
+        http::Connection<IPAddr>::SetRequestLimits(limits);
+    }
+
+    /**
+     * @brief Terminate TLS on all connections with a certificate chain and its private key in PEM format.
+     *
+     * @exception std::runtime_error TLS is not supported, or failed to load the certificate or the key.
+     */
+    static void SetTLSCertificate(const std::filesystem::path& cert_chain,
+                                  const std::filesystem::path& private_key) {
+        http::Connection<IPAddr>::SetTLSCertificate(cert_chain, private_key);
+    }
+
+    /**
+     * @brief Set the reserved path where metrics are exposed in the Prometheus text format.
+     *
+     * @param path A path. If it is empty, metrics are not exposed.
+     */
+    static void SetMetricsPath(std::string path) noexcept {
+        http::Connection<IPAddr>::SetMetricsPath(std::move(path));
+    }
+
+    /**
+     * @brief Set the reserved path where traced request stages are dumped in the Chrome trace event format.
+     *
+     * @param path A path. If it is empty, traces are not dumped.
+     */
+    static void SetTracePath(std::string path) noexcept {
+        http::Connection<IPAddr>::SetTracePath(std::move(path));
+    }
+
+    /**
+     * @brief Set the threshold above which traced requests are logged with their stages.
+     *
+     * @param threshold A duration. Zero disables logging slow requests.
+     */
+    static void SetSlowRequestThreshold(
+        const std::chrono::nanoseconds threshold) noexcept {
+        trace::SetSlowThreshold(threshold);
+    }
+
+    /**
+     * @brief Set the routing table of the reverse proxy.
+     *
+     * @details
+     * Requests routed to upstream servers are forwarded over connections pooled by each reactor.
+     * It only works in the multi-reactor mode with coroutines.
+     */
+    static void SetRoutes(http::RoutingTable routes) noexcept {
+        http::Connection<IPAddr>::SetRoutes(std::move(routes));
+    }
+
     /**
      * @brief Create a web server.
      *
@@ -58,13 +221,46 @@ public:
      * A maximum alive time for client timers.
      * A client's timer will be refreshed if it sends or receives data.
      * When a client's timer reaches zero, it will disconnect.
+     * @param reactor_count
+     * The number of reactors.
+     * If it is zero, the server will run in the classic mode with a thread pool.
+     * Otherwise, it will run in the multi-reactor mode.
+     * @param work_stealing Whether to use a work-stealing thread pool in the classic mode.
+     * @param poller_options Options of reactors' pollers.
+     * @param listener_options Options of reactors' listeners.
+     * @param affinity The placement of threads on CPUs.
+     * @param admission
+     * Limits on the admitted load.
+     * In the multi-reactor mode, the connection limit is shared evenly among reactors.
+     * @param coroutines Whether clients are served by coroutines in the multi-reactor mode.
+     * @param disk_threads
+     * The number of threads building responses that may block on the disk for coroutines.
+     * If it is zero, they are built by reactors.
      * @param logger
-     * A logger. If it is @p nullptr, the thread pool will use the global root logger.
+     * A logger. If it is @p nullptr, the server will use the global root logger.
      */
     explicit WebServer(const std::uint16_t port,
                        const Clock::duration alive_time,
+                       const std::size_t reactor_count = 0,
+                       const bool work_stealing = false,
+                       Poller::Options poller_options = {},
+                       ListenerOptions listener_options = {},
+                       AffinityOptions affinity = {},
+                       AdmissionOptions admission = {},
+                       const bool coroutines = false,
+                       const std::size_t disk_threads = 0,
                        log::Logger::Ptr logger = log::RootLogger()) noexcept :
-        port_ {port}, alive_time_ {alive_time}, logger_ {std::move(logger)} {
+        port_ {port},
+        alive_time_ {alive_time},
+        reactor_count_ {reactor_count},
+        work_stealing_ {work_stealing},
+        poller_options_ {std::move(poller_options)},
+        listener_options_ {std::move(listener_options)},
+        affinity_ {std::move(affinity)},
+        admission_ {std::move(admission)},
+        coroutines_ {coroutines},
+        disk_threads_ {disk_threads},
+        logger_ {std::move(logger)} {
         if (!logger_) {
             logger_ = log::RootLogger();
         }
@@ -82,330 +278,410 @@ public:
 
     WebServer& operator=(WebServer&&) = delete;
 
-    //! Start the server.
+    /**
+     * @brief Start the server.
+     *
+     * @details
+     * The first reactor runs in the current thread, so this method blocks until the server is closed.
+     *
+     * @exception std::invalid_argument Upstream servers are routed without the multi-reactor mode with coroutines.
+     */
     void Start() {
-        thread_pool_.Start();
-        InitNetwork();
-        while (!closed_) {
-            try {
-                const auto wait_time {timer_.ToNextTick()};
-                const auto event_count {epoller_.Wait(wait_time)};
-                for (auto i {0}; i != event_count; ++i) {
-                    const auto socket {epoller_.FileDescriptor(i)};
-                    const auto events {epoller_.Events(i)};
-                    if (socket == listener_) {
-                        OnListenEvent();
-                    } else {
-                        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                            OnCloseEvent(socket);
-                        } else if (events & EPOLLIN) {
-                            OnReceiveEvent(socket);
-                        } else if (events & EPOLLOUT) {
-                            OnSendEvent(socket);
-                        } else {
-                            throw std::runtime_error {
-                                fmt::format("Unexpected event: {}", events)};
-                        }
+        if (http::Connection<IPAddr>::GetRoutes().UpstreamCount() > 0
+            && (reactor_count_ == 0 || !coroutines_)) {
+            throw std::invalid_argument {
+                "The reverse proxy requires the multi-reactor mode with "
+                "coroutines"};
+        }
+
+        // Writing to a connection reset by its client must fail with `EPIPE` instead of terminating the server.
+        std::signal(SIGPIPE, SIG_IGN);
+
+        // Clients are told how long an idle connection is kept, so they do not reuse a closing one.
+        http::Connection<IPAddr>::SetKeepAliveTimeout(
+            std::chrono::duration_cast<std::chrono::seconds>(alive_time_));
+
+        {
+            const std::lock_guard locker {mtx_};
+            if (reactor_count_ == 0) {
+                http::Connection<IPAddr>::SetDiskOffload(false);
+                if (work_stealing_) {
+                    thread_pool_ = std::make_unique<WorkStealingThreadPool>();
+                } else {
+                    thread_pool_ = std::make_unique<ThreadPool>();
+                }
+
+                thread_pool_->SetAffinity(affinity_.workers);
+                thread_pool_->Start();
+                reactors_.push_back(std::make_unique<Reactor<IPAddr>>(
+                    port_, alive_time_, thread_pool_.get(), false,
+                    poller_options_, listener_options_, admission_, false,
+                    nullptr, logger_));
+            } else {
+                auto admission {admission_};
+                admission.max_connections =
+                    (admission.max_connections + reactor_count_ - 1)
+                    / reactor_count_;
+
+                const auto offload {coroutines_ && disk_threads_ > 0};
+                http::Connection<IPAddr>::SetDiskOffload(offload);
+                if (offload) {
+                    io_pool_ = std::make_unique<ThreadPool>(
+                        disk_threads_, log::RootLogger(), "io");
+                    io_pool_->Start();
+                }
+
+                for (std::size_t i {0}; i != reactor_count_; ++i) {
+                    auto listener_options {listener_options_};
+                    if (const auto cpu {ReactorCPU(i)};
+                        affinity_.incoming_cpu && cpu.has_value()) {
+                        listener_options.incoming_cpu = cpu;
                     }
+
+                    reactors_.push_back(std::make_unique<Reactor<IPAddr>>(
+                        port_, alive_time_, nullptr, true, poller_options_,
+                        listener_options, admission, coroutines_,
+                        io_pool_.get(), logger_));
+                }
+
+                for (std::size_t i {1}; i < reactors_.size(); ++i) {
+                    threads_.emplace_back(&WebServer::RunReactor, this,
+                                          std::ref(*reactors_[i]), i);
                 }
-            } catch (const std::exception& err) {
-                logger_->Log(log::Event::Create(log::Level::Error)
-                             << fmt::format("Exception raised in server: {}",
-                                            err.what()));
             }
         }
+
+        PinReactor(0);
+        reactors_.front()->Start();
     }
 
-    //! Close the server.
+    /**
+     * @brief Close the server.
+     *
+     * @details
+     * It can be called in any thread.
+     * Reactors are released when the server is destroyed.
+     */
     void Close() noexcept {
         const std::lock_guard locker {mtx_};
-        if (IsValidFileDescriptor(listener_)) {
-            close(listener_);
-            listener_ = invalid_file_descriptor;
+        for (const auto& reactor : reactors_) {
+            reactor->Close();
         }
 
-        thread_pool_.Close();
-        epoller_.Close();
-        timer_.Clear();
-        users_.clear();
-    }
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
 
-private:
-    static constexpr auto listen_event_mode {EPOLLRDHUP | EPOLLET};
+        threads_.clear();
+        if (thread_pool_) {
+            thread_pool_->Close();
+        }
 
-    static constexpr auto connect_event_mode {EPOLLONESHOT | EPOLLRDHUP
-                                              | EPOLLET};
+        if (io_pool_) {
+            io_pool_->Close();
+        }
+    }
 
-    void InitNetwork() {
-        assert(port_ >= 1024);
+private:
+    //! Get the CPU where a reactor runs.
+    std::optional<std::size_t> ReactorCPU(const std::size_t idx) const noexcept {
+        const auto& cpus {affinity_.reactors};
+        return cpus.empty() ? std::nullopt
+                            : std::optional {cpus[idx % cpus.size()]};
+    }
 
-        const IPAddr addr {IPAddr::any.data(), port_};
-        const linger opt {.l_onoff = true, .l_linger = 1};
-        listener_ = socket(IPAddr::version, SOCK_STREAM, 0);
-        if (!IsValidFileDescriptor(listener_)) {
-            ThrowLastSystemError();
+    //! Pin the current thread to the CPU of a reactor if the affinity has been set.
+    void PinReactor(const std::size_t idx) noexcept {
+        const auto cpu {ReactorCPU(idx)};
+        if (!cpu.has_value()) {
+            return;
         }
 
-        bool failed {true};
-        const RAII raii {std::ref(listener_),
-                         [&failed](FileDescriptor& socket) {
-                             if (failed) {
-                                 close(socket);
-                                 socket = invalid_file_descriptor;
-                             }
-                         }};
-
-        if (setsockopt(listener_, SOL_SOCKET, SO_LINGER, &opt, sizeof(opt))
-            < 0) {
-            ThrowLastSystemError();
+        try {
+            SetCurrentThreadAffinity({&cpu.value(), 1});
+            const auto node {NUMANodeOfCPU(cpu.value())};
+            WS_LOG_INFO(logger_, "Reactor {} runs on CPU {} (NUMA node {})",
+                        idx, cpu.value(),
+                        node.has_value() ? std::to_string(node.value())
+                                         : std::string {"unknown"});
+        } catch (const std::system_error& err) {
+            WS_LOG_WARN(logger_, "Failed to pin reactor {} to CPU {}: {}", idx,
+                        cpu.value(), err.what());
         }
+    }
 
-        const int enable {1};
-        if (setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &enable,
-                       sizeof(enable))
-            < 0) {
-            ThrowLastSystemError();
+    //! Run a reactor in a background thread.
+    void RunReactor(Reactor<IPAddr>& reactor, const std::size_t idx) noexcept {
+        PinReactor(idx);
+        try {
+            reactor.Start();
+        } catch (const std::exception& err) {
+            WS_LOG_ERROR(logger_, "Failed to start a reactor: {}", err.what());
         }
+    }
 
-        if (bind(listener_, addr.Raw(), addr.Size()) < 0) {
-            ThrowLastSystemError();
-        }
+    std::mutex mtx_;
 
-        if (listen(listener_, SOMAXCONN) < 0) {
-            ThrowLastSystemError();
-        }
+    std::uint16_t port_;
+    Clock::duration alive_time_;
+    std::size_t reactor_count_;
+    bool work_stealing_;
+    Poller::Options poller_options_;
+    ListenerOptions listener_options_;
+    AffinityOptions affinity_;
+    AdmissionOptions admission_;
+    bool coroutines_;
+    std::size_t disk_threads_;
 
-        SetFileDescriptorAsNonblocking(listener_);
-        epoller_.AddFileDescriptor(listener_, listen_event_mode | EPOLLIN);
-        failed = false;
+    std::vector<typename Reactor<IPAddr>::Ptr> reactors_;
+
+    //! The thread pool is destroyed before reactors, so no task is using their clients when they are released.
+    std::unique_ptr<Executor> thread_pool_;
+
+    //! The I/O thread pool building responses that may block on the disk, destroyed before reactors as well.
+    std::unique_ptr<Executor> io_pool_;
+    std::vector<std::thread> threads_;
+
+    log::Logger::Ptr logger_;
+};
+
+//! The builder for web servers.
+template <ValidIPAddr IPAddr>
+class WebServerBuilder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void SetRootDirectory(std::filesystem::path dir) noexcept {
+        WebServer<IPAddr>::SetRootDirectory(std::move(dir));
     }
 
-    //! A listen event is triggered.
-    void OnListenEvent() {
-        try {
-            while (true) {
-                typename IPAddr::RawType addr {};
-                socklen_t size {sizeof(addr)};
-                if (const auto new_socket {accept(
-                        listener_, reinterpret_cast<sockaddr*>(&addr), &size)};
-                    IsValidFileDescriptor(new_socket)) {
-                    AddClient(new_socket, std::move(addr));
-                } else {
-                    ThrowLastSystemError();
-                }
-            }
-        } catch (const std::system_error& err) {
-            if (err.code() != std::errc::resource_unavailable_try_again) {
-                logger_->Log(log::Event::Create(log::Level::Error)
-                             << fmt::format("Failed to accept a new client: {}",
-                                            err.what()));
-                throw;
-            }
-        }
+    static std::filesystem::path GetRootDirectory() noexcept {
+        return WebServer<IPAddr>::GetRootDirectory();
     }
 
-    //! A close event is triggered.
-    void OnCloseEvent(const FileDescriptor socket) noexcept {
-        MarkClientAsToBeClosed(socket);
+    static void SetAssetCache(const std::size_t capacity,
+                              const Clock::duration revalidation_interval,
+                              const bool compression = false) noexcept {
+        WebServer<IPAddr>::SetAssetCache(capacity, revalidation_interval,
+                                         compression);
     }
 
-    //! A receive event is triggered.
-    void OnReceiveEvent(const FileDescriptor socket) {
-        if (ExtendClientAliveTime(socket)) {
-            auto client {Conn(socket)};
-            thread_pool_.Push([client = std::move(client), this]() mutable {
-                ReceiveFrom(std::move(client));
-            });
-        }
+    static void SetAssetPack(const std::filesystem::path& pack) {
+        WebServer<IPAddr>::SetAssetPack(pack);
     }
 
-    //! A send event is triggered.
-    void OnSendEvent(const FileDescriptor socket) {
-        if (ExtendClientAliveTime(socket)) {
-            auto client {Conn(socket)};
-            thread_pool_.Push([client = std::move(client), this]() mutable {
-                SendTo(std::move(client));
-            });
-        }
+    static void SetHighWaterMark(const std::size_t size) noexcept {
+        WebServer<IPAddr>::SetHighWaterMark(size);
     }
 
-    /**
-     * @brief Extend a socket's alive time.
-     *
-     * @return @p true if the corresponding client is still valid, otherwise @p false.
-     */
-    bool ExtendClientAliveTime(const FileDescriptor socket) {
-        assert(IsValidFileDescriptor(socket));
-        const std::lock_guard locker {mtx_};
-        if (timer_.Contain(socket)) {
-            timer_.Adjust(socket, alive_time_);
-            return true;
-        } else {
-            return false;
-        }
+    static void SetMaxBufferSize(const std::size_t size) noexcept {
+        WebServer<IPAddr>::SetMaxBufferSize(size);
     }
 
-    /**
-     * @brief Mark a client as needing to be closed.
-     *
-     * @note
-     * Clients should only be added and removed in the main thread.
-     * This method makes a client's alive time zero,
-     * so it will be removed in the next event loop of the main thread.
-     */
-    void MarkClientAsToBeClosed(const FileDescriptor socket) noexcept {
-        assert(IsValidFileDescriptor(socket));
-        const std::lock_guard locker {mtx_};
-        assert(timer_.Contain(socket));
-        timer_.Adjust(socket, Clock::duration::zero());
+    static void SetRequestLimits(const http::RequestLimits limits) noexcept {
+        WebServer<IPAddr>::SetRequestLimits(limits);
     }
 
-    //! Add a client.
-    void AddClient(const FileDescriptor socket, typename IPAddr::RawType addr) {
-        assert(IsValidFileDescriptor(socket));
+    static void SetMaxRequestsPerConnection(const std::size_t count) noexcept {
+        WebServer<IPAddr>::SetMaxRequestsPerConnection(count);
+    }
 
-        const std::lock_guard locker {mtx_};
-        SetFileDescriptorAsNonblocking(socket);
-        epoller_.AddFileDescriptor(socket, connect_event_mode | EPOLLIN);
+    static void SetTLSCertificate(const std::filesystem::path& cert_chain,
+                                  const std::filesystem::path& private_key) {
+        WebServer<IPAddr>::SetTLSCertificate(cert_chain, private_key);
+    }
 
-        IPAddr ip_addr {std::move(addr)};
-        const auto ip_addr_str {ip_addr.IPAddress()};
-        auto client {std::make_shared<http::Connection<IPAddr>>(
-            socket, std::move(ip_addr))};
-        users_.insert({socket, std::move(client)});
+    static void SetMetricsPath(std::string path) noexcept {
+        WebServer<IPAddr>::SetMetricsPath(std::move(path));
+    }
 
-        timer_.Push(socket, alive_time_, [this](const auto socket) {
-            logger_->Log(log::Event::Create(log::Level::Info)
-                         << fmt::format("Client {} has timed-out",
-                                        Conn(socket)->IPAddress()));
-            CloseClient(socket);
-        });
+    static void SetTracePath(std::string path) noexcept {
+        WebServer<IPAddr>::SetTracePath(std::move(path));
+    }
 
-        logger_->Log(log::Event::Create(log::Level::Info) << fmt::format(
-                         "A new client {} has connected", ip_addr_str));
-        logger_->Log(log::Event::Create(log::Level::Debug)
-                     << fmt::format("Client {} is bound to socket {}",
-                                    ip_addr_str, socket));
+    static void SetSlowRequestThreshold(
+        const std::chrono::nanoseconds threshold) noexcept {
+        WebServer<IPAddr>::SetSlowRequestThreshold(threshold);
     }
 
-    //! Close a client.
-    void CloseClient(const FileDescriptor socket) noexcept {
-        assert(IsValidFileDescriptor(socket));
+    static void SetRoutes(http::RoutingTable routes) noexcept {
+        WebServer<IPAddr>::SetRoutes(std::move(routes));
+    }
 
-        const std::lock_guard locker {mtx_};
-        const auto ip_addr {Conn(socket)->IPAddress()};
+    WebServerBuilder& SetPort(const std::uint16_t port) noexcept {
+        port_ = port;
+        return *this;
+    }
 
-        try {
-            epoller_.DeleteFileDescriptor(socket);
-        } catch (const std::exception& err) {
-            logger_->Log(log::Event::Create(log::Level::Debug) << fmt::format(
-                             "Failed to delete socket {} from epoller: {}",
-                             socket, err.what()));
-        }
+    WebServerBuilder& SetAliveTime(const Clock::duration time) noexcept {
+        alive_time_ = time;
+        return *this;
+    }
 
-        timer_.Remove(socket);
-        users_.erase(socket);
-        logger_->Log(log::Event::Create(log::Level::Info)
-                     << fmt::format("Client {} has disconnected", ip_addr));
+    /**
+     * @brief Set the number of reactors.
+     *
+     * @details
+     * If it is zero, the server will run in the classic mode with a thread pool.
+     */
+    WebServerBuilder& SetReactorCount(const std::size_t count) noexcept {
+        reactor_count_ = count;
+        return *this;
     }
 
-    //! Receive data from a client.
-    void ReceiveFrom(typename http::Connection<IPAddr>::Ptr client) noexcept {
-        const auto ip_addr {client->IPAddress()};
+    //! Set whether to use a work-stealing thread pool in the classic mode.
+    WebServerBuilder& SetWorkStealing(const bool set) noexcept {
+        work_stealing_ = set;
+        return *this;
+    }
 
-        try {
-            logger_->Log(log::Event::Create(log::Level::Info) << fmt::format(
-                             "Start to receive data from client {}", ip_addr));
-            client->Receive();
-            Process(std::move(client));
-        } catch (const std::exception& err) {
-            logger_->Log(log::Event::Create(log::Level::Error) << fmt::format(
-                             "Failed to receive data from client {}: {}",
-                             ip_addr, err.what()));
+    //! Set the backend of reactors' pollers.
+    WebServerBuilder& SetPollerBackend(const Poller::Backend backend) noexcept {
+        poller_options_.backend = backend;
+        return *this;
+    }
 
-            MarkClientAsToBeClosed(client->Socket());
-        }
+    //! Set the maximum number of events returned by each wait of reactors.
+    WebServerBuilder& SetMaxEvents(const std::size_t count) noexcept {
+        assert(count > 0);
+        poller_options_.max_events = count;
+        return *this;
     }
 
-    //! Send data to a client.
-    void SendTo(typename http::Connection<IPAddr>::Ptr client) noexcept {
-        const auto ip_addr {client->IPAddress()};
+    /**
+     * @brief Set how long reactors poll without blocking before waiting for events.
+     *
+     * @details Zero disables busy polling.
+     */
+    WebServerBuilder& SetBusyPoll(const Clock::duration time) noexcept {
+        poller_options_.busy_poll = time;
+        return *this;
+    }
 
-        try {
-            logger_->Log(log::Event::Create(log::Level::Info) << fmt::format(
-                             "Start to send data to client {}", ip_addr));
-            client->Send();
-            if (client->KeepAlive()) {
-                // Continue to receive data if the client keeps alive.
-                Process(std::move(client));
-                return;
-            }
-        } catch (const std::exception& err) {
-            logger_->Log(log::Event::Create(log::Level::Error)
-                         << fmt::format("Failed to send data to client {}: {}",
-                                        ip_addr, err.what()));
-        }
+    //! Set the maximum number of connections accepted by a reactor in an iteration of its event loop.
+    WebServerBuilder& SetAcceptBudget(const std::size_t count) noexcept {
+        assert(count > 0);
+        listener_options_.accept_budget = count;
+        return *this;
+    }
 
-        MarkClientAsToBeClosed(client->Socket());
+    /**
+     * @brief Set the time for which the kernel waits for a new connection's first data before reactors accept it.
+     *
+     * @details Zero disables @p TCP_DEFER_ACCEPT.
+     */
+    WebServerBuilder& SetDeferAccept(const std::chrono::seconds time) noexcept {
+        listener_options_.defer_accept = time;
+        return *this;
     }
 
-    //! Process a client.
-    void Process(const typename http::Connection<IPAddr>::Ptr client) {
-        if (client->Process()) {
-            // The client is ready for sending, register a send event.
-            epoller_.ModifyFileDescriptor(client->Socket(),
-                                          connect_event_mode | EPOLLOUT);
-        } else {
-            // The client's reading buffer for request is still empty, register a receive event.
-            epoller_.ModifyFileDescriptor(client->Socket(),
-                                          connect_event_mode | EPOLLIN);
-        }
+    /**
+     * @brief Set the maximum number of pending @p TCP_FASTOPEN requests.
+     *
+     * @details Zero disables @p TCP_FASTOPEN.
+     */
+    WebServerBuilder& SetFastOpenQueue(const std::size_t size) noexcept {
+        listener_options_.fast_open_queue = size;
+        return *this;
     }
 
-    //! Get the client by a socket.
-    typename http::Connection<IPAddr>::Ptr Conn(
-        const FileDescriptor socket) noexcept {
-        assert(users_.contains(socket));
-        return users_[socket];
+    //! Set whether accepted connections disable Nagle's algorithm with @p TCP_NODELAY.
+    WebServerBuilder& SetNoDelay(const bool set) noexcept {
+        listener_options_.no_delay = set;
+        return *this;
     }
 
-    std::mutex mtx_;
+    /**
+     * @brief Set the size of each accepted connection's socket send buffer.
+     *
+     * @details Zero keeps the kernel's default and auto-tuning.
+     */
+    WebServerBuilder& SetSendBufferSize(const std::size_t size) noexcept {
+        listener_options_.send_buffer_size = size;
+        return *this;
+    }
 
-    std::uint16_t port_;
-    Clock::duration alive_time_;
-    std::atomic_bool closed_ {false};
+    /**
+     * @brief Set the size of each accepted connection's socket receive buffer.
+     *
+     * @details Zero keeps the kernel's default and auto-tuning.
+     */
+    WebServerBuilder& SetReceiveBufferSize(const std::size_t size) noexcept {
+        listener_options_.receive_buffer_size = size;
+        return *this;
+    }
 
-    FileDescriptor listener_ {invalid_file_descriptor};
-    ThreadPool thread_pool_;
-    Epoller epoller_;
-    HeapTimer<FileDescriptor> timer_;
-    std::unordered_map<FileDescriptor, typename http::Connection<IPAddr>::Ptr>
-        users_;
+    //! Set CPUs where reactors run.
+    WebServerBuilder& SetReactorAffinity(std::vector<std::size_t> cpus) noexcept {
+        affinity_.reactors = std::move(cpus);
+        return *this;
+    }
 
-    log::Logger::Ptr logger_;
-};
+    //! Set CPUs where working threads of the thread pool run in the classic mode.
+    WebServerBuilder& SetWorkerAffinity(std::vector<std::size_t> cpus) noexcept {
+        affinity_.workers = std::move(cpus);
+        return *this;
+    }
 
-//! The builder for web servers.
-template <ValidIPAddr IPAddr>
-class WebServerBuilder {
-public:
-    using Clock = std::chrono::steady_clock;
+    //! Set whether each reactor's listener prefers connections whose packets are processed on the reactor's CPU.
+    WebServerBuilder& SetIncomingCPU(const bool set) noexcept {
+        affinity_.incoming_cpu = set;
+        return *this;
+    }
 
-    static void SetRootDirectory(std::filesystem::path dir) noexcept {
-        WebServer<IPAddr>::SetRootDirectory(std::move(dir));
+    /**
+     * @brief Set the maximum number of connected clients.
+     *
+     * @details Zero means no limit.
+     */
+    WebServerBuilder& SetMaxConnections(const std::size_t count) noexcept {
+        admission_.max_connections = count;
+        return *this;
     }
 
-    static std::filesystem::path GetRootDirectory() noexcept {
-        return WebServer<IPAddr>::GetRootDirectory();
+    /**
+     * @brief Set the maximum number of tasks queued in the thread pool in the classic mode.
+     *
+     * @details Zero means no limit.
+     */
+    WebServerBuilder& SetMaxQueuedTasks(const std::size_t count) noexcept {
+        admission_.max_queued_tasks = count;
+        return *this;
     }
 
-    WebServerBuilder& SetPort(const std::uint16_t port) noexcept {
-        port_ = port;
+    /**
+     * @brief Set the maximum time for which a client with new requests waits in the thread pool in the classic mode.
+     *
+     * @details Zero means no limit.
+     */
+    WebServerBuilder& SetMaxQueueTime(const Clock::duration time) noexcept {
+        admission_.max_queue_time = time;
         return *this;
     }
 
-    WebServerBuilder& SetAliveTime(const Clock::duration time) noexcept {
-        alive_time_ = time;
+    /**
+     * @brief Set whether clients are served by coroutines in the multi-reactor mode.
+     *
+     * @details
+     * A client's coroutine receives, processes and sends in the reactor's thread,
+     * and its socket is registered once instead of being re-armed for every phase.
+     */
+    WebServerBuilder& SetCoroutines(const bool set) noexcept {
+        coroutines_ = set;
+        return *this;
+    }
+
+    /**
+     * @brief Set the number of threads building responses that may block on the disk for coroutines.
+     *
+     * @details
+     * Coroutines wait for files to be opened and read by these threads, while reactors keep serving other clients.
+     * Zero means reactors build them.
+     */
+    WebServerBuilder& SetDiskThreads(const std::size_t count) noexcept {
+        disk_threads_ = count;
         return *this;
     }
 
@@ -416,13 +692,32 @@ public:
 
     //! Create a web server with the current settings.
     WebServer<IPAddr> Create() noexcept {
-        return WebServer<IPAddr> {port_, alive_time_, logger_};
+        return WebServer<IPAddr> {port_, alive_time_, reactor_count_,
+                                  work_stealing_, poller_options_,
+                                  listener_options_, affinity_, admission_,
+                                  coroutines_, disk_threads_, logger_};
     }
 
 private:
-    std::uint16_t port_;
+    std::uint16_t port_ {0};
 
-    Clock::duration alive_time_;
+    Clock::duration alive_time_ {Clock::duration::zero()};
+
+    std::size_t reactor_count_ {0};
+
+    bool work_stealing_ {false};
+
+    Poller::Options poller_options_;
+
+    ListenerOptions listener_options_;
+
+    AffinityOptions affinity_;
+
+    AdmissionOptions admission_;
+
+    bool coroutines_ {false};
+
+    std::size_t disk_threads_ {0};
 
     log::Logger::Ptr logger_;
 };
@@ -0,0 +1,125 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+namespace ws::bench {
+
+namespace {
+
+//! The number of sub-buckets in each bucket above the exact range.
+constexpr std::uint64_t half_sub_bucket_count {Histogram::sub_bucket_count
+                                               / 2};
+
+//! The number of counters to cover all 64-bit values.
+constexpr std::size_t counter_count {
+    Histogram::sub_bucket_count
+    + (std::numeric_limits<std::uint64_t>::digits
+       - Histogram::sub_bucket_bits)
+          * half_sub_bucket_count};
+
+}  // namespace
+
+Histogram::Histogram() noexcept : counts_(counter_count, 0) {}
+
+std::size_t Histogram::IndexOf(const std::uint64_t value) noexcept {
+    if (value < sub_bucket_count) {
+        return value;
+    }
+
+    // The top bits of a value select its sub-bucket, and the rest are dropped.
+    const auto shift {static_cast<std::size_t>(std::bit_width(value))
+                      - sub_bucket_bits};
+    const auto sub_bucket {value >> shift};
+    assert(sub_bucket >= half_sub_bucket_count
+           && sub_bucket < sub_bucket_count);
+    return sub_bucket_count + (shift - 1) * half_sub_bucket_count
+           + (sub_bucket - half_sub_bucket_count);
+}
+
+std::uint64_t Histogram::HighestEquivalentValue(const std::size_t idx) noexcept {
+    if (idx < sub_bucket_count) {
+        return idx;
+    }
+
+    const auto offset {idx - sub_bucket_count};
+    const auto shift {offset / half_sub_bucket_count + 1};
+    const auto sub_bucket {offset % half_sub_bucket_count
+                           + half_sub_bucket_count};
+    return (sub_bucket << shift) + ((1ULL << shift) - 1);
+}
+
+void Histogram::Record(const std::uint64_t value) noexcept {
+    ++counts_[IndexOf(value)];
+    min_ = count_ == 0 ? value : std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+    ++count_;
+}
+
+void Histogram::Merge(const Histogram& other) noexcept {
+    if (other.count_ == 0) {
+        return;
+    }
+
+    for (std::size_t i {0}; i != counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+
+    min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    count_ += other.count_;
+}
+
+void Histogram::Clear() noexcept {
+    std::ranges::fill(counts_, 0);
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0;
+}
+
+std::uint64_t Histogram::Count() const noexcept {
+    return count_;
+}
+
+std::uint64_t Histogram::Min() const noexcept {
+    return min_;
+}
+
+std::uint64_t Histogram::Max() const noexcept {
+    return max_;
+}
+
+double Histogram::Mean() const noexcept {
+    return count_ == 0 ? 0 : static_cast<double>(sum_ / count_);
+}
+
+std::uint64_t Histogram::ValueAtPercentile(const double percentile) const noexcept {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    const auto rank {std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(
+            std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * count_)),
+        1)};
+
+    std::uint64_t total {0};
+    for (std::size_t i {0}; i != counts_.size(); ++i) {
+        total += counts_[i];
+        if (total >= rank) {
+            // The equivalent range may exceed the actual extremes.
+            return std::clamp(HighestEquivalentValue(i), min_, max_);
+        }
+    }
+
+    return max_;
+}
+
+}  // namespace ws::bench
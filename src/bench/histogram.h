@@ -0,0 +1,89 @@
+/**
+ * @file histogram.h
+ * @brief The latency histogram of the load generator.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-26
+ *
+ * @example src/bench/histogram_test.cpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace ws::bench {
+
+/**
+ * @brief A histogram of non-negative values with a bounded relative error, in the style of HDR histograms.
+ *
+ * @details
+ * Values below @p sub_bucket_count are counted exactly.
+ * Larger values are counted in buckets whose widths double with each power of two,
+ * each split into @p sub_bucket_count / 2 equal sub-buckets.
+ * So a reported value differs from the recorded one by less than 0.1%,
+ * and recording costs a few bit operations without any allocation.
+ */
+class Histogram {
+public:
+    //! The number of bits distinguishing values in a bucket.
+    static constexpr std::size_t sub_bucket_bits {11};
+
+    //! The number of values counted exactly.
+    static constexpr std::uint64_t sub_bucket_count {1ULL << sub_bucket_bits};
+
+    Histogram() noexcept;
+
+    //! Record a value.
+    void Record(std::uint64_t value) noexcept;
+
+    //! Add all values recorded by another histogram.
+    void Merge(const Histogram& other) noexcept;
+
+    //! Remove all values.
+    void Clear() noexcept;
+
+    //! Get the number of recorded values.
+    std::uint64_t Count() const noexcept;
+
+    //! Get the minimum value, or zero if there is no value.
+    std::uint64_t Min() const noexcept;
+
+    //! Get the maximum value, or zero if there is no value.
+    std::uint64_t Max() const noexcept;
+
+    //! Get the mean value, or zero if there is no value.
+    double Mean() const noexcept;
+
+    /**
+     * @brief Get the value at a percentile.
+     *
+     * @param percentile A percentile between 0 and 100.
+     * @return
+     * The largest value equivalent to the one at or below which the percentile of values fall,
+     * or zero if there is no value.
+     */
+    std::uint64_t ValueAtPercentile(double percentile) const noexcept;
+
+private:
+    //! Get the index of the counter of a value.
+    static std::size_t IndexOf(std::uint64_t value) noexcept;
+
+    //! Get the largest value counted by a counter.
+    static std::uint64_t HighestEquivalentValue(std::size_t idx) noexcept;
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t count_ {0};
+    std::uint64_t min_ {0};
+    std::uint64_t max_ {0};
+    long double sum_ {0};
+};
+
+}  // namespace ws::bench
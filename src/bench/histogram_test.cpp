@@ -0,0 +1,78 @@
+#include "histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+
+using namespace ws::bench;
+
+
+TEST(BenchHistogramTest, Empty) {
+    const Histogram histogram;
+    EXPECT_EQ(histogram.Count(), 0);
+    EXPECT_EQ(histogram.Min(), 0);
+    EXPECT_EQ(histogram.Max(), 0);
+    EXPECT_EQ(histogram.Mean(), 0);
+    EXPECT_EQ(histogram.ValueAtPercentile(50), 0);
+}
+
+TEST(BenchHistogramTest, ExactValues) {
+    Histogram histogram;
+    for (std::uint64_t i {1}; i <= 100; ++i) {
+        histogram.Record(i);
+    }
+
+    EXPECT_EQ(histogram.Count(), 100);
+    EXPECT_EQ(histogram.Min(), 1);
+    EXPECT_EQ(histogram.Max(), 100);
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 50.5);
+
+    // Values below the sub-bucket count are counted exactly.
+    EXPECT_EQ(histogram.ValueAtPercentile(0), 1);
+    EXPECT_EQ(histogram.ValueAtPercentile(50), 50);
+    EXPECT_EQ(histogram.ValueAtPercentile(99), 99);
+    EXPECT_EQ(histogram.ValueAtPercentile(99.9), 100);
+    EXPECT_EQ(histogram.ValueAtPercentile(100), 100);
+}
+
+TEST(BenchHistogramTest, RelativeError) {
+    static constexpr std::uint64_t values[] {
+        Histogram::sub_bucket_count, 123'456, 9'876'543'210,
+        std::numeric_limits<std::uint64_t>::max() / 3};
+
+    for (const auto value : values) {
+        Histogram histogram;
+        histogram.Record(1);
+        histogram.Record(value);
+        histogram.Record(std::numeric_limits<std::uint64_t>::max());
+
+        const auto reported {histogram.ValueAtPercentile(50)};
+        EXPECT_GE(reported, value);
+        EXPECT_LT(static_cast<double>(reported - value) / value, 0.001);
+    }
+}
+
+TEST(BenchHistogramTest, Merge) {
+    Histogram lhs;
+    Histogram rhs;
+    for (std::uint64_t i {1}; i <= 50; ++i) {
+        lhs.Record(i);
+        rhs.Record(i + 50);
+    }
+
+    lhs.Merge(rhs);
+    lhs.Merge(Histogram {});
+    EXPECT_EQ(lhs.Count(), 100);
+    EXPECT_EQ(lhs.Min(), 1);
+    EXPECT_EQ(lhs.Max(), 100);
+    EXPECT_EQ(lhs.ValueAtPercentile(75), 75);
+
+    Histogram empty;
+    empty.Merge(rhs);
+    EXPECT_EQ(empty.Min(), 51);
+
+    lhs.Clear();
+    EXPECT_EQ(lhs.Count(), 0);
+    EXPECT_EQ(lhs.ValueAtPercentile(50), 0);
+}
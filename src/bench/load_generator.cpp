@@ -0,0 +1,584 @@
+#include "load_generator.h"
+#include "containers/epoller.h"
+#include "io.h"
+#include "util.h"
+
+#include <fmt/format.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+
+namespace ws::bench {
+
+namespace {
+
+//! The path of the echo page, which renders posted messages.
+constexpr std::string_view echo_path {"/index.html"};
+
+//! The form posted to the echo page.
+constexpr std::string_view echo_form {"user=echo-bench&msg=Hello%2C+world%21"};
+
+//! The time to wait before reopening failed connections.
+constexpr std::chrono::milliseconds reconnect_interval {10};
+
+//! Whether two strings are equal ignoring case.
+bool EqualIgnoreCase(const std::string_view lhs,
+                     const std::string_view rhs) noexcept {
+    return std::ranges::equal(lhs, rhs, [](const char l, const char r) {
+        return std::tolower(static_cast<unsigned char>(l))
+               == std::tolower(static_cast<unsigned char>(r));
+    });
+}
+
+std::string_view ToStringView(const std::span<const std::byte> bytes) noexcept {
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+//! The event loop of a load generator's thread.
+class Worker {
+public:
+    using Clock = LoadGenerator::Clock;
+
+    Worker(const sockaddr* const server, const socklen_t server_size,
+           const LoadGenerator::Options& options,
+           const std::vector<std::string>& gets, const std::string& post,
+           const std::uint32_t seed) :
+        server_ {server},
+        server_size_ {server_size},
+        options_ {options},
+        gets_ {gets},
+        post_ {post},
+        engine_ {seed},
+        poller_ {std::max<std::size_t>(options.connections, 1)} {}
+
+    ~Worker() noexcept {
+        for (const auto& [socket, client] : clients_) {
+            close(socket);
+        }
+    }
+
+    Worker(const Worker&) = delete;
+
+    Worker(Worker&&) = delete;
+
+    Worker& operator=(const Worker&) = delete;
+
+    Worker& operator=(Worker&&) = delete;
+
+    //! Keep a number of connections busy until a deadline.
+    LoadGenerator::Report Run(const std::size_t connections,
+                              const Clock::time_point deadline) {
+        reopen_count_ = connections;
+        while (true) {
+            const auto now {Clock::now()};
+            if (now >= deadline) {
+                break;
+            }
+
+            if (retry_count_ > 0 && now >= retry_time_) {
+                reopen_count_ += std::exchange(retry_count_, 0);
+            }
+
+            for (; reopen_count_ > 0; --reopen_count_) {
+                Open();
+            }
+
+            auto time_out {deadline - now};
+            if (retry_count_ > 0) {
+                time_out = std::min<Clock::duration>(time_out,
+                                                     retry_time_ - now);
+            }
+
+            const auto count {poller_.Wait(time_out)};
+            for (std::size_t i {0}; i != count; ++i) {
+                Handle(poller_.FileDescriptor(i), poller_.Events(i));
+            }
+        }
+
+        return std::move(report_);
+    }
+
+private:
+    //! A connection to the server.
+    struct Client {
+        bool connected {false};
+
+        //! Whether a request is waiting for its response.
+        bool waiting {false};
+
+        Clock::time_point sent;
+        Buffer read_buf;
+        Buffer write_buf;
+        ResponseParser parser;
+    };
+
+    //! Open a new connection, which is reopened later if it fails.
+    void Open() noexcept {
+        const auto socket {::socket(server_->sa_family,
+                                    SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                    0)};
+        if (!IsValidFileDescriptor(socket)) {
+            Fail();
+            return;
+        }
+
+        static constexpr int enable {1};
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        if (connect(socket, server_, server_size_) != 0
+            && errno != EINPROGRESS) {
+            close(socket);
+            Fail();
+            return;
+        }
+
+        try {
+            poller_.AddFileDescriptor(socket, EPOLLOUT);
+        } catch (const std::system_error&) {
+            close(socket);
+            Fail();
+            return;
+        }
+
+        ++report_.connects;
+        clients_.try_emplace(socket);
+    }
+
+    //! Count a failure and reopen the connection after an interval, so a refusing server is not flooded.
+    void Fail() noexcept {
+        ++report_.errors;
+        if (retry_count_++ == 0) {
+            retry_time_ = Clock::now() + reconnect_interval;
+        }
+    }
+
+    /**
+     * @brief Close a connection and open a new one.
+     *
+     * @param error Whether the connection is closed because of an error.
+     */
+    void Close(const FileDescriptor socket, const bool error) noexcept {
+        try {
+            poller_.DeleteFileDescriptor(socket);
+        } catch (const std::system_error&) {
+        }
+
+        close(socket);
+        clients_.erase(socket);
+        if (error) {
+            Fail();
+        } else {
+            ++reopen_count_;
+        }
+    }
+
+    void Handle(const FileDescriptor socket, const std::uint32_t events) {
+        const auto it {clients_.find(socket)};
+        if (it == clients_.cend()) {
+            return;
+        }
+
+        auto& client {it->second};
+        if (!client.connected) {
+            int error {0};
+            socklen_t size {sizeof(error)};
+            if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &size) != 0
+                || error != 0) {
+                Close(socket, true);
+                return;
+            }
+
+            client.connected = true;
+            Send(socket, client);
+            return;
+        }
+
+        if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) {
+            if (!Receive(socket, client)) {
+                return;
+            }
+        }
+
+        if ((events & EPOLLOUT) != 0) {
+            Flush(socket, client);
+        }
+    }
+
+    //! Send a random request.
+    void Send(const FileDescriptor socket, Client& client) {
+        assert(!client.waiting);
+        const auto post {post_distribution_(engine_)
+                         < options_.post_percentage};
+        if (post) {
+            client.write_buf.Append(post_);
+        } else {
+            std::uniform_int_distribution<std::size_t> dist {0,
+                                                             gets_.size() - 1};
+            client.write_buf.Append(gets_[dist(engine_)]);
+        }
+
+        client.waiting = true;
+        client.sent = Clock::now();
+        Flush(socket, client);
+    }
+
+    //! Write the pending request and wait for writability if the socket is full.
+    void Flush(const FileDescriptor socket, Client& client) {
+        io::FileDescriptor io {socket, socket};
+        try {
+            while (!client.write_buf.Empty()) {
+                io.ReadFrom(client.write_buf);
+            }
+        } catch (const std::system_error& err) {
+            if (err.code() != std::errc::resource_unavailable_try_again) {
+                Close(socket, true);
+                return;
+            }
+        }
+
+        poller_.ModifyFileDescriptor(
+            socket, client.write_buf.Empty() ? EPOLLIN : EPOLLIN | EPOLLOUT);
+    }
+
+    /**
+     * @brief Read and parse responses.
+     *
+     * @return Whether the connection is still open.
+     */
+    bool Receive(const FileDescriptor socket, Client& client) {
+        io::FileDescriptor io {socket, socket};
+        while (true) {
+            std::size_t size {0};
+            try {
+                size = io.WriteTo(client.read_buf);
+            } catch (const std::system_error& err) {
+                if (err.code() == std::errc::resource_unavailable_try_again) {
+                    return true;
+                }
+
+                Close(socket, true);
+                return false;
+            }
+
+            if (size == 0) {
+                // A response without a length ends with the connection.
+                if (client.waiting && client.parser.Finish()) {
+                    Complete(client);
+                }
+
+                Close(socket, client.waiting);
+                return false;
+            }
+
+            try {
+                if (!client.waiting || !client.parser.Parse(client.read_buf)) {
+                    continue;
+                }
+            } catch (const std::invalid_argument&) {
+                Close(socket, true);
+                return false;
+            }
+
+            const auto keep_alive {options_.keep_alive
+                                   && client.parser.KeepAlive()};
+            Complete(client);
+            if (!keep_alive) {
+                Close(socket, false);
+                return false;
+            }
+
+            Send(socket, client);
+            if (!clients_.contains(socket)) {
+                return false;
+            }
+        }
+    }
+
+    //! Record a completed response.
+    void Complete(Client& client) noexcept {
+        const auto latency {Clock::now() - client.sent};
+        report_.latency.Record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency)
+                .count()));
+
+        const auto status_class {client.parser.StatusCode() / 100};
+        if (status_class >= 1 && status_class <= report_.status_classes.size()) {
+            ++report_.status_classes[status_class - 1];
+        }
+
+        ++report_.responses;
+        report_.bytes += client.parser.Size();
+        client.parser.Clear();
+        client.waiting = false;
+    }
+
+    const sockaddr* server_;
+    socklen_t server_size_;
+    const LoadGenerator::Options& options_;
+    const std::vector<std::string>& gets_;
+    const std::string& post_;
+
+    std::mt19937 engine_;
+    std::uniform_int_distribution<std::size_t> post_distribution_ {0, 99};
+
+    Epoller poller_;
+    std::unordered_map<FileDescriptor, Client> clients_;
+
+    //! The number of closed connections to be reopened immediately.
+    std::size_t reopen_count_ {0};
+
+    //! The number of failed connections to be reopened at the retry time.
+    std::size_t retry_count_ {0};
+    Clock::time_point retry_time_;
+
+    LoadGenerator::Report report_;
+};
+
+}  // namespace
+
+bool ResponseParser::Parse(Buffer& buf) {
+    assert(!finished_);
+    if (!header_parsed_) {
+        static constexpr std::string_view end {"\r\n\r\n"};
+        const auto data {ToStringView(buf.ReadableBytes())};
+        const auto pos {data.find(end)};
+        if (pos == std::string_view::npos) {
+            if (data.size() > max_header_size) {
+                throw std::invalid_argument {"The response header is too large"};
+            }
+
+            return false;
+        }
+
+        const auto header_size {pos + end.size()};
+        ParseHeader(data.substr(0, pos + 2));
+        buf.Retrieve(header_size);
+        size_ += header_size;
+        header_parsed_ = true;
+    }
+
+    // The body is discarded.
+    const auto remaining {content_length_.has_value()
+                              ? content_length_.value() - body_size_
+                              : buf.ReadableSize()};
+    const auto size {std::min(remaining, buf.ReadableSize())};
+    buf.Retrieve(size);
+    body_size_ += size;
+    size_ += size;
+
+    finished_ = content_length_.has_value()
+                && body_size_ == content_length_.value();
+    return finished_;
+}
+
+void ResponseParser::ParseHeader(std::string_view header) {
+    // The status line looks like `HTTP/1.1 200 OK`.
+    const auto line_end {header.find("\r\n")};
+    const auto status_line {header.substr(0, line_end)};
+    header.remove_prefix(line_end + 2);
+
+    const auto code_begin {status_line.find(' ')};
+    if (!status_line.starts_with("HTTP/")
+        || code_begin == std::string_view::npos) {
+        throw std::invalid_argument {fmt::format(
+            "Invalid response status line: '{}'", status_line)};
+    }
+
+    const auto code {status_line.substr(code_begin + 1, 3)};
+    if (const auto [ptr, error] {std::from_chars(
+            code.data(), code.data() + code.size(), status_code_)};
+        error != std::errc {} || ptr != code.data() + code.size()) {
+        throw std::invalid_argument {fmt::format(
+            "Invalid response status line: '{}'", status_line)};
+    }
+
+    keep_alive_ = !status_line.starts_with("HTTP/1.0");
+    while (!header.empty()) {
+        const auto end {header.find("\r\n")};
+        const auto line {header.substr(0, end)};
+        header.remove_prefix(end + 2);
+
+        const auto colon {line.find(':')};
+        if (colon == std::string_view::npos) {
+            throw std::invalid_argument {
+                fmt::format("Invalid response header: '{}'", line)};
+        }
+
+        const auto key {TrimWhitespace(line.substr(0, colon))};
+        const auto value {TrimWhitespace(line.substr(colon + 1))};
+        if (EqualIgnoreCase(key, "Content-length")) {
+            std::size_t length {0};
+            if (const auto [ptr, error] {std::from_chars(
+                    value.data(), value.data() + value.size(), length)};
+                error != std::errc {} || ptr != value.data() + value.size()) {
+                throw std::invalid_argument {
+                    fmt::format("Invalid content length: '{}'", value)};
+            }
+
+            content_length_ = length;
+        } else if (EqualIgnoreCase(key, "Connection")) {
+            if (EqualIgnoreCase(value, "close")) {
+                keep_alive_ = false;
+            } else if (EqualIgnoreCase(value, "keep-alive")) {
+                keep_alive_ = true;
+            }
+        }
+    }
+
+    // Informational, `204 No Content` and `304 Not Modified` responses have no body.
+    if (status_code_ < 200 || status_code_ == 204 || status_code_ == 304) {
+        content_length_ = 0;
+    }
+
+    // Responses to be ended by closing connections cannot be kept alive.
+    if (!content_length_.has_value()) {
+        keep_alive_ = false;
+    }
+}
+
+bool ResponseParser::Finish() noexcept {
+    if (header_parsed_ && !content_length_.has_value()) {
+        finished_ = true;
+    }
+
+    return finished_;
+}
+
+bool ResponseParser::Finished() const noexcept {
+    return finished_;
+}
+
+std::uint32_t ResponseParser::StatusCode() const noexcept {
+    return status_code_;
+}
+
+std::size_t ResponseParser::Size() const noexcept {
+    return size_;
+}
+
+bool ResponseParser::KeepAlive() const noexcept {
+    return keep_alive_;
+}
+
+void ResponseParser::Clear() noexcept {
+    header_parsed_ = false;
+    finished_ = false;
+    keep_alive_ = true;
+    status_code_ = 0;
+    content_length_.reset();
+    body_size_ = 0;
+    size_ = 0;
+}
+
+void LoadGenerator::Report::Merge(const Report& other) noexcept {
+    responses += other.responses;
+    for (std::size_t i {0}; i != status_classes.size(); ++i) {
+        status_classes[i] += other.status_classes[i];
+    }
+
+    errors += other.errors;
+    connects += other.connects;
+    bytes += other.bytes;
+    latency.Merge(other.latency);
+    elapsed = std::max(elapsed, other.elapsed);
+}
+
+LoadGenerator::LoadGenerator(const IPAddr& server, Options options) :
+    options_ {std::move(options)} {
+    if (options_.connections == 0) {
+        throw std::invalid_argument {"The number of connections is zero"};
+    } else if (options_.threads == 0) {
+        throw std::invalid_argument {"The number of threads is zero"};
+    } else if (options_.duration <= Clock::duration::zero()) {
+        throw std::invalid_argument {"The duration is not positive"};
+    } else if (options_.post_percentage > 100) {
+        throw std::invalid_argument {fmt::format(
+            "Invalid percentage of POST requests: {}", options_.post_percentage)};
+    } else if (options_.paths.empty() && options_.post_percentage != 100) {
+        throw std::invalid_argument {"No path for GET requests"};
+    }
+
+    assert(server.Size() <= sizeof(server_));
+    std::memcpy(&server_, server.Raw(), server.Size());
+    server_size_ = static_cast<socklen_t>(server.Size());
+
+    // Requests are built once and copied to connections.
+    const auto connection {options_.keep_alive ? "keep-alive" : "close"};
+    for (const auto& path : options_.paths) {
+        gets_.push_back(fmt::format("GET {} HTTP/1.1\r\n"
+                                    "Host: {}\r\n"
+                                    "Connection: {}\r\n"
+                                    "\r\n",
+                                    path, options_.host, connection));
+    }
+
+    post_ = fmt::format("POST {} HTTP/1.1\r\n"
+                        "Host: {}\r\n"
+                        "Connection: {}\r\n"
+                        "Content-Type: application/x-www-form-urlencoded\r\n"
+                        "Content-Length: {}\r\n"
+                        "\r\n"
+                        "{}",
+                        echo_path, options_.host, connection, echo_form.size(),
+                        echo_form);
+}
+
+LoadGenerator::Report LoadGenerator::Run() const {
+    const auto thread_count {std::min(options_.threads, options_.connections)};
+    std::vector<Report> reports(thread_count);
+    std::vector<std::exception_ptr> errors(thread_count);
+
+    const auto start {Clock::now()};
+    const auto deadline {start + options_.duration};
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t i {0}; i != thread_count; ++i) {
+            // Connections are distributed evenly among threads.
+            const auto connections {options_.connections / thread_count
+                                    + (i < options_.connections % thread_count
+                                           ? 1
+                                           : 0)};
+            threads.emplace_back([&, i, connections]() noexcept {
+                try {
+                    Worker worker {reinterpret_cast<const sockaddr*>(&server_),
+                                   server_size_,
+                                   options_,
+                                   gets_,
+                                   post_,
+                                   static_cast<std::uint32_t>(i)};
+                    reports[i] = worker.Run(connections, deadline);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+    }
+
+    Report report;
+    for (std::size_t i {0}; i != thread_count; ++i) {
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+
+        report.Merge(reports[i]);
+    }
+
+    report.elapsed = Clock::now() - start;
+    return report;
+}
+
+}  // namespace ws::bench
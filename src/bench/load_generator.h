@@ -0,0 +1,173 @@
+/**
+ * @file load_generator.h
+ * @brief The HTTP load generator.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-26
+ *
+ * @example src/bench/load_generator_test.cpp
+ */
+
+#pragma once
+
+#include "containers/buffer.h"
+#include "histogram.h"
+#include "ip.h"
+
+#include <sys/socket.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace ws::bench {
+
+/**
+ * @brief The incremental parser of HTTP/1.1 responses.
+ *
+ * @details
+ * Bodies are discarded as soon as they are received,
+ * so large files do not need to be buffered.
+ * A response without @p Content-length ends when the server closes the connection.
+ */
+class ResponseParser {
+public:
+    //! The maximum size of a response's header.
+    static constexpr std::size_t max_header_size {0x10000};
+
+    /**
+     * @brief Parse the beginning of a buffer and retrieve the parsed data.
+     *
+     * @return Whether the response has been completely received.
+     *
+     * @exception std::invalid_argument The response is malformed.
+     */
+    bool Parse(Buffer& buf);
+
+    /**
+     * @brief Finish the response when the connection is closed.
+     *
+     * @return Whether the response is complete, which needs it to end with the connection.
+     */
+    bool Finish() noexcept;
+
+    //! Whether the response has been completely received.
+    bool Finished() const noexcept;
+
+    //! Get the status code.
+    std::uint32_t StatusCode() const noexcept;
+
+    //! Get the total size of the header and body received so far.
+    std::size_t Size() const noexcept;
+
+    //! Whether the server keeps the connection alive after the response.
+    bool KeepAlive() const noexcept;
+
+    //! Clear the state to parse a new response.
+    void Clear() noexcept;
+
+private:
+    //! Parse a header ending with an empty line.
+    void ParseHeader(std::string_view header);
+
+    bool header_parsed_ {false};
+    bool finished_ {false};
+    bool keep_alive_ {true};
+    std::uint32_t status_code_ {0};
+    std::optional<std::size_t> content_length_;
+    std::size_t body_size_ {0};
+    std::size_t size_ {0};
+};
+
+//! The load generator opening concurrent connections to a server and replaying requests on them.
+class LoadGenerator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Options of load generators.
+    struct Options {
+        //! The number of concurrent connections.
+        std::size_t connections {100};
+
+        //! The number of threads, each of which runs an event loop for a share of connections.
+        std::size_t threads {1};
+
+        //! The time for which requests are sent.
+        Clock::duration duration {std::chrono::seconds {10}};
+
+        /**
+         * @brief Whether connections are kept alive between requests.
+         *
+         * @details If it is @p false, each connection is closed after a response and a new one is opened.
+         */
+        bool keep_alive {true};
+
+        //! Paths of @p GET requests, which are chosen at random.
+        std::vector<std::string> paths {"/index.html"};
+
+        //! The percentage of requests posting a message to the echo page.
+        std::size_t post_percentage {0};
+
+        //! The value of @p Host headers.
+        std::string host {"localhost"};
+    };
+
+    //! The result of a run.
+    struct Report {
+        //! Merge another report of concurrent connections.
+        void Merge(const Report& other) noexcept;
+
+        //! The number of completed responses.
+        std::uint64_t responses {0};
+
+        //! The number of responses by status class, from @p 1xx to @p 5xx.
+        std::array<std::uint64_t, 5> status_classes {};
+
+        //! The number of failed connections and requests.
+        std::uint64_t errors {0};
+
+        //! The number of opened connections.
+        std::uint64_t connects {0};
+
+        //! The total size of responses.
+        std::uint64_t bytes {0};
+
+        //! The time from sending a request to receiving its whole response, in nanoseconds.
+        Histogram latency;
+
+        //! The wall time of the run.
+        Clock::duration elapsed {Clock::duration::zero()};
+    };
+
+    /**
+     * @brief Create a load generator.
+     *
+     * @exception std::invalid_argument The options are invalid.
+     */
+    LoadGenerator(const IPAddr& server, Options options);
+
+    /**
+     * @brief Send requests for the duration and wait until all threads finish.
+     *
+     * @exception std::system_error Failed to create a poller.
+     */
+    Report Run() const;
+
+private:
+    sockaddr_storage server_ {};
+    socklen_t server_size_ {0};
+    Options options_;
+    std::vector<std::string> gets_;
+    std::string post_;
+};
+
+}  // namespace ws::bench
@@ -0,0 +1,256 @@
+#include "load_generator.h"
+
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+using namespace ws::bench;
+
+
+namespace {
+
+//! A blocking server responding to each request with a fixed message.
+class TestServer {
+public:
+    static constexpr std::string_view response {
+        "HTTP/1.1 200 OK\r\nContent-length: 5\r\n\r\nhello"};
+
+    TestServer() : listener_ {socket(AF_INET, SOCK_STREAM, 0)} {
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size {sizeof(addr)};
+        if (bind(listener_, reinterpret_cast<sockaddr*>(&addr), size) != 0
+            || listen(listener_, SOMAXCONN) != 0
+            || getsockname(listener_, reinterpret_cast<sockaddr*>(&addr),
+                           &size)
+                   != 0) {
+            close(listener_);
+            throw std::runtime_error {"Failed to start the test server"};
+        }
+
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::jthread {[this]() { Accept(); }};
+    }
+
+    ~TestServer() noexcept {
+        // Shutting down the listener wakes up the blocked `accept`.
+        shutdown(listener_, SHUT_RDWR);
+        acceptor_.join();
+        close(listener_);
+
+        const std::lock_guard lock {mtx_};
+        handlers_.clear();
+    }
+
+    std::uint16_t Port() const noexcept {
+        return port_;
+    }
+
+    std::size_t Requests() const noexcept {
+        return requests_;
+    }
+
+    std::size_t Posts() const noexcept {
+        return posts_;
+    }
+
+private:
+    void Accept() noexcept {
+        while (true) {
+            const auto socket {accept(listener_, nullptr, nullptr)};
+            if (socket < 0) {
+                return;
+            }
+
+            const std::lock_guard lock {mtx_};
+            handlers_.emplace_back([this, socket]() { Serve(socket); });
+        }
+    }
+
+    //! Respond to requests until the client closes the connection.
+    void Serve(const int socket) noexcept {
+        static constexpr std::string_view header_end {"\r\n\r\n"};
+        std::string data;
+        char buf[0x1000];
+        for (ssize_t size; (size = read(socket, buf, sizeof(buf))) > 0;) {
+            data.append(buf, static_cast<std::size_t>(size));
+            // Bodies of posted forms do not contain empty lines.
+            for (auto pos {data.find(header_end)}; pos != std::string::npos;
+                 pos = data.find(header_end)) {
+                const std::string_view request {data.data(), pos};
+                ++requests_;
+                if (request.starts_with("POST")) {
+                    ++posts_;
+                }
+
+                const auto close_after {
+                    request.find("Connection: close") != std::string::npos};
+                data.erase(0, pos + header_end.size());
+                if (write(socket, response.data(), response.size()) < 0
+                    || close_after) {
+                    close(socket);
+                    return;
+                }
+            }
+        }
+
+        close(socket);
+    }
+
+    int listener_;
+    std::uint16_t port_ {0};
+    std::atomic_size_t requests_ {0};
+    std::atomic_size_t posts_ {0};
+
+    std::mutex mtx_;
+    std::vector<std::jthread> handlers_;
+    std::jthread acceptor_;
+};
+
+Buffer MakeBuffer(const std::string_view str) noexcept {
+    Buffer buf;
+    buf.Append(str);
+    return buf;
+}
+
+}  // namespace
+
+
+TEST(BenchResponseParserTest, ParseIncrementally) {
+    ResponseParser parser;
+    auto buf {MakeBuffer("HTTP/1.1 200 OK\r\nContent-len")};
+    EXPECT_FALSE(parser.Parse(buf));
+
+    buf.Append("gth: 10\r\nConnection: keep-alive\r\n\r\nhello");
+    EXPECT_FALSE(parser.Parse(buf));
+    EXPECT_EQ(parser.StatusCode(), 200);
+    EXPECT_EQ(buf.ReadableSize(), 0);
+
+    // The body is discarded and the next response is kept.
+    buf.Append("worldHTTP/1.1");
+    EXPECT_TRUE(parser.Parse(buf));
+    EXPECT_TRUE(parser.Finished());
+    EXPECT_TRUE(parser.KeepAlive());
+    EXPECT_EQ(parser.Size(), 73);
+    EXPECT_EQ(buf.ReadableSize(), 8);
+
+    parser.Clear();
+    EXPECT_FALSE(parser.Finished());
+    EXPECT_EQ(parser.Size(), 0);
+}
+
+TEST(BenchResponseParserTest, ConnectionClose) {
+    ResponseParser parser;
+    auto buf {MakeBuffer(
+        "HTTP/1.1 404 Not Found\r\nconnection: Close\r\ncontent-length: 0\r\n\r\n")};
+    EXPECT_TRUE(parser.Parse(buf));
+    EXPECT_EQ(parser.StatusCode(), 404);
+    EXPECT_FALSE(parser.KeepAlive());
+}
+
+TEST(BenchResponseParserTest, NoBody) {
+    ResponseParser parser;
+    auto buf {MakeBuffer("HTTP/1.1 304 Not Modified\r\n\r\n")};
+    EXPECT_TRUE(parser.Parse(buf));
+    EXPECT_TRUE(parser.KeepAlive());
+}
+
+TEST(BenchResponseParserTest, EndWithConnection) {
+    ResponseParser parser;
+    EXPECT_FALSE(parser.Finish());
+
+    auto buf {MakeBuffer("HTTP/1.0 200 OK\r\n\r\nhello")};
+    EXPECT_FALSE(parser.Parse(buf));
+    EXPECT_FALSE(parser.KeepAlive());
+    EXPECT_TRUE(parser.Finish());
+    EXPECT_EQ(parser.Size(), 24);
+}
+
+TEST(BenchResponseParserTest, InvalidResponse) {
+    {
+        ResponseParser parser;
+        auto buf {MakeBuffer("HTTP/1.1 2x0 OK\r\n\r\n")};
+        EXPECT_THROW(parser.Parse(buf), std::invalid_argument);
+    }
+    {
+        ResponseParser parser;
+        auto buf {MakeBuffer("SSH-2.0\r\n\r\n")};
+        EXPECT_THROW(parser.Parse(buf), std::invalid_argument);
+    }
+    {
+        ResponseParser parser;
+        auto buf {MakeBuffer("HTTP/1.1 200 OK\r\nContent-length: -1\r\n\r\n")};
+        EXPECT_THROW(parser.Parse(buf), std::invalid_argument);
+    }
+}
+
+TEST(BenchLoadGeneratorTest, InvalidOptions) {
+    const IPv4Addr server {std::string {IPv4Addr::loop_back}, 10000};
+
+    LoadGenerator::Options options;
+    options.connections = 0;
+    EXPECT_THROW((LoadGenerator {server, options}), std::invalid_argument);
+
+    options = {};
+    options.post_percentage = 101;
+    EXPECT_THROW((LoadGenerator {server, options}), std::invalid_argument);
+
+    options = {};
+    options.paths.clear();
+    EXPECT_THROW((LoadGenerator {server, options}), std::invalid_argument);
+}
+
+TEST(BenchLoadGeneratorTest, KeepAlive) {
+    const TestServer test_server;
+    const IPv4Addr server {std::string {IPv4Addr::loop_back},
+                           test_server.Port()};
+
+    LoadGenerator::Options options;
+    options.connections = 4;
+    options.threads = 2;
+    options.duration = std::chrono::milliseconds {300};
+    options.post_percentage = 50;
+
+    const auto report {LoadGenerator {server, options}.Run()};
+    EXPECT_GT(report.responses, 0);
+    EXPECT_EQ(report.status_classes[1], report.responses);
+    EXPECT_EQ(report.connects, options.connections);
+    EXPECT_EQ(report.errors, 0);
+    EXPECT_EQ(report.bytes, report.responses * TestServer::response.size());
+    EXPECT_EQ(report.latency.Count(), report.responses);
+    EXPECT_GE(report.elapsed, options.duration);
+    EXPECT_GE(test_server.Requests(), report.responses);
+    EXPECT_GT(test_server.Posts(), 0);
+}
+
+TEST(BenchLoadGeneratorTest, ShortLived) {
+    const TestServer test_server;
+    const IPv4Addr server {std::string {IPv4Addr::loop_back},
+                           test_server.Port()};
+
+    LoadGenerator::Options options;
+    options.connections = 2;
+    options.duration = std::chrono::milliseconds {300};
+    options.keep_alive = false;
+
+    const auto report {LoadGenerator {server, options}.Run()};
+    EXPECT_GT(report.responses, 0);
+    EXPECT_EQ(report.errors, 0);
+    EXPECT_EQ(test_server.Posts(), 0);
+
+    // Each response is received on a new connection.
+    EXPECT_GE(report.connects, report.responses);
+    EXPECT_LE(report.connects, report.responses + options.connections);
+}
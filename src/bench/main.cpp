@@ -0,0 +1,193 @@
+#include "ip.h"
+#include "load_generator.h"
+
+#include <fmt/format.h>
+#include <getopt.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace ws;
+using namespace ws::bench;
+
+
+namespace {
+
+constexpr std::string_view usage {
+    "Usage: echo-bench [options]\n"
+    "\n"
+    "Send HTTP requests to an echo web server and report throughput and "
+    "latency.\n"
+    "\n"
+    "Options:\n"
+    "  -a, --address <ip>        The server address (default: 127.0.0.1)\n"
+    "  -p, --port <port>         The server port (default: 10000)\n"
+    "  -6, --ipv6                Treat the address as an IPv6 address\n"
+    "  -c, --connections <n>     The number of concurrent connections\n"
+    "                            (default: 100)\n"
+    "  -t, --threads <n>         The number of threads (default: 1)\n"
+    "  -d, --duration <seconds>  The duration of the test (default: 10)\n"
+    "  -u, --path <path>         A path of GET requests, which can be repeated\n"
+    "                            (default: /index.html and /favicon.ico)\n"
+    "  -m, --post <percentage>   The percentage of requests posting messages\n"
+    "                            to the echo page (default: 0)\n"
+    "  -s, --short-lived         Close each connection after a response\n"
+    "                            and open a new one\n"
+    "  -h, --help                Show this message\n"};
+
+/**
+ * @brief Convert an option's value to an integer.
+ *
+ * @exception std::invalid_argument The value is not an integer.
+ */
+template <typename T>
+T ToInteger(const std::string_view option, const std::string_view value) {
+    T integer {0};
+    if (const auto [ptr, error] {
+            std::from_chars(value.data(), value.data() + value.size(), integer)};
+        error != std::errc {} || ptr != value.data() + value.size()) {
+        throw std::invalid_argument {
+            fmt::format("Invalid value of '{}': '{}'", option, value)};
+    }
+
+    return integer;
+}
+
+//! Convert nanoseconds to microseconds.
+double ToMicroseconds(const std::uint64_t ns) noexcept {
+    return static_cast<double>(ns) / 1000;
+}
+
+void PrintReport(const LoadGenerator::Report& report) noexcept {
+    const auto seconds {
+        std::chrono::duration<double> {report.elapsed}.count()};
+    fmt::print("Responses: {} in {:.2f} s, {:.2f} per second, "
+               "{:.2f} MB per second\n",
+               report.responses, seconds, report.responses / seconds,
+               report.bytes / seconds / 0x100000);
+    fmt::print("Connections: {} opened, {} errors\n", report.connects,
+               report.errors);
+    fmt::print("Status: 1xx {}, 2xx {}, 3xx {}, 4xx {}, 5xx {}\n",
+               report.status_classes[0], report.status_classes[1],
+               report.status_classes[2], report.status_classes[3],
+               report.status_classes[4]);
+
+    const auto& latency {report.latency};
+    fmt::print("Latency (us): min {:.1f}, mean {:.1f}, max {:.1f}\n",
+               ToMicroseconds(latency.Min()), latency.Mean() / 1000,
+               ToMicroseconds(latency.Max()));
+
+    static constexpr std::array percentiles {50.0, 90.0, 99.0, 99.9, 99.99};
+    for (const auto percentile : percentiles) {
+        fmt::print("  p{:<6} {:>12.1f}\n", percentile,
+                   ToMicroseconds(latency.ValueAtPercentile(percentile)));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    static constexpr std::array<option, 11> long_options {
+        option {"address", required_argument, nullptr, 'a'},
+        option {"port", required_argument, nullptr, 'p'},
+        option {"ipv6", no_argument, nullptr, '6'},
+        option {"connections", required_argument, nullptr, 'c'},
+        option {"threads", required_argument, nullptr, 't'},
+        option {"duration", required_argument, nullptr, 'd'},
+        option {"path", required_argument, nullptr, 'u'},
+        option {"post", required_argument, nullptr, 'm'},
+        option {"short-lived", no_argument, nullptr, 's'},
+        option {"help", no_argument, nullptr, 'h'},
+        option {nullptr, 0, nullptr, 0}};
+
+    std::string address {IPv4Addr::loop_back};
+    std::uint16_t port {10000};
+    bool ipv6 {false};
+    LoadGenerator::Options options;
+    options.paths.clear();
+
+    try {
+        for (int opt {0};
+             (opt = getopt_long(argc, argv, "a:p:6c:t:d:u:m:sh",
+                                long_options.data(), nullptr))
+             != -1;) {
+            const std::string_view value {optarg ? optarg : ""};
+            switch (opt) {
+                case 'a':
+                    address = value;
+                    break;
+                case 'p':
+                    port = ToInteger<std::uint16_t>("port", value);
+                    break;
+                case '6':
+                    ipv6 = true;
+                    break;
+                case 'c':
+                    options.connections =
+                        ToInteger<std::size_t>("connections", value);
+                    break;
+                case 't':
+                    options.threads = ToInteger<std::size_t>("threads", value);
+                    break;
+                case 'd':
+                    options.duration = std::chrono::seconds {
+                        ToInteger<std::size_t>("duration", value)};
+                    break;
+                case 'u':
+                    options.paths.emplace_back(value);
+                    break;
+                case 'm':
+                    options.post_percentage =
+                        ToInteger<std::size_t>("post", value);
+                    break;
+                case 's':
+                    options.keep_alive = false;
+                    break;
+                case 'h':
+                    fmt::print("{}", usage);
+                    return EXIT_SUCCESS;
+                default:
+                    fmt::print(stderr, "{}", usage);
+                    return EXIT_FAILURE;
+            }
+        }
+
+        if (options.paths.empty()) {
+            options.paths = {"/index.html", "/favicon.ico"};
+        }
+
+        std::unique_ptr<IPAddr> server;
+        if (ipv6) {
+            server = std::make_unique<IPv6Addr>(address, port);
+        } else {
+            server = std::make_unique<IPv4Addr>(address, port);
+        }
+
+        options.host = fmt::format("{}:{}", ipv6 ? fmt::format("[{}]", address)
+                                                 : address,
+                                   port);
+
+        const LoadGenerator generator {*server, options};
+        fmt::print("Running for {} s with {} {} connections on {} threads "
+                   "against {}\n",
+                   std::chrono::duration_cast<std::chrono::seconds>(
+                       options.duration)
+                       .count(),
+                   options.connections,
+                   options.keep_alive ? "keep-alive" : "short-lived",
+                   std::min(options.threads, options.connections),
+                   options.host);
+        PrintReport(generator.Run());
+        return EXIT_SUCCESS;
+
+    } catch (const std::exception& err) {
+        fmt::print(stderr, "Failed to run benchmark: {}\n", err.what());
+        return EXIT_FAILURE;
+    }
+}
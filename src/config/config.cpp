@@ -87,9 +87,14 @@ void Config::LoadYaml(const YAML::Node& root) {
         const auto key {node.first};
         if (!key.empty()) {
             if (const auto var {LookupBase(key)}; var) {
-                std::ostringstream ss;
-                ss << node.second;
-                var->FromString(ss.str());
+                // Emitting scalars would quote empty strings.
+                if (node.second.IsScalar()) {
+                    var->FromString(node.second.Scalar());
+                } else {
+                    std::ostringstream ss;
+                    ss << node.second;
+                    var->FromString(ss.str());
+                }
             }
         }
     }
@@ -2,81 +2,206 @@
 #include "io.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 
 namespace ws {
 
-Buffer::Buffer(const std::size_t size) noexcept : buf_(size) {}
+std::string_view FindAnyOfInstructionSet() noexcept {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+std::size_t FindAnyOf(const std::string_view str,
+                      const std::string_view chars) noexcept {
+    const auto data {str.data()};
+    const auto size {str.size()};
+    if (chars.size() == 1) {
+        // `memchr` is vectorized by the C library.
+        const auto found {
+            static_cast<const char*>(std::memchr(data, chars.front(), size))};
+        return found ? static_cast<std::size_t>(found - data) : size;
+    }
+
+    std::size_t i {0};
+
+#if defined(__AVX2__)
+    static constexpr std::size_t block_size {32};
+    for (; i + block_size <= size; i += block_size) {
+        const auto block {_mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data + i))};
+        auto matches {_mm256_setzero_si256()};
+        for (const auto c : chars) {
+            matches = _mm256_or_si256(
+                matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c)));
+        }
+
+        if (const auto mask {static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(matches))};
+            mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    static constexpr std::size_t block_size {16};
+    for (; i + block_size <= size; i += block_size) {
+        const auto block {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))};
+        auto matches {_mm_setzero_si128()};
+        for (const auto c : chars) {
+            matches = _mm_or_si128(matches,
+                                   _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+        }
+
+        if (const auto mask {
+                static_cast<std::uint32_t>(_mm_movemask_epi8(matches))};
+            mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    static constexpr std::size_t block_size {16};
+    for (; i + block_size <= size; i += block_size) {
+        const auto block {
+            vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + i))};
+        auto matches {vdupq_n_u8(0)};
+        for (const auto c : chars) {
+            matches = vorrq_u8(
+                matches,
+                vceqq_u8(block, vdupq_n_u8(static_cast<std::uint8_t>(c))));
+        }
 
-Buffer::Buffer(const std::span<const std::byte> bytes) noexcept {
+        // Narrow each byte of results into four bits, as NEON has no byte mask.
+        const auto mask {vget_lane_u64(
+            vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)),
+            0)};
+        if (mask != 0) {
+            return i + std::countr_zero(mask) / 4;
+        }
+    }
+#endif
+
+    for (; i != size; ++i) {
+        if (chars.find(data[i]) != std::string_view::npos) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(
+    const std::size_t size) noexcept : buf_(size) {}
+
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(
+    const std::span<const std::byte> bytes) noexcept {
     Append(bytes);
 }
 
-Buffer::Buffer(const std::initializer_list<std::byte> bytes) noexcept {
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(
+    const std::initializer_list<std::byte> bytes) noexcept {
     Append(bytes.begin(), bytes.size());
 }
 
-Buffer::Buffer(const std::string_view str) noexcept {
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(const std::string_view str) noexcept {
     Append(str);
 }
 
-Buffer::Buffer(const Buffer& o) noexcept :
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(const BasicBuffer& o) noexcept :
     buf_ {o.buf_},
-    read_pos_ {o.read_pos_.load()},
-    write_pos_ {o.write_pos_.load()} {}
+    read_pos_ {static_cast<std::size_t>(o.read_pos_)},
+    write_pos_ {static_cast<std::size_t>(o.write_pos_)} {}
 
-Buffer::Buffer(Buffer&& o) noexcept :
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>::BasicBuffer(BasicBuffer&& o) noexcept :
     buf_ {std::move(o.buf_)},
-    read_pos_ {o.read_pos_.load()},
-    write_pos_ {o.write_pos_.load()} {}
+    read_pos_ {static_cast<std::size_t>(o.read_pos_)},
+    write_pos_ {static_cast<std::size_t>(o.write_pos_)} {}
 
-Buffer& Buffer::operator=(const Buffer& o) noexcept {
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>& BasicBuffer<ThreadingPolicy>::operator=(
+    const BasicBuffer& o) noexcept {
     if (this != &o) {
         buf_ = o.buf_;
-        read_pos_ = o.read_pos_.load();
-        write_pos_ = o.write_pos_.load();
+        read_pos_ = static_cast<std::size_t>(o.read_pos_);
+        write_pos_ = static_cast<std::size_t>(o.write_pos_);
     }
 
     return *this;
 }
 
-Buffer& Buffer::operator=(Buffer&& o) noexcept {
+template <typename ThreadingPolicy>
+BasicBuffer<ThreadingPolicy>& BasicBuffer<ThreadingPolicy>::operator=(
+    BasicBuffer&& o) noexcept {
     if (this != &o) {
         buf_ = std::move(o.buf_);
-        read_pos_ = o.read_pos_.load();
-        write_pos_ = o.write_pos_.load();
+        read_pos_ = static_cast<std::size_t>(o.read_pos_);
+        write_pos_ = static_cast<std::size_t>(o.write_pos_);
     }
 
     return *this;
 }
 
-std::size_t Buffer::WritableSize() const noexcept {
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::WritableSize() const noexcept {
     return buf_.size() - write_pos_;
 }
 
-std::size_t Buffer::ReadableSize() const noexcept {
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::ReadableSize() const noexcept {
     return write_pos_ - read_pos_;
 }
 
-std::size_t Buffer::PrependableSize() const noexcept {
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::PrependableSize() const noexcept {
     return read_pos_;
 }
 
-std::optional<std::byte> Buffer::Peek() const noexcept {
+template <typename ThreadingPolicy>
+std::optional<std::byte> BasicBuffer<ThreadingPolicy>::Peek() const noexcept {
     return Empty() ? std::nullopt : std::optional {*ReadIter()};
 }
 
-void Buffer::Append(const std::initializer_list<std::byte> bytes) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Append(
+    const std::initializer_list<std::byte> bytes) noexcept {
     Append(bytes.begin(), bytes.size());
 }
 
-void Buffer::Append(const std::span<const std::byte> bytes) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Append(
+    const std::span<const std::byte> bytes) noexcept {
     Append(bytes.data(), bytes.size_bytes());
 }
 
-void Buffer::Append(const std::string_view str,
-                    const std::optional<NewLine> new_line) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Append(
+    const std::string_view str,
+    const std::optional<NewLine> new_line) noexcept {
     std::string full_str {str};
     if (new_line.has_value()) {
         if (new_line == NewLine::LF) {
@@ -91,7 +216,9 @@ void Buffer::Append(const std::string_view str,
     Append(full_str.data(), full_str.length());
 }
 
-void Buffer::Append(const void* const data, const std::size_t size) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Append(
+    const void* const data, const std::size_t size) noexcept {
     if (size == 0) {
         return;
     }
@@ -106,11 +233,14 @@ void Buffer::Append(const void* const data, const std::size_t size) noexcept {
     assert(ReadableSize() >= size);
 }
 
-void Buffer::Append(const Buffer& buf) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Append(const BasicBuffer& buf) noexcept {
     Append(buf.ReadableBytes());
 }
 
-void Buffer::EnsureWriteableSize(const std::size_t size) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::EnsureWriteableSize(
+    const std::size_t size) noexcept {
     if (WritableSize() < size) {
         MakeSpace(size);
     }
@@ -118,7 +248,8 @@ void Buffer::EnsureWriteableSize(const std::size_t size) noexcept {
     assert(WritableSize() >= size);
 }
 
-void Buffer::MakeSpace(const std::size_t size) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::MakeSpace(const std::size_t size) noexcept {
     if (WritableSize() + PrependableSize() < size) {
         buf_.resize(write_pos_ + size);
     } else {
@@ -131,41 +262,121 @@ void Buffer::MakeSpace(const std::size_t size) noexcept {
     }
 }
 
-std::span<const std::byte> Buffer::ReadableBytes() const noexcept {
+template <typename ThreadingPolicy>
+std::span<const std::byte>
+BasicBuffer<ThreadingPolicy>::ReadableBytes() const noexcept {
     return {ReadIter().base(), ReadableSize()};
 }
 
-std::string Buffer::ReadableString() const noexcept {
+template <typename ThreadingPolicy>
+std::span<std::byte>
+BasicBuffer<ThreadingPolicy>::MutableReadableBytes() noexcept {
+    return {ReadIter().base(), ReadableSize()};
+}
+
+template <typename ThreadingPolicy>
+std::string BasicBuffer<ThreadingPolicy>::ReadableString() const noexcept {
     return {reinterpret_cast<char*>(ReadIter().base()), ReadableSize()};
 }
 
-std::span<std::byte> Buffer::WritableBytes() const noexcept {
+template <typename ThreadingPolicy>
+std::optional<std::size_t> BasicBuffer<ThreadingPolicy>::Find(
+    const char c, const std::size_t offset) const noexcept {
+    const auto bytes {ReadableBytes()};
+    if (offset >= bytes.size()) {
+        return std::nullopt;
+    }
+
+    // `memchr` is vectorized by the C library.
+    const auto begin {reinterpret_cast<const char*>(bytes.data())};
+    if (const auto found {static_cast<const char*>(
+            std::memchr(begin + offset, c, bytes.size() - offset))};
+        found) {
+        return found - begin;
+    } else {
+        return std::nullopt;
+    }
+}
+
+template <typename ThreadingPolicy>
+std::optional<std::size_t> BasicBuffer<ThreadingPolicy>::FindCRLF(
+    const std::size_t offset) const noexcept {
+    const auto bytes {ReadableBytes()};
+    std::size_t lf {offset};
+
+    // Only line feeds are searched for, and each one is checked for a preceding carriage return.
+    while (const auto found {Find('\n', lf + 1)}) {
+        lf = found.value();
+        if (bytes[lf - 1] == std::byte {'\r'}) {
+            return lf - 1;
+        }
+    }
+
+    return std::nullopt;
+}
+
+template <typename ThreadingPolicy>
+std::optional<std::size_t> BasicBuffer<ThreadingPolicy>::FindAny(
+    const std::string_view chars, const std::size_t offset) const noexcept {
+    const auto bytes {ReadableBytes()};
+    if (offset >= bytes.size()) {
+        return std::nullopt;
+    }
+
+    const std::string_view str {reinterpret_cast<const char*>(bytes.data()),
+                                bytes.size()};
+    if (const auto found {FindAnyOf(str.substr(offset), chars)};
+        offset + found < str.size()) {
+        return offset + found;
+    } else {
+        return std::nullopt;
+    }
+}
+
+template <typename ThreadingPolicy>
+std::span<std::byte>
+BasicBuffer<ThreadingPolicy>::WritableBytes() const noexcept {
     return {WriteIter().base(), WritableSize()};
 }
 
-void Buffer::HasWritten(const std::size_t size) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::HasWritten(const std::size_t size) noexcept {
     assert(WritableSize() >= size);
     write_pos_ += size;
 }
 
-void Buffer::Retrieve(const std::size_t size) noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Retrieve(const std::size_t size) noexcept {
     assert(ReadableSize() >= size);
     read_pos_ += size;
 }
 
-std::size_t Buffer::RetrieveAll() noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Erase(const std::size_t offset,
+                                         const std::size_t size) noexcept {
+    assert(offset + size <= ReadableSize());
+    const auto begin {ReadIter() + offset};
+    std::copy(begin + size, WriteIter(), begin);
+    write_pos_ -= size;
+}
+
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::RetrieveAll() noexcept {
     const auto read_size {ReadableSize()};
     Clear();
     return read_size;
 }
 
-std::string Buffer::RetrieveAllToString() noexcept {
+template <typename ThreadingPolicy>
+std::string BasicBuffer<ThreadingPolicy>::RetrieveAllToString() noexcept {
     const auto str {ReadableString()};
     Clear();
     return str;
 }
 
-std::size_t Buffer::RetrieveUntil(const void* const addr) noexcept {
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::RetrieveUntil(
+    const void* const addr) noexcept {
     const auto end {static_cast<const std::byte*>(addr)};
     const auto begin {ReadIter().base()};
 
@@ -176,24 +387,47 @@ std::size_t Buffer::RetrieveUntil(const void* const addr) noexcept {
     return read_size;
 }
 
-void Buffer::Clear() noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Clear() noexcept {
     read_pos_ = 0;
     write_pos_ = 0;
     assert(Empty());
 }
 
-bool Buffer::Empty() const noexcept {
+template <typename ThreadingPolicy>
+void BasicBuffer<ThreadingPolicy>::Reset(const std::size_t max_size) noexcept {
+    Clear();
+    if (buf_.size() > max_size) {
+        buf_.resize(max_size);
+        buf_.shrink_to_fit();
+    }
+}
+
+template <typename ThreadingPolicy>
+std::size_t BasicBuffer<ThreadingPolicy>::Capacity() const noexcept {
+    return buf_.size();
+}
+
+template <typename ThreadingPolicy>
+bool BasicBuffer<ThreadingPolicy>::Empty() const noexcept {
     return ReadableSize() == 0;
 }
 
-std::vector<std::byte>::iterator Buffer::ReadIter() const noexcept {
-    return const_cast<Buffer*>(this)->buf_.begin() + read_pos_;
+template <typename ThreadingPolicy>
+std::vector<std::byte>::iterator
+BasicBuffer<ThreadingPolicy>::ReadIter() const noexcept {
+    return const_cast<BasicBuffer*>(this)->buf_.begin() + read_pos_;
 }
 
-std::vector<std::byte>::iterator Buffer::WriteIter() const noexcept {
-    return const_cast<Buffer*>(this)->buf_.begin() + write_pos_;
+template <typename ThreadingPolicy>
+std::vector<std::byte>::iterator
+BasicBuffer<ThreadingPolicy>::WriteIter() const noexcept {
+    return const_cast<BasicBuffer*>(this)->buf_.begin() + write_pos_;
 }
 
+template class BasicBuffer<SingleThreaded>;
+template class BasicBuffer<MultiThreaded>;
+
 std::size_t IOBuffer::ReadFrom(io::IReadWriter& io) {
     return io.WriteTo(*this);
 }
@@ -202,6 +436,16 @@ std::size_t IOBuffer::WriteTo(io::IReadWriter& io) {
     return io.ReadFrom(*this);
 }
 
+std::size_t IOBuffer::WriteTo(io::FileDescriptor& io,
+                              const std::initializer_list<Buffer*> follows) {
+    std::array<Buffer*, io::FileDescriptor::max_gather_count> bufs;
+    assert(follows.size() < bufs.size());
+
+    bufs.front() = this;
+    std::ranges::copy(follows, std::next(bufs.begin()));
+    return io.ReadFrom(std::span {bufs.data(), follows.size() + 1});
+}
+
 Buffer& operator<<(Buffer& buf, const std::string_view str) noexcept {
     buf.Append(str);
     return buf;
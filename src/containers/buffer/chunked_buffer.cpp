@@ -0,0 +1,248 @@
+#include "chunked_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <utility>
+
+
+namespace ws {
+
+ChunkAllocator& ChunkAllocator::Global() noexcept {
+    static ChunkAllocator allocator;
+    return allocator;
+}
+
+ChunkAllocator::ChunkAllocator(const std::size_t chunk_size,
+                               const std::size_t max_free_count) noexcept :
+    chunk_size_ {chunk_size}, free_chunks_ {max_free_count} {
+    assert(chunk_size_ > 0);
+}
+
+ChunkAllocator::~ChunkAllocator() noexcept {
+    while (const auto chunk {free_chunks_.TryPop()}) {
+        ::operator delete(chunk.value());
+    }
+}
+
+std::byte* ChunkAllocator::Allocate() noexcept {
+    if (const auto chunk {free_chunks_.TryPop()}; chunk.has_value()) {
+        return chunk.value();
+    } else {
+        return static_cast<std::byte*>(::operator new(chunk_size_));
+    }
+}
+
+void ChunkAllocator::Release(std::byte* chunk) noexcept {
+    assert(chunk);
+    if (!free_chunks_.TryPush(std::move(chunk))) {
+        ::operator delete(chunk);
+    }
+}
+
+std::size_t ChunkAllocator::ChunkSize() const noexcept {
+    return chunk_size_;
+}
+
+std::size_t ChunkAllocator::FreeCount() const noexcept {
+    return free_chunks_.Size();
+}
+
+ChunkedBuffer::ChunkedBuffer(ChunkAllocator& allocator) noexcept :
+    allocator_ {&allocator} {}
+
+ChunkedBuffer::~ChunkedBuffer() noexcept {
+    Clear();
+}
+
+ChunkedBuffer::ChunkedBuffer(ChunkedBuffer&& o) noexcept :
+    allocator_ {o.allocator_},
+    chunks_ {std::move(o.chunks_)},
+    read_pos_ {std::exchange(o.read_pos_, 0)},
+    size_ {std::exchange(o.size_, 0)} {
+    o.chunks_.clear();
+}
+
+ChunkedBuffer& ChunkedBuffer::operator=(ChunkedBuffer&& o) noexcept {
+    if (this != &o) {
+        Clear();
+        allocator_ = o.allocator_;
+        chunks_ = std::move(o.chunks_);
+        o.chunks_.clear();
+        read_pos_ = std::exchange(o.read_pos_, 0);
+        size_ = std::exchange(o.size_, 0);
+    }
+
+    return *this;
+}
+
+std::size_t ChunkedBuffer::ChunkSize() const noexcept {
+    return allocator_->ChunkSize();
+}
+
+std::size_t ChunkedBuffer::WriteOffset() const noexcept {
+    return read_pos_ + size_;
+}
+
+std::size_t ChunkedBuffer::ReadableSize() const noexcept {
+    return size_;
+}
+
+std::size_t ChunkedBuffer::WritableSize() const noexcept {
+    return chunks_.size() * ChunkSize() - WriteOffset();
+}
+
+std::size_t ChunkedBuffer::ChunkCount() const noexcept {
+    return chunks_.size();
+}
+
+bool ChunkedBuffer::Empty() const noexcept {
+    return size_ == 0;
+}
+
+std::size_t ChunkedBuffer::ReadableSegments(
+    const std::span<std::span<const std::byte>> segments) const noexcept {
+    std::size_t count {0};
+    auto offset {read_pos_};
+    auto remaining {size_};
+    for (auto it {chunks_.cbegin()};
+         it != chunks_.cend() && remaining > 0 && count != segments.size();
+         ++it) {
+        const auto size {std::min(remaining, ChunkSize() - offset)};
+        segments[count++] = {*it + offset, size};
+        remaining -= size;
+        offset = 0;
+    }
+
+    return count;
+}
+
+std::size_t ChunkedBuffer::WritableSegments(
+    const std::size_t size,
+    const std::span<std::span<std::byte>> segments) noexcept {
+    EnsureWriteableSize(size);
+
+    std::size_t count {0};
+    auto index {WriteOffset() / ChunkSize()};
+    auto offset {WriteOffset() % ChunkSize()};
+    for (; index < chunks_.size() && count != segments.size(); ++index) {
+        segments[count++] = {chunks_[index] + offset, ChunkSize() - offset};
+        offset = 0;
+    }
+
+    return count;
+}
+
+void ChunkedBuffer::EnsureWriteableSize(const std::size_t size) noexcept {
+    while (WritableSize() < size) {
+        chunks_.push_back(allocator_->Allocate());
+    }
+}
+
+void ChunkedBuffer::Append(const std::span<const std::byte> bytes) noexcept {
+    EnsureWriteableSize(bytes.size());
+
+    auto data {bytes.data()};
+    auto remaining {bytes.size()};
+    while (remaining > 0) {
+        const auto index {WriteOffset() / ChunkSize()};
+        const auto offset {WriteOffset() % ChunkSize()};
+        const auto size {std::min(remaining, ChunkSize() - offset)};
+        std::memcpy(chunks_[index] + offset, data, size);
+        data += size;
+        remaining -= size;
+        size_ += size;
+    }
+}
+
+void ChunkedBuffer::Append(const std::string_view str) noexcept {
+    Append(std::as_bytes(std::span {str}));
+}
+
+void ChunkedBuffer::HasWritten(const std::size_t size) noexcept {
+    assert(WritableSize() >= size);
+    size_ += size;
+}
+
+void ChunkedBuffer::Retrieve(const std::size_t size) noexcept {
+    assert(ReadableSize() >= size);
+    size_ -= size;
+    read_pos_ += size;
+
+    // Keep the last chunk if it still has writable space.
+    while (read_pos_ >= ChunkSize() && !chunks_.empty()) {
+        allocator_->Release(chunks_.front());
+        chunks_.pop_front();
+        read_pos_ -= ChunkSize();
+    }
+
+    if (size_ == 0) {
+        // Reuse the remaining chunks from the beginning.
+        read_pos_ = 0;
+    }
+}
+
+std::string ChunkedBuffer::ReadableString() const {
+    return ReadableString(size_);
+}
+
+std::string ChunkedBuffer::ReadableString(const std::size_t size) const {
+    return ReadableString(0, size);
+}
+
+std::string ChunkedBuffer::ReadableString(const std::size_t offset,
+                                          const std::size_t size) const {
+    std::string str;
+    if (offset >= size_) {
+        return str;
+    }
+
+    auto remaining {std::min(size, size_ - offset)};
+    str.reserve(remaining);
+
+    const auto begin {read_pos_ + offset};
+    auto pos {begin % ChunkSize()};
+    for (auto it {chunks_.cbegin() + begin / ChunkSize()}; remaining > 0;
+         ++it) {
+        assert(it != chunks_.cend());
+        const auto segment_size {std::min(remaining, ChunkSize() - pos)};
+        str.append(reinterpret_cast<const char*>(*it + pos), segment_size);
+        remaining -= segment_size;
+        pos = 0;
+    }
+
+    return str;
+}
+
+std::string ChunkedBuffer::RetrieveAllToString() {
+    auto str {ReadableString()};
+    Retrieve(size_);
+    return str;
+}
+
+void ChunkedBuffer::Clear() noexcept {
+    for (const auto chunk : chunks_) {
+        allocator_->Release(chunk);
+    }
+
+    chunks_.clear();
+    read_pos_ = 0;
+    size_ = 0;
+}
+
+void ChunkedBuffer::Shrink() noexcept {
+    if (size_ == 0) {
+        Clear();
+        return;
+    }
+
+    // Keep the chunk containing the writing offset.
+    const auto used_count {(WriteOffset() + ChunkSize() - 1) / ChunkSize()};
+    while (chunks_.size() > used_count) {
+        allocator_->Release(chunks_.back());
+        chunks_.pop_back();
+    }
+}
+
+}  // namespace ws
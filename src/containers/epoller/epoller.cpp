@@ -1,5 +1,6 @@
 #include "epoller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <unordered_map>
@@ -7,9 +8,10 @@
 
 namespace ws {
 
-Epoller::Epoller(const std::size_t capacity) : epoll_fd_ {epoll_create1(0)} {
-    assert(capacity > 0);
-    events_.resize(capacity);
+Epoller::Epoller(const std::size_t capacity) :
+    epoll_fd_ {epoll_create1(0)}, capacity_ {capacity} {
+    assert(capacity_ > 0 && capacity_ <= std::numeric_limits<int>::max());
+    events_.resize(std::min(capacity_, min_event_count));
     if (!IsValidFileDescriptor(epoll_fd_)) {
         ThrowLastSystemError();
     }
@@ -77,18 +79,51 @@ void Epoller::SetFileDescriptor(const Control ctl, const ws::FileDescriptor fd,
     }
 }
 
-std::size_t Epoller::Wait(const Clock::duration time_out) {
-    const auto size {events_.size()};
-    assert(size <= std::numeric_limits<int>::max());
+std::size_t Epoller::WaitForEvents(
+    const std::optional<Clock::duration> time_out) {
+    const auto size {static_cast<int>(events_.size())};
+
+    int ready_count {0};
+    if (precise_wait_) {
+        // A null time-out makes `epoll_pwait2` block indefinitely.
+        timespec ts {};
+        if (time_out.has_value()) {
+            const auto ns {std::max(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    time_out.value())
+                    .count(),
+                std::chrono::nanoseconds::rep {0})};
+            ts.tv_sec = ns / 1'000'000'000;
+            ts.tv_nsec = ns % 1'000'000'000;
+        }
+
+        ready_count = epoll_pwait2(epoll_fd_, events_.data(), size,
+                                   time_out.has_value() ? &ts : nullptr,
+                                   nullptr);
+        if (ready_count < 0
+            && static_cast<std::errc>(errno)
+                   == std::errc::function_not_supported) {
+            // The kernel is older than Linux 5.11.
+            precise_wait_ = false;
+        }
+    }
 
-    const auto milliseconds {
-        std::chrono::duration_cast<std::chrono::milliseconds>(time_out)
-            .count()};
-    assert(milliseconds <= std::numeric_limits<int>::max());
+    if (!precise_wait_) {
+        // A negative time-out makes `epoll_wait` block indefinitely.
+        // Round up the time-out, so a wait does not return before it expires.
+        const auto milliseconds {
+            time_out.has_value()
+                ? std::chrono::ceil<std::chrono::milliseconds>(
+                      std::max(time_out.value(), Clock::duration::zero()))
+                      .count()
+                : -1};
+        assert(milliseconds <= std::numeric_limits<int>::max());
+        ready_count = epoll_wait(epoll_fd_, events_.data(), size,
+                                 static_cast<int>(milliseconds));
+    }
 
-    if (const auto ready_count {
-            epoll_wait(epoll_fd_, events_.data(), size, milliseconds)};
-        ready_count >= 0) {
+    if (ready_count >= 0) {
+        Adapt(ready_count);
         return ready_count;
     } else if (static_cast<std::errc>(errno) == std::errc::interrupted) {
         // Some signal handlers will interrupt `epoll_wait` and similar system calls on any Linux.
@@ -100,4 +135,22 @@ std::size_t Epoller::Wait(const Clock::duration time_out) {
     }
 }
 
-}  // namespace ws
\ No newline at end of file
+void Epoller::Adapt(const std::size_t ready_count) noexcept {
+    const auto size {events_.size()};
+    if (ready_count == size && size < capacity_) {
+        // More file descriptors may be ready, let the next wait return more of them.
+        events_.resize(std::min(size * 2, capacity_));
+        sparse_wait_count_ = 0;
+    } else if (ready_count <= size / 4 && size > min_event_count) {
+        if (++sparse_wait_count_ == shrink_wait_count) {
+            // Keep the ready events, as they may not have been read.
+            events_.resize(std::max(size / 2, min_event_count));
+            events_.shrink_to_fit();
+            sparse_wait_count_ = 0;
+        }
+    } else {
+        sparse_wait_count_ = 0;
+    }
+}
+
+}  // namespace ws
@@ -0,0 +1,364 @@
+#include "io_uring_poller.h"
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+
+namespace ws {
+
+namespace {
+
+//! The user data of requests whose completions are always ignored.
+constexpr std::uint64_t control_user_data {
+    std::numeric_limits<std::uint64_t>::max()};
+
+int Setup(const unsigned entries, io_uring_params& params) noexcept {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int Enter(const FileDescriptor ring_fd, const unsigned to_submit,
+          const unsigned min_complete, const unsigned flags,
+          const void* const arg = nullptr,
+          const std::size_t arg_size = 0) noexcept {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                    min_complete, flags, arg, arg_size));
+}
+
+//! Combine a file descriptor and its generation into the user data of a request.
+constexpr std::uint64_t ToUserData(const FileDescriptor fd,
+                                   const std::uint32_t generation) noexcept {
+    return (static_cast<std::uint64_t>(generation) << 32)
+           | static_cast<std::uint32_t>(fd);
+}
+
+constexpr FileDescriptor ToFileDescriptor(const std::uint64_t data) noexcept {
+    return static_cast<FileDescriptor>(data & 0xFFFFFFFF);
+}
+
+constexpr std::uint32_t ToGeneration(const std::uint64_t data) noexcept {
+    return static_cast<std::uint32_t>(data >> 32);
+}
+
+template <typename T>
+T LoadAcquire(T* const ptr) noexcept {
+    return std::atomic_ref<T> {*ptr}.load(std::memory_order_acquire);
+}
+
+template <typename T>
+void StoreRelease(T* const ptr, const T val) noexcept {
+    std::atomic_ref<T> {*ptr}.store(val, std::memory_order_release);
+}
+
+}  // namespace
+
+IoUringPoller::IoUringPoller(const std::size_t capacity) {
+    assert(capacity > 0 && capacity <= std::numeric_limits<unsigned>::max());
+    events_.resize(capacity);
+
+    io_uring_params params {};
+    params.flags = IORING_SETUP_CLAMP;
+    ring_fd_ = Setup(static_cast<unsigned>(capacity), params);
+    if (!IsValidFileDescriptor(ring_fd_)) {
+        ThrowLastSystemError();
+    }
+
+    bool failed {true};
+    const RAII raii {this, [&failed](IoUringPoller* const poller) noexcept {
+                         if (failed) {
+                             poller->Close();
+                         }
+                     }};
+
+    // Waiting with a time-out needs `IORING_FEAT_EXT_ARG` (Linux 5.11).
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)
+        || !(params.features & IORING_FEAT_EXT_ARG)) {
+        throw std::system_error {
+            std::make_error_code(std::errc::not_supported),
+            "The kernel does not support the required io_uring features"};
+    }
+
+    ring_size_ = std::max(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring_ = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_ == MAP_FAILED) {
+        ring_ = nullptr;
+        ThrowLastSystemError();
+    }
+
+    entry_count_ = params.sq_entries;
+    const auto entries {mmap(nullptr, entry_count_ * sizeof(io_uring_sqe),
+                             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring_fd_, IORING_OFF_SQES)};
+    if (entries == MAP_FAILED) {
+        ThrowLastSystemError();
+    }
+
+    entries_ = static_cast<io_uring_sqe*>(entries);
+
+    const auto ring {static_cast<std::byte*>(ring_)};
+    sq_head_ = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    cq_entries_ = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+    failed = false;
+}
+
+IoUringPoller::~IoUringPoller() noexcept {
+    Close();
+}
+
+void IoUringPoller::Close() noexcept {
+    if (entries_) {
+        munmap(entries_, entry_count_ * sizeof(io_uring_sqe));
+        entries_ = nullptr;
+    }
+
+    if (ring_) {
+        munmap(ring_, ring_size_);
+        ring_ = nullptr;
+    }
+
+    if (IsValidFileDescriptor(ring_fd_)) {
+        close(ring_fd_);
+        ring_fd_ = invalid_file_descriptor;
+    }
+}
+
+std::uint32_t IoUringPoller::Events(const std::size_t idx) const noexcept {
+    assert(ValidIndex(idx));
+    return events_[idx].events;
+}
+
+FileDescriptor IoUringPoller::FileDescriptor(
+    const std::size_t idx) const noexcept {
+    assert(ValidIndex(idx));
+    return events_[idx].fd;
+}
+
+bool IoUringPoller::ValidIndex(const std::size_t idx) const noexcept {
+    return idx < events_.size();
+}
+
+void IoUringPoller::AddFileDescriptor(const ws::FileDescriptor fd,
+                                      const std::uint32_t events) {
+    assert(IsValidFileDescriptor(fd));
+
+    const std::lock_guard locker {mtx_};
+    if (targets_.size() <= static_cast<std::size_t>(fd)) {
+        targets_.resize(fd + 1);
+    }
+
+    auto& target {targets_[fd]};
+    if (target.registered) {
+        throw std::system_error {std::make_error_code(std::errc::file_exists)};
+    }
+
+    target.registered = true;
+    target.events = events;
+    Arm(fd, target);
+}
+
+void IoUringPoller::DeleteFileDescriptor(const ws::FileDescriptor fd) {
+    const std::lock_guard locker {mtx_};
+    auto& target {RegisteredTarget(fd)};
+    Disarm(fd, target);
+    target.registered = false;
+}
+
+void IoUringPoller::ModifyFileDescriptor(const ws::FileDescriptor fd,
+                                         const std::uint32_t events) {
+    const std::lock_guard locker {mtx_};
+    auto& target {RegisteredTarget(fd)};
+    Disarm(fd, target);
+    target.events = events;
+    Arm(fd, target);
+
+    // The waiting thread cannot see the request until its next wait.
+    if (waiter_.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+        Submit();
+    }
+}
+
+IoUringPoller::Target& IoUringPoller::RegisteredTarget(
+    const ws::FileDescriptor fd) {
+    assert(IsValidFileDescriptor(fd));
+    if (static_cast<std::size_t>(fd) >= targets_.size()
+        || !targets_[fd].registered) {
+        throw std::system_error {
+            std::make_error_code(std::errc::no_such_file_or_directory)};
+    }
+
+    return targets_[fd];
+}
+
+io_uring_sqe& IoUringPoller::NextEntry() {
+    const auto tail {*sq_tail_};
+    if (tail - LoadAcquire(sq_head_) == entry_count_) {
+        Submit();
+    }
+
+    const auto idx {tail & sq_mask_};
+    auto& entry {entries_[idx]};
+    std::memset(&entry, 0, sizeof(entry));
+    sq_array_[idx] = idx;
+    return entry;
+}
+
+void IoUringPoller::CommitEntry() noexcept {
+    StoreRelease(sq_tail_, *sq_tail_ + 1);
+}
+
+void IoUringPoller::Arm(const ws::FileDescriptor fd, Target& target) {
+    auto& entry {NextEntry()};
+    entry.opcode = IORING_OP_POLL_ADD;
+    entry.fd = fd;
+    entry.poll32_events = target.events & ~(EPOLLONESHOT | EPOLLET);
+    if (!(target.events & EPOLLONESHOT)) {
+        entry.len = IORING_POLL_ADD_MULTI;
+    }
+
+    entry.user_data = ToUserData(fd, target.generation);
+    CommitEntry();
+    target.armed = true;
+}
+
+void IoUringPoller::Disarm(const ws::FileDescriptor fd, Target& target) {
+    if (target.armed) {
+        auto& entry {NextEntry()};
+        entry.opcode = IORING_OP_POLL_REMOVE;
+        entry.fd = -1;
+        entry.addr = ToUserData(fd, target.generation);
+        entry.user_data = control_user_data;
+        CommitEntry();
+        target.armed = false;
+    }
+
+    // Ignore the completions of earlier requests.
+    ++target.generation;
+}
+
+void IoUringPoller::Submit() {
+    if (Enter(ring_fd_, entry_count_, 0, 0) < 0) {
+        ThrowLastSystemError();
+    }
+}
+
+std::size_t IoUringPoller::WaitForEvents(
+    const std::optional<Clock::duration> time_out) {
+    waiter_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    const auto deadline {time_out.has_value()
+                             ? std::optional {Clock::now() + time_out.value()}
+                             : std::nullopt};
+    while (true) {
+        __kernel_timespec ts {};
+        io_uring_getevents_arg arg {};
+        if (deadline.has_value()) {
+            const auto ns {std::max(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    deadline.value() - Clock::now())
+                    .count(),
+                std::chrono::nanoseconds::rep {0})};
+            ts.tv_sec = ns / 1'000'000'000;
+            ts.tv_nsec = ns % 1'000'000'000;
+            arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+        }
+
+        // Submit all queued requests and wait for completions in a single system call.
+        // The kernel submits only the requests that have been committed.
+        if (Enter(ring_fd_, entry_count_, 1,
+                  IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                  sizeof(arg))
+            < 0) {
+            switch (static_cast<std::errc>(errno)) {
+                case std::errc::stream_timeout:
+                case std::errc::interrupted: {
+                    // `ETIME` means a time-out.
+                    const std::lock_guard locker {mtx_};
+                    return Reap();
+                }
+                case std::errc::device_or_resource_busy: {
+                    // The completion queue is full, reap it now.
+                    break;
+                }
+                default: {
+                    ThrowLastSystemError();
+                }
+            }
+        }
+
+        // Completions of cancelled requests are ignored.
+        // Keep waiting if all completions are ignored, so waking up without events means a time-out like `epoll`.
+        const std::lock_guard locker {mtx_};
+        if (const auto count {Reap()};
+            count > 0
+            || (deadline.has_value() && Clock::now() >= deadline.value())) {
+            return count;
+        }
+    }
+}
+
+std::size_t IoUringPoller::Reap() {
+    std::size_t count {0};
+    auto head {*cq_head_};
+    const auto tail {LoadAcquire(cq_tail_)};
+
+    // The remaining completions will be reaped in the next wait.
+    while (head != tail && count != events_.size()) {
+        const auto& completion {cq_entries_[head & cq_mask_]};
+        ++head;
+        if (completion.user_data == control_user_data) {
+            continue;
+        }
+
+        const auto fd {ToFileDescriptor(completion.user_data)};
+        if (static_cast<std::size_t>(fd) >= targets_.size()) {
+            continue;
+        }
+
+        auto& target {targets_[fd]};
+        if (!target.registered
+            || target.generation != ToGeneration(completion.user_data)) {
+            // The request was issued before the file descriptor was removed or modified.
+            continue;
+        }
+
+        if (!(completion.flags & IORING_CQE_F_MORE)) {
+            target.armed = false;
+        }
+
+        if (completion.res > 0) {
+            events_[count++] = {.fd = fd,
+                                .events
+                                = static_cast<std::uint32_t>(completion.res)};
+        } else if (completion.res < 0) {
+            events_[count++] = {.fd = fd, .events = EPOLLERR};
+        }
+
+        if (!target.armed && !(target.events & EPOLLONESHOT)) {
+            // A multi-shot request can be terminated by the kernel.
+            ++target.generation;
+            Arm(fd, target);
+        }
+    }
+
+    StoreRelease(cq_head_, head);
+    return count;
+}
+
+}  // namespace ws
@@ -0,0 +1,89 @@
+#include "poller.h"
+#include "epoller.h"
+#include "io_uring_poller.h"
+#include "metrics.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+namespace ws {
+
+namespace {
+
+//! Get the histogram of the number of events returned by each wait.
+metrics::Histogram& EventsPerWait() noexcept {
+    static auto& histogram {metrics::DefaultRegistry().AddHistogram(
+        "ws_poller_events_per_wait",
+        "The number of events returned by each wait of pollers",
+        {0, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024})};
+    return histogram;
+}
+
+}  // namespace
+
+Poller::Ptr Poller::Create(const Options& options) {
+    Ptr poller;
+    switch (options.backend) {
+        case Backend::Epoll: {
+            poller = std::make_unique<Epoller>(options.max_events);
+            break;
+        }
+        case Backend::IoUring: {
+            poller = std::make_unique<IoUringPoller>(options.max_events);
+            break;
+        }
+        default: {
+            assert(false);
+        }
+    }
+
+    poller->SetBusyPoll(options.busy_poll);
+    return poller;
+}
+
+Poller::Backend Poller::ToBackend(const std::string_view name) {
+    if (name == "epoll") {
+        return Backend::Epoll;
+    } else if (name == "io_uring") {
+        return Backend::IoUring;
+    } else {
+        throw std::invalid_argument {
+            fmt::format("Invalid poller backend: '{}'", name)};
+    }
+}
+
+void Poller::SetBusyPoll(const Clock::duration time) noexcept {
+    busy_poll_ = std::max(time, Clock::duration::zero());
+}
+
+std::size_t Poller::Wait(std::optional<Clock::duration> time_out) {
+    if (busy_poll_ > Clock::duration::zero()
+        && time_out != Clock::duration::zero()) {
+        const auto start {Clock::now()};
+        const auto spin_time {time_out.has_value()
+                                  ? std::min(time_out.value(), busy_poll_)
+                                  : busy_poll_};
+        do {
+            if (const auto count {WaitForEvents(Clock::duration::zero())};
+                count > 0) {
+                EventsPerWait().Observe(count);
+                return count;
+            }
+        } while (Clock::now() - start < spin_time);
+
+        if (time_out.has_value()) {
+            time_out = std::max(time_out.value() - (Clock::now() - start),
+                                Clock::duration::zero());
+        }
+    }
+
+    const auto count {WaitForEvents(time_out)};
+    EventsPerWait().Observe(count);
+    return count;
+}
+
+}  // namespace ws
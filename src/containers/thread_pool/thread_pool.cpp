@@ -2,13 +2,39 @@
 #include "util.h"
 
 #include <cassert>
+#include <string>
 
 
 namespace ws {
 
+void Executor::SetAffinity(std::vector<std::size_t> cpus) noexcept {
+    cpus_ = std::move(cpus);
+}
+
+const std::vector<std::size_t>& Executor::Affinity() const noexcept {
+    return cpus_;
+}
+
+void Executor::PinWorker(std::thread& thread, const std::size_t idx) const {
+    if (!cpus_.empty()) {
+        const auto cpu {cpus_[idx % cpus_.size()]};
+        SetThreadAffinity(thread.native_handle(), {&cpu, 1});
+    }
+}
+
 ThreadPool::ThreadPool(const std::optional<std::size_t> thread_count,
-                       log::Logger::Ptr logger) noexcept :
-    logger_ {std::move(logger)} {
+                       log::Logger::Ptr logger,
+                       const std::string_view pool) noexcept :
+    logger_ {std::move(logger)},
+    queued_tasks_ {metrics::DefaultRegistry().AddGauge(
+        "ws_thread_pool_queued_tasks",
+        "The number of tasks waiting in thread pools",
+        {{"pool", std::string {pool}}})},
+    task_latency_ {metrics::DefaultRegistry().AddHistogram(
+        "ws_thread_pool_task_latency_seconds",
+        "The time from pushing a task to starting it",
+        metrics::Histogram::latency_bounds, 1e-9,
+        {{"pool", std::string {pool}}})} {
     if (!logger_) {
         logger_ = log::RootLogger();
     }
@@ -30,18 +56,56 @@ ThreadPool::~ThreadPool() noexcept {
 void ThreadPool::Start() noexcept {
     assert(closed_);
     closed_ = false;
-    for (auto i {0}; i != thread_count_; ++i) {
-        threads_.emplace_back(&ThreadPool::ExecProc, this);
+    for (std::size_t i {0}; i != thread_count_; ++i) {
+        auto& thread {threads_.emplace_back(&ThreadPool::ExecProc, this)};
+        try {
+            PinWorker(thread, i);
+        } catch (const std::system_error& err) {
+            WS_LOG_WARN(logger_, "Failed to pin working thread {}: {}", i,
+                        err.what());
+        }
     }
 }
 
 void ThreadPool::Push(Task task) noexcept {
     assert(!closed_);
     const std::lock_guard locker {mtx_};
-    tasks_.push_back(std::move(task));
+    Enqueue(std::move(task));
     cond_.notify_one();
 }
 
+void ThreadPool::PushBatch(const std::span<Task> tasks) noexcept {
+    assert(!closed_);
+    if (tasks.empty()) {
+        return;
+    }
+
+    const std::lock_guard locker {mtx_};
+    for (auto& task : tasks) {
+        Enqueue(std::move(task));
+    }
+
+    if (tasks.size() >= thread_count_) {
+        cond_.notify_all();
+    } else {
+        for (std::size_t i {0}; i != tasks.size(); ++i) {
+            cond_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Enqueue(Task task) noexcept {
+    QueuedTask queued {std::move(task), std::chrono::steady_clock::now()};
+    if (!free_tasks_.empty()) {
+        tasks_.splice(tasks_.cend(), free_tasks_, free_tasks_.cbegin());
+        tasks_.back() = std::move(queued);
+    } else {
+        tasks_.push_back(std::move(queued));
+    }
+
+    queued_tasks_.Increase();
+}
+
 void ThreadPool::ExecProc() noexcept {
     const auto not_empty_or_closed {[this]() noexcept {
         // Working threads may not have started to wait when closing the thread pool.
@@ -53,17 +117,26 @@ void ThreadPool::ExecProc() noexcept {
 
     while (true) {
         Task task;
+        std::chrono::steady_clock::time_point pushed;
         {
             std::unique_lock locker {mtx_};
             cond_.wait(locker, not_empty_or_closed);
             if (!closed_) {
-                task = std::move(tasks_.front());
-                tasks_.pop_front();
+                task = std::move(tasks_.front().task);
+                pushed = tasks_.front().pushed;
+                free_tasks_.splice(free_tasks_.cend(), tasks_,
+                                   tasks_.cbegin());
             } else {
                 return;
             }
         }
 
+        queued_tasks_.Decrease();
+        task_latency_.Observe(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - pushed)
+                .count()));
+
         try {
             assert(task);
             task();
@@ -77,8 +150,18 @@ void ThreadPool::ExecProc() noexcept {
 
 void ThreadPool::Close() noexcept {
     const std::lock_guard locker {mtx_};
+    if (!closed_) {
+        // The remaining tasks are dropped.
+        queued_tasks_.Decrease(static_cast<std::int64_t>(tasks_.size()));
+    }
+
     closed_ = true;
     cond_.notify_all();
 }
 
+std::size_t ThreadPool::QueuedCount() const noexcept {
+    const std::lock_guard locker {mtx_};
+    return closed_ ? 0 : tasks_.size();
+}
+
 }  // namespace ws
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "work_stealing_thread_pool.h"
+
+#include <cassert>
+
+
+namespace ws {
+
+namespace {
+
+//! The thread pool that the current working thread belongs to.
+thread_local const WorkStealingThreadPool* curr_pool {nullptr};
+
+//! The index of the current working thread in its thread pool.
+thread_local std::size_t curr_worker {0};
+
+//! The label of work-stealing thread pools in metrics.
+const metrics::Labels pool_labels {{"pool", "work-stealing"}};
+
+}  // namespace
+
+WorkStealingThreadPool::Worker::Worker(const std::size_t capacity) noexcept :
+    tasks {capacity} {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const std::optional<std::size_t> thread_count, log::Logger::Ptr logger,
+    const std::size_t queue_capacity) noexcept :
+    logger_ {std::move(logger)},
+    injection_ {queue_capacity},
+    free_tasks_ {queue_capacity},
+    queued_tasks_ {metrics::DefaultRegistry().AddGauge(
+        "ws_thread_pool_queued_tasks",
+        "The number of tasks waiting in thread pools", pool_labels)},
+    task_latency_ {metrics::DefaultRegistry().AddHistogram(
+        "ws_thread_pool_task_latency_seconds",
+        "The time from pushing a task to starting it",
+        metrics::Histogram::latency_bounds, 1e-9, pool_labels)} {
+    if (!logger_) {
+        logger_ = log::RootLogger();
+    }
+
+    thread_count_ = thread_count.value_or(0);
+    if (thread_count_ == 0) {
+        thread_count_ = std::thread::hardware_concurrency();
+    }
+
+    for (std::size_t i {0}; i != thread_count_; ++i) {
+        workers_.push_back(std::make_unique<Worker>(queue_capacity));
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() noexcept {
+    Close();
+    for (const auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    Clear();
+}
+
+void WorkStealingThreadPool::Start() noexcept {
+    assert(closed_);
+    closed_ = false;
+
+    // Deques must all exist before any working thread starts to steal.
+    for (std::size_t i {0}; i != workers_.size(); ++i) {
+        workers_[i]->thread =
+            std::thread {&WorkStealingThreadPool::ExecProc, this, i};
+        try {
+            PinWorker(workers_[i]->thread, i);
+        } catch (const std::system_error& err) {
+            WS_LOG_WARN(logger_, "Failed to pin working thread {}: {}", i,
+                        err.what());
+        }
+    }
+}
+
+void WorkStealingThreadPool::Push(Task task) noexcept {
+    assert(!closed_);
+    if (Enqueue(std::move(task))) {
+        Notify();
+    }
+}
+
+void WorkStealingThreadPool::PushBatch(const std::span<Task> tasks) noexcept {
+    assert(!closed_);
+    std::size_t count {0};
+    for (auto& task : tasks) {
+        if (Enqueue(std::move(task))) {
+            ++count;
+        }
+    }
+
+    if (count > 0) {
+        Notify(count);
+    }
+}
+
+bool WorkStealingThreadPool::Enqueue(Task task) noexcept {
+    auto item {Allocate(std::move(task))};
+    if (curr_pool != this || !workers_[curr_worker]->tasks.Push(item)) {
+        while (!injection_.TryPush(std::move(item))) {
+            if (closed_) {
+                Recycle(item);
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    queued_count_.fetch_add(1, std::memory_order_relaxed);
+    queued_tasks_.Increase();
+    return true;
+}
+
+std::size_t WorkStealingThreadPool::QueuedCount() const noexcept {
+    return queued_count_.load(std::memory_order_relaxed);
+}
+
+void WorkStealingThreadPool::Close() noexcept {
+    closed_ = true;
+    epoch_.fetch_add(1, std::memory_order_release);
+    epoch_.notify_all();
+}
+
+void WorkStealingThreadPool::Notify(const std::size_t count) noexcept {
+    assert(count > 0);
+
+    // Pair with the fence in `Park`,
+    // so either the task is visible to a parking thread or the thread is visible here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (const auto parked_count {parked_count_.load(std::memory_order_relaxed)};
+        parked_count > 0) {
+        epoch_.fetch_add(1, std::memory_order_release);
+        if (count >= parked_count) {
+            epoch_.notify_all();
+        } else {
+            for (std::size_t i {0}; i != count; ++i) {
+                epoch_.notify_one();
+            }
+        }
+    }
+}
+
+void WorkStealingThreadPool::ExecProc(const std::size_t index) noexcept {
+    curr_pool = this;
+    curr_worker = index;
+
+    while (!closed_) {
+        auto task {FindTask(index)};
+        for (std::size_t i {0}; !task && i != spin_count && !closed_; ++i) {
+            std::this_thread::yield();
+            task = FindTask(index);
+        }
+
+        if (!task && !closed_) {
+            task = Park(index);
+        }
+
+        if (task) {
+            Run(task);
+        }
+    }
+}
+
+WorkStealingThreadPool::QueuedTask* WorkStealingThreadPool::FindTask(
+    const std::size_t index) noexcept {
+    if (const auto task {workers_[index]->tasks.Pop()}; task.has_value()) {
+        return task.value();
+    }
+
+    if (const auto task {injection_.TryPop()}; task.has_value()) {
+        return task.value();
+    }
+
+    return Steal(index);
+}
+
+WorkStealingThreadPool::QueuedTask* WorkStealingThreadPool::Steal(
+    const std::size_t index) noexcept {
+    // Start from the next working thread so victims are spread out.
+    for (std::size_t i {1}; i < workers_.size(); ++i) {
+        const auto victim {(index + i) % workers_.size()};
+        if (const auto task {workers_[victim]->tasks.Steal()};
+            task.has_value()) {
+            return task.value();
+        }
+    }
+
+    return nullptr;
+}
+
+WorkStealingThreadPool::QueuedTask* WorkStealingThreadPool::Park(
+    const std::size_t index) noexcept {
+    const auto epoch {epoch_.load(std::memory_order_acquire)};
+    parked_count_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Check again in case a task was pushed before the thread became visible as parked.
+    auto task {FindTask(index)};
+    if (!task && !closed_) {
+        epoch_.wait(epoch, std::memory_order_acquire);
+    }
+
+    parked_count_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+WorkStealingThreadPool::QueuedTask* WorkStealingThreadPool::Allocate(
+    Task task) noexcept {
+    const auto now {std::chrono::steady_clock::now()};
+    if (const auto item {free_tasks_.TryPop()}; item.has_value()) {
+        item.value()->task = std::move(task);
+        item.value()->pushed = now;
+        return item.value();
+    } else {
+        return new QueuedTask {std::move(task), now};
+    }
+}
+
+void WorkStealingThreadPool::Recycle(QueuedTask* task) noexcept {
+    assert(task);
+    task->task.Reset();
+    if (!free_tasks_.TryPush(std::move(task))) {
+        delete task;
+    }
+}
+
+void WorkStealingThreadPool::Run(QueuedTask* const task) noexcept {
+    assert(task && task->task);
+    queued_count_.fetch_sub(1, std::memory_order_relaxed);
+    queued_tasks_.Decrease();
+    task_latency_.Observe(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - task->pushed)
+            .count()));
+
+    try {
+        task->task();
+    } catch (const std::exception& err) {
+        logger_->Log(
+            log::Event::Create(log::Level::Error) << fmt::format(
+                "Exception raised in thread pool's task: {}", err.what()));
+    }
+
+    Recycle(task);
+}
+
+void WorkStealingThreadPool::Clear() noexcept {
+    // The remaining tasks are dropped.
+    while (const auto task {injection_.TryPop()}) {
+        queued_count_.fetch_sub(1, std::memory_order_relaxed);
+        queued_tasks_.Decrease();
+        delete task.value();
+    }
+
+    for (const auto& worker : workers_) {
+        while (const auto task {worker->tasks.Steal()}) {
+            queued_count_.fetch_sub(1, std::memory_order_relaxed);
+            queued_tasks_.Decrease();
+            delete task.value();
+        }
+    }
+
+    while (const auto task {free_tasks_.TryPop()}) {
+        delete task.value();
+    }
+}
+
+}  // namespace ws
@@ -0,0 +1,253 @@
+#include "asset_cache.h"
+#include "compression.h"
+#include "io.h"
+#include "response.h"
+
+#include <sys/stat.h>
+
+#include <cassert>
+#include <filesystem>
+#include <system_error>
+
+
+namespace ws::http {
+
+std::shared_ptr<Asset> Asset::Load(const ReadOnlyFile& file) {
+    assert(file.Valid());
+
+    auto asset {std::make_shared<Asset>()};
+    asset->modification_time = file.ModificationTime();
+    asset->content = file.ReadAll();
+    return asset;
+}
+
+std::shared_ptr<Asset> Asset::Map(const ReadOnlyFile& file) {
+    assert(file.Valid());
+
+    auto mapping {std::make_shared<MappedReadOnlyFile>()};
+    const auto data {mapping->Map(file)};
+    auto asset {std::make_shared<Asset>()};
+    asset->modification_time = file.ModificationTime();
+    asset->mapped = {data, mapping->Size()};
+    asset->mapping = std::move(mapping);
+    return asset;
+}
+
+void Asset::BuildHeaders(const std::string_view path) noexcept {
+    const auto validators {GetValidators()};
+    const auto size {Content().size()};
+
+    Buffer buf;
+    Response response {""};
+    response.SetContentType(std::string {content_type});
+    response.SetKeepAlive(true).Build(buf, path, size, encoding, &validators);
+    keep_alive_header = buf.RetrieveAllToString();
+    response.BuildNotModified(buf, validators);
+    not_modified_keep_alive_header = buf.RetrieveAllToString();
+
+    response.SetKeepAlive(false).Build(buf, path, size, encoding, &validators);
+    close_header = buf.RetrieveAllToString();
+    response.BuildNotModified(buf, validators);
+    not_modified_close_header = buf.RetrieveAllToString();
+}
+
+std::string_view Asset::Header(const bool keep_alive,
+                               const bool not_modified) const noexcept {
+    if (not_modified) {
+        return keep_alive ? not_modified_keep_alive_header
+                          : not_modified_close_header;
+    } else {
+        return keep_alive ? keep_alive_header : close_header;
+    }
+}
+
+Validators Asset::GetValidators() const noexcept {
+    return {.etag = etag, .last_modified = modification_time};
+}
+
+std::span<const std::byte> Asset::Content() const noexcept {
+    return mapping ? mapped : std::span<const std::byte> {content};
+}
+
+std::shared_ptr<const Asset> Asset::Variant(
+    const ContentEncodings encodings) const noexcept {
+    if (encodings.Empty()) {
+        return nullptr;
+    }
+
+    for (const auto& variant : variants) {
+        if (encodings.Contains(variant->encoding)) {
+            return variant;
+        }
+    }
+
+    return nullptr;
+}
+
+std::size_t Asset::TotalSize() const noexcept {
+    auto size {Content().size()};
+    for (const auto& variant : variants) {
+        size += variant->Content().size();
+    }
+
+    return size;
+}
+
+AssetCache::AssetCache(const std::size_t capacity,
+                       const Clock::duration revalidation_interval,
+                       const bool compression) noexcept :
+    capacity_ {capacity},
+    revalidation_interval_ {revalidation_interval},
+    compression_ {compression} {}
+
+std::shared_ptr<const Asset> AssetCache::Find(
+    const std::filesystem::path& path) {
+    const std::string key {path};
+    std::shared_ptr<const Asset> cached;
+    {
+        const std::lock_guard locker {mtx_};
+        const auto index {indices_.find(key)};
+        if (index == indices_.cend()) {
+            return nullptr;
+        }
+
+        const auto entry {index->second};
+        entries_.splice(entries_.begin(), entries_, entry);
+        if (Clock::now() - entry->validation_time < revalidation_interval_) {
+            return entry->asset;
+        }
+
+        cached = entry->asset;
+    }
+
+    // Check the file without holding the lock.
+    const auto unchanged {Unchanged(key, *cached)};
+
+    const std::lock_guard locker {mtx_};
+    if (const auto index {indices_.find(key)};
+        index != indices_.cend() && index->second->asset == cached) {
+        if (unchanged) {
+            index->second->validation_time = Clock::now();
+        } else {
+            Erase(index->second);
+        }
+    }
+
+    return unchanged ? cached : nullptr;
+}
+
+std::shared_ptr<const Asset> AssetCache::Insert(
+    const std::filesystem::path& path, const ReadOnlyFile& file) {
+    std::string key {path};
+    if (file.Size() > max_file_size || file.Size() > capacity_) {
+        return nullptr;
+    }
+
+    auto asset {Load(key, file)};
+    const auto size {asset->TotalSize()};
+    if (size > capacity_) {
+        return nullptr;
+    }
+
+    const std::lock_guard locker {mtx_};
+    if (const auto index {indices_.find(key)}; index != indices_.cend()) {
+        Erase(index->second);
+    }
+
+    while (size_ + size > capacity_) {
+        assert(!entries_.empty());
+        Erase(std::prev(entries_.end()));
+    }
+
+    entries_.push_front({.path = std::move(key),
+                         .asset = asset,
+                         .validation_time = Clock::now()});
+    indices_.insert({entries_.front().path, entries_.begin()});
+    size_ += size;
+    return asset;
+}
+
+void AssetCache::Clear() noexcept {
+    const std::lock_guard locker {mtx_};
+    indices_.clear();
+    entries_.clear();
+    size_ = 0;
+}
+
+std::size_t AssetCache::Size() const noexcept {
+    const std::lock_guard locker {mtx_};
+    return size_;
+}
+
+std::size_t AssetCache::Count() const noexcept {
+    const std::lock_guard locker {mtx_};
+    return entries_.size();
+}
+
+bool AssetCache::Unchanged(const std::string& path,
+                           const Asset& asset) noexcept {
+    struct stat status {};
+    return stat(path.c_str(), &status) == 0
+           && static_cast<std::size_t>(status.st_size) == asset.content.size()
+           && ModificationTime(status) == asset.modification_time;
+}
+
+std::shared_ptr<const Asset> AssetCache::Load(const std::string_view path,
+                                              const ReadOnlyFile& file) const {
+    auto asset {Asset::Load(file)};
+    asset->etag = MakeEntityTag(file.Inode(), file.Size(),
+                                file.ModificationTime());
+    asset->BuildHeaders(path);
+
+    const auto compressible {IsCompressibleContentType(
+        ContentTypeByFileName(path))};
+    for (const auto encoding : ContentEncodings::preferences) {
+        std::shared_ptr<Asset> variant;
+        const auto compressed_path {
+            fmt::format("{}{}", path, ContentEncodingToExtension(encoding))};
+
+        // Check the sibling first to avoid throwing an exception if it does not exist.
+        if (std::error_code error;
+            std::filesystem::is_regular_file(compressed_path, error)) {
+            try {
+                ReadOnlyFile compressed;
+                compressed.Open(compressed_path);
+                variant = Asset::Load(compressed);
+            } catch (const std::exception&) {
+                // Ignore an invalid sibling.
+            }
+        }
+
+        if (!variant && compression_ && compressible
+            && CanCompress(encoding)) {
+            if (auto content {Compress(asset->content, encoding)};
+                content.has_value()
+                && content->size() < asset->content.size()) {
+                variant = std::make_shared<Asset>();
+                variant->content = std::move(content.value());
+            }
+        }
+
+        if (variant) {
+            // Validators are derived from the original file, which is the only one revalidated.
+            variant->encoding = encoding;
+            variant->modification_time = asset->modification_time;
+            variant->etag = MakeEntityTag(file.Inode(), file.Size(),
+                                          file.ModificationTime(), encoding);
+            variant->BuildHeaders(path);
+            asset->variants.push_back(std::move(variant));
+        }
+    }
+
+    return asset;
+}
+
+void AssetCache::Erase(const std::list<Entry>::iterator entry) noexcept {
+    const auto size {entry->asset->TotalSize()};
+    assert(size_ >= size);
+    size_ -= size;
+    indices_.erase(entry->path);
+    entries_.erase(entry);
+}
+
+}  // namespace ws::http
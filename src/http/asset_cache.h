@@ -0,0 +1,228 @@
+/**
+ * @file asset_cache.h
+ * @brief The in-memory cache for static assets.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-06-30
+ */
+
+#pragma once
+
+#include "http.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace ws::http {
+
+//! The content of a static asset.
+struct Asset {
+    /**
+     * @brief Load content from an opened file.
+     *
+     * @exception std::system_error Failed to read the file.
+     * @exception std::runtime_error The file has been truncated.
+     */
+    static std::shared_ptr<Asset> Load(const ReadOnlyFile& file);
+
+    /**
+     * @brief Map an opened file as the content.
+     *
+     * @exception std::invalid_argument The file is empty.
+     * @exception std::system_error Failed to map the file.
+     */
+    static std::shared_ptr<Asset> Map(const ReadOnlyFile& file);
+
+    /**
+     * @brief Build the pre-serialized response headers.
+     *
+     * @param path A file path, used to determine the content type if it is not stored.
+     */
+    void BuildHeaders(std::string_view path) noexcept;
+
+    /**
+     * @brief Get the pre-serialized response header.
+     *
+     * @param keep_alive Whether the connection keeps alive.
+     * @param not_modified Whether to get the header of a @p 304 Not Modified response.
+     */
+    std::string_view Header(bool keep_alive,
+                            bool not_modified = false) const noexcept;
+
+    //! Get the validators for conditional requests.
+    Validators GetValidators() const noexcept;
+
+    //! Get the content bytes, which are either owned or mapped.
+    std::span<const std::byte> Content() const noexcept;
+
+    /**
+     * @brief Get the most preferred encoded variant accepted by a client.
+     *
+     * @return The variant, or @p nullptr if the client only accepts the unencoded content.
+     */
+    std::shared_ptr<const Asset> Variant(
+        ContentEncodings encodings) const noexcept;
+
+    //! Get the total size of the content and its encoded variants.
+    std::size_t TotalSize() const noexcept;
+
+    std::vector<std::byte> content;
+
+    //! The content mapped from an asset pack or a file, which is used instead of @p content if @p mapping exists.
+    std::span<const std::byte> mapped;
+
+    //! The mapping of the asset pack or the file, which is kept alive while the asset is being sent.
+    std::shared_ptr<const MappedReadOnlyFile> mapping;
+
+    //! The content type stored in an asset pack, or an empty string if it is derived from the file name.
+    std::string_view content_type;
+
+    ContentEncoding encoding {ContentEncoding::Identity};
+
+    //! The strong entity tag, which is derived from the original file for all variants.
+    std::string etag;
+
+    //! The encoded variants of the content in the order of the server's preference.
+    std::vector<std::shared_ptr<const Asset>> variants;
+
+    std::chrono::system_clock::time_point modification_time;
+
+    //! The pre-serialized response header for keep-alive connections.
+    std::string keep_alive_header;
+
+    //! The pre-serialized response header for non-persistent connections.
+    std::string close_header;
+
+    //! The pre-serialized @p 304 Not Modified response header for keep-alive connections.
+    std::string not_modified_keep_alive_header;
+
+    //! The pre-serialized @p 304 Not Modified response header for non-persistent connections.
+    std::string not_modified_close_header;
+};
+
+/**
+ * @brief The in-memory cache for static assets.
+ *
+ * @details
+ * It keeps file content with pre-serialized response headers,
+ * so a hit costs no file system calls or header formatting.
+ *
+ * - Assets are evicted in least-recently-used order when the total size exceeds the capacity.
+ * - An asset is revalidated by its modification time and size at most once per revalidation interval.
+ * - An asset keeps the content of its precompressed siblings, such as @p index.css.br and @p index.css.gz for @p index.css.
+ *   They are assumed to be regenerated along with the original file, so only the original file is revalidated.
+ * - If compression is enabled, a compressible asset without a @p .gz sibling is compressed with gzip when it is inserted.
+ *
+ * It is thread-safe.
+ */
+class AssetCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! The maximum size of a file that can be cached.
+    static constexpr std::size_t max_file_size {0x100000};
+
+    /**
+     * @brief Create an asset cache.
+     *
+     * @param capacity The maximum total size of cached content.
+     * @param revalidation_interval
+     * The minimum interval between two checks of an asset's modification time.
+     * @param compression Whether to compress assets with gzip if they do not have a precompressed @p .gz sibling.
+     */
+    explicit AssetCache(std::size_t capacity,
+                        Clock::duration revalidation_interval,
+                        bool compression = false) noexcept;
+
+    AssetCache(const AssetCache&) = delete;
+
+    AssetCache(AssetCache&&) = delete;
+
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    AssetCache& operator=(AssetCache&&) = delete;
+
+    /**
+     * @brief Find a cached asset.
+     *
+     * @details
+     * If the revalidation interval has passed since the asset was last checked,
+     * its modification time and size will be compared with the file.
+     *
+     * @param path A full file path.
+     * @return The asset, or @p nullptr if it is not cached or has been modified.
+     */
+    std::shared_ptr<const Asset> Find(const std::filesystem::path& path);
+
+    /**
+     * @brief Load an opened file and cache it.
+     *
+     * @details
+     * The least recently used assets will be evicted if the capacity is exceeded.
+     *
+     * @param path A full file path, used as the key.
+     * @param file The opened file.
+     * @return The asset, or @p nullptr if the file is too large to be cached.
+     *
+     * @exception std::system_error Failed to read the file.
+     * @exception std::runtime_error The file has been truncated.
+     */
+    std::shared_ptr<const Asset> Insert(const std::filesystem::path& path,
+                                        const ReadOnlyFile& file);
+
+    //! Remove all assets.
+    void Clear() noexcept;
+
+    //! Get the total size of cached content, including encoded variants.
+    std::size_t Size() const noexcept;
+
+    //! Get the number of cached assets.
+    std::size_t Count() const noexcept;
+
+private:
+    struct Entry {
+        std::string path;
+        std::shared_ptr<const Asset> asset;
+
+        //! The last time the asset was checked.
+        Clock::time_point validation_time;
+    };
+
+    //! Whether a cached asset is the same as the file on disk.
+    static bool Unchanged(const std::string& path, const Asset& asset) noexcept;
+
+    //! Load an asset with its encoded variants and build their response headers.
+    std::shared_ptr<const Asset> Load(std::string_view path,
+                                      const ReadOnlyFile& file) const;
+
+    //! Remove an asset from the cache.
+    void Erase(std::list<Entry>::iterator entry) noexcept;
+
+    mutable std::mutex mtx_;
+
+    std::size_t capacity_;
+    Clock::duration revalidation_interval_;
+    bool compression_;
+    std::size_t size_ {0};
+
+    //! Entries from the most recently used to the least recently used.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> indices_;
+};
+
+}  // namespace ws::http
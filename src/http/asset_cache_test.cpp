@@ -0,0 +1,250 @@
+#include "asset_cache.h"
+#include "compression.h"
+#include "io.h"
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+using namespace ws;
+using namespace ws::http;
+using namespace ws::test;
+
+
+namespace {
+
+//! Get the expected validator headers of a file.
+std::string ValidatorHeaders(
+    const std::string& path,
+    const ContentEncoding encoding = ContentEncoding::Identity) {
+    ReadOnlyFile file;
+    file.Open(path);
+    return fmt::format("ETag: {}\r\nLast-modified: {}\r\n",
+                       MakeEntityTag(file.Inode(), file.Size(),
+                                     file.ModificationTime(), encoding),
+                       FormatHTTPDate(file.ModificationTime()));
+}
+
+}  // namespace
+
+TEST(AssetCacheTest, FindAndInsert) {
+    // Create a temporary file.
+    const TempTestFile temp;
+    const auto& path {temp.Path()};
+
+    constexpr std::string_view data {"hello"};
+    temp.Rewrite(data);
+
+    AssetCache cache {0x1000, std::chrono::hours {1}};
+    EXPECT_FALSE(cache.Find(path));
+
+    ReadOnlyFile file;
+    file.Open(path);
+    const auto asset {cache.Insert(path, file)};
+    ASSERT_TRUE(asset);
+    EXPECT_EQ(cache.Count(), 1);
+    EXPECT_EQ(cache.Size(), data.length());
+
+    EXPECT_EQ((std::string_view {reinterpret_cast<const char*>(
+                                     asset->Content().data()),
+                                 asset->Content().size()}),
+              data);
+
+    const auto validators {ValidatorHeaders(path)};
+    EXPECT_EQ(asset->Header(true),
+              "HTTP/1.1 200 OK\r\n"
+              "Connection: keep-alive\r\n"
+              "Keep-alive: timeout=60\r\n"
+              "Content-type: application/octet-stream\r\n"
+              "Vary: Accept-Encoding\r\n"
+                  + validators
+                  + "Accept-ranges: bytes\r\n"
+                    "Content-length: 5\r\n"
+                    "\r\n");
+
+    EXPECT_EQ(asset->Header(false),
+              "HTTP/1.1 200 OK\r\n"
+              "Connection: close\r\n"
+              "Content-type: application/octet-stream\r\n"
+              "Vary: Accept-Encoding\r\n"
+                  + validators
+                  + "Accept-ranges: bytes\r\n"
+                    "Content-length: 5\r\n"
+                    "\r\n");
+
+    // A `304 Not Modified` response has no content headers.
+    EXPECT_EQ(asset->Header(false, true),
+              "HTTP/1.1 304 Not Modified\r\n"
+              "Connection: close\r\n"
+              "Vary: Accept-Encoding\r\n"
+                  + validators + "\r\n");
+
+    // The asset will not be revalidated within the interval.
+    EXPECT_EQ(cache.Find(path), asset);
+
+    cache.Clear();
+    EXPECT_EQ(cache.Count(), 0);
+    EXPECT_EQ(cache.Size(), 0);
+    EXPECT_FALSE(cache.Find(path));
+}
+
+TEST(AssetCacheTest, Revalidation) {
+    // Create a temporary file.
+    const TempTestFile temp;
+    const auto& path {temp.Path()};
+
+    temp.Rewrite("hello");
+
+    // Assets are always revalidated.
+    AssetCache cache {0x1000, AssetCache::Clock::duration::zero()};
+
+    ReadOnlyFile file;
+    file.Open(path);
+    const auto asset {cache.Insert(path, file)};
+    ASSERT_TRUE(asset);
+    EXPECT_EQ(cache.Find(path), asset);
+
+    // The asset is removed after the file is modified.
+    temp.Rewrite("hello world");
+    EXPECT_FALSE(cache.Find(path));
+    EXPECT_EQ(cache.Count(), 0);
+}
+
+TEST(AssetCacheTest, Eviction) {
+    // Create temporary files.
+    const std::array<TempTestFile, 3> files;
+    constexpr std::string_view data {"hello"};
+    for (const auto& file : files) {
+        file.Rewrite(data);
+    }
+
+    AssetCache cache {data.length() * 2, std::chrono::hours {1}};
+
+    const auto insert {[&cache](const std::string& path) {
+        ReadOnlyFile file;
+        file.Open(path);
+        return cache.Insert(path, file);
+    }};
+
+    EXPECT_TRUE(insert(files[0].Path()));
+    EXPECT_TRUE(insert(files[1].Path()));
+
+    // Use the first asset, so the second one becomes the least recently used.
+    EXPECT_TRUE(cache.Find(files[0].Path()));
+
+    EXPECT_TRUE(insert(files[2].Path()));
+    EXPECT_EQ(cache.Count(), 2);
+    EXPECT_EQ(cache.Size(), data.length() * 2);
+    EXPECT_TRUE(cache.Find(files[0].Path()));
+    EXPECT_FALSE(cache.Find(files[1].Path()));
+    EXPECT_TRUE(cache.Find(files[2].Path()));
+
+    // A file larger than the capacity cannot be cached.
+    files[1].Rewrite("hello world");
+    EXPECT_FALSE(insert(files[1].Path()));
+    EXPECT_EQ(cache.Count(), 2);
+}
+
+TEST(AssetCacheTest, EncodedVariants) {
+    const auto dir {CreateTempTestDirectory()};
+    const RAII raii {dir, [](const auto& dir) noexcept {
+                         std::error_code error;
+                         std::filesystem::remove_all(dir, error);
+                     }};
+
+    const auto write {[&dir](const std::string_view name,
+                             const std::string_view data) {
+        std::ofstream file {std::filesystem::path {dir} / name};
+        file << data;
+    }};
+
+    std::string page;
+    for (auto i {0}; i != 0x100; ++i) {
+        page += "<p>hello</p>\n";
+    }
+
+    write("page.html", page);
+    write("page.html.br", "br");
+
+    const auto path {std::filesystem::path {dir} / "page.html"};
+    const auto insert {[&path](AssetCache& cache) {
+        ReadOnlyFile file;
+        file.Open(path);
+        return cache.Insert(path, file);
+    }};
+
+    constexpr ContentEncodings gzip {
+        ContentEncodings {}.Add(ContentEncoding::Gzip)};
+    constexpr ContentEncodings all {
+        ContentEncodings {gzip}.Add(ContentEncoding::Brotli)};
+
+    {
+        // Only the precompressed sibling is cached without compression.
+        AssetCache cache {0x10000, std::chrono::hours {1}};
+        const auto asset {insert(cache)};
+        ASSERT_TRUE(asset);
+        ASSERT_EQ(asset->variants.size(), 1);
+        EXPECT_EQ(cache.Size(), page.size() + 2);
+
+        EXPECT_FALSE(asset->Variant({}));
+        EXPECT_FALSE(asset->Variant(gzip));
+
+        const auto brotli {asset->Variant(all)};
+        ASSERT_TRUE(brotli);
+        EXPECT_EQ(brotli->encoding, ContentEncoding::Brotli);
+        EXPECT_EQ(brotli->Header(false),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Connection: close\r\n"
+                  "Content-type: text/html\r\n"
+                  "Content-encoding: br\r\n"
+                  "Vary: Accept-Encoding\r\n"
+                      + ValidatorHeaders(path, ContentEncoding::Brotli)
+                      + "Accept-ranges: bytes\r\n"
+                        "Content-length: 2\r\n"
+                        "\r\n");
+
+        // Variants have different entity tags but the same modification time.
+        EXPECT_NE(brotli->etag, asset->etag);
+        EXPECT_EQ(brotli->modification_time, asset->modification_time);
+    }
+
+    if (!CanCompress(ContentEncoding::Gzip)) {
+        GTEST_SKIP() << "The server is built without zlib.";
+    }
+
+    {
+        // Compress the file with gzip when it is inserted.
+        AssetCache cache {0x10000, std::chrono::hours {1}, true};
+        const auto asset {insert(cache)};
+        ASSERT_TRUE(asset);
+        ASSERT_EQ(asset->variants.size(), 2);
+
+        const auto compressed {asset->Variant(gzip)};
+        ASSERT_TRUE(compressed);
+        EXPECT_EQ(compressed->encoding, ContentEncoding::Gzip);
+        EXPECT_LT(compressed->content.size(), page.size());
+        EXPECT_NE(compressed->Header(true).find("Content-encoding: gzip\r\n"),
+                  std::string::npos);
+        EXPECT_EQ(asset->Variant(all)->encoding, ContentEncoding::Brotli);
+        EXPECT_EQ(cache.Size(), asset->TotalSize());
+        EXPECT_EQ(asset->TotalSize(),
+                  page.size() + 2 + compressed->content.size());
+    }
+
+    {
+        // Binary files are not compressed.
+        write("image.png", page);
+        const auto image {std::filesystem::path {dir} / "image.png"};
+        AssetCache cache {0x10000, std::chrono::hours {1}, true};
+        ReadOnlyFile file;
+        file.Open(image);
+        const auto asset {cache.Insert(image, file)};
+        ASSERT_TRUE(asset);
+        EXPECT_TRUE(asset->variants.empty());
+    }
+}
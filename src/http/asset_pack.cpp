@@ -0,0 +1,384 @@
+#include "asset_pack.h"
+#include "compression.h"
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace ws::http {
+
+namespace {
+
+constexpr std::array<char, 8> pack_magic {'W', 'S', 'A', 'S', 'S', 'E', 'T', 'S'};
+
+constexpr std::uint32_t pack_version {1};
+
+//! The marker distinguishing packs written in a different byte order.
+constexpr std::uint32_t byte_order_mark {0x01020304};
+
+struct PackHeader {
+    std::array<char, 8> magic {pack_magic};
+    std::uint32_t version {pack_version};
+    std::uint32_t byte_order {byte_order_mark};
+    std::uint64_t entry_count {0};
+    std::uint64_t entries_offset {0};
+    std::uint64_t variant_count {0};
+    std::uint64_t variants_offset {0};
+    std::uint64_t strings_offset {0};
+    std::uint64_t strings_size {0};
+    std::uint64_t data_offset {0};
+    std::uint64_t data_size {0};
+};
+
+struct PackEntry {
+    //! The offset of the request path in the string table.
+    std::uint64_t path_offset {0};
+    std::uint64_t content_type_offset {0};
+    std::uint32_t path_size {0};
+    std::uint32_t content_type_size {0};
+
+    //! The modification time of the original file, in nanoseconds since the epoch.
+    std::int64_t modification_time {0};
+
+    std::uint32_t first_variant {0};
+    std::uint32_t variant_count {0};
+};
+
+struct PackVariant {
+    //! The offset of the content in the data region.
+    std::uint64_t offset {0};
+    std::uint64_t size {0};
+    std::uint64_t etag_offset {0};
+    std::uint32_t etag_size {0};
+    std::uint8_t encoding {0};
+    std::array<std::uint8_t, 3> padding {};
+};
+
+static_assert(sizeof(PackHeader) == 80);
+static_assert(sizeof(PackEntry) == 40);
+static_assert(sizeof(PackVariant) == 32);
+
+//! Whether a range is inside a region of a certain size.
+constexpr bool InBounds(const std::uint64_t offset, const std::uint64_t size,
+                        const std::uint64_t limit) noexcept {
+    return offset <= limit && size <= limit - offset;
+}
+
+[[noreturn]] void ThrowMalformedPack(const std::string_view path,
+                                     const std::string_view reason) {
+    throw std::invalid_argument {
+        fmt::format("The asset pack '{}' is malformed: {}", path, reason)};
+}
+
+//! Read a structure from the mapped pack, which may not be aligned.
+template <typename T>
+T ReadStruct(const std::byte* const data) noexcept {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+std::optional<ContentEncoding> ToContentEncoding(
+    const std::uint8_t value) noexcept {
+    switch (static_cast<ContentEncoding>(value)) {
+        case ContentEncoding::Identity:
+        case ContentEncoding::Gzip:
+        case ContentEncoding::Brotli:
+            return static_cast<ContentEncoding>(value);
+        default:
+            return std::nullopt;
+    }
+}
+
+//! The builder of an asset pack's regions.
+class PackWriter {
+public:
+    //! Add a file's content to the data region, sharing the content of a file that has been added.
+    std::pair<std::uint64_t, std::uint64_t> AddFile(const std::string& path) {
+        if (const auto added {files_.find(path)}; added != files_.cend()) {
+            return added->second;
+        }
+
+        ReadOnlyFile file;
+        file.Open(path);
+        const auto range {AddContent(file.ReadAll())};
+        files_.insert({path, range});
+        return range;
+    }
+
+    //! Get content that has been added.
+    std::span<const std::byte> Content(
+        const std::pair<std::uint64_t, std::uint64_t> range) const noexcept {
+        return std::span {data_}.subspan(range.first, range.second);
+    }
+
+    std::pair<std::uint64_t, std::uint64_t> AddContent(
+        const std::span<const std::byte> content) {
+        const std::pair range {data_.size(), content.size()};
+        data_.insert(data_.cend(), content.begin(), content.end());
+        return range;
+    }
+
+    std::pair<std::uint64_t, std::uint32_t> AddString(
+        const std::string_view str) {
+        const std::pair range {strings_.size(),
+                               static_cast<std::uint32_t>(str.size())};
+        strings_.append(str);
+        return range;
+    }
+
+    void AddEntry(PackEntry entry, const std::vector<PackVariant>& variants) {
+        entry.first_variant = static_cast<std::uint32_t>(variants_.size());
+        entry.variant_count = static_cast<std::uint32_t>(variants.size());
+        entries_.push_back(entry);
+        variants_.insert(variants_.cend(), variants.cbegin(), variants.cend());
+    }
+
+    void Write(const std::filesystem::path& pack) const {
+        PackHeader header;
+        header.entry_count = entries_.size();
+        header.entries_offset = sizeof(PackHeader);
+        header.variant_count = variants_.size();
+        header.variants_offset =
+            header.entries_offset + entries_.size() * sizeof(PackEntry);
+        header.strings_offset =
+            header.variants_offset + variants_.size() * sizeof(PackVariant);
+        header.strings_size = strings_.size();
+        header.data_offset = header.strings_offset + strings_.size();
+        header.data_size = data_.size();
+
+        std::ofstream file;
+        file.exceptions(std::ios::failbit | std::ios::badbit);
+        file.open(pack, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries_.data()),
+                   entries_.size() * sizeof(PackEntry));
+        file.write(reinterpret_cast<const char*>(variants_.data()),
+                   variants_.size() * sizeof(PackVariant));
+        file.write(strings_.data(), strings_.size());
+        file.write(reinterpret_cast<const char*>(data_.data()), data_.size());
+    }
+
+private:
+    std::vector<PackEntry> entries_;
+    std::vector<PackVariant> variants_;
+    std::string strings_;
+    std::vector<std::byte> data_;
+
+    //! Ranges of files' content in the data region.
+    std::unordered_map<std::string, std::pair<std::uint64_t, std::uint64_t>>
+        files_;
+};
+
+}  // namespace
+
+void PackAssets(const std::filesystem::path& dir,
+                const std::filesystem::path& pack, const bool compression) {
+    // Entries are sorted by their request paths, so the same folder always builds the same pack.
+    std::map<std::string, std::filesystem::path> files;
+    for (const auto& file : std::filesystem::recursive_directory_iterator {dir}) {
+        // A previous pack in the folder is not packed into the new one.
+        if (std::error_code error;
+            file.is_regular_file()
+            && !std::filesystem::equivalent(file.path(), pack, error)) {
+            files.insert(
+                {fmt::format("/{}", std::filesystem::relative(file.path(), dir)
+                                        .generic_string()),
+                 file.path()});
+        }
+    }
+
+    PackWriter writer;
+    for (const auto& [request_path, file_path] : files) {
+        ReadOnlyFile file;
+        file.Open(file_path);
+
+        PackEntry entry;
+        std::tie(entry.path_offset, entry.path_size) =
+            writer.AddString(request_path);
+        const auto type {ContentTypeByFileName(request_path)};
+        std::tie(entry.content_type_offset, entry.content_type_size) =
+            writer.AddString(type);
+        entry.modification_time =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                file.ModificationTime().time_since_epoch())
+                .count();
+
+        // Entity tags are the same as the ones of files served from the asset folder.
+        const auto add_variant {[&](const ContentEncoding encoding,
+                                    const std::pair<std::uint64_t,
+                                                    std::uint64_t> range) {
+            PackVariant variant;
+            std::tie(variant.offset, variant.size) = range;
+            std::tie(variant.etag_offset, variant.etag_size) =
+                writer.AddString(MakeEntityTag(file.Inode(), file.Size(),
+                                               file.ModificationTime(),
+                                               encoding));
+            variant.encoding = static_cast<std::uint8_t>(encoding);
+            return variant;
+        }};
+
+        std::vector<PackVariant> variants;
+        const auto identity {writer.AddFile(file_path)};
+        variants.push_back(add_variant(ContentEncoding::Identity, identity));
+
+        for (const auto encoding : ContentEncodings::preferences) {
+            const auto sibling {fmt::format(
+                "{}{}", file_path.string(), ContentEncodingToExtension(encoding))};
+            if (std::error_code error;
+                std::filesystem::is_regular_file(sibling, error)) {
+                variants.push_back(
+                    add_variant(encoding, writer.AddFile(sibling)));
+            } else if (compression && IsCompressibleContentType(type)
+                       && CanCompress(encoding)) {
+                // The data region may grow, so the content is copied before being compressed.
+                const auto original {writer.Content(identity)};
+                const std::vector<std::byte> content {original.begin(),
+                                                     original.end()};
+                if (const auto compressed {Compress(content, encoding)};
+                    compressed.has_value()
+                    && compressed->size() < content.size()) {
+                    variants.push_back(add_variant(
+                        encoding, writer.AddContent(compressed.value())));
+                }
+            }
+        }
+
+        writer.AddEntry(entry, variants);
+    }
+
+    writer.Write(pack);
+}
+
+AssetPack::AssetPack(const std::filesystem::path& path) {
+    auto mapping {std::make_shared<MappedReadOnlyFile>()};
+    const auto data {mapping->Map(path)};
+    const auto size {mapping->Size()};
+    mapping_ = mapping;
+
+    const auto path_str {path.native()};
+    if (size < sizeof(PackHeader)) {
+        ThrowMalformedPack(path_str, "The header is truncated");
+    }
+
+    const auto header {ReadStruct<PackHeader>(data)};
+    if (header.magic != pack_magic) {
+        ThrowMalformedPack(path_str, "The magic number is invalid");
+    } else if (header.byte_order != byte_order_mark) {
+        ThrowMalformedPack(path_str, "The byte order is different");
+    } else if (header.version != pack_version) {
+        ThrowMalformedPack(path_str, "The version is not supported");
+    }
+
+    if (header.entry_count > size / sizeof(PackEntry)
+        || !InBounds(header.entries_offset,
+                     header.entry_count * sizeof(PackEntry), size)
+        || header.variant_count > size / sizeof(PackVariant)
+        || !InBounds(header.variants_offset,
+                     header.variant_count * sizeof(PackVariant), size)
+        || !InBounds(header.strings_offset, header.strings_size, size)
+        || !InBounds(header.data_offset, header.data_size, size)) {
+        ThrowMalformedPack(path_str, "Regions are out of bounds");
+    }
+
+    const auto strings {reinterpret_cast<const char*>(data)
+                        + header.strings_offset};
+    const auto string_at {[&](const std::uint64_t offset,
+                              const std::uint32_t length) {
+        if (!InBounds(offset, length, header.strings_size)) {
+            ThrowMalformedPack(path_str, "A string is out of bounds");
+        }
+
+        return std::string_view {strings + offset, length};
+    }};
+
+    assets_.reserve(header.entry_count);
+    for (std::uint64_t i {0}; i != header.entry_count; ++i) {
+        const auto entry {ReadStruct<PackEntry>(
+            data + header.entries_offset + i * sizeof(PackEntry))};
+        if (entry.variant_count == 0
+            || !InBounds(entry.first_variant, entry.variant_count,
+                         header.variant_count)) {
+            ThrowMalformedPack(path_str, "Variants are out of bounds");
+        }
+
+        const auto request_path {string_at(entry.path_offset, entry.path_size)};
+        const auto content_type {
+            string_at(entry.content_type_offset, entry.content_type_size)};
+        const std::chrono::system_clock::time_point modification_time {
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds {entry.modification_time})};
+
+        std::shared_ptr<Asset> original;
+        for (std::uint32_t j {0}; j != entry.variant_count; ++j) {
+            const auto variant {ReadStruct<PackVariant>(
+                data + header.variants_offset
+                + (entry.first_variant + j) * sizeof(PackVariant))};
+            const auto encoding {ToContentEncoding(variant.encoding)};
+            if (!encoding.has_value()
+                || (j == 0) != (encoding == ContentEncoding::Identity)) {
+                ThrowMalformedPack(path_str, "A variant's encoding is invalid");
+            } else if (!InBounds(variant.offset, variant.size,
+                                 header.data_size)) {
+                ThrowMalformedPack(path_str, "Content is out of bounds");
+            }
+
+            auto asset {std::make_shared<Asset>()};
+            asset->mapping = mapping_;
+            asset->mapped = {data + header.data_offset + variant.offset,
+                             variant.size};
+            asset->encoding = encoding.value();
+            asset->etag = string_at(variant.etag_offset, variant.etag_size);
+            asset->modification_time = modification_time;
+            asset->content_type = content_type;
+            asset->BuildHeaders(request_path);
+            all_assets_.push_back({request_path, asset});
+            if (original) {
+                original->variants.push_back(std::move(asset));
+            } else {
+                original = std::move(asset);
+            }
+        }
+
+        if (!assets_.insert({request_path, std::move(original)}).second) {
+            ThrowMalformedPack(path_str, "Paths are duplicated");
+        }
+    }
+}
+
+std::shared_ptr<const Asset> AssetPack::Find(
+    const std::string_view path) const noexcept {
+    const auto asset {assets_.find(path)};
+    return asset != assets_.cend() ? asset->second : nullptr;
+}
+
+void AssetPack::BuildHeaders() noexcept {
+    for (const auto& [path, asset] : all_assets_) {
+        asset->BuildHeaders(path);
+    }
+}
+
+std::size_t AssetPack::Count() const noexcept {
+    return assets_.size();
+}
+
+std::size_t AssetPack::Size() const noexcept {
+    return mapping_->Size();
+}
+
+}  // namespace ws::http
@@ -0,0 +1,102 @@
+/**
+ * @file asset_pack.h
+ * @brief The packed bundle of static assets, mapped into memory once.
+ *
+ * @details
+ * An asset pack is a single file built from an asset folder by @p echo-asset-pack.
+ * It consists of the following regions in the native byte order.
+ *
+ * 1. A header with a magic number, a version and the location of other regions.
+ * 2. An index of entries sorted by their request paths.
+ *    Each entry has the offsets of its path and content type, its modification time and a range of variants.
+ * 3. Variants of entries. The first variant of an entry is its unencoded content,
+ *    followed by precompressed ones in the order of the server's preference.
+ *    Each variant has the offset and size of its content, its encoding and its entity tag.
+ * 4. A string table of paths, content types and entity tags.
+ * 5. The content of files. A precompressed sibling requested directly shares the content of its variant.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-30
+ *
+ * @example src/http/asset_pack_test.cpp
+ */
+
+#pragma once
+
+#include "asset_cache.h"
+#include "util.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace ws::http {
+
+/**
+ * @brief The static assets loaded from an asset pack.
+ *
+ * @details
+ * The pack is mapped with one @p mmap and its index is loaded into a hash table with pre-serialized response headers,
+ * so a lookup costs no file system calls.
+ * Assets refer to the mapped content and keep the mapping alive.
+ *
+ * Lookups are thread-safe.
+ */
+class AssetPack {
+public:
+    /**
+     * @brief Map an asset pack and load its index.
+     *
+     * @exception std::system_error Failed to map the pack.
+     * @exception std::invalid_argument The pack is malformed.
+     */
+    explicit AssetPack(const std::filesystem::path& path);
+
+    AssetPack(const AssetPack&) = delete;
+
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    /**
+     * @brief Find an asset.
+     *
+     * @param path A request path, such as @p /index.css.
+     * @return The asset, or @p nullptr if it is not in the pack.
+     */
+    std::shared_ptr<const Asset> Find(std::string_view path) const noexcept;
+
+    /**
+     * @brief Rebuild the pre-serialized response headers of all assets.
+     *
+     * @details It should be called after response settings such as the keep-alive timeout are changed.
+     *
+     * @warning It must not be called while assets are being looked up.
+     */
+    void BuildHeaders() noexcept;
+
+    //! Get the number of assets.
+    std::size_t Count() const noexcept;
+
+    //! Get the total size of the mapped pack.
+    std::size_t Size() const noexcept;
+
+private:
+    std::shared_ptr<const MappedReadOnlyFile> mapping_;
+
+    //! Assets indexed by their request paths, which refer to the mapped string table.
+    std::unordered_map<std::string_view, std::shared_ptr<const Asset>> assets_;
+
+    //! All assets including encoded variants, with their request paths.
+    std::vector<std::pair<std::string_view, std::shared_ptr<Asset>>>
+        all_assets_;
+};
+
+}  // namespace ws::http
@@ -0,0 +1,158 @@
+#include "asset_pack.h"
+#include "asset_cache.h"
+#include "compression.h"
+#include "response.h"
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+using namespace ws;
+using namespace ws::http;
+using namespace ws::test;
+
+
+namespace {
+
+void WriteFile(const std::filesystem::path& path, const std::string_view data) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file {path, std::ios::binary};
+    file << data;
+}
+
+std::string_view ToString(const std::span<const std::byte> bytes) noexcept {
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+}  // namespace
+
+TEST(AssetPackTest, PackAndFind) {
+    const std::filesystem::path dir {CreateTempTestDirectory()};
+    WriteFile(dir / "index.css", "body {}");
+    WriteFile(dir / "index.css.gz", "gzip");
+    WriteFile(dir / "img" / "logo.png", "png");
+    WriteFile(dir / "empty.txt", "");
+
+    const auto pack_path {dir / "assets.pack"};
+    PackAssets(dir, pack_path);
+    std::filesystem::remove(dir / "empty.txt");
+
+    const AssetPack pack {pack_path};
+    EXPECT_EQ(pack.Count(), 4);
+    EXPECT_EQ(pack.Size(), std::filesystem::file_size(pack_path));
+    EXPECT_FALSE(pack.Find("/missing.css"));
+    EXPECT_FALSE(pack.Find("index.css"));
+
+    // Files are found by their request paths even if they have been removed.
+    const auto empty {pack.Find("/empty.txt")};
+    ASSERT_TRUE(empty);
+    EXPECT_TRUE(empty->Content().empty());
+
+    const auto logo {pack.Find("/img/logo.png")};
+    ASSERT_TRUE(logo);
+    EXPECT_EQ(ToString(logo->Content()), "png");
+    EXPECT_NE(logo->Header(true).find("Content-type: image/png\r\n"),
+              std::string_view::npos);
+
+    // Packed headers are the same as the ones of cached files.
+    const auto css {pack.Find("/index.css")};
+    ASSERT_TRUE(css);
+    EXPECT_EQ(ToString(css->Content()), "body {}");
+
+    AssetCache cache {0x1000, std::chrono::hours {1}};
+    ReadOnlyFile file;
+    file.Open(dir / "index.css");
+    const auto cached {cache.Insert(dir / "index.css", file)};
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(css->Header(true), cached->Header(true));
+    EXPECT_EQ(css->Header(false, true), cached->Header(false, true));
+
+    // Precompressed siblings are packed as variants and can still be requested directly.
+    const auto gzip {css->Variant(ContentEncodings {}.Add(ContentEncoding::Gzip))};
+    ASSERT_TRUE(gzip);
+    EXPECT_EQ(gzip->encoding, ContentEncoding::Gzip);
+    EXPECT_EQ(ToString(gzip->Content()), "gzip");
+    EXPECT_EQ(gzip->Header(true),
+              cached->Variant(ContentEncodings {}.Add(ContentEncoding::Gzip))
+                  ->Header(true));
+    EXPECT_FALSE(
+        css->Variant(ContentEncodings {}.Add(ContentEncoding::Brotli)));
+
+    const auto sibling {pack.Find("/index.css.gz")};
+    ASSERT_TRUE(sibling);
+    EXPECT_EQ(sibling->Content().data(), gzip->Content().data());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AssetPackTest, Compression) {
+    if (!CanCompress(ContentEncoding::Gzip)) {
+        GTEST_SKIP() << "Gzip is not supported";
+    }
+
+    const std::filesystem::path dir {CreateTempTestDirectory()};
+    const std::string text(0x1000, 'a');
+    WriteFile(dir / "index.js", text);
+    WriteFile(dir / "logo.png", text);
+
+    const auto pack_path {dir / "assets.pack"};
+    PackAssets(dir, pack_path, true);
+
+    const AssetPack pack {pack_path};
+    const auto gzip {ContentEncodings {}.Add(ContentEncoding::Gzip)};
+    const auto compressed {pack.Find("/index.js")->Variant(gzip)};
+    ASSERT_TRUE(compressed);
+    EXPECT_LT(compressed->Content().size(), text.size());
+
+    // Images are not compressed again.
+    EXPECT_FALSE(pack.Find("/logo.png")->Variant(gzip));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AssetPackTest, BuildHeaders) {
+    const RAII raii {Response::GetKeepAliveTimeout(),
+                     [](const auto timeout) noexcept {
+                         Response::SetKeepAliveTimeout(timeout);
+                     }};
+
+    const std::filesystem::path dir {CreateTempTestDirectory()};
+    WriteFile(dir / "index.css", "body {}");
+    const auto pack_path {dir / "assets.pack"};
+    PackAssets(dir, pack_path);
+
+    AssetPack pack {pack_path};
+    Response::SetKeepAliveTimeout(std::chrono::seconds {5});
+    pack.BuildHeaders();
+    EXPECT_NE(pack.Find("/index.css")->Header(true).find("timeout=5\r\n"),
+              std::string_view::npos);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AssetPackTest, Malformed) {
+    const std::filesystem::path dir {CreateTempTestDirectory()};
+    WriteFile(dir / "index.css", "body {}");
+    const auto pack_path {dir / "assets.pack"};
+    PackAssets(dir, pack_path);
+
+    // A pack whose regions are truncated.
+    std::filesystem::resize_file(pack_path,
+                                 std::filesystem::file_size(pack_path) - 1);
+    EXPECT_THROW(AssetPack {pack_path}, std::invalid_argument);
+
+    WriteFile(pack_path, "not an asset pack, but long enough to be read as a header"
+                         "................................");
+    EXPECT_THROW(AssetPack {pack_path}, std::invalid_argument);
+
+    WriteFile(pack_path, "short");
+    EXPECT_THROW(AssetPack {pack_path}, std::invalid_argument);
+
+    EXPECT_THROW(AssetPack {dir / "missing.pack"}, std::system_error);
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,71 @@
+#include "compression.h"
+
+#ifdef WS_HTTP_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace ws::http {
+
+namespace {
+
+#ifdef WS_HTTP_ZLIB
+std::optional<std::vector<std::byte>> CompressWithGzip(
+    const std::span<const std::byte> content) noexcept {
+    // Adding 16 to the window bits makes zlib write a gzip header and trailer instead of a zlib wrapper.
+    static constexpr int window_bits {MAX_WBITS + 16};
+    static constexpr int memory_level {8};
+
+    z_stream stream {};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, window_bits,
+                     memory_level, Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<std::byte>> compressed;
+    try {
+        compressed.emplace(deflateBound(&stream, content.size()));
+    } catch (const std::bad_alloc&) {
+        deflateEnd(&stream);
+        return std::nullopt;
+    }
+
+    // zlib does not modify the input although its pointer is not constant.
+    stream.next_in = reinterpret_cast<Bytef*>(
+        const_cast<std::byte*>(content.data()));
+    stream.avail_in = static_cast<uInt>(content.size());
+    stream.next_out = reinterpret_cast<Bytef*>(compressed->data());
+    stream.avail_out = static_cast<uInt>(compressed->size());
+
+    // The output buffer is large enough, so the stream finishes in one call.
+    const auto finished {deflate(&stream, Z_FINISH) == Z_STREAM_END};
+    compressed->resize(stream.total_out);
+    deflateEnd(&stream);
+    return finished ? std::move(compressed) : std::nullopt;
+}
+#endif
+
+}  // namespace
+
+bool CanCompress(const ContentEncoding encoding) noexcept {
+#ifdef WS_HTTP_ZLIB
+    return encoding == ContentEncoding::Gzip;
+#else
+    return false;
+#endif
+}
+
+std::optional<std::vector<std::byte>> Compress(
+    const std::span<const std::byte> content,
+    const ContentEncoding encoding) noexcept {
+#ifdef WS_HTTP_ZLIB
+    if (encoding == ContentEncoding::Gzip) {
+        return CompressWithGzip(content);
+    }
+#endif
+
+    return std::nullopt;
+}
+
+}  // namespace ws::http
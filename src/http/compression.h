@@ -0,0 +1,44 @@
+/**
+ * @file compression.h
+ * @brief The on-the-fly compression of HTTP content.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-22
+ *
+ * @example src/http/compression_test.cpp
+ */
+
+#pragma once
+
+#include "http.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace ws::http {
+
+/**
+ * @brief Whether content can be compressed with an encoding on the fly.
+ *
+ * @details Gzip is supported if the server is built with @p zlib.
+ */
+bool CanCompress(ContentEncoding encoding) noexcept;
+
+/**
+ * @brief Compress content with an encoding.
+ *
+ * @return
+ * The compressed content,
+ * or @p std::nullopt if the encoding is not supported or the compression failed.
+ */
+std::optional<std::vector<std::byte>> Compress(
+    std::span<const std::byte> content, ContentEncoding encoding) noexcept;
+
+}  // namespace ws::http
@@ -0,0 +1,50 @@
+#include "compression.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace ws;
+using namespace ws::http;
+
+
+TEST(CompressionTest, Gzip) {
+    if (!CanCompress(ContentEncoding::Gzip)) {
+        GTEST_SKIP() << "The server is built without zlib.";
+    }
+
+    std::string data;
+    for (auto i {0}; i != 0x100; ++i) {
+        data += "<p>hello</p>\n";
+    }
+
+    const std::span content {reinterpret_cast<const std::byte*>(data.data()),
+                             data.size()};
+    const auto compressed {Compress(content, ContentEncoding::Gzip)};
+    ASSERT_TRUE(compressed.has_value());
+    ASSERT_GT(compressed->size(), 18);
+    EXPECT_LT(compressed->size(), data.size());
+
+    // A gzip stream starts with a magic number.
+    EXPECT_EQ(compressed->at(0), std::byte {0x1F});
+    EXPECT_EQ(compressed->at(1), std::byte {0x8B});
+
+    // A gzip stream ends with the size of the uncompressed data in little-endian.
+    std::uint32_t size {0};
+    for (auto i {0}; i != 4; ++i) {
+        size |= std::to_integer<std::uint32_t>(
+                    compressed->at(compressed->size() - 4 + i))
+                << (i * 8);
+    }
+
+    EXPECT_EQ(size, data.size());
+}
+
+TEST(CompressionTest, Unsupported) {
+    constexpr std::string_view data {"hello"};
+    const std::span content {reinterpret_cast<const std::byte*>(data.data()),
+                             data.size()};
+    EXPECT_FALSE(CanCompress(ContentEncoding::Identity));
+    EXPECT_FALSE(CanCompress(ContentEncoding::Brotli));
+    EXPECT_FALSE(Compress(content, ContentEncoding::Brotli).has_value());
+}
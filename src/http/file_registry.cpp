@@ -0,0 +1,64 @@
+#include "file_registry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+
+namespace ws::http {
+
+std::shared_ptr<const Asset> FileRegistry::Acquire(
+    const ReadOnlyFile& file) {
+    assert(file.Valid());
+
+    const std::string_view path {file.Path()};
+    {
+        const std::lock_guard locker {mtx_};
+        if (const auto it {entries_.find(std::string {path})};
+            it != entries_.cend()) {
+            const auto& entry {it->second};
+            if (auto asset {entry.asset.lock()};
+                asset && entry.inode == file.Inode()
+                && entry.modification_time == file.ModificationTime()
+                && entry.size == file.Size()) {
+                return asset;
+            }
+        }
+    }
+
+    // Load the file without the lock, as it reads the whole file.
+    std::shared_ptr<const Asset> asset {file.Size() <= max_read_file_size
+                                            ? Asset::Load(file)
+                                            : Asset::Map(file)};
+
+    const std::lock_guard locker {mtx_};
+    auto& entry {entries_[std::string {path}]};
+    entry.inode = file.Inode();
+    entry.modification_time = file.ModificationTime();
+    entry.size = file.Size();
+    entry.asset = asset;
+    Sweep();
+    return asset;
+}
+
+std::size_t FileRegistry::Count() const noexcept {
+    const std::lock_guard locker {mtx_};
+    return std::ranges::count_if(entries_, [](const auto& entry) noexcept {
+        return !entry.second.asset.expired();
+    });
+}
+
+void FileRegistry::Sweep() noexcept {
+    if (entries_.size() < sweep_count_) {
+        return;
+    }
+
+    std::erase_if(entries_, [](const auto& entry) noexcept {
+        return entry.second.asset.expired();
+    });
+
+    // Sweeping again only after the entries double keeps the amortized cost constant.
+    sweep_count_ = std::max(min_sweep_count, entries_.size() * 2);
+}
+
+}  // namespace ws::http
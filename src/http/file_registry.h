@@ -0,0 +1,100 @@
+/**
+ * @file file_registry.h
+ * @brief The process-wide registry of file contents shared by connections.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-08-01
+ *
+ * @example src/http/file_registry_test.cpp
+ */
+
+#pragma once
+
+#include "asset_cache.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace ws::http {
+
+/**
+ * @brief The registry of immutable and reference-counted contents of uncached files.
+ *
+ * @details
+ * Connections sending the same file at the same time share one copy of its content,
+ * instead of each reading the file into its own memory or mapping it again.
+ * - A small file is read into memory, as mapping and unmapping it costs more than reading it.
+ * - A larger file is mapped with @p MAP_POPULATE and @p MADV_SEQUENTIAL.
+ *   It should be replaced instead of being truncated in place, as reading a truncated mapping faults.
+ *
+ * A content is identified by its path along with the inode number, modification time and size of the file,
+ * so a modified file is loaded again while older responses keep the previous content.
+ *
+ * The registry does not own contents.
+ * A content is released when its last connection finishes sending it.
+ *
+ * It is thread-safe.
+ */
+class FileRegistry {
+public:
+    //! The maximum size of a file that is read instead of mapped.
+    static constexpr std::size_t max_read_file_size {0x4000};
+
+    //! The number of entries above which expired ones are removed.
+    static constexpr std::size_t min_sweep_count {0x40};
+
+    FileRegistry() noexcept = default;
+
+    FileRegistry(const FileRegistry&) = delete;
+
+    FileRegistry(FileRegistry&&) = delete;
+
+    FileRegistry& operator=(const FileRegistry&) = delete;
+
+    FileRegistry& operator=(FileRegistry&&) = delete;
+
+    /**
+     * @brief Get the shared content of an opened file, loading it if no connection is using it.
+     *
+     * @param file An opened file, used as the key by its path.
+     * @return An asset with the file content.
+     *
+     * @exception std::system_error Failed to read or map the file.
+     * @exception std::runtime_error The file has been truncated.
+     */
+    std::shared_ptr<const Asset> Acquire(const ReadOnlyFile& file);
+
+    //! Get the number of contents in use.
+    std::size_t Count() const noexcept;
+
+private:
+    struct Entry {
+        std::uint64_t inode {0};
+        std::chrono::system_clock::time_point modification_time;
+        std::size_t size {0};
+        std::weak_ptr<const Asset> asset;
+    };
+
+    //! Remove entries whose contents have been released, if there are too many entries.
+    void Sweep() noexcept;
+
+    mutable std::mutex mtx_;
+
+    std::unordered_map<std::string, Entry> entries_;
+
+    //! The number of entries at which the next sweep happens.
+    std::size_t sweep_count_ {min_sweep_count};
+};
+
+}  // namespace ws::http
@@ -0,0 +1,79 @@
+#include "file_registry.h"
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+using namespace ws;
+using namespace ws::http;
+using namespace ws::test;
+
+
+namespace {
+
+std::string_view ToString(const Asset& asset) noexcept {
+    const auto content {asset.Content()};
+    return {reinterpret_cast<const char*>(content.data()), content.size()};
+}
+
+}  // namespace
+
+
+TEST(FileRegistryTest, Acquire) {
+    // Create a temporary file.
+    const TempTestFile temp;
+    const auto& path {temp.Path()};
+
+    constexpr std::string_view data {"hello"};
+    temp.Rewrite(data);
+
+    FileRegistry files;
+    ReadOnlyFile file;
+    file.Open(path);
+    auto asset {files.Acquire(file)};
+    ASSERT_TRUE(asset);
+    EXPECT_EQ(ToString(*asset), data);
+
+    // A small file is read instead of mapped.
+    EXPECT_FALSE(asset->mapping);
+
+    // Connections using the file at the same time share its content.
+    ReadOnlyFile other;
+    other.Open(path);
+    EXPECT_EQ(files.Acquire(other), asset);
+    EXPECT_EQ(files.Count(), 1);
+
+    // The content is released with its last user.
+    asset.reset();
+    EXPECT_EQ(files.Count(), 0);
+    EXPECT_EQ(ToString(*files.Acquire(file)), data);
+}
+
+TEST(FileRegistryTest, Map) {
+    // Create a temporary file.
+    const TempTestFile temp;
+    const auto& path {temp.Path()};
+
+    const std::string data(FileRegistry::max_read_file_size + 1, 'a');
+    temp.Rewrite(data);
+
+    FileRegistry files;
+    ReadOnlyFile file;
+    file.Open(path);
+    const auto asset {files.Acquire(file)};
+    ASSERT_TRUE(asset);
+    EXPECT_TRUE(asset->mapping);
+    EXPECT_EQ(ToString(*asset), data);
+
+    // A modified file is loaded again, while the previous content is kept by its users.
+    temp.Rewrite("hello");
+    ReadOnlyFile modified;
+    modified.Open(path);
+    const auto reloaded {files.Acquire(modified)};
+    ASSERT_TRUE(reloaded);
+    EXPECT_NE(reloaded, asset);
+    EXPECT_EQ(ToString(*reloaded), "hello");
+    EXPECT_EQ(asset->Content().size(), data.size());
+}
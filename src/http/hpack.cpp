@@ -0,0 +1,533 @@
+#include "hpack.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+
+namespace ws::http::hpack {
+
+namespace {
+
+//! The code of a symbol in the static Huffman code.
+struct HuffmanCode {
+    std::uint32_t code;
+    std::uint8_t length;
+};
+
+//! The static Huffman code, indexed by symbols, where the last one is EOS.
+constexpr std::array<HuffmanCode, 257> huffman_codes {{
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12}, {0x1ff9, 13}, {0x15, 6},
+    {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6}, {0x0, 5}, {0x1, 5}, {0x2, 5},
+    {0x19, 6}, {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6},
+    {0x5c, 7}, {0xfb, 8}, {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7},
+    {0x61, 7}, {0x62, 7}, {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7},
+    {0x68, 7}, {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7}, {0xfd, 8},
+    {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5}, {0x25, 6},
+    {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7}, {0x28, 6}, {0x29, 6},
+    {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5}, {0x9, 5},
+    {0x2d, 6}, {0x77, 7}, {0x78, 7}, {0x79, 7}, {0x7a, 7}, {0x7b, 7},
+    {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20}, {0x3fffd3, 22},
+    {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22},
+    {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23},
+    {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23}, {0xffffec, 24},
+    {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24},
+    {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23},
+    {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23}, {0x3fffd9, 22},
+    {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22},
+    {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22},
+    {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21}, {0x7fffea, 23},
+    {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21},
+    {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21},
+    {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21}, {0x7fffed, 23},
+    {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20},
+    {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23},
+    {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23}, {0x3ffffe0, 26},
+    {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22},
+    {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26},
+    {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27}, {0x7ffffdf, 27},
+    {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19},
+    {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27},
+    {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24}, {0x1fffe4, 21},
+    {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28},
+    {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20},
+    {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21}, {0x3fffe9, 22},
+    {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22},
+    {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24},
+    {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23}, {0x3ffffeb, 26},
+    {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27},
+    {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27},
+    {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27}, {0x7ffffee, 27},
+    {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}, {0x3fffffff, 30}
+}};
+
+constexpr std::size_t eos_symbol {256};
+
+/**
+ * @brief The decoding tree of the static Huffman code.
+ *
+ * @details
+ * Each node has two children for bits @p 0 and @p 1.
+ * A non-negative child is the index of another node and a negative child @p -(symbol + 1) is a leaf.
+ */
+class HuffmanTree {
+public:
+    HuffmanTree() noexcept {
+        nodes_.push_back({0, 0});
+        for (std::size_t symbol {0}; symbol != huffman_codes.size(); ++symbol) {
+            const auto [code, length] {huffman_codes[symbol]};
+            std::size_t node {0};
+            for (auto bit {length}; bit-- > 0;) {
+                const auto branch {(code >> bit) & 1};
+                if (bit == 0) {
+                    nodes_[node][branch] = -static_cast<std::int32_t>(symbol) - 1;
+                } else {
+                    if (nodes_[node][branch] == 0) {
+                        nodes_[node][branch] =
+                            static_cast<std::int32_t>(nodes_.size());
+                        nodes_.push_back({0, 0});
+                    }
+
+                    node = nodes_[node][branch];
+                }
+            }
+        }
+    }
+
+    std::string Decode(const std::span<const std::uint8_t> in) const {
+        std::string str;
+        str.reserve(in.size() * 8 / 5);
+
+        std::size_t node {0};
+        // Bits after the last symbol, which must be a prefix of EOS consisting of ones.
+        std::size_t pending_bits {0};
+        bool all_ones {true};
+        for (const auto byte : in) {
+            for (auto bit {8}; bit-- > 0;) {
+                const auto branch {(byte >> bit) & 1};
+                ++pending_bits;
+                all_ones = all_ones && branch == 1;
+                if (const auto next {nodes_[node][branch]}; next < 0) {
+                    const auto symbol {static_cast<std::size_t>(-next - 1)};
+                    if (symbol == eos_symbol) {
+                        throw std::invalid_argument {
+                            "A Huffman-encoded string contains EOS"};
+                    }
+
+                    str.push_back(static_cast<char>(symbol));
+                    node = 0;
+                    pending_bits = 0;
+                    all_ones = true;
+                } else {
+                    node = next;
+                }
+            }
+        }
+
+        if (pending_bits > 7 || !all_ones) {
+            throw std::invalid_argument {
+                "A Huffman-encoded string has invalid padding"};
+        }
+
+        return str;
+    }
+
+private:
+    std::vector<std::array<std::int32_t, 2>> nodes_;
+};
+
+//! The static table, whose indices start from one.
+const std::array<HeaderField, 61> static_table {{
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+}};
+
+//! Fields whose values change between responses or are sensitive, which are not indexed.
+constexpr std::array<std::string_view, 7> unindexed_names {
+    "content-length", "content-range", "etag", "last-modified",
+    "date",           "set-cookie",    "authorization"};
+
+//! Representations of header fields, which are identified by the high bits of the first byte.
+constexpr std::uint8_t indexed_flag {0x80};
+constexpr std::uint8_t incremental_indexing_flag {0x40};
+constexpr std::uint8_t table_size_update_flag {0x20};
+constexpr std::uint8_t huffman_flag {0x80};
+
+}  // namespace
+
+void EncodeInteger(std::string& out, std::uint64_t value,
+                   const std::size_t prefix_bits,
+                   const std::uint8_t flags) noexcept {
+    assert(prefix_bits >= 1 && prefix_bits <= 8);
+    const std::uint64_t max_prefix {(1u << prefix_bits) - 1};
+    if (value < max_prefix) {
+        out.push_back(static_cast<char>(flags | value));
+        return;
+    }
+
+    out.push_back(static_cast<char>(flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t DecodeInteger(std::span<const std::uint8_t>& in,
+                            const std::size_t prefix_bits) {
+    assert(prefix_bits >= 1 && prefix_bits <= 8);
+    if (in.empty()) {
+        throw std::invalid_argument {"An integer is incomplete"};
+    }
+
+    const std::uint64_t max_prefix {(1u << prefix_bits) - 1};
+    std::uint64_t value {in.front() & max_prefix};
+    in = in.subspan(1);
+    if (value < max_prefix) {
+        return value;
+    }
+
+    // Integers larger than 2^56 are not needed by any field or size.
+    for (std::size_t shift {0}; shift <= 56; shift += 7) {
+        if (in.empty()) {
+            throw std::invalid_argument {"An integer is incomplete"};
+        }
+
+        const auto byte {in.front()};
+        in = in.subspan(1);
+        value += static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    throw std::invalid_argument {"An integer is too large"};
+}
+
+std::size_t HuffmanEncodedSize(const std::string_view str) noexcept {
+    std::size_t bits {0};
+    for (const auto c : str) {
+        bits += huffman_codes[static_cast<std::uint8_t>(c)].length;
+    }
+
+    return (bits + 7) / 8;
+}
+
+void HuffmanEncode(std::string& out, const std::string_view str) noexcept {
+    std::uint64_t bits {0};
+    std::size_t bit_count {0};
+    for (const auto c : str) {
+        const auto [code, length] {huffman_codes[static_cast<std::uint8_t>(c)]};
+        bits = (bits << length) | code;
+        bit_count += length;
+        while (bit_count >= 8) {
+            bit_count -= 8;
+            out.push_back(static_cast<char>(bits >> bit_count));
+        }
+    }
+
+    // Pad the last byte with the most significant bits of EOS, which are ones.
+    if (bit_count > 0) {
+        out.push_back(static_cast<char>((bits << (8 - bit_count))
+                                        | (0xFF >> bit_count)));
+    }
+}
+
+std::string HuffmanDecode(const std::span<const std::uint8_t> in) {
+    static const HuffmanTree tree;
+    return tree.Decode(in);
+}
+
+DynamicTable::DynamicTable(const std::size_t max_size) noexcept :
+    max_size_ {max_size} {}
+
+std::size_t DynamicTable::EntrySize(const HeaderField& field) noexcept {
+    // Each entry has an overhead of 32 bytes.
+    return field.name.size() + field.value.size() + 32;
+}
+
+void DynamicTable::Insert(HeaderField field) noexcept {
+    const auto size {EntrySize(field)};
+    if (size > max_size_) {
+        // An entry larger than the table empties it.
+        Evict(0);
+        return;
+    }
+
+    Evict(max_size_ - size);
+    size_ += size;
+    entries_.push_front(std::move(field));
+}
+
+void DynamicTable::Resize(const std::size_t max_size) noexcept {
+    max_size_ = max_size;
+    Evict(max_size_);
+}
+
+void DynamicTable::Evict(const std::size_t max_size) noexcept {
+    while (size_ > max_size) {
+        size_ -= EntrySize(entries_.back());
+        entries_.pop_back();
+    }
+}
+
+const HeaderField* DynamicTable::Get(const std::size_t idx) const noexcept {
+    return idx < entries_.size() ? &entries_[idx] : nullptr;
+}
+
+std::size_t DynamicTable::Count() const noexcept {
+    return entries_.size();
+}
+
+std::size_t DynamicTable::Size() const noexcept {
+    return size_;
+}
+
+std::size_t DynamicTable::MaxSize() const noexcept {
+    return max_size_;
+}
+
+void Encoder::SetMaxTableSize(const std::size_t max_size) noexcept {
+    const auto size {std::min(max_size, default_table_size)};
+    if (size != table_.MaxSize()) {
+        table_.Resize(size);
+        table_size_update_ = size;
+    }
+}
+
+std::string Encoder::Encode(const HeaderList& fields) noexcept {
+    std::string block;
+    if (table_size_update_.has_value()) {
+        EncodeInteger(block, table_size_update_.value(), 5,
+                      table_size_update_flag);
+        table_size_update_.reset();
+    }
+
+    for (const auto& field : fields) {
+        // Find a matching entry, preferring the one matching both the name and the value.
+        std::size_t name_idx {0};
+        std::size_t field_idx {0};
+        for (std::size_t i {0}; i != static_table.size() && field_idx == 0;
+             ++i) {
+            if (static_table[i].name == field.name) {
+                name_idx = name_idx == 0 ? i + 1 : name_idx;
+                if (static_table[i].value == field.value) {
+                    field_idx = i + 1;
+                }
+            }
+        }
+
+        for (std::size_t i {0}; i != table_.Count() && field_idx == 0; ++i) {
+            if (const auto entry {table_.Get(i)}; entry->name == field.name) {
+                name_idx = name_idx == 0 ? static_table.size() + i + 1
+                                         : name_idx;
+                if (entry->value == field.value) {
+                    field_idx = static_table.size() + i + 1;
+                }
+            }
+        }
+
+        if (field_idx != 0) {
+            EncodeInteger(block, field_idx, 7, indexed_flag);
+            continue;
+        }
+
+        const auto indexed {std::ranges::find(unindexed_names, field.name)
+                            == unindexed_names.cend()};
+        if (indexed) {
+            EncodeInteger(block, name_idx, 6, incremental_indexing_flag);
+        } else {
+            EncodeInteger(block, name_idx, 4);
+        }
+
+        if (name_idx == 0) {
+            EncodeString(block, field.name);
+        }
+
+        EncodeString(block, field.value);
+        if (indexed) {
+            table_.Insert(field);
+        }
+    }
+
+    return block;
+}
+
+void Encoder::EncodeString(std::string& out,
+                           const std::string_view str) noexcept {
+    if (const auto size {HuffmanEncodedSize(str)}; size < str.size()) {
+        EncodeInteger(out, size, 7, huffman_flag);
+        HuffmanEncode(out, str);
+    } else {
+        EncodeInteger(out, str.size(), 7);
+        out.append(str);
+    }
+}
+
+Decoder::Decoder(const std::size_t max_table_size,
+                 const std::size_t max_list_size) noexcept :
+    table_ {max_table_size},
+    max_table_size_ {max_table_size},
+    max_list_size_ {max_list_size} {}
+
+HeaderList Decoder::Decode(std::span<const std::uint8_t> block) {
+    HeaderList fields;
+    std::size_t list_size {0};
+    bool field_decoded {false};
+    while (!block.empty()) {
+        const auto first {block.front()};
+        if (first & indexed_flag) {
+            const auto idx {DecodeInteger(block, 7)};
+            if (idx == 0) {
+                throw std::invalid_argument {"A field has an index of zero"};
+            }
+
+            fields.push_back(Lookup(idx));
+        } else if ((first & 0xE0) == table_size_update_flag) {
+            // Size updates can only appear at the start of a header block.
+            if (field_decoded) {
+                throw std::invalid_argument {
+                    "A dynamic table size update follows header fields"};
+            }
+
+            const auto size {DecodeInteger(block, 5)};
+            if (size > max_table_size_) {
+                throw std::invalid_argument {
+                    "A dynamic table size exceeds the limit"};
+            }
+
+            table_.Resize(size);
+            continue;
+        } else {
+            // A literal field, whose name is either indexed or a literal.
+            const auto incremental {(first & 0xC0)
+                                    == incremental_indexing_flag};
+            const auto prefix_bits {incremental ? 6u : 4u};
+            const auto name_idx {DecodeInteger(block, prefix_bits)};
+
+            HeaderField field;
+            field.name = name_idx == 0 ? DecodeString(block)
+                                       : Lookup(name_idx).name;
+            field.value = DecodeString(block);
+            if (incremental) {
+                table_.Insert(field);
+            }
+
+            fields.push_back(std::move(field));
+        }
+
+        field_decoded = true;
+        list_size += DynamicTable::EntrySize(fields.back());
+        if (list_size > max_list_size_) {
+            throw std::invalid_argument {"A header list is too large"};
+        }
+    }
+
+    return fields;
+}
+
+const HeaderField& Decoder::Lookup(const std::uint64_t idx) const {
+    assert(idx > 0);
+    if (idx <= static_table.size()) {
+        return static_table[idx - 1];
+    } else if (const auto entry {table_.Get(idx - static_table.size() - 1)};
+               entry) {
+        return *entry;
+    } else {
+        throw std::invalid_argument {"A field index is out of range"};
+    }
+}
+
+std::string Decoder::DecodeString(std::span<const std::uint8_t>& in) {
+    if (in.empty()) {
+        throw std::invalid_argument {"A string literal is incomplete"};
+    }
+
+    const auto huffman {(in.front() & huffman_flag) != 0};
+    const auto length {DecodeInteger(in, 7)};
+    if (length > in.size()) {
+        throw std::invalid_argument {"A string literal is incomplete"};
+    }
+
+    const auto bytes {in.first(length)};
+    in = in.subspan(length);
+    return huffman ? HuffmanDecode(bytes)
+                   : std::string {bytes.begin(), bytes.end()};
+}
+
+}  // namespace ws::http::hpack
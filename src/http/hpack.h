@@ -0,0 +1,176 @@
+/**
+ * @file hpack.h
+ * @brief The HPACK header compression for HTTP/2.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-24
+ *
+ * @example src/http/hpack_test.cpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace ws::http::hpack {
+
+//! A header field, whose name is in lowercase.
+struct HeaderField {
+    bool operator==(const HeaderField&) const noexcept = default;
+
+    std::string name;
+    std::string value;
+};
+
+using HeaderList = std::vector<HeaderField>;
+
+//! The default maximum size of a dynamic table.
+inline constexpr std::size_t default_table_size {4096};
+
+/**
+ * @brief Append an integer with an @p N-bit prefix.
+ *
+ * @param out A string to receive the bytes.
+ * @param value The integer.
+ * @param prefix_bits The number of bits of the prefix, from 1 to 8.
+ * @param flags The bits above the prefix in the first byte.
+ */
+void EncodeInteger(std::string& out, std::uint64_t value,
+                   std::size_t prefix_bits, std::uint8_t flags = 0) noexcept;
+
+/**
+ * @brief Read an integer with an @p N-bit prefix and move the input after it.
+ *
+ * @exception std::invalid_argument The integer is incomplete or too large.
+ */
+std::uint64_t DecodeInteger(std::span<const std::uint8_t>& in,
+                            std::size_t prefix_bits);
+
+//! Get the size of a string encoded by the static Huffman code.
+std::size_t HuffmanEncodedSize(std::string_view str) noexcept;
+
+//! Append a string encoded by the static Huffman code.
+void HuffmanEncode(std::string& out, std::string_view str) noexcept;
+
+/**
+ * @brief Decode a string encoded by the static Huffman code.
+ *
+ * @exception std::invalid_argument The string has invalid padding or contains the EOS symbol.
+ */
+std::string HuffmanDecode(std::span<const std::uint8_t> in);
+
+//! The dynamic table, where new entries are inserted at the front and the oldest ones are evicted.
+class DynamicTable {
+public:
+    explicit DynamicTable(std::size_t max_size = default_table_size) noexcept;
+
+    //! Insert an entry, evicting the oldest ones to make space.
+    void Insert(HeaderField field) noexcept;
+
+    //! Change the maximum size, evicting entries that no longer fit.
+    void Resize(std::size_t max_size) noexcept;
+
+    /**
+     * @brief Get an entry by its index in the dynamic table, starting from zero for the newest one.
+     *
+     * @return The entry, or @p nullptr if the index is out of range.
+     */
+    const HeaderField* Get(std::size_t idx) const noexcept;
+
+    //! Get the number of entries.
+    std::size_t Count() const noexcept;
+
+    //! Get the sum of entry sizes, each of which counts 32 bytes of overhead.
+    std::size_t Size() const noexcept;
+
+    std::size_t MaxSize() const noexcept;
+
+    //! Get the size of an entry.
+    static std::size_t EntrySize(const HeaderField& field) noexcept;
+
+private:
+    void Evict(std::size_t max_size) noexcept;
+
+    std::deque<HeaderField> entries_;
+    std::size_t size_ {0};
+    std::size_t max_size_;
+};
+
+/**
+ * @brief The header block encoder.
+ *
+ * @details
+ * Fields in the static or dynamic table are sent as indices.
+ * Others are sent as literals with incremental indexing,
+ * except for values that change between responses, such as @p content-length and @p etag,
+ * which would only evict reusable entries.
+ * Strings are Huffman-encoded if that makes them shorter.
+ */
+class Encoder {
+public:
+    /**
+     * @brief Set the maximum dynamic table size allowed by the decoder.
+     *
+     * @details A dynamic table size update is sent at the start of the next header block.
+     */
+    void SetMaxTableSize(std::size_t max_size) noexcept;
+
+    //! Encode a header list into a header block.
+    std::string Encode(const HeaderList& fields) noexcept;
+
+private:
+    //! Append a string literal.
+    static void EncodeString(std::string& out, std::string_view str) noexcept;
+
+    DynamicTable table_;
+    std::optional<std::size_t> table_size_update_;
+};
+
+/**
+ * @brief The header block decoder.
+ *
+ * @details Since the dynamic table is shared by all header blocks, every block must be decoded in order.
+ */
+class Decoder {
+public:
+    /**
+     * @brief Create a decoder.
+     *
+     * @param max_table_size The maximum dynamic table size allowed by the decoder.
+     * @param max_list_size The maximum size of a decoded header list, counting 32 bytes of overhead per field.
+     */
+    explicit Decoder(std::size_t max_table_size = default_table_size,
+                     std::size_t max_list_size = 0x10000) noexcept;
+
+    /**
+     * @brief Decode a header block.
+     *
+     * @exception std::invalid_argument The header block is invalid or the header list is too large.
+     */
+    HeaderList Decode(std::span<const std::uint8_t> block);
+
+private:
+    //! Get an entry from the static or dynamic table by its index starting from one.
+    const HeaderField& Lookup(std::uint64_t idx) const;
+
+    //! Read a string literal and move the input after it.
+    static std::string DecodeString(std::span<const std::uint8_t>& in);
+
+    DynamicTable table_;
+    std::size_t max_table_size_;
+    std::size_t max_list_size_;
+};
+
+}  // namespace ws::http::hpack
@@ -0,0 +1,261 @@
+#include "hpack.h"
+
+#include <gtest/gtest.h>
+
+#include <charconv>
+
+using namespace ws::http::hpack;
+
+
+namespace {
+
+//! Convert a hexadecimal string, which may contain spaces, to bytes.
+std::vector<std::uint8_t> FromHex(const std::string_view hex) noexcept {
+    std::vector<std::uint8_t> bytes;
+    for (std::size_t i {0}; i < hex.size();) {
+        if (hex[i] == ' ') {
+            ++i;
+            continue;
+        }
+
+        std::uint8_t byte {0};
+        std::from_chars(hex.data() + i, hex.data() + i + 2, byte, 16);
+        bytes.push_back(byte);
+        i += 2;
+    }
+
+    return bytes;
+}
+
+std::string ToString(const std::vector<std::uint8_t>& bytes) noexcept {
+    return {bytes.cbegin(), bytes.cend()};
+}
+
+std::span<const std::uint8_t> ToSpan(const std::string& str) noexcept {
+    return {reinterpret_cast<const std::uint8_t*>(str.data()), str.size()};
+}
+
+}  // namespace
+
+TEST(HPACKTest, Integers) {
+    // Examples from RFC 7541, Appendix C.1.
+    const std::vector<std::tuple<std::uint64_t, std::size_t, std::string_view>>
+        cases {{10, 5, "0a"}, {1337, 5, "1f9a0a"}, {42, 8, "2a"}};
+    for (const auto& [value, prefix_bits, hex] : cases) {
+        std::string encoded;
+        EncodeInteger(encoded, value, prefix_bits);
+        EXPECT_EQ(encoded, ToString(FromHex(hex)));
+
+        const auto bytes {FromHex(hex)};
+        std::span<const std::uint8_t> in {bytes};
+        EXPECT_EQ(DecodeInteger(in, prefix_bits), value);
+        EXPECT_TRUE(in.empty());
+    }
+
+    {
+        // The flags above the prefix are kept when encoding and ignored when decoding.
+        std::string encoded;
+        EncodeInteger(encoded, 10, 5, 0xE0);
+        EXPECT_EQ(encoded, "\xEA");
+
+        std::span<const std::uint8_t> in {ToSpan(encoded)};
+        EXPECT_EQ(DecodeInteger(in, 5), 10);
+    }
+
+    {
+        const auto bytes {FromHex("1f9a")};
+        std::span<const std::uint8_t> in {bytes};
+        EXPECT_THROW(DecodeInteger(in, 5), std::invalid_argument);
+    }
+
+    {
+        const auto bytes {FromHex("ff ffffffffffffffffff 01")};
+        std::span<const std::uint8_t> in {bytes};
+        EXPECT_THROW(DecodeInteger(in, 8), std::invalid_argument);
+    }
+}
+
+TEST(HPACKTest, Huffman) {
+    // Examples from RFC 7541, Appendix C.4 and C.6.
+    const std::vector<std::pair<std::string_view, std::string_view>> cases {
+        {"www.example.com", "f1e3c2e5f23a6ba0ab90f4ff"},
+        {"no-cache", "a8eb10649cbf"},
+        {"custom-key", "25a849e95ba97d7f"},
+        {"custom-value", "25a849e95bb8e8b4bf"},
+        {"302", "6402"},
+        {"private", "aec3771a4b"},
+        {"Mon, 21 Oct 2013 20:13:21 GMT",
+         "d07abe941054d444a8200595040b8166e082a62d1bff"},
+        {"https://www.example.com", "9d29ad171863c78f0b97c8e9ae82ae43d3"}};
+    for (const auto& [str, hex] : cases) {
+        std::string encoded;
+        HuffmanEncode(encoded, str);
+        EXPECT_EQ(encoded, ToString(FromHex(hex)));
+        EXPECT_EQ(HuffmanEncodedSize(str), encoded.size());
+        EXPECT_EQ(HuffmanDecode(FromHex(hex)), str);
+    }
+
+    {
+        // Every octet can be encoded.
+        std::string str;
+        for (std::size_t c {0}; c != 0x100; ++c) {
+            str.push_back(static_cast<char>(c));
+        }
+
+        std::string encoded;
+        HuffmanEncode(encoded, str);
+        EXPECT_EQ(HuffmanDecode(ToSpan(encoded)), str);
+    }
+
+    // The padding is longer than 7 bits.
+    EXPECT_THROW(HuffmanDecode(FromHex("f1e3c2e5f23a6ba0ab90f4ffff")),
+                 std::invalid_argument);
+
+    // The padding is not the most significant bits of EOS.
+    EXPECT_THROW(HuffmanDecode(FromHex("f1e3c2e5f23a6ba0ab90f4fe")),
+                 std::invalid_argument);
+
+    // The string contains EOS.
+    EXPECT_THROW(HuffmanDecode(FromHex("fffffffc")), std::invalid_argument);
+}
+
+TEST(HPACKTest, DynamicTable) {
+    DynamicTable table {100};
+    EXPECT_EQ(table.Count(), 0);
+    EXPECT_EQ(table.Get(0), nullptr);
+
+    table.Insert({"a", "1"});
+    table.Insert({"b", "2"});
+    EXPECT_EQ(table.Count(), 2);
+    EXPECT_EQ(table.Size(), 68);
+    EXPECT_EQ(*table.Get(0), (HeaderField {"b", "2"}));
+    EXPECT_EQ(*table.Get(1), (HeaderField {"a", "1"}));
+
+    // The oldest entry is evicted.
+    table.Insert({"c", "3"});
+    EXPECT_EQ(table.Count(), 2);
+    EXPECT_EQ(*table.Get(0), (HeaderField {"c", "3"}));
+    EXPECT_EQ(*table.Get(1), (HeaderField {"b", "2"}));
+
+    table.Resize(40);
+    EXPECT_EQ(table.Count(), 1);
+    EXPECT_EQ(table.MaxSize(), 40);
+
+    // An entry larger than the table empties it.
+    table.Insert({"d", std::string(100, 'x')});
+    EXPECT_EQ(table.Count(), 0);
+    EXPECT_EQ(table.Size(), 0);
+}
+
+TEST(HPACKTest, DecodeRequestsWithoutHuffman) {
+    // Examples from RFC 7541, Appendix C.3.
+    Decoder decoder;
+    EXPECT_EQ(
+        decoder.Decode(FromHex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 "
+                               "2e63 6f6d")),
+        (HeaderList {{":method", "GET"},
+                     {":scheme", "http"},
+                     {":path", "/"},
+                     {":authority", "www.example.com"}}));
+
+    EXPECT_EQ(decoder.Decode(FromHex("8286 84be 5808 6e6f 2d63 6163 6865")),
+              (HeaderList {{":method", "GET"},
+                           {":scheme", "http"},
+                           {":path", "/"},
+                           {":authority", "www.example.com"},
+                           {"cache-control", "no-cache"}}));
+
+    EXPECT_EQ(
+        decoder.Decode(FromHex("8287 85bf 400a 6375 7374 6f6d 2d6b 6579 "
+                               "0c63 7573 746f 6d2d 7661 6c75 65")),
+        (HeaderList {{":method", "GET"},
+                     {":scheme", "https"},
+                     {":path", "/index.html"},
+                     {":authority", "www.example.com"},
+                     {"custom-key", "custom-value"}}));
+}
+
+TEST(HPACKTest, EncodeRequestsWithHuffman) {
+    // Examples from RFC 7541, Appendix C.4.
+    const std::vector<std::pair<HeaderList, std::string_view>> cases {
+        {{{":method", "GET"},
+          {":scheme", "http"},
+          {":path", "/"},
+          {":authority", "www.example.com"}},
+         "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"},
+        {{{":method", "GET"},
+          {":scheme", "http"},
+          {":path", "/"},
+          {":authority", "www.example.com"},
+          {"cache-control", "no-cache"}},
+         "8286 84be 5886 a8eb 1064 9cbf"},
+        {{{":method", "GET"},
+          {":scheme", "https"},
+          {":path", "/index.html"},
+          {":authority", "www.example.com"},
+          {"custom-key", "custom-value"}},
+         "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"}};
+
+    Encoder encoder;
+    Decoder decoder;
+    for (const auto& [fields, hex] : cases) {
+        const auto block {encoder.Encode(fields)};
+        EXPECT_EQ(block, ToString(FromHex(hex)));
+        EXPECT_EQ(decoder.Decode(ToSpan(block)), fields);
+    }
+}
+
+TEST(HPACKTest, EncodeChangingValuesWithoutIndexing) {
+    const HeaderList fields {{":status", "200"},
+                             {"content-type", "text/html"},
+                             {"content-length", "1234"}};
+
+    Encoder encoder;
+    Decoder decoder;
+    const auto first {encoder.Encode(fields)};
+    EXPECT_EQ(decoder.Decode(ToSpan(first)), fields);
+
+    // The content type is indexed, but the content length is not.
+    const auto second {encoder.Encode(fields)};
+    EXPECT_EQ(second.substr(0, 2), ToString(FromHex("88be")));
+    EXPECT_EQ(static_cast<std::uint8_t>(second[2]), 0x0F);
+    EXPECT_EQ(decoder.Decode(ToSpan(second)), fields);
+}
+
+TEST(HPACKTest, TableSizeUpdate) {
+    Encoder encoder;
+    Decoder decoder;
+    encoder.SetMaxTableSize(0);
+
+    const HeaderList fields {{"custom-key", "custom-value"}};
+    const auto block {encoder.Encode(fields)};
+    EXPECT_EQ(static_cast<std::uint8_t>(block.front()), 0x20);
+    EXPECT_EQ(decoder.Decode(ToSpan(block)), fields);
+
+    // Nothing has been inserted, so the field is sent as a literal again.
+    EXPECT_EQ(encoder.Encode(fields), block.substr(1));
+
+    // A size larger than the setting is invalid.
+    Decoder small_decoder {100};
+    EXPECT_THROW(small_decoder.Decode(FromHex("3f46")), std::invalid_argument);
+}
+
+TEST(HPACKTest, InvalidBlocks) {
+    Decoder decoder;
+
+    // An index of zero.
+    EXPECT_THROW(decoder.Decode(FromHex("80")), std::invalid_argument);
+
+    // An index out of the tables.
+    EXPECT_THROW(decoder.Decode(FromHex("be")), std::invalid_argument);
+
+    // A string longer than the block.
+    EXPECT_THROW(decoder.Decode(FromHex("4005 6162")), std::invalid_argument);
+
+    {
+        // A header list larger than the limit.
+        Decoder small_decoder {default_table_size, 40};
+        EXPECT_THROW(small_decoder.Decode(FromHex("8286")),
+                     std::invalid_argument);
+    }
+}
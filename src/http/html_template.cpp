@@ -0,0 +1,184 @@
+#include "html_template.h"
+
+#include <sys/stat.h>
+
+#include <cassert>
+#include <concepts>
+
+
+namespace ws::http {
+
+namespace {
+
+/**
+ * @brief Visit a string piece by piece with line breaks normalized to @p CRLF.
+ *
+ * @details
+ * Like @p SplitStringToLines, any carriage returns before a line feed are treated as part of the line break.
+ */
+template <std::invocable<std::string_view> Visitor>
+void VisitNormalizedLines(std::string_view str, Visitor&& visit) noexcept {
+    static constexpr std::string_view crlf {"\r\n"};
+    while (!str.empty()) {
+        const auto lf {str.find('\n')};
+        if (lf == std::string_view::npos) {
+            visit(str);
+            break;
+        }
+
+        auto end {lf};
+        while (end > 0 && str[end - 1] == '\r') {
+            --end;
+        }
+
+        visit(str.substr(0, end));
+        visit(crlf);
+        str.remove_prefix(lf + 1);
+    }
+}
+
+//! Normalize line breaks in a string to @p CRLF.
+std::string NormalizeLines(const std::string_view str) noexcept {
+    std::string normalized;
+    normalized.reserve(str.size());
+    VisitNormalizedLines(str, [&normalized](const std::string_view piece) {
+        normalized.append(piece);
+    });
+
+    return normalized;
+}
+
+}  // namespace
+
+HTMLTemplate::HTMLTemplate(std::string_view html) noexcept {
+    // The beginning and end of placeholders created by `HTMLPlaceholder`.
+    static constexpr std::string_view open {"<$"};
+    static constexpr std::string_view close {"$>"};
+
+    const auto add_literal {[this](const std::string_view literal) {
+        if (!literal.empty()) {
+            segments_.push_back({.text = NormalizeLines(literal)});
+        }
+    }};
+
+    while (!html.empty()) {
+        auto begin {html.find(open)};
+        if (begin == std::string_view::npos) {
+            break;
+        }
+
+        const auto end {html.find(close, begin + open.length())};
+        if (end == std::string_view::npos) {
+            break;
+        }
+
+        // Use the nearest beginning if there are several before the end.
+        begin = html.rfind(open, end - open.length());
+
+        add_literal(html.substr(0, begin));
+        const auto key_begin {begin + open.length()};
+        segments_.push_back(
+            {.text = std::string {html.substr(key_begin, end - key_begin)},
+             .placeholder = true});
+        html.remove_prefix(end + close.length());
+    }
+
+    add_literal(html);
+
+    // Remove the trailing line break.
+    static constexpr std::string_view crlf {"\r\n"};
+    if (!segments_.empty() && !segments_.back().placeholder
+        && segments_.back().text.ends_with(crlf)) {
+        auto& text {segments_.back().text};
+        text.erase(text.size() - crlf.length());
+        if (text.empty()) {
+            segments_.pop_back();
+        }
+    }
+}
+
+std::optional<std::string_view> HTMLTemplate::Value(
+    const Segment& segment, const Parameters& params) noexcept {
+    assert(segment.placeholder);
+    if (const auto param {params.find(segment.text)}; param != params.cend()) {
+        return param->second;
+    } else {
+        return std::nullopt;
+    }
+}
+
+std::size_t HTMLTemplate::Length(const Parameters& params) const noexcept {
+    std::size_t length {0};
+    for (const auto& segment : segments_) {
+        if (!segment.placeholder) {
+            length += segment.text.length();
+        } else if (const auto value {Value(segment, params)};
+                   value.has_value()) {
+            VisitNormalizedLines(value.value(),
+                                 [&length](const std::string_view piece) {
+                                     length += piece.length();
+                                 });
+        } else {
+            length += HTMLPlaceholder(segment.text).length();
+        }
+    }
+
+    return length;
+}
+
+void HTMLTemplate::Render(Buffer& buf,
+                          const Parameters& params) const noexcept {
+    for (const auto& segment : segments_) {
+        if (!segment.placeholder) {
+            buf.Append(segment.text);
+        } else if (const auto value {Value(segment, params)};
+                   value.has_value()) {
+            VisitNormalizedLines(
+                value.value(),
+                [&buf](const std::string_view piece) { buf.Append(piece); });
+        } else {
+            buf.Append(HTMLPlaceholder(segment.text));
+        }
+    }
+}
+
+HTMLTemplate::Ptr HTMLTemplateCache::Get(const std::filesystem::path& path) {
+    const std::string key {path};
+
+    struct stat status {};
+    if (stat(key.c_str(), &status) < 0) {
+        ThrowLastSystemError();
+    }
+
+    {
+        const std::lock_guard locker {mtx_};
+        if (const auto entry {templates_.find(key)};
+            entry != templates_.cend()
+            && entry->second.modification_time == ModificationTime(status)
+            && entry->second.size
+                   == static_cast<std::size_t>(status.st_size)) {
+            return entry->second.html;
+        }
+    }
+
+    // Compile the template without holding the lock.
+    ReadOnlyFile file;
+    file.Open(key);
+    const auto content {file.ReadAll()};
+    auto html {std::make_shared<const HTMLTemplate>(std::string_view {
+        reinterpret_cast<const char*>(content.data()), content.size()})};
+
+    const std::lock_guard locker {mtx_};
+    templates_.insert_or_assign(
+        key, Entry {.html = html,
+                    .modification_time = file.ModificationTime(),
+                    .size = file.Size()});
+    return html;
+}
+
+void HTMLTemplateCache::Clear() noexcept {
+    const std::lock_guard locker {mtx_};
+    templates_.clear();
+}
+
+}  // namespace ws::http
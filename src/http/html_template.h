@@ -0,0 +1,113 @@
+/**
+ * @file html_template.h
+ * @brief The compiled HTML template.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-06-30
+ */
+
+#pragma once
+
+#include "containers/buffer.h"
+#include "http.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace ws::http {
+
+/**
+ * @brief An HTML page compiled into literal segments and placeholder slots.
+ *
+ * @details
+ * Placeholders are created by @p HTMLPlaceholder.
+ * Rendering is a single linear pass without searching or copying the page.
+ *
+ * Line breaks in both the page and parameter values are normalized to @p CRLF,
+ * and a trailing line break of the page is removed.
+ */
+class HTMLTemplate {
+public:
+    using Ptr = std::shared_ptr<const HTMLTemplate>;
+
+    //! Compile an HTML page.
+    explicit HTMLTemplate(std::string_view html) noexcept;
+
+    /**
+     * @brief Get the length of the rendered content.
+     *
+     * @param params
+     * HTTP parameters for replacement.
+     * A placeholder without a parameter will be kept as it is.
+     * The parameter name is case-sensitive.
+     */
+    std::size_t Length(const Parameters& params) const noexcept;
+
+    //! Render the content into a buffer.
+    void Render(Buffer& buf, const Parameters& params) const noexcept;
+
+private:
+    struct Segment {
+        //! A literal, or the key of a placeholder.
+        std::string text;
+
+        bool placeholder {false};
+    };
+
+    /**
+     * @brief Get the value of a placeholder segment.
+     *
+     * @return The parameter value, or @p std::nullopt if there is no such parameter.
+     */
+    static std::optional<std::string_view> Value(
+        const Segment& segment, const Parameters& params) noexcept;
+
+    std::vector<Segment> segments_;
+};
+
+/**
+ * @brief The cache for compiled HTML templates.
+ *
+ * @details
+ * A template is recompiled when the modification time or size of its file changes.
+ *
+ * It is thread-safe.
+ */
+class HTMLTemplateCache {
+public:
+    /**
+     * @brief Get a compiled template, compiling it if it is not cached or has been modified.
+     *
+     * @exception std::invalid_argument The path refers to a directory.
+     * @exception std::runtime_error No permission to access the file.
+     * @exception std::system_error Failed to read the file.
+     */
+    HTMLTemplate::Ptr Get(const std::filesystem::path& path);
+
+    //! Remove all templates.
+    void Clear() noexcept;
+
+private:
+    struct Entry {
+        HTMLTemplate::Ptr html;
+        std::chrono::system_clock::time_point modification_time;
+        std::size_t size {0};
+    };
+
+    std::mutex mtx_;
+    std::unordered_map<std::string, Entry> templates_;
+};
+
+}  // namespace ws::http
@@ -0,0 +1,91 @@
+#include "html_template.h"
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+
+using namespace ws;
+using namespace ws::http;
+using namespace ws::test;
+
+
+namespace {
+
+//! Render a template into a string and check its length.
+std::string Render(const HTMLTemplate& html, const Parameters& params) {
+    Buffer buf;
+    html.Render(buf, params);
+    auto content {buf.RetrieveAllToString()};
+    EXPECT_EQ(html.Length(params), content.length());
+    return content;
+}
+
+}  // namespace
+
+TEST(HTMLTemplateTest, Render) {
+    {
+        const HTMLTemplate html {""};
+        EXPECT_EQ(Render(html, {{"name", "mike"}}), "");
+    }
+
+    {
+        const HTMLTemplate html {"<p><$name$></p>"};
+        EXPECT_EQ(Render(html, {{"name", "mike"}}), "<p>mike</p>");
+        EXPECT_EQ(Render(html, {{"NAME", "mike"}}), "<p><$name$></p>");
+    }
+
+    {
+        const HTMLTemplate html {"<$name$> said: <$msg$><$name$>"};
+        EXPECT_EQ(Render(html, {{"name", "mike"}, {"msg", "hello"}}),
+                  "mike said: hellomike");
+        EXPECT_EQ(Render(html, {{"name", "mike"}}),
+                  "mike said: <$msg$>mike");
+    }
+
+    {
+        // The nearest beginning is used.
+        const HTMLTemplate html {"<$<$name$>"};
+        EXPECT_EQ(Render(html, {{"name", "mike"}}), "<$mike");
+    }
+}
+
+TEST(HTMLTemplateTest, NormalizeLines) {
+    {
+        // Line breaks in both the page and values are normalized.
+        const HTMLTemplate html {"a\r\r\nb<$k$><$x$>\nc"};
+        EXPECT_EQ(Render(html, {{"k", "v\nw"}}), "a\r\nbv\r\nw<$x$>\r\nc");
+    }
+
+    {
+        // The trailing line break is removed.
+        const HTMLTemplate html {"a<$k$>b\n"};
+        EXPECT_EQ(Render(html, {{"k", "v"}}), "avb");
+    }
+
+    {
+        const HTMLTemplate html {"\n\nx\n\n"};
+        EXPECT_EQ(Render(html, {}), "\r\n\r\nx\r\n");
+    }
+}
+
+TEST(HTMLTemplateCacheTest, Get) {
+    // Create a temporary file.
+    const TempTestFile temp;
+    const auto& path {temp.Path()};
+
+    temp.Rewrite("<$name$>");
+
+    HTMLTemplateCache cache;
+    const auto html {cache.Get(path)};
+    ASSERT_TRUE(html);
+    EXPECT_EQ(Render(*html, {{"name", "mike"}}), "mike");
+    EXPECT_EQ(cache.Get(path), html);
+
+    // The template is recompiled after the file is modified.
+    temp.Rewrite("<$name$>!");
+    const auto new_html {cache.Get(path)};
+    EXPECT_NE(new_html, html);
+    EXPECT_EQ(Render(*new_html, {{"name", "mike"}}), "mike!");
+
+    EXPECT_THROW(cache.Get("."), std::invalid_argument);
+    EXPECT_THROW(cache.Get("non_existing_file"), std::system_error);
+}
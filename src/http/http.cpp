@@ -1,17 +1,33 @@
 #include "http.h"
+#include "asset_cache.h"
+#include "asset_pack.h"
+#include "containers/perfect_hash_map.h"
+#include "file_registry.h"
+#include "http2.h"
 #include "io.h"
+#include "metrics.h"
+#include "proxy.h"
 #include "request.h"
 #include "response.h"
+#include "tls.h"
+#include "url_encoding.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <ctime>
 #include <filesystem>
-#include <sstream>
 
 
 namespace ws::http {
 
 namespace {
 
+constexpr std::string_view index_page {"/index.html"};
+
 std::optional<Parameters> ExtractUserMessage(const Request& request) noexcept {
     static constexpr std::string_view user_tag {"user"};
     static constexpr std::string_view msg_tag {"msg"};
@@ -26,14 +42,48 @@ std::optional<Parameters> ExtractUserMessage(const Request& request) noexcept {
     }
 }
 
+//! Metrics of connections.
+struct ConnectionMetrics {
+    metrics::Gauge& connections;
+    metrics::Counter& received_bytes;
+    metrics::Counter& sent_bytes;
+};
+
+ConnectionMetrics& Metrics() noexcept {
+    static ConnectionMetrics metrics {
+        .connections = metrics::DefaultRegistry().AddGauge(
+            "ws_http_connections", "The number of open connections"),
+        .received_bytes = metrics::DefaultRegistry().AddCounter(
+            "ws_http_received_bytes_total",
+            "The number of bytes received from clients"),
+        .sent_bytes = metrics::DefaultRegistry().AddCounter(
+            "ws_http_sent_bytes_total", "The number of bytes sent to clients")};
+    return metrics;
+}
+
+//! Get the registry of uncached file contents shared by all connections.
+FileRegistry& Files() noexcept {
+    static FileRegistry files;
+    return files;
+}
+
+//! Count a response by its status code.
+void CountResponse(const StatusCode code) noexcept {
+    metrics::CachedCounter("ws_http_responses_total",
+                           "The number of responses by status code", "code",
+                           StatusCodeToInteger(code))
+        .Increase();
+}
+
 }  // namespace
 
 std::string_view ContentTypeByFileName(const std::string_view name) noexcept {
-    static const std::unordered_map<std::string_view, std::string_view> types {
+    static constexpr auto types {MakePerfectHashMap<std::string_view>({
         {".html", "text/html"},
         {".xml", "text/xml"},
         {".xhtml", "application/xhtml+xml"},
         {".txt", "text/plain"},
+        {".json", "application/json"},
         {".rtf", "application/rtf"},
         {".pdf", "application/pdf"},
         {".word", "application/nsword"},
@@ -49,22 +99,48 @@ std::string_view ContentTypeByFileName(const std::string_view name) noexcept {
         {".tar", "application/x-tar"},
         {".css", "text/css"},
         {".js", "text/javascript"},
-    };
+    })};
+
+    static constexpr std::string_view default_type {"application/octet-stream"};
 
-    const auto extension {
-        StringToLower(std::filesystem::path {name}.extension())};
-    return types.contains(extension.c_str()) ? types.at(extension.c_str())
-                                             : "application/octet-stream";
+    // Find the extension in the same way as `std::filesystem::path::extension` without allocating a path.
+    const auto file_name {name.substr(name.rfind('/') + 1)};
+    const auto dot {file_name.rfind('.')};
+    if (dot == std::string_view::npos || dot == 0 || file_name == "..") {
+        return default_type;
+    }
+
+    return types.Find(file_name.substr(dot)).value_or(default_type);
 }
 
 std::string_view StatusCodeToMessage(const StatusCode code) noexcept {
-    static const std::unordered_map<StatusCode, std::string_view> msgs {
-        {StatusCode::OK, "OK"},
-        {StatusCode::BadRequest, "Bad Request"},
-        {StatusCode::Forbidden, "Forbidden"},
-        {StatusCode::NotFound, "Not Found"}};
-
-    return msgs.at(code);
+    switch (code) {
+        case StatusCode::OK:
+            return "OK";
+        case StatusCode::PartialContent:
+            return "Partial Content";
+        case StatusCode::NotModified:
+            return "Not Modified";
+        case StatusCode::BadRequest:
+            return "Bad Request";
+        case StatusCode::Forbidden:
+            return "Forbidden";
+        case StatusCode::NotFound:
+            return "Not Found";
+        case StatusCode::PayloadTooLarge:
+            return "Payload Too Large";
+        case StatusCode::RangeNotSatisfiable:
+            return "Range Not Satisfiable";
+        case StatusCode::RequestHeaderFieldsTooLarge:
+            return "Request Header Fields Too Large";
+        case StatusCode::BadGateway:
+            return "Bad Gateway";
+        case StatusCode::ServiceUnavailable:
+            return "Service Unavailable";
+        default:
+            assert(false);
+            return {};
+    }
 }
 
 std::ostream& operator<<(std::ostream& os, const StatusCode code) noexcept {
@@ -76,31 +152,38 @@ std::uint32_t StatusCodeToInteger(const StatusCode code) noexcept {
 }
 
 std::string_view MethodToString(const Method method) noexcept {
-    static const std::unordered_map<Method, std::string_view> methods {
-        {Method::Get, "GET"},
-        {Method::Patch, "PATCH"},
-        {Method::Post, "POST"},
-        {Method::Delete, "DELETE"},
-        {Method::Put, "PUT"}};
-
-    return methods.at(method);
+    switch (method) {
+        case Method::Get:
+            return "GET";
+        case Method::Post:
+            return "POST";
+        case Method::Put:
+            return "PUT";
+        case Method::Patch:
+            return "PATCH";
+        case Method::Delete:
+            return "DELETE";
+        default:
+            assert(false);
+            return {};
+    }
 }
 
 std::string to_string(const Method method) noexcept {
     return MethodToString(method).data();
 }
 
-Method StringToMethod(std::string str) {
-    static const std::unordered_map<std::string_view, Method> methods {
+Method StringToMethod(const std::string_view str) {
+    static constexpr auto methods {MakePerfectHashMap<Method>({
         {"GET", Method::Get},
         {"PATCH", Method::Patch},
         {"POST", Method::Post},
         {"DELETE", Method::Delete},
-        {"PUT", Method::Put}};
+        {"PUT", Method::Put},
+    })};
 
-    str = StringToUpper(str);
-    if (const auto method {methods.find(str)}; method != methods.cend()) {
-        return method->second;
+    if (const auto method {methods.Find(str)}; method.has_value()) {
+        return method.value();
     } else {
         throw std::invalid_argument {
             fmt::format("Invalid HTTP method: '{}'", str)};
@@ -111,37 +194,330 @@ std::ostream& operator<<(std::ostream& os, const Method method) noexcept {
     return os << MethodToString(method);
 }
 
-char DecodeURLEncodedCharacter(const std::string& str) {
-    static constexpr std::size_t encoded_length {3};
-    if (str.length() == encoded_length && str.front() == '%') {
-        const auto ascii {std::stoi(str.substr(1), nullptr, 16)};
-        return static_cast<char>(ascii);
+std::string_view ContentEncodingToString(
+    const ContentEncoding encoding) noexcept {
+    switch (encoding) {
+        case ContentEncoding::Identity:
+            return "identity";
+        case ContentEncoding::Gzip:
+            return "gzip";
+        case ContentEncoding::Brotli:
+            return "br";
+        default:
+            assert(false);
+            return {};
+    }
+}
+
+std::string_view ContentEncodingToExtension(
+    const ContentEncoding encoding) noexcept {
+    switch (encoding) {
+        case ContentEncoding::Identity:
+            return "";
+        case ContentEncoding::Gzip:
+            return ".gz";
+        case ContentEncoding::Brotli:
+            return ".br";
+        default:
+            assert(false);
+            return {};
+    }
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         const ContentEncoding encoding) noexcept {
+    return os << ContentEncodingToString(encoding);
+}
+
+ContentEncodings ParseAcceptEncoding(std::string_view value) noexcept {
+    static constexpr auto encodings {MakePerfectHashMap<ContentEncoding>({
+        {"gzip", ContentEncoding::Gzip},
+        {"x-gzip", ContentEncoding::Gzip},
+        {"br", ContentEncoding::Brotli},
+    })};
+
+    ContentEncodings accepted;
+    ContentEncodings rejected;
+    bool wildcard {false};
+    while (!value.empty()) {
+        const auto comma {std::min(value.find(','), value.size())};
+        auto item {value.substr(0, comma)};
+        value.remove_prefix(std::min(comma + 1, value.size()));
+
+        // An item is like "gzip;q=0.8".
+        const auto semicolon {std::min(item.find(';'), item.size())};
+        const auto name {TrimWhitespace(item.substr(0, semicolon))};
+        auto param {item.substr(std::min(semicolon + 1, item.size()))};
+        param = TrimWhitespace(param.substr(0, param.find(';')));
+
+        bool zero_quality {false};
+        if (param.starts_with("q=") || param.starts_with("Q=")) {
+            param.remove_prefix(2);
+            zero_quality = !param.empty()
+                           && param.find_first_not_of("0.")
+                                  == std::string_view::npos;
+        }
+
+        if (name == "*") {
+            wildcard = !zero_quality;
+        } else if (const auto encoding {encodings.Find(name)};
+                   encoding.has_value()) {
+            (zero_quality ? rejected : accepted).Add(encoding.value());
+        }
+    }
+
+    if (wildcard) {
+        for (const auto encoding : ContentEncodings::preferences) {
+            if (!rejected.Contains(encoding)) {
+                accepted.Add(encoding);
+            }
+        }
+    }
+
+    return accepted;
+}
+
+std::string MakeEntityTag(
+    const std::uint64_t inode, const std::size_t size,
+    const std::chrono::system_clock::time_point modification_time,
+    const ContentEncoding encoding) noexcept {
+    const auto time {std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         modification_time.time_since_epoch())
+                         .count()};
+    if (encoding == ContentEncoding::Identity) {
+        return fmt::format("\"{:x}-{:x}-{:x}\"", inode, size, time);
     } else {
-        throw std::invalid_argument {
-            fmt::format("Invalid HTTP URL-encoding character: '{}'", str)};
+        return fmt::format("\"{:x}-{:x}-{:x}-{}\"", inode, size, time,
+                           ContentEncodingToString(encoding));
     }
 }
 
-std::string DecodeURLEncodedString(const std::string& str) {
-    static constexpr std::size_t encoded_length {3};
-    std::ostringstream ss;
-    std::size_t i {0};
-    while (i < str.size()) {
-        if (str[i] == '%') {
-            if (const auto encoded {str.substr(i, encoded_length)};
-                encoded.length() == encoded_length) {
-                ss << DecodeURLEncodedCharacter(encoded);
-                i += encoded_length;
+std::string FormatHTTPDate(
+    const std::chrono::system_clock::time_point time) noexcept {
+    const auto seconds {std::chrono::system_clock::to_time_t(time)};
+    std::tm utc {};
+    gmtime_r(&seconds, &utc);
+
+    std::array<char, 0x40> date {};
+    const auto size {std::strftime(date.data(), date.size(),
+                                   "%a, %d %b %Y %H:%M:%S GMT", &utc)};
+    return {date.data(), size};
+}
+
+std::optional<std::chrono::system_clock::time_point> ParseHTTPDate(
+    const std::string_view date) noexcept {
+    static constexpr std::array formats {
+        // The preferred format, such as "Sun, 06 Nov 1994 08:49:37 GMT".
+        "%a, %d %b %Y %H:%M:%S GMT",
+        // The RFC 850 format, such as "Sunday, 06-Nov-94 08:49:37 GMT".
+        "%A, %d-%b-%y %H:%M:%S GMT",
+        // The ANSI C format, such as "Sun Nov  6 08:49:37 1994".
+        "%a %b %e %H:%M:%S %Y"};
+
+    const std::string str {date};
+    for (const auto format : formats) {
+        std::tm utc {};
+        if (const auto end {strptime(str.c_str(), format, &utc)};
+            end && *end == '\0') {
+            return std::chrono::system_clock::from_time_t(timegm(&utc));
+        }
+    }
+
+    return std::nullopt;
+}
+
+bool Preconditions::Empty() const noexcept {
+    return !if_none_match.has_value() && !if_modified_since.has_value()
+           && !if_range.has_value();
+}
+
+bool Preconditions::NotModified(const Validators& validators) const noexcept {
+    if (if_none_match.has_value()) {
+        auto tags {if_none_match.value()};
+        while (!tags.empty()) {
+            const auto comma {std::min(tags.find(','), tags.size())};
+            auto tag {TrimWhitespace(tags.substr(0, comma))};
+            tags.remove_prefix(std::min(comma + 1, tags.size()));
+
+            // The weak comparison ignores the weakness indicator.
+            if (tag.starts_with("W/")) {
+                tag.remove_prefix(2);
+            }
+
+            if (tag == "*" || tag == validators.etag) {
+                return true;
+            }
+        }
+
+        return false;
+    } else if (if_modified_since.has_value()) {
+        // HTTP dates only have a resolution of seconds.
+        const auto last_modified {std::chrono::floor<std::chrono::seconds>(
+            validators.last_modified)};
+        return last_modified <= if_modified_since.value();
+    } else {
+        return false;
+    }
+}
+
+bool Preconditions::RangeApplies(const Validators& validators) const noexcept {
+    if (!if_range.has_value()) {
+        return true;
+    }
+
+    const auto condition {TrimWhitespace(if_range.value())};
+    if (condition.starts_with('"')) {
+        return condition == validators.etag;
+    } else if (condition.starts_with("W/")) {
+        // A weak entity tag never matches in a strong comparison.
+        return false;
+    } else if (const auto date {ParseHTTPDate(condition)}; date.has_value()) {
+        return std::chrono::floor<std::chrono::seconds>(
+                   validators.last_modified)
+               == date.value();
+    } else {
+        return false;
+    }
+}
+
+std::optional<ByteRange> RangeSpec::Resolve(
+    const std::size_t size) const noexcept {
+    if (size == 0) {
+        return std::nullopt;
+    }
+
+    if (!first.has_value()) {
+        // A suffix range such as "-500" means the last 500 bytes.
+        assert(last.has_value());
+        if (last.value() == 0) {
+            return std::nullopt;
+        }
+
+        return ByteRange {.first = size - std::min(last.value(), size),
+                          .last = size - 1};
+    } else if (first.value() < size) {
+        return ByteRange {.first = first.value(),
+                          .last = std::min(last.value_or(size - 1), size - 1)};
+    } else {
+        return std::nullopt;
+    }
+}
+
+std::optional<std::vector<RangeSpec>> ParseRange(
+    std::string_view value) noexcept {
+    static constexpr std::string_view unit {"bytes="};
+
+    const auto parse_position {
+        [](const std::string_view str) noexcept -> std::optional<std::size_t> {
+            std::size_t position {0};
+            if (const auto [end, error] {std::from_chars(
+                    str.data(), str.data() + str.size(), position)};
+                !str.empty() && error == std::errc {}
+                && end == str.data() + str.size()) {
+                return position;
             } else {
-                throw std::invalid_argument {fmt::format(
-                    "Invalid HTTP URL-encoding strings: '{}'", str)};
+                return std::nullopt;
+            }
+        }};
+
+    value = TrimWhitespace(value);
+    if (value.size() < unit.size()
+        || !EqualsIgnoreCase(value.substr(0, unit.size()), unit)) {
+        return std::nullopt;
+    }
+
+    value.remove_prefix(unit.size());
+    std::vector<RangeSpec> ranges;
+    while (!value.empty()) {
+        const auto comma {std::min(value.find(','), value.size())};
+        const auto item {TrimWhitespace(value.substr(0, comma))};
+        value.remove_prefix(std::min(comma + 1, value.size()));
+        if (item.empty()) {
+            continue;
+        }
+
+        const auto hyphen {item.find('-')};
+        if (hyphen == std::string_view::npos
+            || ranges.size() == max_range_count) {
+            return std::nullopt;
+        }
+
+        RangeSpec range;
+        if (hyphen == 0) {
+            // A suffix range such as "-500".
+            range.last = parse_position(item.substr(1));
+            if (!range.last.has_value()) {
+                return std::nullopt;
             }
         } else {
-            ss << str[i++];
+            range.first = parse_position(item.substr(0, hyphen));
+            if (!range.first.has_value()) {
+                return std::nullopt;
+            }
+
+            // An open range such as "100-" has no last position.
+            if (const auto last {item.substr(hyphen + 1)}; !last.empty()) {
+                range.last = parse_position(last);
+                if (!range.last.has_value()
+                    || range.last.value() < range.first.value()) {
+                    return std::nullopt;
+                }
+            }
         }
+
+        ranges.push_back(range);
     }
 
-    return ss.str();
+    return ranges.empty() ? std::nullopt : std::optional {std::move(ranges)};
+}
+
+std::vector<ByteRange> ResolveRanges(const std::vector<RangeSpec>& ranges,
+                                     const std::size_t size) noexcept {
+    std::vector<ByteRange> resolved;
+    for (const auto& range : ranges) {
+        if (const auto bytes {range.Resolve(size)}; bytes.has_value()) {
+            resolved.push_back(bytes.value());
+        }
+    }
+
+    std::ranges::sort(resolved, {}, &ByteRange::first);
+
+    // Coalesce overlapping and adjacent ranges,
+    // so a client cannot make the server send the same bytes repeatedly.
+    std::vector<ByteRange> coalesced;
+    for (const auto& range : resolved) {
+        if (!coalesced.empty() && range.first <= coalesced.back().last + 1) {
+            coalesced.back().last = std::max(coalesced.back().last, range.last);
+        } else {
+            coalesced.push_back(range);
+        }
+    }
+
+    return coalesced;
+}
+
+bool IsCompressibleContentType(const std::string_view type) noexcept {
+    return type.starts_with("text/") || type.ends_with("+xml")
+           || type == "application/rtf" || type == "application/javascript"
+           || type == "application/json";
+}
+
+char DecodeURLEncodedCharacter(const std::string& str) {
+    static constexpr std::size_t encoded_length {3};
+    if (str.length() == encoded_length && str.front() == '%') {
+        if (const auto c {DecodeHexPair(str[1], str[2])}; c.has_value()) {
+            return c.value();
+        }
+    }
+
+    throw std::invalid_argument {
+        fmt::format("Invalid HTTP URL-encoding character: '{}'", str)};
+}
+
+std::string DecodeURLEncodedString(const std::string& str) {
+    auto decoded {str};
+    decoded.resize(DecodeURLEncodedInPlace(decoded));
+    return decoded;
 }
 
 std::string HTMLPlaceholder(const std::string_view key) noexcept {
@@ -166,19 +542,182 @@ std::filesystem::path ConnectionImpl::GetRootDirectory() noexcept {
     return root_dir_;
 }
 
+std::unique_ptr<AssetCache> ConnectionImpl::asset_cache_;
+
+void ConnectionImpl::SetAssetCache(
+    const std::size_t capacity,
+    const std::chrono::steady_clock::duration revalidation_interval,
+    const bool compression) noexcept {
+    asset_cache_ = capacity > 0 ? std::make_unique<AssetCache>(
+                                      capacity, revalidation_interval,
+                                      compression)
+                                : nullptr;
+}
+
+std::unique_ptr<AssetPack> ConnectionImpl::asset_pack_;
+
+void ConnectionImpl::SetAssetPack(const std::filesystem::path& pack) {
+    asset_pack_ = pack.empty() ? nullptr : std::make_unique<AssetPack>(pack);
+}
+
+std::size_t ConnectionImpl::high_water_mark_ {default_high_water_mark};
+
+void ConnectionImpl::SetHighWaterMark(const std::size_t size) noexcept {
+    high_water_mark_ = size > 0 ? size : default_high_water_mark;
+}
+
+std::size_t ConnectionImpl::GetHighWaterMark() noexcept {
+    return high_water_mark_;
+}
+
+std::size_t ConnectionImpl::max_requests_ {0};
+
+void ConnectionImpl::SetMaxRequestsPerConnection(
+    const std::size_t count) noexcept {
+    max_requests_ = count;
+}
+
+std::size_t ConnectionImpl::GetMaxRequestsPerConnection() noexcept {
+    return max_requests_;
+}
+
+void ConnectionImpl::SetKeepAliveTimeout(
+    const std::chrono::seconds timeout) noexcept {
+    Response::SetKeepAliveTimeout(timeout);
+    if (asset_pack_) {
+        // Packed assets keep headers serialized with the previous timeout.
+        asset_pack_->BuildHeaders();
+    }
+}
+
+std::size_t ConnectionImpl::max_buffer_size_ {0};
+
+void ConnectionImpl::SetMaxBufferSize(const std::size_t size) noexcept {
+    max_buffer_size_ = size;
+}
+
+std::size_t ConnectionImpl::GetMaxBufferSize() noexcept {
+    return max_buffer_size_;
+}
+
+RequestLimits ConnectionImpl::request_limits_;
+
+void ConnectionImpl::SetRequestLimits(const RequestLimits limits) noexcept {
+    request_limits_ = limits;
+}
+
+RequestLimits ConnectionImpl::GetRequestLimits() noexcept {
+    return request_limits_;
+}
+
+std::unique_ptr<TLSContext> ConnectionImpl::tls_context_;
+
+void ConnectionImpl::SetTLSCertificate(
+    const std::filesystem::path& cert_chain,
+    const std::filesystem::path& private_key) {
+    tls_context_ = std::make_unique<TLSContext>(cert_chain, private_key);
+}
+
+void ConnectionImpl::DisableTLS() noexcept {
+    tls_context_.reset();
+}
+
+bool ConnectionImpl::TLSEnabled() noexcept {
+    return tls_context_ != nullptr;
+}
+
+RoutingTable ConnectionImpl::routes_;
+
+void ConnectionImpl::SetRoutes(RoutingTable routes) noexcept {
+    routes_ = std::move(routes);
+}
+
+const RoutingTable& ConnectionImpl::GetRoutes() noexcept {
+    return routes_;
+}
+
+bool ConnectionImpl::disk_offload_ {false};
+
+void ConnectionImpl::SetDiskOffload(const bool enable) noexcept {
+    disk_offload_ = enable;
+}
+
+bool ConnectionImpl::GetDiskOffload() noexcept {
+    return disk_offload_;
+}
+
+std::string ConnectionImpl::metrics_path_ {default_metrics_path};
+
+void ConnectionImpl::SetMetricsPath(std::string path) noexcept {
+    metrics_path_ = std::move(path);
+}
+
+std::string ConnectionImpl::GetMetricsPath() noexcept {
+    return metrics_path_;
+}
+
+std::string ConnectionImpl::trace_path_ {default_trace_path};
+
+void ConnectionImpl::SetTracePath(std::string path) noexcept {
+    trace_path_ = std::move(path);
+}
+
+std::string ConnectionImpl::GetTracePath() noexcept {
+    return trace_path_;
+}
+
 ConnectionImpl::ConnectionImpl(const FileDescriptor socket) noexcept :
-    socket_ {socket} {
+    socket_ {socket}, request_ {std::make_unique<Request>()} {
     assert(IsValidFileDescriptor(socket_));
+    Metrics().connections.Increase();
 }
 
 ConnectionImpl::~ConnectionImpl() noexcept {
     Close();
 }
 
+void ConnectionImpl::Reset(const FileDescriptor socket) noexcept {
+    assert(IsValidFileDescriptor(socket));
+    Close();
+    socket_ = socket;
+    keep_alive_ = false;
+    request_count_ = 0;
+    drained_ = false;
+    Metrics().connections.Increase();
+
+    read_buf_.Reset(max_reused_buffer_size);
+    write_buf_.Reset(max_reused_buffer_size);
+    asset_.reset();
+    asset_offset_ = 0;
+    file_ = {};
+    file_offset_ = 0;
+    parts_.clear();
+    next_part_ = 0;
+    content_end_ = 0;
+
+    // The pipe may still contain data of an unfinished response.
+    splice_pipe_.reset();
+    request_->Clear();
+    pending_responses_ = {};
+    pending_size_ = 0;
+    http2_.reset();
+    protocol_detected_ = false;
+    proxy_upstream_.reset();
+    proxy_request_.RetrieveAll();
+    disk_pending_ = false;
+    WS_TRACE_CLEAR(trace_);
+}
+
 void ConnectionImpl::Close() noexcept {
+    if (tls_) {
+        tls_->Shutdown();
+        tls_.reset();
+    }
+
     if (IsValidFileDescriptor(socket_)) {
         close(socket_);
         socket_ = invalid_file_descriptor;
+        Metrics().connections.Decrease();
     }
 }
 
@@ -187,7 +726,12 @@ FileDescriptor ConnectionImpl::Socket() const noexcept {
 }
 
 bool ConnectionImpl::KeepAlive() const noexcept {
-    return keep_alive_;
+    if (tls_ && !tls_->Established()) {
+        // No request has been received before the handshake finishes.
+        return true;
+    }
+
+    return http2_ ? !http2_->Closed() : keep_alive_;
 }
 
 bool ConnectionImpl::Valid() const noexcept {
@@ -195,89 +739,725 @@ bool ConnectionImpl::Valid() const noexcept {
 }
 
 std::size_t ConnectionImpl::Receive() {
-    io::FileDescriptor io {socket_, socket_};
+    WS_TRACE_SCOPE(trace_, trace::Stage::Receive);
+    io::FileDescriptor socket_io {socket_, socket_};
     std::size_t size {0};
+    drained_ = false;
 
     try {
-        while (true) {
-            size += read_buf_.ReadFrom(io);
+        if (tls_context_ && !tls_) {
+            tls_ = std::make_unique<TLSSession>(*tls_context_, socket_);
         }
+
+        if (tls_ && !tls_->Handshake()) {
+            // Wait for the rest of the handshake.
+            drained_ = true;
+            return 0;
+        }
+
+        // Data is read from the socket directly if there is no TLS or it is decrypted by the kernel.
+        io::IReadWriter& io {tls_ && !tls_->KernelReceive()
+                                 ? static_cast<io::IReadWriter&>(*tls_)
+                                 : socket_io};
+
+        // The rest of the data stays in the socket until buffered requests have been processed.
+        // But decrypted data buffered in the TLS session must be read, as it will not trigger a receive event.
+        do {
+            if (const auto read {read_buf_.ReadFrom(io)}; read > 0) {
+                size += read;
+            } else {
+                // The client has shut down its writing side.
+                drained_ = true;
+                break;
+            }
+        } while (read_buf_.ReadableSize() < high_water_mark_
+                 || (tls_ && tls_->Pending() > 0));
     } catch (const std::system_error& err) {
         if (err.code() != std::errc::resource_unavailable_try_again) {
             throw;
         }
+
+        drained_ = true;
     }
 
+    Metrics().received_bytes.Increase(size);
     return size;
 }
 
+bool ConnectionImpl::Drained() const noexcept {
+    return drained_;
+}
+
+bool ConnectionImpl::HasReceivedData() const noexcept {
+    return read_buf_.ReadableSize() > 0;
+}
+
 std::size_t ConnectionImpl::Send() {
+    std::size_t size {0};
+    {
+        WS_TRACE_SCOPE(trace_, trace::Stage::Send);
+        size = SendResponses();
+    }
+
+    if constexpr (trace::enabled) {
+        if (ToSendSize() == 0) {
+            WS_TRACE_FINISH(trace_);
+        }
+    }
+
+    Metrics().sent_bytes.Increase(size);
+    return size;
+}
+
+std::size_t ConnectionImpl::SendResponses() {
     io::FileDescriptor io {socket_, socket_};
-    std::size_t header_size {0};
-    while (!write_buf_.Empty()) {
-        header_size += write_buf_.WriteTo(io);
+    std::size_t size {0};
+
+    // HTTP/2 frames are produced in batches, so the write buffer keeps its reusable size.
+    const auto http2_limit {std::min(high_water_mark_, max_reused_buffer_size)};
+
+    try {
+        if (tls_ && !tls_->Handshake()) {
+            // The handshake was waiting for the socket to be writable.
+            return 0;
+        }
+
+        do {
+            do {
+                while (!write_buf_.Empty()
+                       || (asset_ && asset_offset_ < content_end_)) {
+                    size += SendMemory(io);
+                }
+
+                // The pipe must be drained before the prefix of the next part is written.
+                while ((file_.Valid() && file_offset_ < content_end_)
+                       || (splice_pipe_ && splice_pipe_->PendingSize() > 0)) {
+                    size += SendFile();
+                }
+            } while (NextPart());
+        } while (http2_ ? http2_->Produce(write_buf_, http2_limit)
+                        : NextResponse());
+    } catch (const std::system_error& err) {
+        // The socket buffer is full, sending will be resumed by the next send event.
+        if (err.code() != std::errc::resource_unavailable_try_again) {
+            throw;
+        }
     }
 
-    std::size_t file_size {0};
-    while (file_size < file_.Size()) {
-        if (const auto size {write(socket_, file_.Data() + file_size,
-                                   file_.Size() - file_size)};
-            size >= 0) {
-            file_size += size;
-        } else {
+    return size;
+}
+
+std::size_t ConnectionImpl::SendFile() {
+    assert(file_.Valid());
+    assert(file_offset_ <= content_end_ && content_end_ <= file_.Size());
+
+    const auto remaining {content_end_ - file_offset_};
+    if (tls_ && !tls_->KernelSend()) {
+        // Without kTLS, the file is read into user space to be encrypted.
+        // A resumed write reads the same bytes again, as the offset only advances by the sent size.
+        std::array<std::byte, 0x4000> chunk;
+        const auto count {std::min(remaining, chunk.size())};
+        const auto read {
+            pread(file_.Descriptor(), chunk.data(), count, file_offset_)};
+        if (read < 0) {
             ThrowLastSystemError();
+        } else if (read == 0 && count > 0) {
+            throw std::runtime_error {fmt::format(
+                "The file '{}' has been truncated", file_.Path())};
         }
+
+        const auto size {tls_->Write({chunk.data(),
+                                      static_cast<std::size_t>(read)})};
+        file_offset_ += size;
+        return size;
     }
 
-    return header_size + file_size;
+    if (!splice_pipe_) {
+        try {
+            if (const auto size {io::SendFile(socket_, file_.Descriptor(),
+                                              file_offset_, remaining)};
+                size > 0 || remaining == 0) {
+                return size;
+            } else {
+                throw std::runtime_error {fmt::format(
+                    "The file '{}' has been truncated", file_.Path())};
+            }
+        } catch (const std::system_error& err) {
+            // Some file systems do not support `sendfile`, use `splice` instead.
+            if (err.code() != std::errc::invalid_argument
+                && err.code() != std::errc::function_not_supported) {
+                throw;
+            }
+        }
+
+        splice_pipe_ = std::make_unique<io::SplicePipe>();
+    }
+
+    const auto pending {splice_pipe_->PendingSize()};
+    if (const auto size {splice_pipe_->Send(socket_, file_.Descriptor(),
+                                            file_offset_, remaining)};
+        size > 0 || pending + remaining == 0) {
+        return size;
+    } else {
+        throw std::runtime_error {
+            fmt::format("The file '{}' has been truncated", file_.Path())};
+    }
 }
 
-bool ConnectionImpl::Process() noexcept {
-    static constexpr std::string_view index_page {"/index.html"};
-    static constexpr std::string_view hide_msg_tag {"hide-msg"};
+std::size_t ConnectionImpl::SendMemory(io::FileDescriptor& io) {
+    std::span<const std::byte> content;
+    if (asset_) {
+        assert(asset_offset_ <= content_end_
+               && content_end_ <= asset_->Content().size());
+        content = asset_->Content().subspan(asset_offset_,
+                                            content_end_ - asset_offset_);
+    }
 
-    file_.Unmap();
-    if (read_buf_.ReadableSize() == 0) {
-        return false;
+    if (tls_ && !tls_->KernelSend()) {
+        // Without kTLS, the header and the content are encrypted separately.
+        if (!write_buf_.Empty()) {
+            return write_buf_.WriteTo(*tls_);
+        }
+
+        const auto size {tls_->Write(content)};
+        asset_offset_ += size;
+        return size;
     }
 
-    Request request;
-    Response response {root_dir_};
-    std::optional<std::string> error_msg;
+    const std::array segments {write_buf_.ReadableBytes(), content};
+    const auto size {io.Write(segments, MoreAfterMemory())};
 
-    try {
-        request.Parse(read_buf_);
-    } catch (const std::exception& err) {
-        error_msg = err.what();
+    // The response header is written before the content.
+    const auto header_size {std::min(size, write_buf_.ReadableSize())};
+    write_buf_.Retrieve(header_size);
+    asset_offset_ += size - header_size;
+    return size;
+}
+
+bool ConnectionImpl::MoreAfterMemory() const noexcept {
+    // HTTP/2 frames are produced in batches, whose end is unknown here.
+    return !http2_
+           && ((file_.Valid() && file_offset_ < content_end_)
+               || next_part_ < parts_.size() || !pending_responses_.empty());
+}
+
+std::optional<StatusCode> ConnectionImpl::BuildFromCache(
+    const std::filesystem::path& path, const ContentEncodings encodings,
+    const Preconditions& preconditions,
+    const std::optional<std::vector<RangeSpec>>& ranges, Buffer& header,
+    std::shared_ptr<const Asset>& asset, std::vector<BodyPart>& parts) {
+    if (asset_pack_) {
+        if (auto packed {asset_pack_->Find(path.native())}; packed) {
+            return BuildFromAsset(path, std::move(packed), encodings,
+                                  preconditions, ranges, header, asset, parts);
+        }
     }
 
-    keep_alive_ = request.KeepAlive();
-    response.SetKeepAlive(keep_alive_);
-    if (!error_msg.has_value()) {
-        std::string path {request.Path()};
-        if (path.empty() || path == "/") {
-            path = index_page;
+    if (!asset_cache_) {
+        return std::nullopt;
+    }
+
+    const auto full_path {Response::FullPath(root_dir_, path)};
+    auto cached {asset_cache_->Find(full_path)};
+    if (!cached) {
+        try {
+            // Load the original file even if the client accepts encoded content,
+            // so its precompressed siblings are cached together.
+            ReadOnlyFile opened;
+            opened.Open(full_path);
+            cached = asset_cache_->Insert(full_path, opened);
+        } catch (const std::exception&) {
+            // The response will report the error.
+            return std::nullopt;
+        }
+
+        if (!cached) {
+            // The file is too large to be cached.
+            return std::nullopt;
         }
+    }
+
+    return BuildFromAsset(path, std::move(cached), encodings, preconditions,
+                          ranges, header, asset, parts);
+}
+
+StatusCode ConnectionImpl::BuildFromAsset(
+    const std::filesystem::path& path, std::shared_ptr<const Asset> cached,
+    const ContentEncodings encodings, const Preconditions& preconditions,
+    const std::optional<std::vector<RangeSpec>>& ranges, Buffer& header,
+    std::shared_ptr<const Asset>& asset, std::vector<BodyPart>& parts) {
+    if (auto variant {cached->Variant(encodings)}; variant) {
+        cached = std::move(variant);
+    }
+
+    const auto validators {cached->GetValidators()};
+    if (preconditions.NotModified(validators)) {
+        header.Append(cached->Header(keep_alive_, true));
+        return StatusCode::NotModified;
+    } else if (ranges.has_value()) {
+        // Partial responses cannot use the pre-serialized header.
+        Response response {root_dir_};
+        response.SetKeepAlive(keep_alive_)
+            .SetContentType(std::string {cached->content_type})
+            .SetPreconditions(preconditions)
+            .SetRanges(ranges);
+        response.Build(header, path, cached->Content().size(),
+                       cached->encoding, &validators);
+        if (response.Status() != StatusCode::RangeNotSatisfiable) {
+            parts = response.Parts();
+            asset = std::move(cached);
+        }
+
+        return response.Status();
+    } else {
+        header.Append(cached->Header(keep_alive_));
+        asset = std::move(cached);
+        return StatusCode::OK;
+    }
+}
+
+void ConnectionImpl::KeepFile(ReadOnlyFile opened, const bool user_space,
+                              std::shared_ptr<const Asset>& asset,
+                              ReadOnlyFile& file) noexcept {
+    try {
+        if (const auto size {opened.Size()};
+            size <= max_gathered_file_size
+            || (user_space && size <= max_mapped_file_size)) {
+            // Connections sending the same file at the same time share its content.
+            asset = Files().Acquire(opened);
+            return;
+        }
+    } catch (const std::exception&) {
+        // Fall back to `sendfile` if the file cannot be read.
+    }
+
+    file = std::move(opened);
+}
+
+bool ConnectionImpl::NextResponse() noexcept {
+    assert(ToSendSize() == 0);
+    if (pending_responses_.empty()) {
+        return false;
+    }
 
-        StatusCode status_code {StatusCode::OK};
-        if (path == index_page) {
-            auto params {ExtractUserMessage(request).value_or(Parameters {})};
-            params.insert({hide_msg_tag.data(), params.empty()
-                                                    ? true_tag.data()
-                                                    : false_tag.data()});
-            response.Build(write_buf_, index_page, params, status_code);
+    auto& response {pending_responses_.front()};
+    assert(pending_size_ >= BufferedSize(response));
+    pending_size_ -= BufferedSize(response);
+    write_buf_.Append(response.header);
+    asset_ = std::move(response.asset);
+    file_ = std::move(response.file);
+    parts_ = std::move(response.parts);
+    pending_responses_.pop();
+    StartContent();
+    return true;
+}
+
+void ConnectionImpl::StartContent() noexcept {
+    asset_offset_ = 0;
+    file_offset_ = 0;
+    next_part_ = 0;
+    if (parts_.empty()) {
+        if (asset_) {
+            content_end_ = asset_->Content().size();
+        } else if (file_.Valid()) {
+            content_end_ = file_.Size();
         } else {
-            if (auto file {
-                    response.Build(write_buf_, std::move(path), status_code)};
-                file.has_value()) {
-                file_ = std::move(file.value());
+            content_end_ = 0;
+        }
+    } else {
+        NextPart();
+    }
+}
+
+bool ConnectionImpl::NextPart() noexcept {
+    if (next_part_ == parts_.size()) {
+        return false;
+    }
+
+    const auto& part {parts_[next_part_++]};
+    write_buf_.Append(part.prefix);
+    asset_offset_ = part.offset;
+    file_offset_ = part.offset;
+    content_end_ = part.offset + part.length;
+    return true;
+}
+
+std::size_t ConnectionImpl::ToSendSize() const noexcept {
+    std::size_t size {write_buf_.ReadableSize()};
+    if (asset_) {
+        size += content_end_ - asset_offset_;
+    }
+
+    if (file_.Valid()) {
+        size += content_end_ - file_offset_;
+    }
+
+    for (auto i {next_part_}; i < parts_.size(); ++i) {
+        size += parts_[i].prefix.size() + parts_[i].length;
+    }
+
+    if (splice_pipe_) {
+        size += splice_pipe_->PendingSize();
+    }
+
+    if (http2_) {
+        size += http2_->SendableSize();
+    }
+
+    if (tls_ && tls_->WantWrite()) {
+        // The size of handshake data is unknown, so a single byte is counted to wait for a send event.
+        ++size;
+    }
+
+    return size;
+}
+
+std::size_t ConnectionImpl::BufferedSize() const noexcept {
+    auto size {write_buf_.ReadableSize() + pending_size_};
+    if (asset_) {
+        size += content_end_ - asset_offset_;
+    }
+
+    return size;
+}
+
+std::size_t ConnectionImpl::BufferedSize(
+    const PendingResponse& response) noexcept {
+    return response.header.ReadableSize()
+           + (response.asset ? response.asset->Content().size() : 0);
+}
+
+bool ConnectionImpl::DetectProtocol() noexcept {
+    const auto bytes {read_buf_.ReadableBytes()};
+    const std::string_view received {reinterpret_cast<const char*>(bytes.data()),
+                                     bytes.size()};
+    const auto& preface {Http2Session::preface};
+    if (received.size() < preface.size() && preface.starts_with(received)) {
+        // Wait for the rest of the preface.
+        return false;
+    }
+
+    protocol_detected_ = true;
+    if (received.starts_with(preface)) {
+        read_buf_.Retrieve(preface.size());
+        http2_ = std::make_unique<Http2Session>(
+            [this](const Request& request,
+                   const std::optional<RequestError>& error, Buffer& header,
+                   std::shared_ptr<const Asset>& asset, ReadOnlyFile& file,
+                   std::vector<BodyPart>& parts) noexcept {
+                BuildResponse(request, error, header, asset, file, parts);
+            });
+    }
+
+    return true;
+}
+
+bool ConnectionImpl::Process() noexcept {
+    if (!protocol_detected_ && !DetectProtocol()) {
+        return ToSendSize() > 0;
+    }
+
+    if (http2_) {
+        http2_->Receive(read_buf_);
+        return ToSendSize() > 0;
+    }
+
+    if (proxy_upstream_.has_value() || disk_pending_) {
+        // Wait for previous responses to be sent before the request is forwarded or built.
+        return ToSendSize() > 0;
+    }
+
+    while (pending_responses_.size() < max_pending_response_count
+           && BufferedSize() < high_water_mark_
+           && read_buf_.ReadableSize() > 0) {
+        std::optional<RequestError> error;
+        std::optional<std::size_t> upstream;
+        try {
+            WS_TRACE_SCOPE(trace_, trace::Stage::Parse);
+            if (!request_->Parse(read_buf_, request_limits_)) {
+                if (max_buffer_size_ > 0
+                    && read_buf_.ReadableSize() > max_buffer_size_) {
+                    static auto& shed {metrics::DefaultRegistry().AddCounter(
+                        "ws_shed_total", "The number of clients shed by reason",
+                        {{"reason", "buffer"}})};
+                    shed.Increase();
+                    return Reject();
+                }
+
+                // Wait for the rest of the request.
+                break;
+            }
+
+            // A forwarded request is kept as it was received.
+            upstream = routes_.Match(request_->Path());
+            if (!upstream.has_value()) {
+                request_->DecodePost();
             }
+        } catch (const RequestTooLarge& err) {
+            error = {.status = err.Status(), .msg = err.what()};
+        } catch (const std::exception& err) {
+            error = {.msg = err.what()};
         }
+
+        // The end of an invalid request is unknown, so the connection cannot be reused.
+        ++request_count_;
+        keep_alive_ = !error.has_value() && request_->KeepAlive()
+                      && (max_requests_ == 0 || request_count_ < max_requests_);
+        if (!error.has_value()) {
+            if (upstream.has_value()) {
+                // The request stays in the reading buffer until it is forwarded.
+                proxy_upstream_ = upstream;
+                break;
+            }
+
+            if (disk_offload_ && !InMemory(*request_)) {
+                // The request stays in the reading buffer until its response is built.
+                disk_pending_ = true;
+                break;
+            }
+        }
+
+        if (!BuildNextResponse(error)) {
+            break;
+        }
+    }
+
+    return ToSendSize() > 0;
+}
+
+bool ConnectionImpl::BuildNextResponse(
+    const std::optional<RequestError>& error) noexcept {
+    if (ToSendSize() == 0) {
+        file_.Close();
+        asset_.reset();
+        parts_.clear();
+        BuildResponse(*request_, error, write_buf_, asset_, file_, parts_);
+        StartContent();
+    } else {
+        PendingResponse response;
+        BuildResponse(*request_, error, response.header, response.asset,
+                      response.file, response.parts);
+        pending_size_ += BufferedSize(response);
+        pending_responses_.push(std::move(response));
+    }
+
+    // The request refers to the buffer until its response has been built.
+    if (keep_alive_) {
+        read_buf_.Retrieve(request_->Size());
+        request_->Clear();
+        return true;
     } else {
-        response.Build(write_buf_, StatusCode::BadRequest, error_msg.value());
+        // Drop the following requests since the connection will be closed.
+        read_buf_.RetrieveAll();
+        request_->Clear();
+        return false;
     }
+}
+
+bool ConnectionImpl::InMemory(const Request& request) const noexcept {
+    const auto path {request.Path()};
+    if ((!metrics_path_.empty() && path == metrics_path_)
+        || (!trace_path_.empty() && path == trace_path_)) {
+        return true;
+    } else if (path.empty() || path == "/" || path == index_page) {
+        // The index page is rendered from a template file.
+        return false;
+    }
+
+    try {
+        return (asset_pack_ && asset_pack_->Find(path))
+               || (asset_cache_
+                   && asset_cache_->Find(Response::FullPath(
+                       root_dir_, std::filesystem::path {path})));
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool ConnectionImpl::DiskPending() const noexcept {
+    return disk_pending_;
+}
+
+void ConnectionImpl::BuildDiskResponse() noexcept {
+    assert(disk_pending_);
+    disk_pending_ = false;
+    BuildNextResponse(std::nullopt);
+}
 
+std::optional<std::size_t> ConnectionImpl::ProxiedUpstream() const noexcept {
+    return proxy_upstream_;
+}
+
+std::span<const std::byte> ConnectionImpl::StartProxy(
+    const std::string_view forwarded_for) {
+    assert(proxy_upstream_.has_value() && ToSendSize() == 0);
+    const auto bytes {read_buf_.ReadableBytes()};
+    proxy_request_.RetrieveAll();
+    ProxyExchange::WriteRequest(
+        {reinterpret_cast<const char*>(bytes.data()), request_->Size()},
+        forwarded_for, proxy_request_);
+
+    if (keep_alive_) {
+        read_buf_.Retrieve(request_->Size());
+    } else {
+        read_buf_.RetrieveAll();
+    }
+
+    request_->Clear();
+    file_.Close();
+    asset_.reset();
+    parts_.clear();
+    StartContent();
+
+    if (proxy_) {
+        proxy_->Clear();
+    } else {
+        proxy_ = std::make_unique<ProxyExchange>();
+    }
+
+    return proxy_request_.ReadableBytes();
+}
+
+bool ConnectionImpl::ForwardProxyResponse(ChunkedBuffer& data,
+                                          const bool closed) {
+    assert(proxy_);
+    return proxy_->Forward(data, write_buf_, keep_alive_, closed);
+}
+
+bool ConnectionImpl::FinishProxy(const bool succeeded) noexcept {
+    assert(proxy_);
+    proxy_upstream_.reset();
+    proxy_request_.RetrieveAll();
+    if (succeeded) {
+        CountResponse(static_cast<StatusCode>(proxy_->Status()));
+        return proxy_->Reusable();
+    }
+
+    if (proxy_->Started()) {
+        keep_alive_ = false;
+    } else {
+        Response response {root_dir_};
+        response.SetKeepAlive(keep_alive_);
+        response.Build(write_buf_, StatusCode::BadGateway,
+                       "The upstream server is unavailable");
+        CountResponse(StatusCode::BadGateway);
+    }
+
+    return false;
+}
+
+bool ConnectionImpl::Reject() noexcept {
+    static constexpr std::string_view response {
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Connection: close\r\n"
+        "Retry-After: 1\r\n"
+        "Content-length: 0\r\n\r\n"};
+
+    keep_alive_ = false;
+    read_buf_.RetrieveAll();
+    request_->Clear();
+
+    const auto plain_text {tls_ ? tls_->Established() : !tls_context_};
+    if (http2_ || !plain_text || ToSendSize() > 0) {
+        return ToSendSize() > 0;
+    }
+
+    write_buf_.Append(response);
+    CountResponse(StatusCode::ServiceUnavailable);
     return true;
 }
 
+void ConnectionImpl::BuildResponse(const Request& request,
+                                   const std::optional<RequestError>& error,
+                                   Buffer& header,
+                                   std::shared_ptr<const Asset>& asset,
+                                   ReadOnlyFile& file,
+                                   std::vector<BodyPart>& parts) noexcept {
+    WS_TRACE_SCOPE(trace_, trace::Stage::Build);
+    WS_TRACE_LABEL(trace_, request.Path());
+    CountResponse(
+        BuildResponseContent(request, error, header, asset, file, parts));
+}
+
+StatusCode ConnectionImpl::BuildResponseContent(
+    const Request& request, const std::optional<RequestError>& error,
+    Buffer& header, std::shared_ptr<const Asset>& asset, ReadOnlyFile& file,
+    std::vector<BodyPart>& parts) noexcept {
+    static constexpr std::string_view hide_msg_tag {"hide-msg"};
+
+    Response response {root_dir_};
+    response.SetKeepAlive(keep_alive_);
+    if (error.has_value()) {
+        response.Build(header, error->status, error->msg);
+        return error->status;
+    }
+
+    if (routes_.Match(request.Path()).has_value()) {
+        // Only HTTP/1.1 requests are forwarded, since an HTTP/2 stream cannot be mapped to an upstream connection.
+        response.Build(header, StatusCode::BadGateway,
+                       "HTTP/2 requests cannot be forwarded");
+        return StatusCode::BadGateway;
+    }
+
+    std::string path {request.Path()};
+    if (path.empty() || path == "/") {
+        path = index_page;
+    }
+
+    if (!metrics_path_.empty() && path == metrics_path_) {
+        // Metrics are aggregated from all shards when they are scraped.
+        static constexpr std::string_view metrics_file {"metrics.txt"};
+        const auto text {metrics::DefaultRegistry().Expose()};
+        response.Build(header, metrics_file, text.size());
+        header.Append(text);
+        return response.Status();
+    }
+
+    if (!trace_path_.empty() && path == trace_path_) {
+        static constexpr std::string_view trace_file {"trace.json"};
+        const auto json {trace::DumpChromeTrace()};
+        response.Build(header, trace_file, json.size());
+        header.Append(json);
+        return response.Status();
+    }
+
+    StatusCode status_code {StatusCode::OK};
+    if (path == index_page) {
+        auto params {ExtractUserMessage(request).value_or(Parameters {})};
+        params.insert({hide_msg_tag.data(),
+                       params.empty() ? true_tag.data() : false_tag.data()});
+        response.Build(header, index_page, params, status_code);
+        return status_code;
+    }
+
+    // Only requests for static files are conditional or partial, since other responses are generated.
+    const auto is_get {request.Method() == Method::Get};
+    const auto encodings {request.AcceptedEncodings()};
+    const auto preconditions {is_get ? request.Preconditions()
+                                     : Preconditions {}};
+    const auto ranges {is_get ? request.Ranges() : std::nullopt};
+    if (const auto cached {BuildFromCache(path, encodings, preconditions,
+                                          ranges, header, asset, parts)};
+        cached.has_value()) {
+        return cached.value();
+    }
+
+    response.SetAcceptedEncodings(encodings)
+        .SetPreconditions(preconditions)
+        .SetRanges(ranges);
+    if (auto opened {response.Build(header, std::move(path), status_code)};
+        opened.has_value()) {
+        parts = response.Parts();
+        KeepFile(std::move(opened.value()), tls_ && !tls_->KernelSend(), asset,
+                 file);
+        if (file.Valid()) {
+            // Start reading a cold file in the background, so `sendfile` is less likely to wait for the disk.
+            file.Prefetch(parts.empty() ? 0 : parts.front().offset,
+                          max_prefetch_size);
+        }
+    }
+
+    return status_code;
+}
+
 }  // namespace ws::http
\ No newline at end of file
@@ -0,0 +1,924 @@
+#include "http2.h"
+#include "asset_cache.h"
+
+#include <fmt/format.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace ws::http {
+
+namespace {
+
+//! Flags of HTTP/2 frames.
+constexpr std::uint8_t end_stream_flag {0x1};
+constexpr std::uint8_t ack_flag {0x1};
+constexpr std::uint8_t end_headers_flag {0x4};
+constexpr std::uint8_t padded_flag {0x8};
+constexpr std::uint8_t priority_flag {0x20};
+
+//! An error that terminates the connection.
+class ConnectionError : public std::runtime_error {
+public:
+    ConnectionError(const Http2Error error, const std::string& msg) noexcept :
+        std::runtime_error {msg}, error_ {error} {}
+
+    Http2Error Error() const noexcept {
+        return error_;
+    }
+
+private:
+    Http2Error error_;
+};
+
+//! An error that makes a request malformed, which resets its stream.
+class MalformedRequest : public std::invalid_argument {
+public:
+    using std::invalid_argument::invalid_argument;
+};
+
+std::uint32_t ReadUInt32(const std::span<const std::uint8_t> bytes) noexcept {
+    assert(bytes.size() >= 4);
+    return (static_cast<std::uint32_t>(bytes[0]) << 24)
+           | (static_cast<std::uint32_t>(bytes[1]) << 16)
+           | (static_cast<std::uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+void AppendUInt32(std::string& out, const std::uint32_t value) noexcept {
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+void AppendSetting(std::string& out, const Setting id,
+                   const std::uint32_t value) noexcept {
+    out.push_back(static_cast<char>(static_cast<std::uint16_t>(id) >> 8));
+    out.push_back(static_cast<char>(static_cast<std::uint16_t>(id)));
+    AppendUInt32(out, value);
+}
+
+/**
+ * @brief Remove the padding of a @p DATA or @p HEADERS frame.
+ *
+ * @exception ConnectionError The padding is longer than the payload.
+ */
+std::span<const std::uint8_t> RemovePadding(
+    const FrameHeader& header, std::span<const std::uint8_t> payload) {
+    if ((header.flags & padded_flag) == 0) {
+        return payload;
+    }
+
+    if (payload.empty() || payload.front() >= payload.size()) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "The padding is too long"};
+    }
+
+    const std::size_t pad_length {payload.front()};
+    return payload.subspan(1, payload.size() - 1 - pad_length);
+}
+
+//! Convert a lowercase HTTP/2 field name to the canonical HTTP/1.1 form, such as @p If-None-Match.
+std::string CanonicalFieldName(const std::string_view name) noexcept {
+    std::string canonical {name};
+    auto word_start {true};
+    for (auto& c : canonical) {
+        if (word_start && c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+
+        word_start = c == '-';
+    }
+
+    return canonical;
+}
+
+/**
+ * @brief Translate a request's header list into an HTTP/1.1 request line and headers.
+ *
+ * @exception MalformedRequest The header list is malformed.
+ */
+std::string TranslateRequest(const hpack::HeaderList& fields) {
+    // Connection-specific fields are not allowed in HTTP/2.
+    static constexpr std::array<std::string_view, 5> connection_fields {
+        "connection", "keep-alive", "proxy-connection", "transfer-encoding",
+        "upgrade"};
+
+    std::optional<std::string_view> method;
+    std::optional<std::string_view> path;
+    std::optional<std::string_view> authority;
+    bool scheme {false};
+    std::string cookie;
+    std::string headers;
+    bool regular_field {false};
+    for (const auto& [name, value] : fields) {
+        // Field values are copied into an HTTP/1.1 request, so line breaks must be rejected.
+        if (value.find_first_of(std::string_view {"\r\n\0", 3})
+            != std::string::npos) {
+            throw MalformedRequest {"A field value contains a line break"};
+        }
+
+        if (name.starts_with(':')) {
+            if (regular_field) {
+                throw MalformedRequest {
+                    "A pseudo-header field follows regular fields"};
+            }
+
+            auto& pseudo {name == ":method"      ? method
+                          : name == ":path"      ? path
+                          : name == ":authority" ? authority
+                                                 : path};
+            if (name == ":scheme") {
+                if (scheme) {
+                    throw MalformedRequest {
+                        "A pseudo-header field is duplicated"};
+                }
+
+                scheme = true;
+            } else if (name != ":method" && name != ":path"
+                       && name != ":authority") {
+                throw MalformedRequest {
+                    fmt::format("Unknown pseudo-header field: '{}'", name)};
+            } else if (pseudo.has_value()) {
+                throw MalformedRequest {"A pseudo-header field is duplicated"};
+            } else {
+                pseudo = value;
+            }
+
+            continue;
+        }
+
+        regular_field = true;
+        if (name.empty()
+            || std::ranges::any_of(name, [](const char c) noexcept {
+                   return (c >= 'A' && c <= 'Z') || c == ':' || c == ' '
+                          || c == '\r' || c == '\n';
+               })) {
+            throw MalformedRequest {fmt::format("Invalid field name: '{}'", name)};
+        } else if (std::ranges::find(connection_fields, name)
+                   != connection_fields.cend()) {
+            throw MalformedRequest {
+                fmt::format("Connection-specific field: '{}'", name)};
+        } else if (name == "te" && value != "trailers") {
+            throw MalformedRequest {"The 'te' field is not 'trailers'"};
+        } else if (name == "content-length") {
+            // The length is set after the body has been received.
+            continue;
+        } else if (name == "cookie") {
+            // Cookies may be split into several fields.
+            cookie += cookie.empty() ? value : "; " + value;
+            continue;
+        }
+
+        headers += fmt::format("{}: {}{}", CanonicalFieldName(name), value,
+                               new_line);
+    }
+
+    if (!method.has_value() || !path.has_value() || !scheme) {
+        throw MalformedRequest {"A pseudo-header field is missing"};
+    } else if (method->empty()
+               || method->find_first_of(" \t") != std::string_view::npos
+               || !path->starts_with('/')
+               || path->find_first_of(" \t") != std::string_view::npos) {
+        throw MalformedRequest {"The method or path is invalid"};
+    }
+
+    std::string head {
+        fmt::format("{} {} HTTP/{}{}", method.value(), path.value(),
+                    version, new_line)};
+    if (authority.has_value()) {
+        head += fmt::format("Host: {}{}", authority.value(), new_line);
+    }
+
+    if (!cookie.empty()) {
+        head += fmt::format("Cookie: {}{}", cookie, new_line);
+    }
+
+    head += headers;
+    return head;
+}
+
+/**
+ * @brief Translate an HTTP/1.1 response header into a header list.
+ *
+ * @param header The response header, which may be followed by a part of the content.
+ * @return The header list and the part of the content.
+ */
+std::pair<hpack::HeaderList, std::string> TranslateResponse(
+    const std::string_view header) noexcept {
+    static constexpr std::string_view status_prefix {"HTTP/1.1 "};
+    static constexpr std::string_view end_of_header {"\r\n\r\n"};
+
+    const auto end {header.find(end_of_header)};
+    const auto head {header.substr(0, end)};
+    std::string content;
+    if (end != std::string_view::npos) {
+        content = header.substr(end + end_of_header.size());
+    }
+
+    hpack::HeaderList fields;
+    auto line_end {head.find(new_line)};
+    const auto status_line {head.substr(0, line_end)};
+    fields.push_back(
+        {":status",
+         std::string {status_line.substr(status_prefix.size(), 3)}});
+
+    while (line_end != std::string_view::npos) {
+        const auto line_start {line_end + new_line.size()};
+        line_end = head.find(new_line, line_start);
+        const auto line {head.substr(line_start, line_end == std::string_view::npos
+                                                     ? std::string_view::npos
+                                                     : line_end - line_start)};
+        const auto colon {line.find(':')};
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+
+        auto name {StringToLower(std::string {line.substr(0, colon)})};
+        // Connection management belongs to HTTP/2 itself.
+        if (name == "connection" || name == "keep-alive") {
+            continue;
+        }
+
+        auto value {line.substr(colon + 1)};
+        value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+        fields.push_back({std::move(name), std::string {value}});
+    }
+
+    return {std::move(fields), std::move(content)};
+}
+
+}  // namespace
+
+void FrameHeader::AppendTo(std::string& out) const noexcept {
+    assert(length < (1 << 24));
+    out.push_back(static_cast<char>(length >> 16));
+    out.push_back(static_cast<char>(length >> 8));
+    out.push_back(static_cast<char>(length));
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(flags));
+    AppendUInt32(out, stream_id & 0x7FFFFFFF);
+}
+
+FrameHeader FrameHeader::Parse(const std::span<const std::byte> bytes) noexcept {
+    assert(bytes.size() >= Http2Session::frame_header_size);
+    const std::span<const std::uint8_t> data {
+        reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size()};
+    return {.length = (static_cast<std::size_t>(data[0]) << 16)
+                      | (static_cast<std::size_t>(data[1]) << 8) | data[2],
+            .type = static_cast<FrameType>(data[3]),
+            .flags = data[4],
+            .stream_id = ReadUInt32(data.subspan(5)) & 0x7FFFFFFF};
+}
+
+Http2Session::Http2Session(Responder responder) noexcept :
+    responder_ {std::move(responder)},
+    decoder_ {hpack::default_table_size, max_header_list_size} {
+    assert(responder_);
+    std::string settings;
+    AppendSetting(settings, Setting::MaxConcurrentStreams,
+                  max_concurrent_streams);
+    AppendSetting(settings, Setting::MaxHeaderListSize, max_header_list_size);
+    QueueFrame(FrameType::Settings, 0, 0, settings);
+}
+
+void Http2Session::Receive(Buffer& buf) noexcept {
+    while (!go_away_sent_ && buf.ReadableSize() >= frame_header_size) {
+        const auto bytes {buf.ReadableBytes()};
+        const auto header {FrameHeader::Parse(bytes)};
+        if (header.length > default_max_frame_size) {
+            GoAway(Http2Error::FrameSizeError);
+            break;
+        }
+
+        if (bytes.size() < frame_header_size + header.length) {
+            // Wait for the rest of the frame.
+            break;
+        }
+
+        const std::span<const std::uint8_t> payload {
+            reinterpret_cast<const std::uint8_t*>(bytes.data())
+                + frame_header_size,
+            header.length};
+        try {
+            HandleFrame(header, payload);
+        } catch (const ConnectionError& err) {
+            GoAway(err.Error());
+        } catch (const std::exception&) {
+            GoAway(Http2Error::InternalError);
+        }
+
+        buf.Retrieve(frame_header_size + header.length);
+    }
+
+    if (go_away_sent_) {
+        // Frames after a connection error are ignored.
+        buf.RetrieveAll();
+    }
+}
+
+void Http2Session::HandleFrame(const FrameHeader& header,
+                               const std::span<const std::uint8_t> payload) {
+    // A header block must be continued without any other frames between.
+    if (continued_stream_.has_value()
+        && (header.type != FrameType::Continuation
+            || header.stream_id != continued_stream_.value())) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A header block is interrupted"};
+    }
+
+    switch (header.type) {
+        case FrameType::Data:
+            HandleData(header, payload);
+            break;
+        case FrameType::Headers:
+            HandleHeaders(header, payload);
+            break;
+        case FrameType::Continuation:
+            HandleContinuation(header, payload);
+            break;
+        case FrameType::Settings:
+            HandleSettings(header, payload);
+            break;
+        case FrameType::Ping:
+            HandlePing(header, payload);
+            break;
+        case FrameType::WindowUpdate:
+            HandleWindowUpdate(header, payload);
+            break;
+        case FrameType::RstStream:
+            HandleRstStream(header, payload);
+            break;
+        case FrameType::Priority:
+            // Priorities are not used, since streams are served in a round-robin manner.
+            if (header.stream_id == 0) {
+                throw ConnectionError {Http2Error::ProtocolError,
+                                       "A PRIORITY frame has no stream"};
+            } else if (payload.size() != 5) {
+                ResetStream(header.stream_id, Http2Error::FrameSizeError);
+            }
+
+            break;
+        case FrameType::GoAway:
+            if (header.stream_id != 0) {
+                throw ConnectionError {Http2Error::ProtocolError,
+                                       "A GOAWAY frame has a stream"};
+            }
+
+            go_away_received_ = true;
+            break;
+        case FrameType::PushPromise:
+            throw ConnectionError {Http2Error::ProtocolError,
+                                   "A client cannot push streams"};
+        default:
+            // Frames of unknown types must be ignored.
+            break;
+    }
+}
+
+void Http2Session::HandleHeaders(const FrameHeader& header,
+                                 std::span<const std::uint8_t> payload) {
+    if (header.stream_id == 0) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A HEADERS frame has no stream"};
+    }
+
+    payload = RemovePadding(header, payload);
+    if (header.flags & priority_flag) {
+        if (payload.size() < 5) {
+            throw ConnectionError {Http2Error::FrameSizeError,
+                                   "A HEADERS frame is too short"};
+        }
+
+        payload = payload.subspan(5);
+    }
+
+    header_block_.assign(payload.begin(), payload.end());
+    const auto end_stream {(header.flags & end_stream_flag) != 0};
+    if (header.flags & end_headers_flag) {
+        HandleHeaderBlock(header.stream_id, end_stream);
+    } else {
+        continued_stream_ = header.stream_id;
+        continued_end_stream_ = end_stream;
+    }
+}
+
+void Http2Session::HandleContinuation(
+    const FrameHeader& header, const std::span<const std::uint8_t> payload) {
+    if (!continued_stream_.has_value()) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A CONTINUATION frame is unexpected"};
+    }
+
+    header_block_.append(payload.begin(), payload.end());
+    if (header_block_.size() > max_header_list_size) {
+        throw ConnectionError {Http2Error::EnhanceYourCalm,
+                               "A header block is too large"};
+    }
+
+    if (header.flags & end_headers_flag) {
+        continued_stream_.reset();
+        HandleHeaderBlock(header.stream_id, continued_end_stream_);
+    }
+}
+
+void Http2Session::HandleHeaderBlock(const std::uint32_t stream_id,
+                                     const bool end_stream) {
+    // Every header block must be decoded to keep the dynamic table synchronized, even if the stream is refused.
+    hpack::HeaderList fields;
+    try {
+        fields = decoder_.Decode(
+            {reinterpret_cast<const std::uint8_t*>(header_block_.data()),
+             header_block_.size()});
+    } catch (const std::invalid_argument& err) {
+        throw ConnectionError {Http2Error::CompressionError, err.what()};
+    }
+
+    header_block_.clear();
+    if (const auto stream {streams_.find(stream_id)};
+        stream != streams_.end()) {
+        // Trailers, which are ignored, must end the stream.
+        if (!end_stream) {
+            ResetStream(stream_id, Http2Error::ProtocolError);
+        } else {
+            Respond(stream_id, stream->second);
+        }
+
+        return;
+    }
+
+    if (stream_id % 2 == 0 || stream_id <= last_stream_id_) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A stream ID is invalid"};
+    }
+
+    last_stream_id_ = stream_id;
+    if (go_away_received_ || streams_.size() >= max_concurrent_streams) {
+        ResetStream(stream_id, Http2Error::RefusedStream);
+        return;
+    }
+
+    Stream stream;
+    stream.send_window = initial_window_size_;
+    try {
+        stream.request_head = TranslateRequest(fields);
+    } catch (const MalformedRequest&) {
+        ResetStream(stream_id, Http2Error::ProtocolError);
+        return;
+    }
+
+    auto& opened {streams_.emplace(stream_id, std::move(stream)).first->second};
+    if (end_stream) {
+        Respond(stream_id, opened);
+    }
+}
+
+void Http2Session::HandleData(const FrameHeader& header,
+                              const std::span<const std::uint8_t> payload) {
+    if (header.stream_id == 0) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A DATA frame has no stream"};
+    } else if (Idle(header.stream_id)) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A DATA frame is sent on an idle stream"};
+    }
+
+    // The whole frame, including padding, counts against flow control.
+    if (header.length > 0) {
+        QueueWindowUpdate(0, header.length);
+    }
+
+    const auto data {RemovePadding(header, payload)};
+    const auto found {streams_.find(header.stream_id)};
+    if (found == streams_.end() || found->second.remaining > 0
+        || !found->second.parts.empty()) {
+        // The stream has been closed or its request has been answered.
+        ResetStream(header.stream_id, Http2Error::StreamClosed);
+        return;
+    }
+
+    auto& stream {found->second};
+    if (stream.request_body.size() + data.size() > max_request_body_size) {
+        stream.request_too_large = true;
+    } else {
+        stream.request_body.append(data.begin(), data.end());
+    }
+
+    if (header.flags & end_stream_flag) {
+        Respond(header.stream_id, stream);
+    } else if (header.length > 0) {
+        QueueWindowUpdate(header.stream_id, header.length);
+    }
+}
+
+void Http2Session::HandleSettings(const FrameHeader& header,
+                                  const std::span<const std::uint8_t> payload) {
+    if (header.stream_id != 0) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A SETTINGS frame has a stream"};
+    }
+
+    if (header.flags & ack_flag) {
+        if (!payload.empty()) {
+            throw ConnectionError {Http2Error::FrameSizeError,
+                                   "A SETTINGS acknowledgment has a payload"};
+        }
+
+        return;
+    }
+
+    if (payload.size() % 6 != 0) {
+        throw ConnectionError {Http2Error::FrameSizeError,
+                               "A SETTINGS frame has an invalid length"};
+    }
+
+    for (std::size_t i {0}; i != payload.size(); i += 6) {
+        const auto id {static_cast<Setting>((payload[i] << 8) | payload[i + 1])};
+        const auto value {ReadUInt32(payload.subspan(i + 2))};
+        switch (id) {
+            case Setting::HeaderTableSize:
+                encoder_.SetMaxTableSize(value);
+                break;
+            case Setting::EnablePush:
+                if (value > 1) {
+                    throw ConnectionError {Http2Error::ProtocolError,
+                                           "SETTINGS_ENABLE_PUSH is invalid"};
+                }
+
+                break;
+            case Setting::InitialWindowSize: {
+                if (value > max_window_size) {
+                    throw ConnectionError {
+                        Http2Error::FlowControlError,
+                        "SETTINGS_INITIAL_WINDOW_SIZE is too large"};
+                }
+
+                // The change applies to the windows of all open streams.
+                const auto delta {static_cast<std::int64_t>(value)
+                                  - initial_window_size_};
+                for (auto& [id, stream] : streams_) {
+                    stream.send_window += delta;
+                    if (stream.send_window > max_window_size) {
+                        throw ConnectionError {Http2Error::FlowControlError,
+                                               "A window is too large"};
+                    }
+                }
+
+                initial_window_size_ = value;
+                break;
+            }
+            case Setting::MaxFrameSize:
+                if (value < default_max_frame_size || value > 0xFFFFFF) {
+                    throw ConnectionError {Http2Error::ProtocolError,
+                                           "SETTINGS_MAX_FRAME_SIZE is invalid"};
+                }
+
+                max_frame_size_ = value;
+                break;
+            default:
+                // Other settings do not affect a server without server push.
+                break;
+        }
+    }
+
+    QueueFrame(FrameType::Settings, ack_flag, 0);
+}
+
+void Http2Session::HandlePing(const FrameHeader& header,
+                              const std::span<const std::uint8_t> payload) {
+    if (header.stream_id != 0) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A PING frame has a stream"};
+    } else if (payload.size() != 8) {
+        throw ConnectionError {Http2Error::FrameSizeError,
+                               "A PING frame has an invalid length"};
+    }
+
+    if ((header.flags & ack_flag) == 0) {
+        QueueFrame(FrameType::Ping, ack_flag, 0,
+                   {reinterpret_cast<const char*>(payload.data()),
+                    payload.size()});
+    }
+}
+
+void Http2Session::HandleWindowUpdate(
+    const FrameHeader& header, const std::span<const std::uint8_t> payload) {
+    if (payload.size() != 4) {
+        throw ConnectionError {Http2Error::FrameSizeError,
+                               "A WINDOW_UPDATE frame has an invalid length"};
+    }
+
+    const auto increment {ReadUInt32(payload) & 0x7FFFFFFF};
+    if (header.stream_id == 0) {
+        if (increment == 0) {
+            throw ConnectionError {Http2Error::ProtocolError,
+                                   "A window increment is zero"};
+        }
+
+        conn_send_window_ += increment;
+        if (conn_send_window_ > max_window_size) {
+            throw ConnectionError {Http2Error::FlowControlError,
+                                   "The connection window is too large"};
+        }
+
+        return;
+    }
+
+    if (Idle(header.stream_id)) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A WINDOW_UPDATE frame is sent on an idle stream"};
+    }
+
+    if (const auto stream {streams_.find(header.stream_id)};
+        stream != streams_.end()) {
+        if (increment == 0) {
+            ResetStream(header.stream_id, Http2Error::ProtocolError);
+            return;
+        }
+
+        stream->second.send_window += increment;
+        if (stream->second.send_window > max_window_size) {
+            ResetStream(header.stream_id, Http2Error::FlowControlError);
+        }
+    }
+}
+
+void Http2Session::HandleRstStream(const FrameHeader& header,
+                                   const std::span<const std::uint8_t> payload) {
+    if (header.stream_id == 0 || Idle(header.stream_id)) {
+        throw ConnectionError {Http2Error::ProtocolError,
+                               "A RST_STREAM frame has an invalid stream"};
+    } else if (payload.size() != 4) {
+        throw ConnectionError {Http2Error::FrameSizeError,
+                               "A RST_STREAM frame has an invalid length"};
+    }
+
+    streams_.erase(header.stream_id);
+}
+
+void Http2Session::Respond(const std::uint32_t stream_id,
+                           Stream& stream) noexcept {
+    std::optional<RequestError> error;
+    if (stream.request_too_large) {
+        error = {.status = StatusCode::PayloadTooLarge,
+                 .msg = "The request body is too large"};
+    }
+
+    // The request is parsed by the HTTP/1.1 parser.
+    auto request_text {std::move(stream.request_head)};
+    if (!stream.request_body.empty()) {
+        request_text += fmt::format("Content-Length: {}{}",
+                                    stream.request_body.size(), new_line);
+    }
+
+    request_text += new_line;
+    request_text += stream.request_body;
+    stream.request_body.clear();
+
+    Buffer request_buf {request_text};
+    Request request;
+    try {
+        if (!error.has_value()) {
+            if (request.Parse(request_buf)) {
+                request.DecodePost();
+            } else {
+                error = {.msg = "The request is incomplete"};
+            }
+        }
+    } catch (const RequestTooLarge& err) {
+        error = {.status = err.Status(), .msg = err.what()};
+    } catch (const std::exception& err) {
+        error = {.msg = err.what()};
+    }
+
+    Buffer header;
+    std::vector<BodyPart> parts;
+    responder_(request, error, header, stream.asset, stream.file, parts);
+
+    auto [fields, content] {TranslateResponse(header.RetrieveAllToString())};
+    const auto status {fields.front().value};
+
+    // The content rendered into the header is sent first.
+    stream.parts.push_back({.prefix = std::move(content)});
+    if (parts.empty()) {
+        const auto size {stream.asset ? stream.asset->Content().size()
+                         : stream.file.Valid() ? stream.file.Size()
+                                               : 0};
+        stream.parts.push_back({.prefix = "", .offset = 0, .length = size});
+    } else {
+        std::ranges::move(parts, std::back_inserter(stream.parts));
+    }
+
+    // Responses of `304 Not Modified` have no content.
+    if (status != "304") {
+        for (const auto& part : stream.parts) {
+            stream.remaining += part.prefix.size() + part.length;
+        }
+    }
+
+    // A header block larger than a frame is split into CONTINUATION frames.
+    const auto block {encoder_.Encode(fields)};
+    const std::string_view block_view {block};
+    std::size_t offset {0};
+    do {
+        const auto fragment {block_view.substr(offset, max_frame_size_)};
+        offset += fragment.size();
+        const auto last {offset == block.size()};
+        std::uint8_t flags {last ? end_headers_flag : std::uint8_t {0}};
+        if (offset == fragment.size() && stream.remaining == 0) {
+            flags |= end_stream_flag;
+        }
+
+        QueueFrame(offset == fragment.size() ? FrameType::Headers
+                                             : FrameType::Continuation,
+                   flags, stream_id, fragment);
+    } while (offset < block.size());
+
+    if (stream.remaining == 0) {
+        streams_.erase(stream_id);
+    }
+}
+
+bool Http2Session::Produce(Buffer& out, const std::size_t limit) noexcept {
+    bool produced {false};
+    if (!control_frames_.empty()) {
+        out.Append(control_frames_.data(), control_frames_.size());
+        control_frames_.clear();
+        produced = true;
+    }
+
+    while (!go_away_sent_ && out.ReadableSize() < limit
+           && conn_send_window_ > 0) {
+        const auto stream {NextSendableStream()};
+        if (stream == streams_.end()) {
+            break;
+        }
+
+        const auto stream_id {stream->first};
+        auto& state {stream->second};
+        const auto size {std::min(
+            {state.remaining, static_cast<std::size_t>(state.send_window),
+             static_cast<std::size_t>(conn_send_window_), max_frame_size_})};
+        try {
+            AppendData(out, stream_id, state, size);
+        } catch (const std::exception&) {
+            // The file may have been truncated.
+            ResetStream(stream_id, Http2Error::InternalError);
+            out.Append(control_frames_.data(), control_frames_.size());
+            control_frames_.clear();
+        }
+
+        last_served_id_ = stream_id;
+        produced = true;
+    }
+
+    return produced;
+}
+
+void Http2Session::AppendData(Buffer& out, const std::uint32_t stream_id,
+                              Stream& stream, const std::size_t size) {
+    assert(size > 0 && size <= stream.remaining);
+
+    // Read the content before appending the frame header, so a failure leaves no partial frame.
+    std::string frame;
+    const FrameHeader header {
+        .length = size,
+        .type = FrameType::Data,
+        .flags = size == stream.remaining ? end_stream_flag : std::uint8_t {0},
+        .stream_id = stream_id};
+    header.AppendTo(frame);
+    frame.resize(frame_header_size + size);
+
+    auto dest {frame.data() + frame_header_size};
+    auto left {size};
+    while (left > 0) {
+        assert(stream.part_idx < stream.parts.size());
+        const auto& part {stream.parts[stream.part_idx]};
+        const auto part_size {part.prefix.size() + part.length};
+        const auto count {std::min(left, part_size - stream.part_pos)};
+        if (stream.part_pos < part.prefix.size()) {
+            const auto prefix_count {
+                std::min(count, part.prefix.size() - stream.part_pos)};
+            std::memcpy(dest, part.prefix.data() + stream.part_pos,
+                        prefix_count);
+            dest += prefix_count;
+            left -= prefix_count;
+            stream.part_pos += prefix_count;
+        } else {
+            const auto offset {part.offset + stream.part_pos
+                               - part.prefix.size()};
+            if (stream.asset) {
+                std::memcpy(dest, stream.asset->Content().data() + offset, count);
+            } else if (const auto read {pread(stream.file.Descriptor(), dest,
+                                              count, offset)};
+                       read != static_cast<ssize_t>(count)) {
+                throw std::runtime_error {fmt::format(
+                    "The file '{}' has been truncated", stream.file.Path())};
+            }
+
+            dest += count;
+            left -= count;
+            stream.part_pos += count;
+        }
+
+        if (stream.part_pos == part_size) {
+            ++stream.part_idx;
+            stream.part_pos = 0;
+        }
+    }
+
+    out.Append(frame.data(), frame.size());
+    stream.send_window -= size;
+    conn_send_window_ -= size;
+    stream.remaining -= size;
+    if (stream.remaining == 0) {
+        streams_.erase(stream_id);
+    }
+}
+
+std::map<std::uint32_t, Http2Session::Stream>::iterator
+Http2Session::NextSendableStream() noexcept {
+    const auto sendable {[](const auto& stream) noexcept {
+        return stream.second.remaining > 0 && stream.second.send_window > 0;
+    }};
+
+    const auto next {streams_.upper_bound(last_served_id_)};
+    if (const auto found {std::find_if(next, streams_.end(), sendable)};
+        found != streams_.end()) {
+        return found;
+    }
+
+    const auto found {std::find_if(streams_.begin(), next, sendable)};
+    return found != next ? found : streams_.end();
+}
+
+std::size_t Http2Session::SendableSize() const noexcept {
+    std::size_t data_size {0};
+    if (!go_away_sent_) {
+        for (const auto& [id, stream] : streams_) {
+            data_size += std::min(
+                stream.remaining,
+                static_cast<std::size_t>(std::max<std::int64_t>(
+                    stream.send_window, 0)));
+        }
+    }
+
+    return control_frames_.size()
+           + std::min(data_size, static_cast<std::size_t>(std::max<std::int64_t>(
+                                     conn_send_window_, 0)));
+}
+
+bool Http2Session::Closed() const noexcept {
+    return go_away_sent_ || (go_away_received_ && streams_.empty());
+}
+
+std::size_t Http2Session::StreamCount() const noexcept {
+    return streams_.size();
+}
+
+bool Http2Session::Idle(const std::uint32_t stream_id) const noexcept {
+    return stream_id > last_stream_id_;
+}
+
+void Http2Session::QueueFrame(const FrameType type, const std::uint8_t flags,
+                              const std::uint32_t stream_id,
+                              const std::string_view payload) noexcept {
+    const FrameHeader header {.length = payload.size(),
+                              .type = type,
+                              .flags = flags,
+                              .stream_id = stream_id};
+    header.AppendTo(control_frames_);
+    control_frames_.append(payload);
+}
+
+void Http2Session::QueueWindowUpdate(const std::uint32_t stream_id,
+                                     const std::size_t increment) noexcept {
+    std::string payload;
+    AppendUInt32(payload, static_cast<std::uint32_t>(increment));
+    QueueFrame(FrameType::WindowUpdate, 0, stream_id, payload);
+}
+
+void Http2Session::ResetStream(const std::uint32_t stream_id,
+                               const Http2Error error) noexcept {
+    std::string payload;
+    AppendUInt32(payload, static_cast<std::uint32_t>(error));
+    QueueFrame(FrameType::RstStream, 0, stream_id, payload);
+    streams_.erase(stream_id);
+}
+
+void Http2Session::GoAway(const Http2Error error) noexcept {
+    std::string payload;
+    AppendUInt32(payload, last_stream_id_);
+    AppendUInt32(payload, static_cast<std::uint32_t>(error));
+    QueueFrame(FrameType::GoAway, 0, 0, payload);
+    streams_.clear();
+    go_away_sent_ = true;
+}
+
+}  // namespace ws::http
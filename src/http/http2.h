@@ -0,0 +1,290 @@
+/**
+ * @file http2.h
+ * @brief The HTTP/2 session over a connection.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-24
+ *
+ * @example src/http/http2_test.cpp
+ */
+
+#pragma once
+
+#include "containers/buffer.h"
+#include "hpack.h"
+#include "http.h"
+#include "request.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace ws::http {
+
+//! HTTP/2 frame types.
+enum class FrameType : std::uint8_t {
+    Data = 0x0,
+    Headers = 0x1,
+    Priority = 0x2,
+    RstStream = 0x3,
+    Settings = 0x4,
+    PushPromise = 0x5,
+    Ping = 0x6,
+    GoAway = 0x7,
+    WindowUpdate = 0x8,
+    Continuation = 0x9
+};
+
+//! HTTP/2 error codes.
+enum class Http2Error : std::uint32_t {
+    NoError = 0x0,
+    ProtocolError = 0x1,
+    InternalError = 0x2,
+    FlowControlError = 0x3,
+    StreamClosed = 0x5,
+    FrameSizeError = 0x6,
+    RefusedStream = 0x7,
+    CompressionError = 0x9,
+    EnhanceYourCalm = 0xb
+};
+
+//! HTTP/2 setting identifiers.
+enum class Setting : std::uint16_t {
+    HeaderTableSize = 0x1,
+    EnablePush = 0x2,
+    MaxConcurrentStreams = 0x3,
+    InitialWindowSize = 0x4,
+    MaxFrameSize = 0x5,
+    MaxHeaderListSize = 0x6
+};
+
+//! The header of an HTTP/2 frame.
+struct FrameHeader {
+    //! Append the 9-byte representation.
+    void AppendTo(std::string& out) const noexcept;
+
+    /**
+     * @brief Parse a frame header.
+     *
+     * @param bytes At least 9 bytes.
+     */
+    static FrameHeader Parse(std::span<const std::byte> bytes) noexcept;
+
+    std::size_t length {0};
+    FrameType type {FrameType::Data};
+    std::uint8_t flags {0};
+    std::uint32_t stream_id {0};
+};
+
+/**
+ * @brief The HTTP/2 session over a connection.
+ *
+ * @details
+ * Requests of multiplexed streams are translated into HTTP/1.1 requests,
+ * so they are parsed by @p Request and answered by the same routing logic as HTTP/1.1 connections.
+ * Each response header built by @p Response is translated back into a header list compressed by HPACK,
+ * and its content, which may be in memory, in a file or split into byte ranges, is sent in @p DATA frames.
+ *
+ * @p DATA frames respect the flow-control windows of both the connection and each stream.
+ * Streams with content are served in a round-robin manner, so a large response cannot block others.
+ * Received @p DATA frames are acknowledged by @p WINDOW_UPDATE frames right away,
+ * since request bodies are limited by @p max_request_body_size.
+ *
+ * Connection errors make the session send a @p GOAWAY frame and close.
+ * Stream errors reset the stream with a @p RST_STREAM frame.
+ */
+class Http2Session {
+public:
+    //! The callback building a response for a request, which has the same parameters as the HTTP/1.1 one.
+    using Responder = std::function<void(
+        const Request& request, const std::optional<RequestError>& error,
+        Buffer& header, std::shared_ptr<const Asset>& asset,
+        ReadOnlyFile& file, std::vector<BodyPart>& parts)>;
+
+    //! The connection preface sent by a client with prior knowledge of HTTP/2.
+    static constexpr std::string_view preface {
+        "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"};
+
+    static constexpr std::size_t frame_header_size {9};
+
+    //! The maximum frame size until the peer changes it, which is also the maximum size of received frames.
+    static constexpr std::size_t default_max_frame_size {0x4000};
+
+    static constexpr std::int64_t default_window_size {0xFFFF};
+
+    static constexpr std::int64_t max_window_size {0x7FFFFFFF};
+
+    static constexpr std::size_t max_concurrent_streams {100};
+
+    static constexpr std::size_t max_header_list_size {0x10000};
+
+    static constexpr std::size_t max_request_body_size {0x100000};
+
+    /**
+     * @brief Create a session, whose server preface is queued to be sent.
+     *
+     * @param responder A callback building responses.
+     */
+    explicit Http2Session(Responder responder) noexcept;
+
+    /**
+     * @brief Handle received frames after the client connection preface.
+     *
+     * @details An incomplete frame is kept in the buffer.
+     *
+     * @param buf The reading buffer, whose complete frames are retrieved.
+     */
+    void Receive(Buffer& buf) noexcept;
+
+    /**
+     * @brief Move frames to be sent into a buffer.
+     *
+     * @details
+     * Control frames and response headers are always moved.
+     * @p DATA frames are appended until the buffer reaches the limit or flow-control windows are exhausted.
+     *
+     * @param out A buffer to receive frames.
+     * @param limit The size at which no more @p DATA frames are appended.
+     * @return @p true if any frame has been appended, otherwise @p false.
+     */
+    bool Produce(Buffer& out, std::size_t limit) noexcept;
+
+    //! Get the number of bytes that can be sent with the current flow-control windows.
+    std::size_t SendableSize() const noexcept;
+
+    //! Whether the session has finished, because of a connection error or a @p GOAWAY from the client.
+    bool Closed() const noexcept;
+
+    //! Get the number of active streams.
+    std::size_t StreamCount() const noexcept;
+
+private:
+    //! A stream opened by a request.
+    struct Stream {
+        //! The HTTP/1.1 request line and headers translated from the header list.
+        std::string request_head;
+
+        std::string request_body;
+
+        //! Whether the request body is larger than @p max_request_body_size.
+        bool request_too_large {false};
+
+        std::int64_t send_window {default_window_size};
+
+        //! The content of the response, which starts with a part of content rendered into the header.
+        std::shared_ptr<const Asset> asset;
+        ReadOnlyFile file;
+        std::vector<BodyPart> parts;
+
+        //! The index of the part being sent.
+        std::size_t part_idx {0};
+
+        //! The position in the part being sent, counting its prefix.
+        std::size_t part_pos {0};
+
+        //! The number of response bytes that have not been sent.
+        std::size_t remaining {0};
+    };
+
+    //! Handle a complete frame.
+    void HandleFrame(const FrameHeader& header,
+                     std::span<const std::uint8_t> payload);
+
+    void HandleHeaders(const FrameHeader& header,
+                       std::span<const std::uint8_t> payload);
+
+    void HandleContinuation(const FrameHeader& header,
+                            std::span<const std::uint8_t> payload);
+
+    void HandleData(const FrameHeader& header,
+                    std::span<const std::uint8_t> payload);
+
+    void HandleSettings(const FrameHeader& header,
+                        std::span<const std::uint8_t> payload);
+
+    void HandlePing(const FrameHeader& header,
+                    std::span<const std::uint8_t> payload);
+
+    void HandleWindowUpdate(const FrameHeader& header,
+                            std::span<const std::uint8_t> payload);
+
+    void HandleRstStream(const FrameHeader& header,
+                         std::span<const std::uint8_t> payload);
+
+    //! Handle a complete header block.
+    void HandleHeaderBlock(std::uint32_t stream_id, bool end_stream);
+
+    //! Build and queue the response after a request has been received.
+    void Respond(std::uint32_t stream_id, Stream& stream) noexcept;
+
+    //! Append a @p DATA frame of a stream's content.
+    void AppendData(Buffer& out, std::uint32_t stream_id, Stream& stream,
+                    std::size_t size);
+
+    //! Find the next stream with content that can be sent, after the last served one.
+    std::map<std::uint32_t, Stream>::iterator NextSendableStream() noexcept;
+
+    //! Whether a stream has never been opened.
+    bool Idle(std::uint32_t stream_id) const noexcept;
+
+    //! Queue a frame to be sent.
+    void QueueFrame(FrameType type, std::uint8_t flags, std::uint32_t stream_id,
+                    std::string_view payload = {}) noexcept;
+
+    //! Queue a @p WINDOW_UPDATE frame.
+    void QueueWindowUpdate(std::uint32_t stream_id,
+                           std::size_t increment) noexcept;
+
+    //! Reset a stream because of a stream error.
+    void ResetStream(std::uint32_t stream_id, Http2Error error) noexcept;
+
+    //! Send a @p GOAWAY frame because of a connection error and stop handling frames.
+    void GoAway(Http2Error error) noexcept;
+
+    Responder responder_;
+
+    hpack::Encoder encoder_;
+    hpack::Decoder decoder_;
+
+    std::map<std::uint32_t, Stream> streams_;
+
+    //! The largest stream ID opened by the client.
+    std::uint32_t last_stream_id_ {0};
+
+    //! The stream served by the last @p DATA frame.
+    std::uint32_t last_served_id_ {0};
+
+    //! Frames to be sent before any @p DATA frames.
+    std::string control_frames_;
+
+    //! The stream whose header block is continued by @p CONTINUATION frames.
+    std::optional<std::uint32_t> continued_stream_;
+
+    //! Whether the continued header block ends its stream.
+    bool continued_end_stream_ {false};
+
+    std::string header_block_;
+
+    std::int64_t conn_send_window_ {default_window_size};
+
+    //! The initial window size of streams set by the client.
+    std::int64_t initial_window_size_ {default_window_size};
+
+    std::size_t max_frame_size_ {default_max_frame_size};
+
+    bool go_away_sent_ {false};
+    bool go_away_received_ {false};
+};
+
+}  // namespace ws::http
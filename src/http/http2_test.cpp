@@ -0,0 +1,398 @@
+#include "http2.h"
+
+#include <gtest/gtest.h>
+
+using namespace ws;
+using namespace ws::http;
+
+
+namespace {
+
+struct Frame {
+    FrameHeader header;
+    std::string payload;
+};
+
+//! A client with prior knowledge of HTTP/2, which talks to a session in memory.
+class Client {
+public:
+    explicit Client(Http2Session& session) noexcept : session_ {session} {}
+
+    //! Send a frame to the session.
+    void Send(const FrameType type, const std::uint8_t flags,
+              const std::uint32_t stream_id,
+              const std::string_view payload = {}) noexcept {
+        std::string frame;
+        const FrameHeader header {.length = payload.size(),
+                                  .type = type,
+                                  .flags = flags,
+                                  .stream_id = stream_id};
+        header.AppendTo(frame);
+        frame += payload;
+        Buffer buf {frame};
+        session_.Receive(buf);
+        EXPECT_EQ(buf.ReadableSize(), 0);
+    }
+
+    //! Send a request's header block.
+    void SendHeaders(const std::uint32_t stream_id,
+                     const hpack::HeaderList& fields,
+                     const bool end_stream = true) noexcept {
+        Send(FrameType::Headers, end_stream ? 0x5 : 0x4, stream_id,
+             encoder_.Encode(fields));
+    }
+
+    //! Receive frames produced by the session.
+    std::vector<Frame> Receive(
+        const std::size_t limit = Http2Session::max_request_body_size) {
+        Buffer buf;
+        session_.Produce(buf, limit);
+        const auto bytes {buf.ReadableBytes()};
+
+        std::vector<Frame> frames;
+        for (std::size_t offset {0}; offset < bytes.size();) {
+            EXPECT_GE(bytes.size() - offset, Http2Session::frame_header_size);
+            Frame frame {.header = FrameHeader::Parse(bytes.subspan(offset)),
+                         .payload = ""};
+            offset += Http2Session::frame_header_size;
+            frame.payload.assign(
+                reinterpret_cast<const char*>(bytes.data()) + offset,
+                frame.header.length);
+            offset += frame.header.length;
+            frames.push_back(std::move(frame));
+        }
+
+        return frames;
+    }
+
+    //! Decode the header block of a @p HEADERS frame.
+    hpack::HeaderList Decode(const Frame& frame) {
+        EXPECT_EQ(frame.header.type, FrameType::Headers);
+        return decoder_.Decode(
+            {reinterpret_cast<const std::uint8_t*>(frame.payload.data()),
+             frame.payload.size()});
+    }
+
+private:
+    Http2Session& session_;
+    hpack::Encoder encoder_;
+    hpack::Decoder decoder_;
+};
+
+//! Get a 4-byte payload encoding an integer.
+std::string UInt32Payload(const std::uint32_t value) noexcept {
+    return {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+            static_cast<char>(value >> 8), static_cast<char>(value)};
+}
+
+//! Get a @p SETTINGS payload with a single parameter.
+std::string SettingPayload(const Setting id, const std::uint32_t value) noexcept {
+    return std::string {static_cast<char>(static_cast<std::uint16_t>(id) >> 8),
+                        static_cast<char>(id)}
+           + UInt32Payload(value);
+}
+
+//! Get the request fields for a path.
+hpack::HeaderList GetRequest(const std::string& path) noexcept {
+    return {{":method", "GET"},
+            {":scheme", "http"},
+            {":path", path},
+            {":authority", "localhost"}};
+}
+
+//! A responder replying with the request path as plain text.
+struct EchoResponder {
+    void operator()(const Request& request,
+                    const std::optional<RequestError>& error,
+                    Buffer& header, std::shared_ptr<const Asset>&,
+                    ReadOnlyFile&, std::vector<BodyPart>&) {
+        requests.push_back(std::string {request.Path()});
+        errors.push_back(error.has_value());
+        if (const auto user {request.Post("username")}) {
+            users.push_back(std::string {user.value()});
+        }
+
+        const auto body {std::string {request.Path()} + suffix};
+        header.Append(fmt::format(
+            "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\n"
+            "Content-type: text/plain\r\nContent-length: {}\r\n\r\n{}",
+            body.size(), body));
+    }
+
+    std::string suffix;
+    std::vector<std::string> requests;
+    std::vector<bool> errors;
+    std::vector<std::string> users;
+};
+
+}  // namespace
+
+TEST(HTTP2SessionTest, ServerPreface) {
+    EchoResponder responder;
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+
+    const auto frames {client.Receive()};
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].header.type, FrameType::Settings);
+    EXPECT_EQ(frames[0].header.flags, 0);
+    EXPECT_EQ(frames[0].header.stream_id, 0);
+    EXPECT_EQ(frames[0].payload.size(), 12);
+
+    // The client's settings are acknowledged.
+    client.Send(FrameType::Settings, 0, 0);
+    const auto ack {client.Receive()};
+    ASSERT_EQ(ack.size(), 1);
+    EXPECT_EQ(ack[0].header.type, FrameType::Settings);
+    EXPECT_EQ(ack[0].header.flags, 0x1);
+    EXPECT_FALSE(session.Closed());
+}
+
+TEST(HTTP2SessionTest, Get) {
+    EchoResponder responder;
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    client.SendHeaders(1, GetRequest("/index.html"));
+    ASSERT_EQ(responder.requests.size(), 1);
+    EXPECT_EQ(responder.requests[0], "/index.html");
+    EXPECT_FALSE(responder.errors[0]);
+
+    const auto frames {client.Receive()};
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[0].header.stream_id, 1);
+    EXPECT_EQ(frames[0].header.flags, 0x4);
+
+    // Connection-specific fields are removed.
+    EXPECT_EQ(client.Decode(frames[0]),
+              (hpack::HeaderList {{":status", "200"},
+                                  {"content-type", "text/plain"},
+                                  {"content-length", "11"}}));
+
+    EXPECT_EQ(frames[1].header.type, FrameType::Data);
+    EXPECT_EQ(frames[1].header.stream_id, 1);
+    EXPECT_EQ(frames[1].header.flags, 0x1);
+    EXPECT_EQ(frames[1].payload, "/index.html");
+    EXPECT_EQ(session.StreamCount(), 0);
+    EXPECT_EQ(session.SendableSize(), 0);
+}
+
+TEST(HTTP2SessionTest, PostWithData) {
+    EchoResponder responder;
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    client.SendHeaders(1,
+                       {{":method", "POST"},
+                        {":scheme", "http"},
+                        {":path", "/"},
+                        {"content-type", "application/x-www-form-urlencoded"}},
+                       false);
+    EXPECT_TRUE(responder.requests.empty());
+
+    // Received data is acknowledged for both the connection and the stream.
+    client.Send(FrameType::Data, 0, 1, "username=");
+    auto frames {client.Receive()};
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[0].header.type, FrameType::WindowUpdate);
+    EXPECT_EQ(frames[0].header.stream_id, 0);
+    EXPECT_EQ(frames[0].payload, UInt32Payload(9));
+    EXPECT_EQ(frames[1].header.type, FrameType::WindowUpdate);
+    EXPECT_EQ(frames[1].header.stream_id, 1);
+
+    client.Send(FrameType::Data, 0x1, 1, "abc");
+    ASSERT_EQ(responder.users.size(), 1);
+    EXPECT_EQ(responder.users[0], "abc");
+
+    frames = client.Receive();
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[0].header.type, FrameType::WindowUpdate);
+    EXPECT_EQ(frames[1].header.type, FrameType::Headers);
+    EXPECT_EQ(frames[2].header.type, FrameType::Data);
+}
+
+TEST(HTTP2SessionTest, FlowControl) {
+    EchoResponder responder;
+    responder.suffix = std::string(20, 'x');
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    client.Send(FrameType::Settings, 0, 0,
+                SettingPayload(Setting::InitialWindowSize, 10));
+    client.SendHeaders(1, GetRequest("/a"));
+
+    // Only the window is sent.
+    auto frames {client.Receive()};
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[0].header.type, FrameType::Settings);
+    EXPECT_EQ(frames[1].header.type, FrameType::Headers);
+    EXPECT_EQ(frames[2].header.type, FrameType::Data);
+    EXPECT_EQ(frames[2].header.flags, 0);
+    EXPECT_EQ(frames[2].payload, "/a" + std::string(8, 'x'));
+    EXPECT_EQ(session.SendableSize(), 0);
+    EXPECT_TRUE(client.Receive().empty());
+
+    client.Send(FrameType::WindowUpdate, 0, 1, UInt32Payload(100));
+    EXPECT_EQ(session.SendableSize(), 12);
+    frames = client.Receive();
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].header.flags, 0x1);
+    EXPECT_EQ(frames[0].payload, std::string(12, 'x'));
+    EXPECT_EQ(session.StreamCount(), 0);
+}
+
+TEST(HTTP2SessionTest, Multiplexing) {
+    constexpr auto frame_size {Http2Session::default_max_frame_size};
+    EchoResponder responder;
+    responder.suffix = std::string(frame_size, 'x');
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    client.SendHeaders(1, GetRequest("/1"));
+    client.SendHeaders(3, GetRequest("/3"));
+    EXPECT_EQ(session.StreamCount(), 2);
+
+    // Response headers are always sent, but the limit stops appending data frames.
+    auto frames {client.Receive(1)};
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[0].header.stream_id, 1);
+    EXPECT_EQ(frames[1].header.stream_id, 3);
+
+    // Data frames of different streams are sent in a round-robin manner.
+    const std::vector<std::pair<std::uint32_t, std::size_t>> expected {
+        {1, frame_size}, {3, frame_size}, {1, 2}, {3, 2}};
+    for (const auto& [stream_id, size] : expected) {
+        frames = client.Receive(1);
+        ASSERT_EQ(frames.size(), 1);
+        EXPECT_EQ(frames[0].header.type, FrameType::Data);
+        EXPECT_EQ(frames[0].header.stream_id, stream_id);
+        EXPECT_EQ(frames[0].payload.size(), size);
+    }
+
+    EXPECT_EQ(frames[0].header.flags, 0x1);
+    EXPECT_EQ(session.StreamCount(), 0);
+}
+
+TEST(HTTP2SessionTest, MalformedRequest) {
+    EchoResponder responder;
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    const std::vector<hpack::HeaderList> requests {
+        {{":method", "GET"}, {":scheme", "http"}},
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {"Host", "a"}},
+        {{":method", "GET"}, {":scheme", "http"}, {"a", "b"}, {":path", "/"}},
+        {{":method", "GET"},
+         {":scheme", "http"},
+         {":path", "/"},
+         {"connection", "close"}},
+        {{":method", "GET"},
+         {":scheme", "http"},
+         {":path", "/"},
+         {"a", "b\r\nc: d"}},
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":a", "b"}}};
+
+    std::uint32_t stream_id {1};
+    for (const auto& request : requests) {
+        client.SendHeaders(stream_id, request);
+        const auto frames {client.Receive()};
+        ASSERT_EQ(frames.size(), 1);
+        EXPECT_EQ(frames[0].header.type, FrameType::RstStream);
+        EXPECT_EQ(frames[0].header.stream_id, stream_id);
+        EXPECT_EQ(frames[0].payload,
+                  UInt32Payload(static_cast<std::uint32_t>(
+                      Http2Error::ProtocolError)));
+        stream_id += 2;
+    }
+
+    EXPECT_TRUE(responder.requests.empty());
+    EXPECT_FALSE(session.Closed());
+}
+
+TEST(HTTP2SessionTest, ControlFrames) {
+    EchoResponder responder;
+    Http2Session session {std::ref(responder)};
+    Client client {session};
+    client.Receive();
+
+    client.Send(FrameType::Ping, 0, 0, "12345678");
+    auto frames {client.Receive()};
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].header.type, FrameType::Ping);
+    EXPECT_EQ(frames[0].header.flags, 0x1);
+    EXPECT_EQ(frames[0].payload, "12345678");
+
+    // A header block split into CONTINUATION frames.
+    hpack::Encoder encoder;
+    const auto block {encoder.Encode(GetRequest("/split"))};
+    client.Send(FrameType::Headers, 0x1, 1, block.substr(0, 3));
+    client.Send(FrameType::Continuation, 0x4, 1, block.substr(3));
+    ASSERT_EQ(responder.requests.size(), 1);
+    EXPECT_EQ(responder.requests[0], "/split");
+    client.Receive();
+
+    // The client closes the stream before the response has been sent.
+    const auto rst_payload {UInt32Payload(0x8)};
+    client.Send(FrameType::Settings, 0, 0,
+                SettingPayload(Setting::InitialWindowSize, 0));
+    client.SendHeaders(3, GetRequest("/reset"));
+    EXPECT_EQ(session.StreamCount(), 1);
+    client.Send(FrameType::RstStream, 0, 3, rst_payload);
+    EXPECT_EQ(session.StreamCount(), 0);
+
+    client.Send(FrameType::GoAway, 0, 0,
+                UInt32Payload(0) + UInt32Payload(0));
+    EXPECT_TRUE(session.Closed());
+}
+
+TEST(HTTP2SessionTest, ConnectionErrors) {
+    const std::vector<std::pair<Frame, Http2Error>> cases {
+        {{{.type = FrameType::Data, .stream_id = 0}, "data"},
+         Http2Error::ProtocolError},
+        {{{.type = FrameType::Ping, .stream_id = 0}, "short"},
+         Http2Error::FrameSizeError},
+        {{{.type = FrameType::Headers, .flags = 0x4, .stream_id = 2}, "\x82"},
+         Http2Error::ProtocolError},
+        {{{.type = FrameType::Headers, .flags = 0x4, .stream_id = 1}, "\x80"},
+         Http2Error::CompressionError},
+        {{{.type = FrameType::WindowUpdate, .stream_id = 0},
+          UInt32Payload(0x7FFFFFFF)},
+         Http2Error::FlowControlError},
+        {{{.type = FrameType::Continuation, .flags = 0x4, .stream_id = 1},
+          "\x82"},
+         Http2Error::ProtocolError}};
+
+    for (const auto& [frame, error] : cases) {
+        EchoResponder responder;
+        Http2Session session {std::ref(responder)};
+        Client client {session};
+        client.Receive();
+
+        client.Send(frame.header.type, frame.header.flags,
+                    frame.header.stream_id, frame.payload);
+        EXPECT_TRUE(session.Closed());
+
+        const auto frames {client.Receive()};
+        ASSERT_EQ(frames.size(), 1);
+        EXPECT_EQ(frames[0].header.type, FrameType::GoAway);
+        EXPECT_EQ(frames[0].payload.substr(4),
+                  UInt32Payload(static_cast<std::uint32_t>(error)));
+    }
+
+    {
+        // An oversized frame.
+        EchoResponder responder;
+        Http2Session session {std::ref(responder)};
+        Client client {session};
+        client.Receive();
+
+        client.Send(FrameType::Data, 0, 1,
+                    std::string(Http2Session::default_max_frame_size + 1, 'x'));
+        EXPECT_TRUE(session.Closed());
+    }
+}
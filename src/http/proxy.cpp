@@ -0,0 +1,566 @@
+#include "proxy.h"
+#include "request.h"
+#include "response.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+namespace ws::http {
+
+namespace {
+
+//! Headers that only apply to a single connection and are not forwarded.
+constexpr std::array<std::string_view, 5> hop_by_hop_headers {
+    "Connection", "Keep-Alive", "Proxy-Connection", "TE", "Upgrade"};
+
+constexpr std::string_view forwarded_for_header {"X-Forwarded-For"};
+
+/**
+ * @brief Take the next line of a string.
+ *
+ * @return The line without its line ending.
+ */
+std::string_view TakeLine(std::string_view& str) noexcept {
+    const auto lf {std::min(str.find('\n'), str.size())};
+    auto line {str.substr(0, lf)};
+    str.remove_prefix(std::min(lf + 1, str.size()));
+    if (line.ends_with('\r')) {
+        line.remove_suffix(1);
+    }
+
+    return line;
+}
+
+/**
+ * @brief Get the values of @p Connection headers.
+ *
+ * @param fields Header fields after the start line.
+ */
+std::vector<std::string_view> ConnectionOptions(
+    std::string_view fields) noexcept {
+    std::vector<std::string_view> options;
+    while (!fields.empty()) {
+        const auto line {TakeLine(fields)};
+        if (line.empty()) {
+            break;
+        }
+
+        const auto colon {std::min(line.find(':'), line.size())};
+        if (EqualsIgnoreCase(line.substr(0, colon), "Connection")) {
+            options.push_back(TrimWhitespace(line.substr(colon + 1)));
+        }
+    }
+
+    return options;
+}
+
+/**
+ * @brief Whether a header only applies to a single connection.
+ *
+ * @details
+ * Besides well-known hop-by-hop headers,
+ * the @p Connection header can list more of them (RFC 9110 §7.6.1).
+ * Framing headers are never removed, as the message could not be read without them.
+ *
+ * @param options The values of @p Connection headers.
+ */
+bool IsHopByHopHeader(
+    const std::string_view name,
+    const std::span<const std::string_view> options) noexcept {
+    if (std::ranges::any_of(hop_by_hop_headers,
+                            [name](const std::string_view header) noexcept {
+                                return EqualsIgnoreCase(name, header);
+                            })) {
+        return true;
+    } else if (EqualsIgnoreCase(name, "Content-Length")
+               || EqualsIgnoreCase(name, "Transfer-Encoding")) {
+        return false;
+    } else {
+        return std::ranges::any_of(
+            options, [name](const std::string_view option) noexcept {
+                return HasToken(option, name);
+            });
+    }
+}
+
+std::invalid_argument MalformedResponse(const std::string_view reason) {
+    return std::invalid_argument {
+        fmt::format("Malformed upstream response: {}", reason)};
+}
+
+//! Parse an unsigned integer that must take up the whole string.
+std::size_t ParseSize(const std::string_view str, const int base = 10) {
+    std::size_t size {0};
+    const auto end {str.data() + str.size()};
+    if (const auto [ptr, ec] {std::from_chars(str.data(), end, size, base)};
+        str.empty() || ec != std::errc {} || ptr != end) {
+        throw MalformedResponse(fmt::format("Invalid size '{}'", str));
+    }
+
+    return size;
+}
+
+//! Get the IP address of an upstream server.
+const IPAddr& ToIPAddr(const UpstreamAddr& addr) noexcept {
+    return std::visit(
+        [](const auto& ip) noexcept -> const IPAddr& { return ip; }, addr);
+}
+
+}  // namespace
+
+UpstreamAddr ParseUpstream(const std::string_view addr) {
+    const auto colon {addr.rfind(':')};
+    if (colon == std::string_view::npos) {
+        throw std::invalid_argument {
+            fmt::format("The upstream server '{}' has no port", addr)};
+    }
+
+    // An IPv6 address is in brackets, since it contains colons.
+    auto ip {addr.substr(0, colon)};
+    const auto ipv6 {ip.starts_with('[')};
+    if (ipv6) {
+        if (!ip.ends_with(']')) {
+            throw std::invalid_argument {fmt::format(
+                "The upstream server '{}' has an unclosed bracket", addr)};
+        }
+
+        ip = ip.substr(1, ip.size() - 2);
+    } else if (ip.find(':') != std::string_view::npos) {
+        throw std::invalid_argument {fmt::format(
+            "The IPv6 upstream server '{}' must be in brackets", addr)};
+    }
+
+    std::uint16_t port {0};
+    const auto port_str {addr.substr(colon + 1)};
+    const auto end {port_str.data() + port_str.size()};
+    if (const auto [ptr, ec] {std::from_chars(port_str.data(), end, port)};
+        ec != std::errc {} || ptr != end || port == 0) {
+        throw std::invalid_argument {fmt::format(
+            "The upstream server '{}' has an invalid port", addr)};
+    }
+
+    try {
+        if (ipv6) {
+            return IPv6Addr {std::string {ip}, port};
+        } else {
+            return IPv4Addr {std::string {ip}, port};
+        }
+    } catch (const std::system_error&) {
+        throw std::invalid_argument {fmt::format(
+            "The upstream server '{}' is not an IP address", addr)};
+    }
+}
+
+void RoutingTable::Add(std::string prefix,
+                       std::optional<UpstreamAddr> upstream) {
+    if (!prefix.starts_with('/')) {
+        throw std::invalid_argument {
+            fmt::format("The route '{}' does not start with '/'", prefix)};
+    }
+
+    if (std::ranges::any_of(routes_, [&prefix](const Route& route) noexcept {
+            return route.prefix == prefix;
+        })) {
+        throw std::invalid_argument {
+            fmt::format("The route '{}' has been added", prefix)};
+    }
+
+    std::optional<std::size_t> idx;
+    if (upstream.has_value()) {
+        // Routes to the same server share its upstream connections.
+        const auto& new_addr {ToIPAddr(upstream.value())};
+        const auto same {std::ranges::find_if(
+            upstreams_, [&new_addr](const UpstreamAddr& upstream) noexcept {
+                const auto& addr {ToIPAddr(upstream)};
+                return addr.Version() == new_addr.Version()
+                       && addr.IPAddress() == new_addr.IPAddress()
+                       && addr.Port() == new_addr.Port();
+            })};
+        idx = same - upstreams_.begin();
+        if (same == upstreams_.end()) {
+            upstreams_.push_back(std::move(upstream).value());
+        }
+    }
+
+    // Keep longer prefixes first, so the first match is the longest.
+    const auto pos {std::ranges::find_if(
+        routes_, [&prefix](const Route& route) noexcept {
+            return route.prefix.size() < prefix.size();
+        })};
+    routes_.insert(pos, {.prefix = std::move(prefix), .upstream = idx});
+}
+
+std::optional<std::size_t> RoutingTable::Match(
+    const std::string_view path) const noexcept {
+    for (const auto& route : routes_) {
+        if (path.starts_with(route.prefix)) {
+            return route.upstream;
+        }
+    }
+
+    return std::nullopt;
+}
+
+const IPAddr& RoutingTable::Upstream(const std::size_t idx) const noexcept {
+    assert(idx < upstreams_.size());
+    return ToIPAddr(upstreams_[idx]);
+}
+
+std::size_t RoutingTable::UpstreamCount() const noexcept {
+    return upstreams_.size();
+}
+
+void ProxyExchange::WriteRequest(std::string_view request,
+                                 const std::string_view forwarded_for,
+                                 Buffer& buf) {
+    buf.Append(TakeLine(request), NewLine::CRLF);
+
+    const auto options {ConnectionOptions(request)};
+    std::string_view forwarded;
+    auto chunked {false};
+    while (!request.empty()) {
+        const auto line {TakeLine(request)};
+        if (line.empty()) {
+            break;
+        }
+
+        const auto colon {std::min(line.find(':'), line.size())};
+        const auto name {line.substr(0, colon)};
+        if (IsHopByHopHeader(name, options)) {
+            continue;
+        } else if (EqualsIgnoreCase(name, forwarded_for_header)) {
+            forwarded = TrimWhitespace(line.substr(colon + 1));
+            continue;
+        } else if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked = true;
+            continue;
+        }
+
+        buf.Append(line, NewLine::CRLF);
+    }
+
+    // A chunked body has been decoded in place by the parser.
+    if (chunked) {
+        buf.Append(fmt::format("Content-Length: {}", request.size()),
+                   NewLine::CRLF);
+    }
+
+    buf.Append("Connection: keep-alive", NewLine::CRLF);
+    buf.Append(fmt::format("{}: {}{}{}", forwarded_for_header, forwarded,
+                           forwarded.empty() ? "" : ", ", forwarded_for),
+               NewLine::CRLF);
+    buf.Append("", NewLine::CRLF);
+
+    // The rest is the body.
+    buf.Append(request);
+}
+
+bool ProxyExchange::Forward(ChunkedBuffer& data, Buffer& buf,
+                            bool& keep_alive, const bool closed) {
+    while (true) {
+        switch (state_) {
+            case State::Header: {
+                if (!ForwardHeader(data, buf, keep_alive)) {
+                    break;
+                }
+
+                continue;
+            }
+            case State::Body:
+            case State::ChunkData: {
+                ForwardContent(data, buf);
+                if (remaining_ > 0) {
+                    break;
+                }
+
+                state_ = state_ == State::Body ? State::Finished
+                                               : State::ChunkEnd;
+                continue;
+            }
+            case State::ChunkSize:
+            case State::ChunkEnd:
+            case State::Trailer: {
+                if (!ForwardChunkLine(data, buf)) {
+                    break;
+                }
+
+                continue;
+            }
+            case State::UntilClose: {
+                ForwardContent(data, buf);
+                if (!closed) {
+                    break;
+                }
+
+                state_ = State::Finished;
+                continue;
+            }
+            case State::Finished: {
+                if (data.ReadableSize() > 0) {
+                    // Data beyond the response means the connection is out of sync.
+                    data.Clear();
+                    reusable_ = false;
+                }
+
+                return true;
+            }
+            default: {
+                assert(false);
+                break;
+            }
+        }
+
+        if (closed) {
+            throw MalformedResponse("The connection was closed early");
+        }
+
+        return false;
+    }
+}
+
+bool ProxyExchange::ForwardHeader(ChunkedBuffer& data, Buffer& buf,
+                                  bool& keep_alive) {
+    // The header may span chunks, so it is copied out of the buffer.
+    const auto end {Receive(data, "\r\n\r\n", max_header_size)};
+    if (!end.has_value()) {
+        if (data.ReadableSize() > max_header_size) {
+            throw MalformedResponse("The header is too large");
+        }
+
+        return false;
+    }
+
+    auto header {std::string_view {received_}.substr(0, end.value())};
+    const auto status_line {TakeLine(header)};
+
+    // The status line is `HTTP/1.x <code> <reason>`.
+    static constexpr std::string_view version_prefix {"HTTP/1."};
+    if (!status_line.starts_with(version_prefix)
+        || status_line.size() < version_prefix.size() + 5
+        || status_line[version_prefix.size() + 1] != ' ') {
+        throw MalformedResponse(
+            fmt::format("Invalid status line '{}'", status_line));
+    }
+
+    status_ = static_cast<std::uint32_t>(
+        ParseSize(status_line.substr(version_prefix.size() + 2, 3)));
+    if (status_ == 101) {
+        throw MalformedResponse("Protocol upgrades are not supported");
+    }
+
+    // An HTTP/1.0 server closes the connection unless it is asked to keep it.
+    auto close {status_line[version_prefix.size()] == '0'};
+    auto chunked {false};
+    std::optional<std::size_t> length;
+
+    const auto options {ConnectionOptions(header)};
+    buf.Append(status_line, NewLine::CRLF);
+    while (true) {
+        const auto line {TakeLine(header)};
+        if (line.empty()) {
+            break;
+        }
+
+        const auto colon {line.find(':')};
+        if (colon == std::string_view::npos) {
+            throw MalformedResponse(fmt::format("Invalid header '{}'", line));
+        }
+
+        const auto name {line.substr(0, colon)};
+        const auto value {TrimWhitespace(line.substr(colon + 1))};
+        if (EqualsIgnoreCase(name, "Connection")) {
+            if (HasToken(value, "close")) {
+                close = true;
+            } else if (HasToken(value, "keep-alive")) {
+                close = false;
+            }
+        } else if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked = HasToken(value, "chunked");
+        } else if (EqualsIgnoreCase(name, "Content-Length")) {
+            length = ParseSize(value);
+        }
+
+        if (!IsHopByHopHeader(name, options)) {
+            buf.Append(line, NewLine::CRLF);
+        }
+    }
+
+    Consume(data, end.value());
+    started_ = true;
+
+    if (status_ >= 100 && status_ < 200) {
+        // An interim response is followed by another header.
+        buf.Append("", NewLine::CRLF);
+        return true;
+    }
+
+    if (status_ == 204 || status_ == 304) {
+        state_ = State::Finished;
+    } else if (chunked) {
+        state_ = State::ChunkSize;
+    } else if (length.has_value()) {
+        remaining_ = length.value();
+        state_ = remaining_ > 0 ? State::Body : State::Finished;
+    } else {
+        // The body ends when the connection is closed,
+        // so the client connection must be closed to tell the client where the response ends.
+        state_ = State::UntilClose;
+        close = true;
+        keep_alive = false;
+    }
+
+    reusable_ = !close;
+
+    buf.Append("Connection: ");
+    if (keep_alive) {
+        buf.Append("keep-alive", NewLine::CRLF);
+        if (const auto timeout {Response::GetKeepAliveTimeout()};
+            timeout > std::chrono::seconds::zero()) {
+            buf.Append(fmt::format("Keep-alive: timeout={}", timeout.count()),
+                       NewLine::CRLF);
+        }
+    } else {
+        buf.Append("close", NewLine::CRLF);
+    }
+
+    buf.Append("", NewLine::CRLF);
+    return true;
+}
+
+bool ProxyExchange::ForwardChunkLine(ChunkedBuffer& data, Buffer& buf) {
+    const auto end {Receive(data, "\n", max_chunk_line_size + 1)};
+    if (!end.has_value()) {
+        if (data.ReadableSize() > max_chunk_line_size) {
+            throw MalformedResponse("The chunk line is too large");
+        }
+
+        return false;
+    }
+
+    std::string_view rest {received_};
+    const auto line {TakeLine(rest)};
+    switch (state_) {
+        case State::ChunkSize: {
+            // Chunk extensions follow the size after a semicolon.
+            const auto size {TrimWhitespace(line.substr(0, line.find(';')))};
+            remaining_ = ParseSize(size, 16);
+            state_ = remaining_ > 0 ? State::ChunkData : State::Trailer;
+            break;
+        }
+        case State::ChunkEnd: {
+            if (!line.empty()) {
+                throw MalformedResponse("A chunk is longer than its size");
+            }
+
+            state_ = State::ChunkSize;
+            break;
+        }
+        case State::Trailer: {
+            if (line.empty()) {
+                state_ = State::Finished;
+            }
+
+            break;
+        }
+        default: {
+            assert(false);
+            break;
+        }
+    }
+
+    buf.Append(line, NewLine::CRLF);
+    Consume(data, end.value());
+    return true;
+}
+
+void ProxyExchange::ForwardContent(ChunkedBuffer& data, Buffer& buf) noexcept {
+    const auto size {state_ == State::UntilClose
+                         ? data.ReadableSize()
+                         : std::min(remaining_, data.ReadableSize())};
+
+    // The content is appended chunk by chunk without making it contiguous first.
+    for (auto remaining {size}; remaining > 0;) {
+        std::array<std::span<const std::byte>, 0x10> segments;
+        const auto count {data.ReadableSegments(segments)};
+        std::size_t appended {0};
+        for (std::size_t i {0}; i != count && appended != remaining; ++i) {
+            const auto segment {
+                segments[i].first(std::min(remaining - appended, segments[i].size()))};
+            buf.Append(segment);
+            appended += segment.size();
+        }
+
+        data.Retrieve(appended);
+        remaining -= appended;
+    }
+
+    if (state_ != State::UntilClose) {
+        remaining_ -= size;
+    }
+}
+
+std::optional<std::size_t> ProxyExchange::Receive(
+    const ChunkedBuffer& data, const std::string_view delimiter,
+    const std::size_t max_size) {
+    assert(!delimiter.empty());
+    if (received_.size() < max_size) {
+        received_.append(data.ReadableString(received_.size(),
+                                             max_size - received_.size()));
+    }
+
+    // A delimiter may span old and new data.
+    const auto from {scanned_ >= delimiter.size() - 1
+                         ? scanned_ - (delimiter.size() - 1)
+                         : 0};
+    if (const auto pos {received_.find(delimiter, from)};
+        pos != std::string::npos) {
+        return pos + delimiter.size();
+    }
+
+    scanned_ = received_.size();
+    return std::nullopt;
+}
+
+void ProxyExchange::Consume(ChunkedBuffer& data,
+                            const std::size_t size) noexcept {
+    data.Retrieve(size);
+
+    // Copied data beyond the header or the line may be retrieved as content, so it is discarded.
+    received_.clear();
+    scanned_ = 0;
+}
+
+bool ProxyExchange::Started() const noexcept {
+    return started_;
+}
+
+bool ProxyExchange::Reusable() const noexcept {
+    return reusable_ && state_ == State::Finished;
+}
+
+std::uint32_t ProxyExchange::Status() const noexcept {
+    return status_;
+}
+
+void ProxyExchange::Clear() noexcept {
+    state_ = State::Header;
+    status_ = 0;
+    remaining_ = 0;
+    received_.clear();
+    scanned_ = 0;
+    started_ = false;
+    reusable_ = false;
+}
+
+}  // namespace ws::http
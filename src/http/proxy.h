@@ -0,0 +1,151 @@
+/**
+ * @file proxy.h
+ * @brief The exchange of requests and responses with upstream servers of the reverse proxy.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-08-01
+ *
+ * @example src/http/proxy_test.cpp
+ */
+
+#pragma once
+
+#include "containers/buffer.h"
+#include "containers/chunked_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+namespace ws::http {
+
+/**
+ * @brief The exchange of a request forwarded to an upstream server and its response.
+ *
+ * @details
+ * The response is forwarded to the client while it is being received,
+ * so its body is never buffered as a whole.
+ * Only its header is rewritten, replacing hop-by-hop headers with the client connection's own ones.
+ * The body is forwarded byte by byte, and its framing is tracked to find where the response ends,
+ * so the upstream connection can be reused for another request.
+ */
+class ProxyExchange {
+public:
+    //! The maximum size of a response header.
+    static constexpr std::size_t max_header_size {0x10000};
+
+    //! The maximum size of a line that frames a chunk.
+    static constexpr std::size_t max_chunk_line_size {0x400};
+
+    /**
+     * @brief Serialize a request for an upstream server.
+     *
+     * @details
+     * Hop-by-hop headers, including those listed in @p Connection, are removed.
+     * The request asks for a persistent connection and carries the client's address in @p X-Forwarded-For.
+     * A chunked body is sent with @p Content-Length instead of @p Transfer-Encoding.
+     *
+     * @param request A complete and valid request, whose chunked body has been decoded by @p Request.
+     * @param forwarded_for The address of the client.
+     * @param[out] buf An output buffer.
+     */
+    static void WriteRequest(std::string_view request,
+                             std::string_view forwarded_for, Buffer& buf);
+
+    /**
+     * @brief Forward received data of the response to the client.
+     *
+     * @param[in, out] data
+     * Received data. Forwarded bytes are retrieved from it.
+     * It must be the same buffer during the exchange and only be retrieved by the exchange.
+     * @param[out] buf The client's writing buffer.
+     * @param[in, out] keep_alive
+     * Whether the client connection keeps alive.
+     * It is cleared if the response ends by closing the upstream connection.
+     * @param closed Whether the upstream server has closed the connection.
+     * @return Whether the response has been forwarded entirely.
+     *
+     * @exception std::invalid_argument
+     * The response is malformed, or the connection was closed before the response ended.
+     */
+    bool Forward(ChunkedBuffer& data, Buffer& buf, bool& keep_alive,
+                 bool closed);
+
+    //! Whether any part of the response has been forwarded to the client.
+    bool Started() const noexcept;
+
+    //! Whether the upstream connection can be reused for another request after the response.
+    bool Reusable() const noexcept;
+
+    //! Get the status code of the response.
+    std::uint32_t Status() const noexcept;
+
+    //! Reset the exchange for a new request.
+    void Clear() noexcept;
+
+private:
+    enum class State {
+        Header,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkEnd,
+        Trailer,
+        UntilClose,
+        Finished
+    };
+
+    /**
+     * @brief Parse and forward the response header.
+     *
+     * @return Whether the header is complete.
+     */
+    bool ForwardHeader(ChunkedBuffer& data, Buffer& buf, bool& keep_alive);
+
+    //! Forward a line of chunk framing if it is complete.
+    bool ForwardChunkLine(ChunkedBuffer& data, Buffer& buf);
+
+    //! Forward at most the remaining bytes of a body or a chunk.
+    void ForwardContent(ChunkedBuffer& data, Buffer& buf) noexcept;
+
+    /**
+     * @brief Copy newly received data and find a delimiter in it.
+     *
+     * @details
+     * Only bytes that have not been scanned by previous calls are searched,
+     * so a header received in many small pieces is scanned once.
+     *
+     * @param max_size The maximum size of data to copy.
+     * @return The offset after the delimiter if it is found.
+     */
+    std::optional<std::size_t> Receive(const ChunkedBuffer& data,
+                                       std::string_view delimiter,
+                                       std::size_t max_size);
+
+    //! Retrieve a received header or line and discard copied data.
+    void Consume(ChunkedBuffer& data, std::size_t size) noexcept;
+
+    State state_ {State::Header};
+    std::uint32_t status_ {0};
+
+    //! The remaining size of the body or the current chunk.
+    std::size_t remaining_ {0};
+
+    //! Data copied from the beginning of received data when looking for a header or a line.
+    std::string received_;
+
+    //! The size of copied data that has been scanned.
+    std::size_t scanned_ {0};
+
+    bool started_ {false};
+    bool reusable_ {false};
+};
+
+}  // namespace ws::http
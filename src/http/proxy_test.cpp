@@ -0,0 +1,322 @@
+#include "proxy.h"
+#include "response.h"
+#include "util.h"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+using namespace ws;
+using namespace ws::http;
+
+
+namespace {
+
+std::string ToString(const Buffer& buf) {
+    const auto bytes {buf.ReadableBytes()};
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+}  // namespace
+
+
+TEST(RoutingTableTest, Match) {
+    RoutingTable routes;
+    EXPECT_FALSE(routes.Match("/"));
+
+    routes.Add("/api/", ParseUpstream("127.0.0.1:8080"));
+    routes.Add("/api/static/", std::nullopt);
+    routes.Add("/admin/", ParseUpstream("127.0.0.1:8081"));
+    routes.Add("/v2/", ParseUpstream("127.0.0.1:8080"));
+
+    // Routes to the same server share an upstream.
+    EXPECT_EQ(routes.UpstreamCount(), 2);
+    EXPECT_EQ(routes.Match("/api/users?id=1"), 0);
+    EXPECT_EQ(routes.Match("/v2/users"), 0);
+    EXPECT_EQ(routes.Match("/admin/"), 1);
+    EXPECT_EQ(routes.Upstream(1).Port(), 8081);
+
+    // Servers of different IP versions differ.
+    routes.Add("/v6/", ParseUpstream("[::1]:8080"));
+    EXPECT_EQ(routes.UpstreamCount(), 3);
+    EXPECT_EQ(routes.Upstream(2).Version(), AF_INET6);
+
+    // The longest prefix decides, whatever the order of adding.
+    EXPECT_FALSE(routes.Match("/api/static/logo.png"));
+    EXPECT_FALSE(routes.Match("/index.html"));
+
+    EXPECT_THROW(routes.Add("/api/", std::nullopt), std::invalid_argument);
+    EXPECT_THROW(routes.Add("api/", std::nullopt), std::invalid_argument);
+}
+
+TEST(RoutingTableTest, ParseUpstream) {
+    const auto ipv4 {std::get<IPv4Addr>(ParseUpstream("127.0.0.1:8080"))};
+    EXPECT_EQ(ipv4.IPAddress(), "127.0.0.1");
+    EXPECT_EQ(ipv4.Port(), 8080);
+
+    const auto ipv6 {std::get<IPv6Addr>(ParseUpstream("[::1]:8080"))};
+    EXPECT_EQ(ipv6.IPAddress(), "::1");
+    EXPECT_EQ(ipv6.Port(), 8080);
+    EXPECT_THROW(ParseUpstream("::1:8080"), std::invalid_argument);
+    EXPECT_THROW(ParseUpstream("[::1:8080"), std::invalid_argument);
+    EXPECT_THROW(ParseUpstream("[127.0.0.1]:8080"), std::invalid_argument);
+
+    EXPECT_THROW(ParseUpstream("127.0.0.1"), std::invalid_argument);
+    EXPECT_THROW(ParseUpstream("127.0.0.1:0"), std::invalid_argument);
+    EXPECT_THROW(ParseUpstream("127.0.0.1:65536"), std::invalid_argument);
+    EXPECT_THROW(ParseUpstream("localhost:8080"), std::invalid_argument);
+}
+
+TEST(ProxyExchangeTest, WriteRequest) {
+    Buffer buf;
+    ProxyExchange::WriteRequest("POST /api HTTP/1.1\r\n"
+                                "Host: example.com\r\n"
+                                "Connection: close\r\n"
+                                "Keep-Alive: timeout=5\r\n"
+                                "X-Forwarded-For: 10.0.0.1\r\n"
+                                "Content-Length: 4\r\n"
+                                "\r\n"
+                                "body",
+                                "127.0.0.1", buf);
+    EXPECT_EQ(ToString(buf), "POST /api HTTP/1.1\r\n"
+                             "Host: example.com\r\n"
+                             "Content-Length: 4\r\n"
+                             "Connection: keep-alive\r\n"
+                             "X-Forwarded-For: 10.0.0.1, 127.0.0.1\r\n"
+                             "\r\n"
+                             "body");
+
+    // A decoded chunked body is sent with its length.
+    buf.RetrieveAll();
+    ProxyExchange::WriteRequest("POST / HTTP/1.1\r\n"
+                                "Transfer-Encoding: chunked\r\n"
+                                "\r\n"
+                                "body",
+                                "127.0.0.1", buf);
+    EXPECT_EQ(ToString(buf), "POST / HTTP/1.1\r\n"
+                             "Content-Length: 4\r\n"
+                             "Connection: keep-alive\r\n"
+                             "X-Forwarded-For: 127.0.0.1\r\n"
+                             "\r\n"
+                             "body");
+
+    // Headers listed in `Connection` are removed, except framing headers.
+    buf.RetrieveAll();
+    ProxyExchange::WriteRequest("POST / HTTP/1.1\r\n"
+                                "Connection: X-Secret, content-length\r\n"
+                                "x-secret: 1\r\n"
+                                "Connection: Foo\r\n"
+                                "Foo: 2\r\n"
+                                "X-Public: 3\r\n"
+                                "Content-Length: 4\r\n"
+                                "\r\n"
+                                "body",
+                                "127.0.0.1", buf);
+    EXPECT_EQ(ToString(buf), "POST / HTTP/1.1\r\n"
+                             "X-Public: 3\r\n"
+                             "Content-Length: 4\r\n"
+                             "Connection: keep-alive\r\n"
+                             "X-Forwarded-For: 127.0.0.1\r\n"
+                             "\r\n"
+                             "body");
+
+    // Bare line feeds are accepted.
+    buf.RetrieveAll();
+    ProxyExchange::WriteRequest("GET / HTTP/1.1\nHost: a\n\n", "127.0.0.1",
+                                buf);
+    EXPECT_EQ(ToString(buf), "GET / HTTP/1.1\r\n"
+                             "Host: a\r\n"
+                             "Connection: keep-alive\r\n"
+                             "X-Forwarded-For: 127.0.0.1\r\n"
+                             "\r\n");
+}
+
+TEST(ProxyExchangeTest, ForwardContentLength) {
+    const RAII raii {Response::GetKeepAliveTimeout(),
+                           [](const auto timeout) noexcept {
+                               Response::SetKeepAliveTimeout(timeout);
+                           }};
+    Response::SetKeepAliveTimeout(std::chrono::seconds {5});
+
+    ProxyExchange exchange;
+    ChunkedBuffer data;
+    Buffer buf;
+    auto keep_alive {true};
+
+    // The header is forwarded only when it is complete.
+    data.Append(
+        "HTTP/1.1 201 Created\r\nConnection: keep-alive, X-Hop\r\n"
+        "X-Hop: 1\r\nContent-");
+    EXPECT_FALSE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_FALSE(exchange.Started());
+    EXPECT_EQ(buf.ReadableSize(), 0);
+
+    data.Append("Length: 10\r\n\r\nhello");
+    EXPECT_FALSE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_TRUE(exchange.Started());
+    EXPECT_EQ(data.ReadableSize(), 0);
+    EXPECT_EQ(ToString(buf), "HTTP/1.1 201 Created\r\n"
+                             "Content-Length: 10\r\n"
+                             "Connection: keep-alive\r\n"
+                             "Keep-alive: timeout=5\r\n"
+                             "\r\n"
+                             "hello");
+
+    // The body is streamed as it arrives.
+    buf.RetrieveAll();
+    data.Append("world");
+    EXPECT_TRUE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_EQ(ToString(buf), "world");
+    EXPECT_EQ(exchange.Status(), 201);
+    EXPECT_TRUE(exchange.Reusable());
+    EXPECT_TRUE(keep_alive);
+}
+
+TEST(ProxyExchangeTest, ForwardChunked) {
+    ProxyExchange exchange;
+    ChunkedBuffer data;
+    Buffer buf;
+    auto keep_alive {false};
+
+    constexpr std::string_view body {"4\r\nWiki\r\n"
+                                     "5;ext=1\r\npedia\r\n"
+                                     "0\r\n"
+                                     "Trailer: 1\r\n"
+                                     "\r\n"};
+    data.Append("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+
+    // Feed the body byte by byte.
+    for (std::size_t i {0}; i + 1 < body.size(); ++i) {
+        data.Append(body.substr(i, 1));
+        ASSERT_FALSE(exchange.Forward(data, buf, keep_alive, false)) << i;
+    }
+
+    data.Append(body.substr(body.size() - 1));
+    EXPECT_TRUE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_EQ(ToString(buf), std::string {"HTTP/1.1 200 OK\r\n"
+                                          "Transfer-Encoding: chunked\r\n"
+                                          "Connection: close\r\n"
+                                          "\r\n"}
+                                 + std::string {body});
+    EXPECT_TRUE(exchange.Reusable());
+
+    // Malformed chunks are rejected.
+    exchange.Clear();
+    data.Clear();
+    data.Append("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "2\r\nabc\r\n");
+    EXPECT_THROW(exchange.Forward(data, buf, keep_alive, false),
+                 std::invalid_argument);
+}
+
+TEST(ProxyExchangeTest, ForwardAcrossChunks) {
+    // Small chunks make the header, the chunk lines and the body span many of them.
+    ChunkAllocator allocator {4};
+    ProxyExchange exchange;
+    ChunkedBuffer data {allocator};
+    Buffer buf;
+    auto keep_alive {false};
+
+    const std::string body(0x100, 'a');
+    const auto response {fmt::format("HTTP/1.1 200 OK\r\n"
+                                     "Transfer-Encoding: chunked\r\n"
+                                     "\r\n"
+                                     "{:x}\r\n{}\r\n"
+                                     "0\r\n"
+                                     "\r\n",
+                                     body.size(), body)};
+    // Feed the response byte by byte, after an interim response.
+    const auto interim {std::string {"HTTP/1.1 100 Continue\r\n\r\n"}
+                        + response};
+    for (std::size_t i {0}; i + 1 < interim.size(); ++i) {
+        data.Append(std::string_view {interim}.substr(i, 1));
+        ASSERT_FALSE(exchange.Forward(data, buf, keep_alive, false)) << i;
+    }
+
+    data.Append(std::string_view {interim}.substr(interim.size() - 1));
+    EXPECT_TRUE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_TRUE(exchange.Reusable());
+    EXPECT_TRUE(data.Empty());
+    EXPECT_EQ(ToString(buf).substr(0, 25), "HTTP/1.1 100 Continue\r\n\r\n");
+    buf.Retrieve(25);
+    EXPECT_EQ(ToString(buf), fmt::format("HTTP/1.1 200 OK\r\n"
+                                         "Transfer-Encoding: chunked\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n"
+                                         "{:x}\r\n{}\r\n"
+                                         "0\r\n"
+                                         "\r\n",
+                                         body.size(), body));
+
+    // Forwarded chunks are released.
+    EXPECT_LE(data.ChunkCount(), 1);
+}
+
+TEST(ProxyExchangeTest, ForwardUntilClose) {
+    ProxyExchange exchange;
+    ChunkedBuffer data;
+    Buffer buf;
+    auto keep_alive {true};
+
+    data.Append("HTTP/1.0 200 OK\r\n\r\nhello");
+    EXPECT_FALSE(exchange.Forward(data, buf, keep_alive, false));
+
+    // The client connection is closed to end the response.
+    EXPECT_FALSE(keep_alive);
+    EXPECT_EQ(ToString(buf), "HTTP/1.0 200 OK\r\nConnection: close\r\n\r\nhello");
+
+    EXPECT_TRUE(exchange.Forward(data, buf, keep_alive, true));
+    EXPECT_FALSE(exchange.Reusable());
+}
+
+TEST(ProxyExchangeTest, ForwardWithoutBody) {
+    ProxyExchange exchange;
+    ChunkedBuffer data;
+    Buffer buf;
+    auto keep_alive {true};
+
+    // An interim response is followed by the final one.
+    data.Append("HTTP/1.1 100 Continue\r\n\r\n"
+                "HTTP/1.1 304 Not Modified\r\nETag: \"1\"\r\n\r\n");
+    EXPECT_TRUE(exchange.Forward(data, buf, keep_alive, false));
+    EXPECT_EQ(exchange.Status(), 304);
+    EXPECT_TRUE(exchange.Reusable());
+    EXPECT_EQ(ToString(buf), "HTTP/1.1 100 Continue\r\n\r\n"
+                             "HTTP/1.1 304 Not Modified\r\n"
+                             "ETag: \"1\"\r\n"
+                             "Connection: keep-alive\r\n"
+                             + fmt::format("Keep-alive: timeout={}\r\n",
+                                           Response::GetKeepAliveTimeout()
+                                               .count())
+                             + "\r\n");
+}
+
+TEST(ProxyExchangeTest, Malformed) {
+    Buffer buf;
+    auto keep_alive {true};
+    for (const std::string_view response :
+         {"HTTP/2 200 OK\r\n\r\n", "HTTP/1.1 abc OK\r\n\r\n",
+          "HTTP/1.1 101 Switching Protocols\r\n\r\n",
+          "HTTP/1.1 200 OK\r\nContent-Length: x\r\n\r\n",
+          "HTTP/1.1 200 OK\r\nInvalid\r\n\r\n"}) {
+        ProxyExchange exchange;
+        ChunkedBuffer data;
+        data.Append(response);
+        EXPECT_THROW(exchange.Forward(data, buf, keep_alive, false),
+                     std::invalid_argument)
+            << response;
+    }
+
+    // The connection is closed before the response ends.
+    ProxyExchange exchange;
+    ChunkedBuffer data;
+    data.Append("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhello");
+    EXPECT_THROW(exchange.Forward(data, buf, keep_alive, true),
+                 std::invalid_argument);
+    EXPECT_TRUE(exchange.Started());
+    EXPECT_FALSE(exchange.Reusable());
+}
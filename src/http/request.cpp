@@ -1,160 +1,485 @@
 #include "request.h"
+#include "containers/perfect_hash_map.h"
+#include "url_encoding.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cassert>
-#include <regex>
+#include <charconv>
+#include <cstring>
+#include <span>
 #include <stdexcept>
 
 
 namespace ws::http {
 
-//! The interface of parsing state.
-class Request::State {
-public:
-    explicit State(Request& parser) noexcept : parser_ {parser} {}
-
-    virtual ~State() noexcept = default;
-
-    virtual void Parse(const std::string& content) = 0;
-
-protected:
-    Request& parser_;
-};
-
-//! The parsing has not started yet.
-class NotStarted : public Request::State {
-public:
-    using State::State;
-
-    /**
-     * @brief Parse the HTTP status line.
-     *
-     * @exception std::invalid_argument The HTTP status line is invalid.
-     */
-    void Parse(const std::string& line) override {
-        ParseStatusLine(line);
-    }
-
-private:
-    void ParseStatusLine(const std::string& line);
-};
-
-//! The parser is processing HTTP headers.
-class Header : public Request::State {
-public:
-    using State::State;
-
-    /**
-     * @brief Parse an HTTP header.
-     *
-     * @exception std::invalid_argument No empty line between HTTP headers and the body.
-     */
-    void Parse(const std::string& line) override;
-};
-
-//! The parser is processing the HTTP body.
-class Body : public Request::State {
-public:
-    using State::State;
-
-    /**
-     * @brief Parse the HTTP body.
-     *
-     * @exception std::invalid_argument Unsupported HTTP method.
-     */
-    void Parse(const std::string& body) override;
-
-private:
-    /**
-     * @brief Parse an HTTP @p POST body.
-     *
-     * @exception std::invalid_argument Unsupported HTTP content type.
-     */
-    void ParsePost(const std::string& body);
-
-    /**
-     * @brief
-     * Parse an HTTP @p POST body with content type @p application/x-www-form-urlencoded.
-     *
-     * @exception std::invalid_argument Invalid HTTP @p POST data.
-     */
-    void ParseURLEncodedPost(const std::string& body);
-};
-
-//! The parsing has finished.
-class Finished : public Request::State {
-public:
-    using State::State;
-
-    //! Throw a @p std::invalid_argument exception because the parsing shoud have finished.
-    [[noreturn]] void Parse(const std::string& content) override {
-        throw std::invalid_argument {"The parsing shoud have finished"};
-    }
-};
+namespace {
 
-Request::Request() noexcept = default;
+//! Whether a character can be used in an HTTP token, such as a header name.
+constexpr bool IsTokenCharacter(const char c) noexcept {
+    constexpr std::string_view symbols {"!#$%&'*+-.^_`|~"};
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+           || (c >= 'A' && c <= 'Z') || symbols.find(c) != std::string_view::npos;
+}
+
+//! Whether a string is a valid HTTP token.
+constexpr bool IsToken(const std::string_view str) noexcept {
+    return !str.empty() && std::ranges::all_of(str, IsTokenCharacter);
+}
+
+constexpr auto known_headers {MakePerfectHashMap<KnownHeader>({
+    {"Host", KnownHeader::Host},
+    {"Connection", KnownHeader::Connection},
+    {"Content-Length", KnownHeader::ContentLength},
+    {"Content-Type", KnownHeader::ContentType},
+    {"Transfer-Encoding", KnownHeader::TransferEncoding},
+    {"Expect", KnownHeader::Expect},
+    {"Upgrade", KnownHeader::Upgrade},
+    {"Accept", KnownHeader::Accept},
+    {"Accept-Encoding", KnownHeader::AcceptEncoding},
+    {"Accept-Language", KnownHeader::AcceptLanguage},
+    {"If-None-Match", KnownHeader::IfNoneMatch},
+    {"If-Modified-Since", KnownHeader::IfModifiedSince},
+    {"If-Range", KnownHeader::IfRange},
+    {"Range", KnownHeader::Range},
+    {"Cache-Control", KnownHeader::CacheControl},
+    {"Cookie", KnownHeader::Cookie},
+    {"Referer", KnownHeader::Referer},
+    {"User-Agent", KnownHeader::UserAgent},
+})};
+
+static_assert(known_headers.Size() == known_header_count);
+
+}  // namespace
+
+RequestTooLarge::RequestTooLarge(const StatusCode status, const std::string& msg) :
+    std::invalid_argument {msg}, status_ {status} {}
+
+StatusCode RequestTooLarge::Status() const noexcept {
+    return status_;
+}
 
-Request::~Request() noexcept = default;
+std::optional<KnownHeader> ToKnownHeader(const std::string_view name) noexcept {
+    return known_headers.Find(name);
+}
+
+Request::Request() noexcept = default;
 
 Request::Request(Buffer& buf) {
     Parse(buf);
 }
 
-void Request::Parse(Buffer& buf) {
-    Clear();
-    if (buf.Empty()) {
-        throw std::invalid_argument {"The buffer is empty"};
-    }
+bool Request::Parse(Buffer& buf, const RequestLimits& limits) {
+    assert(!buf_ || buf_ == &buf);
+    buf_ = &buf;
+    limits_ = limits;
+
+    while (state_ != State::Finished) {
+        switch (state_) {
+            case State::NotStarted:
+            case State::Header: {
+                const auto line {ExtractLine()};
+                if (!line.has_value()) {
+                    // Reject an endless header without waiting for its end.
+                    CheckHeaderSize(buf.ReadableSize());
+                    if (state_ == State::Header) {
+                        CheckPartialHeader();
+                    }
+
+                    return false;
+                }
 
-    auto content {buf.ReadableString()};
-    while (!content.empty()) {
-        const auto line_end {content.find(new_line)};
-        const auto line {content.substr(0, line_end)};
+                CheckHeaderSize(offset_);
+                if (state_ == State::NotStarted) {
+                    ParseStatusLine(line.value());
+                } else {
+                    ParseHeader(line.value());
+                }
+
+                break;
+            }
+            case State::Body: {
+                assert(offset_ <= buf.ReadableSize());
+                if (buf.ReadableSize() - offset_ < content_length_) {
+                    return false;
+                }
 
-        assert(state_);
-        state_->Parse(line);
+                ParseBody({.offset = offset_, .length = content_length_});
+                offset_ += content_length_;
+                state_ = State::Finished;
+                break;
+            }
+            case State::ChunkSize:
+            case State::ChunkEnd:
+            case State::Trailer: {
+                const auto line {ExtractLine()};
+                if (!line.has_value()) {
+                    if (buf.ReadableSize() - offset_ > max_chunk_line_size) {
+                        throw std::invalid_argument {
+                            "The HTTP chunk line is too large"};
+                    }
+
+                    EraseChunkFraming();
+                    return false;
+                }
 
-        buf.Retrieve(line.length());
-        content = content.substr(line.length());
-        if (line_end != std::string::npos) {
-            content = content.substr(new_line.length());
-            buf.Retrieve(new_line.length());
+                ParseChunkLine(line.value());
+                break;
+            }
+            case State::ChunkData: {
+                if (!ParseChunkData()) {
+                    EraseChunkFraming();
+                    return false;
+                }
+
+                state_ = State::ChunkEnd;
+                break;
+            }
+            default: {
+                assert(false);
+                break;
+            }
         }
     }
+
+    return true;
 }
 
-void Request::SetState(std::unique_ptr<State> state) noexcept {
-    state_ = std::move(state);
+bool Request::Finished() const noexcept {
+    return state_ == State::Finished;
+}
+
+std::size_t Request::Size() const noexcept {
+    return offset_;
 }
 
 void Request::Clear() noexcept {
-    SetState(std::make_unique<NotStarted>(*this));
+    buf_ = nullptr;
+    state_ = State::NotStarted;
+    offset_ = 0;
+    content_length_ = 0;
+    header_count_ = 0;
+    chunk_remaining_ = 0;
+    body_offset_ = 0;
+    decoded_end_ = 0;
+    trailer_size_ = 0;
     method_ = Method::Get;
-    version_.clear();
-    path_.clear();
-    headers_.clear();
+    version_ = {};
+    path_ = {};
+    known_header_mask_ = 0;
+    other_headers_.clear();
+    post_body_ = {};
+    post_decoded_ = false;
     post_.clear();
 }
 
+std::string_view Request::View(const Range range) const noexcept {
+    assert(buf_);
+    const auto bytes {buf_->ReadableBytes()};
+    assert(range.offset + range.length <= bytes.size());
+    return {reinterpret_cast<const char*>(bytes.data()) + range.offset,
+            range.length};
+}
+
+std::optional<Request::Range> Request::ExtractLine() noexcept {
+    assert(buf_);
+    const auto bytes {buf_->ReadableBytes()};
+    assert(offset_ <= bytes.size());
+
+    // Bare line feeds are accepted, so the line ends at a line feed instead of `\r\n`.
+    const auto lf {buf_->Find('\n', offset_)};
+    if (!lf.has_value()) {
+        return std::nullopt;
+    }
+
+    Range line {.offset = offset_, .length = lf.value() - offset_};
+    if (line.length > 0
+        && bytes[line.offset + line.length - 1] == std::byte {'\r'}) {
+        --line.length;
+    }
+
+    offset_ = lf.value() + 1;
+    return line;
+}
+
+void Request::ParseStatusLine(const Range line) {
+    static constexpr std::string_view version_prefix {"HTTP/"};
+
+    const auto str {View(line)};
+
+    // Ignore empty lines before the status line.
+    if (str.empty()) {
+        return;
+    }
+
+    const auto invalid {[str]() {
+        return std::invalid_argument {
+            fmt::format("Invalid HTTP status line: '{}'", str)};
+    }};
+
+    // The form of a status line is "<method> <path> HTTP/<version>".
+    const auto method_end {str.find(' ')};
+    if (method_end == std::string_view::npos) {
+        throw invalid();
+    }
+
+    const auto path_begin {method_end + 1};
+    const auto path_end {str.find(' ', path_begin)};
+    if (path_end == std::string_view::npos) {
+        throw invalid();
+    }
+
+    const auto version {str.substr(path_end + 1)};
+    if (!version.starts_with(version_prefix)
+        || version.find(' ') != std::string_view::npos) {
+        throw invalid();
+    }
+
+    method_ = StringToMethod(str.substr(0, method_end));
+    path_ = {.offset = line.offset + path_begin,
+             .length = path_end - path_begin};
+    version_ = {.offset = line.offset + path_end + 1 + version_prefix.length(),
+                .length = version.length() - version_prefix.length()};
+    state_ = State::Header;
+}
+
+void Request::ParseHeader(const Range line) {
+    if (line.length == 0) {
+        FinishHeaders();
+        return;
+    }
+
+    CountHeader();
+    const auto str {View(line)};
+    const auto colon {str.find(':')};
+    if (colon == std::string_view::npos || !IsToken(str.substr(0, colon))) {
+        throw std::invalid_argument {
+            fmt::format("Invalid HTTP header: '{}'", str)};
+    }
+
+    const auto value {TrimWhitespace(str.substr(colon + 1))};
+    const auto value_offset {
+        value.empty() ? line.offset + line.length
+                      : line.offset + (value.data() - str.data())};
+    const Range value_range {.offset = value_offset, .length = value.length()};
+    if (const auto known {ToKnownHeader(str.substr(0, colon))};
+        known.has_value()) {
+        // Only the first one of repeated headers is kept.
+        const auto index {static_cast<std::size_t>(known.value())};
+        if (const auto bit {std::uint32_t {1} << index};
+            !(known_header_mask_ & bit)) {
+            known_headers_[index] = value_range;
+            known_header_mask_ |= bit;
+        }
+    } else {
+        other_headers_.push_back(
+            {.name = {.offset = line.offset, .length = colon},
+             .value = value_range});
+    }
+}
+
+void Request::CheckPartialHeader() const {
+    assert(buf_);
+    auto partial {
+        View({.offset = offset_, .length = buf_->ReadableSize() - offset_})};
+
+    // A carriage return may be the beginning of a line break.
+    if (partial.ends_with('\r')) {
+        partial.remove_suffix(1);
+    }
+
+    const auto name {partial.substr(0, partial.find(':'))};
+    if (!std::ranges::all_of(name, IsTokenCharacter)) {
+        throw std::invalid_argument {
+            "There must be an empty line between HTTP headers and the body"};
+    }
+}
+
+void Request::CheckHeaderSize(const std::size_t size) const {
+    if (limits_.max_header_size > 0 && size > limits_.max_header_size) {
+        throw RequestTooLarge {StatusCode::RequestHeaderFieldsTooLarge,
+                               "The HTTP header is too large"};
+    }
+}
+
+void Request::CountHeader() {
+    if (++header_count_ > limits_.max_header_count
+        && limits_.max_header_count > 0) {
+        throw RequestTooLarge {StatusCode::RequestHeaderFieldsTooLarge,
+                               "There are too many HTTP headers"};
+    }
+}
+
+void Request::FinishHeaders() {
+    content_length_ = 0;
+    body_offset_ = offset_;
+    decoded_end_ = offset_;
+    if (const auto encoding {Header(KnownHeader::TransferEncoding)};
+        encoding.has_value()) {
+        // Both headers may be used to smuggle another request through a proxy.
+        if (Header(KnownHeader::ContentLength).has_value()) {
+            throw std::invalid_argument {
+                "An HTTP request cannot have both Content-Length and "
+                "Transfer-Encoding"};
+        }
+
+        if (!EqualsIgnoreCase(TrimWhitespace(encoding.value()), "chunked")) {
+            throw std::invalid_argument {fmt::format(
+                "Unsupported HTTP transfer encoding: '{}'", encoding.value())};
+        }
+
+        state_ = State::ChunkSize;
+        return;
+    }
+
+    if (const auto length {Header(KnownHeader::ContentLength)}; length.has_value()) {
+        const auto str {length.value()};
+        if (const auto [end, err] {std::from_chars(
+                str.data(), str.data() + str.size(), content_length_)};
+            err != std::errc {} || end != str.data() + str.size()) {
+            throw std::invalid_argument {
+                fmt::format("Invalid HTTP content length: '{}'", str)};
+        }
+    }
+
+    // Reject a large body before receiving it.
+    if (limits_.max_body_size > 0 && content_length_ > limits_.max_body_size) {
+        throw RequestTooLarge {StatusCode::PayloadTooLarge,
+                               "The HTTP request body is too large"};
+    }
+
+    state_ = content_length_ > 0 ? State::Body : State::Finished;
+}
+
+void Request::ParseChunkLine(const Range line) {
+    const auto str {View(line)};
+    switch (state_) {
+        case State::ChunkSize: {
+            // Chunk extensions are ignored.
+            const auto size_str {TrimWhitespace(str.substr(0, str.find(';')))};
+            std::size_t size {0};
+            if (const auto [end, err] {std::from_chars(
+                    size_str.data(), size_str.data() + size_str.size(), size, 16)};
+                size_str.empty() || err != std::errc {}
+                || end != size_str.data() + size_str.size()) {
+                throw std::invalid_argument {
+                    fmt::format("Invalid HTTP chunk size: '{}'", str)};
+            }
+
+            if (limits_.max_body_size > 0
+                && size > limits_.max_body_size - (decoded_end_ - body_offset_)) {
+                throw RequestTooLarge {StatusCode::PayloadTooLarge,
+                                       "The HTTP request body is too large"};
+            }
+
+            chunk_remaining_ = size;
+            state_ = size > 0 ? State::ChunkData : State::Trailer;
+            break;
+        }
+        case State::ChunkEnd: {
+            if (!str.empty()) {
+                throw std::invalid_argument {
+                    "An HTTP chunk is longer than its size"};
+            }
+
+            state_ = State::ChunkSize;
+            break;
+        }
+        case State::Trailer: {
+            // Trailer fields are ignored until the empty line ending the body.
+            if (str.empty()) {
+                // The next request follows the decoded body once the framing is erased.
+                EraseChunkFraming();
+                ParseBody({.offset = body_offset_,
+                           .length = decoded_end_ - body_offset_});
+                state_ = State::Finished;
+            } else {
+                CountHeader();
+                trailer_size_ += offset_ - line.offset;
+                CheckHeaderSize(body_offset_ + trailer_size_);
+            }
+
+            break;
+        }
+        default: {
+            assert(false);
+            break;
+        }
+    }
+}
+
+bool Request::ParseChunkData() {
+    assert(buf_ && offset_ <= buf_->ReadableSize());
+    const auto size {
+        std::min(chunk_remaining_, buf_->ReadableSize() - offset_)};
+
+    // The data is moved down over the framing before it, so the decoded body stays contiguous.
+    if (decoded_end_ != offset_) {
+        const auto bytes {buf_->MutableReadableBytes()};
+        std::memmove(bytes.data() + decoded_end_, bytes.data() + offset_, size);
+    }
+
+    decoded_end_ += size;
+    offset_ += size;
+    chunk_remaining_ -= size;
+    return chunk_remaining_ == 0;
+}
+
+void Request::EraseChunkFraming() noexcept {
+    assert(buf_ && decoded_end_ <= offset_);
+    buf_->Erase(decoded_end_, offset_ - decoded_end_);
+    offset_ = decoded_end_;
+}
+
 std::size_t Request::PostSize() const noexcept {
     return post_.size();
 }
 
 bool Request::KeepAlive() const noexcept {
-    if (const auto conn {headers_.find("Connection")};
-        conn != headers_.cend()) {
-        return version_ == "1.1" && conn->second == "keep-alive";
+    const auto conn {Header(KnownHeader::Connection).value_or("")};
+    if (Version() == "1.1") {
+        // HTTP/1.1 connections are persistent unless the client closes them.
+        return !HasToken(conn, "close");
     } else {
-        return false;
+        return Version() == "1.0" && HasToken(conn, "keep-alive");
+    }
+}
+
+ContentEncodings Request::AcceptedEncodings() const noexcept {
+    if (const auto encodings {Header(KnownHeader::AcceptEncoding)};
+        encodings.has_value()) {
+        return ParseAcceptEncoding(encodings.value());
+    } else {
+        return {};
+    }
+}
+
+http::Preconditions Request::Preconditions() const noexcept {
+    http::Preconditions preconditions;
+    preconditions.if_none_match = Header(KnownHeader::IfNoneMatch);
+    if (const auto since {Header(KnownHeader::IfModifiedSince)}; since.has_value()) {
+        // An invalid date is ignored.
+        preconditions.if_modified_since = ParseHTTPDate(since.value());
+    }
+
+    preconditions.if_range = Header(KnownHeader::IfRange);
+    return preconditions;
+}
+
+std::optional<std::vector<RangeSpec>> Request::Ranges() const noexcept {
+    if (const auto ranges {Header(KnownHeader::Range)}; ranges.has_value()) {
+        return ParseRange(ranges.value());
+    } else {
+        return std::nullopt;
     }
 }
 
 std::string_view Request::Version() const noexcept {
-    return version_;
+    return buf_ ? View(version_) : std::string_view {};
 }
 
 std::string_view Request::Path() const noexcept {
-    return path_;
+    return buf_ ? View(path_) : std::string_view {};
 }
 
 http::Method Request::Method() const noexcept {
@@ -163,7 +488,7 @@ http::Method Request::Method() const noexcept {
 
 std::optional<std::string_view> Request::Post(
     const std::string_view key) const noexcept {
-    if (const auto val {post_.find(key.data())}; val != post_.cend()) {
+    if (const auto val {post_.find(key)}; val != post_.cend()) {
         return val->second;
     } else {
         return std::nullopt;
@@ -171,74 +496,86 @@ std::optional<std::string_view> Request::Post(
 }
 
 std::optional<std::string_view> Request::Header(
-    const std::string_view key) const noexcept {
-    if (const auto val {headers_.find(key.data())}; val != headers_.cend()) {
-        return val->second;
+    const KnownHeader key) const noexcept {
+    const auto index {static_cast<std::size_t>(key)};
+    if (known_header_mask_ & (std::uint32_t {1} << index)) {
+        return View(known_headers_[index]);
     } else {
         return std::nullopt;
     }
 }
 
-void NotStarted::ParseStatusLine(const std::string& line) {
-    const std::regex pattern {"^([^ ]*) ([^ ]*) HTTP/([^ ]*)$"};
-    std::smatch matches;
-    if (std::regex_match(line, matches, pattern)) {
-        parser_.method_ = StringToMethod(matches[1]);
-        parser_.path_ = matches[2];
-        parser_.version_ = matches[3];
-        parser_.SetState(std::make_unique<Header>(parser_));
-    } else {
-        throw std::invalid_argument {
-            fmt::format("Invalid HTTP status line: '{}'", line)};
+std::optional<std::string_view> Request::Header(
+    const std::string_view key) const noexcept {
+    if (const auto known {ToKnownHeader(key)}; known.has_value()) {
+        return Header(known.value());
     }
-}
 
-void Header::Parse(const std::string& line) {
-    const std::regex pattern {"^([^:]*): ?(.*)$"};
-    std::smatch matches;
-    if (std::regex_match(line, matches, pattern)) {
-        parser_.headers_.emplace(matches[1], matches[2]);
-    } else if (line.empty()) {
-        parser_.SetState(std::make_unique<Body>(parser_));
+    if (const auto field {std::ranges::find_if(
+            other_headers_,
+            [this, key](const Field& field) {
+                return EqualsIgnoreCase(View(field.name), key);
+            })};
+        field != other_headers_.cend()) {
+        return View(field->value);
     } else {
-        throw std::invalid_argument {
-            "There must be an empty line between HTTP headers and the body"};
+        return std::nullopt;
     }
 }
 
-void Body::Parse(const std::string& body) {
-    const auto method {parser_.Method()};
-    switch (method) {
+void Request::ParseBody(const Range body) {
+    // An empty body, such as an empty chunked one, is allowed for any method.
+    if (body.length == 0) {
+        return;
+    }
+
+    switch (method_) {
         case Method::Post: {
             ParsePost(body);
             break;
         }
         default: {
             throw std::invalid_argument {fmt::format(
-                "Unsupported HTTP method: '{}'", to_string(method))};
+                "Unsupported HTTP method: '{}'", to_string(method_))};
         }
     }
-
-    parser_.SetState(std::make_unique<Finished>(parser_));
 }
 
-void Body::ParsePost(const std::string& body) {
-    if (const auto content_type {parser_.Header("Content-Type").value_or("")};
+void Request::ParsePost(const Range body) {
+    if (const auto content_type {Header(KnownHeader::ContentType).value_or("")};
         content_type == "application/x-www-form-urlencoded") {
-        ParseURLEncodedPost(body);
+        post_body_ = body;
     } else {
         throw std::invalid_argument {
             fmt::format("Unsupported HTTP content type: '{}'", content_type)};
     }
 }
 
-void Body::ParseURLEncodedPost(const std::string& body) {
-    auto& post {parser_.post_};
-    auto decoded_body {DecodeURLEncodedString(body)};
-    std::string_view view {decoded_body};
-    std::string key, val;
+void Request::DecodePost() {
+    assert(state_ == State::Finished);
+    if (post_decoded_) {
+        return;
+    }
+
+    post_decoded_ = true;
+    if (post_body_.length > 0) {
+        ParseURLEncodedPost(post_body_);
+    }
+}
+
+void Request::ParseURLEncodedPost(const Range body) {
+    assert(buf_);
+    auto& post {post_};
+    const auto bytes {
+        buf_->MutableReadableBytes().subspan(body.offset, body.length)};
+    const std::span<char> data {reinterpret_cast<char*>(bytes.data()),
+                                bytes.size()};
+
+    // The body is decoded in the buffer, so variables are its views.
+    const std::string_view view {data.data(), DecodeURLEncodedInPlace(data)};
+    std::string_view key;
     std::size_t begin {0}, end {0};
-    for (; end < view.size(); ++end) {
+    for (; (end += FindFormSeparator(view.substr(end))) < view.size(); ++end) {
         switch (view[end]) {
             case '=': {
                 key = view.substr(begin, end - begin);
@@ -246,36 +583,38 @@ void Body::ParseURLEncodedPost(const std::string& body) {
                 break;
             }
             case '+': {
-                decoded_body[end] = ' ';
+                data[end] = ' ';
                 break;
             }
             case '&': {
-                val = view.substr(begin, end - begin);
-                begin = end + 1;
                 if (!key.empty()) {
-                    post.emplace(std::move(key), std::move(val));
+                    post.emplace(key, view.substr(begin, end - begin));
+                    key = {};
                 } else {
                     throw std::invalid_argument {
-                        fmt::format("Invalid HTTP POST data: '{}'", body)};
+                        fmt::format("Invalid HTTP POST data: '{}'", view)};
                 }
 
+                begin = end + 1;
                 break;
             }
             default: {
+                assert(false);
                 break;
             }
         }
     }
 
     // Save the last key-value pair.
+    end = view.size();
     assert(begin <= end);
-    val = view.substr(begin, end - begin);
+    const auto val {view.substr(begin, end - begin)};
     if (!key.empty() && !post.contains(key) && !val.empty()) {
-        post.emplace(std::move(key), std::move(val));
+        post.emplace(key, val);
     } else {
         throw std::invalid_argument {
-            fmt::format("Invalid HTTP POST data: '{}'", body)};
+            fmt::format("Invalid HTTP POST data: '{}'", view)};
     }
 }
 
-}  // namespace ws::http
\ No newline at end of file
+}  // namespace ws::http
@@ -13,18 +13,123 @@
 #pragma once
 
 #include "containers/buffer.h"
+#include "containers/perfect_hash_map.h"
 #include "http.h"
 
-#include <memory>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 
 namespace ws::http {
 
-//! The HTTP request parser.
+//! Well-known HTTP header names, which are interned into fixed slots of a request when it is parsed.
+enum class KnownHeader : std::uint8_t {
+    Host,
+    Connection,
+    ContentLength,
+    ContentType,
+    TransferEncoding,
+    Expect,
+    Upgrade,
+    Accept,
+    AcceptEncoding,
+    AcceptLanguage,
+    IfNoneMatch,
+    IfModifiedSince,
+    IfRange,
+    Range,
+    CacheControl,
+    Cookie,
+    Referer,
+    UserAgent
+};
+
+//! The number of well-known HTTP header names.
+inline constexpr std::size_t known_header_count {18};
+
+//! Whether a comma-separated list, such as the @p Connection header, contains a case-insensitive token.
+constexpr bool HasToken(std::string_view list,
+                        const std::string_view token) noexcept {
+    while (!list.empty()) {
+        const auto comma {std::min(list.find(','), list.size())};
+        if (EqualsIgnoreCase(TrimWhitespace(list.substr(0, comma)), token)) {
+            return true;
+        }
+
+        list.remove_prefix(std::min(comma + 1, list.size()));
+    }
+
+    return false;
+}
+
+/**
+ * @brief Intern an HTTP header name.
+ *
+ * @details The name is case-insensitive.
+ *
+ * @return The well-known header, or @p std::nullopt if the name is not well-known.
+ */
+std::optional<KnownHeader> ToKnownHeader(std::string_view name) noexcept;
+
+//! An HTTP request exceeding a limit, which is answered with a specific status code.
+class RequestTooLarge : public std::invalid_argument {
+public:
+    /**
+     * @param status
+     * @p StatusCode::PayloadTooLarge or @p StatusCode::RequestHeaderFieldsTooLarge.
+     */
+    explicit RequestTooLarge(StatusCode status, const std::string& msg);
+
+    //! Get the status code answering the request.
+    StatusCode Status() const noexcept;
+
+private:
+    StatusCode status_;
+};
+
+/**
+ * @brief The incremental HTTP request parser.
+ *
+ * @details
+ * The parser runs directly over the readable bytes of a buffer without copying them.
+ * If a request is incomplete, the parsing can be resumed after more data is appended to the buffer.
+ *
+ * The path, version and headers are views of the buffer.
+ * So developers must not retrieve the request's bytes from the buffer before finishing using it.
+ * After that, the request's bytes can be retrieved by @p Size.
+ *
+ * A body with @p Content-Length is kept in the buffer until it is complete.
+ * A body with @p Transfer-Encoding: chunked is decoded in place as the data arrives.
+ * The data of each chunk is moved down over the framing before it,
+ * and the framing is erased from the buffer each time the parsing stops,
+ * so the decoded body follows the headers and is never held twice.
+ * Trailer fields are erased too, but count towards the limits on headers.
+ * Limits are checked as soon as the sizes are known, before the rest of the request is received.
+ */
 class Request {
 public:
-    class State;
+    //! The parsing state.
+    enum class State {
+        NotStarted,
+        Header,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkEnd,
+        Trailer,
+        Finished
+    };
+
+    //! The maximum size of a line that frames a chunk or a trailer field.
+    static constexpr std::size_t max_chunk_line_size {0x400};
 
     Request() noexcept;
 
@@ -35,26 +140,61 @@ public:
      */
     explicit Request(Buffer& buf);
 
-    ~Request() noexcept;
-
     /**
-     * @brief Parse an HTTP request.
+     * @brief Parse or continue parsing an HTTP request.
+     *
+     * @param buf
+     * A buffer whose readable bytes start with the request.
+     * It must be the same buffer if the parsing is resumed.
+     * The framing of a chunked body is erased from it.
+     * @param limits Limits on the size of the request.
+     * @return @p true if the request is complete, otherwise @p false.
      *
+     * @exception RequestTooLarge The HTTP request exceeds a limit.
      * @exception std::invalid_argument The HTTP request is invalid.
      */
-    void Parse(Buffer& buf);
+    bool Parse(Buffer& buf, const RequestLimits& limits = {});
+
+    //! Whether the request is complete.
+    bool Finished() const noexcept;
+
+    //! Get the size of the request that has been parsed, excluding the erased framing of a chunked body.
+    std::size_t Size() const noexcept;
+
+    //! Reset the parser for a new request.
+    void Clear() noexcept;
 
     /**
      * @brief Get an HTTP header by its key.
      *
-     * @warning The query is case-sensitive.
+     * @details
+     * The query is case-insensitive.
+     * If the header is repeated, the first one is returned.
      */
     std::optional<std::string_view> Header(std::string_view key) const noexcept;
 
+    //! Get a well-known HTTP header without hashing its name.
+    std::optional<std::string_view> Header(KnownHeader key) const noexcept;
+
+    /**
+     * @brief Decode HTTP @p POST variables of a complete request in place.
+     *
+     * @details
+     * A URL-encoded body is decoded in the buffer, and the variables are views of it.
+     * It is not decoded while parsing, as a request forwarded to an upstream server must be kept as it was received.
+     *
+     * @warning The body in the buffer is overwritten, so the request can no longer be forwarded.
+     *
+     * @exception std::invalid_argument Invalid HTTP @p POST data.
+     */
+    void DecodePost();
+
     /**
      * @brief Get an HTTP @p POST variable by its key.
      *
-     * @warning The query is case-sensitive.
+     * @warning
+     * The query is case-sensitive.
+     * Variables are only available after @p DecodePost.
      */
     std::optional<std::string_view> Post(std::string_view key) const noexcept;
 
@@ -70,28 +210,184 @@ public:
     //! Get the HTTP version.
     std::string_view Version() const noexcept;
 
-    //! Whether the request keeps alive.
+    /**
+     * @brief Whether the client wants the connection to be kept alive after the request.
+     *
+     * @details
+     * An HTTP/1.1 connection is persistent unless the @p Connection header contains @p close.
+     * An HTTP/1.0 connection is persistent only if the @p Connection header contains @p keep-alive.
+     */
     bool KeepAlive() const noexcept;
 
+    //! Get the content encodings accepted by the client from the @p Accept-Encoding header.
+    ContentEncodings AcceptedEncodings() const noexcept;
+
+    //! Get the preconditions from the @p If-None-Match, @p If-Modified-Since and @p If-Range headers.
+    http::Preconditions Preconditions() const noexcept;
+
+    /**
+     * @brief Get the byte ranges from the @p Range header.
+     *
+     * @return The ranges, or @p std::nullopt if the header does not exist or should be ignored.
+     */
+    std::optional<std::vector<RangeSpec>> Ranges() const noexcept;
+
 private:
-    friend class NotStarted;
-    friend class Header;
-    friend class Body;
+    //! A range of the request's bytes.
+    struct Range {
+        std::size_t offset {0};
+        std::size_t length {0};
+    };
 
-    //! Set a new parsing state.
-    void SetState(std::unique_ptr<State> state) noexcept;
+    struct Field {
+        Range name;
+        Range value;
+    };
 
-    //! Clear the cache.
-    void Clear() noexcept;
+    /**
+     * @brief Extract the next line starting from the parsing offset and move the offset after it.
+     *
+     * @return The range of the line without its line break, or @p std::nullopt if the line is incomplete.
+     */
+    std::optional<Range> ExtractLine() noexcept;
+
+    /**
+     * @brief Parse the HTTP status line.
+     *
+     * @exception std::invalid_argument The HTTP status line is invalid.
+     */
+    void ParseStatusLine(Range line);
+
+    /**
+     * @brief Parse an HTTP header.
+     *
+     * @exception std::invalid_argument The HTTP header is invalid.
+     */
+    void ParseHeader(Range line);
+
+    /**
+     * @brief Check an incomplete HTTP header to reject an invalid one early.
+     *
+     * @exception std::invalid_argument The HTTP header is invalid.
+     */
+    void CheckPartialHeader() const;
+
+    /**
+     * @brief Check the size of the request line, headers and trailer fields that have been received.
+     *
+     * @exception RequestTooLarge The size exceeds the limit.
+     */
+    void CheckHeaderSize(std::size_t size) const;
+
+    /**
+     * @brief Count a header or trailer field.
+     *
+     * @exception RequestTooLarge There are too many fields.
+     */
+    void CountHeader();
+
+    /**
+     * @brief Finish parsing headers and decide whether there is a body.
+     *
+     * @exception RequestTooLarge The body exceeds the size limit.
+     * @exception std::invalid_argument The framing of the body is invalid.
+     */
+    void FinishHeaders();
+
+    /**
+     * @brief Parse a line framing a chunk, or a trailer field.
+     *
+     * @exception RequestTooLarge The decoded body or trailer fields exceed a limit.
+     * @exception std::invalid_argument The chunk framing is invalid.
+     */
+    void ParseChunkLine(Range line);
+
+    //! Decode the available data of the current chunk, returning whether the chunk is complete.
+    bool ParseChunkData();
+
+    /**
+     * @brief Erase the parsed framing of a chunked body from the buffer.
+     *
+     * @details
+     * Only the bytes after the parsing offset are moved,
+     * so it is called once each time the parsing stops instead of once per chunk.
+     */
+    void EraseChunkFraming() noexcept;
 
-    std::unique_ptr<State> state_;
+    /**
+     * @brief Parse the HTTP body.
+     *
+     * @exception std::invalid_argument A non-empty body is sent with an unsupported HTTP method.
+     */
+    void ParseBody(Range body);
+
+    /**
+     * @brief Parse an HTTP @p POST body, which is decoded later by @p DecodePost.
+     *
+     * @exception std::invalid_argument Unsupported HTTP content type.
+     */
+    void ParsePost(Range body);
+
+    /**
+     * @brief
+     * Decode an HTTP @p POST body with content type @p application/x-www-form-urlencoded in place.
+     *
+     * @exception std::invalid_argument Invalid HTTP @p POST data.
+     */
+    void ParseURLEncodedPost(Range body);
+
+    //! Get the view of a range.
+    std::string_view View(Range range) const noexcept;
+
+    Buffer* buf_ {nullptr};
+
+    State state_ {State::NotStarted};
+
+    //! The offset where the next parsing starts.
+    std::size_t offset_ {0};
+
+    std::size_t content_length_ {0};
+
+    RequestLimits limits_;
+
+    std::size_t header_count_ {0};
+
+    //! The remaining size of the current chunk.
+    std::size_t chunk_remaining_ {0};
+
+    //! The offset where the body starts.
+    std::size_t body_offset_ {0};
+
+    //! The offset where the decoded data of a chunked body ends, before the framing that has not been erased.
+    std::size_t decoded_end_ {0};
+
+    //! The size of trailer fields that have been parsed.
+    std::size_t trailer_size_ {0};
 
     http::Method method_ {Method::Get};
-    std::string version_;
-    std::string path_;
+    Range version_;
+    Range path_;
+
+    //! Values of well-known headers, indexed by @p KnownHeader.
+    std::array<Range, known_header_count> known_headers_ {};
+
+    //! The bit mask of well-known headers that have been parsed.
+    std::uint32_t known_header_mask_ {0};
+
+    static_assert(known_header_count <= sizeof(known_header_mask_) * 8);
+
+    //! Headers that are not well-known, which are searched linearly as a request usually has only a few of them.
+    std::vector<Field> other_headers_;
+
+    //! The URL-encoded @p POST body.
+    Range post_body_;
+
+    bool post_decoded_ {false};
 
-    Parameters headers_;
-    Parameters post_;
+    //! @p POST variables, which are views of the decoded body.
+    std::unordered_map<std::string_view, std::string_view, StringHash,
+                       std::equal_to<>>
+        post_;
 };
 
-}  // namespace ws::http
\ No newline at end of file
+}  // namespace ws::http
@@ -1,11 +1,106 @@
 #include "request.h"
 
+#include <fmt/format.h>
 #include <gtest/gtest.h>
 
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
 using namespace ws;
 using namespace ws::http;
 
 
+namespace {
+
+/**
+ * @brief The previous form parser, splitting a decoded body one character at a time.
+ *
+ * @return Parameters, or @p std::nullopt if the body is invalid.
+ */
+std::optional<Parameters> ReferenceParseForm(const std::string_view body) {
+    std::string decoded_body;
+    for (std::size_t i {0}; i < body.size();) {
+        if (body[i] == '%') {
+            if (i + 3 > body.size()) {
+                return std::nullopt;
+            }
+
+            decoded_body += static_cast<char>(
+                std::stoi(std::string {body.substr(i + 1, 2)}, nullptr, 16));
+            i += 3;
+        } else {
+            decoded_body += body[i++];
+        }
+    }
+
+    Parameters post;
+    std::string_view view {decoded_body};
+    std::string key, val;
+    std::size_t begin {0}, end {0};
+    for (; end < view.size(); ++end) {
+        switch (view[end]) {
+            case '=': {
+                key = view.substr(begin, end - begin);
+                begin = end + 1;
+                break;
+            }
+            case '+': {
+                decoded_body[end] = ' ';
+                break;
+            }
+            case '&': {
+                val = view.substr(begin, end - begin);
+                begin = end + 1;
+                if (key.empty()) {
+                    return std::nullopt;
+                }
+
+                post.emplace(std::move(key), std::move(val));
+                key.clear();
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    val = view.substr(begin, end - begin);
+    if (key.empty() || post.contains(key) || val.empty()) {
+        return std::nullopt;
+    }
+
+    post.emplace(std::move(key), std::move(val));
+    return post;
+}
+
+//! Generate a random form with URL-encoded characters, which may be invalid.
+std::string RandomForm(std::mt19937& engine) {
+    static constexpr std::string_view chars {"abcxyz019-_.~+&=%"};
+    static constexpr std::string_view hex {"0123456789abcdefABCDEF"};
+
+    std::uniform_int_distribution<std::size_t> length {1, 120};
+    std::uniform_int_distribution<std::size_t> index {0, chars.size() - 1};
+    std::uniform_int_distribution<std::size_t> hex_index {0, hex.size() - 1};
+
+    std::string form;
+    for (std::size_t i {0}, count {length(engine)}; i != count; ++i) {
+        const auto c {chars[index(engine)]};
+        form += c;
+        if (c == '%' && i + 1 != count) {
+            form += hex[hex_index(engine)];
+            form += hex[hex_index(engine)];
+        }
+    }
+
+    return form;
+}
+
+}  // namespace
+
+
 TEST(HTTPRequestTest, Parse) {
     {
         Buffer buf {"POST /path/to/file HTTP/1.1\r\n"
@@ -29,7 +124,9 @@ TEST(HTTPRequestTest, Parse) {
                     "id=1"};
 
         Request request {buf};
-        EXPECT_FALSE(request.KeepAlive());
+
+        // HTTP/1.1 connections are persistent by default.
+        EXPECT_TRUE(request.KeepAlive());
         EXPECT_EQ(request.Version(), "1.1");
         EXPECT_EQ(request.Path(), "/file");
         EXPECT_EQ(request.Method(), Method::Post);
@@ -40,13 +137,15 @@ TEST(HTTPRequestTest, Parse) {
         EXPECT_EQ(request.Header("Host"), "server.id");
         EXPECT_FALSE(request.Header("Connection"));
 
+        request.DecodePost();
         EXPECT_EQ(request.Post("id"), "1");
         EXPECT_FALSE(request.Post("name"));
 
-        // The query is case-sensitive.
+        // Queries of variables are case-sensitive, but queries of headers are not.
         EXPECT_FALSE(request.Post("ID"));
-        EXPECT_FALSE(request.Header("host"));
-        EXPECT_FALSE(request.Header("HOST"));
+        EXPECT_EQ(request.Header("host"), "server.id");
+        EXPECT_EQ(request.Header("HOST"), "server.id");
+        EXPECT_EQ(request.Header(KnownHeader::Host), "server.id");
 
         EXPECT_EQ(request.PostSize(), 1);
     }
@@ -71,10 +170,21 @@ TEST(HTTPRequestTest, Parse) {
                   "application/x-www-form-urlencoded");
         EXPECT_EQ(request.Header("Host"), "server.id");
 
+        // The body is decoded in place only when it is asked for.
+        EXPECT_FALSE(request.Post("id"));
+        EXPECT_TRUE(buf.ReadableString().ends_with("mike+chen&msg=hello%21"));
+        request.DecodePost();
+        request.DecodePost();
+        EXPECT_EQ(buf.ReadableString().substr(request.Size() - 32, 30),
+                  "id=1&name=mike chen&msg=hello!");
+
         EXPECT_EQ(request.Post("id"), "1");
         EXPECT_EQ(request.Post("name"), "mike chen");
         EXPECT_EQ(request.Post("msg"), "hello!");
 
+        // A key does not need to be null-terminated.
+        EXPECT_EQ(request.Post(std::string_view {"idx"}.substr(0, 2)), "1");
+
         EXPECT_EQ(request.PostSize(), 3);
     }
 
@@ -88,4 +198,404 @@ TEST(HTTPRequestTest, Parse) {
         Request request;
         EXPECT_THROW(request.Parse(buf), std::invalid_argument);
     }
-}
\ No newline at end of file
+}
+
+TEST(HTTPRequestTest, ParseIncrementally) {
+    const std::string_view raw {
+        "POST /file HTTP/1.1\r\n"
+        "Host: server.id\r\n"
+        "Content-Type:  application/x-www-form-urlencoded \r\n"
+        "Content-Length: 4\r\n"
+        "\r\n"
+        "id=1"};
+
+    // Append a request byte by byte.
+    Buffer buf;
+    Request request;
+    for (std::size_t i {0}; i < raw.size() - 1; ++i) {
+        buf.Append(raw.substr(i, 1));
+        EXPECT_FALSE(request.Parse(buf));
+        EXPECT_FALSE(request.Finished());
+    }
+
+    buf.Append(raw.substr(raw.size() - 1));
+    ASSERT_TRUE(request.Parse(buf));
+    EXPECT_TRUE(request.Finished());
+    EXPECT_EQ(request.Size(), raw.size());
+    EXPECT_EQ(request.Path(), "/file");
+    EXPECT_EQ(request.Header("Content-Type"),
+              "application/x-www-form-urlencoded");
+    request.DecodePost();
+    EXPECT_EQ(request.Post("id"), "1");
+
+    request.Clear();
+    EXPECT_FALSE(request.Finished());
+    EXPECT_EQ(request.Size(), 0);
+}
+
+TEST(HTTPRequestTest, ParseFollowedRequest) {
+    // Only the first request is parsed.
+    Buffer buf {"GET /first HTTP/1.1\r\n"
+                "\r\n"
+                "GET /second HTTP/1.1\r\n"
+                "\r\n"};
+
+    Request request;
+    ASSERT_TRUE(request.Parse(buf));
+    EXPECT_EQ(request.Path(), "/first");
+    EXPECT_EQ(request.Method(), Method::Get);
+
+    const auto size {request.Size()};
+    EXPECT_EQ(size, std::string_view {"GET /first HTTP/1.1\r\n\r\n"}.size());
+    request.Clear();
+    buf.Retrieve(size);
+
+    ASSERT_TRUE(request.Parse(buf));
+    EXPECT_EQ(request.Path(), "/second");
+    EXPECT_EQ(request.Size(), buf.ReadableSize());
+}
+
+TEST(HTTPRequestTest, ParseInvalid) {
+    const auto parse {[](const std::string_view raw) {
+        Buffer buf {raw};
+        Request request;
+        return request.Parse(buf);
+    }};
+
+    EXPECT_THROW(parse("GET /\r\n\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse("GET / HTTP/1.1 extra\r\n\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse("GET / FTP/1.1\r\n\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse("UNKNOWN / HTTP/1.1\r\n\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse("GET / HTTP/1.1\r\nNo colon\r\n\r\n"),
+                 std::invalid_argument);
+    EXPECT_THROW(parse("GET / HTTP/1.1\r\n: empty name\r\n\r\n"),
+                 std::invalid_argument);
+    EXPECT_THROW(parse("POST / HTTP/1.1\r\nContent-Length: 1a\r\n\r\n"),
+                 std::invalid_argument);
+
+    // An incomplete request is not an error.
+    EXPECT_FALSE(parse("GET / HTTP/1.1\r\nHost: server"));
+    EXPECT_FALSE(parse("GET / HTTP/1.1\r\n\r"));
+}
+
+TEST(HTTPRequestTest, ParseChunked) {
+    const std::string_view raw {
+        "POST /file HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "3\r\nid=\r\n"
+        "a;ext=1\r\n1&name=abc\r\n"
+        "0\r\n"
+        "Trailer: 1\r\n"
+        "\r\n"};
+
+    // Append a request byte by byte.
+    Buffer buf;
+    Request request;
+    for (std::size_t i {0}; i < raw.size() - 1; ++i) {
+        buf.Append(raw.substr(i, 1));
+        ASSERT_FALSE(request.Parse(buf)) << i;
+    }
+
+    buf.Append(raw.substr(raw.size() - 1));
+    ASSERT_TRUE(request.Parse(buf));
+    request.DecodePost();
+    EXPECT_EQ(request.Post("id"), "1");
+    EXPECT_EQ(request.Post("name"), "abc");
+
+    // The framing is erased from the buffer, leaving the decoded body after the headers.
+    constexpr std::string_view decoded {
+        "POST /file HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "id=1&name=abc"};
+    EXPECT_EQ(request.Size(), decoded.size());
+    EXPECT_EQ(buf.ReadableString(), decoded);
+    EXPECT_EQ(request.Header("Transfer-Encoding"), "chunked");
+
+    // A following request is kept.
+    Buffer followed_buf {"POST / HTTP/1.1\r\n"
+                         "Content-Type: application/x-www-form-urlencoded\r\n"
+                         "Transfer-Encoding: chunked\r\n"
+                         "\r\n"
+                         "4\r\nid=1\r\n0\r\n\r\n"
+                         "GET / HTTP/1.1\r\n\r\n"};
+    request.Clear();
+    ASSERT_TRUE(request.Parse(followed_buf));
+    followed_buf.Retrieve(request.Size());
+    EXPECT_EQ(followed_buf.ReadableString(), "GET / HTTP/1.1\r\n\r\n");
+
+    // Many chunks are decoded in one pass, even if the parsing stops inside one of them.
+    Buffer chunks_buf {"POST / HTTP/1.1\r\n"
+                       "Content-Type: application/x-www-form-urlencoded\r\n"
+                       "Transfer-Encoding: chunked\r\n"
+                       "\r\n"
+                       "3\r\nid=\r\n1\r\n1\r\n7\r\n&na"};
+    request.Clear();
+    ASSERT_FALSE(request.Parse(chunks_buf));
+    chunks_buf.Append("me=a\r\n2\r\nbc\r\n0\r\n\r\nGET / HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(request.Parse(chunks_buf));
+    request.DecodePost();
+    EXPECT_EQ(request.Post("id"), "1");
+    EXPECT_EQ(request.Post("name"), "abc");
+    EXPECT_EQ(chunks_buf.ReadableString().substr(request.Size()),
+              "GET / HTTP/1.1\r\n\r\n");
+    EXPECT_TRUE(chunks_buf.ReadableString().substr(0, request.Size()).ends_with(
+        "\r\n\r\nid=1&name=abc"));
+
+    const auto parse {[](const std::string_view body) {
+        Buffer buf {fmt::format("POST / HTTP/1.1\r\n"
+                                "Content-Type: application/x-www-form-urlencoded\r\n"
+                                "Transfer-Encoding: chunked\r\n"
+                                "\r\n"
+                                "{}",
+                                body)};
+        Request request;
+        return request.Parse(buf);
+    }};
+
+    EXPECT_TRUE(parse("4\r\nid=1\r\n0\r\n\r\n"));
+    EXPECT_TRUE(parse("0\r\n\r\n"));
+    EXPECT_THROW(parse("2\r\nid=1\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse("x\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse(";ext\r\n"), std::invalid_argument);
+    EXPECT_THROW(parse(std::string(Request::max_chunk_line_size + 1, '1')),
+                 std::invalid_argument);
+
+    // The framing of a body must be unambiguous.
+    Buffer buf_with_length {"POST / HTTP/1.1\r\n"
+                            "Transfer-Encoding: chunked\r\n"
+                            "Content-Length: 4\r\n"
+                            "\r\n"};
+    EXPECT_THROW(Request {buf_with_length}, std::invalid_argument);
+
+    // An empty chunked body is allowed for any method, but a non-empty one is not.
+    Buffer empty_get_buf {"GET / HTTP/1.1\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "\r\n"
+                          "0\r\n\r\n"};
+    EXPECT_TRUE(Request {}.Parse(empty_get_buf));
+
+    Buffer get_buf {"GET / HTTP/1.1\r\n"
+                    "Transfer-Encoding: chunked\r\n"
+                    "\r\n"
+                    "1\r\na\r\n0\r\n\r\n"};
+    EXPECT_THROW(Request {get_buf}, std::invalid_argument);
+
+    Buffer gzip_buf {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"};
+    EXPECT_THROW(Request {gzip_buf}, std::invalid_argument);
+}
+
+TEST(HTTPRequestTest, ParseWithLimits) {
+    const auto parse {[](const std::string_view raw,
+                         const RequestLimits& limits) -> std::optional<StatusCode> {
+        Buffer buf {raw};
+        Request request;
+        try {
+            request.Parse(buf, limits);
+            return std::nullopt;
+        } catch (const RequestTooLarge& err) {
+            return err.Status();
+        }
+    }};
+
+    constexpr RequestLimits limits {
+        .max_header_size = 0x40, .max_header_count = 2, .max_body_size = 8};
+
+    // The header is rejected before its end is received.
+    EXPECT_EQ(parse(fmt::format("GET / HTTP/1.1\r\nX-Long: {}",
+                                std::string(limits.max_header_size, 'a')),
+                    limits),
+              StatusCode::RequestHeaderFieldsTooLarge);
+    EXPECT_EQ(parse("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\n\r\n", limits),
+              StatusCode::RequestHeaderFieldsTooLarge);
+    EXPECT_FALSE(parse("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\n\r\n", limits));
+
+    // The body is rejected before it is received.
+    EXPECT_EQ(parse("POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n", limits),
+              StatusCode::PayloadTooLarge);
+    EXPECT_EQ(parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                    "5\r\naaaaa\r\n4\r\n",
+                    limits),
+              StatusCode::PayloadTooLarge);
+
+    // Trailer fields count towards the limits on headers.
+    constexpr std::string_view chunked_header {
+        "POST / HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "4\r\nid=1\r\n0\r\n"};
+    constexpr RequestLimits trailer_limits {
+        .max_header_size = 0x80, .max_header_count = 3, .max_body_size = 8};
+    EXPECT_FALSE(parse(fmt::format("{}A: 1\r\n\r\n", chunked_header),
+                       trailer_limits));
+    EXPECT_EQ(parse(fmt::format("{}A: 1\r\nB: 2\r\n\r\n", chunked_header),
+                    trailer_limits),
+              StatusCode::RequestHeaderFieldsTooLarge);
+    EXPECT_EQ(parse(fmt::format("{}X: {}\r\n\r\n", chunked_header,
+                                std::string(40, 'a')),
+                    trailer_limits),
+              StatusCode::RequestHeaderFieldsTooLarge);
+
+    // Zero disables limits.
+    EXPECT_FALSE(parse("POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n",
+                       {.max_header_size = 0, .max_header_count = 0, .max_body_size = 0}));
+}
+
+TEST(HTTPRequestTest, AcceptedEncodings) {
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n\r\n"};
+        const Request request {buf};
+        EXPECT_TRUE(request.AcceptedEncodings().Empty());
+    }
+
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n"
+                    "Accept-Encoding: gzip, br;q=0\r\n"
+                    "\r\n"};
+        const Request request {buf};
+        const auto encodings {request.AcceptedEncodings()};
+        EXPECT_TRUE(encodings.Contains(ContentEncoding::Gzip));
+        EXPECT_FALSE(encodings.Contains(ContentEncoding::Brotli));
+    }
+}
+
+TEST(HTTPRequestTest, Preconditions) {
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n\r\n"};
+        const Request request {buf};
+        EXPECT_TRUE(request.Preconditions().Empty());
+    }
+
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n"
+                    "If-None-Match: \"tag\"\r\n"
+                    "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                    "\r\n"};
+        const Request request {buf};
+        const auto preconditions {request.Preconditions()};
+        EXPECT_EQ(preconditions.if_none_match, "\"tag\"");
+        EXPECT_EQ(preconditions.if_modified_since,
+                  std::chrono::system_clock::time_point {
+                      std::chrono::seconds {784111777}});
+    }
+
+    {
+        // An invalid date is ignored.
+        Buffer buf {"GET / HTTP/1.1\r\n"
+                    "If-Modified-Since: yesterday\r\n"
+                    "\r\n"};
+        const Request request {buf};
+        EXPECT_TRUE(request.Preconditions().Empty());
+    }
+}
+
+TEST(HTTPRequestTest, Ranges) {
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n\r\n"};
+        const Request request {buf};
+        EXPECT_FALSE(request.Ranges().has_value());
+    }
+
+    {
+        Buffer buf {"GET / HTTP/1.1\r\n"
+                    "Range: bytes=0-9, -5\r\n"
+                    "If-Range: \"tag\"\r\n"
+                    "\r\n"};
+        const Request request {buf};
+        EXPECT_EQ(request.Ranges(),
+                  (std::vector<RangeSpec> {{.first = 0, .last = 9},
+                                           {.last = 5}}));
+        EXPECT_EQ(request.Preconditions().if_range, "\"tag\"");
+    }
+
+    {
+        // An invalid header is ignored.
+        Buffer buf {"GET / HTTP/1.1\r\n"
+                    "Range: lines=1-2\r\n"
+                    "\r\n"};
+        const Request request {buf};
+        EXPECT_FALSE(request.Ranges().has_value());
+    }
+}
+
+TEST(HTTPRequestTest, URLEncodedPostEquivalentToReference) {
+    std::mt19937 engine {0x20220729};
+    for (auto i {0}; i != 5000; ++i) {
+        const auto form {RandomForm(engine)};
+        const auto expected {ReferenceParseForm(form)};
+
+        Buffer buf {fmt::format(
+            "POST / HTTP/1.1\r\n"
+            "Content-Type: application/x-www-form-urlencoded\r\n"
+            "Content-Length: {}\r\n"
+            "\r\n"
+            "{}",
+            form.size(), form)};
+
+        Request request;
+        try {
+            ASSERT_TRUE(request.Parse(buf));
+            request.DecodePost();
+            ASSERT_TRUE(expected.has_value()) << form;
+            ASSERT_EQ(request.PostSize(), expected->size()) << form;
+            for (const auto& [key, val] : expected.value()) {
+                ASSERT_EQ(request.Post(key), val) << form;
+            }
+        } catch (const std::invalid_argument&) {
+            ASSERT_FALSE(expected.has_value()) << form;
+        }
+    }
+}
+
+TEST(HTTPRequestTest, KeepAlive) {
+    const auto keep_alive {[](const std::string_view version,
+                              const std::string_view conn) {
+        Buffer buf {fmt::format("GET / HTTP/{}\r\n{}\r\n", version,
+                                conn.empty() ? ""
+                                             : fmt::format("Connection: {}\r\n",
+                                                           conn))};
+        return Request {buf}.KeepAlive();
+    }};
+
+    EXPECT_TRUE(keep_alive("1.1", ""));
+    EXPECT_TRUE(keep_alive("1.1", "keep-alive"));
+    EXPECT_TRUE(keep_alive("1.1", "Upgrade"));
+    EXPECT_FALSE(keep_alive("1.1", "close"));
+    EXPECT_FALSE(keep_alive("1.1", "Close"));
+    EXPECT_FALSE(keep_alive("1.1", "TE, close"));
+
+    EXPECT_FALSE(keep_alive("1.0", ""));
+    EXPECT_TRUE(keep_alive("1.0", "keep-alive"));
+    EXPECT_TRUE(keep_alive("1.0", "Keep-Alive"));
+    EXPECT_FALSE(keep_alive("1.0", "close"));
+}
+
+TEST(HTTPRequestTest, InternHeaders) {
+    EXPECT_EQ(ToKnownHeader("Content-Length"), KnownHeader::ContentLength);
+    EXPECT_EQ(ToKnownHeader("content-length"), KnownHeader::ContentLength);
+    EXPECT_EQ(ToKnownHeader("USER-AGENT"), KnownHeader::UserAgent);
+    EXPECT_FALSE(ToKnownHeader("X-Custom"));
+    EXPECT_FALSE(ToKnownHeader(""));
+
+    Buffer buf {"GET / HTTP/1.1\r\n"
+                "host: server.id\r\n"
+                "X-Custom: first\r\n"
+                "HOST: ignored\r\n"
+                "x-custom: second\r\n"
+                "Empty:\r\n"
+                "\r\n"};
+
+    const Request request {buf};
+
+    // The first one of repeated headers is returned.
+    EXPECT_EQ(request.Header(KnownHeader::Host), "server.id");
+    EXPECT_EQ(request.Header("Host"), "server.id");
+    EXPECT_EQ(request.Header("X-CUSTOM"), "first");
+    EXPECT_EQ(request.Header("empty"), "");
+    EXPECT_FALSE(request.Header(KnownHeader::Connection));
+    EXPECT_FALSE(request.Header("Missing"));
+}
@@ -1,38 +1,119 @@
 #include "response.h"
 
 #include <cassert>
+#include <random>
 #include <sstream>
 
 
 namespace ws::http {
 
+namespace {
+
+//! The boundary of @p multipart/byteranges bodies, which is unlikely to appear in content.
+std::string_view MultipartBoundary() noexcept {
+    static const auto boundary {[] {
+        std::random_device random;
+        return fmt::format("ws-{:08x}{:08x}", random(), random());
+    }()};
+    return boundary;
+}
+
+//! The compiled HTML pages shared by all responses.
+HTMLTemplateCache& Templates() noexcept {
+    static HTMLTemplateCache templates;
+    return templates;
+}
+
+}  // namespace
+
 Response::Response(std::filesystem::path root_dir) noexcept :
     root_dir_ {std::move(root_dir)} {}
 
+std::filesystem::path Response::FullPath(
+    const std::filesystem::path& root_dir,
+    const std::filesystem::path& file) noexcept {
+    if (!root_dir.empty()) {
+        // The form of an HTTP path is "/path/to/file".
+        // Using `relative_path` can get its relative path which is "path/to/file".
+        // Otherwise `root_dir / file` only returns `file`,
+        // because `file` is considered as an absolute path.
+        return root_dir / file.relative_path();
+    } else {
+        return file;
+    }
+}
+
 Response::~Response() noexcept {
     Clear();
 }
 
 void Response::Clear() noexcept {
-    file_.Unmap();
+    file_.Close();
+    html_.reset();
     status_code_ = StatusCode::OK;
+    encoding_ = ContentEncoding::Identity;
+    validators_.reset();
+    byte_ranges_.clear();
+    parts_.clear();
     file_path_.clear();
 }
 
+std::chrono::seconds Response::keep_alive_timeout_ {
+    default_keep_alive_timeout};
+
+void Response::SetKeepAliveTimeout(const std::chrono::seconds timeout) noexcept {
+    keep_alive_timeout_ = timeout;
+}
+
+std::chrono::seconds Response::GetKeepAliveTimeout() noexcept {
+    return keep_alive_timeout_;
+}
+
 Response& Response::SetKeepAlive(const bool set) noexcept {
     keep_alive_ = set;
     return *this;
 }
 
-std::optional<MappedReadOnlyFile> Response::Build(Buffer& buf,
-                                                  std::filesystem::path file,
-                                                  StatusCode& code) noexcept {
+Response& Response::SetContentType(std::string type) noexcept {
+    content_type_ = std::move(type);
+    return *this;
+}
+
+Response& Response::SetAcceptedEncodings(
+    const ContentEncodings encodings) noexcept {
+    accepted_encodings_ = encodings;
+    return *this;
+}
+
+Response& Response::SetPreconditions(
+    http::Preconditions preconditions) noexcept {
+    preconditions_ = std::move(preconditions);
+    return *this;
+}
+
+Response& Response::SetRanges(
+    std::optional<std::vector<RangeSpec>> ranges) noexcept {
+    ranges_ = std::move(ranges);
+    return *this;
+}
+
+const std::vector<BodyPart>& Response::Parts() const noexcept {
+    return parts_;
+}
+
+StatusCode Response::Status() const noexcept {
+    return status_code_;
+}
+
+std::optional<ReadOnlyFile> Response::Build(Buffer& buf,
+                                            std::filesystem::path file,
+                                            StatusCode& code) noexcept {
     Clear();
     file_path_ = std::move(file);
     status_code_ = StatusCode::OK;
     Build(buf);
     code = status_code_;
-    return file_.Data() ? std::optional {std::move(file_)} : std::nullopt;
+    return file_.Valid() ? std::optional {std::move(file_)} : std::nullopt;
 }
 
 void Response::Build(Buffer& buf, std::filesystem::path file,
@@ -44,6 +125,34 @@ void Response::Build(Buffer& buf, std::filesystem::path file,
     code = status_code_;
 }
 
+void Response::Build(Buffer& buf, std::filesystem::path file,
+                     const std::size_t size,
+                     const ContentEncoding encoding,
+                     const Validators* const validators) noexcept {
+    Clear();
+    file_path_ = std::move(file);
+    status_code_ = StatusCode::OK;
+    encoding_ = encoding;
+    if (validators) {
+        validators_ = *validators;
+    }
+
+    SelectRanges(size);
+    AddStatusLine(buf);
+    AddHeaders(buf);
+    AddContentHeaders(buf, size);
+}
+
+void Response::BuildNotModified(Buffer& buf,
+                                const Validators& validators) noexcept {
+    Clear();
+    status_code_ = StatusCode::NotModified;
+    validators_ = validators;
+    AddStatusLine(buf);
+    AddHeaders(buf);
+    AddNotModifiedHeaders(buf);
+}
+
 void Response::Build(Buffer& buf, const StatusCode code,
                      std::string msg) noexcept {
     static constexpr std::string_view http_status_page {"/http-status.html"};
@@ -68,33 +177,151 @@ void Response::Build(Buffer& buf, const Parameters* const params) noexcept {
     std::optional<std::string> error_msg;
 
     try {
-        if (!root_dir_.empty()) {
-            // The form of an HTTP path is "/path/to/file".
-            // Using `relative_path` can get its relative path which is "path/to/file".
-            // Otherwise `root_dir_ / file_path_` only returns `file_path_`,
-            // because `file_path_` is considered as an absolute path.
-            file_.Map(root_dir_ / file_path_.relative_path());
+        // Only HTML pages with placeholders need to be mapped into memory.
+        // Other files are sent from their descriptors.
+        if (params) {
+            html_ = Templates().Get(FullPath(root_dir_, file_path_));
         } else {
-            file_.Map(file_path_);
+            OpenFile();
         }
     } catch (const std::exception& err) {
         status_code_ = StatusCode::BadRequest;
         error_msg = err.what();
     }
 
+    // The size of a file that cannot be satisfied by ranges needs to be reported.
+    std::size_t file_size {0};
+    if (file_.Valid()) {
+        file_size = file_.Size();
+        SelectRanges(file_size);
+        if (status_code_ == StatusCode::RangeNotSatisfiable) {
+            file_.Close();
+        }
+    }
+
     AddStatusLine(buf);
     AddHeaders(buf);
     if (!error_msg.has_value()) {
         if (params) {
             AddParamContent(buf, *params);
+        } else if (status_code_ == StatusCode::NotModified) {
+            AddNotModifiedHeaders(buf);
+        } else if (status_code_ == StatusCode::RangeNotSatisfiable) {
+            AddRangeNotSatisfiableHeaders(buf, file_size);
         } else {
-            AddMappedContent(buf);
+            AddFileContent(buf);
         }
     } else {
         AddPredefinedErrorContent(buf, error_msg.value());
     }
 }
 
+void Response::OpenFile() {
+    const auto path {FullPath(root_dir_, file_path_)};
+
+    // The requested file must exist even if a precompressed sibling is sent.
+    file_.Open(path);
+    encoding_ = SelectEncoding(path);
+
+    // Validators are derived from the requested file, so an unmodified file needs no more system calls.
+    const auto make_validators {[this] {
+        return Validators {.etag = MakeEntityTag(file_.Inode(), file_.Size(),
+                                                 file_.ModificationTime(),
+                                                 encoding_),
+                           .last_modified = file_.ModificationTime()};
+    }};
+
+    validators_ = make_validators();
+    if (preconditions_.NotModified(validators_.value())) {
+        file_.Close();
+        status_code_ = StatusCode::NotModified;
+        return;
+    }
+
+    if (encoding_ == ContentEncoding::Identity) {
+        return;
+    }
+
+    try {
+        ReadOnlyFile compressed;
+        compressed.Open(fmt::format("{}{}", path.native(),
+                                    ContentEncodingToExtension(encoding_)));
+        file_ = std::move(compressed);
+    } catch (const std::exception&) {
+        // Send the requested file if its sibling cannot be opened.
+        encoding_ = ContentEncoding::Identity;
+        validators_ = make_validators();
+    }
+}
+
+ContentEncoding Response::SelectEncoding(
+    const std::filesystem::path& path) const {
+    if (accepted_encodings_.Empty()) {
+        return ContentEncoding::Identity;
+    }
+
+    for (const auto encoding : ContentEncodings::preferences) {
+        if (!accepted_encodings_.Contains(encoding)) {
+            continue;
+        }
+
+        // Check the sibling without opening it, since it is not needed if the file has not been modified.
+        std::error_code error;
+        if (std::filesystem::is_regular_file(
+                fmt::format("{}{}", path.native(),
+                            ContentEncodingToExtension(encoding)),
+                error)) {
+            return encoding;
+        }
+    }
+
+    return ContentEncoding::Identity;
+}
+
+void Response::SelectRanges(const std::size_t size) noexcept {
+    if (!ranges_.has_value() || status_code_ != StatusCode::OK) {
+        return;
+    }
+
+    // A full response is sent if the content has changed since the client got a part of it.
+    if (preconditions_.if_range.has_value()
+        && (!validators_.has_value()
+            || !preconditions_.RangeApplies(validators_.value()))) {
+        return;
+    }
+
+    byte_ranges_ = ResolveRanges(ranges_.value(), size);
+    if (byte_ranges_.empty()) {
+        status_code_ = StatusCode::RangeNotSatisfiable;
+        return;
+    }
+
+    status_code_ = StatusCode::PartialContent;
+    if (byte_ranges_.size() == 1) {
+        const auto& range {byte_ranges_.front()};
+        parts_.push_back(
+            {.prefix = "", .offset = range.first, .length = range.Length()});
+        return;
+    }
+
+    // Each part of a multiple-range body has its own header.
+    const auto type {ContentType()};
+    for (const auto& range : byte_ranges_) {
+        parts_.push_back(
+            {.prefix = fmt::format("{}--{}{}Content-type: {}{}"
+                                   "Content-range: bytes {}-{}/{}{}{}",
+                                   parts_.empty() ? "" : new_line,
+                                   MultipartBoundary(), new_line, type,
+                                   new_line, range.first, range.last, size,
+                                   new_line, new_line),
+             .offset = range.first,
+             .length = range.Length()});
+    }
+
+    parts_.push_back({.prefix = fmt::format("{}--{}--{}", new_line,
+                                            MultipartBoundary(), new_line)});
+}
+
 void Response::AddStatusLine(Buffer& buf) const noexcept {
     buf.Append(
         fmt::format("HTTP/{} {} {}", version, StatusCodeToInteger(status_code_),
@@ -102,55 +329,112 @@ void Response::AddStatusLine(Buffer& buf) const noexcept {
         NewLine::CRLF);
 }
 
+std::string_view Response::ContentType() const noexcept {
+    return content_type_.empty() ? ContentTypeByFileName(file_path_.c_str())
+                                 : content_type_;
+}
+
 void Response::AddHeaders(Buffer& buf) const noexcept {
     buf.Append("Connection: ");
     if (keep_alive_) {
         buf.Append("keep-alive", NewLine::CRLF);
-        buf.Append("keep-alive: max=6, timeout=120", NewLine::CRLF);
+        if (keep_alive_timeout_ > std::chrono::seconds::zero()) {
+            // The remaining number of requests is not advertised, so pre-serialized headers can be shared.
+            // The final response of a connection says `close` instead.
+            buf.Append(fmt::format("Keep-alive: timeout={}",
+                                   keep_alive_timeout_.count()),
+                       NewLine::CRLF);
+        }
     } else {
         buf.Append("close", NewLine::CRLF);
     }
 }
 
-void Response::AddMappedContent(Buffer& buf) noexcept {
-    assert(file_.Data());
+void Response::AddFileContent(Buffer& buf) noexcept {
+    assert(file_.Valid());
+    AddContentHeaders(buf, file_.Size());
+}
+
+void Response::AddContentHeaders(Buffer& buf,
+                                 const std::size_t size) const noexcept {
+    if (status_code_ == StatusCode::RangeNotSatisfiable) {
+        AddRangeNotSatisfiableHeaders(buf, size);
+        return;
+    }
+
+    if (byte_ranges_.size() > 1) {
+        buf.Append(fmt::format("Content-type: multipart/byteranges; boundary={}",
+                               MultipartBoundary()),
+                   NewLine::CRLF);
+    } else {
+        buf.Append(fmt::format("Content-type: {}", ContentType()),
+                   NewLine::CRLF);
+    }
+
+    if (encoding_ != ContentEncoding::Identity) {
+        buf.Append(fmt::format("Content-encoding: {}",
+                               ContentEncodingToString(encoding_)),
+                   NewLine::CRLF);
+    }
+
+    AddValidatorHeaders(buf);
+    buf.Append("Accept-ranges: bytes", NewLine::CRLF);
 
-    buf.Append(fmt::format("Content-type: {}",
-                           ContentTypeByFileName(file_path_.c_str())),
-               NewLine::CRLF);
-    buf.Append(fmt::format("Content-length: {}", file_.Size()), NewLine::CRLF);
+    auto length {size};
+    if (byte_ranges_.size() == 1) {
+        const auto& range {byte_ranges_.front()};
+        buf.Append(fmt::format("Content-range: bytes {}-{}/{}", range.first,
+                               range.last, size),
+                   NewLine::CRLF);
+        length = range.Length();
+    } else if (!parts_.empty()) {
+        length = 0;
+        for (const auto& part : parts_) {
+            length += part.prefix.size() + part.length;
+        }
+    }
+
+    buf.Append(fmt::format("Content-length: {}", length), NewLine::CRLF);
     buf.Append(new_line);
 }
 
-void Response::AddParamContent(Buffer& buf,
-                               const Parameters& params) const noexcept {
-    assert(file_.Data());
+void Response::AddRangeNotSatisfiableHeaders(
+    Buffer& buf, const std::size_t size) const noexcept {
+    AddValidatorHeaders(buf);
+    buf.Append(fmt::format("Content-range: bytes */{}", size), NewLine::CRLF);
+    buf.Append("Content-length: 0", NewLine::CRLF);
+    buf.Append(new_line);
+}
 
-    buf.Append(fmt::format("Content-type: {}",
-                           ContentTypeByFileName(file_path_.c_str())),
-               NewLine::CRLF);
+void Response::AddNotModifiedHeaders(Buffer& buf) const noexcept {
+    // A `304 Not Modified` response has no content.
+    AddValidatorHeaders(buf);
+    buf.Append(new_line);
+}
 
-    std::string content {reinterpret_cast<const char*>(file_.Data()),
-                         file_.Size()};
-    for (const auto& [key, val] : params) {
-        content = ReplaceAllSubstring(content, HTMLPlaceholder(key), val);
+void Response::AddValidatorHeaders(Buffer& buf) const noexcept {
+    // Files may have precompressed siblings, so caches must not share responses between clients accepting different encodings.
+    buf.Append("Vary: Accept-Encoding", NewLine::CRLF);
+    if (validators_.has_value()) {
+        buf.Append(fmt::format("ETag: {}", validators_->etag), NewLine::CRLF);
+        buf.Append(fmt::format("Last-modified: {}",
+                               FormatHTTPDate(validators_->last_modified)),
+                   NewLine::CRLF);
     }
+}
 
-    const auto lines {SplitStringToLines(content)};
-    std::size_t length {new_line.length() * (lines.size() - 1)};
-    std::for_each(lines.cbegin(), lines.cend(),
-                  [&length](const auto& line) { length += line.size(); });
+void Response::AddParamContent(Buffer& buf,
+                               const Parameters& params) const noexcept {
+    assert(html_);
+
+    buf.Append(fmt::format("Content-type: {}", ContentType()), NewLine::CRLF);
 
+    const auto length {html_->Length(params)};
     buf.Append(fmt::format("Content-length: {}", length), NewLine::CRLF);
     buf.Append(new_line);
 
-    for (auto i {0}; i != lines.size(); ++i) {
-        if (i != lines.size() - 1) {
-            buf.Append(lines[i], NewLine::CRLF);
-        } else {
-            buf.Append(lines[i]);
-        }
-    }
+    buf.EnsureWriteableSize(length);
+    html_->Render(buf, params);
 }
 
 void Response::AddPredefinedErrorContent(Buffer& buf,
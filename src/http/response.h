@@ -13,11 +13,15 @@
 #pragma once
 
 #include "containers/buffer.h"
+#include "html_template.h"
 #include "http.h"
 #include "util.h"
 
+#include <chrono>
 #include <filesystem>
 #include <optional>
+#include <string>
+#include <string_view>
 
 
 namespace ws::http {
@@ -35,6 +39,16 @@ public:
      */
     explicit Response(std::filesystem::path root_dir) noexcept;
 
+    /**
+     * @brief Get the full path of a requested file.
+     *
+     * @param root_dir A root directory.
+     * @param file A file path. If it is a relative path, it will be relative to the root directory.
+     */
+    static std::filesystem::path FullPath(
+        const std::filesystem::path& root_dir,
+        const std::filesystem::path& file) noexcept;
+
     ~Response() noexcept;
 
     Response(const Response&) = delete;
@@ -45,9 +59,68 @@ public:
 
     Response& operator=(Response&&) = delete;
 
+    /**
+     * @brief Set the idle timeout advertised by the @p Keep-Alive header of persistent connections.
+     *
+     * @param timeout A timeout. If it is zero, the header is omitted.
+     */
+    static void SetKeepAliveTimeout(std::chrono::seconds timeout) noexcept;
+
+    //! Get the idle timeout advertised by the @p Keep-Alive header.
+    static std::chrono::seconds GetKeepAliveTimeout() noexcept;
+
+    //! The default idle timeout advertised by the @p Keep-Alive header.
+    static constexpr std::chrono::seconds default_keep_alive_timeout {60};
+
     //! Whether the connection should keep alive.
     Response& SetKeepAlive(bool set) noexcept;
 
+    /**
+     * @brief Set the content type of files, overriding the type derived from file names.
+     *
+     * @param type A content type, or an empty string to derive types from file names.
+     */
+    Response& SetContentType(std::string type) noexcept;
+
+    /**
+     * @brief Set the content encodings accepted by the client.
+     *
+     * @details
+     * When a file is requested, its precompressed sibling with an accepted encoding will be sent instead if it exists.
+     * For example, @p index.css.br or @p index.css.gz for @p index.css.
+     */
+    Response& SetAcceptedEncodings(ContentEncodings encodings) noexcept;
+
+    /**
+     * @brief Set the preconditions of a conditional request.
+     *
+     * @details
+     * If a requested file has not been modified,
+     * a @p 304 Not Modified response will be built and the file will not be sent.
+     */
+    Response& SetPreconditions(http::Preconditions preconditions) noexcept;
+
+    /**
+     * @brief Set the byte ranges requested by the client.
+     *
+     * @details
+     * If ranges can be satisfied, a @p 206 Partial Content response will be built,
+     * and developers should send the body parts from @p Parts after the response header.
+     * If no range can be satisfied, a @p 416 Range Not Satisfiable response will be built without content.
+     * Ranges are ignored if @p If-Range in the preconditions does not match the content.
+     */
+    Response& SetRanges(std::optional<std::vector<RangeSpec>> ranges) noexcept;
+
+    /**
+     * @brief Get the body parts of a @p 206 Partial Content response that has been built.
+     *
+     * @return The parts, or an empty list if the whole content should be sent.
+     */
+    const std::vector<BodyPart>& Parts() const noexcept;
+
+    //! Get the status code of the response that has been built.
+    StatusCode Status() const noexcept;
+
     /**
      * @brief Build an HTTP response from a file request.
      *
@@ -55,13 +128,35 @@ public:
      * @param file A file path. If it is a relative path, it will be relative to the root directory.
      * @param[out] code The HTTP status code representing the file request.
      * @return
-     * A read-only mapped file.  @p std::nullopt if the file request failed.
-     * If this method returns a valid mapped file,
+     * An opened read-only file, which may be a precompressed sibling of the requested file.
+     * @p std::nullopt if the file request failed, the file has not been modified or no range can be satisfied.
+     * If this method returns a valid file,
      * developers should send file content after sending the response header in the buffer.
+     * The file is not mapped into memory, so its content can be sent by @p sendfile.
      */
-    std::optional<MappedReadOnlyFile> Build(Buffer& buf,
-                                            std::filesystem::path file,
-                                            StatusCode& code) noexcept;
+    std::optional<ReadOnlyFile> Build(Buffer& buf, std::filesystem::path file,
+                                      StatusCode& code) noexcept;
+
+    /**
+     * @brief Build an HTTP response header for file content that has been loaded by developers.
+     *
+     * @param[out] buf An output buffer where the response header will be written to.
+     * @param file A file path, used to determine the content type.
+     * @param size The content size.
+     * @param encoding The content encoding.
+     * @param validators The optional validators of the content.
+     */
+    void Build(Buffer& buf, std::filesystem::path file, std::size_t size,
+               ContentEncoding encoding = ContentEncoding::Identity,
+               const Validators* validators = nullptr) noexcept;
+
+    /**
+     * @brief Build a @p 304 Not Modified response header.
+     *
+     * @param[out] buf An output buffer where the response header will be written to.
+     * @param validators The validators of the unmodified content.
+     */
+    void BuildNotModified(Buffer& buf, const Validators& validators) noexcept;
 
     /**
      * @brief Build an HTTP response from a file request.
@@ -92,32 +187,67 @@ public:
     void Build(Buffer& buf, StatusCode code, std::string msg = "") noexcept;
 
 private:
+    static std::chrono::seconds keep_alive_timeout_;
+
     //! Clear settings.
     void Clear() noexcept;
 
     //! Build an HTTP response from the current settings.
     void Build(Buffer& buf, const Parameters* params = nullptr) noexcept;
 
-    //! Check the file status if there is a file request.
-    void CheckFile();
-
-    //! Map the file into memory if there is a valid file request.
-    void MapFile();
-
     //! Add an HTTP status line.
     void AddStatusLine(Buffer& buf) const noexcept;
 
+    /**
+     * @brief Open the requested file or its precompressed sibling with the most preferred accepted encoding.
+     *
+     * @details
+     * If the file has not been modified according to the preconditions,
+     * the status code will be @p 304 Not Modified and no file will be kept open.
+     *
+     * @exception std::system_error The requested file cannot be opened.
+     */
+    void OpenFile();
+
+    //! Get the most preferred accepted encoding whose precompressed sibling exists.
+    ContentEncoding SelectEncoding(const std::filesystem::path& path) const;
+
+    /**
+     * @brief Resolve the requested byte ranges against the content size.
+     *
+     * @details
+     * The status code becomes @p 206 Partial Content or @p 416 Range Not Satisfiable if ranges apply,
+     * and body parts are built for satisfiable ranges.
+     */
+    void SelectRanges(std::size_t size) noexcept;
+
+    //! Get the content type of the file to be sent.
+    std::string_view ContentType() const noexcept;
+
     //! Add HTTP headers that are not relevant to the content of the response.
     void AddHeaders(Buffer& buf) const noexcept;
 
     /**
-     * @brief Add HTTP headers that are relevant to the mapped read-only file.
+     * @brief Add HTTP headers that are relevant to the opened read-only file.
      *
      * @note
      * This method does not append file content to the buffer,
-     * because the base address of file content will be returned to developers.
+     * because the opened file will be returned to developers.
      */
-    void AddMappedContent(Buffer& buf) noexcept;
+    void AddFileContent(Buffer& buf) noexcept;
+
+    //! Add HTTP headers that are relevant to file content of a specific size.
+    void AddContentHeaders(Buffer& buf, std::size_t size) const noexcept;
+
+    //! Add HTTP headers of a @p 304 Not Modified response.
+    void AddNotModifiedHeaders(Buffer& buf) const noexcept;
+
+    //! Add the @p Vary header and validators of file content.
+    void AddValidatorHeaders(Buffer& buf) const noexcept;
+
+    //! Add HTTP headers of a @p 416 Range Not Satisfiable response.
+    void AddRangeNotSatisfiableHeaders(Buffer& buf,
+                                       std::size_t size) const noexcept;
 
     //! Add HTTP headers and generated HTML content from parameters.
     void AddParamContent(Buffer& buf, const Parameters& params) const noexcept;
@@ -129,9 +259,34 @@ private:
     std::filesystem::path root_dir_;
     std::filesystem::path file_path_;
 
-    MappedReadOnlyFile file_;
+    //! The requested file to be sent.
+    ReadOnlyFile file_;
+
+    //! The compiled HTML page whose placeholders need to be replaced.
+    HTMLTemplate::Ptr html_;
 
     bool keep_alive_ {false};
+
+    //! The content type overriding the one derived from the file name.
+    std::string content_type_;
+
+    ContentEncodings accepted_encodings_;
+    http::Preconditions preconditions_;
+
+    //! The validators of the file content to be sent.
+    std::optional<Validators> validators_;
+
+    std::optional<std::vector<RangeSpec>> ranges_;
+
+    //! The satisfiable byte ranges to be sent.
+    std::vector<ByteRange> byte_ranges_;
+
+    //! The body parts of a @p 206 Partial Content response.
+    std::vector<BodyPart> parts_;
+
+    //! The encoding of the content to be sent.
+    ContentEncoding encoding_ {ContentEncoding::Identity};
+
     StatusCode status_code_ {StatusCode::OK};
 };
 
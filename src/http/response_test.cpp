@@ -4,6 +4,10 @@
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+
 using namespace ws;
 using namespace ws::http;
 using namespace ws::test;
@@ -15,8 +19,21 @@ constexpr std::string_view system_error_tip {
     "The unit test involves system exceptions which may have different "
     "explanatory strings on platforms.\n"
     "Please check that firstly if the test failed."};
+
+//! Get the expected validator headers of a file.
+std::string ValidatorHeaders(
+    const std::string& path,
+    const ContentEncoding encoding = ContentEncoding::Identity) {
+    ReadOnlyFile file;
+    file.Open(path);
+    return fmt::format("ETag: {}\r\nLast-modified: {}\r\n",
+                       MakeEntityTag(file.Inode(), file.Size(),
+                                     file.ModificationTime(), encoding),
+                       FormatHTTPDate(file.ModificationTime()));
 }
 
+}  // namespace
+
 TEST(HTTPResponseTest, BuiltByFile) {
     {
         // Create a temporary file.
@@ -39,13 +56,16 @@ TEST(HTTPResponseTest, BuiltByFile) {
         EXPECT_TRUE(header.Build(buf, path, status_code));
         EXPECT_EQ(status_code, StatusCode::OK);
 
-        constexpr std::string_view content {
+        const auto content {
             "HTTP/1.1 200 OK\r\n"
             "Connection: keep-alive\r\n"
-            "keep-alive: max=6, timeout=120\r\n"
+            "Keep-alive: timeout=60\r\n"
             "Content-type: application/octet-stream\r\n"
-            "Content-length: 5\r\n"
-            "\r\n"};
+            "Vary: Accept-Encoding\r\n"
+            + ValidatorHeaders(path)
+            + "Accept-ranges: bytes\r\n"
+              "Content-length: 5\r\n"
+              "\r\n"};
         EXPECT_EQ(buf.RetrieveAllToString(), content);
     }
 
@@ -73,6 +93,267 @@ TEST(HTTPResponseTest, BuiltByFile) {
     }
 }
 
+TEST(HTTPResponseTest, BuiltByPrecompressedFile) {
+    const auto dir {CreateTempTestDirectory()};
+    const RAII raii {dir, [](const auto& dir) noexcept {
+                         std::error_code error;
+                         std::filesystem::remove_all(dir, error);
+                     }};
+
+    const auto write {[&dir](const std::string_view name,
+                             const std::string_view data) {
+        std::ofstream file {std::filesystem::path {dir} / name};
+        file << data;
+    }};
+
+    write("page.html", "hello");
+    write("page.html.gz", "gzip");
+    write("page.html.br", "br");
+    const auto page {(std::filesystem::path {dir} / "page.html").string()};
+
+    const auto build {[&dir](const ContentEncodings encodings) {
+        Buffer buf;
+        StatusCode status_code {StatusCode::OK};
+        Response header {dir};
+        header.SetAcceptedEncodings(encodings);
+        const auto file {header.Build(buf, "/page.html", status_code)};
+        EXPECT_TRUE(file.has_value());
+        EXPECT_EQ(status_code, StatusCode::OK);
+        return std::pair {buf.RetrieveAllToString(),
+                          file.has_value() ? file->Size() : 0};
+    }};
+
+    {
+        const auto [header, size] {build({})};
+        EXPECT_EQ(header,
+                  "HTTP/1.1 200 OK\r\n"
+                  "Connection: close\r\n"
+                  "Content-type: text/html\r\n"
+                  "Vary: Accept-Encoding\r\n"
+                      + ValidatorHeaders(page)
+                      + "Accept-ranges: bytes\r\n"
+                        "Content-length: 5\r\n"
+                        "\r\n");
+        EXPECT_EQ(size, 5);
+    }
+
+    {
+        const auto [header, size] {
+            build(ContentEncodings {}.Add(ContentEncoding::Gzip))};
+        EXPECT_EQ(header,
+                  "HTTP/1.1 200 OK\r\n"
+                  "Connection: close\r\n"
+                  "Content-type: text/html\r\n"
+                  "Content-encoding: gzip\r\n"
+                  "Vary: Accept-Encoding\r\n"
+                      + ValidatorHeaders(page, ContentEncoding::Gzip)
+                      + "Accept-ranges: bytes\r\n"
+                        "Content-length: 4\r\n"
+                        "\r\n");
+        EXPECT_EQ(size, 4);
+    }
+
+    {
+        // Brotli is preferred.
+        const auto [header, size] {build(ContentEncodings {}
+                                             .Add(ContentEncoding::Gzip)
+                                             .Add(ContentEncoding::Brotli))};
+        EXPECT_NE(header.find("Content-encoding: br\r\n"), std::string::npos);
+        EXPECT_EQ(size, 2);
+    }
+
+    {
+        // Fall back to another accepted encoding if a sibling does not exist.
+        std::filesystem::remove(std::filesystem::path {dir} / "page.html.br");
+        const auto [header, size] {build(ContentEncodings {}
+                                             .Add(ContentEncoding::Gzip)
+                                             .Add(ContentEncoding::Brotli))};
+        EXPECT_NE(header.find("Content-encoding: gzip\r\n"),
+                  std::string::npos);
+        EXPECT_EQ(size, 4);
+    }
+
+    {
+        // A precompressed sibling is not sent if the requested file does not exist.
+        std::filesystem::remove(std::filesystem::path {dir} / "page.html");
+        Buffer buf;
+        StatusCode status_code {StatusCode::OK};
+        Response header {dir};
+        header.SetAcceptedEncodings(
+            ContentEncodings {}.Add(ContentEncoding::Gzip));
+        EXPECT_FALSE(header.Build(buf, "/page.html", status_code));
+        EXPECT_EQ(status_code, StatusCode::BadRequest);
+    }
+}
+
+TEST(HTTPResponseTest, BuiltByUnmodifiedFile) {
+    const auto dir {CreateTempTestDirectory()};
+    const RAII raii {dir, [](const auto& dir) noexcept {
+                         std::error_code error;
+                         std::filesystem::remove_all(dir, error);
+                     }};
+
+    const auto page {(std::filesystem::path {dir} / "page.html").string()};
+    std::ofstream {page} << "hello";
+    std::ofstream {page + ".gz"} << "gzip";
+
+    ReadOnlyFile file;
+    file.Open(page);
+    const auto etag {MakeEntityTag(file.Inode(), file.Size(),
+                                   file.ModificationTime())};
+    const auto gzip_etag {MakeEntityTag(file.Inode(), file.Size(),
+                                        file.ModificationTime(),
+                                        ContentEncoding::Gzip)};
+
+    const auto build {[&dir](const Preconditions& preconditions,
+                             const ContentEncodings encodings = {}) {
+        Buffer buf;
+        StatusCode status_code {StatusCode::OK};
+        Response header {dir};
+        header.SetAcceptedEncodings(encodings).SetPreconditions(preconditions);
+        const auto file {header.Build(buf, "/page.html", status_code)};
+        EXPECT_EQ(file.has_value(), status_code == StatusCode::OK);
+        return std::pair {status_code, buf.RetrieveAllToString()};
+    }};
+
+    {
+        Preconditions preconditions;
+        preconditions.if_none_match = etag;
+        const auto [status_code, header] {build(preconditions)};
+        EXPECT_EQ(status_code, StatusCode::NotModified);
+        EXPECT_EQ(header, "HTTP/1.1 304 Not Modified\r\n"
+                          "Connection: close\r\n"
+                          "Vary: Accept-Encoding\r\n"
+                              + ValidatorHeaders(page) + "\r\n");
+    }
+
+    {
+        // An encoded representation has a different entity tag.
+        Preconditions preconditions;
+        preconditions.if_none_match = etag;
+        const auto gzip {ContentEncodings {}.Add(ContentEncoding::Gzip)};
+        EXPECT_EQ(build(preconditions, gzip).first, StatusCode::OK);
+
+        preconditions.if_none_match = gzip_etag;
+        const auto [status_code, header] {build(preconditions, gzip)};
+        EXPECT_EQ(status_code, StatusCode::NotModified);
+        EXPECT_NE(header.find(fmt::format("ETag: {}\r\n", gzip_etag)),
+                  std::string::npos);
+    }
+
+    {
+        Preconditions preconditions;
+        preconditions.if_modified_since = file.ModificationTime();
+        EXPECT_EQ(build(preconditions).first, StatusCode::NotModified);
+
+        preconditions.if_modified_since =
+            file.ModificationTime() - std::chrono::hours {1};
+        EXPECT_EQ(build(preconditions).first, StatusCode::OK);
+    }
+}
+
+TEST(HTTPResponseTest, BuiltByFileRanges) {
+    const auto dir {CreateTempTestDirectory()};
+    const RAII raii {dir, [](const auto& dir) noexcept {
+                         std::error_code error;
+                         std::filesystem::remove_all(dir, error);
+                     }};
+
+    const auto page {(std::filesystem::path {dir} / "page.txt").string()};
+    std::ofstream {page} << "0123456789";
+
+    const auto build {[&dir](std::vector<RangeSpec> ranges,
+                             const Preconditions& preconditions = {}) {
+        Buffer buf;
+        StatusCode status_code {StatusCode::OK};
+        Response header {dir};
+        header.SetPreconditions(preconditions).SetRanges(std::move(ranges));
+        const auto file {header.Build(buf, "/page.txt", status_code)};
+        EXPECT_EQ(file.has_value(),
+                  status_code != StatusCode::RangeNotSatisfiable);
+        EXPECT_EQ(header.Status(), status_code);
+        return std::tuple {status_code, buf.RetrieveAllToString(),
+                           header.Parts()};
+    }};
+
+    {
+        const auto [status_code, header, parts] {
+            build({{.first = 2, .last = 4}})};
+        EXPECT_EQ(status_code, StatusCode::PartialContent);
+        EXPECT_EQ(header, "HTTP/1.1 206 Partial Content\r\n"
+                          "Connection: close\r\n"
+                          "Content-type: text/plain\r\n"
+                          "Vary: Accept-Encoding\r\n"
+                              + ValidatorHeaders(page)
+                              + "Accept-ranges: bytes\r\n"
+                                "Content-range: bytes 2-4/10\r\n"
+                                "Content-length: 3\r\n"
+                                "\r\n");
+        ASSERT_EQ(parts.size(), 1);
+        EXPECT_TRUE(parts.front().prefix.empty());
+        EXPECT_EQ(parts.front().offset, 2);
+        EXPECT_EQ(parts.front().length, 3);
+    }
+
+    {
+        const auto [status_code, header, parts] {
+            build({{.first = 0, .last = 1}, {.last = 2}})};
+        EXPECT_EQ(status_code, StatusCode::PartialContent);
+        EXPECT_NE(header.find(
+                      "Content-type: multipart/byteranges; boundary="),
+                  std::string::npos);
+
+        // The body consists of part headers, content ranges and a closing boundary.
+        ASSERT_EQ(parts.size(), 3);
+        std::string body;
+        std::size_t length {0};
+        for (const auto& part : parts) {
+            body += part.prefix;
+            body += std::string_view {"0123456789"}.substr(part.offset,
+                                                           part.length);
+            length += part.prefix.size() + part.length;
+        }
+
+        EXPECT_NE(header.find(fmt::format("Content-length: {}\r\n", length)),
+                  std::string::npos);
+        EXPECT_TRUE(body.starts_with("--"));
+        EXPECT_NE(body.find("Content-type: text/plain\r\n"
+                            "Content-range: bytes 0-1/10\r\n"
+                            "\r\n"
+                            "01\r\n"),
+                  std::string::npos);
+        EXPECT_NE(body.find("Content-range: bytes 8-9/10\r\n"
+                            "\r\n"
+                            "89\r\n"),
+                  std::string::npos);
+        EXPECT_TRUE(body.ends_with("--\r\n"));
+    }
+
+    {
+        const auto [status_code, header, parts] {build({{.first = 10}})};
+        EXPECT_EQ(status_code, StatusCode::RangeNotSatisfiable);
+        EXPECT_EQ(header, "HTTP/1.1 416 Range Not Satisfiable\r\n"
+                          "Connection: close\r\n"
+                          "Vary: Accept-Encoding\r\n"
+                              + ValidatorHeaders(page)
+                              + "Content-range: bytes */10\r\n"
+                                "Content-length: 0\r\n"
+                                "\r\n");
+        EXPECT_TRUE(parts.empty());
+    }
+
+    {
+        // The whole file is sent if it has changed since the client got a part of it.
+        Preconditions preconditions;
+        preconditions.if_range = "\"outdated\"";
+        const auto [status_code, header, parts] {
+            build({{.first = 2, .last = 4}}, preconditions)};
+        EXPECT_EQ(status_code, StatusCode::OK);
+        EXPECT_NE(header.find("Content-length: 10\r\n"), std::string::npos);
+        EXPECT_TRUE(parts.empty());
+    }
+}
+
 TEST(HTTPResponseTest, BuiltByPredefinedErrorContent) {
     // Failed to find HTML template pages because the root directory is not set.
     Buffer buf;
@@ -0,0 +1,331 @@
+#include "tls.h"
+#include "containers/buffer.h"
+
+#ifdef WS_HTTP_TLS
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+
+namespace ws::http {
+
+namespace {
+
+#ifdef WS_HTTP_TLS
+//! The maximum size of a TLS record's plain data, which is the largest size read at once.
+constexpr std::size_t max_record_size {0x4000};
+
+//! The session ID context, which keeps sessions of other applications from being resumed.
+constexpr std::string_view session_id_context {"echo-web-server"};
+
+//! The maximum number of sessions kept by the server-side cache.
+constexpr long session_cache_size {0x5000};
+
+/**
+ * @brief Application protocols supported by ALPN in the order of preference.
+ *
+ * @details HTTP/2 is detected from its connection preface, so it needs no special handling after negotiation.
+ */
+constexpr std::array<unsigned char, 12> alpn_protocols {
+    2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
+
+//! Get the description of the last OpenSSL error and clear the error queue.
+std::string LastErrorString() noexcept {
+    std::array<char, 0x100> msg {};
+    if (const auto error {ERR_get_error()}; error != 0) {
+        ERR_error_string_n(error, msg.data(), msg.size());
+    }
+
+    ERR_clear_error();
+    return msg.data();
+}
+
+//! Select an application protocol offered by the client.
+int SelectProtocol(SSL*, const unsigned char** out, unsigned char* out_len,
+                   const unsigned char* in, const unsigned int in_len,
+                   void*) noexcept {
+    unsigned char* selected {nullptr};
+    if (SSL_select_next_proto(&selected, out_len, alpn_protocols.data(),
+                              alpn_protocols.size(), in, in_len)
+        != OPENSSL_NPN_NEGOTIATED) {
+        // If the client only offers other protocols, continue without ALPN.
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+#endif
+
+}  // namespace
+
+bool TLSContext::Supported() noexcept {
+#ifdef WS_HTTP_TLS
+    return true;
+#else
+    return false;
+#endif
+}
+
+TLSContext::TLSContext(const std::filesystem::path& cert_chain,
+                       const std::filesystem::path& private_key) {
+#ifdef WS_HTTP_TLS
+    ctx_ = SSL_CTX_new(TLS_server_method());
+    if (!ctx_) {
+        throw std::runtime_error {fmt::format(
+            "Failed to create a TLS context: {}", LastErrorString())};
+    }
+
+    try {
+        if (SSL_CTX_use_certificate_chain_file(ctx_, cert_chain.c_str())
+            != 1) {
+            throw std::runtime_error {
+                fmt::format("Failed to load the certificate chain '{}': {}",
+                            cert_chain.string(), LastErrorString())};
+        }
+
+        if (SSL_CTX_use_PrivateKey_file(ctx_, private_key.c_str(),
+                                        SSL_FILETYPE_PEM)
+                != 1
+            || SSL_CTX_check_private_key(ctx_) != 1) {
+            throw std::runtime_error {
+                fmt::format("Failed to load the private key '{}': {}",
+                            private_key.string(), LastErrorString())};
+        }
+    } catch (const std::runtime_error&) {
+        SSL_CTX_free(ctx_);
+        throw;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+
+    // A connection without a closure alert is treated as closed, like a socket reading zero bytes.
+    auto options {SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE
+                  | SSL_OP_IGNORE_UNEXPECTED_EOF};
+#ifdef SSL_OP_ENABLE_KTLS
+    // The record layer moves to the kernel after handshakes if it is supported.
+    options |= SSL_OP_ENABLE_KTLS;
+#endif
+    SSL_CTX_set_options(ctx_, options);
+
+    // Partial writes let a large buffer be sent record by record on a non-blocking socket.
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE
+                               | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER
+                               | SSL_MODE_RELEASE_BUFFERS);
+
+    // Sessions are resumed by both the cache and stateless tickets, which are enabled by default.
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx_, session_cache_size);
+    SSL_CTX_set_session_id_context(
+        ctx_, reinterpret_cast<const unsigned char*>(session_id_context.data()),
+        session_id_context.size());
+
+    SSL_CTX_set_alpn_select_cb(ctx_, SelectProtocol, nullptr);
+#else
+    throw std::runtime_error {"TLS is not supported without OpenSSL"};
+#endif
+}
+
+TLSContext::~TLSContext() noexcept {
+#ifdef WS_HTTP_TLS
+    SSL_CTX_free(ctx_);
+#endif
+}
+
+TLSSession::TLSSession(const TLSContext& ctx, const FileDescriptor socket) {
+    assert(IsValidFileDescriptor(socket));
+#ifdef WS_HTTP_TLS
+    assert(ctx.ctx_);
+    ssl_ = SSL_new(ctx.ctx_);
+    if (!ssl_) {
+        throw std::runtime_error {fmt::format(
+            "Failed to create a TLS session: {}", LastErrorString())};
+    }
+
+    // A socket BIO is needed to offload the record layer to the kernel.
+    if (SSL_set_fd(ssl_, socket) != 1) {
+        SSL_free(ssl_);
+        throw std::runtime_error {fmt::format(
+            "Failed to create a TLS session: {}", LastErrorString())};
+    }
+
+    SSL_set_accept_state(ssl_);
+#else
+    throw std::runtime_error {"TLS is not supported without OpenSSL"};
+#endif
+}
+
+TLSSession::~TLSSession() noexcept {
+#ifdef WS_HTTP_TLS
+    SSL_free(ssl_);
+#endif
+}
+
+bool TLSSession::Handshake() {
+    if (established_) {
+        return true;
+    }
+
+#ifdef WS_HTTP_TLS
+    ERR_clear_error();
+    if (const auto result {SSL_do_handshake(ssl_)}; result == 1) {
+        established_ = true;
+        want_write_ = false;
+    } else {
+        const auto error {SSL_get_error(ssl_, result)};
+        if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+            ThrowError(result, "handshake");
+        }
+
+        want_write_ = error == SSL_ERROR_WANT_WRITE;
+    }
+#endif
+
+    return established_;
+}
+
+bool TLSSession::Established() const noexcept {
+    return established_;
+}
+
+bool TLSSession::WantWrite() const noexcept {
+    return want_write_;
+}
+
+bool TLSSession::Resumed() const noexcept {
+#ifdef WS_HTTP_TLS
+    return SSL_session_reused(ssl_) == 1;
+#else
+    return false;
+#endif
+}
+
+bool TLSSession::KernelSend() const noexcept {
+#ifdef WS_HTTP_TLS
+    return established_ && BIO_get_ktls_send(SSL_get_wbio(ssl_)) == 1;
+#else
+    return false;
+#endif
+}
+
+bool TLSSession::KernelReceive() const noexcept {
+#ifdef WS_HTTP_TLS
+    return established_ && BIO_get_ktls_recv(SSL_get_rbio(ssl_)) == 1;
+#else
+    return false;
+#endif
+}
+
+std::string_view TLSSession::Protocol() const noexcept {
+#ifdef WS_HTTP_TLS
+    const unsigned char* protocol {nullptr};
+    unsigned int size {0};
+    SSL_get0_alpn_selected(ssl_, &protocol, &size);
+    return {reinterpret_cast<const char*>(protocol), size};
+#else
+    return {};
+#endif
+}
+
+std::size_t TLSSession::Pending() const noexcept {
+#ifdef WS_HTTP_TLS
+    return static_cast<std::size_t>(SSL_pending(ssl_));
+#else
+    return 0;
+#endif
+}
+
+std::size_t TLSSession::WriteTo(Buffer& buf) {
+    assert(established_);
+#ifdef WS_HTTP_TLS
+    buf.EnsureWriteableSize(max_record_size);
+    const auto bytes {buf.WritableBytes()};
+
+    ERR_clear_error();
+    std::size_t size {0};
+    if (const auto result {SSL_read_ex(ssl_, bytes.data(), bytes.size(), &size)};
+        result == 1) {
+        buf.HasWritten(size);
+        return size;
+    } else if (SSL_get_error(ssl_, result) == SSL_ERROR_ZERO_RETURN) {
+        return 0;
+    } else {
+        ThrowError(result, "read");
+    }
+#else
+    return 0;
+#endif
+}
+
+std::size_t TLSSession::ReadFrom(Buffer& buf) {
+    const auto size {Write(buf.ReadableBytes())};
+    buf.Retrieve(size);
+    return size;
+}
+
+std::size_t TLSSession::Write(const std::span<const std::byte> bytes) {
+    assert(established_);
+    if (bytes.empty()) {
+        return 0;
+    }
+
+#ifdef WS_HTTP_TLS
+    ERR_clear_error();
+    std::size_t size {0};
+    if (const auto result {
+            SSL_write_ex(ssl_, bytes.data(), bytes.size(), &size)};
+        result == 1) {
+        return size;
+    } else {
+        ThrowError(result, "write");
+    }
+#else
+    return 0;
+#endif
+}
+
+void TLSSession::Shutdown() noexcept {
+#ifdef WS_HTTP_TLS
+    if (established_) {
+        // The alert may not be sent if the socket is full, which is harmless as the connection is closing.
+        SSL_shutdown(ssl_);
+        ERR_clear_error();
+    }
+#endif
+}
+
+void TLSSession::ThrowError(const int result,
+                            const std::string_view operation) const {
+#ifdef WS_HTTP_TLS
+    switch (SSL_get_error(ssl_, result)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            throw std::system_error {std::make_error_code(
+                std::errc::resource_unavailable_try_again)};
+        case SSL_ERROR_SYSCALL:
+            if (errno != 0) {
+                ThrowLastSystemError();
+            }
+
+            break;
+        default:
+            break;
+    }
+
+    throw std::runtime_error {
+        fmt::format("TLS {} failed: {}", operation, LastErrorString())};
+#else
+    throw std::runtime_error {
+        fmt::format("TLS {} failed: TLS is not supported", operation)};
+#endif
+}
+
+}  // namespace ws::http
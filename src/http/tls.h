@@ -0,0 +1,175 @@
+/**
+ * @file tls.h
+ * @brief The TLS termination of HTTP connections.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-25
+ *
+ * @example src/http/tls_test.cpp
+ */
+
+#pragma once
+
+#include "io.h"
+#include "util.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+struct ssl_ctx_st;
+struct ssl_st;
+
+
+namespace ws::http {
+
+/**
+ * @brief The server-side TLS configuration shared by all connections.
+ *
+ * @details
+ * Sessions can be resumed by both a server-side session cache and session tickets,
+ * so a reconnecting client skips the full handshake.
+ * Since all reactors share the same context, a client can resume its session on any of them.
+ *
+ * The record layer is offloaded to the kernel (kTLS) after handshakes if both OpenSSL and the kernel support it.
+ */
+class TLSContext {
+public:
+    //! Whether the server is built with TLS support, which needs OpenSSL.
+    static bool Supported() noexcept;
+
+    /**
+     * @brief Create a context with a certificate chain and its private key in PEM format.
+     *
+     * @exception std::runtime_error TLS is not supported, or failed to load the certificate or the key.
+     */
+    TLSContext(const std::filesystem::path& cert_chain,
+               const std::filesystem::path& private_key);
+
+    ~TLSContext() noexcept;
+
+    TLSContext(const TLSContext&) = delete;
+
+    TLSContext(TLSContext&&) = delete;
+
+    TLSContext& operator=(const TLSContext&) = delete;
+
+    TLSContext& operator=(TLSContext&&) = delete;
+
+private:
+    friend class TLSSession;
+
+    ssl_ctx_st* ctx_ {nullptr};
+};
+
+/**
+ * @brief The TLS session of a connection.
+ *
+ * @details
+ * The handshake runs in user space on a non-blocking socket.
+ * After it, each direction whose record layer has moved to kTLS carries plain data on the socket,
+ * so @p sendfile and gather writes keep working.
+ * Otherwise, data is encrypted and decrypted by this object.
+ *
+ * Reading methods follow the convention of @p io::FileDescriptor:
+ * they throw @p std::system_error with @p std::errc::resource_unavailable_try_again if the socket is not ready.
+ */
+class TLSSession : public virtual io::IReadWriter {
+public:
+    /**
+     * @brief Create a session on an accepted socket.
+     *
+     * @exception std::runtime_error Failed to create the session.
+     */
+    TLSSession(const TLSContext& ctx, FileDescriptor socket);
+
+    ~TLSSession() noexcept override;
+
+    TLSSession(const TLSSession&) = delete;
+
+    TLSSession(TLSSession&&) = delete;
+
+    TLSSession& operator=(const TLSSession&) = delete;
+
+    TLSSession& operator=(TLSSession&&) = delete;
+
+    /**
+     * @brief Continue the handshake.
+     *
+     * @return @p true if the handshake has finished, or @p false if it is waiting for the socket.
+     *
+     * @exception std::runtime_error The handshake failed.
+     */
+    bool Handshake();
+
+    //! Whether the handshake has finished.
+    bool Established() const noexcept;
+
+    //! Whether the unfinished handshake is waiting for the socket to be writable.
+    bool WantWrite() const noexcept;
+
+    //! Whether the session has been resumed without a full handshake.
+    bool Resumed() const noexcept;
+
+    //! Whether data sent to the socket is encrypted by the kernel.
+    bool KernelSend() const noexcept;
+
+    //! Whether data received from the socket is decrypted by the kernel.
+    bool KernelReceive() const noexcept;
+
+    //! Get the application protocol negotiated by ALPN, or an empty string if none.
+    std::string_view Protocol() const noexcept;
+
+    //! Get the number of decrypted bytes that are buffered in the session and can be read without the socket.
+    std::size_t Pending() const noexcept;
+
+    /**
+     * @brief Decrypt received data into a buffer.
+     *
+     * @return The number of bytes read, or zero if the client has closed the session.
+     *
+     * @exception std::system_error The socket has no data or failed to read.
+     * @exception std::runtime_error Failed to decrypt.
+     */
+    std::size_t WriteTo(Buffer& buf) override;
+
+    /**
+     * @brief Encrypt and send the readable data of a buffer, retrieving the sent part.
+     *
+     * @exception std::system_error The socket cannot accept more data or failed to write.
+     * @exception std::runtime_error Failed to encrypt.
+     */
+    std::size_t ReadFrom(Buffer& buf) override;
+
+    /**
+     * @brief Encrypt and send bytes.
+     *
+     * @details
+     * If the socket cannot accept more data, the same bytes must be passed again to resume,
+     * although their address may change.
+     *
+     * @return The number of bytes sent.
+     *
+     * @exception std::system_error The socket cannot accept more data or failed to write.
+     * @exception std::runtime_error Failed to encrypt.
+     */
+    std::size_t Write(std::span<const std::byte> bytes);
+
+    //! Send a closure alert without waiting for the client's one.
+    void Shutdown() noexcept;
+
+private:
+    //! Convert an OpenSSL result into an exception.
+    [[noreturn]] void ThrowError(int result, std::string_view operation) const;
+
+    ssl_st* ssl_ {nullptr};
+    bool established_ {false};
+    bool want_write_ {false};
+};
+
+}  // namespace ws::http
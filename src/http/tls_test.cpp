@@ -0,0 +1,295 @@
+#include "tls.h"
+#include "containers/buffer.h"
+#include "http.h"
+#include "test_util.h"
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+using namespace ws;
+using namespace ws::http;
+
+
+namespace {
+
+//! A self-signed certificate and its private key written to temporary files.
+class TestCertificate {
+public:
+    TestCertificate() :
+        dir_ {test::CreateTempTestDirectory()},
+        cert_ {dir_ / "cert.pem"},
+        key_ {dir_ / "key.pem"} {
+        const std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key {
+            EVP_EC_gen("P-256"), EVP_PKEY_free};
+        const std::unique_ptr<X509, decltype(&X509_free)> cert {X509_new(),
+                                                               X509_free};
+        if (!key || !cert) {
+            throw std::runtime_error {"Failed to create a test certificate"};
+        }
+
+        ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert.get()), 3600);
+        X509_set_pubkey(cert.get(), key.get());
+        const auto name {X509_get_subject_name(cert.get())};
+        X509_NAME_add_entry_by_txt(
+            name, "CN", MBSTRING_ASC,
+            reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert.get(), name);
+        X509_sign(cert.get(), key.get(), EVP_sha256());
+
+        const auto cert_file {std::fopen(cert_.c_str(), "w")};
+        PEM_write_X509(cert_file, cert.get());
+        std::fclose(cert_file);
+
+        const auto key_file {std::fopen(key_.c_str(), "w")};
+        PEM_write_PrivateKey(key_file, key.get(), nullptr, nullptr, 0,
+                             nullptr, nullptr);
+        std::fclose(key_file);
+    }
+
+    ~TestCertificate() noexcept {
+        std::error_code error;
+        std::filesystem::remove_all(dir_, error);
+    }
+
+    const std::filesystem::path& CertificatePath() const noexcept {
+        return cert_;
+    }
+
+    const std::filesystem::path& KeyPath() const noexcept {
+        return key_;
+    }
+
+private:
+    std::filesystem::path dir_;
+    std::filesystem::path cert_;
+    std::filesystem::path key_;
+};
+
+//! A TLS client on one end of a socket pair.
+class Client {
+public:
+    using SessionPtr = std::unique_ptr<SSL_SESSION, decltype(&SSL_SESSION_free)>;
+
+    explicit Client(const FileDescriptor socket,
+                    SSL_SESSION* const session = nullptr) :
+        ctx_ {SSL_CTX_new(TLS_client_method()), SSL_CTX_free},
+        ssl_ {SSL_new(ctx_.get()), SSL_free},
+        socket_ {socket} {
+        static constexpr std::array<unsigned char, 12> protocols {
+            2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
+        SSL_set_alpn_protos(ssl_.get(), protocols.data(), protocols.size());
+        SSL_set_fd(ssl_.get(), socket_);
+        if (session) {
+            SSL_set_session(ssl_.get(), session);
+        }
+
+        SSL_set_connect_state(ssl_.get());
+    }
+
+    ~Client() noexcept {
+        // A session freed without a closure alert cannot be resumed.
+        SSL_shutdown(ssl_.get());
+        close(socket_);
+    }
+
+    //! Continue the handshake, returning whether it has finished.
+    bool Handshake() noexcept {
+        return SSL_do_handshake(ssl_.get()) == 1;
+    }
+
+    void Write(const std::string_view data) noexcept {
+        EXPECT_EQ(SSL_write(ssl_.get(), data.data(), data.size()),
+                  static_cast<int>(data.size()));
+    }
+
+    //! Read all available decrypted data.
+    std::string Read() noexcept {
+        std::string data;
+        std::array<char, 0x4000> buf;
+        while (true) {
+            if (const auto size {SSL_read(ssl_.get(), buf.data(), buf.size())};
+                size > 0) {
+                data.append(buf.data(), size);
+            } else {
+                break;
+            }
+        }
+
+        return data;
+    }
+
+    //! Get the session for resumption.
+    SessionPtr Session() const noexcept {
+        return {SSL_get1_session(ssl_.get()), SSL_SESSION_free};
+    }
+
+private:
+    std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)> ctx_;
+    std::unique_ptr<SSL, decltype(&SSL_free)> ssl_;
+    FileDescriptor socket_;
+};
+
+//! Create a pair of connected non-blocking sockets.
+std::array<FileDescriptor, 2> CreateSocketPair() noexcept {
+    std::array<FileDescriptor, 2> sockets {};
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+    return sockets;
+}
+
+//! Run a handshake between a client and a session until both have finished.
+bool RunHandshake(Client& client, TLSSession& session) {
+    for (std::size_t i {0}; i != 0x10; ++i) {
+        const auto client_done {client.Handshake()};
+        if (session.Handshake() && client_done) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace
+
+TEST(TLSTest, InvalidCertificate) {
+    ASSERT_TRUE(TLSContext::Supported());
+    EXPECT_THROW((TLSContext {"/missing/cert.pem", "/missing/key.pem"}),
+                 std::runtime_error);
+
+    // A certificate and a key that do not match.
+    const TestCertificate cert;
+    const TestCertificate other;
+    EXPECT_THROW((TLSContext {cert.CertificatePath(), other.KeyPath()}),
+                 std::runtime_error);
+    EXPECT_NO_THROW(
+        (TLSContext {cert.CertificatePath(), cert.KeyPath()}));
+}
+
+TEST(TLSTest, HandshakeAndResumption) {
+    const TestCertificate cert;
+    const TLSContext ctx {cert.CertificatePath(), cert.KeyPath()};
+
+    Client::SessionPtr saved {nullptr, SSL_SESSION_free};
+    {
+        const auto [server_socket, client_socket] {CreateSocketPair()};
+        const RAII socket_raii {server_socket,
+                                [](const auto socket) noexcept { close(socket); }};
+        Client client {client_socket};
+        TLSSession session {ctx, server_socket};
+
+        EXPECT_FALSE(session.Established());
+        ASSERT_TRUE(RunHandshake(client, session));
+        EXPECT_TRUE(session.Established());
+        EXPECT_FALSE(session.Resumed());
+        EXPECT_EQ(session.Protocol(), "h2");
+
+        // The server cannot read before the client sends data.
+        Buffer buf;
+        EXPECT_THROW(session.WriteTo(buf), std::system_error);
+
+        client.Write("hello");
+        EXPECT_EQ(session.WriteTo(buf), 5);
+        EXPECT_EQ(buf.RetrieveAllToString(), "hello");
+
+        buf.Append("world");
+        EXPECT_EQ(session.ReadFrom(buf), 5);
+        EXPECT_EQ(buf.ReadableSize(), 0);
+
+        // Reading also receives session tickets sent after the handshake.
+        EXPECT_EQ(client.Read(), "world");
+        saved = client.Session();
+
+        session.Shutdown();
+    }
+
+    {
+        // A reconnecting client skips the full handshake.
+        const auto [server_socket, client_socket] {CreateSocketPair()};
+        const RAII socket_raii {server_socket,
+                                [](const auto socket) noexcept { close(socket); }};
+        Client client {client_socket, saved.get()};
+        TLSSession session {ctx, server_socket};
+
+        ASSERT_TRUE(RunHandshake(client, session));
+        EXPECT_TRUE(session.Resumed());
+    }
+}
+
+TEST(TLSTest, ServeHTTPOverTLS) {
+    // Like the server, ignore `SIGPIPE` as closure alerts may be sent to closed sockets.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const TestCertificate cert;
+    const RAII tls_raii {0, [](auto) noexcept { ConnectionImpl::DisableTLS(); }};
+    ConnectionImpl::SetTLSCertificate(cert.CertificatePath(), cert.KeyPath());
+    ASSERT_TRUE(ConnectionImpl::TLSEnabled());
+
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII dir_raii {std::pair {dir, old_root_dir},
+                         [](const auto& dirs) noexcept {
+                             ConnectionImpl::SetRootDirectory(dirs.second);
+                             std::error_code error;
+                             std::filesystem::remove_all(dirs.first, error);
+                         }};
+
+    ConnectionImpl::SetRootDirectory(dir);
+
+    // A large file, which is sent by `sendfile` without TLS.
+    std::string large(0x20000, '\0');
+    for (std::size_t i {0}; i != large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+
+    std::ofstream {std::filesystem::path {dir} / "large.txt"} << large;
+
+    const auto [server_socket, client_socket] {CreateSocketPair()};
+    Connection<IPv4Addr> conn {server_socket, IPv4Addr {"127.0.0.1", 0}};
+    Client client {client_socket};
+
+    // The connection stays alive during the handshake.
+    EXPECT_FALSE(client.Handshake());
+    EXPECT_EQ(conn.Receive(), 0);
+    EXPECT_TRUE(conn.KeepAlive());
+
+    bool established {false};
+    for (std::size_t i {0}; i != 0x10 && !established; ++i) {
+        established = client.Handshake();
+        EXPECT_EQ(conn.Receive(), 0);
+        EXPECT_FALSE(conn.Process());
+    }
+
+    ASSERT_TRUE(established);
+
+    client.Write("GET /large.txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n");
+    EXPECT_GT(conn.Receive(), 0);
+    ASSERT_TRUE(conn.Process());
+
+    // The response is sent in several calls as the socket becomes full.
+    std::string response;
+    while (conn.ToSendSize() > 0) {
+        conn.Send();
+        response += client.Read();
+    }
+
+    response += client.Read();
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 200 OK\r\n"));
+    EXPECT_TRUE(response.ends_with("\r\n\r\n" + large));
+    EXPECT_TRUE(conn.KeepAlive());
+}
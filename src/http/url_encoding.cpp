@@ -0,0 +1,90 @@
+#include "url_encoding.h"
+#include "containers/buffer.h"
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace ws::http {
+
+namespace {
+
+//! Convert a hexadecimal digit into its value.
+std::optional<std::uint8_t> HexDigitValue(const char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return std::nullopt;
+    }
+}
+
+}  // namespace
+
+std::string_view URLEncodingInstructionSet() noexcept {
+    return FindAnyOfInstructionSet();
+}
+
+std::size_t FindURLEscape(const std::string_view str) noexcept {
+    return FindAnyOf(str, "%");
+}
+
+std::size_t FindFormSeparator(const std::string_view str) noexcept {
+    return FindAnyOf(str, "+&=");
+}
+
+std::optional<char> DecodeHexPair(const char high, const char low) noexcept {
+    const auto high_val {HexDigitValue(high)};
+    const auto low_val {HexDigitValue(low)};
+    if (high_val.has_value() && low_val.has_value()) {
+        return static_cast<char>(high_val.value() << 4 | low_val.value());
+    } else {
+        return std::nullopt;
+    }
+}
+
+std::size_t DecodeURLEncodedInPlace(const std::span<char> str) {
+    static constexpr std::size_t encoded_length {3};
+    const auto data {str.data()};
+    const auto size {str.size()};
+    std::size_t in {0};
+    std::size_t out {0};
+    while (true) {
+        const auto escape {in + FindURLEscape({data + in, size - in})};
+
+        // Nothing is moved until the first URL-encoded character has been decoded.
+        if (out != in) {
+            std::memmove(data + out, data + in, escape - in);
+        }
+
+        out += escape - in;
+        if (escape == size) {
+            return out;
+        }
+
+        if (size - escape < encoded_length) {
+            throw std::invalid_argument {fmt::format(
+                "Invalid HTTP URL-encoding strings: '{}'",
+                std::string_view {data + escape, size - escape})};
+        }
+
+        if (const auto decoded {
+                DecodeHexPair(data[escape + 1], data[escape + 2])};
+            decoded.has_value()) {
+            data[out++] = decoded.value();
+            in = escape + encoded_length;
+        } else {
+            throw std::invalid_argument {
+                fmt::format("Invalid HTTP URL-encoding character: '{}'",
+                            std::string_view {data + escape, encoded_length})};
+        }
+    }
+}
+
+}  // namespace ws::http
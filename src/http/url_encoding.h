@@ -0,0 +1,68 @@
+/**
+ * @file url_encoding.h
+ * @brief The vectorized decoding of URL-encoded strings and forms.
+ *
+ * @details
+ * Special characters are searched in blocks with SIMD instructions by @p FindAnyOf,
+ * which is shared with buffers' delimiter searches.
+ *
+ * @author Zhenshuo Chen (chenzs108@outlook.com)
+ * @author Liu Guowen (liu.guowen@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-29
+ *
+ * @example src/http/url_encoding_test.cpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+
+namespace ws::http {
+
+//! Get the name of the instruction set used to search special characters.
+std::string_view URLEncodingInstructionSet() noexcept;
+
+/**
+ * @brief Find the first @p % in a string.
+ *
+ * @return The position of the character, or the size of the string if it is not found.
+ */
+std::size_t FindURLEscape(std::string_view str) noexcept;
+
+/**
+ * @brief Find the first character separating a URL-encoded form, which is one of @p +, @p & and @p =.
+ *
+ * @return The position of the character, or the size of the string if it is not found.
+ */
+std::size_t FindFormSeparator(std::string_view str) noexcept;
+
+/**
+ * @brief Convert a pair of hexadecimal digits into a byte.
+ *
+ * @return The byte, or @p std::nullopt if either of the characters is not a hexadecimal digit.
+ */
+std::optional<char> DecodeHexPair(char high, char low) noexcept;
+
+/**
+ * @brief Decode URL-encoded characters in place.
+ *
+ * @details
+ * Plain characters between URL-encoded ones are moved in blocks,
+ * so a string without @p % is only scanned.
+ *
+ * @param str A string, whose beginning will be replaced with the decoded string.
+ * @return The size of the decoded string.
+ *
+ * @exception std::invalid_argument
+ * The string contains a @p % that is not followed by a pair of hexadecimal digits.
+ */
+std::size_t DecodeURLEncodedInPlace(std::span<char> str);
+
+}  // namespace ws::http
@@ -0,0 +1,154 @@
+#include "url_encoding.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace ws;
+using namespace ws::http;
+
+
+namespace {
+
+/**
+ * @brief The previous scalar decoder, decoding one character at a time.
+ *
+ * @return The decoded string, or @p std::nullopt if the string is invalid.
+ */
+std::optional<std::string> ReferenceDecode(const std::string& str) {
+    std::ostringstream ss;
+    std::size_t i {0};
+    while (i < str.size()) {
+        if (str[i] == '%') {
+            if (const auto encoded {str.substr(i, 3)}; encoded.length() == 3) {
+                ss << static_cast<char>(std::stoi(encoded.substr(1), nullptr, 16));
+                i += 3;
+            } else {
+                return std::nullopt;
+            }
+        } else {
+            ss << str[i++];
+        }
+    }
+
+    return ss.str();
+}
+
+/**
+ * @brief Generate a random URL-encoded string.
+ *
+ * @details
+ * It consists of plain characters, form separators and URL-encoded characters.
+ * A @p % may be left at the end without enough digits.
+ */
+std::string RandomURLEncodedString(std::mt19937& engine) {
+    static constexpr std::string_view plain {
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~+&="};
+    static constexpr std::string_view hex {"0123456789abcdefABCDEF"};
+
+    std::uniform_int_distribution<std::size_t> length {0, 200};
+    std::uniform_int_distribution<std::size_t> kind {0, 9};
+    std::uniform_int_distribution<std::size_t> plain_index {0, plain.size() - 1};
+    std::uniform_int_distribution<std::size_t> hex_index {0, hex.size() - 1};
+
+    std::string str;
+    for (std::size_t i {0}, count {length(engine)}; i != count; ++i) {
+        if (kind(engine) == 0) {
+            str += '%';
+            str += hex[hex_index(engine)];
+            str += hex[hex_index(engine)];
+        } else {
+            str += plain[plain_index(engine)];
+        }
+    }
+
+    if (kind(engine) == 0) {
+        str += '%';
+        if (kind(engine) < 5) {
+            str += hex[hex_index(engine)];
+        }
+    }
+
+    return str;
+}
+
+}  // namespace
+
+
+TEST(URLEncodingTest, InstructionSet) {
+    EXPECT_FALSE(URLEncodingInstructionSet().empty());
+}
+
+TEST(URLEncodingTest, FindSpecialCharacters) {
+    EXPECT_EQ(FindURLEscape(""), 0);
+    EXPECT_EQ(FindURLEscape("hello"), 5);
+    EXPECT_EQ(FindURLEscape("hello%20world"), 5);
+    EXPECT_EQ(FindFormSeparator("id=1"), 2);
+    EXPECT_EQ(FindFormSeparator("mike+chen"), 4);
+    EXPECT_EQ(FindFormSeparator("%21&"), 3);
+
+    // Characters are found at every position of blocks and remaining bytes.
+    for (std::size_t size {1}; size != 100; ++size) {
+        for (std::size_t pos {0}; pos != size; ++pos) {
+            std::string str(size, 'a');
+            str[pos] = '%';
+            ASSERT_EQ(FindURLEscape(str), pos);
+            ASSERT_EQ(FindFormSeparator(str), size);
+
+            str[pos] = '=';
+            ASSERT_EQ(FindURLEscape(str), size);
+            ASSERT_EQ(FindFormSeparator(str), pos);
+        }
+    }
+}
+
+TEST(URLEncodingTest, DecodeHexPair) {
+    EXPECT_EQ(DecodeHexPair('2', '0'), ' ');
+    EXPECT_EQ(DecodeHexPair('7', 'e'), '~');
+    EXPECT_EQ(DecodeHexPair('7', 'E'), '~');
+    EXPECT_EQ(DecodeHexPair('f', 'f'), '\xff');
+
+    EXPECT_FALSE(DecodeHexPair('2', 'g'));
+    EXPECT_FALSE(DecodeHexPair(' ', '1'));
+    EXPECT_FALSE(DecodeHexPair('-', '1'));
+}
+
+TEST(URLEncodingTest, DecodeInPlace) {
+    std::string str {"hello%20world%21"};
+    str.resize(DecodeURLEncodedInPlace(str));
+    EXPECT_EQ(str, "hello world!");
+
+    // Malformed characters are rejected even if they are followed by valid ones.
+    str = "%2G";
+    EXPECT_THROW(DecodeURLEncodedInPlace(str), std::invalid_argument);
+    str = "%-1";
+    EXPECT_THROW(DecodeURLEncodedInPlace(str), std::invalid_argument);
+    str = "%2";
+    EXPECT_THROW(DecodeURLEncodedInPlace(str), std::invalid_argument);
+}
+
+TEST(URLEncodingTest, EquivalentToReference) {
+    std::mt19937 engine {0x20220729};
+    for (auto i {0}; i != 10000; ++i) {
+        const auto str {RandomURLEncodedString(engine)};
+        const auto expected {ReferenceDecode(str)};
+
+        auto decoded {str};
+        try {
+            decoded.resize(DecodeURLEncodedInPlace(decoded));
+            ASSERT_TRUE(expected.has_value()) << str;
+            ASSERT_EQ(decoded, expected.value()) << str;
+        } catch (const std::invalid_argument&) {
+            ASSERT_FALSE(expected.has_value()) << str;
+        }
+
+        ASSERT_EQ(FindFormSeparator(str),
+                  std::min(str.find_first_of("+&="), str.size()))
+            << str;
+    }
+}
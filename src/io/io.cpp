@@ -1,10 +1,16 @@
 #include "io.h"
 #include "containers/buffer.h"
+#include "containers/chunked_buffer.h"
 
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 
 
 namespace ws::io {
@@ -54,7 +60,7 @@ std::size_t FileDescriptor::WriteTo(Buffer& buf) {
     const auto size {readv(read_, bufs.data(), bufs.size())};
     if (size < 0) {
         ThrowLastSystemError();
-    } else if (size <= buf_bytes.size_bytes()) {
+    } else if (static_cast<std::size_t>(size) <= buf_bytes.size_bytes()) {
         buf.HasWritten(size);
     } else {
         buf.HasWritten(buf_bytes.size_bytes());
@@ -76,4 +82,167 @@ std::size_t FileDescriptor::ReadFrom(Buffer& buf) {
     }
 }
 
+std::size_t FileDescriptor::ReadFrom(const std::span<Buffer* const> bufs) {
+    std::array<std::span<const std::byte>, max_gather_count> segments;
+    std::size_t count {0};
+    for (const auto buf : bufs) {
+        if (count == segments.size()) {
+            break;
+        }
+
+        assert(buf);
+        if (const auto bytes {buf->ReadableBytes()}; !bytes.empty()) {
+            segments[count++] = bytes;
+        }
+    }
+
+    const auto size {Write({segments.data(), count})};
+
+    // Retrieve written data from buffers in order.
+    auto remaining {size};
+    for (const auto buf : bufs) {
+        if (remaining == 0) {
+            break;
+        }
+
+        const auto retrieved {std::min(remaining, buf->ReadableSize())};
+        buf->Retrieve(retrieved);
+        remaining -= retrieved;
+    }
+
+    return size;
+}
+
+std::size_t FileDescriptor::Write(
+    const std::span<const std::span<const std::byte>> segments,
+    const bool more) {
+    std::array<iovec, max_gather_count> vecs;
+    std::size_t count {0};
+    for (const auto segment : segments) {
+        if (count == vecs.size()) {
+            break;
+        }
+
+        if (!segment.empty()) {
+            vecs[count++] = {.iov_base = const_cast<std::byte*>(segment.data()),
+                             .iov_len = segment.size_bytes()};
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (more) {
+        const msghdr msg {.msg_name = nullptr,
+                          .msg_namelen = 0,
+                          .msg_iov = vecs.data(),
+                          .msg_iovlen = count,
+                          .msg_control = nullptr,
+                          .msg_controllen = 0,
+                          .msg_flags = 0};
+        if (const auto size {sendmsg(write_, &msg, MSG_MORE | MSG_NOSIGNAL)};
+            size >= 0) {
+            return size;
+        } else {
+            ThrowLastSystemError();
+        }
+    }
+
+    if (const auto size {writev(write_, vecs.data(), count)}; size >= 0) {
+        return size;
+    } else {
+        ThrowLastSystemError();
+    }
+}
+
+std::size_t FileDescriptor::WriteTo(ChunkedBuffer& buf, const std::size_t size) {
+    std::array<std::span<std::byte>, max_gather_count> segments;
+    const auto count {buf.WritableSegments(size, segments)};
+
+    std::array<iovec, max_gather_count> vecs;
+    for (std::size_t i {0}; i != count; ++i) {
+        vecs[i] = {.iov_base = segments[i].data(),
+                   .iov_len = segments[i].size_bytes()};
+    }
+
+    if (const auto read_size {readv(read_, vecs.data(), count)};
+        read_size >= 0) {
+        buf.HasWritten(read_size);
+        return read_size;
+    } else {
+        ThrowLastSystemError();
+    }
+}
+
+std::size_t SendFile(const ws::FileDescriptor out, const ws::FileDescriptor in,
+                     std::size_t& offset, const std::size_t count) {
+    auto file_offset {static_cast<off_t>(offset)};
+    if (const auto size {sendfile(out, in, &file_offset, count)}; size >= 0) {
+        offset = file_offset;
+        return size;
+    } else {
+        ThrowLastSystemError();
+    }
+}
+
+SplicePipe::SplicePipe() {
+    std::array<ws::FileDescriptor, 2> fds {};
+    if (pipe2(fds.data(), O_NONBLOCK | O_CLOEXEC) < 0) {
+        ThrowLastSystemError();
+    }
+
+    read_ = fds[0];
+    write_ = fds[1];
+}
+
+SplicePipe::~SplicePipe() noexcept {
+    close(read_);
+    close(write_);
+}
+
+std::size_t SplicePipe::PendingSize() const noexcept {
+    return pending_size_;
+}
+
+std::size_t SplicePipe::Flush(const ws::FileDescriptor out) {
+    std::size_t total {0};
+    while (pending_size_ > 0) {
+        if (const auto size {splice(read_, nullptr, out, nullptr, pending_size_,
+                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK)};
+            size >= 0) {
+            assert(static_cast<std::size_t>(size) <= pending_size_);
+            pending_size_ -= size;
+            total += size;
+        } else {
+            ThrowLastSystemError();
+        }
+    }
+
+    return total;
+}
+
+std::size_t SplicePipe::Send(const ws::FileDescriptor out,
+                             const ws::FileDescriptor in, std::size_t& offset,
+                             const std::size_t count) {
+    // Data left by the previous call must be sent before reading more.
+    auto total {Flush(out)};
+    if (count == 0) {
+        return total;
+    }
+
+    auto file_offset {static_cast<off_t>(offset)};
+    if (const auto size {splice(in, &file_offset, write_, nullptr, count,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK)};
+        size >= 0) {
+        offset = file_offset;
+        pending_size_ += size;
+    } else {
+        ThrowLastSystemError();
+    }
+
+    total += Flush(out);
+    return total;
+}
+
 }  // namespace ws::io
\ No newline at end of file
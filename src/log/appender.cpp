@@ -1,5 +1,7 @@
 #include "log.h"
+#include "containers/perfect_hash_map.h"
 
+#include <cassert>
 #include <stdexcept>
 #include <syncstream>
 
@@ -7,29 +9,40 @@
 namespace ws::log {
 
 std::string_view AppenderTypeToString(const AppenderType type) noexcept {
-    static const std::unordered_map<AppenderType, std::string_view> types {
-        {AppenderType::StdOut, "StdOut"}, {AppenderType::File, "File"}};
-
-    return types.at(type);
+    switch (type) {
+        case AppenderType::StdOut:
+            return "StdOut";
+        case AppenderType::File:
+            return "File";
+        default:
+            assert(false);
+            return {};
+    }
 }
 
 std::string to_string(const AppenderType type) noexcept {
     return AppenderTypeToString(type).data();
 }
 
-AppenderType StringToAppenderType(std::string str) {
-    static const std::unordered_map<std::string_view, AppenderType> types {
-        {"STDOUT", AppenderType::StdOut}, {"FILE", AppenderType::File}};
+AppenderType StringToAppenderType(const std::string_view str) {
+    static constexpr auto types {MakePerfectHashMap<AppenderType>({
+        {"StdOut", AppenderType::StdOut},
+        {"File", AppenderType::File},
+    })};
 
-    str = StringToUpper(str);
-    if (const auto type {types.find(str)}; type != types.cend()) {
-        return type->second;
+    if (const auto type {types.Find(str)}; type.has_value()) {
+        return type.value();
     } else {
         throw std::invalid_argument {
             fmt::format("Invalid log appender type: '{}'", str)};
     }
 }
 
+bool operator==(const FlushPolicy& lhs, const FlushPolicy& rhs) noexcept {
+    return lhs.buffer_size == rhs.buffer_size && lhs.interval == rhs.interval
+           && lhs.level == rhs.level;
+}
+
 Appender::Appender(const std::string_view pattern) {
     SetFormatter(pattern);
 }
@@ -51,10 +64,55 @@ void Appender::SetFormatter(const std::string_view pattern) {
     SetFormatter(std::make_shared<log::Formatter>(pattern));
 }
 
-void StdOutAppender::Log(const Logger& logger, const Event& event) noexcept {
+FlushPolicy Appender::GetFlushPolicy() const noexcept {
+    const std::lock_guard locker {mtx_};
+    return flush_policy_;
+}
+
+void Appender::SetFlushPolicy(const FlushPolicy& policy) noexcept {
+    const std::lock_guard locker {mtx_};
+    flush_policy_ = policy;
+    if (buffer_.capacity() < policy.buffer_size) {
+        buffer_.reserve(policy.buffer_size);
+    }
+}
+
+void Appender::Log(const Logger& logger, const Event& event) noexcept {
+    const std::lock_guard locker {mtx_};
+    formatter_->Format(buffer_, logger, event);
+
+    // The event time is used instead of the current time to avoid reading the clock.
+    if (buffer_.size() >= flush_policy_.buffer_size
+        || event.Level() >= flush_policy_.level
+        || event.Time() - last_flush_time_ >= flush_policy_.interval) {
+        FlushBuffer();
+    }
+}
+
+void Appender::Flush() noexcept {
     const std::lock_guard locker {mtx_};
-    std::osyncstream {std::cout} << formatter_->Format(logger, event)
-                                 << std::flush;
+    FlushBuffer();
+}
+
+void Appender::FlushBuffer() noexcept {
+    if (!buffer_.empty()) {
+        Write(buffer_);
+
+        // Keep the allocated memory for later events.
+        buffer_.clear();
+    }
+
+    last_flush_time_ = Event::Clock::now();
+}
+
+void Appender::FlushPolicyToYaml(YAML::Node& node) const noexcept {
+    node["buffer_size"] = flush_policy_.buffer_size;
+    node["flush_interval"] = flush_policy_.interval.count();
+    node["flush_level"] = LevelToString(flush_policy_.level).data();
+}
+
+void StdOutAppender::Write(const std::string_view logs) noexcept {
+    std::osyncstream {std::cout} << logs << std::flush;
 }
 
 std::string StdOutAppender::ToYamlString() const noexcept {
@@ -66,6 +124,8 @@ std::string StdOutAppender::ToYamlString() const noexcept {
         node["formatter"] = formatter_->Pattern().data();
     }
 
+    FlushPolicyToYaml(node);
+
     std::ostringstream ss;
     ss << node;
     return ss.str();
@@ -73,7 +133,7 @@ std::string StdOutAppender::ToYamlString() const noexcept {
 
 FileAppender::FileAppender(const std::string_view file_name,
                            const Formatter::Ptr formatter) :
-    file_name_ {file_name}, Appender {formatter} {
+    Appender {formatter}, file_name_ {file_name} {
     file_.open(file_name_, std::ofstream::app);
     if (!file_.good()) {
         ThrowLastSystemError();
@@ -90,14 +150,16 @@ std::string FileAppender::ToYamlString() const noexcept {
         node["formatter"] = formatter_->Pattern().data();
     }
 
+    FlushPolicyToYaml(node);
+
     std::ostringstream ss;
     ss << node;
     return ss.str();
 }
 
-void FileAppender::Log(const Logger& logger, const Event& event) noexcept {
-    const std::lock_guard locker {mtx_};
-    file_ << formatter_->Format(logger, event) << std::flush;
+void FileAppender::Write(const std::string_view logs) noexcept {
+    file_.write(logs.data(), logs.size());
+    file_.flush();
 }
 
 }  // namespace ws::log
\ No newline at end of file
@@ -7,7 +7,7 @@ namespace ws::log {
 
 bool operator==(const AppenderConfig& lhs, const AppenderConfig& rhs) noexcept {
     return lhs.type == rhs.type && lhs.formatter == rhs.formatter
-           && lhs.file == rhs.file;
+           && lhs.file == rhs.file && lhs.flush == rhs.flush;
 }
 
 bool operator!=(const AppenderConfig& lhs, const AppenderConfig& rhs) noexcept {
@@ -16,7 +16,9 @@ bool operator!=(const AppenderConfig& lhs, const AppenderConfig& rhs) noexcept {
 
 bool operator==(const LoggerConfig& lhs, const LoggerConfig& rhs) noexcept {
     return lhs.name == rhs.name && lhs.level == rhs.level
-           && lhs.capacity == rhs.capacity && lhs.formatter == rhs.formatter
+           && lhs.capacity == rhs.capacity && lhs.overflow == rhs.overflow
+           && lhs.cpus == rhs.cpus
+           && lhs.formatter == rhs.formatter
            && lhs.appenders == rhs.appenders;
 }
 
@@ -41,11 +43,24 @@ cfg::Var<std::unordered_set<LoggerConfig>>::Ptr SetListener(
 
                 // Create a new logger.
                 const auto logger {manager->FindLogger(
-                    logger_cfg.name, logger_cfg.level, logger_cfg.capacity)};
+                    logger_cfg.name, logger_cfg.level, logger_cfg.capacity,
+                    logger_cfg.overflow)};
                 if (!logger_cfg.formatter.empty()) {
                     logger->SetDefaultFormatter(logger_cfg.formatter);
                 }
 
+                if (!logger_cfg.cpus.empty()) {
+                    try {
+                        logger->SetWriterAffinity(
+                            ParseCPUList(logger_cfg.cpus));
+                    } catch (const std::exception& err) {
+                        WS_LOG_WARN(logger,
+                                    "Failed to pin the writer thread of "
+                                    "logger '{}': {}",
+                                    logger_cfg.name, err.what());
+                    }
+                }
+
                 // Add appenders.
                 logger->ClearAppenders();
                 for (const auto& appender_cfg : logger_cfg.appenders) {
@@ -66,6 +81,7 @@ cfg::Var<std::unordered_set<LoggerConfig>>::Ptr SetListener(
                         }
                     }
 
+                    appender->SetFlushPolicy(appender_cfg.flush);
                     logger->AddAppender(appender);
                 }
             }
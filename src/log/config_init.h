@@ -11,10 +11,15 @@
  *   - name: root
  *     level: info
  *     capacity: 50
+ *     overflow: drop
+ *     cpus: 3
  *     appenders:
  *       - type: stdout
  *       - type: file
  *         file: log.txt
+ *         buffer_size: 8192
+ *         flush_interval: 500
+ *         flush_level: warn
  *   - name: system
  *     level: debug
  *     formatter: "%d%T%m%n"
@@ -47,6 +52,9 @@ struct AppenderConfig {
 
     //! Only required for file writters.
     std::string file;
+
+    //! Optional.
+    FlushPolicy flush;
 };
 
 bool operator==(const AppenderConfig&, const AppenderConfig&) noexcept;
@@ -62,6 +70,12 @@ struct LoggerConfig {
     //! Optional.
     std::size_t capacity;
 
+    //! Optional, only used by asynchronous loggers.
+    OverflowPolicy overflow;
+
+    //! Optional, only used by asynchronous loggers. CPUs where the writer thread runs, such as @p 2-3.
+    std::string cpus;
+
     //! Optional.
     std::string formatter;
 
@@ -105,6 +119,23 @@ public:
             appender.formatter = node["formatters"].as<std::string>();
         }
 
+        if (node["buffer_size"]) {
+            ThrowIfYamlFieldIsNotScalar(node, "buffer_size");
+            appender.flush.buffer_size = node["buffer_size"].as<std::size_t>();
+        }
+
+        if (node["flush_interval"]) {
+            ThrowIfYamlFieldIsNotScalar(node, "flush_interval");
+            appender.flush.interval = std::chrono::milliseconds {
+                node["flush_interval"].as<std::chrono::milliseconds::rep>()};
+        }
+
+        if (node["flush_level"]) {
+            ThrowIfYamlFieldIsNotScalar(node, "flush_level");
+            appender.flush.level =
+                log::StringToLevel(node["flush_level"].as<std::string>());
+        }
+
         return appender;
     }
 };
@@ -124,6 +155,10 @@ public:
             node["formatter"] = appender.formatter;
         }
 
+        node["buffer_size"] = appender.flush.buffer_size;
+        node["flush_interval"] = appender.flush.interval.count();
+        node["flush_level"] = log::LevelToString(appender.flush.level).data();
+
         std::ostringstream ss;
         ss << node;
         return ss.str();
@@ -149,6 +184,18 @@ public:
             logger.capacity = node["capacity"].as<std::size_t>();
         }
 
+        if (node["overflow"]) {
+            ThrowIfYamlFieldIsNotScalar(node, "overflow");
+            logger.overflow =
+                log::StringToOverflowPolicy(node["overflow"].as<std::string>());
+        }
+
+        if (node["cpus"]) {
+            ThrowIfYamlFieldIsNotScalar(node, "cpus");
+            logger.cpus = node["cpus"].as<std::string>();
+            ParseCPUList(logger.cpus);
+        }
+
         if (node["formatter"]) {
             ThrowIfYamlFieldIsNotScalar(node, "formatter");
             logger.formatter = node["formatter"].as<std::string>();
@@ -171,6 +218,8 @@ public:
         node["name"] = logger.name;
         node["level"] = log::LevelToString(logger.level).data();
         node["capacity"] = logger.capacity;
+        node["overflow"] = log::OverflowPolicyToString(logger.overflow).data();
+        node["cpus"] = logger.cpus;
         node["formatter"] = logger.formatter;
         node["appenders"] =
             VarConverter<std::list<log::AppenderConfig>, std::string> {}(
@@ -15,6 +15,7 @@ using ws::log::AppenderType;
 using ws::log::Formatter;
 using ws::log::Level;
 using ws::log::Manager;
+using ws::log::OverflowPolicy;
 
 
 TEST(LoggerConfigurationTest, Construction) {
@@ -22,6 +23,8 @@ TEST(LoggerConfigurationTest, Construction) {
 - name: root
   level: info
   capacity: 50
+  overflow: drop
+  cpus: 0
   appenders:
     - type: stdout
 - name: system
@@ -48,6 +51,8 @@ TEST(LoggerConfigurationTest, Construction) {
         if (cfg.name == "root") {
             EXPECT_EQ(cfg.level, Level::Info);
             EXPECT_EQ(cfg.capacity, 50);
+            EXPECT_EQ(cfg.overflow, OverflowPolicy::Drop);
+            EXPECT_EQ(cfg.cpus, "0");
             EXPECT_TRUE(cfg.formatter.empty());
             EXPECT_EQ(
                 cfg.appenders,
@@ -56,6 +61,8 @@ TEST(LoggerConfigurationTest, Construction) {
         } else if (cfg.name == "system") {
             EXPECT_EQ(cfg.level, Level::Debug);
             EXPECT_EQ(cfg.capacity, 0);
+            EXPECT_EQ(cfg.overflow, OverflowPolicy::Block);
+            EXPECT_TRUE(cfg.cpus.empty());
             EXPECT_EQ(cfg.formatter, "%d");
             EXPECT_EQ(cfg.appenders, (std::list<AppenderConfig> {
                                          {.type = AppenderType::StdOut},
@@ -73,6 +80,7 @@ TEST(LoggerConfigurationTest, Construction) {
                 if (cfg.name == "root") {
                     EXPECT_EQ(logger->GetLevel(), Level::Info);
                     EXPECT_EQ(logger->Capacity(), 50);
+                    EXPECT_EQ(logger->Overflow(), OverflowPolicy::Drop);
                     EXPECT_EQ(logger->GetDefaultFormatter()->Pattern(),
                               Formatter::Default()->Pattern());
                 } else if (cfg.name == "system") {
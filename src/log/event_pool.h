@@ -0,0 +1,139 @@
+/**
+ * @file event_pool.h
+ * @brief The per-thread memory pool for log events.
+ *
+ * @author Chen Zhenshuo (chenzs108@outlook.com)
+ * @par GitHub
+ * https://github.com/Zhuagenborn
+ * @version 1.0
+ * @date 2022-07-20
+ *
+ * @example src/log/event_pool_test.cpp
+ */
+
+#pragma once
+
+#include "containers/mpsc_queue.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+
+namespace ws::log {
+
+/**
+ * @brief The pool of memory blocks with the same size.
+ *
+ * @details
+ * A pool belongs to a thread, which is the only one acquiring blocks from it.
+ * Blocks can be released in any thread, usually the writer thread of an asynchronous logger,
+ * so they are returned through a lock-free multi-producer single-consumer queue.
+ * Blocks released when the pool is full are freed.
+ */
+class BlockPool {
+public:
+    /**
+     * @brief Create a block pool.
+     *
+     * @param capacity The maximum number of kept blocks.
+     */
+    explicit BlockPool(std::size_t capacity = 0x100) noexcept :
+        free_blocks_ {capacity} {}
+
+    ~BlockPool() noexcept {
+        while (const auto block {free_blocks_.TryPop()}) {
+            ::operator delete(block.value());
+        }
+    }
+
+    BlockPool(const BlockPool&) = delete;
+
+    BlockPool(BlockPool&&) = delete;
+
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    BlockPool& operator=(BlockPool&&) = delete;
+
+    /**
+     * @brief Get a block in the owner thread.
+     *
+     * @param size The block size, which must be the same for all blocks.
+     *
+     * @exception std::bad_alloc Failed to allocate memory.
+     */
+    void* Acquire(const std::size_t size) {
+        assert(block_size_ == 0 || block_size_ == size);
+        block_size_ = size;
+        if (auto block {free_blocks_.TryPop()}) {
+            return block.value();
+        } else {
+            return ::operator new(size);
+        }
+    }
+
+    //! Return a block in any thread, or free it if the pool is full.
+    void Release(void* block) noexcept {
+        assert(block);
+        if (!free_blocks_.TryPush(std::move(block))) {
+            ::operator delete(block);
+        }
+    }
+
+    //! Get the approximate number of kept blocks.
+    std::size_t Size() const noexcept {
+        return free_blocks_.Size();
+    }
+
+private:
+    MPSCQueue<void*> free_blocks_;
+    std::size_t block_size_ {0};
+};
+
+/**
+ * @brief The allocator getting memory from a block pool.
+ *
+ * @details
+ * It is used with @p std::allocate_shared,
+ * so an object and its control block take a single pooled block.
+ * The allocator stored in the control block keeps the pool alive until the object is destroyed,
+ * even if the owner thread has exited.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool) noexcept :
+        pool_ {std::move(pool)} {
+        assert(pool_);
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept :
+        pool_ {other.pool_} {}
+
+    T* allocate(const std::size_t n) {
+        assert(n == 1);
+        return static_cast<T*>(pool_->Acquire(sizeof(T)));
+    }
+
+    void deallocate(T* const ptr, const std::size_t n) noexcept {
+        assert(n == 1);
+        pool_->Release(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<BlockPool> pool_;
+};
+
+}  // namespace ws::log
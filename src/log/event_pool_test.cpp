@@ -0,0 +1,50 @@
+#include "event_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <thread>
+
+using namespace ws::log;
+
+
+TEST(BlockPoolTest, ReuseBlocks) {
+    constexpr std::size_t block_size {0x40};
+    BlockPool pool {2};
+    EXPECT_EQ(pool.Size(), 0);
+
+    const auto block {pool.Acquire(block_size)};
+    pool.Release(block);
+    EXPECT_EQ(pool.Size(), 1);
+
+    // A released block is reused.
+    EXPECT_EQ(pool.Acquire(block_size), block);
+    EXPECT_EQ(pool.Size(), 0);
+    pool.Release(block);
+
+    // Blocks released when the pool is full are freed.
+    const auto blocks {std::array {pool.Acquire(block_size),
+                                   pool.Acquire(block_size),
+                                   pool.Acquire(block_size)}};
+    for (const auto block : blocks) {
+        pool.Release(block);
+    }
+
+    EXPECT_EQ(pool.Size(), 2);
+}
+
+TEST(BlockPoolTest, ReleaseInAnotherThread) {
+    const auto pool {std::make_shared<BlockPool>()};
+    auto ptr {std::allocate_shared<int>(PoolAllocator<int> {pool}, 1)};
+    const auto block {ptr.get()};
+
+    // The object can outlive its creating thread's reference to the pool.
+    std::thread {[ptr = std::move(ptr)]() mutable noexcept { ptr.reset(); }}
+        .join();
+    EXPECT_EQ(pool->Size(), 1);
+
+    const auto reused {std::allocate_shared<int>(PoolAllocator<int> {pool}, 2)};
+    EXPECT_EQ(reused.get(), block);
+    EXPECT_EQ(*reused, 2);
+}
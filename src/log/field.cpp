@@ -1,114 +1,103 @@
 #include "field.h"
 
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <concepts>
 #include <ctime>
-#include <functional>
+#include <limits>
 #include <stdexcept>
 #include <unordered_map>
 
 
 namespace ws::log::field {
 
-void Message::Format(std::ostream& out, const Logger& logger,
-                     const Event& event) noexcept {
-    out << event.Message();
-}
-
-std::string_view Message::Tag() const noexcept {
-    return tag;
-}
-
-void Level::Format(std::ostream& out, const Logger& logger,
-                   const Event& event) noexcept {
-    out << LevelToString(event.Level());
-}
-
-std::string_view Level::Tag() const noexcept {
-    return tag;
-}
-
-void ThreadId::Format(std::ostream& out, const Logger& logger,
-                      const Event& event) noexcept {
-    out << event.ThreadId();
-}
-
-std::string_view ThreadId::Tag() const noexcept {
-    return tag;
-}
-
-DateTime::DateTime(const std::string_view format) noexcept : format_ {format} {
-    if (format_.empty()) {
-        format_ = default_format;
+namespace {
+
+//! Append a number to a string.
+template <std::integral T>
+void AppendNumber(std::string& out, const T num) noexcept {
+    std::array<char, std::numeric_limits<T>::digits10 + 2> str;
+    const auto [end, _] {
+        std::to_chars(str.data(), str.data() + str.size(), num)};
+    out.append(str.data(), end);
+}
+
+}  // namespace
+
+void FormatDateTime(std::string& out, const Formatter::Field& field,
+                    const Event::Clock::time_point time) noexcept {
+    assert(field.type == Formatter::Field::Type::DateTime);
+
+    //! The time rendered for a date time field in the current second.
+    struct RenderedTime {
+        std::size_t field_id {0};
+        std::time_t time {0};
+        std::string str;
+    };
+
+    // Fields with different IDs rarely collide, as there are only a few date time fields.
+    static constexpr std::size_t cache_size {4};
+    thread_local std::array<RenderedTime, cache_size> cache;
+
+    const auto sec {Event::Clock::to_time_t(time)};
+    auto& rendered {cache[field.id % cache_size]};
+    if (rendered.field_id != field.id || rendered.time != sec) {
+        std::tm local {};
+        localtime_r(&sec, &local);
+
+        std::array<char, 0x60> str;
+        const auto size {std::strftime(str.data(), str.size(),
+                                       field.arg.c_str(), &local)};
+        rendered.str.assign(str.data(), size);
+        rendered.field_id = field.id;
+        rendered.time = sec;
     }
-}
-
-std::string_view DateTime::Tag() const noexcept {
-    return tag;
-}
-
-void DateTime::Format(std::ostream& out, const Logger& logger,
-                      const Event& event) noexcept {
-    const auto time {Event::Clock::to_time_t(event.Time())};
-    char time_str[0x60] {0};
-    std::strftime(time_str, sizeof(time_str), format_.c_str(),
-                  std::localtime(&time));
-    out << time_str;
-}
-
-void FileName::Format(std::ostream& out, const Logger& logger,
-                      const Event& event) noexcept {
-    out << event.FileName();
-}
-
-std::string_view FileName::Tag() const noexcept {
-    return tag;
-}
-
-void LineNum::Format(std::ostream& out, const Logger& logger,
-                     const Event& event) noexcept {
-    out << event.LineNum();
-}
-
-std::string_view LineNum::Tag() const noexcept {
-    return tag;
-}
-
-void NewLine::Format(std::ostream& out, const Logger& logger,
-                     const Event& event) noexcept {
-    out << std::endl;
-}
-
-std::string_view NewLine::Tag() const noexcept {
-    return tag;
-}
 
-void Tab::Format(std::ostream& out, const Logger& logger,
-                 const Event& event) noexcept {
-    out << "\t";
+    out += rendered.str;
 }
 
-std::string_view Tab::Tag() const noexcept {
-    return tag;
-}
-
-RawString::RawString(const std::string_view content) noexcept :
-    content_ {content} {}
-
-void RawString::Format(std::ostream& out, const Logger& logger,
-                       const Event& event) noexcept {
-    out << content_;
-}
-
-std::string_view RawString::Tag() const noexcept {
-    return "";
-}
-
-void LoggerName::Format(std::ostream& out, const Logger& logger,
-                        const Event& event) noexcept {
-    out << logger.Name();
-}
-
-std::string_view LoggerName::Tag() const noexcept {
-    return tag;
+void Format(std::string& out, const Formatter::Field& field,
+            const Logger& logger, const Event& event) noexcept {
+    using Type = Formatter::Field::Type;
+    switch (field.type) {
+        case Type::RawString: {
+            out += field.arg;
+            break;
+        }
+        case Type::Message: {
+            out += event.Message();
+            break;
+        }
+        case Type::Level: {
+            out += LevelToString(event.Level());
+            break;
+        }
+        case Type::ThreadId: {
+            AppendNumber(out, event.ThreadId());
+            break;
+        }
+        case Type::DateTime: {
+            FormatDateTime(out, field, event.Time());
+            break;
+        }
+        case Type::FileName: {
+            out += event.FileName();
+            break;
+        }
+        case Type::LineNum: {
+            AppendNumber(out, event.LineNum());
+            break;
+        }
+        case Type::LoggerName: {
+            out += logger.Name();
+            break;
+        }
+        default: {
+            assert(false);
+        }
+    }
 }
 
 bool operator==(const RawField& lhs, const RawField& rhs) noexcept {
@@ -123,7 +112,7 @@ bool operator!=(const RawField& lhs, const RawField& rhs) noexcept {
 std::list<RawField> ParsePattern(const std::string_view pattern) {
     std::string raw_str;
     std::list<RawField> raw_fields;
-    for (auto i {0}; i < pattern.size(); ++i) {
+    for (std::size_t i {0}; i < pattern.size(); ++i) {
         if (pattern[i] != '%'
             || (i + 1 < pattern.size() && pattern[i + 1] == '%')) {
             raw_str.append(1, pattern[i]);
@@ -133,7 +122,7 @@ std::list<RawField> ParsePattern(const std::string_view pattern) {
             raw_str.clear();
         }
 
-        auto j {i + 1}, fmt_begin {0};
+        std::size_t j {i + 1}, fmt_begin {0};
         std::string type, fmt;
         auto processing {false};
         while (j < pattern.size()) {
@@ -178,60 +167,51 @@ std::list<RawField> ParsePattern(const std::string_view pattern) {
     return raw_fields;
 }
 
-std::list<Formatter::Field::Ptr> RawFieldsToFormatFields(
+std::vector<Formatter::Field> CompileFields(
     const std::list<RawField>& raw_fields) {
-    using Creator = std::function<Formatter::Field::Ptr(std::string_view)>;
-    static const std::unordered_map<std::string_view, Creator>
-        supported_fields {
-            {Message::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<Message>(format);
-             }},
-            {Level::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<Level>(format);
-             }},
-            {ThreadId::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<ThreadId>(format);
-             }},
-            {NewLine::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<NewLine>(format);
-             }},
-            {LoggerName::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<LoggerName>(format);
-             }},
-            {DateTime::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<DateTime>(format);
-             }},
-            {FileName::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<FileName>(format);
-             }},
-            {LineNum::tag,
-             [](const std::string_view format) noexcept {
-                 return std::make_shared<LineNum>(format);
-             }},
-            {Tab::tag, [](const std::string_view format) noexcept {
-                 return std::make_shared<Tab>(format);
-             }}};
-
-    std::list<Formatter::Field::Ptr> fields;
+    using Type = Formatter::Field::Type;
+    static const std::unordered_map<std::string_view, Type> supported_fields {
+        {tag::message, Type::Message},
+        {tag::level, Type::Level},
+        {tag::thread_id, Type::ThreadId},
+        {tag::date_time, Type::DateTime},
+        {tag::file_name, Type::FileName},
+        {tag::line_num, Type::LineNum},
+        {tag::logger_name, Type::LoggerName}};
+
+    // Date time fields of all formatters have different IDs.
+    static std::atomic_size_t date_time_count {0};
+
+    std::vector<Formatter::Field> fields;
+    const auto append_raw_str {[&fields](const std::string_view str) {
+        if (!fields.empty() && fields.back().type == Type::RawString) {
+            fields.back().arg += str;
+        } else {
+            fields.push_back(
+                {.type = Type::RawString, .arg = std::string {str}});
+        }
+    }};
+
     for (const auto& raw_field : raw_fields) {
         if (raw_field.raw_str) {
-            fields.push_back(
-                std::make_shared<field::RawString>(raw_field.content));
-        } else {
-            if (const auto field {supported_fields.find(raw_field.content)};
-                field != supported_fields.cend()) {
-                fields.push_back(field->second(raw_field.format));
-            } else {
-                throw std::invalid_argument {fmt::format(
-                    "Invalid log format field: '{}'", raw_field.content)};
+            append_raw_str(raw_field.content);
+        } else if (raw_field.content == tag::new_line) {
+            append_raw_str("\n");
+        } else if (raw_field.content == tag::tab) {
+            append_raw_str("\t");
+        } else if (const auto type {supported_fields.find(raw_field.content)};
+                   type != supported_fields.cend()) {
+            Formatter::Field field {.type = type->second, .arg = ""};
+            if (field.type == Type::DateTime) {
+                field.arg = raw_field.format.empty() ? default_date_time_format
+                                                     : raw_field.format;
+                field.id = ++date_time_count;
             }
+
+            fields.push_back(std::move(field));
+        } else {
+            throw std::invalid_argument {fmt::format(
+                "Invalid log format field: '{}'", raw_field.content)};
         }
     }
 
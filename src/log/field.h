@@ -1,6 +1,6 @@
 /**
  * @file field.h
- * @brief Sub-formatters for different event fields.
+ * @brief The compilation and formatting of event fields.
  *
  * @author Chen Zhenshuo (chenzs108@outlook.com)
  * @par GitHub
@@ -18,135 +18,28 @@
 #include <list>
 #include <string>
 #include <string_view>
+#include <vector>
 
 
 namespace ws::log::field {
 
-class Message : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"m"};
+//! Tags of fields, without the preceding symbol @p %.
+namespace tag {
 
-    using Field::Field;
+constexpr std::string_view message {"m"};
+constexpr std::string_view level {"p"};
+constexpr std::string_view thread_id {"t"};
+constexpr std::string_view date_time {"d"};
+constexpr std::string_view file_name {"f"};
+constexpr std::string_view line_num {"l"};
+constexpr std::string_view new_line {"n"};
+constexpr std::string_view tab {"T"};
+constexpr std::string_view logger_name {"c"};
 
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
+}  // namespace tag
 
-    std::string_view Tag() const noexcept override;
-};
-
-class Level : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"p"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class ThreadId : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"t"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class DateTime : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"d"};
-
-    static constexpr std::string_view default_format {"%Y-%m-%d %H:%M:%S"};
-
-    DateTime(std::string_view format = default_format) noexcept;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-
-private:
-    std::string format_;
-};
-
-class FileName : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"f"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class LineNum : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"l"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class NewLine : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"n"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class Tab : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"T"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
-
-class RawString : public Formatter::Field {
-public:
-    RawString(std::string_view content) noexcept;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-
-private:
-    std::string content_;
-};
-
-class LoggerName : public Formatter::Field {
-public:
-    static constexpr std::string_view tag {"c"};
-
-    using Field::Field;
-
-    void Format(std::ostream& out, const Logger& logger,
-                const Event& event) noexcept override;
-
-    std::string_view Tag() const noexcept override;
-};
+//! The default format of date time fields.
+constexpr std::string_view default_date_time_format {"%Y-%m-%d %H:%M:%S"};
 
 /**
  * @brief The raw field.
@@ -184,8 +77,28 @@ bool operator!=(const RawField&, const RawField&) noexcept;
 //! Parse a pattern string into raw fields.
 std::list<RawField> ParsePattern(std::string_view pattern);
 
-//! Convert raw fields into sub-formatters.
-std::list<Formatter::Field::Ptr> RawFieldsToFormatFields(
+/**
+ * @brief Compile raw fields into fields.
+ *
+ * @details Adjacent raw strings, tabs and new lines are merged into a single raw string.
+ *
+ * @exception std::invalid_argument A raw field has an unsupported tag.
+ */
+std::vector<Formatter::Field> CompileFields(
     const std::list<RawField>& raw_fields);
 
+//! Format a field of an event and append it to a string.
+void Format(std::string& out, const Formatter::Field& field,
+            const Logger& logger, const Event& event) noexcept;
+
+/**
+ * @brief Format a time and append it to a string.
+ *
+ * @details
+ * The rendered time is cached per thread for each date time field,
+ * so @p strftime only runs once per second.
+ */
+void FormatDateTime(std::string& out, const Formatter::Field& field,
+                    Event::Clock::time_point time) noexcept;
+
 }  // namespace ws::log::field
\ No newline at end of file
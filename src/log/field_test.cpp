@@ -2,6 +2,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <stdexcept>
+
 using namespace ws::log::field;
 
 
@@ -20,4 +23,56 @@ TEST(LogFormatFieldTest, ParsePattern) {
                                                             {false, "t", ""},
                                                             {true, "]", ""},
                                                             {false, "d", ""}}));
-}
\ No newline at end of file
+}
+TEST(LogFormatFieldTest, CompileFields) {
+    using Type = ws::log::Formatter::Field::Type;
+
+    // Raw strings, tabs and new lines are merged.
+    const auto fields {CompileFields(ParsePattern("[%t]%T%m%n"))};
+    ASSERT_EQ(fields.size(), 5);
+    EXPECT_EQ(fields[0].type, Type::RawString);
+    EXPECT_EQ(fields[0].arg, "[");
+    EXPECT_EQ(fields[1].type, Type::ThreadId);
+    EXPECT_EQ(fields[2].type, Type::RawString);
+    EXPECT_EQ(fields[2].arg, "]\t");
+    EXPECT_EQ(fields[3].type, Type::Message);
+    EXPECT_EQ(fields[4].type, Type::RawString);
+    EXPECT_EQ(fields[4].arg, "\n");
+
+    // Date time fields have a default format and different IDs.
+    const auto dates {CompileFields(ParsePattern("%d%d{%Y}"))};
+    ASSERT_EQ(dates.size(), 2);
+    EXPECT_EQ(dates[0].arg, default_date_time_format);
+    EXPECT_EQ(dates[1].arg, "%Y");
+    EXPECT_NE(dates[0].id, dates[1].id);
+
+    EXPECT_THROW(CompileFields(ParsePattern("%U")), std::invalid_argument);
+}
+
+TEST(LogFormatFieldTest, FormatDateTime) {
+    using namespace std::chrono_literals;
+    using Clock = ws::log::Event::Clock;
+
+    const auto fields {CompileFields(ParsePattern("%d{%S}%d{%M:%S}"))};
+    ASSERT_EQ(fields.size(), 2);
+
+    // 1970-01-01 00:01:05 UTC, whose minutes and seconds do not depend on most time zones.
+    const Clock::time_point time {65s};
+    std::string str;
+    FormatDateTime(str, fields[0], time);
+    EXPECT_EQ(str, "05");
+
+    // The cached time is reused in the same second.
+    FormatDateTime(str, fields[0], time + 500ms);
+    EXPECT_EQ(str, "0505");
+
+    // Another field is rendered with its own format.
+    str.clear();
+    FormatDateTime(str, fields[1], time);
+    EXPECT_EQ(str, "01:05");
+
+    // The time is rendered again in the next second.
+    str.clear();
+    FormatDateTime(str, fields[0], time + 1s);
+    EXPECT_EQ(str, "06");
+}
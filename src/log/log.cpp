@@ -1,10 +1,12 @@
 #include "log.h"
 #include "config_init.h"
+#include "event_pool.h"
 #include "field.h"
 
 #include <algorithm>
 #include <cassert>
 #include <stdexcept>
+#include <streambuf>
 
 
 namespace ws {
@@ -47,11 +49,39 @@ Level StringToLevel(std::string str) {
     }
 }
 
+std::string_view OverflowPolicyToString(const OverflowPolicy policy) noexcept {
+    static const std::unordered_map<OverflowPolicy, std::string_view> policies {
+        {OverflowPolicy::Block, "Block"},
+        {OverflowPolicy::Drop, "Drop"},
+        {OverflowPolicy::Sample, "Sample"}};
+
+    return policies.at(policy);
+}
+
+std::string to_string(const OverflowPolicy policy) noexcept {
+    return OverflowPolicyToString(policy).data();
+}
+
+OverflowPolicy StringToOverflowPolicy(std::string str) {
+    static const std::unordered_map<std::string_view, OverflowPolicy>
+        policies {{"BLOCK", OverflowPolicy::Block},
+                  {"DROP", OverflowPolicy::Drop},
+                  {"SAMPLE", OverflowPolicy::Sample}};
+
+    str = StringToUpper(str);
+    if (const auto policy {policies.find(str)}; policy != policies.cend()) {
+        return policy->second;
+    } else {
+        throw std::invalid_argument {
+            fmt::format("Invalid log overflow policy: '{}'", str)};
+    }
+}
+
 Event::Ptr Event::Create(const log::Level level,
                          std::experimental::source_location location,
                          const std::uint32_t thread_id,
                          Clock::time_point time) noexcept {
-    // Make `std::make_shared` have the access to the private constructor.
+    // Make `std::allocate_shared` have the access to the private constructor.
     struct MakeSharedEvent : public Event {
         MakeSharedEvent(const log::Level level,
                         std::experimental::source_location location,
@@ -60,10 +90,41 @@ Event::Ptr Event::Create(const log::Level level,
             Event {level, std::move(location), thread_id, std::move(time)} {}
     };
 
-    return std::make_shared<MakeSharedEvent>(level, std::move(location),
-                                             thread_id, std::move(time));
+    // Each thread allocates events from its own pool.
+    thread_local const auto pool {std::make_shared<BlockPool>()};
+    return std::allocate_shared<MakeSharedEvent>(
+        PoolAllocator<MakeSharedEvent> {pool}, level, std::move(location),
+        thread_id, std::move(time));
 }
 
+//! The output stream appending characters to an event's message.
+class Event::Stream : private std::streambuf, public std::ostream {
+public:
+    explicit Stream(Event& event) noexcept :
+        std::ostream {this}, event_ {event} {}
+
+private:
+    using std::streambuf::int_type;
+    using std::streambuf::traits_type;
+
+    int_type overflow(const int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            const auto c {traits_type::to_char_type(ch)};
+            event_.AppendMessage({&c, 1});
+        }
+
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* const str,
+                           const std::streamsize count) override {
+        event_.AppendMessage({str, static_cast<std::size_t>(count)});
+        return count;
+    }
+
+    Event& event_;
+};
+
 Event::Event(const log::Level level,
              const std::experimental::source_location location,
              const std::uint32_t thread_id, Clock::time_point time) noexcept :
@@ -73,6 +134,8 @@ Event::Event(const log::Level level,
     thread_id_ {thread_id},
     time_ {std::move(time)} {}
 
+Event::~Event() noexcept = default;
+
 log::Level Event::Level() const noexcept {
     return level_;
 }
@@ -93,17 +156,41 @@ Event::Clock::time_point Event::Time() const noexcept {
     return time_;
 }
 
-std::string Event::Message() const noexcept {
-    return msg_.str();
+std::string_view Event::Message() const noexcept {
+    if (heap_msg_.empty()) {
+        return {inline_msg_.data(), msg_size_};
+    } else {
+        return heap_msg_;
+    }
 }
 
-std::ostringstream& Event::MessageStream() noexcept {
-    return msg_;
+void Event::AppendMessage(const std::string_view msg) noexcept {
+    if (heap_msg_.empty()) {
+        if (msg_size_ + msg.size() <= inline_msg_.size()) {
+            std::ranges::copy(msg, inline_msg_.begin() + msg_size_);
+            msg_size_ += msg.size();
+            return;
+        }
+
+        // Move the message to the heap, leaving room for later strings.
+        heap_msg_.reserve(2 * (msg_size_ + msg.size()));
+        heap_msg_.assign(inline_msg_.data(), msg_size_);
+    }
+
+    heap_msg_ += msg;
+}
+
+std::ostream& Event::MessageStream() noexcept {
+    if (!stream_) {
+        stream_ = std::make_unique<Stream>(*this);
+    }
+
+    return *stream_;
 }
 
 Event::Ptr operator<<(const Event::Ptr event,
                       const std::string_view msg) noexcept {
-    event->MessageStream() << msg;
+    event->AppendMessage(msg);
     return event;
 }
 
@@ -114,7 +201,7 @@ EventWriter::~EventWriter() noexcept {
     logger_.Log(event_);
 }
 
-std::ostringstream& EventWriter::MessageStream() noexcept {
+std::ostream& EventWriter::MessageStream() noexcept {
     return event_->MessageStream();
 }
 
@@ -125,20 +212,22 @@ Formatter::Ptr Formatter::Default() noexcept {
     return ins;
 }
 
-Formatter::Field::Field(const std::string_view format) noexcept {}
-
 Formatter::Formatter(const std::string_view pattern) :
     pattern_ {pattern},
-    fields_ {field::RawFieldsToFormatFields(field::ParsePattern(pattern))} {}
+    fields_ {field::CompileFields(field::ParsePattern(pattern))} {}
 
 std::string Formatter::Format(const Logger& logger,
                               const Event& event) const noexcept {
-    std::ostringstream str;
-    std::ranges::for_each(fields_, [&str, &logger, &event](auto& it) noexcept {
-        it->Format(str, logger, event);
-    });
+    std::string str;
+    Format(str, logger, event);
+    return str;
+}
 
-    return str.str();
+void Formatter::Format(std::string& out, const Logger& logger,
+                       const Event& event) const noexcept {
+    for (const auto& field : fields_) {
+        field::Format(out, field, logger, event);
+    }
 }
 
 std::string_view Formatter::Pattern() const noexcept {
@@ -146,11 +235,15 @@ std::string_view Formatter::Pattern() const noexcept {
 }
 
 Logger::Logger(const std::string_view name, const log::Level level,
-               const std::optional<std::size_t> capacity) noexcept :
-    name_ {name}, level_ {level}, capacity_ {capacity.value_or(0)} {
+               const std::optional<std::size_t> capacity,
+               const OverflowPolicy overflow) noexcept :
+    name_ {name},
+    capacity_ {capacity.value_or(0)},
+    overflow_ {overflow},
+    level_ {level} {
     if (capacity_ > 0) {
         async_ = true;
-        event_deque_ = std::make_unique<BlockDeque<Event::Ptr>>(capacity_);
+        event_queue_ = std::make_unique<MPSCQueue<Event::Ptr>>(capacity_);
         writer_thread_ =
             std::make_unique<std::thread>(&Logger::AsyncLogProc, this);
     } else {
@@ -160,8 +253,9 @@ Logger::Logger(const std::string_view name, const log::Level level,
 
 Logger::~Logger() noexcept {
     if (async_) {
-        assert(event_deque_);
-        event_deque_->Close();
+        closed_.store(true, std::memory_order_release);
+        writer_signal_.fetch_add(1, std::memory_order_release);
+        writer_signal_.notify_one();
 
         assert(writer_thread_ && writer_thread_->joinable());
         writer_thread_->join();
@@ -169,12 +263,44 @@ Logger::~Logger() noexcept {
 }
 
 void Logger::AsyncLogProc() noexcept {
+    assert(event_queue_);
+    bool unflushed {false};
     while (true) {
-        if (const auto event {event_deque_->Pop()}; event) {
+        // Check the flag before popping, so events pushed before closing are all logged.
+        const auto closed {closed_.load(std::memory_order_acquire)};
+        if (const auto event {event_queue_->TryPop()}; event.has_value()) {
+            // Wake up producers waiting for the freed slot.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiting_producers_.load(std::memory_order_relaxed) > 0) {
+                space_signal_.fetch_add(1, std::memory_order_release);
+                space_signal_.notify_all();
+            }
+
             SyncLog(*event.value());
-        } else {
+            unflushed = true;
+            continue;
+        }
+
+        // Write all events of a burst together when the queue becomes empty.
+        if (unflushed) {
+            FlushAppenders();
+            unflushed = false;
+        }
+
+        if (closed) {
             return;
         }
+
+        // Sleep until a producer pushes an event.
+        // Producers check the flag after pushing, so either they see it or the writer sees their events.
+        const auto signal {writer_signal_.load(std::memory_order_acquire)};
+        writer_sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (event_queue_->Empty() && !closed_.load(std::memory_order_acquire)) {
+            writer_signal_.wait(signal, std::memory_order_acquire);
+        }
+
+        writer_sleeping_.store(false, std::memory_order_relaxed);
     }
 }
 
@@ -185,14 +311,83 @@ void Logger::SyncLog(const Event& event) noexcept {
     });
 }
 
+void Logger::FlushAppenders() noexcept {
+    const std::lock_guard locker {mtx_};
+    std::ranges::for_each(appenders_,
+                          [](auto& it) noexcept { it->Flush(); });
+}
+
 void Logger::Log(const Event::Ptr event) noexcept {
-    if (event->Level() >= level_) {
+    if (Enabled(event->Level())) {
         if (async_) {
-            const std::lock_guard locker {mtx_};
-            event_deque_->PushBack(std::move(event));
+            Enqueue(std::move(event));
         } else {
             SyncLog(*event);
+            FlushAppenders();
+        }
+    }
+}
+
+bool Logger::Enabled(const log::Level level) const noexcept {
+    return level >= level_.load(std::memory_order_relaxed);
+}
+
+void Logger::Enqueue(Event::Ptr event) noexcept {
+    assert(event_queue_);
+    if (event_queue_->TryPush(std::move(event))) {
+        NotifyWriter();
+        return;
+    }
+
+    // The event has not been moved since the queue is full.
+    switch (overflow_) {
+        case OverflowPolicy::Block: {
+            EnqueueWaiting(std::move(event));
+            return;
+        }
+        case OverflowPolicy::Sample: {
+            if (event->Level() >= Level::Error
+                || overflow_count_.fetch_add(1, std::memory_order_relaxed)
+                           % overflow_sample_interval
+                       == 0) {
+                EnqueueWaiting(std::move(event));
+                return;
+            }
+
+            [[fallthrough]];
+        }
+        case OverflowPolicy::Drop: {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        default: {
+            assert(false);
+        }
+    }
+}
+
+void Logger::EnqueueWaiting(Event::Ptr event) noexcept {
+    waiting_producers_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        const auto signal {space_signal_.load(std::memory_order_acquire)};
+        if (event_queue_->TryPush(std::move(event))) {
+            break;
         }
+
+        // The writer thread increases the signal after freeing a slot.
+        space_signal_.wait(signal, std::memory_order_acquire);
+    }
+
+    waiting_producers_.fetch_sub(1, std::memory_order_relaxed);
+    NotifyWriter();
+}
+
+void Logger::NotifyWriter() noexcept {
+    // Pair with the fence in the writer thread before it checks whether the queue is empty.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_sleeping_.load(std::memory_order_relaxed)) {
+        writer_signal_.fetch_add(1, std::memory_order_release);
+        writer_signal_.notify_one();
     }
 }
 
@@ -218,13 +413,11 @@ void Logger::ClearAppenders() noexcept {
 }
 
 log::Level Logger::GetLevel() const noexcept {
-    const std::lock_guard locker {mtx_};
-    return level_;
+    return level_.load(std::memory_order_relaxed);
 }
 
 void Logger::SetLevel(const log::Level level) noexcept {
-    const std::lock_guard locker {mtx_};
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 Formatter::Ptr Logger::GetDefaultFormatter() const noexcept {
@@ -248,6 +441,20 @@ std::size_t Logger::Capacity() const noexcept {
     return capacity_;
 }
 
+OverflowPolicy Logger::Overflow() const noexcept {
+    return overflow_;
+}
+
+std::size_t Logger::DroppedCount() const noexcept {
+    return dropped_count_.load(std::memory_order_relaxed);
+}
+
+void Logger::SetWriterAffinity(const std::span<const std::size_t> cpus) {
+    if (writer_thread_) {
+        SetThreadAffinity(writer_thread_->native_handle(), cpus);
+    }
+}
+
 std::string_view Logger::Name() const noexcept {
     return name_;
 }
@@ -257,7 +464,7 @@ std::string Logger::ToYamlString() const noexcept {
 
     YAML::Node node;
     node["name"] = name_;
-    node["level"] = LevelToString(level_).data();
+    node["level"] = LevelToString(GetLevel()).data();
 
     if (formatter_) {
         node["formatter"] = formatter_->Pattern().data();
@@ -291,13 +498,15 @@ std::string_view Manager::Name() const noexcept {
 
 Logger::Ptr Manager::FindLogger(
     const std::string_view name, const log::Level level,
-    const std::optional<std::size_t> capacity) noexcept {
+    const std::optional<std::size_t> capacity,
+    const OverflowPolicy overflow) noexcept {
     const std::lock_guard locker {mtx_};
     if (const auto logger {loggers_.find(name.data())};
         logger != loggers_.cend()) {
         return logger->second;
     } else {
-        const auto new_logger {std::make_shared<Logger>(name, level, capacity)};
+        const auto new_logger {std::make_shared<Logger>(
+            name, level, capacity, overflow)};
         loggers_.emplace(name, new_logger);
         return new_logger;
     }
@@ -358,6 +567,11 @@ std::ostream& operator<<(std::ostream& os, const Level level) noexcept {
     return os << LevelToString(level);
 }
 
+std::ostream& operator<<(std::ostream& os,
+                         const OverflowPolicy policy) noexcept {
+    return os << OverflowPolicyToString(policy);
+}
+
 }  // namespace log
 
 }  // namespace ws
\ No newline at end of file
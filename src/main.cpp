@@ -3,8 +3,12 @@
 #include "util.h"
 #include "web_server.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
 
 using namespace ws;
 
@@ -13,13 +17,102 @@ namespace {
 
 constexpr std::string_view port_tag {"server.port"};
 constexpr std::string_view asset_folder_tag {"server.asset_folder"};
+constexpr std::string_view asset_pack_tag {"server.asset_pack"};
 constexpr std::string_view alive_time_tag {"server.alive_time"};
+constexpr std::string_view reactors_tag {"server.reactors"};
+constexpr std::string_view coroutines_tag {"server.coroutines"};
+constexpr std::string_view disk_threads_tag {"server.disk_threads"};
+constexpr std::string_view thread_pool_tag {"server.thread_pool"};
+constexpr std::string_view poller_tag {"server.poller"};
+constexpr std::string_view max_events_tag {"server.max_events"};
+constexpr std::string_view busy_poll_tag {"server.busy_poll"};
+constexpr std::string_view high_water_mark_tag {"server.high_water_mark"};
+constexpr std::string_view accept_budget_tag {"server.listener.accept_budget"};
+constexpr std::string_view defer_accept_tag {"server.listener.defer_accept"};
+constexpr std::string_view fast_open_tag {"server.listener.fast_open"};
+constexpr std::string_view no_delay_tag {"server.listener.no_delay"};
+constexpr std::string_view send_buffer_tag {"server.listener.send_buffer"};
+constexpr std::string_view receive_buffer_tag {
+    "server.listener.receive_buffer"};
+constexpr std::string_view reactor_affinity_tag {"server.affinity.reactors"};
+constexpr std::string_view worker_affinity_tag {"server.affinity.workers"};
+constexpr std::string_view incoming_cpu_tag {"server.affinity.incoming_cpu"};
+constexpr std::string_view max_connections_tag {
+    "server.admission.max_connections"};
+constexpr std::string_view max_queued_tasks_tag {
+    "server.admission.max_queued_tasks"};
+constexpr std::string_view max_queue_time_tag {
+    "server.admission.max_queue_time"};
+constexpr std::string_view max_buffer_size_tag {
+    "server.admission.max_buffer_size"};
+constexpr std::string_view max_header_size_tag {
+    "server.request.max_header_size"};
+constexpr std::string_view max_header_count_tag {
+    "server.request.max_header_count"};
+constexpr std::string_view max_body_size_tag {"server.request.max_body_size"};
+constexpr std::string_view keep_alive_max_requests_tag {
+    "server.keep_alive.max_requests"};
+constexpr std::string_view asset_cache_size_tag {"server.asset_cache.size"};
+constexpr std::string_view asset_cache_revalidation_tag {
+    "server.asset_cache.revalidation"};
+constexpr std::string_view asset_cache_compression_tag {
+    "server.asset_cache.compression"};
+constexpr std::string_view tls_certificate_tag {"server.tls.certificate"};
+constexpr std::string_view tls_private_key_tag {"server.tls.private_key"};
+constexpr std::string_view metrics_path_tag {"server.metrics_path"};
+constexpr std::string_view trace_path_tag {"server.trace.path"};
+constexpr std::string_view trace_slow_threshold_tag {
+    "server.trace.slow_threshold"};
+constexpr std::string_view routes_tag {"server.routes"};
+
+//! The route target handling requests locally.
+constexpr std::string_view local_route {"local"};
 
 //! Initialize the default configuration.
 cfg::Config::Ptr InitDefaultConfig() noexcept {
     static constexpr std::uint16_t default_port {10000};
     static const std::string default_asset_folder {"assets"};
+    static const std::string default_asset_pack {};
     static constexpr std::size_t default_alive_time {60};
+    static constexpr std::size_t default_reactors {0};
+    static constexpr std::size_t default_coroutines {0};
+    static constexpr std::size_t default_disk_threads {0};
+    static const std::string default_thread_pool {"shared"};
+    static const std::string default_poller {"epoll"};
+    static constexpr std::size_t default_max_events {1024};
+    static constexpr std::size_t default_busy_poll {0};
+    static constexpr std::size_t default_high_water_mark {1024};
+    static constexpr std::size_t default_accept_budget {64};
+    static constexpr std::size_t default_defer_accept {0};
+    static constexpr std::size_t default_fast_open {0};
+    static constexpr std::size_t default_no_delay {1};
+    static constexpr std::size_t default_send_buffer {0};
+    static constexpr std::size_t default_receive_buffer {0};
+    static const std::string default_reactor_affinity {};
+    static const std::string default_worker_affinity {};
+    static constexpr std::size_t default_incoming_cpu {0};
+    static constexpr std::size_t default_max_connections {0};
+    static constexpr std::size_t default_max_queued_tasks {0};
+    static constexpr std::size_t default_max_queue_time {0};
+    static constexpr std::size_t default_max_buffer_size {0};
+    static constexpr std::size_t default_max_header_size {
+        http::RequestLimits {}.max_header_size / 0x400};
+    static constexpr std::size_t default_max_header_count {
+        http::RequestLimits {}.max_header_count};
+    static constexpr std::size_t default_max_body_size {
+        http::RequestLimits {}.max_body_size / 0x400};
+    static constexpr std::size_t default_keep_alive_max_requests {1000};
+    static constexpr std::size_t default_asset_cache_size {64};
+    static constexpr std::size_t default_asset_cache_revalidation {1};
+    static constexpr std::size_t default_asset_cache_compression {1};
+    static const std::string default_tls_certificate {};
+    static const std::string default_tls_private_key {};
+    static const std::string default_metrics_path {
+        http::ConnectionImpl::default_metrics_path};
+    static const std::string default_trace_path {
+        http::ConnectionImpl::default_trace_path};
+    static constexpr std::size_t default_trace_slow_threshold {0};
+    static const std::map<std::string, std::string> default_routes {};
 
     const auto config {cfg::RootConfig()};
     config->Lookup<std::uint16_t>(port_tag, default_port, "The listening port");
@@ -27,9 +120,147 @@ cfg::Config::Ptr InitDefaultConfig() noexcept {
                                 "The alive time of client (in seconds)");
     config->Lookup<std::string>(asset_folder_tag, default_asset_folder,
                                 "The asset folder");
+    config->Lookup<std::string>(
+        asset_pack_tag, default_asset_pack,
+        "The asset pack built by echo-asset-pack (empty to serve files from the asset folder only)");
+    config->Lookup<std::size_t>(
+        reactors_tag, default_reactors,
+        "The number of reactors (zero for a single reactor with a thread pool)");
+    config->Lookup<std::size_t>(
+        coroutines_tag, default_coroutines,
+        "Whether clients of multiple reactors are served by coroutines (zero to disable)");
+    config->Lookup<std::size_t>(
+        disk_threads_tag, default_disk_threads,
+        "The number of threads opening and reading files for coroutines (zero to disable)");
+    config->Lookup<std::string>(
+        thread_pool_tag, default_thread_pool,
+        "The thread pool type for a single reactor ('shared' or 'work-stealing')");
+    config->Lookup<std::string>(poller_tag, default_poller,
+                                "The poller backend ('epoll' or 'io_uring')");
+    config->Lookup<std::size_t>(
+        max_events_tag, default_max_events,
+        "The maximum number of events returned by each wait of a reactor");
+    config->Lookup<std::size_t>(
+        busy_poll_tag, default_busy_poll,
+        "The time for which a reactor polls without blocking before waiting (in microseconds, zero to disable)");
+    config->Lookup<std::size_t>(
+        high_water_mark_tag, default_high_water_mark,
+        "The high-water mark of each client's buffered data (in kilobytes)");
+    config->Lookup<std::size_t>(
+        accept_budget_tag, default_accept_budget,
+        "The maximum number of connections accepted in an iteration of a reactor");
+    config->Lookup<std::size_t>(
+        defer_accept_tag, default_defer_accept,
+        "The time for which the kernel waits for a new connection's first data (in seconds, zero to disable)");
+    config->Lookup<std::size_t>(
+        fast_open_tag, default_fast_open,
+        "The maximum number of pending TCP Fast Open requests (zero to disable)");
+    config->Lookup<std::size_t>(
+        no_delay_tag, default_no_delay,
+        "Whether accepted connections disable Nagle's algorithm by TCP_NODELAY (zero to disable)");
+    config->Lookup<std::size_t>(
+        send_buffer_tag, default_send_buffer,
+        "The socket send buffer size of accepted connections (in kilobytes, zero for the default)");
+    config->Lookup<std::size_t>(
+        receive_buffer_tag, default_receive_buffer,
+        "The socket receive buffer size of accepted connections (in kilobytes, zero for the default)");
+    config->Lookup<std::string>(
+        reactor_affinity_tag, default_reactor_affinity,
+        "CPUs where reactors run, such as '0-3' (empty to disable pinning)");
+    config->Lookup<std::string>(
+        worker_affinity_tag, default_worker_affinity,
+        "CPUs where working threads run in the classic mode (empty to disable pinning)");
+    config->Lookup<std::size_t>(
+        incoming_cpu_tag, default_incoming_cpu,
+        "Whether pinned reactors prefer connections processed on their CPUs by SO_INCOMING_CPU (zero to disable)");
+    config->Lookup<std::size_t>(
+        max_connections_tag, default_max_connections,
+        "The maximum number of connected clients, above which accepting pauses (zero to disable)");
+    config->Lookup<std::size_t>(
+        max_queued_tasks_tag, default_max_queued_tasks,
+        "The maximum number of tasks queued in the thread pool, above which new requests are rejected (zero to disable)");
+    config->Lookup<std::size_t>(
+        max_queue_time_tag, default_max_queue_time,
+        "The maximum time for which new requests wait in the thread pool before being rejected (in milliseconds, zero to disable)");
+    config->Lookup<std::size_t>(
+        max_buffer_size_tag, default_max_buffer_size,
+        "The maximum size of a client's incomplete request, above which it is rejected (in kilobytes, zero to disable)");
+    config->Lookup<std::size_t>(
+        max_header_size_tag, default_max_header_size,
+        "The maximum size of a request's status line and headers, above which it is rejected (in kilobytes, zero to disable)");
+    config->Lookup<std::size_t>(
+        max_header_count_tag, default_max_header_count,
+        "The maximum number of a request's headers, above which it is rejected (zero to disable)");
+    config->Lookup<std::size_t>(
+        max_body_size_tag, default_max_body_size,
+        "The maximum size of a request's body, above which it is rejected (in kilobytes, zero to disable)");
+    config->Lookup<std::size_t>(
+        keep_alive_max_requests_tag, default_keep_alive_max_requests,
+        "The maximum number of requests served on a persistent connection (zero for no limit)");
+    config->Lookup<std::size_t>(
+        asset_cache_size_tag, default_asset_cache_size,
+        "The capacity of the static asset cache (in megabytes, zero to disable)");
+    config->Lookup<std::size_t>(
+        asset_cache_revalidation_tag, default_asset_cache_revalidation,
+        "The interval between checks of a cached asset's modification time (in seconds)");
+    config->Lookup<std::size_t>(
+        asset_cache_compression_tag, default_asset_cache_compression,
+        "Whether to compress cached text assets with gzip (zero to disable)");
+    config->Lookup<std::string>(
+        tls_certificate_tag, default_tls_certificate,
+        "The certificate chain file for TLS (empty to disable TLS)");
+    config->Lookup<std::string>(tls_private_key_tag, default_tls_private_key,
+                                "The private key file for TLS");
+    config->Lookup<std::string>(
+        metrics_path_tag, default_metrics_path,
+        "The path where metrics are exposed (empty to disable)");
+    config->Lookup<std::string>(
+        trace_path_tag, default_trace_path,
+        "The path where traced request stages are dumped (empty to disable)");
+    config->Lookup<std::size_t>(
+        trace_slow_threshold_tag, default_trace_slow_threshold,
+        "The time above which traced requests are logged (in milliseconds, zero to disable)");
+    config->Lookup<std::map<std::string, std::string>>(
+        routes_tag, default_routes,
+        "Path prefixes mapped to upstream servers of the reverse proxy or 'local'");
     return config;
 }
 
+/**
+ * @brief Whether a thread pool type refers to the work-stealing thread pool.
+ *
+ * @exception std::invalid_argument The type is neither @p shared nor @p work-stealing.
+ */
+bool IsWorkStealingThreadPool(const std::string_view type) {
+    if (type == "work-stealing") {
+        return true;
+    } else if (type == "shared") {
+        return false;
+    } else {
+        throw std::invalid_argument {
+            fmt::format("Invalid thread pool type: '{}'", type)};
+    }
+}
+
+/**
+ * @brief Build the routing table of the reverse proxy.
+ *
+ * @param routes Path prefixes mapped to upstream addresses, or @p local to handle requests locally.
+ *
+ * @exception std::invalid_argument A route is invalid.
+ */
+http::RoutingTable ParseRoutes(
+    const std::map<std::string, std::string>& routes) {
+    http::RoutingTable table;
+    for (const auto& [prefix, target] : routes) {
+        table.Add(prefix, target.empty() || target == local_route
+                              ? std::nullopt
+                              : std::optional {http::ParseUpstream(target)});
+    }
+
+    return table;
+}
+
 /**
  * @brief Load a local configuration.
  *
@@ -69,11 +300,132 @@ int main() {
             config->Lookup<std::size_t>(alive_time_tag)->GetValue()};
         const auto asset_folder {
             config->Lookup<std::string>(asset_folder_tag)->GetValue()};
+        const auto asset_pack {
+            config->Lookup<std::string>(asset_pack_tag)->GetValue()};
+        const auto reactors {
+            config->Lookup<std::size_t>(reactors_tag)->GetValue()};
+        const auto coroutines {
+            config->Lookup<std::size_t>(coroutines_tag)->GetValue()};
+        const auto disk_threads {
+            config->Lookup<std::size_t>(disk_threads_tag)->GetValue()};
+        const auto work_stealing {IsWorkStealingThreadPool(
+            config->Lookup<std::string>(thread_pool_tag)->GetValue())};
+        const auto poller {Poller::ToBackend(
+            config->Lookup<std::string>(poller_tag)->GetValue())};
+        const auto max_events {
+            config->Lookup<std::size_t>(max_events_tag)->GetValue()};
+        const auto busy_poll {
+            config->Lookup<std::size_t>(busy_poll_tag)->GetValue()};
+        const auto high_water_mark {
+            config->Lookup<std::size_t>(high_water_mark_tag)->GetValue()};
+        const auto accept_budget {
+            config->Lookup<std::size_t>(accept_budget_tag)->GetValue()};
+        const auto defer_accept {
+            config->Lookup<std::size_t>(defer_accept_tag)->GetValue()};
+        const auto fast_open {
+            config->Lookup<std::size_t>(fast_open_tag)->GetValue()};
+        const auto no_delay {
+            config->Lookup<std::size_t>(no_delay_tag)->GetValue()};
+        const auto send_buffer {
+            config->Lookup<std::size_t>(send_buffer_tag)->GetValue()};
+        const auto receive_buffer {
+            config->Lookup<std::size_t>(receive_buffer_tag)->GetValue()};
+        const auto reactor_affinity {ParseCPUList(
+            config->Lookup<std::string>(reactor_affinity_tag)->GetValue())};
+        const auto worker_affinity {ParseCPUList(
+            config->Lookup<std::string>(worker_affinity_tag)->GetValue())};
+        const auto incoming_cpu {
+            config->Lookup<std::size_t>(incoming_cpu_tag)->GetValue()};
+        const auto max_connections {
+            config->Lookup<std::size_t>(max_connections_tag)->GetValue()};
+        const auto max_queued_tasks {
+            config->Lookup<std::size_t>(max_queued_tasks_tag)->GetValue()};
+        const auto max_queue_time {
+            config->Lookup<std::size_t>(max_queue_time_tag)->GetValue()};
+        const auto max_buffer_size {
+            config->Lookup<std::size_t>(max_buffer_size_tag)->GetValue()};
+        const auto max_header_size {
+            config->Lookup<std::size_t>(max_header_size_tag)->GetValue()};
+        const auto max_header_count {
+            config->Lookup<std::size_t>(max_header_count_tag)->GetValue()};
+        const auto max_body_size {
+            config->Lookup<std::size_t>(max_body_size_tag)->GetValue()};
+        const auto keep_alive_max_requests {
+            config->Lookup<std::size_t>(keep_alive_max_requests_tag)
+                ->GetValue()};
+        const auto asset_cache_size {
+            config->Lookup<std::size_t>(asset_cache_size_tag)->GetValue()};
+        const auto asset_cache_revalidation {
+            config->Lookup<std::size_t>(asset_cache_revalidation_tag)
+                ->GetValue()};
+        const auto asset_cache_compression {
+            config->Lookup<std::size_t>(asset_cache_compression_tag)
+                ->GetValue()};
+        const auto tls_certificate {
+            config->Lookup<std::string>(tls_certificate_tag)->GetValue()};
+        const auto tls_private_key {
+            config->Lookup<std::string>(tls_private_key_tag)->GetValue()};
+        const auto metrics_path {
+            config->Lookup<std::string>(metrics_path_tag)->GetValue()};
+        const auto trace_path {
+            config->Lookup<std::string>(trace_path_tag)->GetValue()};
+        const auto trace_slow_threshold {
+            config->Lookup<std::size_t>(trace_slow_threshold_tag)->GetValue()};
+        auto routes {ParseRoutes(
+            config->Lookup<std::map<std::string, std::string>>(routes_tag)
+                ->GetValue())};
+        if (routes.UpstreamCount() > 0 && (reactors == 0 || coroutines == 0)) {
+            throw std::invalid_argument {fmt::format(
+                "Upstream servers in '{}' require a positive '{}' and a "
+                "non-zero '{}'",
+                routes_tag, reactors_tag, coroutines_tag)};
+        }
 
         WebServerBuilder<IPv4Addr> builder {};
         builder.SetPort(port)
             .SetAliveTime(std::chrono::seconds {alive_time})
+            .SetReactorCount(reactors)
+            .SetCoroutines(coroutines != 0)
+            .SetDiskThreads(disk_threads)
+            .SetWorkStealing(work_stealing)
+            .SetPollerBackend(poller)
+            .SetMaxEvents(std::max<std::size_t>(max_events, 1))
+            .SetBusyPoll(std::chrono::microseconds {busy_poll})
+            .SetAcceptBudget(std::max<std::size_t>(accept_budget, 1))
+            .SetDeferAccept(std::chrono::seconds {defer_accept})
+            .SetFastOpenQueue(fast_open)
+            .SetNoDelay(no_delay != 0)
+            .SetSendBufferSize(send_buffer * 0x400)
+            .SetReceiveBufferSize(receive_buffer * 0x400)
+            .SetReactorAffinity(reactor_affinity)
+            .SetWorkerAffinity(worker_affinity)
+            .SetIncomingCPU(incoming_cpu != 0)
+            .SetMaxConnections(max_connections)
+            .SetMaxQueuedTasks(max_queued_tasks)
+            .SetMaxQueueTime(std::chrono::milliseconds {max_queue_time})
             .SetRootDirectory(curr_dir / asset_folder);
+        builder.SetAssetCache(asset_cache_size * 0x100000,
+                              std::chrono::seconds {asset_cache_revalidation},
+                              asset_cache_compression != 0);
+        if (!asset_pack.empty()) {
+            builder.SetAssetPack(curr_dir / asset_pack);
+        }
+
+        builder.SetHighWaterMark(high_water_mark * 0x400);
+        builder.SetMaxBufferSize(max_buffer_size * 0x400);
+        builder.SetRequestLimits({.max_header_size = max_header_size * 0x400,
+                                  .max_header_count = max_header_count,
+                                  .max_body_size = max_body_size * 0x400});
+        builder.SetMaxRequestsPerConnection(keep_alive_max_requests);
+        builder.SetMetricsPath(metrics_path);
+        builder.SetTracePath(trace_path);
+        builder.SetSlowRequestThreshold(
+            std::chrono::milliseconds {trace_slow_threshold});
+        builder.SetRoutes(std::move(routes));
+        if (!tls_certificate.empty()) {
+            builder.SetTLSCertificate(curr_dir / tls_certificate,
+                                      curr_dir / tls_private_key);
+        }
 
         auto web_server {builder.Create()};
         web_server.Start();
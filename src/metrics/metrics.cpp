@@ -0,0 +1,283 @@
+#include "metrics.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+
+
+namespace ws::metrics {
+
+namespace {
+
+//! Format labels as `{name="value",...}`, escaping backslashes, quotes and new lines in values.
+std::string FormatLabels(const Labels& labels) noexcept {
+    std::string str;
+    for (const auto& [name, value] : labels) {
+        str += str.empty() ? "{" : ",";
+        str += name;
+        str += "=\"";
+        for (const auto c : value) {
+            switch (c) {
+                case '\\':
+                    str += "\\\\";
+                    break;
+                case '"':
+                    str += "\\\"";
+                    break;
+                case '\n':
+                    str += "\\n";
+                    break;
+                default:
+                    str += c;
+                    break;
+            }
+        }
+
+        str += '"';
+    }
+
+    return str.empty() ? str : str + "}";
+}
+
+//! Add a label to formatted labels.
+std::string AppendLabel(const std::string_view labels,
+                        const std::string_view label) noexcept {
+    if (labels.empty()) {
+        return fmt::format("{{{}}}", label);
+    } else {
+        return fmt::format("{},{}}}", labels.substr(0, labels.size() - 1),
+                           label);
+    }
+}
+
+}  // namespace
+
+std::size_t ShardIndex() noexcept {
+    static std::atomic_size_t next {0};
+    thread_local const auto idx {next.fetch_add(1, std::memory_order_relaxed)
+                                 % shard_count};
+    return idx;
+}
+
+void Counter::Increase(const std::uint64_t n) noexcept {
+    shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+std::uint64_t Counter::Value() const noexcept {
+    return std::accumulate(shards_.cbegin(), shards_.cend(), std::uint64_t {0},
+                           [](const std::uint64_t sum, const Shard& shard) {
+                               return sum
+                                      + shard.value.load(
+                                          std::memory_order_relaxed);
+                           });
+}
+
+void Gauge::Increase(const std::int64_t n) noexcept {
+    shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+void Gauge::Decrease(const std::int64_t n) noexcept {
+    shards_[ShardIndex()].value.fetch_sub(n, std::memory_order_relaxed);
+}
+
+std::int64_t Gauge::Value() const noexcept {
+    return std::accumulate(shards_.cbegin(), shards_.cend(), std::int64_t {0},
+                           [](const std::int64_t sum, const Shard& shard) {
+                               return sum
+                                      + shard.value.load(
+                                          std::memory_order_relaxed);
+                           });
+}
+
+const std::vector<std::uint64_t> Histogram::latency_bounds {
+    100'000,       250'000,       500'000,     1'000'000,
+    2'500'000,     5'000'000,     10'000'000,  25'000'000,
+    50'000'000,    100'000'000,   250'000'000, 500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000};
+
+Histogram::Histogram(std::vector<std::uint64_t> bounds, const double scale) :
+    bounds_ {std::move(bounds)}, scale_ {scale} {
+    if (std::ranges::adjacent_find(bounds_, std::greater_equal {})
+        != bounds_.cend()) {
+        throw std::invalid_argument {
+            "Histogram bounds are not in ascending order"};
+    }
+
+    for (auto& shard : shards_) {
+        shard.counts = std::make_unique<std::atomic_uint64_t[]>(
+            bounds_.size() + 1);
+    }
+}
+
+void Histogram::Observe(const std::uint64_t value) noexcept {
+    // A value equal to an upper bound belongs to that bucket.
+    const auto bucket {static_cast<std::size_t>(
+        std::ranges::lower_bound(bounds_, value) - bounds_.cbegin())};
+    auto& shard {shards_[ShardIndex()]};
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+const std::vector<std::uint64_t>& Histogram::Bounds() const noexcept {
+    return bounds_;
+}
+
+double Histogram::Scale() const noexcept {
+    return scale_;
+}
+
+std::vector<std::uint64_t> Histogram::Counts() const noexcept {
+    std::vector<std::uint64_t> counts(bounds_.size() + 1, 0);
+    for (const auto& shard : shards_) {
+        for (std::size_t i {0}; i != counts.size(); ++i) {
+            counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    return counts;
+}
+
+std::uint64_t Histogram::Sum() const noexcept {
+    return std::accumulate(shards_.cbegin(), shards_.cend(), std::uint64_t {0},
+                           [](const std::uint64_t sum, const Shard& shard) {
+                               return sum
+                                      + shard.sum.load(
+                                          std::memory_order_relaxed);
+                           });
+}
+
+Registry::Metric& Registry::Find(const std::string_view name,
+                                 const std::string_view help, const Type type,
+                                 const Labels& labels) {
+    auto family {std::ranges::find(families_, name, &Family::name)};
+    if (family == families_.end()) {
+        families_.push_back({.name = std::string {name},
+                             .help = std::string {help},
+                             .type = type,
+                             .metrics = {}});
+        family = std::prev(families_.end());
+    } else if (family->type != type) {
+        throw std::invalid_argument {fmt::format(
+            "The metric '{}' has been registered with another type", name)};
+    }
+
+    auto formatted {FormatLabels(labels)};
+    auto& metrics {family->metrics};
+    if (const auto metric {
+            std::ranges::find(metrics, formatted, &Metric::labels)};
+        metric != metrics.end()) {
+        return *metric;
+    }
+
+    metrics.push_back({.labels = std::move(formatted),
+                       .counter = nullptr,
+                       .gauge = nullptr,
+                       .histogram = nullptr});
+    return metrics.back();
+}
+
+Counter& Registry::AddCounter(const std::string_view name,
+                              const std::string_view help,
+                              const Labels& labels) {
+    const std::lock_guard locker {mtx_};
+    auto& metric {Find(name, help, Type::Counter, labels)};
+    if (!metric.counter) {
+        metric.counter = std::make_unique<Counter>();
+    }
+
+    return *metric.counter;
+}
+
+Gauge& Registry::AddGauge(const std::string_view name,
+                          const std::string_view help, const Labels& labels) {
+    const std::lock_guard locker {mtx_};
+    auto& metric {Find(name, help, Type::Gauge, labels)};
+    if (!metric.gauge) {
+        metric.gauge = std::make_unique<Gauge>();
+    }
+
+    return *metric.gauge;
+}
+
+Histogram& Registry::AddHistogram(const std::string_view name,
+                                  const std::string_view help,
+                                  std::vector<std::uint64_t> bounds,
+                                  const double scale, const Labels& labels) {
+    const std::lock_guard locker {mtx_};
+    auto& metric {Find(name, help, Type::Histogram, labels)};
+    if (!metric.histogram) {
+        metric.histogram = std::make_unique<Histogram>(std::move(bounds), scale);
+    }
+
+    return *metric.histogram;
+}
+
+std::string Registry::Expose() const noexcept {
+    static constexpr std::array<std::string_view, 3> type_names {
+        "counter", "gauge", "histogram"};
+
+    std::string text;
+    const std::lock_guard locker {mtx_};
+    for (const auto& family : families_) {
+        const auto& name {family.name};
+        text += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help,
+                            name,
+                            type_names[static_cast<std::size_t>(family.type)]);
+        for (const auto& metric : family.metrics) {
+            const auto& labels {metric.labels};
+            switch (family.type) {
+                case Type::Counter: {
+                    text += fmt::format("{}{} {}\n", name, labels,
+                                        metric.counter->Value());
+                    break;
+                }
+                case Type::Gauge: {
+                    text += fmt::format("{}{} {}\n", name, labels,
+                                        metric.gauge->Value());
+                    break;
+                }
+                case Type::Histogram: {
+                    // Buckets are cumulative in the Prometheus format.
+                    const auto& histogram {*metric.histogram};
+                    const auto& bounds {histogram.Bounds()};
+                    const auto counts {histogram.Counts()};
+                    std::uint64_t count {0};
+                    for (std::size_t i {0}; i != counts.size(); ++i) {
+                        count += counts[i];
+                        const auto bound {
+                            i != bounds.size()
+                                ? fmt::format("{}",
+                                              bounds[i] * histogram.Scale())
+                                : std::string {"+Inf"}};
+                        text += fmt::format(
+                            "{}_bucket{} {}\n", name,
+                            AppendLabel(labels,
+                                        fmt::format("le=\"{}\"", bound)),
+                            count);
+                    }
+
+                    text += fmt::format("{}_sum{} {}\n", name, labels,
+                                        histogram.Sum() * histogram.Scale());
+                    text += fmt::format("{}_count{} {}\n", name, labels, count);
+                    break;
+                }
+                default: {
+                    assert(false);
+                    break;
+                }
+            }
+        }
+    }
+
+    return text;
+}
+
+Registry& DefaultRegistry() noexcept {
+    static Registry registry;
+    return registry;
+}
+
+}  // namespace ws::metrics
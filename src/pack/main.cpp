@@ -0,0 +1,69 @@
+#include "http.h"
+
+#include <fmt/format.h>
+#include <getopt.h>
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string_view>
+
+using namespace ws;
+
+
+namespace {
+
+constexpr std::string_view usage {
+    "Usage: echo-asset-pack [options] <asset-folder> <pack>\n"
+    "\n"
+    "Pack all files in an asset folder into a single indexed asset pack,\n"
+    "which an echo web server maps into memory at startup.\n"
+    "\n"
+    "Options:\n"
+    "  -z, --compress  Compress text files with gzip if they do not have\n"
+    "                  a precompressed .gz sibling\n"
+    "  -h, --help      Show this message\n"};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    static constexpr std::array<option, 3> long_options {
+        option {"compress", no_argument, nullptr, 'z'},
+        option {"help", no_argument, nullptr, 'h'},
+        option {nullptr, 0, nullptr, 0}};
+
+    bool compression {false};
+    for (int opt {0}; (opt = getopt_long(argc, argv, "zh", long_options.data(),
+                                         nullptr))
+                      != -1;) {
+        switch (opt) {
+            case 'z':
+                compression = true;
+                break;
+            case 'h':
+                fmt::print("{}", usage);
+                return EXIT_SUCCESS;
+            default:
+                fmt::print(stderr, "{}", usage);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 2) {
+        fmt::print(stderr, "{}", usage);
+        return EXIT_FAILURE;
+    }
+
+    const std::filesystem::path dir {argv[optind]};
+    const std::filesystem::path pack {argv[optind + 1]};
+    try {
+        http::PackAssets(dir, pack, compression);
+        fmt::print("Packed '{}' into '{}' ({} bytes)\n", dir.string(),
+                   pack.string(), std::filesystem::file_size(pack));
+        return EXIT_SUCCESS;
+    } catch (const std::exception& err) {
+        fmt::print(stderr, "Failed to pack assets: {}\n", err.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -2,8 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 #include <filesystem>
 #include <mutex>
+#include <tuple>
 
 
 namespace ws::test {
@@ -29,6 +32,45 @@ std::pair<FileDescriptor, std::string> CreateTempTestFile() {
     }
 }
 
+TempTestFile::TempTestFile() {
+    std::tie(fd_, path_) = CreateTempTestFile();
+}
+
+TempTestFile::~TempTestFile() noexcept {
+    close(fd_);
+    unlink(path_.c_str());
+}
+
+FileDescriptor TempTestFile::Descriptor() const noexcept {
+    return fd_;
+}
+
+const std::string& TempTestFile::Path() const noexcept {
+    return path_;
+}
+
+void TempTestFile::Rewrite(const std::string_view data) const {
+    test::Rewrite(fd_, data);
+}
+
+void Rewrite(const FileDescriptor fd, const std::string_view data) {
+    ASSERT_EQ(ftruncate(fd, 0), 0);
+    ASSERT_EQ(pwrite(fd, data.data(), data.size(), 0),
+              static_cast<ssize_t>(data.size()));
+}
+
+std::string CreateTempTestDirectory() {
+    static constexpr std::string_view suffix {"-XXXXXX"};
+
+    const auto dir {TestName() + suffix.data()};
+    std::string path {std::filesystem::temp_directory_path().append(dir)};
+    if (mkdtemp(path.data())) {
+        return path;
+    } else {
+        ThrowLastSystemError();
+    }
+}
+
 log::Logger::Ptr TestLogger() noexcept {
     static std::once_flag init_flag;
     static const auto ins {
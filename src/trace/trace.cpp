@@ -0,0 +1,281 @@
+#include "trace.h"
+#include "log.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ws::trace {
+
+namespace {
+
+//! Stages kept by a thread.
+class Ring {
+public:
+    explicit Ring(const std::size_t thread) noexcept :
+        thread_ {thread}, spans_(ring_capacity) {}
+
+    void Push(const Span& span) noexcept {
+        const std::lock_guard locker {mtx_};
+        spans_[next_] = span;
+        next_ = (next_ + 1) % spans_.size();
+        size_ = std::min(size_ + 1, spans_.size());
+    }
+
+    //! Get stages from the oldest to the newest.
+    std::vector<Span> Spans() const noexcept {
+        const std::lock_guard locker {mtx_};
+        std::vector<Span> spans;
+        spans.reserve(size_);
+        const auto first {(next_ + spans_.size() - size_) % spans_.size()};
+        for (std::size_t i {0}; i != size_; ++i) {
+            spans.push_back(spans_[(first + i) % spans_.size()]);
+        }
+
+        return spans;
+    }
+
+    void Clear() noexcept {
+        const std::lock_guard locker {mtx_};
+        next_ = 0;
+        size_ = 0;
+    }
+
+    std::size_t Thread() const noexcept {
+        return thread_;
+    }
+
+private:
+    //! The number of the thread, in the order of first use.
+    std::size_t thread_;
+
+    //! The ring is only written by its thread, so the lock is uncontended unless it is being dumped.
+    mutable std::mutex mtx_;
+    std::vector<Span> spans_;
+    std::size_t next_ {0};
+    std::size_t size_ {0};
+};
+
+//! Rings of all threads, which are kept after their threads exit.
+class Rings {
+public:
+    std::shared_ptr<Ring> Add() noexcept {
+        const std::lock_guard locker {mtx_};
+        rings_.push_back(std::make_shared<Ring>(rings_.size()));
+        return rings_.back();
+    }
+
+    std::vector<std::shared_ptr<Ring>> All() const noexcept {
+        const std::lock_guard locker {mtx_};
+        return rings_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+};
+
+Rings& AllRings() noexcept {
+    static Rings rings;
+    return rings;
+}
+
+Ring& ThreadRing() noexcept {
+    thread_local const auto ring {AllRings().Add()};
+    return *ring;
+}
+
+std::atomic_uint64_t next_request {1};
+
+std::atomic<std::chrono::nanoseconds::rep> slow_threshold {0};
+
+//! Measure the number of nanoseconds per tick against the steady clock.
+double CalibrateTickPeriod() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds interval {5};
+
+    const auto start_time {Clock::now()};
+    const auto start_ticks {Now()};
+    while (Clock::now() - start_time < interval) {
+        std::this_thread::yield();
+    }
+
+    const auto ticks {Now() - start_ticks};
+    const std::chrono::duration<double, std::nano> elapsed {Clock::now()
+                                                            - start_time};
+    return ticks > 0 ? elapsed.count() / ticks : 1;
+#else
+    return 1;
+#endif
+}
+
+//! Get the duration of a stage in ticks.
+std::uint64_t Duration(const Span& span) noexcept {
+    // Time stamp counters of different cores may differ slightly.
+    return span.end > span.begin ? span.end - span.begin : 0;
+}
+
+}  // namespace
+
+std::string_view StageToString(const Stage stage) noexcept {
+    switch (stage) {
+        case Stage::Queue:
+            return "Queue";
+        case Stage::Receive:
+            return "Receive";
+        case Stage::Parse:
+            return "Parse";
+        case Stage::Build:
+            return "Build";
+        case Stage::Send:
+            return "Send";
+        default:
+            assert(false);
+            return "";
+    }
+}
+
+double ToNanoseconds(const std::uint64_t ticks) noexcept {
+    static const auto period {CalibrateTickPeriod()};
+    return ticks * period;
+}
+
+void RequestTrace::Enqueue() noexcept {
+    queued_ = Now();
+}
+
+void RequestTrace::Dequeue() noexcept {
+    if (queued_ != 0) {
+        Record(Stage::Queue, queued_, Now());
+        queued_ = 0;
+    }
+}
+
+void RequestTrace::Record(const Stage stage, const std::uint64_t begin,
+                          const std::uint64_t end) noexcept {
+    if (size_ < spans_.size()) {
+        spans_[size_++] = {.stage = stage, .begin = begin, .end = end};
+    } else {
+        // Extend the last stage instead of dropping the rest.
+        spans_.back().end = end;
+    }
+}
+
+void RequestTrace::Finish() noexcept {
+    if (size_ == 0) {
+        return;
+    }
+
+    const auto request {next_request.fetch_add(1, std::memory_order_relaxed)};
+    auto& ring {ThreadRing()};
+    std::uint64_t begin {std::numeric_limits<std::uint64_t>::max()};
+    std::uint64_t end {0};
+    for (std::size_t i {0}; i != size_; ++i) {
+        auto& span {spans_[i]};
+        span.request = request;
+        ring.Push(span);
+        begin = std::min(begin, span.begin);
+        end = std::max(end, span.end);
+    }
+
+    if (const auto threshold {slow_threshold.load(std::memory_order_relaxed)};
+        threshold > 0 && ToNanoseconds(end - begin) >= threshold) {
+        std::string stages;
+        for (std::size_t i {0}; i != size_; ++i) {
+            const auto& span {spans_[i]};
+            stages += fmt::format("{}{} {:.1f} us", i == 0 ? "" : ", ",
+                                  StageToString(span.stage),
+                                  ToNanoseconds(Duration(span)) / 1000);
+        }
+
+        WS_LOG_WARN(log::RootLogger(),
+                    "Slow request {} '{}' took {:.1f} us: {}", request, label_,
+                    ToNanoseconds(end - begin) / 1000, stages);
+    }
+
+    Clear();
+}
+
+void RequestTrace::SetLabel(const std::string_view label) noexcept {
+    label_ = label;
+}
+
+void RequestTrace::Clear() noexcept {
+    size_ = 0;
+    queued_ = 0;
+    label_.clear();
+}
+
+std::size_t RequestTrace::Size() const noexcept {
+    return size_;
+}
+
+Scope::Scope(RequestTrace& trace, const Stage stage) noexcept :
+    trace_ {trace}, stage_ {stage}, begin_ {Now()} {}
+
+Scope::~Scope() noexcept {
+    trace_.Record(stage_, begin_, Now());
+}
+
+void SetSlowThreshold(const std::chrono::nanoseconds threshold) noexcept {
+    if (threshold.count() > 0) {
+        // Calibrate the tick rate now instead of in the first slow request.
+        ToNanoseconds(0);
+    }
+
+    slow_threshold.store(threshold.count(), std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds GetSlowThreshold() noexcept {
+    return std::chrono::nanoseconds {
+        slow_threshold.load(std::memory_order_relaxed)};
+}
+
+std::string DumpChromeTrace() noexcept {
+    std::vector<std::pair<std::size_t, std::vector<Span>>> threads;
+    std::uint64_t origin {std::numeric_limits<std::uint64_t>::max()};
+    for (const auto& ring : AllRings().All()) {
+        auto spans {ring->Spans()};
+        for (const auto& span : spans) {
+            origin = std::min(origin, span.begin);
+        }
+
+        threads.emplace_back(ring->Thread(), std::move(spans));
+    }
+
+    // Timestamps are in microseconds from the earliest stage.
+    std::string json {"{\"traceEvents\":["};
+    bool first {true};
+    for (const auto& [thread, spans] : threads) {
+        for (const auto& span : spans) {
+            json += fmt::format(
+                "{}{{\"name\":\"{}\",\"cat\":\"http\",\"ph\":\"X\","
+                "\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},"
+                "\"args\":{{\"request\":{}}}}}",
+                first ? "" : ",", StageToString(span.stage), thread,
+                ToNanoseconds(span.begin - origin) / 1000,
+                ToNanoseconds(Duration(span)) / 1000, span.request);
+            first = false;
+        }
+    }
+
+    json += "],\"displayTimeUnit\":\"ns\"}";
+    return json;
+}
+
+void ClearRings() noexcept {
+    for (const auto& ring : AllRings().All()) {
+        ring->Clear();
+    }
+}
+
+}  // namespace ws::trace
@@ -2,6 +2,8 @@
 
 #include <execinfo.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/mman.h>
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -9,6 +11,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <charconv>
+#include <filesystem>
 #include <iterator>
 #include <sstream>
 #include <system_error>
@@ -16,6 +20,25 @@
 
 namespace ws {
 
+namespace {
+
+/**
+ * @brief Check whether a file can be read.
+ *
+ * @exception std::invalid_argument The path refers to a directory.
+ * @exception std::runtime_error No permission to access the file.
+ */
+void CheckReadableFile(const std::string_view path, const struct stat& stat) {
+    if (S_ISDIR(stat.st_mode)) {
+        throw std::invalid_argument {fmt::format("'{}' is a directory", path)};
+    } else if (!(stat.st_mode & S_IREAD)) {
+        throw std::runtime_error {
+            fmt::format("No permission to access '{}'", path)};
+    }
+}
+
+}  // namespace
+
 std::string StringToLower(std::string str) noexcept {
     std::ranges::transform(
         str.begin(), str.end(), str.begin(),
@@ -76,6 +99,16 @@ YAML::Node LoadYamlString(
     return node;
 }
 
+std::string YamlNodeToString(const YAML::Node& node) noexcept {
+    if (node.IsScalar()) {
+        return node.Scalar();
+    }
+
+    std::ostringstream ss;
+    ss << node;
+    return ss.str();
+}
+
 void ThrowIfYamlFieldIsNotScalar(const YAML::Node& node,
                                  const std::string_view field) {
     if (!node[field.data()] || !node[field.data()].IsScalar()) {
@@ -96,7 +129,94 @@ void SetFileDescriptorAsNonblocking(const FileDescriptor fd) {
 }
 
 std::uint32_t CurrentThreadId() noexcept {
-    return static_cast<std::uint32_t>(syscall(SYS_gettid));
+    // A thread's ID never changes, so the system call is only made once.
+    thread_local const auto id {
+        static_cast<std::uint32_t>(syscall(SYS_gettid))};
+    return id;
+}
+
+std::vector<std::size_t> ParseCPUList(const std::string_view list) {
+    const auto to_cpu {[list](const std::string_view str) {
+        std::size_t cpu {0};
+        if (const auto [ptr, error] {
+                std::from_chars(str.data(), str.data() + str.size(), cpu)};
+            str.empty() || error != std::errc {}
+            || ptr != str.data() + str.size()) {
+            throw std::invalid_argument {
+                fmt::format("Invalid CPU list: '{}'", list)};
+        }
+
+        return cpu;
+    }};
+
+    std::vector<std::size_t> cpus;
+    if (list.empty()) {
+        return cpus;
+    }
+
+    static const std::regex separator {","};
+    for (const auto& range : SplitString(std::string {list}, separator)) {
+        if (const auto dash {range.find('-')}; dash != std::string::npos) {
+            const auto first {to_cpu(std::string_view {range}.substr(0, dash))};
+            const auto last {to_cpu(std::string_view {range}.substr(dash + 1))};
+            if (first > last) {
+                throw std::invalid_argument {
+                    fmt::format("Invalid CPU list: '{}'", list)};
+            }
+
+            for (auto cpu {first}; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } else {
+            cpus.push_back(to_cpu(range));
+        }
+    }
+
+    return cpus;
+}
+
+void SetThreadAffinity(const std::thread::native_handle_type thread,
+                       const std::span<const std::size_t> cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus) {
+        if (cpu >= CPU_SETSIZE) {
+            throw std::system_error {std::make_error_code(
+                std::errc::invalid_argument)};
+        }
+
+        CPU_SET(cpu, &set);
+    }
+
+    if (const auto error {pthread_setaffinity_np(thread, sizeof(set), &set)};
+        error != 0) {
+        throw std::system_error {error, std::system_category()};
+    }
+}
+
+void SetCurrentThreadAffinity(const std::span<const std::size_t> cpus) {
+    SetThreadAffinity(pthread_self(), cpus);
+}
+
+std::optional<std::size_t> NUMANodeOfCPU(const std::size_t cpu) noexcept {
+    // A CPU's directory contains a link named after its node, such as `node0`.
+    static constexpr std::string_view prefix {"node"};
+    std::error_code error;
+    for (const std::filesystem::directory_iterator dir {
+             fmt::format("/sys/devices/system/cpu/cpu{}", cpu), error};
+         const auto& entry : dir) {
+        const auto name {entry.path().filename().string()};
+        std::size_t node {0};
+        if (name.size() > prefix.size() && name.starts_with(prefix)
+            && std::from_chars(name.data() + prefix.size(),
+                               name.data() + name.size(), node)
+                       .ptr
+                   == name.data() + name.size()) {
+            return node;
+        }
+    }
+
+    return std::nullopt;
 }
 
 void Backtrace(std::vector<std::string>& stack, const std::size_t size,
@@ -106,7 +226,7 @@ void Backtrace(std::vector<std::string>& stack, const std::size_t size,
     const auto ret_size {backtrace(buffer.get(), static_cast<int>(size))};
     char** const stack_strs {backtrace_symbols(buffer.get(), ret_size)};
     if (stack_strs) {
-        for (auto i {skip}; i < ret_size; ++i) {
+        for (auto i {skip}; i < static_cast<std::size_t>(ret_size); ++i) {
             stack.push_back(stack_strs[i]);
         }
 
@@ -127,10 +247,135 @@ std::string Backtrace(const std::size_t size, const std::size_t skip,
     return backtrace.str();
 }
 
+std::chrono::system_clock::time_point ModificationTime(
+    const struct stat& stat) noexcept {
+    const auto time {std::chrono::seconds {stat.st_mtim.tv_sec}
+                     + std::chrono::nanoseconds {stat.st_mtim.tv_nsec}};
+    return std::chrono::system_clock::time_point {
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(time)};
+}
+
+ReadOnlyFile::ReadOnlyFile() noexcept = default;
+
+ReadOnlyFile::ReadOnlyFile(ReadOnlyFile&& o) noexcept :
+    path_ {std::move(o.path_)}, stat_ {std::move(o.stat_)}, fd_ {o.fd_} {
+    o.fd_ = invalid_file_descriptor;
+}
+
+ReadOnlyFile& ReadOnlyFile::operator=(ReadOnlyFile&& o) noexcept {
+    if (this != &o) {
+        Close();
+        fd_ = o.fd_;
+        stat_ = std::move(o.stat_);
+        path_ = std::move(o.path_);
+        o.fd_ = invalid_file_descriptor;
+    }
+
+    return *this;
+}
+
+ReadOnlyFile::~ReadOnlyFile() noexcept {
+    Close();
+}
+
+FileDescriptor ReadOnlyFile::Open(std::string path) {
+    Close();
+
+    path_ = std::move(path);
+    assert(!path_.empty());
+
+    fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (!IsValidFileDescriptor(fd_)) {
+        ThrowLastSystemError();
+    }
+
+    bool failed {true};
+    const RAII raii {this, [&failed](ReadOnlyFile* const file) noexcept {
+                         if (failed) {
+                             file->Close();
+                         }
+                     }};
+
+    // Use `fstat` on the opened descriptor to avoid another path lookup.
+    if (fstat(fd_, &stat_) < 0) {
+        ThrowLastSystemError();
+    }
+
+    CheckReadableFile(path_, stat_);
+    failed = false;
+    return fd_;
+}
+
+void ReadOnlyFile::Close() noexcept {
+    if (IsValidFileDescriptor(fd_)) {
+        close(fd_);
+        fd_ = invalid_file_descriptor;
+    }
+
+    stat_ = {};
+    path_.clear();
+}
+
+std::vector<std::byte> ReadOnlyFile::ReadAll() const {
+    assert(Valid());
+
+    std::vector<std::byte> content(Size());
+    std::size_t size {0};
+    while (size < content.size()) {
+        if (const auto read {pread(fd_, content.data() + size,
+                                   content.size() - size, size)};
+            read > 0) {
+            size += read;
+        } else if (read == 0) {
+            throw std::runtime_error {
+                fmt::format("The file '{}' has been truncated", path_)};
+        } else if (static_cast<std::errc>(errno) != std::errc::interrupted) {
+            ThrowLastSystemError();
+        }
+    }
+
+    return content;
+}
+
+void ReadOnlyFile::Prefetch(const std::size_t offset,
+                            const std::size_t size) const noexcept {
+    assert(Valid());
+    if (offset < Size()) {
+        posix_fadvise(fd_, static_cast<off_t>(offset),
+                      static_cast<off_t>(std::min(size, Size() - offset)),
+                      POSIX_FADV_WILLNEED);
+    }
+}
+
+bool ReadOnlyFile::Valid() const noexcept {
+    return IsValidFileDescriptor(fd_);
+}
+
+std::size_t ReadOnlyFile::Size() const noexcept {
+    return stat_.st_size;
+}
+
+FileDescriptor ReadOnlyFile::Descriptor() const noexcept {
+    return fd_;
+}
+
+std::chrono::system_clock::time_point ReadOnlyFile::ModificationTime()
+    const noexcept {
+    return ws::ModificationTime(stat_);
+}
+
+std::uint64_t ReadOnlyFile::Inode() const noexcept {
+    return stat_.st_ino;
+}
+
+std::string_view ReadOnlyFile::Path() const noexcept {
+    return path_;
+}
+
 MappedReadOnlyFile::MappedReadOnlyFile() noexcept = default;
 
 MappedReadOnlyFile::MappedReadOnlyFile(MappedReadOnlyFile&& o) noexcept :
-    data_ {o.data_}, stat_ {std::move(o.stat_)}, path_ {std::move(o.path_)} {
+    path_ {std::move(o.path_)}, stat_ {std::move(o.stat_)}, data_ {o.data_} {
     o.data_ = nullptr;
 }
 
@@ -155,12 +400,9 @@ void MappedReadOnlyFile::Check() {
 
     if (stat(path_.data(), &stat_) < 0) {
         ThrowLastSystemError();
-    } else if (S_ISDIR(stat_.st_mode)) {
-        throw std::invalid_argument {fmt::format("'{}' is a directory", path_)};
-    } else if (!(stat_.st_mode & S_IREAD)) {
-        throw std::runtime_error {
-            fmt::format("No permission to access '{}'", path_)};
     }
+
+    CheckReadableFile(path_, stat_);
 }
 
 std::byte* MappedReadOnlyFile::Map(std::string path) {
@@ -179,8 +421,38 @@ std::byte* MappedReadOnlyFile::Map(std::string path) {
                                   MAP_PRIVATE, fd.Object(), 0)};
         map_base != MAP_FAILED) {
         data_ = static_cast<std::byte*>(map_base);
+
+        // A failed advice only loses the read-ahead.
+        madvise(data_, stat_.st_size, MADV_WILLNEED);
+        return data_;
+    } else {
+        ThrowLastSystemError();
+    }
+}
+
+std::byte* MappedReadOnlyFile::Map(const ReadOnlyFile& file) {
+    assert(file.Valid());
+    Unmap();
+
+    if (file.Size() == 0) {
+        throw std::invalid_argument {
+            fmt::format("The file '{}' is empty", file.Path())};
+    } else if (fstat(file.Descriptor(), &stat_) < 0) {
+        ThrowLastSystemError();
+    }
+
+    if (const auto map_base {mmap(nullptr, stat_.st_size, PROT_READ,
+                                  MAP_PRIVATE | MAP_POPULATE,
+                                  file.Descriptor(), 0)};
+        map_base != MAP_FAILED) {
+        data_ = static_cast<std::byte*>(map_base);
+        path_ = file.Path();
+
+        // A failed advice only loses the read-ahead.
+        madvise(data_, stat_.st_size, MADV_SEQUENTIAL);
         return data_;
     } else {
+        stat_ = {};
         ThrowLastSystemError();
     }
 }
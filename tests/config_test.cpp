@@ -3,6 +3,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 using namespace ws;
 using namespace ws::cfg;
 
@@ -35,6 +39,11 @@ TEST(ConfigurationVariableConverterTest, List) {
     EXPECT_EQ((VarConverter<std::string, std::vector<std::vector<int>>> {}(
                   "[[0], [1, 2]]")),
               (std::vector<std::vector<int>> {{0}, {1, 2}}));
+
+    // Quoted strings are converted into their unquoted values.
+    EXPECT_EQ((VarConverter<std::string, std::vector<std::string>> {}(
+                  R"(["[::1]:8080", x])")),
+              (std::vector<std::string> {"[::1]:8080", "x"}));
 }
 
 TEST(ConfigurationVariableConverterTest, Set) {
@@ -64,6 +73,12 @@ TEST(ConfigurationVariableConverterTest, Map) {
                   "{[0, 1]: 1}")),
               (std::map<std::string, int> {{"[0, 1]", 1}}));
 
+    // Quoted strings are converted into their unquoted values.
+    EXPECT_EQ(
+        (VarConverter<std::string, std::map<std::string, std::string>> {}(
+            R"({"/v6/": "[::1]:8080"})")),
+        (std::map<std::string, std::string> {{"/v6/", "[::1]:8080"}}));
+
     EXPECT_EQ(
         (VarConverter<std::string,
                       std::map<std::string, std::map<std::string, int>>> {}(
@@ -147,6 +162,71 @@ TEST(ConfigurationVariableTest, Listen) {
     var.SetValue(2);
 }
 
+TEST(ConfigurationVariableTest, Snapshot) {
+    Var<std::string> var {"", "old"};
+    const auto version {var.Version()};
+    const auto old_snapshot {var.GetSnapshot()};
+
+    // A snapshot is not affected by later changes.
+    var.SetValue("new");
+    EXPECT_EQ(*old_snapshot, "old");
+    EXPECT_EQ(*var.GetSnapshot(), "new");
+    EXPECT_EQ(var.Version(), version + 1);
+
+    // The version does not change if the value is the same.
+    var.SetValue("new");
+    EXPECT_EQ(var.Version(), version + 1);
+}
+
+TEST(ConfigurationVariableTest, NotifyBeforePublishing) {
+    const auto var {std::make_shared<Var<int>>("", 1)};
+    auto notified {false};
+    var->AddListener([&notified, &var](const int& old_val,
+                                       const int& new_val) noexcept {
+        // The new value has not been published when listeners are notified.
+        notified = old_val == 1 && new_val == 2 && var->GetValue() == 1;
+    });
+
+    var->SetValue(2);
+    EXPECT_TRUE(notified);
+    EXPECT_EQ(var->GetValue(), 2);
+}
+
+TEST(ConfigurationVariableTest, ConcurrentRead) {
+    constexpr int max_val {1000};
+    const auto var {std::make_shared<Var<std::vector<int>>>(
+        "", std::vector<int> {0})};
+
+    // Readers always see a consistent and non-decreasing value.
+    std::atomic_bool failed {false};
+    std::vector<std::thread> readers;
+    for (auto i {0}; i != 2; ++i) {
+        readers.emplace_back([&var, &failed]() noexcept {
+            auto last {0};
+            while (last != max_val) {
+                const auto snapshot {var->GetSnapshot()};
+                const auto& val {*snapshot};
+                if (val.size() != 1 || val.front() < last) {
+                    failed = true;
+                    return;
+                }
+
+                last = val.front();
+            }
+        });
+    }
+
+    for (auto i {1}; i <= max_val; ++i) {
+        var->SetValue({i});
+    }
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_FALSE(failed);
+}
+
 TEST(ConfigurationTest, Lookup) {
     Config cfg {"test"};
 
@@ -173,6 +253,11 @@ TEST(ConfigurationTest, Lookup) {
 
     // The variable type is mismatched.
     EXPECT_THROW(cfg.Lookup<wchar_t>("x"), std::invalid_argument);
+
+    // Empty strings are loaded without quotes.
+    const auto str {cfg.Lookup<std::string>("str", "default")};
+    cfg.LoadYaml(LoadYamlString(R"({str: ""})"));
+    EXPECT_EQ(str->GetValue(), "");
 }
 
 TEST(ConfigurationTest, Visit) {
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <string>
 
 using namespace ws;
 
@@ -137,6 +138,81 @@ TEST(BufferTest, ReadWrite) {
     EXPECT_EQ(buf.RetrieveAllToString(), "hello\n");
 }
 
+TEST(BufferTest, Erase) {
+    Buffer buf;
+    buf.Append("__hello, world");
+    buf.Retrieve(2);
+
+    // `"hello, world"` → `"hello world"`
+    buf.Erase(5, 1);
+    EXPECT_EQ(buf.ReadableString(), "hello world");
+
+    // `"hello world"` → `"hello"`
+    buf.Erase(5, 6);
+    EXPECT_EQ(buf.ReadableString(), "hello");
+
+    buf.Erase(0, 0);
+    EXPECT_EQ(buf.ReadableString(), "hello");
+
+    // Readable bytes can be edited in place.
+    buf.MutableReadableBytes()[0] = std::byte {'j'};
+    EXPECT_EQ(buf.ReadableString(), "jello");
+
+    // Erased space becomes writable again.
+    buf.Append("!");
+    EXPECT_EQ(buf.ReadableString(), "jello!");
+}
+
+TEST(BufferTest, Find) {
+    Buffer buf {"xGET / HTTP/1.1\nHost: a\r\n\r\n"};
+    buf.Retrieve(1);
+
+    // Offsets are relative to readable bytes.
+    EXPECT_EQ(buf.Find('G'), 0);
+    EXPECT_EQ(buf.Find('\n'), 14);
+    EXPECT_EQ(buf.Find('\n', 15), 23);
+    EXPECT_FALSE(buf.Find('z'));
+    EXPECT_FALSE(buf.Find('G', buf.ReadableSize()));
+
+    // A bare line feed is not a line break.
+    EXPECT_EQ(buf.FindCRLF(), 22);
+    EXPECT_EQ(buf.FindCRLF(23), 24);
+    EXPECT_FALSE(buf.FindCRLF(25));
+
+    EXPECT_EQ(buf.FindAny(":\r"), 19);
+    EXPECT_EQ(buf.FindAny("/"), 4);
+    EXPECT_FALSE(buf.FindAny(""));
+    EXPECT_FALSE(buf.FindAny("{}"));
+
+    // Matches are found in vectorized blocks and the rest of bytes.
+    for (const std::size_t pos : {0, 15, 16, 31, 32, 63, 64, 100}) {
+        std::string str(101, 'a');
+        str[pos] = '=';
+        const Buffer data {str};
+        EXPECT_EQ(data.FindAny("&="), pos);
+        EXPECT_FALSE(data.FindAny("&=", pos + 1));
+    }
+
+    const ConcurrentBuffer concurrent {"a\r\n"};
+    EXPECT_EQ(concurrent.FindCRLF(), 1);
+}
+
+TEST(BufferTest, FindAnyOf) {
+    EXPECT_FALSE(FindAnyOfInstructionSet().empty());
+    EXPECT_EQ(FindAnyOf("", "&="), 0);
+    EXPECT_EQ(FindAnyOf("abc", ""), 3);
+    EXPECT_EQ(FindAnyOf("abc", "c"), 2);
+    EXPECT_EQ(FindAnyOf("abc", "xy"), 3);
+
+    // Matches are found in vectorized blocks and the rest of bytes.
+    for (const std::size_t pos : {0, 15, 16, 31, 32, 63, 64, 100}) {
+        std::string str(101, 'a');
+        str[pos] = '=';
+        EXPECT_EQ(FindAnyOf(str, "&="), pos);
+        EXPECT_EQ(FindAnyOf(str, "="), pos);
+    }
+}
+
 TEST(BufferTest, Clear) {
     Buffer buf {"hello"};
     buf.Clear();
@@ -146,6 +222,38 @@ TEST(BufferTest, Clear) {
     EXPECT_EQ(buf.Peek(), std::nullopt);
 }
 
+TEST(BufferTest, Reset) {
+    Buffer buf {0x10};
+    buf.Append(std::string(0x40, 'a'));
+    const auto capacity {buf.Capacity()};
+    EXPECT_GE(capacity, 0x40);
+
+    // The allocated space is kept if it does not exceed the maximum size.
+    buf.Reset(capacity);
+    EXPECT_TRUE(buf.Empty());
+    EXPECT_EQ(buf.Capacity(), capacity);
+
+    // The buffer is shrunk if it exceeds the maximum size.
+    buf.Append("hello");
+    buf.Reset(0x10);
+    EXPECT_TRUE(buf.Empty());
+    EXPECT_EQ(buf.Capacity(), 0x10);
+    buf.Append("hello");
+    EXPECT_EQ(buf.RetrieveAllToString(), "hello");
+}
+
+TEST(ConcurrentBufferTest, ReadWrite) {
+    ConcurrentBuffer buf {0x10};
+    buf.Append("hello");
+    EXPECT_EQ(buf.ReadableSize(), 5);
+
+    ConcurrentBuffer copy {buf};
+    buf.Retrieve(2);
+    EXPECT_EQ(buf.RetrieveAllToString(), "llo");
+    EXPECT_TRUE(buf.Empty());
+    EXPECT_EQ(copy.RetrieveAllToString(), "hello");
+}
+
 TEST(IOBufferTest, ReadWrite) {
     IOBuffer buf;
     EXPECT_TRUE(buf.Empty());
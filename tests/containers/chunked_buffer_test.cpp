@@ -0,0 +1,123 @@
+#include "containers/chunked_buffer.h"
+#include "io.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <array>
+#include <string>
+
+using namespace ws;
+
+
+TEST(ChunkAllocatorTest, AllocateAndRelease) {
+    ChunkAllocator allocator {0x10, 2};
+    EXPECT_EQ(allocator.ChunkSize(), 0x10);
+    EXPECT_EQ(allocator.FreeCount(), 0);
+
+    const auto first {allocator.Allocate()};
+    const auto second {allocator.Allocate()};
+    const auto third {allocator.Allocate()};
+    ASSERT_NE(first, nullptr);
+    EXPECT_NE(first, second);
+    EXPECT_NE(second, third);
+
+    // Released chunks are kept for reuse until the free list is full.
+    allocator.Release(first);
+    allocator.Release(second);
+    allocator.Release(third);
+    EXPECT_EQ(allocator.FreeCount(), 2);
+    EXPECT_EQ(allocator.Allocate(), first);
+    allocator.Release(first);
+}
+
+TEST(ChunkedBufferTest, AppendAndRetrieve) {
+    ChunkAllocator allocator {4};
+    ChunkedBuffer buf {allocator};
+    EXPECT_TRUE(buf.Empty());
+    EXPECT_EQ(buf.ChunkCount(), 0);
+
+    // Data spanning several chunks.
+    buf.Append("hello world");
+    EXPECT_EQ(buf.ReadableSize(), 11);
+    EXPECT_EQ(buf.ChunkCount(), 3);
+    EXPECT_EQ(buf.WritableSize(), 1);
+    EXPECT_EQ(buf.ReadableString(), "hello world");
+    EXPECT_EQ(buf.ReadableString(6), "hello ");
+    EXPECT_EQ(buf.ReadableString(0x100), "hello world");
+    EXPECT_EQ(buf.ReadableString(3, 5), "lo wo");
+    EXPECT_EQ(buf.ReadableString(8, 0x100), "rld");
+    EXPECT_TRUE(buf.ReadableString(11, 1).empty());
+
+    std::array<std::span<const std::byte>, 4> segments;
+    ASSERT_EQ(buf.ReadableSegments(segments), 3);
+    EXPECT_EQ(segments[0].size(), 4);
+    EXPECT_EQ(segments[2].size(), 3);
+
+    // Fully retrieved chunks are released.
+    buf.Retrieve(6);
+    EXPECT_EQ(buf.ChunkCount(), 2);
+    EXPECT_EQ(buf.ReadableString(), "world");
+    EXPECT_EQ(buf.ReadableString(1, 3), "orl");
+    ASSERT_EQ(buf.ReadableSegments(segments), 2);
+    EXPECT_EQ(segments[0].size(), 2);
+
+    EXPECT_EQ(buf.RetrieveAllToString(), "world");
+    EXPECT_TRUE(buf.Empty());
+
+    // An empty buffer reuses its remaining chunk from the beginning.
+    EXPECT_EQ(buf.ChunkCount(), 1);
+    EXPECT_EQ(buf.WritableSize(), 4);
+
+    buf.Shrink();
+    EXPECT_EQ(buf.ChunkCount(), 0);
+    EXPECT_GE(allocator.FreeCount(), 3);
+}
+
+TEST(ChunkedBufferTest, WritableSegments) {
+    ChunkAllocator allocator {4};
+    ChunkedBuffer buf {allocator};
+    buf.Append("ab");
+
+    std::array<std::span<std::byte>, 4> segments;
+    ASSERT_EQ(buf.WritableSegments(6, segments), 2);
+    EXPECT_EQ(segments[0].size(), 2);
+    EXPECT_EQ(segments[1].size(), 4);
+
+    segments[0][0] = std::byte {'c'};
+    segments[0][1] = std::byte {'d'};
+    segments[1][0] = std::byte {'e'};
+    buf.HasWritten(3);
+    EXPECT_EQ(buf.ReadableString(), "abcde");
+
+    // Unused chunks are released, but the chunk containing data is kept.
+    buf.EnsureWriteableSize(10);
+    buf.Shrink();
+    EXPECT_EQ(buf.ChunkCount(), 2);
+
+    ChunkedBuffer moved {std::move(buf)};
+    EXPECT_TRUE(buf.Empty());
+    EXPECT_EQ(buf.ChunkCount(), 0);
+    EXPECT_EQ(moved.RetrieveAllToString(), "abcde");
+}
+
+TEST(ChunkedBufferTest, Read) {
+    std::array<FileDescriptor, 2> fds {};
+    ASSERT_EQ(pipe(fds.data()), 0);
+
+    ChunkAllocator allocator {0x10};
+    ChunkedBuffer buf {allocator};
+    const std::string data(0x40, 'a');
+    ASSERT_EQ(write(fds[1], data.data(), data.size()), data.size());
+
+    io::FileDescriptor io {fds[0], fds[1]};
+
+    // Data is read directly into multiple chunks.
+    EXPECT_EQ(io.WriteTo(buf, data.size()), data.size());
+    EXPECT_GE(buf.ChunkCount(), 4);
+    EXPECT_EQ(buf.RetrieveAllToString(), data);
+
+    close(fds[0]);
+    close(fds[1]);
+}
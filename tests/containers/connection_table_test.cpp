@@ -0,0 +1,94 @@
+#include "containers/connection_table.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace ws;
+
+
+namespace {
+
+//! A connection that can be neither copied nor moved.
+struct Pinned {
+    explicit Pinned(std::string name) noexcept : name {std::move(name)} {}
+
+    Pinned(const Pinned&) = delete;
+
+    Pinned& operator=(const Pinned&) = delete;
+
+    std::string name;
+    std::atomic_int count {0};
+};
+
+}  // namespace
+
+
+TEST(ConnectionTableTest, EmplaceAndErase) {
+    ConnectionTable<Pinned> table;
+    EXPECT_TRUE(table.Empty());
+    EXPECT_FALSE(table.Contain(3));
+    EXPECT_FALSE(table.Contain(invalid_file_descriptor));
+    EXPECT_EQ(table.Find(3), nullptr);
+
+    auto& first {table.Emplace(3, "first")};
+    EXPECT_EQ(first.name, "first");
+    EXPECT_TRUE(table.Contain(3));
+    EXPECT_EQ(table.Find(3), &first);
+    EXPECT_EQ(table.Size(), 1);
+
+    // Growing the table does not move existing connections.
+    auto& second {table.Emplace(1000, "second")};
+    EXPECT_EQ(table.Find(3), &first);
+    EXPECT_EQ(table.Find(1000), &second);
+    EXPECT_FALSE(table.Contain(500));
+    EXPECT_EQ(table.Size(), 2);
+
+    EXPECT_TRUE(table.Erase(3));
+    EXPECT_FALSE(table.Erase(3));
+    EXPECT_FALSE(table.Contain(3));
+    EXPECT_EQ(table.Size(), 1);
+
+    table.Clear();
+    EXPECT_TRUE(table.Empty());
+    EXPECT_FALSE(table.Contain(1000));
+}
+
+TEST(ConnectionTableTest, InsertAndExtract) {
+    ConnectionTable<Pinned> table;
+    auto item {std::make_unique<Pinned>("item")};
+    const auto addr {item.get()};
+    EXPECT_EQ(&table.Insert(7, std::move(item)), addr);
+    const auto handle {table.GetHandle(7)};
+
+    // Extracting a connection keeps it alive but makes its handle stale.
+    item = table.Extract(7);
+    EXPECT_EQ(item.get(), addr);
+    EXPECT_FALSE(table.Contain(7));
+    EXPECT_EQ(table.Find(handle), nullptr);
+    EXPECT_EQ(table.Extract(7), nullptr);
+    EXPECT_TRUE(table.Empty());
+}
+
+TEST(ConnectionTableTest, Handle) {
+    ConnectionTable<Pinned> table;
+    table.Emplace(5, "old");
+    const auto old_handle {table.GetHandle(5)};
+    EXPECT_EQ(old_handle.socket, 5);
+    EXPECT_EQ(table.Find(old_handle)->name, "old");
+
+    // A handle becomes stale after its socket is reused by a new connection.
+    table.Erase(5);
+    EXPECT_EQ(table.Find(old_handle), nullptr);
+    table.Emplace(5, "new");
+    EXPECT_EQ(table.Find(old_handle), nullptr);
+
+    const auto new_handle {table.GetHandle(5)};
+    EXPECT_NE(new_handle, old_handle);
+    EXPECT_EQ(table.Find(new_handle)->name, "new");
+
+    table.Clear();
+    EXPECT_EQ(table.Find(new_handle), nullptr);
+}
@@ -0,0 +1,86 @@
+#include "containers/mpmc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+
+
+TEST(MPMCQueueTest, MinimumCapacity) {
+    // A single-slot queue would accept a second element into its occupied slot.
+    MPMCQueue<int> queue {1};
+    EXPECT_EQ(queue.Capacity(), 2);
+    EXPECT_TRUE(queue.TryPush(1));
+    EXPECT_TRUE(queue.TryPush(2));
+    EXPECT_FALSE(queue.TryPush(3));
+    EXPECT_EQ(queue.TryPop(), 1);
+    EXPECT_EQ(queue.TryPop(), 2);
+    EXPECT_FALSE(queue.TryPop());
+}
+
+TEST(MPMCQueueTest, PushAndPop) {
+    MPMCQueue<std::unique_ptr<int>> queue {2};
+    EXPECT_EQ(queue.Capacity(), 2);
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_FALSE(queue.TryPop());
+
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(1)));
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(2)));
+    EXPECT_EQ(queue.Size(), 2);
+
+    // An element is not moved if the queue is full.
+    auto item {std::make_unique<int>(3)};
+    EXPECT_FALSE(queue.TryPush(std::move(item)));
+    ASSERT_TRUE(item);
+
+    EXPECT_EQ(*queue.TryPop().value(), 1);
+    EXPECT_TRUE(queue.TryPush(std::move(item)));
+    EXPECT_EQ(*queue.TryPop().value(), 2);
+    EXPECT_EQ(*queue.TryPop().value(), 3);
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(MPMCQueueTest, ConcurrentPushAndPop) {
+    constexpr std::size_t thread_count {4};
+    constexpr std::size_t item_count {10000};
+
+    MPMCQueue<std::size_t> queue {0x40};
+    std::vector<std::atomic_size_t> taken(thread_count * item_count);
+    std::atomic_size_t pop_count {0};
+
+    std::vector<std::thread> threads;
+    for (std::size_t i {0}; i != thread_count; ++i) {
+        threads.emplace_back([&queue, i]() {
+            for (std::size_t j {0}; j != item_count; ++j) {
+                auto item {i * item_count + j};
+                while (!queue.TryPush(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        threads.emplace_back([&queue, &taken, &pop_count]() {
+            while (pop_count < taken.size()) {
+                if (const auto item {queue.TryPop()}; item.has_value()) {
+                    ++taken[item.value()];
+                    ++pop_count;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Each element is popped exactly once.
+    for (const auto& count : taken) {
+        ASSERT_EQ(count, 1);
+    }
+}
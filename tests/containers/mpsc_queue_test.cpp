@@ -0,0 +1,87 @@
+#include "containers/mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+
+
+TEST(MPSCQueueTest, PushAndPop) {
+    MPSCQueue<std::unique_ptr<int>> queue {2};
+    EXPECT_EQ(queue.Capacity(), 2);
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_FALSE(queue.TryPop());
+
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(1)));
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(2)));
+    EXPECT_EQ(queue.Size(), 2);
+
+    // An element is not moved if the queue is full.
+    auto item {std::make_unique<int>(3)};
+    EXPECT_FALSE(queue.TryPush(std::move(item)));
+    ASSERT_TRUE(item);
+
+    EXPECT_EQ(*queue.TryPop().value(), 1);
+    EXPECT_TRUE(queue.TryPush(std::move(item)));
+    EXPECT_EQ(*queue.TryPop().value(), 2);
+    EXPECT_EQ(*queue.TryPop().value(), 3);
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(MPSCQueueTest, ReleasePoppedSlots) {
+    MPSCQueue<std::shared_ptr<int>> queue {2};
+    const auto item {std::make_shared<int>(1)};
+    EXPECT_TRUE(queue.TryPush(std::shared_ptr {item}));
+    EXPECT_EQ(item.use_count(), 2);
+
+    // A popped slot does not keep the element alive.
+    EXPECT_EQ(queue.TryPop(), item);
+    EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(MPSCQueueTest, ConcurrentPush) {
+    constexpr std::size_t thread_count {4};
+    constexpr std::size_t item_count {10000};
+
+    MPSCQueue<std::size_t> queue {0x40};
+    std::vector<std::size_t> taken(thread_count * item_count);
+
+    std::vector<std::thread> producers;
+    for (std::size_t i {0}; i != thread_count; ++i) {
+        producers.emplace_back([&queue, i]() {
+            for (std::size_t j {0}; j != item_count; ++j) {
+                auto item {i * item_count + j};
+                while (!queue.TryPush(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Elements from the same producer are popped in order.
+    std::vector<std::size_t> last(thread_count, 0);
+    for (std::size_t pop_count {0}; pop_count != taken.size();) {
+        if (const auto item {queue.TryPop()}; item.has_value()) {
+            const auto producer {item.value() / item_count};
+            ASSERT_GE(item.value(), last[producer]);
+            last[producer] = item.value();
+            ++taken[item.value()];
+            ++pop_count;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+
+    // Each element is popped exactly once.
+    for (const auto count : taken) {
+        ASSERT_EQ(count, 1);
+    }
+}
@@ -0,0 +1,70 @@
+#include "containers/object_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace ws;
+
+
+namespace {
+
+class Object {
+public:
+    explicit Object(std::string name) noexcept : name_ {std::move(name)} {}
+
+    void Reset(std::string name) noexcept {
+        name_ = std::move(name);
+        ++reset_count_;
+    }
+
+    const std::string& Name() const noexcept {
+        return name_;
+    }
+
+    std::size_t ResetCount() const noexcept {
+        return reset_count_;
+    }
+
+private:
+    std::string name_;
+    std::size_t reset_count_ {0};
+};
+
+}  // namespace
+
+
+TEST(ObjectPoolTest, AcquireAndRelease) {
+    ObjectPool<Object> pool {1};
+    EXPECT_EQ(pool.Capacity(), 1);
+    EXPECT_EQ(pool.Size(), 0);
+
+    // A new object is created if there is no kept object.
+    auto first {pool.Acquire("first")};
+    EXPECT_EQ(first->Name(), "first");
+    EXPECT_EQ(first->ResetCount(), 0);
+    EXPECT_EQ(pool.MissCount(), 1);
+    EXPECT_EQ(pool.HitCount(), 0);
+
+    const auto addr {first.get()};
+    pool.Release(std::move(first));
+    EXPECT_EQ(pool.Size(), 1);
+
+    // A kept object is reinitialized and reused.
+    auto second {pool.Acquire("second")};
+    EXPECT_EQ(second.get(), addr);
+    EXPECT_EQ(second->Name(), "second");
+    EXPECT_EQ(second->ResetCount(), 1);
+    EXPECT_EQ(pool.HitCount(), 1);
+    EXPECT_EQ(pool.Size(), 0);
+
+    // An object released to a full pool is destroyed.
+    auto third {pool.Acquire("third")};
+    EXPECT_EQ(pool.MissCount(), 2);
+    pool.Release(std::move(second));
+    pool.Release(std::move(third));
+    EXPECT_EQ(pool.Size(), 1);
+
+    pool.Clear();
+    EXPECT_EQ(pool.Size(), 0);
+}
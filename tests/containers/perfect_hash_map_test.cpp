@@ -0,0 +1,61 @@
+#include "containers/perfect_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace ws;
+
+
+namespace {
+
+enum class Color { Red, Green, Blue };
+
+constexpr auto colors {MakePerfectHashMap<Color>({
+    {"red", Color::Red},
+    {"green", Color::Green},
+    {"blue", Color::Blue},
+})};
+
+// Maps are built and queried at compile time.
+static_assert(colors.Find("red") == Color::Red);
+static_assert(!colors.Contains("yellow"));
+
+}  // namespace
+
+
+TEST(PerfectHashMapTest, Find) {
+    EXPECT_EQ(colors.Size(), 3);
+    EXPECT_EQ(colors.Find("red"), Color::Red);
+    EXPECT_EQ(colors.Find("green"), Color::Green);
+    EXPECT_EQ(colors.Find("blue"), Color::Blue);
+
+    EXPECT_FALSE(colors.Find(""));
+    EXPECT_FALSE(colors.Find("yellow"));
+    EXPECT_FALSE(colors.Find("re"));
+    EXPECT_FALSE(colors.Find("reds"));
+}
+
+TEST(PerfectHashMapTest, CaseInsensitive) {
+    EXPECT_EQ(colors.Find("RED"), Color::Red);
+    EXPECT_EQ(colors.Find("Green"), Color::Green);
+    EXPECT_EQ(colors.Find("bLuE"), Color::Blue);
+
+    EXPECT_TRUE(EqualsIgnoreCase("Content-Length", "content-length"));
+    EXPECT_FALSE(EqualsIgnoreCase("Content-Length", "Content-Type"));
+    EXPECT_EQ(HashIgnoreCase("Host", 1), HashIgnoreCase("HOST", 1));
+}
+
+TEST(PerfectHashMapTest, ManyKeys) {
+    static constexpr auto numbers {MakePerfectHashMap<int>({
+        {"zero", 0},   {"one", 1},      {"two", 2},     {"three", 3},
+        {"four", 4},   {"five", 5},     {"six", 6},     {"seven", 7},
+        {"eight", 8},  {"nine", 9},     {"ten", 10},    {"eleven", 11},
+        {"twelve", 12}, {"thirteen", 13}, {"fourteen", 14}, {"fifteen", 15},
+    })};
+
+    for (const auto& [key, value] : numbers.Entries()) {
+        EXPECT_EQ(numbers.Find(key), value);
+        EXPECT_EQ(numbers.Find(std::string {key} + "s"), std::nullopt);
+    }
+}
@@ -0,0 +1,173 @@
+#include "containers/poller.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <future>
+#include <system_error>
+#include <vector>
+
+using namespace ws;
+
+
+class PollerTest : public testing::TestWithParam<Poller::Backend> {
+protected:
+    static constexpr std::chrono::milliseconds time_out {10};
+
+    void SetUp() override {
+        try {
+            poller_ = Poller::Create({.backend = GetParam()});
+        } catch (const std::system_error& err) {
+            GTEST_SKIP() << err.what();
+        }
+
+        event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ASSERT_TRUE(IsValidFileDescriptor(event_));
+    }
+
+    void TearDown() override {
+        if (IsValidFileDescriptor(event_)) {
+            close(event_);
+        }
+    }
+
+    void Notify() const noexcept {
+        const std::uint64_t count {1};
+        ASSERT_EQ(write(event_, &count, sizeof(count)), sizeof(count));
+    }
+
+    Poller::Ptr poller_;
+    FileDescriptor event_ {invalid_file_descriptor};
+};
+
+INSTANTIATE_TEST_SUITE_P(Backends, PollerTest,
+                         testing::Values(Poller::Backend::Epoll,
+                                         Poller::Backend::IoUring));
+
+TEST(PollerBackendTest, ToBackend) {
+    EXPECT_EQ(Poller::ToBackend("epoll"), Poller::Backend::Epoll);
+    EXPECT_EQ(Poller::ToBackend("io_uring"), Poller::Backend::IoUring);
+    EXPECT_THROW(Poller::ToBackend("select"), std::invalid_argument);
+}
+
+TEST_P(PollerTest, Wait) {
+    poller_->AddFileDescriptor(event_, EPOLLIN);
+    EXPECT_EQ(poller_->Wait(time_out), 0);
+
+    Notify();
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+    EXPECT_EQ(poller_->FileDescriptor(0), event_);
+    EXPECT_TRUE(poller_->Events(0) & EPOLLIN);
+}
+
+TEST_P(PollerTest, OneShot) {
+    poller_->AddFileDescriptor(event_, EPOLLONESHOT | EPOLLIN);
+    Notify();
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+
+    // The file descriptor is still readable but has been disarmed.
+    EXPECT_EQ(poller_->Wait(time_out), 0);
+
+    // Re-arm the file descriptor.
+    poller_->ModifyFileDescriptor(event_, EPOLLONESHOT | EPOLLIN);
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+    EXPECT_EQ(poller_->FileDescriptor(0), event_);
+}
+
+TEST_P(PollerTest, Modify) {
+    poller_->AddFileDescriptor(event_, EPOLLONESHOT | EPOLLIN);
+    EXPECT_EQ(poller_->Wait(time_out), 0);
+
+    // Change the events before they are triggered.
+    poller_->ModifyFileDescriptor(event_, EPOLLONESHOT | EPOLLOUT);
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+    EXPECT_TRUE(poller_->Events(0) & EPOLLOUT);
+    EXPECT_FALSE(poller_->Events(0) & EPOLLIN);
+
+    // Re-arm the file descriptor in another thread while waiting.
+    auto waiting {std::async(std::launch::async, [this] {
+        return poller_->Wait(std::chrono::seconds {5});
+    })};
+
+    std::this_thread::sleep_for(time_out);
+    Notify();
+    poller_->ModifyFileDescriptor(event_, EPOLLONESHOT | EPOLLIN);
+    ASSERT_EQ(waiting.get(), 1);
+    EXPECT_TRUE(poller_->Events(0) & EPOLLIN);
+}
+
+TEST_P(PollerTest, Delete) {
+    poller_->AddFileDescriptor(event_, EPOLLIN);
+    poller_->DeleteFileDescriptor(event_);
+    Notify();
+    EXPECT_EQ(poller_->Wait(time_out), 0);
+
+    // The file descriptor can be added again.
+    poller_->AddFileDescriptor(event_, EPOLLIN);
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+    EXPECT_EQ(poller_->FileDescriptor(0), event_);
+
+    // Throw an exception if a file descriptor is not in the poller.
+    poller_->DeleteFileDescriptor(event_);
+    EXPECT_THROW(poller_->DeleteFileDescriptor(event_), std::system_error);
+    EXPECT_THROW(poller_->ModifyFileDescriptor(event_, EPOLLIN),
+                 std::system_error);
+}
+
+TEST_P(PollerTest, SubMillisecondTimeOut) {
+    using namespace std::chrono_literals;
+
+    poller_->AddFileDescriptor(event_, EPOLLIN);
+
+    // A time-out shorter than a millisecond must not be rounded down to zero.
+    const auto start {Poller::Clock::now()};
+    EXPECT_EQ(poller_->Wait(500us), 0);
+    EXPECT_GE(Poller::Clock::now() - start, 500us);
+}
+
+TEST_P(PollerTest, BusyPoll) {
+    using namespace std::chrono_literals;
+
+    poller_->SetBusyPoll(1ms);
+    poller_->AddFileDescriptor(event_, EPOLLIN);
+    EXPECT_EQ(poller_->Wait(time_out), 0);
+
+    Notify();
+    ASSERT_EQ(poller_->Wait(time_out), 1);
+    EXPECT_EQ(poller_->FileDescriptor(0), event_);
+}
+
+TEST_P(PollerTest, MaxEvents) {
+    constexpr std::size_t fd_count {300};
+    constexpr std::size_t max_events {200};
+
+    poller_ = Poller::Create({.backend = GetParam(), .max_events = max_events});
+
+    std::vector<FileDescriptor> fds;
+    for (std::size_t i {0}; i != fd_count; ++i) {
+        const auto fd {eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC)};
+        ASSERT_TRUE(IsValidFileDescriptor(fd));
+        fds.push_back(fd);
+        poller_->AddFileDescriptor(fd, EPOLLIN);
+    }
+
+    // All file descriptors stay readable.
+    // The event array grows until a wait returns as many events as allowed.
+    std::size_t max_ready_count {0};
+    for (auto i {0}; i != 10; ++i) {
+        const auto count {poller_->Wait(time_out)};
+        EXPECT_LE(count, max_events);
+        max_ready_count = std::max(max_ready_count, count);
+    }
+
+    EXPECT_EQ(max_ready_count, max_events);
+
+    poller_.reset();
+    for (const auto fd : fds) {
+        close(fd);
+    }
+}
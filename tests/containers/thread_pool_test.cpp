@@ -1,15 +1,60 @@
 #include "containers/thread_pool.h"
+#include "containers/work_stealing_thread_pool.h"
 #include "test_util.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <sched.h>
+
+#include <atomic>
 #include <chrono>
+#include <latch>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace ws;
 using namespace ws::test;
 
 
+namespace {
+
+//! Check that tasks waiting behind a running task are counted as queued.
+void ExpectQueuedCount(Executor& pool) {
+    using namespace std::chrono_literals;
+
+    std::atomic_bool started {false};
+    std::atomic_bool blocked {true};
+    pool.Push([&started, &blocked]() {
+        started = true;
+        while (blocked) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+
+    while (!started) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    constexpr std::size_t task_num {3};
+    std::latch finished {task_num};
+    for (std::size_t i {0}; i != task_num; ++i) {
+        pool.Push([&finished]() { finished.count_down(); });
+    }
+
+    EXPECT_EQ(pool.QueuedCount(), task_num);
+
+    blocked = false;
+    finished.wait();
+    EXPECT_EQ(pool.QueuedCount(), 0);
+    pool.Close();
+}
+
+}  // namespace
+
+
 TEST(ThreadPoolTest, Execution) {
     using namespace std::chrono_literals;
 
@@ -30,4 +75,154 @@ TEST(ThreadPoolTest, Execution) {
     // Wait a short time for the logger to log events.
     // It is normal that a thread pool may not have executed all tasks when it is closed.
     std::this_thread::sleep_for(0.01s);
-}
\ No newline at end of file
+}
+
+TEST(ThreadPoolTest, MetricsLabel) {
+    // Pools with different purposes are told apart by labels.
+    const ThreadPool pool {1, TestLogger(), "test"};
+    const auto exposed {metrics::DefaultRegistry().Expose()};
+    EXPECT_NE(exposed.find("ws_thread_pool_queued_tasks{pool=\"test\"}"),
+              std::string::npos);
+}
+
+TEST(ThreadPoolTest, PushBatch) {
+    constexpr std::size_t task_num {100};
+
+    ThreadPool pool {2, TestLogger()};
+    pool.Start();
+
+    std::atomic_size_t count {0};
+    std::latch finished {task_num};
+    std::vector<Executor::Task> tasks;
+    for (std::size_t i {0}; i != task_num; ++i) {
+        tasks.emplace_back([&count, &finished]() {
+            ++count;
+            finished.count_down();
+        });
+    }
+
+    pool.PushBatch(tasks);
+    finished.wait();
+    EXPECT_EQ(count, task_num);
+    pool.Close();
+}
+
+TEST(ThreadPoolTest, QueuedCount) {
+    ThreadPool pool {1, TestLogger()};
+    pool.Start();
+    ExpectQueuedCount(pool);
+}
+
+TEST(ThreadPoolTest, Affinity) {
+    cpu_set_t set;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+    std::size_t cpu {0};
+    while (!CPU_ISSET(cpu, &set)) {
+        ++cpu;
+    }
+
+    ThreadPool pool {2, TestLogger()};
+    EXPECT_TRUE(pool.Affinity().empty());
+    pool.SetAffinity({cpu});
+    EXPECT_EQ(pool.Affinity(), (std::vector<std::size_t> {cpu}));
+    pool.Start();
+
+    // Both threads are pinned to the only CPU in the list.
+    constexpr std::size_t task_num {10};
+    std::atomic_size_t pinned_count {0};
+    std::latch finished {task_num};
+    for (std::size_t i {0}; i != task_num; ++i) {
+        pool.Push([cpu, &pinned_count, &finished]() {
+            if (sched_getcpu() == static_cast<int>(cpu)) {
+                ++pinned_count;
+            }
+
+            finished.count_down();
+        });
+    }
+
+    finished.wait();
+    EXPECT_EQ(pinned_count, task_num);
+    pool.Close();
+}
+
+TEST(WorkStealingThreadPoolTest, Execution) {
+    constexpr std::size_t task_num {1000};
+
+    WorkStealingThreadPool pool {4, TestLogger(), 0x10};
+    pool.Start();
+
+    // Tasks are pushed both from the current thread and from working threads.
+    std::atomic_size_t count {0};
+    std::latch finished {task_num * 2};
+    for (std::size_t i {0}; i != task_num; ++i) {
+        pool.Push([&pool, &count, &finished]() {
+            ++count;
+            finished.count_down();
+            pool.Push([&count, &finished]() {
+                ++count;
+                finished.count_down();
+            });
+        });
+    }
+
+    finished.wait();
+    EXPECT_EQ(count, task_num * 2);
+    pool.Close();
+}
+
+TEST(WorkStealingThreadPoolTest, PushBatch) {
+    constexpr std::size_t task_num {100};
+
+    // The batch is larger than the injection queue.
+    WorkStealingThreadPool pool {2, TestLogger(), 0x10};
+    pool.Start();
+
+    std::atomic_size_t count {0};
+    std::latch finished {task_num};
+    std::vector<Executor::Task> tasks;
+    for (std::size_t i {0}; i != task_num; ++i) {
+        tasks.emplace_back([&count, &finished]() {
+            ++count;
+            finished.count_down();
+        });
+    }
+
+    pool.PushBatch(tasks);
+    finished.wait();
+    EXPECT_EQ(count, task_num);
+    pool.Close();
+}
+
+TEST(WorkStealingThreadPoolTest, QueuedCount) {
+    WorkStealingThreadPool pool {1, TestLogger()};
+    pool.Start();
+    ExpectQueuedCount(pool);
+}
+
+TEST(WorkStealingThreadPoolTest, Close) {
+    using namespace std::chrono_literals;
+
+    std::atomic_bool blocked {true};
+    const auto data {std::make_shared<int>(0)};
+    {
+        WorkStealingThreadPool pool {1, TestLogger()};
+        pool.Start();
+        pool.Push([&blocked]() {
+            while (blocked) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+
+        for (auto i {0}; i != 10; ++i) {
+            pool.Push([data]() { ++*data; });
+        }
+
+        pool.Close();
+        blocked = false;
+    }
+
+    // Remaining tasks are destroyed without being executed.
+    EXPECT_EQ(*data, 0);
+    EXPECT_EQ(data.use_count(), 1);
+}
@@ -0,0 +1,200 @@
+#include "containers/timing_wheel.h"
+#include "test_util.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <ranges>
+#include <thread>
+
+using namespace ws;
+using namespace ws::test;
+
+
+class TimingWheelTest : public testing::Test {
+protected:
+    class Handler {
+    public:
+        MOCK_METHOD(void, OnTimeOut, (const int&), (const, noexcept));
+    };
+
+    using Clock = TimingWheel<int>::Clock;
+
+    static constexpr std::chrono::milliseconds resolution {1};
+
+    static inline const std::vector<int> init_vals_ {1, 2, 3, 4, 5};
+
+    void SetUp() override {
+        std::vector<int> vals {init_vals_.cbegin(), init_vals_.cend()};
+        std::random_shuffle(vals.begin(), vals.end());
+
+        std::ranges::for_each(vals, [this](const auto val) noexcept {
+            // The nodes with large values will have a later expiry time.
+            wheel1_.Push(val, std::chrono::milliseconds {val * 5},
+                         [this](const int& key) { handler_.OnTimeOut(key); });
+
+            // All nodes have the same expiry time.
+            // Throw an exception in the callback.
+            wheel2_.Push(val, Clock::duration::zero(),
+                         [this](const int&) { throw std::runtime_error {""}; });
+        });
+    }
+
+    //! Wait until all nodes in `wheel1_` have expired.
+    static void WaitForExpiration() noexcept {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds {init_vals_.back() * 5} + resolution * 2);
+    }
+
+    Handler handler_;
+    TimingWheel<int> wheel0_ {TestLogger(), resolution};
+    TimingWheel<int> wheel1_ {TestLogger(), resolution};
+    TimingWheel<int> wheel2_ {TestLogger(), resolution};
+};
+
+TEST_F(TimingWheelTest, Construction) {
+    EXPECT_TRUE(wheel0_.Empty());
+    EXPECT_EQ(wheel0_.Size(), 0);
+}
+
+TEST_F(TimingWheelTest, Push) {
+    EXPECT_FALSE(wheel1_.Empty());
+    EXPECT_EQ(wheel1_.Size(), init_vals_.size());
+
+    // The timer system must contain all pushed nodes.
+    for (const auto val : init_vals_) {
+        EXPECT_TRUE(wheel1_.Contain(val));
+    }
+
+    // Pushing an existing node replaces its expiration time and callback.
+    EXPECT_CALL(handler_, OnTimeOut(6)).Times(1);
+    wheel1_.Push(1, Clock::duration::zero(),
+                 [this](const int&) { handler_.OnTimeOut(6); });
+    EXPECT_EQ(wheel1_.Size(), init_vals_.size());
+    std::this_thread::sleep_for(resolution * 2);
+    wheel1_.Tick();
+    EXPECT_FALSE(wheel1_.Contain(1));
+}
+
+TEST_F(TimingWheelTest, Adjust) {
+    using namespace std::chrono_literals;
+
+    // Postpone the node `1`, so it does not expire with other nodes.
+    wheel1_.Adjust(1, 10min);
+    EXPECT_CALL(handler_, OnTimeOut(1)).Times(0);
+    for (const auto val : init_vals_ | std::views::drop(1)) {
+        EXPECT_CALL(handler_, OnTimeOut(val)).Times(1);
+    }
+
+    WaitForExpiration();
+    wheel1_.Tick();
+    EXPECT_EQ(wheel1_.Size(), 1);
+    EXPECT_TRUE(wheel1_.Contain(1));
+
+    // Bring the node `1` forward.
+    EXPECT_CALL(handler_, OnTimeOut(1)).Times(1);
+    wheel1_.Adjust(1, Clock::duration::zero());
+    std::this_thread::sleep_for(resolution * 2);
+    wheel1_.Tick();
+    EXPECT_TRUE(wheel1_.Empty());
+
+    // Throw an exception if a node is not in the timer system.
+    EXPECT_FALSE(wheel0_.Contain(1));
+    EXPECT_THROW((wheel0_.Adjust(1, Clock::now())), std::out_of_range);
+}
+
+TEST_F(TimingWheelTest, Remove) {
+    using namespace testing;
+
+    EXPECT_TRUE(wheel1_.Remove(2));
+    EXPECT_FALSE(wheel1_.Contain(2));
+    EXPECT_EQ(wheel1_.Size(), init_vals_.size() - 1);
+
+    // A removed node will not expire.
+    EXPECT_CALL(handler_, OnTimeOut(2)).Times(0);
+    EXPECT_CALL(handler_, OnTimeOut(Ne(2))).Times(init_vals_.size() - 1);
+    WaitForExpiration();
+    wheel1_.Tick();
+    EXPECT_TRUE(wheel1_.Empty());
+
+    // Remove a non-existing node from a timer system.
+    EXPECT_FALSE(wheel0_.Contain(0));
+    EXPECT_FALSE(wheel0_.Remove(0));
+}
+
+TEST_F(TimingWheelTest, Invoke) {
+    auto size {wheel1_.Size()};
+    EXPECT_CALL(handler_, OnTimeOut(1)).Times(1);
+    wheel1_.Invoke(1);
+    size -= 1;
+    EXPECT_EQ(wheel1_.Size(), size);
+
+    // Throw an exception if a node is not in the timer system.
+    EXPECT_THROW(wheel0_.Invoke(1), std::out_of_range);
+    EXPECT_THROW(wheel1_.Invoke(1), std::out_of_range);
+
+    // The exception in the callback will not be rethrown.
+    EXPECT_NO_THROW(wheel2_.Invoke(1));
+}
+
+TEST_F(TimingWheelTest, Tick) {
+    using namespace testing;
+
+    {
+        // Callbacks in different ticks should be invoked in order of expiration time.
+        InSequence seq;
+        for (const auto val : init_vals_) {
+            EXPECT_CALL(handler_, OnTimeOut(val)).Times(1);
+        }
+    }
+
+    WaitForExpiration();
+    wheel1_.Tick();
+    EXPECT_TRUE(wheel1_.Empty());
+
+    // The exception in the callback will not be rethrown.
+    std::this_thread::sleep_for(resolution * 2);
+    EXPECT_NO_THROW(wheel2_.Tick());
+    EXPECT_TRUE(wheel2_.Empty());
+}
+
+TEST_F(TimingWheelTest, Cascade) {
+    using namespace std::chrono_literals;
+
+    // The node is beyond the first level and will be cascaded before expiring.
+    EXPECT_CALL(handler_, OnTimeOut(1)).Times(1);
+    wheel0_.Push(1, 100ms, [this](const int& key) { handler_.OnTimeOut(key); });
+
+    // The node is beyond the whole wheel.
+    wheel0_.Push(2, 100h, [this](const int& key) { handler_.OnTimeOut(key); });
+
+    std::this_thread::sleep_for(50ms);
+    wheel0_.Tick();
+    EXPECT_TRUE(wheel0_.Contain(1));
+
+    std::this_thread::sleep_for(60ms);
+    wheel0_.Tick();
+    EXPECT_FALSE(wheel0_.Contain(1));
+    EXPECT_TRUE(wheel0_.Contain(2));
+}
+
+TEST_F(TimingWheelTest, ToNextTick) {
+    using namespace std::chrono_literals;
+
+    // The interval should not exceed the expiration time of the earliest node.
+    const auto interval {wheel1_.ToNextTick()};
+    EXPECT_GT(interval, Clock::duration::zero());
+    EXPECT_LE(interval, 5ms + resolution);
+
+    // All nodes have expired, so the interval from now to the next tick should be zero.
+    EXPECT_CALL(handler_, OnTimeOut(testing::_)).Times(init_vals_.size());
+    WaitForExpiration();
+    EXPECT_EQ(wheel1_.ToNextTick(), Clock::duration::zero());
+    EXPECT_TRUE(wheel1_.Empty());
+}
+
+TEST_F(TimingWheelTest, Clear) {
+    EXPECT_FALSE(wheel1_.Empty());
+    wheel1_.Clear();
+    EXPECT_TRUE(wheel1_.Empty());
+}
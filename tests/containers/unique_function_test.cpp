@@ -0,0 +1,63 @@
+#include "containers/unique_function.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+using namespace ws;
+
+
+TEST(UniqueFunctionTest, Invocation) {
+    UniqueFunction<int(int, int)> empty;
+    EXPECT_FALSE(empty);
+
+    UniqueFunction<int(int, int)> add {[](const int a, const int b) {
+        return a + b;
+    }};
+    ASSERT_TRUE(add);
+    EXPECT_EQ(add(1, 2), 3);
+
+    // A move-only callable can be stored.
+    auto value {std::make_unique<std::string>("mike")};
+    UniqueFunction<std::string()> get {
+        [value = std::move(value)]() { return *value; }};
+    EXPECT_EQ(get(), "mike");
+
+    // Arguments are forwarded.
+    UniqueFunction<void(std::unique_ptr<int>&&, int&)> take {
+        [](std::unique_ptr<int>&& ptr, int& out) { out = *ptr; }};
+    auto ptr {std::make_unique<int>(5)};
+    int out {0};
+    take(std::move(ptr), out);
+    EXPECT_EQ(out, 5);
+}
+
+TEST(UniqueFunctionTest, MoveAndReset) {
+    const auto data {std::make_shared<int>(1)};
+
+    UniqueFunction<int()> func {[data]() { return *data; }};
+    EXPECT_EQ(data.use_count(), 2);
+
+    auto moved {std::move(func)};
+    EXPECT_FALSE(func);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(moved(), 1);
+    EXPECT_EQ(data.use_count(), 2);
+
+    func = std::move(moved);
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(func(), 1);
+
+    // The callable is destroyed after being reset.
+    func = nullptr;
+    EXPECT_FALSE(func);
+    EXPECT_EQ(data.use_count(), 1);
+
+    {
+        UniqueFunction<int()> temp {[data]() { return *data; }};
+        EXPECT_EQ(data.use_count(), 2);
+    }
+
+    EXPECT_EQ(data.use_count(), 1);
+}
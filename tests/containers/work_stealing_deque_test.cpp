@@ -0,0 +1,89 @@
+#include "containers/work_stealing_deque.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+
+
+TEST(WorkStealingDequeTest, PushPopAndSteal) {
+    WorkStealingDeque<int> deq {3};
+    EXPECT_EQ(deq.Capacity(), 4);
+    EXPECT_TRUE(deq.Empty());
+    EXPECT_FALSE(deq.Pop());
+    EXPECT_FALSE(deq.Steal());
+
+    for (auto i {0}; i != 4; ++i) {
+        EXPECT_TRUE(deq.Push(i));
+    }
+
+    EXPECT_FALSE(deq.Push(4));
+    EXPECT_EQ(deq.Size(), 4);
+
+    // The owner pops the last element and thieves steal the first element.
+    EXPECT_EQ(deq.Pop(), 3);
+    EXPECT_EQ(deq.Steal(), 0);
+    EXPECT_EQ(deq.Steal(), 1);
+    EXPECT_EQ(deq.Pop(), 2);
+    EXPECT_TRUE(deq.Empty());
+    EXPECT_FALSE(deq.Pop());
+
+    // Indexes wrap around the capacity.
+    for (auto i {0}; i != 4; ++i) {
+        EXPECT_TRUE(deq.Push(i));
+    }
+
+    EXPECT_EQ(deq.Steal(), 0);
+    EXPECT_EQ(deq.Size(), 3);
+}
+
+TEST(WorkStealingDequeTest, ConcurrentSteal) {
+    constexpr std::size_t item_count {100000};
+    constexpr std::size_t thief_count {3};
+
+    WorkStealingDeque<std::size_t> deq {0x100};
+    std::vector<std::atomic_size_t> taken(item_count);
+    std::atomic_bool done {false};
+
+    std::vector<std::thread> thieves;
+    for (std::size_t i {0}; i != thief_count; ++i) {
+        thieves.emplace_back([&deq, &taken, &done]() {
+            while (!done || !deq.Empty()) {
+                if (const auto item {deq.Steal()}; item.has_value()) {
+                    ++taken[item.value()];
+                }
+            }
+        });
+    }
+
+    for (std::size_t i {0}; i != item_count; ++i) {
+        while (!deq.Push(i)) {
+            if (const auto item {deq.Pop()}; item.has_value()) {
+                ++taken[item.value()];
+            }
+        }
+
+        if (i % 3 == 0) {
+            if (const auto item {deq.Pop()}; item.has_value()) {
+                ++taken[item.value()];
+            }
+        }
+    }
+
+    while (const auto item {deq.Pop()}) {
+        ++taken[item.value()];
+    }
+
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    // Each element is taken exactly once.
+    for (const auto& count : taken) {
+        ASSERT_EQ(count, 1);
+    }
+}
@@ -0,0 +1,166 @@
+#include "coroutine.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ws;
+using namespace ws::coro;
+
+
+namespace {
+
+coro::Task<int> Add(const int lhs, const int rhs) {
+    co_return lhs + rhs;
+}
+
+coro::Task<int> Sum(const int count) {
+    int sum {0};
+    for (auto i {0}; i != count; ++i) {
+        sum = co_await Add(sum, i);
+    }
+
+    co_return sum;
+}
+
+coro::Task<> Fail() {
+    throw std::runtime_error {"failure"};
+    co_return;
+}
+
+coro::Task<std::string> Catch() {
+    try {
+        co_await Fail();
+    } catch (const std::runtime_error& err) {
+        co_return err.what();
+    }
+
+    co_return "";
+}
+
+//! Read from a socket, waiting for it to be readable whenever a read would block.
+coro::Task<> Read(SocketReadiness& socket, std::vector<int>& reads,
+                  const int count) {
+    for (auto i {0}; i != count; ++i) {
+        co_await socket.Readable();
+        reads.push_back(i);
+        socket.ClearReadable();
+    }
+}
+
+coro::Task<> Serve(SocketReadiness& socket, std::vector<int>& reads) {
+    co_await Read(socket, reads, 2);
+    co_await socket.Writable();
+}
+
+}  // namespace
+
+
+TEST(CoroutineTest, FramePool) {
+    const auto hits {FramePool::HitCount()};
+    const auto misses {FramePool::MissCount()};
+
+    constexpr std::size_t size {100};
+    const auto frame {FramePool::Allocate(size)};
+    FramePool::Deallocate(frame, size);
+    EXPECT_EQ(FramePool::MissCount(), misses + 1);
+
+    // A frame of the same size class reuses the freed one.
+    EXPECT_EQ(FramePool::Allocate(size + 1), frame);
+    EXPECT_EQ(FramePool::HitCount(), hits + 1);
+    FramePool::Deallocate(frame, size + 1);
+
+    // A frame of another size class does not.
+    const auto other {FramePool::Allocate(size + FramePool::granularity)};
+    EXPECT_NE(other, frame);
+    FramePool::Deallocate(other, size + FramePool::granularity);
+
+    // Large frames are not pooled.
+    const auto large {FramePool::Allocate(FramePool::max_pooled_size + 1)};
+    FramePool::Deallocate(large, FramePool::max_pooled_size + 1);
+    EXPECT_EQ(FramePool::HitCount(), hits + 1);
+    EXPECT_EQ(FramePool::MissCount(), misses + 2);
+}
+
+TEST(CoroutineTest, TaskFramesArePooled) {
+    // Warm up the pool.
+    auto task {Sum(1)};
+    task.Start();
+    EXPECT_EQ(task.Result(), 0);
+
+    const auto misses {FramePool::MissCount()};
+    task = Sum(10);
+    task.Start();
+    EXPECT_TRUE(task.Done());
+    EXPECT_EQ(task.Result(), 45);
+    EXPECT_EQ(FramePool::MissCount(), misses);
+}
+
+TEST(CoroutineTest, TaskIsLazy) {
+    auto task {Add(1, 2)};
+    EXPECT_TRUE(task);
+    EXPECT_FALSE(task.Done());
+    task.Start();
+    EXPECT_TRUE(task.Done());
+    EXPECT_EQ(task.Result(), 3);
+
+    EXPECT_TRUE(coro::Task<> {}.Done());
+}
+
+TEST(CoroutineTest, TaskException) {
+    auto failed {Fail()};
+    failed.Start();
+    EXPECT_TRUE(failed.Done());
+    EXPECT_THROW(failed.Result(), std::runtime_error);
+
+    // An exception is rethrown to the awaiting coroutine.
+    auto caught {Catch()};
+    caught.Start();
+    EXPECT_EQ(caught.Result(), "failure");
+}
+
+TEST(CoroutineTest, SocketReadiness) {
+    SocketReadiness socket;
+    std::vector<int> reads;
+
+    auto task {Serve(socket, reads)};
+    task.Start();
+    EXPECT_TRUE(socket.Waiting());
+    EXPECT_TRUE(reads.empty());
+
+    // An event the coroutine is not waiting for does not resume it.
+    EXPECT_FALSE(socket.Notify(EPOLLOUT));
+
+    // The handle of the awaited task is returned to be resumed.
+    auto waiter {socket.Notify(EPOLLIN)};
+    ASSERT_TRUE(waiter);
+    EXPECT_FALSE(socket.Waiting());
+    waiter.resume();
+    EXPECT_EQ(reads, std::vector<int> {0});
+    EXPECT_TRUE(socket.Waiting());
+
+    // The coroutine continues without suspension as the socket has been writable.
+    waiter = socket.Notify(EPOLLIN | EPOLLRDHUP);
+    ASSERT_TRUE(waiter);
+    waiter.resume();
+    EXPECT_EQ(reads, (std::vector<int> {0, 1}));
+    EXPECT_TRUE(task.Done());
+    EXPECT_FALSE(socket.Waiting());
+
+    socket.Reset();
+    EXPECT_FALSE(socket.Notify(EPOLLIN));
+}
+
+TEST(CoroutineTest, DestroySuspendedTask) {
+    SocketReadiness socket;
+    std::vector<int> reads;
+    {
+        auto task {Serve(socket, reads)};
+        task.Start();
+        EXPECT_TRUE(socket.Waiting());
+    }
+
+    EXPECT_TRUE(reads.empty());
+}
@@ -1,16 +1,69 @@
 #include "http.h"
+#include "test_util.h"
 
 #include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace ws;
 using namespace ws::http;
 
 
+namespace {
+
+//! Read all available data from a non-blocking socket.
+std::string ReadAll(const FileDescriptor socket) {
+    std::string data;
+    std::array<char, 0x1000> chunk {};
+    while (true) {
+        if (const auto size {read(socket, chunk.data(), chunk.size())};
+            size > 0) {
+            data.append(chunk.data(), size);
+        } else {
+            break;
+        }
+    }
+
+    return data;
+}
+
+//! Count occurrences of a substring.
+std::size_t Count(const std::string_view str, const std::string_view sub) {
+    std::size_t count {0};
+    for (auto pos {str.find(sub)}; pos != std::string_view::npos;
+         pos = str.find(sub, pos + sub.length())) {
+        ++count;
+    }
+
+    return count;
+}
+
+}  // namespace
+
+
 TEST(HTTPTest, StatusCodeEnumConversion) {
     EXPECT_EQ(StatusCodeToMessage(StatusCode::OK), "OK");
     EXPECT_EQ(StatusCodeToMessage(StatusCode::Forbidden), "Forbidden");
 
     EXPECT_EQ(StatusCodeToInteger(StatusCode::OK), 200);
     EXPECT_EQ(StatusCodeToInteger(StatusCode::Forbidden), 403);
+
+    EXPECT_EQ(StatusCodeToMessage(StatusCode::ServiceUnavailable),
+              "Service Unavailable");
+    EXPECT_EQ(StatusCodeToInteger(StatusCode::ServiceUnavailable), 503);
+
+    EXPECT_EQ(StatusCodeToMessage(StatusCode::PayloadTooLarge),
+              "Payload Too Large");
+    EXPECT_EQ(StatusCodeToInteger(StatusCode::PayloadTooLarge), 413);
+    EXPECT_EQ(StatusCodeToMessage(StatusCode::RequestHeaderFieldsTooLarge),
+              "Request Header Fields Too Large");
+    EXPECT_EQ(StatusCodeToInteger(StatusCode::RequestHeaderFieldsTooLarge), 431);
 }
 
 TEST(HTTPTest, MethodEnumConversion) {
@@ -27,12 +80,216 @@ TEST(HTTPTest, ContentType) {
     EXPECT_EQ(ContentTypeByFileName("x.jpg"), "image/jpeg");
     EXPECT_EQ(ContentTypeByFileName("unknown"), "application/octet-stream");
     EXPECT_EQ(ContentTypeByFileName("x.unknown"), "application/octet-stream");
+    EXPECT_EQ(ContentTypeByFileName("/path/to/x.Html"), "text/html");
+    EXPECT_EQ(ContentTypeByFileName("x.tar.gz"), "application/x-gzip");
+    EXPECT_EQ(ContentTypeByFileName("dir.png/x"), "application/octet-stream");
+    EXPECT_EQ(ContentTypeByFileName(".png"), "application/octet-stream");
 
     EXPECT_EQ(ContentTypeByFileName("path/to/x.txt"), "text/plain");
     EXPECT_EQ(ContentTypeByFileName("path/to/unknown"),
               "application/octet-stream");
 }
 
+TEST(HTTPTest, ContentEncodingEnumConversion) {
+    EXPECT_EQ(ContentEncodingToString(ContentEncoding::Identity), "identity");
+    EXPECT_EQ(ContentEncodingToString(ContentEncoding::Gzip), "gzip");
+    EXPECT_EQ(ContentEncodingToString(ContentEncoding::Brotli), "br");
+
+    EXPECT_EQ(ContentEncodingToExtension(ContentEncoding::Identity), "");
+    EXPECT_EQ(ContentEncodingToExtension(ContentEncoding::Gzip), ".gz");
+    EXPECT_EQ(ContentEncodingToExtension(ContentEncoding::Brotli), ".br");
+}
+
+TEST(HTTPTest, ParseAcceptEncoding) {
+    constexpr auto gzip {ContentEncoding::Gzip};
+    constexpr auto brotli {ContentEncoding::Brotli};
+
+    EXPECT_TRUE(ParseAcceptEncoding("").Empty());
+    EXPECT_TRUE(ParseAcceptEncoding("identity, deflate").Empty());
+    EXPECT_TRUE(ParseAcceptEncoding("").Contains(ContentEncoding::Identity));
+
+    EXPECT_EQ(ParseAcceptEncoding("gzip"), ContentEncodings {}.Add(gzip));
+    EXPECT_EQ(ParseAcceptEncoding(" GZIP ;q=0.5 , br;q=1.0"),
+              ContentEncodings {}.Add(gzip).Add(brotli));
+    EXPECT_EQ(ParseAcceptEncoding("x-gzip"), ContentEncodings {}.Add(gzip));
+
+    // A zero quality value rejects an encoding.
+    EXPECT_EQ(ParseAcceptEncoding("gzip;q=0, br"),
+              ContentEncodings {}.Add(brotli));
+    EXPECT_EQ(ParseAcceptEncoding("gzip;q=0.000"), ContentEncodings {});
+    EXPECT_EQ(ParseAcceptEncoding("gzip;q=0.001"),
+              ContentEncodings {}.Add(gzip));
+
+    // The wildcard stands for encodings that are not rejected.
+    EXPECT_EQ(ParseAcceptEncoding("*"),
+              ContentEncodings {}.Add(gzip).Add(brotli));
+    EXPECT_EQ(ParseAcceptEncoding("br;q=0, *"),
+              ContentEncodings {}.Add(gzip));
+    EXPECT_EQ(ParseAcceptEncoding("gzip, *;q=0"),
+              ContentEncodings {}.Add(gzip));
+}
+
+TEST(HTTPTest, CompressibleContentType) {
+    EXPECT_TRUE(IsCompressibleContentType("text/html"));
+    EXPECT_TRUE(IsCompressibleContentType("text/css"));
+    EXPECT_TRUE(IsCompressibleContentType("application/xhtml+xml"));
+    EXPECT_FALSE(IsCompressibleContentType("image/png"));
+    EXPECT_FALSE(IsCompressibleContentType("application/x-gzip"));
+    EXPECT_FALSE(IsCompressibleContentType("application/octet-stream"));
+}
+
+TEST(HTTPTest, EntityTag) {
+    const std::chrono::system_clock::time_point time {
+        std::chrono::seconds {1}};
+    EXPECT_EQ(MakeEntityTag(0x10, 5, time), "\"10-5-3b9aca00\"");
+    EXPECT_EQ(MakeEntityTag(0x10, 5, time, ContentEncoding::Gzip),
+              "\"10-5-3b9aca00-gzip\"");
+
+    // Any change of the inode, size or modification time changes the tag.
+    EXPECT_NE(MakeEntityTag(0x11, 5, time), MakeEntityTag(0x10, 5, time));
+    EXPECT_NE(MakeEntityTag(0x10, 6, time), MakeEntityTag(0x10, 5, time));
+    EXPECT_NE(MakeEntityTag(0x10, 5, time + std::chrono::nanoseconds {1}),
+              MakeEntityTag(0x10, 5, time));
+}
+
+TEST(HTTPTest, HTTPDate) {
+    // 1994-11-06 08:49:37 UTC.
+    const std::chrono::system_clock::time_point time {
+        std::chrono::seconds {784111777}};
+    EXPECT_EQ(FormatHTTPDate(time), "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(FormatHTTPDate(time + std::chrono::milliseconds {500}),
+              "Sun, 06 Nov 1994 08:49:37 GMT");
+
+    EXPECT_EQ(ParseHTTPDate("Sun, 06 Nov 1994 08:49:37 GMT"), time);
+    EXPECT_EQ(ParseHTTPDate("Sunday, 06-Nov-94 08:49:37 GMT"), time);
+    EXPECT_EQ(ParseHTTPDate("Sun Nov  6 08:49:37 1994"), time);
+
+    EXPECT_FALSE(ParseHTTPDate(""));
+    EXPECT_FALSE(ParseHTTPDate("yesterday"));
+    EXPECT_FALSE(ParseHTTPDate("Sun, 06 Nov 1994 08:49:37 GMT extra"));
+}
+
+TEST(HTTPTest, Preconditions) {
+    const std::chrono::system_clock::time_point time {
+        std::chrono::seconds {784111777}};
+    const Validators validators {
+        .etag = "\"10-5-3b9aca00\"",
+        .last_modified = time + std::chrono::milliseconds {500}};
+
+    EXPECT_TRUE(Preconditions {}.Empty());
+    EXPECT_FALSE(Preconditions {}.NotModified(validators));
+
+    {
+        Preconditions preconditions;
+        preconditions.if_none_match = "\"10-5-3b9aca00\"";
+        EXPECT_FALSE(preconditions.Empty());
+        EXPECT_TRUE(preconditions.NotModified(validators));
+
+        preconditions.if_none_match = "\"other\", W/\"10-5-3b9aca00\"";
+        EXPECT_TRUE(preconditions.NotModified(validators));
+
+        preconditions.if_none_match = "*";
+        EXPECT_TRUE(preconditions.NotModified(validators));
+
+        // "If-Modified-Since" is ignored if "If-None-Match" exists.
+        preconditions.if_none_match = "\"other\"";
+        preconditions.if_modified_since = time;
+        EXPECT_FALSE(preconditions.NotModified(validators));
+    }
+
+    {
+        // HTTP dates only have a resolution of seconds.
+        Preconditions preconditions;
+        preconditions.if_modified_since = time;
+        EXPECT_TRUE(preconditions.NotModified(validators));
+
+        preconditions.if_modified_since = time - std::chrono::seconds {1};
+        EXPECT_FALSE(preconditions.NotModified(validators));
+    }
+}
+
+TEST(HTTPTest, RangeApplies) {
+    const std::chrono::system_clock::time_point time {
+        std::chrono::seconds {784111777}};
+    const Validators validators {.etag = "\"10-5-3b9aca00\"",
+                                 .last_modified = time};
+
+    EXPECT_TRUE(Preconditions {}.RangeApplies(validators));
+
+    Preconditions preconditions;
+    preconditions.if_range = "\"10-5-3b9aca00\"";
+    EXPECT_FALSE(preconditions.Empty());
+    EXPECT_TRUE(preconditions.RangeApplies(validators));
+
+    // Entity tags are compared strongly.
+    preconditions.if_range = "W/\"10-5-3b9aca00\"";
+    EXPECT_FALSE(preconditions.RangeApplies(validators));
+
+    preconditions.if_range = "\"other\"";
+    EXPECT_FALSE(preconditions.RangeApplies(validators));
+
+    preconditions.if_range = "Sun, 06 Nov 1994 08:49:37 GMT";
+    EXPECT_TRUE(preconditions.RangeApplies(validators));
+
+    preconditions.if_range = "Sun, 06 Nov 1994 08:49:36 GMT";
+    EXPECT_FALSE(preconditions.RangeApplies(validators));
+}
+
+TEST(HTTPTest, ParseRange) {
+    EXPECT_EQ(ParseRange("bytes=0-99"),
+              (std::vector<RangeSpec> {{.first = 0, .last = 99}}));
+    EXPECT_EQ(ParseRange("Bytes= 0-0, 100-, -50 "),
+              (std::vector<RangeSpec> {{.first = 0, .last = 0},
+                                       {.first = 100},
+                                       {.last = 50}}));
+
+    EXPECT_FALSE(ParseRange("").has_value());
+    EXPECT_FALSE(ParseRange("items=0-1").has_value());
+    EXPECT_FALSE(ParseRange("bytes=").has_value());
+    EXPECT_FALSE(ParseRange("bytes=-").has_value());
+    EXPECT_FALSE(ParseRange("bytes=9-1").has_value());
+    EXPECT_FALSE(ParseRange("bytes=a-b").has_value());
+    EXPECT_FALSE(ParseRange("bytes=, ").has_value());
+
+    // Empty list elements are ignored.
+    EXPECT_EQ(ParseRange("bytes=0-1,,2-3"),
+              (std::vector<RangeSpec> {{.first = 0, .last = 1},
+                                       {.first = 2, .last = 3}}));
+
+    // Too many ranges are rejected to prevent amplification attacks.
+    std::string many {"bytes=0-0"};
+    for (std::size_t i {1}; i != max_range_count + 1; ++i) {
+        many += fmt::format(",{}-{}", i * 2, i * 2);
+    }
+
+    EXPECT_FALSE(ParseRange(many).has_value());
+}
+
+TEST(HTTPTest, ResolveRanges) {
+    EXPECT_EQ((RangeSpec {.first = 0, .last = 99}).Resolve(10),
+              (ByteRange {.first = 0, .last = 9}));
+    EXPECT_EQ((RangeSpec {.first = 5}).Resolve(10),
+              (ByteRange {.first = 5, .last = 9}));
+    EXPECT_EQ((RangeSpec {.last = 3}).Resolve(10),
+              (ByteRange {.first = 7, .last = 9}));
+    EXPECT_EQ((RangeSpec {.last = 30}).Resolve(10),
+              (ByteRange {.first = 0, .last = 9}));
+    EXPECT_FALSE((RangeSpec {.first = 10}).Resolve(10).has_value());
+    EXPECT_FALSE((RangeSpec {.last = 0}).Resolve(10).has_value());
+    EXPECT_FALSE((RangeSpec {.last = 1}).Resolve(0).has_value());
+
+    // Overlapping and adjacent ranges are coalesced.
+    EXPECT_EQ(ResolveRanges({{.first = 6, .last = 7},
+                             {.first = 0, .last = 1},
+                             {.first = 2, .last = 3},
+                             {.first = 7},
+                             {.first = 20}},
+                            10),
+              (std::vector<ByteRange> {{.first = 0, .last = 3},
+                                       {.first = 6, .last = 9}}));
+    EXPECT_TRUE(ResolveRanges({{.first = 20}}, 10).empty());
+}
+
 TEST(HTTPTest, URLEncoding) {
     EXPECT_EQ(DecodeURLEncodedCharacter("%20"), ' ');
     EXPECT_EQ(DecodeURLEncodedCharacter("%21"), '!');
@@ -98,4 +355,591 @@ TEST(HTTPTest, PutParameterIntoHTML) {
         const Parameters params {{"name", "mike"}, {"msg", "hello"}};
         EXPECT_EQ(PutParamIntoHTML(std::move(html_template), params), html);
     }
-}
\ No newline at end of file
+}
+
+TEST(HTTPConnectionTest, PartialAndPipelinedRequests) {
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "\r\n"};
+
+    // A request split across reads is resumed.
+    const auto half {request.size() / 2};
+    ASSERT_EQ(write(client, request.data(), half), half);
+    conn.Receive();
+    EXPECT_TRUE(conn.Drained());
+    EXPECT_FALSE(conn.Process());
+
+    ASSERT_EQ(write(client, request.data() + half, request.size() - half),
+              request.size() - half);
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(conn.ToSendSize(), 0);
+    EXPECT_TRUE(conn.KeepAlive());
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 1);
+    EXPECT_FALSE(conn.Process());
+
+    // Pipelined requests are answered in order.
+    const std::string pipelined {std::string {request} + std::string {request}
+                                 + "GET /last HTTP/1.1\r\n"
+                                   "Connection: close\r\n\r\n"};
+    ASSERT_EQ(write(client, pipelined.data(), pipelined.size()),
+              pipelined.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(conn.ToSendSize(), 0);
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 3);
+
+    // The last request closes the connection.
+    EXPECT_FALSE(conn.KeepAlive());
+    EXPECT_FALSE(conn.Process());
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, AssetPack) {
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII raii {std::pair {dir, old_root_dir},
+                     [](const auto& dirs) noexcept {
+                         ConnectionImpl::SetRootDirectory(dirs.second);
+                         ConnectionImpl::SetAssetPack({});
+                         std::error_code error;
+                         std::filesystem::remove_all(dirs.first, error);
+                     }};
+
+    ConnectionImpl::SetRootDirectory(dir);
+
+    const std::filesystem::path assets {std::filesystem::path {dir} / "assets"};
+    std::filesystem::create_directories(assets);
+    std::ofstream {assets / "packed.txt"} << "0123456789";
+
+    const auto pack {std::filesystem::path {dir} / "assets.pack"};
+    PackAssets(assets, pack);
+    ConnectionImpl::SetAssetPack(pack);
+    EXPECT_THROW(ConnectionImpl::SetAssetPack(assets / "packed.txt"),
+                 std::invalid_argument);
+    ConnectionImpl::SetAssetPack(pack);
+
+    // Packed files are served without the asset folder.
+    std::filesystem::remove_all(assets);
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    constexpr std::string_view requests {"GET /packed.txt HTTP/1.1\r\n"
+                                         "\r\n"
+                                         "GET /packed.txt HTTP/1.1\r\n"
+                                         "Range: bytes=2-4\r\n"
+                                         "\r\n"
+                                         "GET /missing.txt HTTP/1.1\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n"};
+    ASSERT_EQ(write(client, requests.data(), requests.size()),
+              requests.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(conn.ToSendSize(), 0);
+
+    const auto responses {ReadAll(client)};
+    EXPECT_EQ(Count(responses, "HTTP/1.1 200 OK\r\n"), 1);
+    EXPECT_EQ(Count(responses, "Content-type: text/plain\r\n"), 2);
+    EXPECT_EQ(Count(responses, "\r\n\r\n0123456789"), 1);
+    EXPECT_EQ(Count(responses, "HTTP/1.1 206 Partial Content\r\n"), 1);
+    EXPECT_EQ(Count(responses, "Content-range: bytes 2-4/10\r\n"), 1);
+    EXPECT_EQ(Count(responses, "\r\n\r\n234"), 1);
+
+    // Files outside the pack are looked up in the root directory.
+    EXPECT_EQ(Count(responses, "HTTP/1.1 "), 3);
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, RangeRequests) {
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII raii {std::pair {dir, old_root_dir},
+                     [](const auto& dirs) noexcept {
+                         ConnectionImpl::SetRootDirectory(dirs.second);
+                         std::error_code error;
+                         std::filesystem::remove_all(dirs.first, error);
+                     }};
+
+    ConnectionImpl::SetRootDirectory(dir);
+
+    // A large file is sent by `sendfile` and a small one is sent from memory.
+    std::string large(0x10000, '\0');
+    for (std::size_t i {0}; i != large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+
+    std::ofstream {std::filesystem::path {dir} / "large.txt"} << large;
+    std::ofstream {std::filesystem::path {dir} / "small.txt"} << "0123456789";
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // Pipelined responses with body parts are sent in order.
+    constexpr std::string_view requests {"GET /small.txt HTTP/1.1\r\n"
+                                         "Connection: keep-alive\r\n"
+                                         "Range: bytes=2-4\r\n"
+                                         "\r\n"
+                                         "GET /large.txt HTTP/1.1\r\n"
+                                         "Connection: keep-alive\r\n"
+                                         "Range: bytes=26-28,-3\r\n"
+                                         "\r\n"
+                                         "GET /small.txt HTTP/1.1\r\n"
+                                         "Range: bytes=10-\r\n"
+                                         "\r\n"};
+    ASSERT_EQ(write(client, requests.data(), requests.size()),
+              requests.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(conn.ToSendSize(), 0);
+
+    const auto responses {ReadAll(client)};
+    EXPECT_EQ(Count(responses, "HTTP/1.1 206 Partial Content\r\n"), 2);
+    EXPECT_EQ(Count(responses, "HTTP/1.1 416 Range Not Satisfiable\r\n"), 1);
+
+    const auto first {responses.find("Content-range: bytes 2-4/10\r\n")};
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_NE(responses.find("\r\n\r\n234HTTP/1.1 ", first),
+              std::string::npos);
+
+    EXPECT_NE(responses.find("Content-range: bytes 26-28/65536\r\n"
+                             "\r\n"
+                             "abc\r\n"),
+              std::string::npos);
+    EXPECT_NE(responses.find(fmt::format("Content-range: bytes 65533-65535/"
+                                         "65536\r\n"
+                                         "\r\n"
+                                         "{}\r\n",
+                                         large.substr(65533))),
+              std::string::npos);
+    EXPECT_TRUE(responses.ends_with("Content-range: bytes */10\r\n"
+                                    "Content-length: 0\r\n"
+                                    "\r\n"));
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, HighWaterMark) {
+    const RAII raii {ConnectionImpl::GetHighWaterMark(),
+                     [](const auto mark) noexcept {
+                         ConnectionImpl::SetHighWaterMark(mark);
+                     }};
+
+    // Only a single response is buffered ahead.
+    ConnectionImpl::SetHighWaterMark(1);
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // Fill the socket with pipelined requests.
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "\r\n"};
+    std::string requests;
+    while (requests.size() < 0x30000) {
+        requests += request;
+    }
+
+    std::size_t written {0};
+    while (written < requests.size()) {
+        if (const auto size {write(client, requests.data() + written,
+                                   requests.size() - written)};
+            size > 0) {
+            written += size;
+        } else {
+            break;
+        }
+    }
+
+    ASSERT_GT(written, 0x20000);
+
+    // Data beyond the mark is left in the socket.
+    const auto received {conn.Receive()};
+    EXPECT_GT(received, 0);
+    EXPECT_LT(received, written);
+    EXPECT_FALSE(conn.Drained());
+
+    // No more responses are built until the buffered one has been sent.
+    ASSERT_TRUE(conn.Process());
+    const auto buffered {conn.BufferedSize()};
+    EXPECT_GT(buffered, 0);
+    ASSERT_TRUE(conn.Process());
+    EXPECT_EQ(conn.BufferedSize(), buffered);
+
+    conn.Send();
+    EXPECT_EQ(conn.BufferedSize(), 0);
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 1);
+
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 1);
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, Reject) {
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // Received requests are dropped and a pre-rendered response is sent.
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "\r\n"};
+    ASSERT_EQ(write(client, request.data(), request.size()), request.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Reject());
+    EXPECT_FALSE(conn.KeepAlive());
+
+    conn.Send();
+    EXPECT_EQ(conn.ToSendSize(), 0);
+    EXPECT_EQ(ReadAll(client), "HTTP/1.1 503 Service Unavailable\r\n"
+                               "Connection: close\r\n"
+                               "Retry-After: 1\r\n"
+                               "Content-length: 0\r\n"
+                               "\r\n");
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, MaxBufferSize) {
+    const RAII raii {ConnectionImpl::GetMaxBufferSize(),
+                     [](const auto size) noexcept {
+                         ConnectionImpl::SetMaxBufferSize(size);
+                     }};
+
+    ConnectionImpl::SetMaxBufferSize(0x10);
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // A complete request larger than the limit is still answered.
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "\r\n"};
+    ASSERT_EQ(write(client, request.data(), request.size()), request.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_TRUE(conn.KeepAlive());
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 1);
+
+    // An incomplete request larger than the limit is rejected.
+    constexpr std::string_view partial {"GET /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"};
+    ASSERT_EQ(write(client, partial.data(), partial.size()), partial.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_FALSE(conn.KeepAlive());
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 503 Service Unavailable\r\n"),
+              1);
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, RequestLimits) {
+    const RAII raii {ConnectionImpl::GetRequestLimits(),
+                     [](const auto limits) noexcept {
+                         ConnectionImpl::SetRequestLimits(limits);
+                     }};
+
+    ConnectionImpl::SetRequestLimits({.max_body_size = 0x10});
+
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII dir_raii {std::pair {dir, old_root_dir},
+                         [](const auto& dirs) noexcept {
+                             ConnectionImpl::SetRootDirectory(dirs.second);
+                             std::error_code error;
+                             std::filesystem::remove_all(dirs.first, error);
+                         }};
+
+    ConnectionImpl::SetRootDirectory(dir);
+    std::ofstream {std::filesystem::path {dir} / "http-status.html"}
+        << HTMLPlaceholder("status-code");
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // A large body is rejected as soon as its length is received.
+    constexpr std::string_view request {"POST /missing HTTP/1.1\r\n"
+                                        "Connection: keep-alive\r\n"
+                                        "Content-Length: 17\r\n"
+                                        "\r\n"};
+    ASSERT_EQ(write(client, request.data(), request.size()), request.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_FALSE(conn.KeepAlive());
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 413 Payload Too Large\r\n"), 1);
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, MaxRequestsPerConnection) {
+    const RAII raii {ConnectionImpl::GetMaxRequestsPerConnection(),
+                     [](const auto count) noexcept {
+                         ConnectionImpl::SetMaxRequestsPerConnection(count);
+                     }};
+
+    ConnectionImpl::SetMaxRequestsPerConnection(2);
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // HTTP/1.1 connections are persistent without a `Connection` header.
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n\r\n"};
+    ASSERT_EQ(write(client, request.data(), request.size()), request.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_TRUE(conn.KeepAlive());
+    auto response {ReadAll(client)};
+    EXPECT_EQ(Count(response, "Connection: keep-alive\r\n"), 1);
+
+    // The response to the last allowed request closes the connection.
+    const std::string pipelined {std::string {request} + std::string {request}};
+    ASSERT_EQ(write(client, pipelined.data(), pipelined.size()),
+              pipelined.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_FALSE(conn.KeepAlive());
+    response = ReadAll(client);
+    EXPECT_EQ(Count(response, "HTTP/1.1 "), 1);
+    EXPECT_EQ(Count(response, "Connection: close\r\n"), 1);
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, Reset) {
+    std::array<FileDescriptor, 2> old_sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         old_sockets.data()),
+              0);
+
+    Connection<IPv4Addr> conn {old_sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    // Leave an incomplete request in the connection.
+    constexpr std::string_view partial {"GET /missing HTTP/1.1\r\n"};
+    ASSERT_EQ(write(old_sockets[1], partial.data(), partial.size()),
+              partial.size());
+    conn.Receive();
+    EXPECT_FALSE(conn.Process());
+
+    std::array<FileDescriptor, 2> new_sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         new_sockets.data()),
+              0);
+
+    // The old socket is closed and the incomplete request is discarded.
+    conn.Reset(new_sockets[0], IPv4Addr {"127.0.0.2", 0});
+    EXPECT_EQ(conn.Socket(), new_sockets[0]);
+    EXPECT_EQ(conn.IPAddress(), "127.0.0.2");
+    EXPECT_EQ(ReadAll(old_sockets[1]), "");
+
+    constexpr std::string_view request {"GET /missing HTTP/1.1\r\n\r\n"};
+    ASSERT_EQ(write(new_sockets[1], request.data(), request.size()),
+              request.size());
+    conn.Receive();
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(Count(ReadAll(new_sockets[1]), "HTTP/1.1 "), 1);
+
+    close(old_sockets[1]);
+    close(new_sockets[1]);
+}
+
+TEST(HTTPConnectionTest, Proxy) {
+    const RAII routes_raii {ConnectionImpl::GetRoutes(),
+                            [](RoutingTable routes) noexcept {
+                                ConnectionImpl::SetRoutes(std::move(routes));
+                            }};
+
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII dir_raii {std::pair {dir, old_root_dir},
+                         [](const auto& dirs) noexcept {
+                             ConnectionImpl::SetRootDirectory(dirs.second);
+                             std::error_code error;
+                             std::filesystem::remove_all(dirs.first, error);
+                         }};
+
+    // Error responses are rendered from the status page.
+    ConnectionImpl::SetRootDirectory(dir);
+    std::ofstream {std::filesystem::path {dir} / "http-status.html"}
+        << HTMLPlaceholder("status-code");
+
+    RoutingTable routes;
+    routes.Add("/api/", ParseUpstream("127.0.0.1:8080"));
+    ConnectionImpl::SetRoutes(std::move(routes));
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    constexpr std::string_view requests {"GET /missing HTTP/1.1\r\n\r\n"
+                                         "GET /api/users HTTP/1.1\r\n"
+                                         "Host: localhost\r\n"
+                                         "\r\n"
+                                         "GET /api/groups HTTP/1.1\r\n\r\n"};
+    ASSERT_EQ(write(client, requests.data(), requests.size()),
+              requests.size());
+    conn.Receive();
+
+    // Processing stops at the first routed request after answering the previous one.
+    ASSERT_TRUE(conn.Process());
+    conn.Send();
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 "), 1);
+    EXPECT_FALSE(conn.Process());
+    EXPECT_EQ(conn.ProxiedUpstream(), 0);
+
+    const auto request {conn.StartProxy("127.0.0.1")};
+    EXPECT_EQ((std::string_view {reinterpret_cast<const char*>(request.data()),
+                                 request.size()}),
+              "GET /api/users HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "Connection: keep-alive\r\n"
+              "X-Forwarded-For: 127.0.0.1\r\n"
+              "\r\n");
+
+    // The upstream response is forwarded to the client.
+    ChunkedBuffer response;
+    response.Append("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nusers");
+    EXPECT_TRUE(conn.ForwardProxyResponse(response, false));
+    EXPECT_TRUE(conn.FinishProxy(true));
+    conn.Send();
+    const auto forwarded {ReadAll(client)};
+    EXPECT_TRUE(forwarded.starts_with("HTTP/1.1 200 OK\r\n"));
+    EXPECT_TRUE(forwarded.ends_with("\r\n\r\nusers"));
+    EXPECT_TRUE(conn.KeepAlive());
+
+    // A request failing before its response is answered with 502 Bad Gateway.
+    EXPECT_FALSE(conn.Process());
+    EXPECT_EQ(conn.ProxiedUpstream(), 0);
+    conn.StartProxy("127.0.0.1");
+    EXPECT_FALSE(conn.FinishProxy(false));
+    EXPECT_FALSE(conn.ProxiedUpstream());
+    conn.Send();
+    EXPECT_TRUE(ReadAll(client).starts_with("HTTP/1.1 502 "));
+    EXPECT_TRUE(conn.KeepAlive());
+    EXPECT_FALSE(conn.Process());
+
+    close(client);
+}
+
+TEST(HTTPConnectionTest, DiskOffload) {
+    const RAII offload_raii {ConnectionImpl::GetDiskOffload(),
+                             [](const bool set) noexcept {
+                                 ConnectionImpl::SetDiskOffload(set);
+                             }};
+    const RAII metrics_raii {ConnectionImpl::GetMetricsPath(),
+                             [](std::string path) noexcept {
+                                 ConnectionImpl::SetMetricsPath(
+                                     std::move(path));
+                             }};
+
+    const auto dir {test::CreateTempTestDirectory()};
+    const auto old_root_dir {ConnectionImpl::GetRootDirectory()};
+    const RAII dir_raii {std::pair {dir, old_root_dir},
+                         [](const auto& dirs) noexcept {
+                             ConnectionImpl::SetRootDirectory(dirs.second);
+                             std::error_code error;
+                             std::filesystem::remove_all(dirs.first, error);
+                         }};
+
+    ConnectionImpl::SetRootDirectory(dir);
+    std::ofstream {std::filesystem::path {dir} / "file.txt"} << "hello";
+    ConnectionImpl::SetMetricsPath("/metrics");
+    ConnectionImpl::SetDiskOffload(true);
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                         sockets.data()),
+              0);
+
+    const auto client {sockets[1]};
+    Connection<IPv4Addr> conn {sockets[0], IPv4Addr {"127.0.0.1", 0}};
+
+    constexpr std::string_view requests {"GET /metrics HTTP/1.1\r\n\r\n"
+                                         "GET /file.txt HTTP/1.1\r\n\r\n"
+                                         "GET /metrics HTTP/1.1\r\n\r\n"};
+    ASSERT_EQ(write(client, requests.data(), requests.size()),
+              requests.size());
+    conn.Receive();
+
+    // Responses in memory are built inline, and processing stops at a file.
+    ASSERT_TRUE(conn.Process());
+    EXPECT_TRUE(conn.DiskPending());
+    conn.Send();
+    EXPECT_EQ(Count(ReadAll(client), "HTTP/1.1 200 "), 1);
+    EXPECT_FALSE(conn.Process());
+
+    // The file's response can be built in another thread.
+    std::thread {[&conn] { conn.BuildDiskResponse(); }}.join();
+    EXPECT_FALSE(conn.DiskPending());
+    ASSERT_TRUE(conn.Process());
+    EXPECT_FALSE(conn.DiskPending());
+    conn.Send();
+    const auto responses {ReadAll(client)};
+    EXPECT_EQ(Count(responses, "HTTP/1.1 200 "), 2);
+    EXPECT_TRUE(responses.starts_with("HTTP/1.1 200 "));
+    EXPECT_NE(responses.find("\r\n\r\nhello"), std::string::npos);
+    EXPECT_TRUE(conn.KeepAlive());
+
+    close(client);
+}
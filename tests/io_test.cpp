@@ -6,9 +6,14 @@
 #include <gtest/gtest.h>
 
 #include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <array>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 using namespace ws;
 using namespace ws::test;
@@ -64,4 +69,93 @@ TEST(FileDescriptorIOTest, ReadWrite) {
                                    invalid_file_descriptor};
     EXPECT_THROW(invalid_io.WriteTo(buf), std::system_error);
     EXPECT_THROW(invalid_io.ReadFrom(buf), std::system_error);
-}
\ No newline at end of file
+}
+TEST(FileDescriptorIOTest, GatherWrite) {
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()), 0);
+
+    // Close file descriptors.
+    const RAII fd_raii {sockets, [](const auto& fds) noexcept {
+                            close(fds[0]);
+                            close(fds[1]);
+                        }};
+
+    IOBuffer header {"header"};
+    Buffer empty {std::string_view {""}};
+    Buffer body {"body"};
+    EXPECT_TRUE(empty.Empty());
+
+    // Buffers are written in order and empty buffers are skipped.
+    io::FileDescriptor io {sockets[1], sockets[0]};
+    EXPECT_EQ(header.WriteTo(io, {&empty, &body}), 10);
+    EXPECT_TRUE(header.Empty());
+    EXPECT_TRUE(body.Empty());
+
+    Buffer buf;
+    io.WriteTo(buf);
+    EXPECT_EQ(buf.RetrieveAllToString(), "headerbody");
+
+    // Nothing is written if all buffers are empty.
+    std::array<Buffer*, 2> bufs {&header, &body};
+    EXPECT_EQ(io.ReadFrom(bufs), 0);
+
+    // Segments followed by more data are written in the same order.
+    constexpr std::string_view first {"first"};
+    constexpr std::string_view last {"last"};
+    const std::array more {std::as_bytes(std::span {first})};
+    const std::array end {std::as_bytes(std::span {last})};
+    EXPECT_EQ(io.Write(more, true), first.size());
+    EXPECT_EQ(io.Write(end), last.size());
+    io.WriteTo(buf);
+    EXPECT_EQ(buf.RetrieveAllToString(), "firstlast");
+}
+
+TEST(ZeroCopyIOTest, SendFile) {
+    const auto [write_fd, path] {CreateTempTestFile()};
+    const auto read_fd {open(path.c_str(), O_RDONLY)};
+
+    // Clean the file.
+    const RAII file_raii {path, [](const auto& path) noexcept {
+                              unlink(path.c_str());
+                          }};
+
+    std::array<FileDescriptor, 2> sockets {};
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()), 0);
+
+    // Close file descriptors.
+    const RAII fd_raii {std::array {read_fd, write_fd, sockets[0], sockets[1]},
+                        [](const auto& fds) noexcept {
+                            for (const auto fd : fds) {
+                                close(fd);
+                            }
+                        }};
+
+    const std::string str {"hello"};
+    Buffer buf {str};
+    io::FileDescriptor file_io {invalid_file_descriptor, write_fd};
+    file_io.ReadFrom(buf);
+
+    io::FileDescriptor socket_io {sockets[1], invalid_file_descriptor};
+
+    // Send the file from an offset.
+    std::size_t offset {1};
+    EXPECT_EQ(io::SendFile(sockets[0], read_fd, offset, str.length() - offset),
+              str.length() - 1);
+    EXPECT_EQ(offset, str.length());
+    socket_io.WriteTo(buf);
+    EXPECT_EQ(buf.RetrieveAllToString(), str.substr(1));
+
+    // Send the file by splicing.
+    offset = 0;
+    io::SplicePipe pipe;
+    EXPECT_EQ(pipe.Send(sockets[0], read_fd, offset, str.length()),
+              str.length());
+    EXPECT_EQ(offset, str.length());
+    EXPECT_EQ(pipe.PendingSize(), 0);
+    socket_io.WriteTo(buf);
+    EXPECT_EQ(buf.RetrieveAllToString(), str);
+
+    // Throw an exception if a descriptor is invalid.
+    EXPECT_THROW(io::SendFile(invalid_file_descriptor, read_fd, offset, 1),
+                 std::system_error);
+}
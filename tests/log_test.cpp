@@ -2,8 +2,12 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace ws::log;
 
@@ -14,10 +18,6 @@ public:
 
     using Appender::Appender;
 
-    void Log(const Logger& logger, const Event& event) noexcept override {
-        ss_ << formatter_->Format(logger, event);
-    }
-
     //! Empty implementation.
     std::string ToYamlString() const noexcept override {
         return "";
@@ -31,6 +31,11 @@ public:
         return msg;
     }
 
+protected:
+    void Write(const std::string_view logs) noexcept override {
+        ss_ << logs;
+    }
+
 private:
     std::ostringstream ss_;
 };
@@ -87,6 +92,156 @@ TEST_F(LoggerTest, AsynchronousLog) {
     }
 }
 
+TEST_F(LoggerTest, AsynchronousLogFromThreads) {
+    constexpr std::size_t thread_count {4};
+    constexpr std::size_t event_count {1000};
+
+    const auto appender {std::make_shared<FakeAppender>("%m%n")};
+    {
+        // Events are never dropped if producers block on a full queue.
+        Logger logger {"async", Level::Debug, 0x10, OverflowPolicy::Block};
+        logger.AddAppender(appender);
+
+        std::vector<std::thread> threads;
+        for (std::size_t i {0}; i != thread_count; ++i) {
+            threads.emplace_back([&logger]() {
+                for (std::size_t j {0}; j != event_count; ++j) {
+                    logger.Log(Event::Create(Level::Info) << "event");
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        EXPECT_EQ(logger.DroppedCount(), 0);
+    }
+
+    // All queued events are logged before the logger is destroyed.
+    const auto log {appender->Message()};
+    EXPECT_EQ(std::ranges::count(log, '\n'), thread_count * event_count);
+}
+
+TEST_F(LoggerTest, AsynchronousLogOverflow) {
+    constexpr std::size_t event_count {1000};
+
+    // An appender that blocks the writer thread until it is released.
+    class SlowAppender : public FakeAppender {
+    public:
+        using FakeAppender::FakeAppender;
+
+        void Log(const Logger& logger, const Event& event) noexcept override {
+            released_.wait(false);
+            FakeAppender::Log(logger, event);
+        }
+
+        void Release() noexcept {
+            released_ = true;
+            released_.notify_all();
+        }
+
+    private:
+        std::atomic_bool released_ {false};
+    };
+
+    const auto appender {std::make_shared<SlowAppender>("%m%n")};
+    Logger logger {"async", Level::Debug, 2, OverflowPolicy::Drop};
+    EXPECT_EQ(logger.Overflow(), OverflowPolicy::Drop);
+    logger.AddAppender(appender);
+    for (std::size_t i {0}; i != event_count; ++i) {
+        logger.Log(Event::Create(Level::Info) << "event");
+    }
+
+    // At most the queue capacity and the event being written are kept.
+    EXPECT_GE(logger.DroppedCount(), event_count - 3);
+    appender->Release();
+}
+
+TEST_F(LoggerTest, LevelGatedLog) {
+    Logger logger {"sync", Level::Warn};
+    logger.AddAppender(appenders_.front());
+    EXPECT_FALSE(logger.Enabled(Level::Info));
+    EXPECT_TRUE(logger.Enabled(Level::Warn));
+
+    // Arguments are not evaluated if the event will not be logged.
+    auto evaluated {false};
+    const auto arg {[&evaluated]() noexcept {
+        evaluated = true;
+        return "arg";
+    }};
+
+    WS_LOG_INFO(&logger, "Message {}", arg());
+    EXPECT_FALSE(evaluated);
+    EXPECT_TRUE(appenders_.front()->Message().empty());
+
+    WS_LOG_WARN(&logger, "Message {}", arg());
+    EXPECT_TRUE(evaluated);
+    EXPECT_NE(appenders_.front()->Message().find("Message arg"),
+              std::string::npos);
+}
+
+TEST(LogAppenderTest, FlushPolicy) {
+    const auto appender {std::make_shared<FakeAppender>("%m%n")};
+    appender->SetFlushPolicy({.buffer_size = 0x10,
+                              .interval = std::chrono::hours {1},
+                              .level = Level::Error});
+    const Logger logger {"logger"};
+
+    // Events are buffered until the size threshold is reached.
+    appender->Log(logger, *(Event::Create(Level::Info) << "12345"));
+    EXPECT_TRUE(appender->Message().empty());
+    appender->Log(logger, *(Event::Create(Level::Info) << "1234567890"));
+    EXPECT_EQ(appender->Message(), "12345\n1234567890\n");
+
+    // An error is written immediately.
+    appender->Log(logger, *(Event::Create(Level::Error) << "error"));
+    EXPECT_EQ(appender->Message(), "error\n");
+
+    appender->Log(logger, *(Event::Create(Level::Info) << "info"));
+    EXPECT_TRUE(appender->Message().empty());
+    appender->Flush();
+    EXPECT_EQ(appender->Message(), "info\n");
+
+    // Zero buffer size writes each event immediately.
+    appender->SetFlushPolicy({.buffer_size = 0});
+    appender->Log(logger, *(Event::Create(Level::Info) << "info"));
+    EXPECT_EQ(appender->Message(), "info\n");
+}
+
+TEST(LogEventTest, Message) {
+    const auto event {Event::Create(Level::Info)};
+    EXPECT_TRUE(event->Message().empty());
+
+    event << "Short";
+    event->MessageStream() << ' ' << 1;
+    EXPECT_EQ(event->Message(), "Short 1");
+
+    // A long message moves out of the inline buffer.
+    const std::string long_msg(Event::inline_message_capacity, 'a');
+    event << long_msg;
+    EXPECT_EQ(event->Message(), "Short 1" + long_msg);
+}
+
+TEST(LogEventTest, Recycle) {
+    auto event {Event::Create(Level::Info)};
+    const auto addr {event.get()};
+
+    // A new event reuses the memory of a destroyed one in the same thread.
+    std::thread {[event = std::move(event)]() mutable noexcept {
+        event.reset();
+    }}.join();
+
+    // Earlier released events may be reused first.
+    std::vector<Event::Ptr> events;
+    do {
+        events.push_back(Event::Create(Level::Info));
+    } while (events.back().get() != addr && events.size() != 0x100);
+
+    EXPECT_EQ(events.back().get(), addr);
+    EXPECT_EQ(events.back()->ThreadId(), ws::CurrentThreadId());
+}
+
 TEST(LogManagementTest, LoggerManager) {
     constexpr std::string_view logger_name {"logger"};
     constexpr std::string_view manager_name {"manager"};
@@ -108,6 +263,14 @@ TEST(LogManagementTest, LevelEnumConversion) {
     EXPECT_THROW(StringToLevel("unknown"), std::invalid_argument);
 }
 
+TEST(LogManagementTest, OverflowPolicyEnumConversion) {
+    EXPECT_EQ(OverflowPolicyToString(OverflowPolicy::Sample), "Sample");
+    EXPECT_EQ(StringToOverflowPolicy("drop"), OverflowPolicy::Drop);
+    EXPECT_EQ(StringToOverflowPolicy("BLOCK"), OverflowPolicy::Block);
+
+    EXPECT_THROW(StringToOverflowPolicy("unknown"), std::invalid_argument);
+}
+
 TEST(LogManagementTest, AppenderTypeEnumConversion) {
     EXPECT_EQ(AppenderTypeToString(AppenderType::StdOut), "StdOut");
     EXPECT_EQ(StringToAppenderType("stdout"), AppenderType::StdOut);
@@ -0,0 +1,132 @@
+#include "metrics.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+using namespace ws::metrics;
+
+
+TEST(MetricsTest, Counter) {
+    Counter counter;
+    EXPECT_EQ(counter.Value(), 0);
+
+    constexpr std::size_t thread_count {8};
+    constexpr std::size_t increase_count {1000};
+    std::vector<std::jthread> threads;
+    for (std::size_t i {0}; i != thread_count; ++i) {
+        threads.emplace_back([&counter] {
+            for (std::size_t j {0}; j != increase_count; ++j) {
+                counter.Increase();
+            }
+        });
+    }
+
+    threads.clear();
+    EXPECT_EQ(counter.Value(), thread_count * increase_count);
+
+    counter.Increase(10);
+    EXPECT_EQ(counter.Value(), thread_count * increase_count + 10);
+}
+
+TEST(MetricsTest, Gauge) {
+    Gauge gauge;
+    EXPECT_EQ(gauge.Value(), 0);
+
+    // A gauge increased by one thread can be decreased by another.
+    std::jthread {[&gauge] { gauge.Increase(5); }}.join();
+    std::jthread {[&gauge] { gauge.Decrease(2); }}.join();
+    EXPECT_EQ(gauge.Value(), 3);
+
+    gauge.Decrease(4);
+    EXPECT_EQ(gauge.Value(), -1);
+}
+
+TEST(MetricsTest, Histogram) {
+    EXPECT_THROW((Histogram {{2, 1}}), std::invalid_argument);
+    EXPECT_THROW((Histogram {{1, 1}}), std::invalid_argument);
+
+    Histogram histogram {{1, 5, 10}};
+    EXPECT_EQ(histogram.Bounds(), (std::vector<std::uint64_t> {1, 5, 10}));
+    EXPECT_THAT(histogram.Counts(), testing::ElementsAre(0, 0, 0, 0));
+
+    for (const auto value : {0, 1, 2, 5, 7, 10, 11, 100}) {
+        histogram.Observe(value);
+    }
+
+    EXPECT_THAT(histogram.Counts(), testing::ElementsAre(2, 2, 2, 2));
+    EXPECT_EQ(histogram.Sum(), 136);
+}
+
+TEST(MetricsTest, Registry) {
+    Registry registry;
+    auto& counter {registry.AddCounter("requests_total", "Requests")};
+    EXPECT_EQ(&registry.AddCounter("requests_total", "Requests"), &counter);
+    EXPECT_NE(&registry.AddCounter("requests_total", "Requests",
+                                   {{"code", "200"}}),
+              &counter);
+
+    EXPECT_THROW(registry.AddGauge("requests_total", "Requests"),
+                 std::invalid_argument);
+}
+
+TEST(MetricsTest, CachedCounter) {
+    auto& counter {CachedCounter("test_cached_total", "Cached", "code", 200)};
+    EXPECT_EQ(&CachedCounter("test_cached_total", "Cached", "code", 200),
+              &counter);
+    EXPECT_EQ(&DefaultRegistry().AddCounter("test_cached_total", "Cached",
+                                            {{"code", "200"}}),
+              &counter);
+    EXPECT_NE(&CachedCounter("test_cached_total", "Cached", "code", 404),
+              &counter);
+
+    // Other threads find the same counter in the registry.
+    Counter* other {nullptr};
+    std::jthread {[&other] {
+        other = &CachedCounter("test_cached_total", "Cached", "code", 200);
+    }}.join();
+    EXPECT_EQ(other, &counter);
+
+    constexpr std::string_view reason {"queue"};
+    EXPECT_EQ(&CachedCounter("test_cached_total", "Cached", "reason", reason),
+              &DefaultRegistry().AddCounter("test_cached_total", "Cached",
+                                            {{"reason", "queue"}}));
+}
+
+TEST(MetricsTest, Expose) {
+    Registry registry;
+    registry.AddCounter("requests_total", "Requests", {{"code", "200"}})
+        .Increase(3);
+    registry.AddCounter("requests_total", "Requests", {{"code", "404"}})
+        .Increase();
+    registry.AddGauge("connections", "Open connections").Increase(2);
+    registry.AddGauge("escaped", "Escaped labels", {{"path", "a\"b\\c"}});
+
+    auto& histogram {registry.AddHistogram("latency_seconds", "Latency",
+                                           {1, 2}, 0.5, {{"pool", "shared"}})};
+    histogram.Observe(1);
+    histogram.Observe(3);
+
+    EXPECT_EQ(registry.Expose(),
+              "# HELP requests_total Requests\n"
+              "# TYPE requests_total counter\n"
+              "requests_total{code=\"200\"} 3\n"
+              "requests_total{code=\"404\"} 1\n"
+              "# HELP connections Open connections\n"
+              "# TYPE connections gauge\n"
+              "connections 2\n"
+              "# HELP escaped Escaped labels\n"
+              "# TYPE escaped gauge\n"
+              "escaped{path=\"a\\\"b\\\\c\"} 0\n"
+              "# HELP latency_seconds Latency\n"
+              "# TYPE latency_seconds histogram\n"
+              "latency_seconds_bucket{pool=\"shared\",le=\"0.5\"} 1\n"
+              "latency_seconds_bucket{pool=\"shared\",le=\"1\"} 1\n"
+              "latency_seconds_bucket{pool=\"shared\",le=\"+Inf\"} 2\n"
+              "latency_seconds_sum{pool=\"shared\"} 2\n"
+              "latency_seconds_count{pool=\"shared\"} 2\n");
+}
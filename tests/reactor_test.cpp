@@ -0,0 +1,204 @@
+#include "reactor.h"
+#include "containers/thread_pool.h"
+#include "ip.h"
+#include "test_util.h"
+#include "util.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace ws;
+using namespace std::chrono_literals;
+
+
+namespace {
+
+//! An executor whose tasks start after a delay, as if each of them were slow.
+class SlowExecutor : public Executor {
+public:
+    explicit SlowExecutor(const std::chrono::milliseconds delay) noexcept :
+        delay_ {delay} {}
+
+    ~SlowExecutor() noexcept override {
+        Close();
+    }
+
+    void Start() noexcept override {
+        for (auto i {0}; i != 2; ++i) {
+            threads_.emplace_back([this]() noexcept { Run(); });
+        }
+    }
+
+    void Push(Task task) noexcept override {
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        {
+            const std::lock_guard locker {mtx_};
+            tasks_.push_back(std::move(task));
+        }
+
+        cond_.notify_one();
+    }
+
+    void PushBatch(const std::span<Task> tasks) noexcept override {
+        for (auto& task : tasks) {
+            Push(std::move(task));
+        }
+    }
+
+    void Close() noexcept override {
+        {
+            const std::lock_guard locker {mtx_};
+            closed_ = true;
+        }
+
+        cond_.notify_all();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    std::size_t QueuedCount() const noexcept override {
+        const std::lock_guard locker {mtx_};
+        return tasks_.size();
+    }
+
+    //! Get the number of tasks that have been pushed.
+    std::size_t Pushed() const noexcept {
+        return pushed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Run() noexcept {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock locker {mtx_};
+                cond_.wait(locker, [this]() { return closed_ || !tasks_.empty(); });
+                if (closed_) {
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            std::this_thread::sleep_for(delay_);
+            task();
+        }
+    }
+
+    const std::chrono::milliseconds delay_;
+    mutable std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<Task> tasks_;
+    std::vector<std::thread> threads_;
+    std::atomic_size_t pushed_ {0};
+    bool closed_ {false};
+};
+
+//! Connect to a local port, retrying until the listener is ready.
+FileDescriptor Connect(const std::uint16_t port) {
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (auto i {0}; i != 100; ++i) {
+        const auto socket {::socket(AF_INET, SOCK_STREAM, 0)};
+        if (connect(socket, reinterpret_cast<const sockaddr*>(&addr),
+                    sizeof(addr))
+            == 0) {
+            return socket;
+        }
+
+        close(socket);
+        std::this_thread::sleep_for(10ms);
+    }
+
+    return invalid_file_descriptor;
+}
+
+//! Read from a socket until a response header arrives or a time-out.
+std::string ReadResponse(const FileDescriptor socket) {
+    const timeval timeout {.tv_sec = 5, .tv_usec = 0};
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string data;
+    std::array<char, 0x1000> buf {};
+    while (data.find("\r\n\r\n") == std::string::npos) {
+        const auto size {read(socket, buf.data(), buf.size())};
+        if (size <= 0) {
+            break;
+        }
+
+        data.append(buf.data(), size);
+    }
+
+    return data;
+}
+
+}  // namespace
+
+
+TEST(ReactorTest, SlowTaskDoesNotBlockLoop) {
+    constexpr std::uint16_t port {10123};
+    constexpr std::chrono::milliseconds delay {300};
+
+    SlowExecutor executor {delay};
+    executor.Start();
+    Reactor<IPv4Addr> reactor {port, 60s, &executor, false, {}, {}, {},
+                               false, nullptr, test::TestLogger()};
+    std::thread loop {[&reactor]() { reactor.Start(); }};
+    const RAII raii {std::ref(loop),
+                     [&reactor, &executor](std::thread& loop) noexcept {
+                         reactor.Close();
+                         loop.join();
+                         executor.Close();
+                     }};
+
+    constexpr std::string_view request {"GET / HTTP/1.1\r\n\r\n"};
+    const auto first {Connect(port)};
+    ASSERT_TRUE(IsValidFileDescriptor(first));
+    ASSERT_EQ(write(first, request.data(), request.size()), request.size());
+
+    // A lone request is processed in the thread pool instead of the reactor's thread.
+    const auto start {std::chrono::steady_clock::now()};
+    while (executor.Pushed() < 1 && std::chrono::steady_clock::now() - start < 1s) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    ASSERT_EQ(executor.Pushed(), 1);
+
+    // While the first request is slow, the reactor keeps accepting and dispatching other clients.
+    const auto second {Connect(port)};
+    ASSERT_TRUE(IsValidFileDescriptor(second));
+    ASSERT_EQ(write(second, request.data(), request.size()), request.size());
+    while (executor.Pushed() < 2 && std::chrono::steady_clock::now() - start < delay) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    EXPECT_EQ(executor.Pushed(), 2);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, delay);
+
+    EXPECT_TRUE(ReadResponse(first).starts_with("HTTP/1.1 "));
+    EXPECT_TRUE(ReadResponse(second).starts_with("HTTP/1.1 "));
+    close(first);
+    close(second);
+}
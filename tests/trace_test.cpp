@@ -0,0 +1,102 @@
+#include "trace.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace ws;
+using namespace ws::trace;
+
+
+TEST(TraceTest, StageToString) {
+    EXPECT_EQ(StageToString(Stage::Queue), "Queue");
+    EXPECT_EQ(StageToString(Stage::Receive), "Receive");
+    EXPECT_EQ(StageToString(Stage::Parse), "Parse");
+    EXPECT_EQ(StageToString(Stage::Build), "Build");
+    EXPECT_EQ(StageToString(Stage::Send), "Send");
+}
+
+TEST(TraceTest, ToNanoseconds) {
+    using namespace std::chrono_literals;
+    EXPECT_DOUBLE_EQ(ToNanoseconds(0), 0);
+
+    const auto begin {Now()};
+    std::this_thread::sleep_for(10ms);
+    const auto elapsed {ToNanoseconds(Now() - begin)};
+    EXPECT_GE(elapsed, 5'000'000);
+    EXPECT_LT(elapsed, 1'000'000'000);
+}
+
+TEST(TraceTest, RequestTrace) {
+    RequestTrace trace;
+    EXPECT_EQ(trace.Size(), 0);
+
+    trace.Record(Stage::Receive, 1, 2);
+    {
+        const Scope scope {trace, Stage::Parse};
+        EXPECT_EQ(trace.Size(), 1);
+    }
+
+    EXPECT_EQ(trace.Size(), 2);
+
+    // Dequeuing without enqueuing records nothing.
+    trace.Dequeue();
+    EXPECT_EQ(trace.Size(), 2);
+
+    trace.Enqueue();
+    trace.Dequeue();
+    EXPECT_EQ(trace.Size(), 3);
+
+    trace.Clear();
+    EXPECT_EQ(trace.Size(), 0);
+
+    for (std::size_t i {0}; i != RequestTrace::max_span_count + 1; ++i) {
+        trace.Record(Stage::Send, i, i + 1);
+    }
+
+    EXPECT_EQ(trace.Size(), RequestTrace::max_span_count);
+}
+
+TEST(TraceTest, DumpChromeTrace) {
+    ClearRings();
+    EXPECT_EQ(DumpChromeTrace(),
+              R"({"traceEvents":[],"displayTimeUnit":"ns"})");
+
+    RequestTrace trace;
+    trace.Record(Stage::Receive, 100, 200);
+    trace.Record(Stage::Build, 200, 300);
+    trace.Finish();
+    EXPECT_EQ(trace.Size(), 0);
+
+    // Stages in another thread are dumped with another thread number.
+    std::jthread {[] {
+        RequestTrace trace;
+        trace.Record(Stage::Send, 300, 400);
+        trace.Finish();
+    }}.join();
+
+    // Finishing a request without stages records nothing.
+    trace.Finish();
+
+    const auto json {DumpChromeTrace()};
+    EXPECT_TRUE(json.starts_with(R"({"traceEvents":[{"name":"Receive",)"));
+    EXPECT_THAT(json, testing::HasSubstr(R"("ts":0.000,)"));
+    EXPECT_THAT(json, testing::HasSubstr(R"("name":"Build")"));
+    EXPECT_THAT(json, testing::HasSubstr(R"("name":"Send")"));
+    EXPECT_THAT(json, testing::HasSubstr(R"("ph":"X")"));
+    EXPECT_TRUE(json.ends_with(R"(],"displayTimeUnit":"ns"})"));
+
+    ClearRings();
+    EXPECT_EQ(DumpChromeTrace(),
+              R"({"traceEvents":[],"displayTimeUnit":"ns"})");
+}
+
+TEST(TraceTest, SlowThreshold) {
+    using namespace std::chrono_literals;
+    EXPECT_EQ(GetSlowThreshold(), 0ns);
+    SetSlowThreshold(1ms);
+    EXPECT_EQ(GetSlowThreshold(), 1ms);
+    SetSlowThreshold(0ns);
+    EXPECT_EQ(GetSlowThreshold(), 0ns);
+}
@@ -5,6 +5,14 @@
 
 #include <gtest/gtest.h>
 
+#include <sched.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
 using namespace ws;
 using namespace ws::test;
 
@@ -75,6 +83,26 @@ TEST(StringTest, SplitStringToLines) {
               (std::vector<std::string> {"a", "b"}));
 }
 
+TEST(StringTest, TrimWhitespace) {
+    static_assert(TrimWhitespace(" \ta b\t ") == "a b");
+    EXPECT_EQ(TrimWhitespace("a"), "a");
+    EXPECT_EQ(TrimWhitespace("\r\n"), "\r\n");
+    EXPECT_TRUE(TrimWhitespace("").empty());
+    EXPECT_TRUE(TrimWhitespace(" \t ").empty());
+}
+
+TEST(StringTest, StringHash) {
+    const std::unordered_map<std::string, int, StringHash, std::equal_to<>>
+        map {{"a", 1}};
+    EXPECT_EQ(StringHash {}("a"), std::hash<std::string> {}("a"));
+
+    // A map is searched by string views without copying them.
+    const auto key {std::string_view {"ab"}.substr(0, 1)};
+    ASSERT_NE(map.find(key), map.cend());
+    EXPECT_EQ(map.find(key)->second, 1);
+    EXPECT_EQ(map.find(std::string_view {"b"}), map.cend());
+}
+
 ///////////////////////////////////////////////////////////////
 // Some versions of Clang cannot compile the following tests.
 ///////////////////////////////////////////////////////////////
@@ -144,6 +172,37 @@ TEST(StringTest, SplitStringToLines) {
 //               (std::pair<int, int> {1, 1}));
 // }
 
+TEST(CPUTest, ParseCPUList) {
+    EXPECT_TRUE(ParseCPUList("").empty());
+    EXPECT_EQ(ParseCPUList("3"), (std::vector<std::size_t> {3}));
+    EXPECT_EQ(ParseCPUList("0-2,8,10-11"),
+              (std::vector<std::size_t> {0, 1, 2, 8, 10, 11}));
+
+    EXPECT_THROW(ParseCPUList("a"), std::invalid_argument);
+    EXPECT_THROW(ParseCPUList("1-"), std::invalid_argument);
+    EXPECT_THROW(ParseCPUList("3-1"), std::invalid_argument);
+    EXPECT_THROW(ParseCPUList("0,,1"), std::invalid_argument);
+}
+
+TEST(CPUTest, SetThreadAffinity) {
+    cpu_set_t old_set;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(old_set), &old_set), 0);
+
+    std::size_t cpu {0};
+    while (!CPU_ISSET(cpu, &old_set)) {
+        ++cpu;
+    }
+
+    std::thread {[cpu] {
+        SetCurrentThreadAffinity({&cpu, 1});
+        EXPECT_EQ(sched_getcpu(), static_cast<int>(cpu));
+    }}.join();
+
+    const std::size_t invalid_cpu {CPU_SETSIZE};
+    EXPECT_THROW(SetCurrentThreadAffinity({&invalid_cpu, 1}),
+                 std::system_error);
+}
+
 TEST(RAIITest, Destroy) {
     int val {0};
 
@@ -192,6 +251,49 @@ TEST(ConceptTest, Addable) {
     EXPECT_FALSE((Addable<std::string, char, char>));
 }
 
+TEST(ReadOnlyFileTest, Open) {
+    {
+        // The path refers to a directory.
+        ReadOnlyFile file;
+        EXPECT_THROW(file.Open("."), std::invalid_argument);
+        EXPECT_FALSE(file.Valid());
+    }
+
+    {
+        // Create a temporary file.
+        const TempTestFile temp;
+        const auto& path {temp.Path()};
+
+        constexpr std::string_view data {"hello"};
+        Buffer str {data};
+        io::FileDescriptor io {invalid_file_descriptor, temp.Descriptor()};
+        io.ReadFrom(str);
+
+        ReadOnlyFile file;
+        const auto file_fd {file.Open(path)};
+        EXPECT_TRUE(file.Valid());
+        EXPECT_EQ(file.Descriptor(), file_fd);
+        EXPECT_EQ(file.Path(), path);
+        EXPECT_EQ(file.Size(), data.length());
+
+        ReadOnlyFile moved {std::move(file)};
+        EXPECT_FALSE(file.Valid());
+        EXPECT_EQ(moved.Descriptor(), file_fd);
+
+        // Prefetching beyond the end of the file is clamped.
+        moved.Prefetch(0, 0x1000);
+        moved.Prefetch(data.length(), 1);
+        const auto content {moved.ReadAll()};
+        EXPECT_EQ((std::string_view {reinterpret_cast<const char*>(
+                                         content.data()),
+                                     content.size()}),
+                  data);
+
+        moved.Close();
+        EXPECT_FALSE(moved.Valid());
+    }
+}
+
 TEST(MappedReadOnlyFileTest, Map) {
     {
         // The path refers to a directory.
@@ -201,16 +303,13 @@ TEST(MappedReadOnlyFileTest, Map) {
 
     {
         // Create a temporary file.
-        const auto [fd, path] {CreateTempTestFile()};
-        const RAII raii {std::pair {fd, path}, [](const auto& file) noexcept {
-                             close(file.first);
-                             unlink(file.second.c_str());
-                         }};
+        const TempTestFile temp;
+        const auto& path {temp.Path()};
 
         // Write data to the temporary file, otherwise it cannot be mapped.
         constexpr std::string_view data {"hello"};
         Buffer str {data};
-        io::FileDescriptor io {invalid_file_descriptor, fd};
+        io::FileDescriptor io {invalid_file_descriptor, temp.Descriptor()};
         io.ReadFrom(str);
 
         MappedReadOnlyFile file;
@@ -226,5 +325,26 @@ TEST(MappedReadOnlyFileTest, Map) {
 
         file.Unmap();
         EXPECT_FALSE(file.Data());
+
+        // Map an opened file.
+        ReadOnlyFile opened;
+        opened.Open(path);
+        EXPECT_TRUE(file.Map(opened));
+        EXPECT_EQ((std::string_view {reinterpret_cast<char*>(file.Data()),
+                                     file.Size()}),
+                  data);
+        EXPECT_EQ(file.Path(), path);
+    }
+
+    {
+        // An empty file cannot be mapped.
+        const TempTestFile temp;
+        const auto& path {temp.Path()};
+
+        ReadOnlyFile opened;
+        opened.Open(path);
+        MappedReadOnlyFile file;
+        EXPECT_THROW(file.Map(opened), std::invalid_argument);
+        EXPECT_FALSE(file.Data());
     }
-}
\ No newline at end of file
+}